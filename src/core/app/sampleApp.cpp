@@ -181,6 +181,7 @@ int GN::util::SampleApp::run( int argc, const char * const argv[] )
 
     while( !mDone )
     {
+        GN_PROFILER_NEXT_FRAME();
         GN_START_PROFILER( Frame );
 
         const sint64 scheduledEndTime = clock.getCycleCount() + UPDATE_INTERVAL_IN_CYCLES;
@@ -602,11 +603,26 @@ void GN::util::SampleApp::drawHUD()
         BitmapFont * font = engine::getDefaultFontRenderer();
 
         StrW timeInfo = str::format(
-            L"FPS: %.2f\tIdle: %.1f%%\n"
-            L"(Press F1 for more helps)",
+            L"FPS: %.2f\tIdle: %.1f%%\n",
             mFps.fps(),
             mFrameIdlePercentage );
 
+#if GN_BUILD_PROFILING_ENABLED
+        // frame time percentiles of last second, to expose spikes hidden by FPS.
+        static ProfileTimer & frameTimer = ProfilerManager::sGetGlobalInstance().getTimer( "Frame" );
+        ProfileHistogram frameTimes;
+        if( frameTimer.getHistogram( frameTimes, PHR_LAST_WINDOW ) )
+        {
+            timeInfo += str::format(
+                L"Frame: p50 %.2fms\tp99 %.2fms\tp99.9 %.2fms\n",
+                frameTimes.getPercentile( 50 ) * 1000.0,
+                frameTimes.getPercentile( 99 ) * 1000.0,
+                frameTimes.getPercentile( 99.9 ) * 1000.0 );
+        }
+#endif
+
+        timeInfo += L"(Press F1 for more helps)";
+
         font->drawText( timeInfo.rawptr(), 40, 40 );
 
         if( mShowHelp )
@@ -0,0 +1,375 @@
+#include "pch.h"
+#include <deque>
+
+using namespace GN;
+
+static GN::Logger * sLogger = GN::getLogger("GN.base.AsyncLoader");
+
+// *****************************************************************************
+// AsyncLoader::Impl
+// *****************************************************************************
+
+class GN::AsyncLoader::Impl
+{
+    typedef AutoRef<AsyncOperation> OpRef;
+
+    JobSystem &         mJobs;
+    uint32              mMaxConcurrent;
+    Mutex               mLock;
+    std::deque<OpRef>   mQueues[AsyncPriority::NUM_PRIORITIES];
+    uint32              mRunning;      ///< number of work stages in flight
+    bool                mShuttingDown;
+    std::atomic<uint32> mPending;      ///< number of operations that are not done
+
+public:
+
+    Impl( JobSystem & js, uint32 maxConcurrent )
+        : mJobs( js )
+        , mMaxConcurrent( maxConcurrent ? maxConcurrent : std::max<uint32>( 1, js.getWorkerCount() ) )
+        , mRunning( 0 )
+        , mShuttingDown( false )
+        , mPending( 0 )
+    {
+    }
+
+    ~Impl()
+    {
+        // cancel everything that has not started yet.
+        DynaArray<OpRef> cancelled;
+        {
+            std::lock_guard<Mutex> lock( mLock );
+            mShuttingDown = true;
+            for( auto & q : mQueues )
+            {
+                for( auto & op : q ) cancelled.append( op );
+                q.clear();
+            }
+        }
+        for( size_t i = 0; i < cancelled.size(); ++i )
+        {
+            cancelled[i]->mCancelRequested = true;
+            complete( cancelled[i], AsyncStatus::CANCELLED );
+        }
+
+        // running operations still reference this loader.
+        waitAll();
+
+        // the last completion might still be waking waiters. It does that with
+        // the lock held.
+        std::lock_guard<Mutex> lock( mLock );
+    }
+
+    JobSystem & getJobSystem() const { return mJobs; }
+
+    uint32 getPendingCount() const { return mPending.load( std::memory_order_acquire ); }
+
+    void enqueue( AsyncOperation * op )
+    {
+        mPending.fetch_add( 1 );
+        {
+            std::lock_guard<Mutex> lock( mLock );
+            if( !mShuttingDown )
+            {
+                mQueues[op->getPriority()].push_back( OpRef( op ) );
+                op = NULL;
+            }
+        }
+        if( op )
+        {
+            GN_ERROR(sLogger)( "Operation '%s' is queued to a loader that is shutting down.", op->getName() );
+            complete( op, AsyncStatus::CANCELLED );
+            return;
+        }
+        dispatch();
+    }
+
+    void setPriority( AsyncOperation * op, AsyncPriority p )
+    {
+        std::lock_guard<Mutex> lock( mLock );
+        uint32 old = op->mPriority.exchange( p );
+        if( old == (uint32)p || AsyncStatus::QUEUED != op->getStatus() ) return;
+        auto & q = mQueues[old];
+        for( auto i = q.begin(); i != q.end(); ++i )
+        {
+            if( *i == op )
+            {
+                q.erase( i );
+                mQueues[p].push_back( OpRef( op ) );
+                break;
+            }
+        }
+    }
+
+    void cancel( AsyncOperation * op )
+    {
+        op->mCancelRequested = true;
+
+        bool removed = false;
+        {
+            std::lock_guard<Mutex> lock( mLock );
+            if( AsyncStatus::QUEUED != op->getStatus() ) return;
+            auto & q = mQueues[op->getPriority()];
+            for( auto i = q.begin(); i != q.end(); ++i )
+            {
+                if( *i == op ) { q.erase( i ); removed = true; break; }
+            }
+        }
+        if( removed ) complete( op, AsyncStatus::CANCELLED );
+    }
+
+    void waitFor( const std::function<bool()> & done, std::atomic<uint32> & addr )
+    {
+        bool main = mJobs.isMainThread();
+        while( !done() )
+        {
+            uint32 v = addr.load( std::memory_order_acquire );
+            if( done() ) break;
+            if( main && mJobs.processMainThreadJobs() > 0 ) continue;
+            // main thread wakes up periodically, since finish stages are queued as
+            // main thread jobs, which do not touch addr.
+            sync::waitOnAddress( addr, v, main ? 1000000 : INFINITE_TIME );
+        }
+    }
+
+    void waitAll()
+    {
+        waitFor( [this]{ return 0 == mPending.load( std::memory_order_acquire ); }, mPending );
+    }
+
+private:
+
+    ///
+    /// Start queued operations, while there are free slots.
+    ///
+    void dispatch()
+    {
+        for(;;)
+        {
+            OpRef op;
+            {
+                std::lock_guard<Mutex> lock( mLock );
+                if( mRunning >= mMaxConcurrent ) return;
+                for( auto & q : mQueues )
+                {
+                    if( !q.empty() )
+                    {
+                        op = q.front();
+                        q.pop_front();
+                        break;
+                    }
+                }
+                if( !op ) return;
+                ++mRunning;
+                setStatus( op, AsyncStatus::WORKING );
+            }
+
+            mJobs.run( op->getName(), [this, op]{ runWork( op ); } );
+        }
+    }
+
+    void runWork( const OpRef & op )
+    {
+        bool ok = op->isCancelRequested() ? false : op->work();
+
+        {
+            std::lock_guard<Mutex> lock( mLock );
+            --mRunning;
+        }
+        dispatch();
+
+        if( op->isCancelRequested() )
+        {
+            complete( op, AsyncStatus::CANCELLED );
+        }
+        else if( !ok )
+        {
+            complete( op, AsyncStatus::FAILED );
+        }
+        else if( op->hasFinishStage() )
+        {
+            setStatus( op, AsyncStatus::FINISHING );
+            mJobs.runOnMainThread( op->getName(), [this, op]{ runFinish( op ); } );
+        }
+        else
+        {
+            complete( op, AsyncStatus::SUCCEEDED );
+        }
+    }
+
+    void runFinish( const OpRef & op )
+    {
+        if( op->isCancelRequested() )
+        {
+            complete( op, AsyncStatus::CANCELLED );
+        }
+        else
+        {
+            complete( op, op->finish() ? AsyncStatus::SUCCEEDED : AsyncStatus::FAILED );
+        }
+    }
+
+    static void setStatus( AsyncOperation * op, AsyncStatus s )
+    {
+        op->mStatus.store( s, std::memory_order_release );
+        sync::wakeAllByAddress( op->mStatus );
+    }
+
+    ///
+    /// Move the operation to a final state, and schedule its callbacks.
+    ///
+    void complete( AsyncOperation * op, AsyncStatus s )
+    {
+        GN_ASSERT( s >= AsyncStatus::SUCCEEDED );
+
+        op->releaseStages();
+
+        DynaArray<std::function<void()> > callbacks;
+        {
+            std::lock_guard<Mutex> lock( op->mCallbackLock );
+            setStatus( op, s );
+            callbacks.swap( op->mCallbacks );
+        }
+
+        if( !callbacks.empty() )
+        {
+            OpRef keep( op );
+            mJobs.runOnMainThread( op->getName(), [keep, callbacks]{
+                for( size_t i = 0; i < callbacks.size(); ++i ) callbacks[i]();
+            } );
+        }
+
+        std::lock_guard<Mutex> lock( mLock );
+        mPending.fetch_sub( 1, std::memory_order_acq_rel );
+        sync::wakeAllByAddress( mPending );
+    }
+};
+
+// *****************************************************************************
+// AsyncOperation
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::AsyncOperation::AsyncOperation( AsyncLoader & loader, const char * name, AsyncPriority priority )
+    : mLoader( loader )
+    , mName( name ? name : "" )
+    , mStatus( AsyncStatus::QUEUED )
+    , mPriority( priority )
+    , mCancelRequested( false )
+{
+    if( priority >= AsyncPriority::NUM_PRIORITIES ) mPriority = AsyncPriority::LOW;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncOperation::setPriority( AsyncPriority p )
+{
+    if( p >= AsyncPriority::NUM_PRIORITIES ) p = AsyncPriority::LOW;
+    mLoader.mImpl->setPriority( this, p );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncOperation::cancel()
+{
+    if( isDone() ) return;
+    mLoader.mImpl->cancel( this );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncOperation::onComplete( std::function<void()> callback )
+{
+    if( !callback ) return;
+    {
+        std::lock_guard<Mutex> lock( mCallbackLock );
+        if( !isDone() )
+        {
+            mCallbacks.append( std::move( callback ) );
+            return;
+        }
+    }
+    AutoRef<AsyncOperation> keep( this );
+    mLoader.getJobSystem().runOnMainThread( mName, [keep, callback]{ callback(); } );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncOperation::wait()
+{
+    mLoader.mImpl->waitFor( [this]{ return isDone(); }, mStatus );
+}
+
+// *****************************************************************************
+// AsyncLoader
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::AsyncLoader::AsyncLoader( JobSystem & js, uint32 maxConcurrentOperations )
+    : mImpl( new Impl( js, maxConcurrentOperations ) )
+{
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::AsyncLoader::~AsyncLoader()
+{
+    delete mImpl;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::AsyncLoader & GN::AsyncLoader::sGetGlobalInstance()
+{
+    static AsyncLoader sInstance( JobSystem::sGetGlobalInstance() );
+    return sInstance;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobSystem & GN::AsyncLoader::getJobSystem() const
+{
+    return mImpl->getJobSystem();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::AsyncLoader::update()
+{
+    return mImpl->getJobSystem().processMainThreadJobs();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncLoader::waitAll()
+{
+    mImpl->waitAll();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint32 GN::AsyncLoader::getPendingCount() const
+{
+    return mImpl->getPendingCount();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::AsyncLoader::enqueue( AsyncOperation * op )
+{
+    mImpl->enqueue( op );
+}
@@ -0,0 +1,573 @@
+#include "pch.h"
+#include "garnet/base/binaryLog.h"
+#include <condition_variable>
+#include <vector>
+
+using namespace GN;
+using namespace GN::internal;
+
+static const size_t THREAD_BUFFER_SIZE = 256 * 1024; // must be power of 2
+
+static const uint32 PADDING_RECORD = 0xFFFFFFFF;
+
+// *****************************************************************************
+// local classes
+// *****************************************************************************
+
+///
+/// Owns all per-thread buffers, and runs the decoder thread.
+///
+class BinaryLogManager
+{
+    std::mutex                   mBufferMutex;
+    std::vector<BinaryLogBuffer*> mBuffers;
+    uint32                       mNextThreadId;
+
+    std::mutex                   mSinkMutex;
+    std::vector<BinaryLogSink*>  mSinks;
+
+    std::thread                  mThread;
+    std::mutex                   mWakeMutex;
+    std::condition_variable      mWake;
+    std::condition_variable      mPassDone;
+    uint64                       mPassCount;
+    int                          mFlushWaiters;
+    bool                         mQuit;
+
+    std::atomic<uint64>          mOrphanDropped; ///< drop count of already deleted buffers
+
+    static thread_local bool     msIsDecoderThread;
+
+public:
+
+    BinaryLogManager() : mNextThreadId(0), mPassCount(0), mFlushWaiters(0), mQuit(false), mOrphanDropped(0) {}
+
+    ~BinaryLogManager()
+    {
+        if( mThread.joinable() )
+        {
+            {
+                std::lock_guard<std::mutex> lock( mWakeMutex );
+                mQuit = true;
+            }
+            mWake.notify_one();
+            mThread.join();
+        }
+
+        // threads that are still alive (main thread, for example) lose their buffers here.
+        for( BinaryLogBuffer * b : mBuffers )
+        {
+            ::free( b->data );
+            delete b;
+        }
+    }
+
+    BinaryLogBuffer * createBuffer()
+    {
+        BinaryLogBuffer * b = new BinaryLogBuffer;
+        b->data = (uint8*)::malloc( THREAD_BUFFER_SIZE );
+        b->capacity = b->data ? THREAD_BUFFER_SIZE : 0;
+        b->writePos = 0;
+        b->readPos = 0;
+        b->dropped = 0;
+        b->orphaned = false;
+
+        std::lock_guard<std::mutex> lock( mBufferMutex );
+        b->threadId = mNextThreadId++;
+        mBuffers.push_back( b );
+        if( !mThread.joinable() ) mThread = std::thread( [this]{ threadProc(); } );
+        return b;
+    }
+
+    void addSink( BinaryLogSink * s )
+    {
+        if( NULL == s ) return;
+        std::lock_guard<std::mutex> lock( mSinkMutex );
+        for( BinaryLogSink * x : mSinks ) if( x == s ) return;
+        mSinks.push_back( s );
+    }
+
+    void removeSink( BinaryLogSink * s )
+    {
+        std::lock_guard<std::mutex> lock( mSinkMutex );
+        for( size_t i = 0; i < mSinks.size(); ++i )
+        {
+            if( mSinks[i] == s ) { mSinks.erase( mSinks.begin() + i ); return; }
+        }
+    }
+
+    ///
+    /// Wait for a complete decoding pass that starts after this call.
+    ///
+    void flush()
+    {
+        if( msIsDecoderThread ) return;
+
+        std::unique_lock<std::mutex> lock( mWakeMutex );
+        if( !mThread.joinable() ) return;
+        uint64 target = mPassCount + 2;
+        ++mFlushWaiters;
+        mWake.notify_one();
+        mPassDone.wait( lock, [&]{ return mPassCount >= target || mQuit; } );
+        --mFlushWaiters;
+    }
+
+    ///
+    /// Deliver a record on the calling thread, after all records queued before it.
+    ///
+    void deliverNow( const uint8 * record )
+    {
+        flush();
+
+        std::vector<BinaryLogField> fields;
+        StrA text;
+        const BinaryLogBuffer::RecordHeader * h = (const BinaryLogBuffer::RecordHeader*)record;
+        decode( fields, record + sizeof(*h), h->fieldCount );
+        deliver( getThreadBinaryLogBuffer(), *h, fields, text );
+    }
+
+    uint64 dropCount()
+    {
+        uint64 n = mOrphanDropped;
+        std::lock_guard<std::mutex> lock( mBufferMutex );
+        for( BinaryLogBuffer * b : mBuffers ) n += b->dropped;
+        return n;
+    }
+
+private:
+
+    void threadProc()
+    {
+        msIsDecoderThread = true;
+
+        std::vector<BinaryLogBuffer*> buffers;
+        std::vector<BinaryLogField>   fields;
+        StrA                          text;
+
+        for(;;)
+        {
+            bool quit;
+            {
+                std::unique_lock<std::mutex> lock( mWakeMutex );
+                if( 0 == mFlushWaiters && !mQuit )
+                {
+                    mWake.wait_for( lock, std::chrono::milliseconds(5) );
+                }
+                quit = mQuit;
+            }
+
+            // snapshot buffer list. Buffers are only deleted by this thread, so the pointers stay valid.
+            {
+                std::lock_guard<std::mutex> lock( mBufferMutex );
+                buffers = mBuffers;
+            }
+
+            for( BinaryLogBuffer * b : buffers ) drain( *b, fields, text );
+
+            // delete buffers of exited threads
+            {
+                std::lock_guard<std::mutex> lock( mBufferMutex );
+                for( size_t i = 0; i < mBuffers.size(); )
+                {
+                    BinaryLogBuffer * b = mBuffers[i];
+                    if( b->orphaned && b->readPos.load() == b->writePos.load() )
+                    {
+                        mOrphanDropped += b->dropped;
+                        ::free( b->data );
+                        delete b;
+                        mBuffers.erase( mBuffers.begin() + i );
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock( mWakeMutex );
+                ++mPassCount;
+            }
+            mPassDone.notify_all();
+
+            if( quit ) break;
+        }
+    }
+
+    void drain( BinaryLogBuffer & b, std::vector<BinaryLogField> & fields, StrA & text )
+    {
+        size_t r = b.readPos.load( std::memory_order_relaxed );
+        size_t w = b.writePos.load( std::memory_order_acquire );
+        while( r != w )
+        {
+            const uint8 * p = b.data + ( r & ( b.capacity - 1 ) );
+            const BinaryLogBuffer::RecordHeader * h = (const BinaryLogBuffer::RecordHeader*)p;
+            if( PADDING_RECORD != h->fieldCount )
+            {
+                decode( fields, p + sizeof(*h), h->fieldCount );
+                deliver( b, *h, fields, text );
+            }
+            r += h->size;
+            b.readPos.store( r, std::memory_order_release );
+        }
+    }
+
+    static void decode( std::vector<BinaryLogField> & fields, const uint8 * p, size_t count )
+    {
+        fields.resize( count );
+        for( size_t i = 0; i < count; ++i )
+        {
+            const BinaryLogBuffer::FieldHeader * fh = (const BinaryLogBuffer::FieldHeader*)p;
+            p += sizeof(*fh);
+
+            BinaryLogField & f = fields[i];
+            f.key = NULL;
+            if( fh->hasKey ) { memcpy( &f.key, p, sizeof(f.key) ); p += 8; }
+            f.type = (BinaryLogFieldType)fh->type;
+            f.str = NULL;
+            f.length = 0;
+            if( BLFT_STRING == f.type )
+            {
+                f.u = 0;
+                f.str = (const char*)p;
+                f.length = fh->strLength;
+                p += blogAlign( f.length + 1 );
+            }
+            else
+            {
+                memcpy( &f.u, p, 8 );
+                p += 8;
+            }
+        }
+    }
+
+    void deliver( const BinaryLogBuffer & b, const BinaryLogBuffer::RecordHeader & h, const std::vector<BinaryLogField> & fields, StrA & text )
+    {
+        const BinaryLogSite & site = *h.site;
+
+        renderBinaryLogText( text, site.fmt, fields.data(), fields.size() );
+
+        h.logger->doLog( Logger::LogDesc( site.level, site.func, site.file, site.line ), text.rawptr() );
+
+        std::lock_guard<std::mutex> lock( mSinkMutex );
+        if( mSinks.empty() ) return;
+        BinaryLogRecord rec;
+        rec.logger     = h.logger;
+        rec.site       = &site;
+        rec.threadId   = b.threadId;
+        rec.timestamp  = h.timestamp;
+        rec.fieldCount = fields.size();
+        rec.fields     = fields.data();
+        rec.text       = text.rawptr();
+        for( BinaryLogSink * s : mSinks ) s->onRecord( rec );
+    }
+};
+
+thread_local bool BinaryLogManager::msIsDecoderThread = false;
+
+//
+//
+// -----------------------------------------------------------------------------
+static BinaryLogManager & sGetManager()
+{
+    static BinaryLogManager m;
+    return m;
+}
+
+///
+/// Mark the thread buffer as orphaned when thread exits.
+///
+struct ThreadBufferOwner
+{
+    BinaryLogBuffer * buffer;
+
+    ThreadBufferOwner() : buffer( sGetManager().createBuffer() ) {}
+
+    ~ThreadBufferOwner() { buffer->orphaned = true; }
+};
+
+//
+// Format single argument using the printf conversion spec.
+// -----------------------------------------------------------------------------
+template<typename T>
+static void sAppendFormatted( StrA & result, const char * spec, T value )
+{
+    char buf[256];
+    int n = snprintf( buf, sizeof(buf), spec, value );
+    if( n < 0 ) return;
+    if( (size_t)n < sizeof(buf) )
+    {
+        result.append( buf, (size_t)n );
+    }
+    else
+    {
+        std::vector<char> big( (size_t)n + 1 );
+        snprintf( big.data(), big.size(), spec, value );
+        result.append( big.data(), (size_t)n );
+    }
+}
+
+//
+// Render field without format spec.
+// -----------------------------------------------------------------------------
+static void sAppendField( StrA & result, const BinaryLogField & f )
+{
+    switch( f.type )
+    {
+        case BLFT_SINT    : sAppendFormatted( result, "%lld", (long long)f.s ); break;
+        case BLFT_UINT    : sAppendFormatted( result, "%llu", (unsigned long long)f.u ); break;
+        case BLFT_DOUBLE  : sAppendFormatted( result, "%g", f.d ); break;
+        case BLFT_POINTER : sAppendFormatted( result, "%p", f.p ); break;
+        case BLFT_STRING  : result.append( f.str, f.length ); break;
+    }
+}
+
+static sint64 sAsInt( const BinaryLogField & f )
+{
+    switch( f.type )
+    {
+        case BLFT_DOUBLE  : return (sint64)f.d;
+        case BLFT_POINTER : return (sint64)(intptr_t)f.p;
+        case BLFT_STRING  : return 0;
+        default           : return f.s;
+    }
+}
+
+static double sAsDouble( const BinaryLogField & f )
+{
+    switch( f.type )
+    {
+        case BLFT_SINT   : return (double)f.s;
+        case BLFT_UINT   : return (double)f.u;
+        case BLFT_DOUBLE : return f.d;
+        default          : return 0.0;
+    }
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::BinaryLogSite::BinaryLogSite( int level_, const char * func_, const char * file_, int line_, const char * fmt_ )
+    : level(level_), func(func_), file(file_), line(line_), fmt(fmt_)
+{
+    static std::atomic<uint32> sNextId(0);
+    id = sNextId++;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint8 * GN::internal::BinaryLogBuffer::beginWrite( size_t bytes )
+{
+    size_t w = writePos.load( std::memory_order_relaxed );
+    size_t r = readPos.load( std::memory_order_acquire );
+    size_t offset = w & ( capacity - 1 );
+    size_t contiguous = capacity - offset;
+
+    // records never wrap around: pad to the end of buffer, then start over.
+    size_t needed = bytes > contiguous ? contiguous + bytes : bytes;
+    if( capacity - ( w - r ) < needed )
+    {
+        ++dropped;
+        return NULL;
+    }
+
+    if( bytes > contiguous )
+    {
+        RecordHeader * pad = (RecordHeader*)( data + offset );
+        pad->size = (uint32)contiguous;
+        pad->fieldCount = PADDING_RECORD;
+        writePos.store( w + contiguous, std::memory_order_release );
+        offset = 0;
+    }
+
+    return data + offset;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::internal::BinaryLogBuffer & GN::internal::getThreadBinaryLogBuffer()
+{
+    static thread_local ThreadBufferOwner sOwner;
+    return *sOwner.buffer;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::internal::getBinaryLogTimestamp()
+{
+    return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::internal::deliverBinaryLogRecordNow( const uint8 * record )
+{
+    sGetManager().deliverNow( record );
+    flushLog();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::addBinaryLogSink( BinaryLogSink * s )
+{
+    sGetManager().addSink( s );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::removeBinaryLogSink( BinaryLogSink * s )
+{
+    sGetManager().removeSink( s );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::flushBinaryLog()
+{
+    sGetManager().flush();
+    flushLog();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::getBinaryLogDropCount()
+{
+    return sGetManager().dropCount();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::renderBinaryLogText( StrA & result, const char * fmt, const BinaryLogField * fields, size_t count )
+{
+    result.clear();
+
+    size_t next = 0;
+    auto nextPositional = [&]() -> const BinaryLogField * {
+        while( next < count && NULL != fields[next].key ) ++next;
+        return next < count ? &fields[next++] : NULL;
+    };
+
+    const char * p = fmt ? fmt : "";
+    while( *p )
+    {
+        if( '%' != *p )
+        {
+            const char * e = p;
+            while( *e && '%' != *e ) ++e;
+            result.append( p, (size_t)( e - p ) );
+            p = e;
+            continue;
+        }
+
+        if( '%' == p[1] )
+        {
+            result.append( '%' );
+            p += 2;
+            continue;
+        }
+
+        // parse conversion spec: %[flags][width][.precision][length]conversion
+        const char * start = p++;
+        char spec[64];
+        size_t n = 0;
+        spec[n++] = '%';
+        while( *p && strchr( "-+ #0", *p ) && n < 16 ) spec[n++] = *p++;
+        for( int part = 0; part < 2; ++part )
+        {
+            if( 1 == part )
+            {
+                if( '.' != *p ) break;
+                spec[n++] = *p++;
+            }
+            if( '*' == *p )
+            {
+                const BinaryLogField * f = nextPositional();
+                n += snprintf( spec + n, 16, "%d", f ? (int)sAsInt( *f ) : 0 );
+                ++p;
+            }
+            else
+            {
+                while( *p >= '0' && *p <= '9' && n < 40 ) spec[n++] = *p++;
+            }
+        }
+        while( *p && strchr( "hlLqjzt", *p ) ) ++p;
+        char conv = *p;
+        if( 0 == conv ) { result.append( start ); break; }
+        ++p;
+
+        const BinaryLogField * f = nextPositional();
+        if( NULL == f )
+        {
+            result.append( start, (size_t)( p - start ) );
+            continue;
+        }
+
+        switch( conv )
+        {
+            case 'd': case 'i':
+                spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = 0;
+                sAppendFormatted( result, spec, (long long)sAsInt( *f ) );
+                break;
+
+            case 'u': case 'o': case 'x': case 'X':
+                spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = 0;
+                sAppendFormatted( result, spec, (unsigned long long)sAsInt( *f ) );
+                break;
+
+            case 'c':
+                spec[n++] = conv; spec[n] = 0;
+                sAppendFormatted( result, spec, (int)sAsInt( *f ) );
+                break;
+
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                spec[n++] = conv; spec[n] = 0;
+                sAppendFormatted( result, spec, sAsDouble( *f ) );
+                break;
+
+            case 's':
+                if( BLFT_STRING == f->type )
+                {
+                    spec[n++] = conv; spec[n] = 0;
+                    sAppendFormatted( result, spec, f->str );
+                }
+                else
+                {
+                    sAppendField( result, *f );
+                }
+                break;
+
+            case 'p':
+                sAppendFormatted( result, "%p", BLFT_POINTER == f->type ? f->p : (const void*)(intptr_t)sAsInt( *f ) );
+                break;
+
+            default:
+                // unknown conversion: print the spec as is.
+                result.append( start, (size_t)( p - start ) );
+                break;
+        }
+    }
+
+    // append named fields
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( NULL == fields[i].key ) continue;
+        result.append( ' ' );
+        result.append( fields[i].key );
+        result.append( '=' );
+        sAppendField( result, fields[i] );
+    }
+}
@@ -1,5 +1,11 @@
 #include "pch.h"
 
+using namespace GN;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -14,6 +20,525 @@ static float sGetNextValue( const float * & buffer, size_t stride )
     return f;
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+static inline const Vector3f * sAdvance( const Vector3f * p, size_t stride )
+{
+    return (const Vector3f*)( (const uint8*)p + stride );
+}
+
+//
+// x, y and z are adjacent floats of one vertex stream, which can be read as Vector3f.
+// -----------------------------------------------------------------------------
+static inline bool sIsVector3Stream(
+    const float * x, size_t strideX,
+    const float * y, size_t strideY,
+    const float * z, size_t strideZ )
+{
+    return x && y == x + 1 && z == x + 2 && strideX == strideY && strideY == strideZ;
+}
+
+//
+// Min/max corners of the positions. Count must be larger than 0.
+// -----------------------------------------------------------------------------
+static void sMinMax( Vector3f & vmin, Vector3f & vmax, const Vector3f * positions, size_t stride, size_t count )
+{
+    GN_ASSERT( count > 0 );
+
+    vmin = vmax = *positions;
+
+    size_t i = 1;
+    const Vector3f * p = sAdvance( positions, stride );
+
+#if GN_SIMD
+    using namespace GN::simd;
+
+    // load() reads 4 floats, which is safe for all but the last vertex.
+    if( stride >= sizeof(Vector3f) && count > 2 )
+    {
+        Float4 mn0 = load( &positions->x ), mx0 = mn0, mn1 = mn0, mx1 = mn0;
+        for( ; i + 2 < count; i += 2 )
+        {
+            Float4 a = load( &p->x );
+            p = sAdvance( p, stride );
+            Float4 b = load( &p->x );
+            p = sAdvance( p, stride );
+            mn0 = minimum( mn0, a );
+            mx0 = maximum( mx0, a );
+            mn1 = minimum( mn1, b );
+            mx1 = maximum( mx1, b );
+        }
+        float f[4];
+        store( f, minimum( mn0, mn1 ) );
+        vmin.set( f[0], f[1], f[2] );
+        store( f, maximum( mx0, mx1 ) );
+        vmax.set( f[0], f[1], f[2] );
+    }
+#endif
+
+    for( ; i < count; ++i, p = sAdvance( p, stride ) )
+    {
+        vmin.x = math::getmin( vmin.x, p->x );
+        vmin.y = math::getmin( vmin.y, p->y );
+        vmin.z = math::getmin( vmin.z, p->z );
+        vmax.x = math::getmax( vmax.x, p->x );
+        vmax.y = math::getmax( vmax.y, p->y );
+        vmax.z = math::getmax( vmax.z, p->z );
+    }
+}
+
+#if GN_SIMD
+
+//
+// Load 4 strided positions into SoA registers. Must not be used on the last vertex,
+// since each load reads 4 floats.
+// -----------------------------------------------------------------------------
+static GN_FORCE_INLINE void sLoad4( const Vector3f * & p, size_t stride, simd::Float4 & x, simd::Float4 & y, simd::Float4 & z )
+{
+    using namespace GN::simd;
+    x = load( &p->x ); p = sAdvance( p, stride );
+    y = load( &p->x ); p = sAdvance( p, stride );
+    z = load( &p->x ); p = sAdvance( p, stride );
+    Float4 w = load( &p->x ); p = sAdvance( p, stride );
+    simd::transpose( x, y, z, w );
+}
+
+//
+// Horizontal min/max of 4 lanes
+// -----------------------------------------------------------------------------
+static inline float sHMin( simd::Float4 v )
+{
+    using namespace GN::simd;
+    v = minimum( v, shuffle<2,3,0,1>( v ) );
+    return getX( minimum( v, shuffle<1,0,3,2>( v ) ) );
+}
+static inline float sHMax( simd::Float4 v )
+{
+    using namespace GN::simd;
+    v = maximum( v, shuffle<2,3,0,1>( v ) );
+    return getX( maximum( v, shuffle<1,0,3,2>( v ) ) );
+}
+static inline float sHSum( simd::Float4 v )
+{
+    using namespace GN::simd;
+    v = add( v, shuffle<2,3,0,1>( v ) );
+    return getX( add( v, shuffle<1,0,3,2>( v ) ) );
+}
+
+#endif
+
+//
+// Projections of one point onto k-DOP axes, in the order of Dop::sGetAxis().
+// Works on both float and simd::Float4.
+// -----------------------------------------------------------------------------
+template<bool FACES, bool CORNERS, bool EDGES, typename V, typename ADD, typename SUB>
+static GN_FORCE_INLINE size_t sProjectDop( V * d, V x, V y, V z, ADD add, SUB sub )
+{
+    size_t n = 0;
+    if( FACES )
+    {
+        d[n++] = x;
+        d[n++] = y;
+        d[n++] = z;
+    }
+    if( CORNERS )
+    {
+        V xy = add( x, y );
+        V xmy = sub( x, y );
+        d[n++] = add( xy, z );
+        d[n++] = sub( xy, z );
+        d[n++] = add( xmy, z );
+        d[n++] = sub( z, xmy );
+    }
+    if( EDGES )
+    {
+        d[n++] = add( x, y );
+        d[n++] = sub( x, y );
+        d[n++] = add( x, z );
+        d[n++] = sub( x, z );
+        d[n++] = add( y, z );
+        d[n++] = sub( y, z );
+    }
+    return n;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+template<bool FACES, bool CORNERS, bool EDGES>
+static void sCalcDop( float * mins, float * maxs, const Vector3f * positions, size_t stride, size_t count )
+{
+    const size_t N = ( FACES ? 3 : 0 ) + ( CORNERS ? 4 : 0 ) + ( EDGES ? 6 : 0 );
+
+    if( 0 == count )
+    {
+        for( size_t k = 0; k < N; ++k ) mins[k] = maxs[k] = 0;
+        return;
+    }
+
+    for( size_t k = 0; k < N; ++k )
+    {
+        mins[k] = FLT_MAX;
+        maxs[k] = -FLT_MAX;
+    }
+
+    size_t i = 0;
+    const Vector3f * p = positions;
+
+#if GN_SIMD
+    using namespace GN::simd;
+    if( stride >= sizeof(Vector3f) && count > 4 )
+    {
+        Float4 mn[N], mx[N];
+        for( size_t k = 0; k < N; ++k )
+        {
+            mn[k] = splat( FLT_MAX );
+            mx[k] = splat( -FLT_MAX );
+        }
+        for( ; i + 4 < count; i += 4 )
+        {
+            Float4 x, y, z, d[N];
+            sLoad4( p, stride, x, y, z );
+            sProjectDop<FACES, CORNERS, EDGES>( d, x, y, z,
+                []( Float4 a, Float4 b ) { return add( a, b ); },
+                []( Float4 a, Float4 b ) { return sub( a, b ); } );
+            for( size_t k = 0; k < N; ++k )
+            {
+                mn[k] = minimum( mn[k], d[k] );
+                mx[k] = maximum( mx[k], d[k] );
+            }
+        }
+        for( size_t k = 0; k < N; ++k )
+        {
+            mins[k] = sHMin( mn[k] );
+            maxs[k] = sHMax( mx[k] );
+        }
+    }
+#endif
+
+    for( ; i < count; ++i, p = sAdvance( p, stride ) )
+    {
+        float d[N];
+        sProjectDop<FACES, CORNERS, EDGES>( d, p->x, p->y, p->z,
+            []( float a, float b ) { return a + b; },
+            []( float a, float b ) { return a - b; } );
+        for( size_t k = 0; k < N; ++k )
+        {
+            mins[k] = math::getmin( mins[k], d[k] );
+            maxs[k] = math::getmax( maxs[k], d[k] );
+        }
+    }
+}
+
+//
+// Grow sphere to include the point (Ritter).
+// -----------------------------------------------------------------------------
+static inline void sGrowSphere( Spheref & s, const Vector3f & p )
+{
+    Vector3f d = p - s.center;
+    float dist2 = d.lengthSqr();
+    if( dist2 <= s.radius * s.radius ) return;
+    float dist = sqrt( dist2 );
+    float r = ( s.radius + dist ) * 0.5f;
+    s.center += d * ( ( r - s.radius ) / dist );
+    s.radius = r;
+}
+
+//
+// Tolerance used by the minimal sphere algorithm.
+// -----------------------------------------------------------------------------
+static const float MINIMAL_SPHERE_TOLERANCE = 1e-5f;
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline bool sSphereContains( const Spheref & s, const Vector3f & p )
+{
+    if( s.radius < 0 ) return false;
+    float r = s.radius * ( 1.0f + MINIMAL_SPHERE_TOLERANCE ) + MINIMAL_SPHERE_TOLERANCE;
+    return Vector3f::sDistanceSqr( s.center, p ) <= r * r;
+}
+
+//
+// Smallest sphere through 2 points
+// -----------------------------------------------------------------------------
+static inline Spheref sSphereFrom2( const Vector3f & a, const Vector3f & b )
+{
+    return Spheref( ( a + b ) * 0.5f, Vector3f::sDistance( a, b ) * 0.5f );
+}
+
+//
+// Smallest sphere through 3 points: the circumcircle. Degenerated (collinear)
+// points use the farthest pair.
+// -----------------------------------------------------------------------------
+static Spheref sSphereFrom3( const Vector3f & a, const Vector3f & b, const Vector3f & c )
+{
+    Vector3f ab = b - a;
+    Vector3f ac = c - a;
+    Vector3f n = Vector3f::sCross( ab, ac );
+    float denom = 2.0f * n.lengthSqr();
+    if( denom > 1e-10f * ab.lengthSqr() * ac.lengthSqr() )
+    {
+        Vector3f o = ( Vector3f::sCross( n, ab ) * ac.lengthSqr() + Vector3f::sCross( ac, n ) * ab.lengthSqr() ) / denom;
+        return Spheref( a + o, o.length() );
+    }
+
+    Spheref s = sSphereFrom2( a, b );
+    Spheref t = sSphereFrom2( a, c );
+    if( t.radius > s.radius ) s = t;
+    t = sSphereFrom2( b, c );
+    if( t.radius > s.radius ) s = t;
+    return s;
+}
+
+//
+// Sphere through 4 points: the circumsphere. Degenerated (coplanar) points use
+// the smallest 3-point sphere that contains the 4th point.
+// -----------------------------------------------------------------------------
+static Spheref sSphereFrom4( const Vector3f & a, const Vector3f & b, const Vector3f & c, const Vector3f & d )
+{
+    Vector3f ab = b - a;
+    Vector3f ac = c - a;
+    Vector3f ad = d - a;
+    Vector3f bc = Vector3f::sCross( ac, ad );
+    float det = Vector3f::sDot( ab, bc );
+    if( fabs( det ) > 1e-6f * ab.length() * ac.length() * ad.length() )
+    {
+        Vector3f o = ( bc * ab.lengthSqr()
+                     + Vector3f::sCross( ad, ab ) * ac.lengthSqr()
+                     + Vector3f::sCross( ab, ac ) * ad.lengthSqr() ) / ( 2.0f * det );
+        return Spheref( a + o, o.length() );
+    }
+
+    const Vector3f * p[4] = { &a, &b, &c, &d };
+    Spheref best( 0, 0, 0, -1 );
+    for( int skip = 0; skip < 4; ++skip )
+    {
+        const Vector3f * q[3];
+        for( int i = 0, n = 0; i < 4; ++i ) if( i != skip ) q[n++] = p[i];
+        Spheref s = sSphereFrom3( *q[0], *q[1], *q[2] );
+        if( sSphereContains( s, *p[skip] ) && ( best.radius < 0 || s.radius < best.radius ) ) best = s;
+    }
+    if( best.radius < 0 ) best = sSphereFrom3( a, b, c );
+    return best;
+}
+
+//
+// Welzl's algorithm. Return minimal sphere of the first n points, with the support
+// points on its boundary.
+// -----------------------------------------------------------------------------
+static Spheref sWelzl( const Vector3f * points, size_t n, Vector3f * support, size_t numSupport )
+{
+    Spheref s;
+    switch( numSupport )
+    {
+        case 0  : s.set( Vector3f( 0, 0, 0 ), -1 ); break;
+        case 1  : s.set( support[0], 0 ); break;
+        case 2  : s = sSphereFrom2( support[0], support[1] ); break;
+        case 3  : s = sSphereFrom3( support[0], support[1], support[2] ); break;
+        default : return sSphereFrom4( support[0], support[1], support[2], support[3] );
+    }
+
+    for( size_t i = 0; i < n; ++i )
+    {
+        if( !sSphereContains( s, points[i] ) )
+        {
+            support[numSupport] = points[i];
+            s = sWelzl( points, i, support, numSupport + 1 );
+        }
+    }
+
+    return s;
+}
+
+//
+// Eigenvectors of a symmetric 3x3 matrix, using Jacobi rotations. The matrix is
+// destroyed, with eigenvalues left on the diagonal. Eigenvectors are in columns of v.
+// -----------------------------------------------------------------------------
+static void sJacobiEigenVectors( double a[3][3], double v[3][3] )
+{
+    for( int i = 0; i < 3; ++i ) for( int j = 0; j < 3; ++j ) v[i][j] = ( i == j ) ? 1.0 : 0.0;
+
+    for( int sweep = 0; sweep < 32; ++sweep )
+    {
+        double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if( off <= 1e-24 * diag ) break;
+
+        for( int p = 0; p < 2; ++p )
+        for( int q = p + 1; q < 3; ++q )
+        {
+            if( 0.0 == a[p][q] ) continue;
+            double theta = ( a[q][q] - a[p][p] ) / ( 2.0 * a[p][q] );
+            double t = ( theta >= 0 ? 1.0 : -1.0 ) / ( fabs( theta ) + ::sqrt( theta * theta + 1.0 ) );
+            double c = 1.0 / ::sqrt( t * t + 1.0 );
+            double s = t * c;
+            for( int k = 0; k < 3; ++k )
+            {
+                double kp = a[k][p], kq = a[k][q];
+                a[k][p] = c * kp - s * kq;
+                a[k][q] = s * kp + c * kq;
+            }
+            for( int k = 0; k < 3; ++k )
+            {
+                double pk = a[p][k], qk = a[q][k];
+                a[p][k] = c * pk - s * qk;
+                a[q][k] = s * pk + c * qk;
+            }
+            for( int k = 0; k < 3; ++k )
+            {
+                double kp = v[k][p], kq = v[k][q];
+                v[k][p] = c * kp - s * kq;
+                v[k][q] = s * kp + c * kq;
+            }
+        }
+    }
+}
+
+//
+// Mean and covariance of the positions.
+// -----------------------------------------------------------------------------
+static void sCovariance( Vector3f & mean, double cov[3][3], const Vector3f * positions, size_t stride, size_t count )
+{
+    GN_ASSERT( count > 0 );
+
+    // mean
+    double sx = 0, sy = 0, sz = 0;
+    size_t i = 0;
+    const Vector3f * p = positions;
+#if GN_SIMD
+    using namespace GN::simd;
+    if( stride >= sizeof(Vector3f) && count > 4 )
+    {
+        Float4 ax = zero(), ay = zero(), az = zero();
+        for( ; i + 4 < count; i += 4 )
+        {
+            Float4 x, y, z;
+            sLoad4( p, stride, x, y, z );
+            ax = add( ax, x );
+            ay = add( ay, y );
+            az = add( az, z );
+        }
+        sx = sHSum( ax );
+        sy = sHSum( ay );
+        sz = sHSum( az );
+    }
+#endif
+    for( ; i < count; ++i, p = sAdvance( p, stride ) )
+    {
+        sx += p->x;
+        sy += p->y;
+        sz += p->z;
+    }
+    mean.set( (float)( sx / count ), (float)( sy / count ), (float)( sz / count ) );
+
+    // covariance around the mean
+    double xx = 0, yy = 0, zz = 0, xy = 0, xz = 0, yz = 0;
+    i = 0;
+    p = positions;
+#if GN_SIMD
+    if( stride >= sizeof(Vector3f) && count > 4 )
+    {
+        Float4 mx = splat( mean.x ), my = splat( mean.y ), mz = splat( mean.z );
+        Float4 axx = zero(), ayy = zero(), azz = zero(), axy = zero(), axz = zero(), ayz = zero();
+        for( ; i + 4 < count; i += 4 )
+        {
+            Float4 x, y, z;
+            sLoad4( p, stride, x, y, z );
+            x = sub( x, mx );
+            y = sub( y, my );
+            z = sub( z, mz );
+            axx = madd( x, x, axx );
+            ayy = madd( y, y, ayy );
+            azz = madd( z, z, azz );
+            axy = madd( x, y, axy );
+            axz = madd( x, z, axz );
+            ayz = madd( y, z, ayz );
+        }
+        xx = sHSum( axx );
+        yy = sHSum( ayy );
+        zz = sHSum( azz );
+        xy = sHSum( axy );
+        xz = sHSum( axz );
+        yz = sHSum( ayz );
+    }
+#endif
+    for( ; i < count; ++i, p = sAdvance( p, stride ) )
+    {
+        double x = p->x - mean.x, y = p->y - mean.y, z = p->z - mean.z;
+        xx += x * x;
+        yy += y * y;
+        zz += z * z;
+        xy += x * y;
+        xz += x * z;
+        yz += y * z;
+    }
+    cov[0][0] = xx / count; cov[0][1] = xy / count; cov[0][2] = xz / count;
+    cov[1][0] = xy / count; cov[1][1] = yy / count; cov[1][2] = yz / count;
+    cov[2][0] = xz / count; cov[2][1] = yz / count; cov[2][2] = zz / count;
+}
+
+//
+// Min/max projections of the positions onto 3 axes.
+// -----------------------------------------------------------------------------
+static void sProjectMinMax( Vector3f & vmin, Vector3f & vmax, const Vector3f axes[3], const Vector3f * positions, size_t stride, size_t count )
+{
+    GN_ASSERT( count > 0 );
+
+    float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    size_t i = 0;
+    const Vector3f * p = positions;
+#if GN_SIMD
+    using namespace GN::simd;
+    if( stride >= sizeof(Vector3f) && count > 4 )
+    {
+        Float4 ax[3], ay[3], az[3], mn[3], mx[3];
+        for( int k = 0; k < 3; ++k )
+        {
+            ax[k] = splat( axes[k].x );
+            ay[k] = splat( axes[k].y );
+            az[k] = splat( axes[k].z );
+            mn[k] = splat( FLT_MAX );
+            mx[k] = splat( -FLT_MAX );
+        }
+        for( ; i + 4 < count; i += 4 )
+        {
+            Float4 x, y, z;
+            sLoad4( p, stride, x, y, z );
+            for( int k = 0; k < 3; ++k )
+            {
+                Float4 d = madd( x, ax[k], madd( y, ay[k], mul( z, az[k] ) ) );
+                mn[k] = minimum( mn[k], d );
+                mx[k] = maximum( mx[k], d );
+            }
+        }
+        for( int k = 0; k < 3; ++k )
+        {
+            mins[k] = sHMin( mn[k] );
+            maxs[k] = sHMax( mx[k] );
+        }
+    }
+#endif
+    for( ; i < count; ++i, p = sAdvance( p, stride ) )
+    {
+        for( int k = 0; k < 3; ++k )
+        {
+            float d = Vector3f::sDot( *p, axes[k] );
+            mins[k] = math::getmin( mins[k], d );
+            maxs[k] = math::getmax( maxs[k], d );
+        }
+    }
+    vmin.set( mins[0], mins[1], mins[2] );
+    vmax.set( maxs[0], maxs[1], maxs[2] );
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -30,6 +555,14 @@ GN_API void GN::calculateBoundingSphere(
 
     result.center = box.center();
     result.radius = Vector3f::sDistance( result.center, box.pos() );
+
+    // Ritter's sphere is usually, but not always, tighter.
+    if( count > 0 && sIsVector3Stream( x, strideX, y, strideY, z, strideZ ) )
+    {
+        Spheref ritter;
+        calculateBoundingSphereRitter( ritter, (const Vector3f*)x, strideX, count );
+        if( ritter.radius < result.radius ) result = ritter;
+    }
 }
 
 //
@@ -54,6 +587,175 @@ GN_API void GN::calculateBoundingSphereFromBoundingBox( Spheref & result, const
     result.radius = Vector3f::sDistance( result.center, bbox.pos() );
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateBoundingSphereRitter( Spheref & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    result.set( Vector3f( 0, 0, 0 ), 0 );
+    if( NULL == positions || 0 == count ) return;
+
+    // find extreme points along x, y and z.
+    const Vector3f * mins[3] = { positions, positions, positions };
+    const Vector3f * maxs[3] = { positions, positions, positions };
+    const Vector3f * p = positions;
+    for( size_t i = 0; i < count; ++i, p = sAdvance( p, strideInBytes ) )
+    {
+        if( p->x < mins[0]->x ) mins[0] = p;
+        if( p->x > maxs[0]->x ) maxs[0] = p;
+        if( p->y < mins[1]->y ) mins[1] = p;
+        if( p->y > maxs[1]->y ) maxs[1] = p;
+        if( p->z < mins[2]->z ) mins[2] = p;
+        if( p->z > maxs[2]->z ) maxs[2] = p;
+    }
+
+    // start with the most separated pair.
+    int axis = 0;
+    float maxDist2 = Vector3f::sDistanceSqr( *mins[0], *maxs[0] );
+    for( int k = 1; k < 3; ++k )
+    {
+        float d2 = Vector3f::sDistanceSqr( *mins[k], *maxs[k] );
+        if( d2 > maxDist2 ) { maxDist2 = d2; axis = k; }
+    }
+    result = sSphereFrom2( *mins[axis], *maxs[axis] );
+
+    // grow to include all points. Outliers are rare, so test 4 points at a time.
+    size_t i = 0;
+    p = positions;
+#if GN_SIMD
+    using namespace GN::simd;
+    if( strideInBytes >= sizeof(Vector3f) && count > 4 )
+    {
+        for( ; i + 4 < count; i += 4 )
+        {
+            const Vector3f * p4 = p;
+            Float4 x, y, z;
+            sLoad4( p, strideInBytes, x, y, z );
+            x = sub( x, splat( result.center.x ) );
+            y = sub( y, splat( result.center.y ) );
+            z = sub( z, splat( result.center.z ) );
+            Float4 d2 = madd( x, x, madd( y, y, mul( z, z ) ) );
+            int outside = movemask( cmplt( splat( result.radius * result.radius ), d2 ) );
+            for( int k = 0; outside; ++k, outside >>= 1, p4 = sAdvance( p4, strideInBytes ) )
+            {
+                if( outside & 1 ) sGrowSphere( result, *p4 );
+            }
+        }
+    }
+#endif
+    for( ; i < count; ++i, p = sAdvance( p, strideInBytes ) )
+    {
+        sGrowSphere( result, *p );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateMinimalBoundingSphere( Spheref & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    result.set( Vector3f( 0, 0, 0 ), 0 );
+    if( NULL == positions || 0 == count ) return;
+
+    // Welzl's algorithm runs in expected linear time on randomly ordered points.
+    DynaArray<Vector3f> points( count );
+    const Vector3f * p = positions;
+    for( size_t i = 0; i < count; ++i, p = sAdvance( p, strideInBytes ) ) points[i] = *p;
+    uint64 seed = 0x9E3779B97F4A7C15ULL;
+    for( size_t i = count - 1; i > 0; --i )
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t j = (size_t)( ( seed >> 33 ) % ( i + 1 ) );
+        std::swap( points[i], points[j] );
+    }
+
+    Vector3f support[4];
+    result = sWelzl( points.rawptr(), count, support, 0 );
+
+    // make sure all points are inside, despite of the tolerance.
+    result.radius = result.radius * ( 1.0f + MINIMAL_SPHERE_TOLERANCE ) + MINIMAL_SPHERE_TOLERANCE;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateOrientedBoundingBox( OrientedBoxf & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    result.center.set( 0, 0, 0 );
+    result.axes[0].set( 1, 0, 0 );
+    result.axes[1].set( 0, 1, 0 );
+    result.axes[2].set( 0, 0, 1 );
+    result.extents.set( 0, 0, 0 );
+    if( NULL == positions || 0 == count ) return;
+
+    // principal axes
+    Vector3f mean;
+    double cov[3][3], v[3][3];
+    sCovariance( mean, cov, positions, strideInBytes, count );
+    sJacobiEigenVectors( cov, v );
+    Vector3f axes[3];
+    axes[0].set( (float)v[0][0], (float)v[1][0], (float)v[2][0] );
+    axes[1].set( (float)v[0][1], (float)v[1][1], (float)v[2][1] );
+    axes[0].normalize();
+    axes[1] = axes[1] - axes[0] * Vector3f::sDot( axes[0], axes[1] );
+    axes[1].normalize();
+    axes[2] = Vector3f::sCross( axes[0], axes[1] );
+
+    Vector3f vmin, vmax;
+    sProjectMinMax( vmin, vmax, axes, positions, strideInBytes, count );
+    Vector3f extents = ( vmax - vmin ) * 0.5f;
+    Vector3f mid = ( vmax + vmin ) * 0.5f;
+
+    // PCA axes are not optimal. Use axis aligned box if it is smaller.
+    Vector3f amin, amax;
+    sMinMax( amin, amax, positions, strideInBytes, count );
+    Vector3f aabbExtents = ( amax - amin ) * 0.5f;
+    if( aabbExtents.x * aabbExtents.y * aabbExtents.z <= extents.x * extents.y * extents.z )
+    {
+        result.center = ( amax + amin ) * 0.5f;
+        result.extents = aabbExtents;
+        return;
+    }
+
+    result.center = axes[0] * mid.x + axes[1] * mid.y + axes[2] * mid.z;
+    result.axes[0] = axes[0];
+    result.axes[1] = axes[1];
+    result.axes[2] = axes[2];
+    result.extents = extents;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateDop( Dop8 & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    sCalcDop<false, true, false>( result.minimum, result.maximum, positions, strideInBytes, positions ? count : 0 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateDop( Dop14 & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    sCalcDop<true, true, false>( result.minimum, result.maximum, positions, strideInBytes, positions ? count : 0 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateDop( Dop18 & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    sCalcDop<true, false, true>( result.minimum, result.maximum, positions, strideInBytes, positions ? count : 0 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::calculateDop( Dop26 & result, const Vector3f * positions, size_t strideInBytes, size_t count )
+{
+    sCalcDop<true, true, true>( result.minimum, result.maximum, positions, strideInBytes, positions ? count : 0 );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -70,28 +772,37 @@ void GN::calculateBoundingBox(
 
     if( 0 == count ) return;
 
-    float x, y, z;
+    Vector3f vMin, vMax;
 
-    x = sGetNextValue( valueX, strideX );
-    y = sGetNextValue( valueY, strideY );
-    z = sGetNextValue( valueZ, strideZ );
-
-    Vector3f vMin( x, y, z );
-    Vector3f vMax( x, y, z );
-
-    for( size_t i = 1; i < count; ++i )
+    if( sIsVector3Stream( valueX, strideX, valueY, strideY, valueZ, strideZ ) )
+    {
+        sMinMax( vMin, vMax, (const Vector3f*)valueX, strideX, count );
+    }
+    else
     {
+        float x, y, z;
+
         x = sGetNextValue( valueX, strideX );
         y = sGetNextValue( valueY, strideY );
         z = sGetNextValue( valueZ, strideZ );
 
-        vMin.x = math::getmin( vMin.x, x );
-        vMin.y = math::getmin( vMin.y, y );
-        vMin.z = math::getmin( vMin.z, z );
+        vMin.set( x, y, z );
+        vMax.set( x, y, z );
+
+        for( size_t i = 1; i < count; ++i )
+        {
+            x = sGetNextValue( valueX, strideX );
+            y = sGetNextValue( valueY, strideY );
+            z = sGetNextValue( valueZ, strideZ );
+
+            vMin.x = math::getmin( vMin.x, x );
+            vMin.y = math::getmin( vMin.y, y );
+            vMin.z = math::getmin( vMin.z, z );
 
-        vMax.x = math::getmax( vMax.x, x );
-        vMax.y = math::getmax( vMax.y, y );
-        vMax.z = math::getmax( vMax.z, z );
+            vMax.x = math::getmax( vMax.x, x );
+            vMax.y = math::getmax( vMax.y, y );
+            vMax.z = math::getmax( vMax.z, z );
+        }
     }
 
     result.pos() = vMin;
@@ -2,7 +2,7 @@
 #include "garnet/base/clock.h"
 #if GN_POSIX
 #include <pthread.h>
-#include <sys/timeb.h>
+#include <time.h>
 #endif
 
 // *****************************************************************************
@@ -29,7 +29,7 @@ static GN::Clock::CycleType sGetSystemCycleFrequency()
     }
 #else
     GN_UNUSED_PARAM(sLogger);
-    r = 1000;
+    r = 1000000000; // clock_gettime() returns nanoseconds
 #endif
 
     // success
@@ -64,9 +64,9 @@ GN_API GN::Clock::CycleType GN::Clock::sGetSystemCycleCount()
     }
     return r;
 #elif GN_POSIX
-    timeb tp;
-    ftime (&tp);
-    return CycleType(tp.time * 1000 + tp.millitm);
+    timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return CycleType(tp.tv_sec) * 1000000000 + tp.tv_nsec;
 #else
 #error Unknown platform!
 #endif
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "garnet/GNinput.h"
 #include <stdlib.h>
+#include <atomic>
 
 // GN::input::Input singletons
 GN_API GN::input::Input * GN::input::Input::msInstancePtr = 0;
@@ -9,6 +10,12 @@ namespace GN
 {
     static Logger * sHeapLogger = getLogger("GN.core.heapAllocation");
 
+    static std::atomic<bool>   sHeapStatsEnabled( false );
+    static std::atomic<uint64> sHeapAllocCount( 0 );
+    static std::atomic<uint64> sHeapReallocCount( 0 );
+    static std::atomic<uint64> sHeapFreeCount( 0 );
+    static std::atomic<uint64> sHeapAllocBytes( 0 );
+
     //
     //
     // -----------------------------------------------------------------------------
@@ -40,6 +47,11 @@ namespace GN
     GN_API void * HeapMemory::alignedAlloc( size_t sizeInBytes, size_t alignment )
     {
         if( 0 == alignment ) alignment = sizeof(size_t);
+        if( sHeapStatsEnabled.load( std::memory_order_relaxed ) )
+        {
+            sHeapAllocCount.fetch_add( 1, std::memory_order_relaxed );
+            sHeapAllocBytes.fetch_add( sizeInBytes, std::memory_order_relaxed );
+        }
 #if GN_DARWIN
         void * ptr;
         if (posix_memalign(&ptr, sizeInBytes, alignment))
@@ -66,8 +78,13 @@ namespace GN
     GN_API void * HeapMemory::alignedRealloc( void * ptr, size_t sizeInBytes, size_t alignment )
     {
         if( 0 == alignment ) alignment = sizeof(size_t);
+        if( sHeapStatsEnabled.load( std::memory_order_relaxed ) )
+        {
+            sHeapReallocCount.fetch_add( 1, std::memory_order_relaxed );
+            sHeapAllocBytes.fetch_add( sizeInBytes, std::memory_order_relaxed );
+        }
 #if GN_POSIX
-        ptr = realloc( ptr, sizeInBytes );
+        ptr = ::realloc( ptr, sizeInBytes );
 #else
         ptr = _aligned_realloc( ptr, sizeInBytes, alignment );
         if ( 0 == ptr ) { GN_ERROR(sHeapLogger)( "out of memory!" ); }
@@ -80,10 +97,41 @@ namespace GN
     // -----------------------------------------------------------------------------
     GN_API void HeapMemory::dealloc( void * ptr )
     {
+        if( ptr && sHeapStatsEnabled.load( std::memory_order_relaxed ) ) sHeapFreeCount.fetch_add( 1, std::memory_order_relaxed );
 #if GN_POSIX
         return ::free( ptr );
 #else
         return _aligned_free( ptr );
 #endif
     }
+
+    //
+    //
+    // -----------------------------------------------------------------------------
+    GN_API void HeapMemory::enableStatistics( bool enabled )
+    {
+        sHeapStatsEnabled.store( enabled, std::memory_order_relaxed );
+    }
+
+    //
+    //
+    // -----------------------------------------------------------------------------
+    GN_API void HeapMemory::getStatistics( Statistics & stats )
+    {
+        stats.allocCount   = sHeapAllocCount.load( std::memory_order_relaxed );
+        stats.reallocCount = sHeapReallocCount.load( std::memory_order_relaxed );
+        stats.freeCount    = sHeapFreeCount.load( std::memory_order_relaxed );
+        stats.allocBytes   = sHeapAllocBytes.load( std::memory_order_relaxed );
+    }
+
+    //
+    //
+    // -----------------------------------------------------------------------------
+    GN_API void HeapMemory::resetStatistics()
+    {
+        sHeapAllocCount = 0;
+        sHeapReallocCount = 0;
+        sHeapFreeCount = 0;
+        sHeapAllocBytes = 0;
+    }
 }
@@ -1,5 +1,10 @@
 #include "pch.h"
 #include <set>
+#include <condition_variable>
+#if GN_POSIX
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 // Note: to prevent circle referencing, this file should try to avoid
 // referencing other garnet components as much as possible.
@@ -441,6 +446,290 @@ namespace GN
         }
     };
 
+    class LoggerImpl;
+
+    ///
+    /// Asynchronous log writer.
+    ///
+    /// Log records are pushed into a bounded multi-producer/single-consumer ring buffer
+    /// (Dmitry Vyukov's sequence-per-slot scheme, so producers never take a lock), then
+    /// delivered to receivers by a background writer thread.
+    ///
+    class AsyncLogWriter
+    {
+        /// Messages shorter than this are stored inline in the ring buffer slot.
+        static const size_t INLINE_TEXT_SIZE = 240;
+
+        /// Number of slots in the ring buffer. Must be power of 2.
+        static const size_t RING_SIZE = 4096;
+
+        struct Record
+        {
+            LoggerImpl     * logger;
+            Logger::LogDesc  desc;
+            bool             wide;
+            char           * heapText; ///< non-NULL, if the message is too long to fit into inline buffer.
+            union
+            {
+                char         text[INLINE_TEXT_SIZE];
+                wchar_t      wtext[INLINE_TEXT_SIZE/sizeof(wchar_t)];
+            };
+
+            const void * message() const { return heapText ? heapText : text; }
+        };
+
+        struct Slot
+        {
+            std::atomic<size_t> seq;
+            Record              record;
+        };
+
+        Slot                  * mSlots;
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mTail;  ///< next position to write (shared by producers)
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mHead;  ///< next position to read (owned by the consumer)
+        std::atomic_flag        mConsumerLock;  ///< held by whoever is draining the ring buffer.
+
+        std::atomic<bool>       mRunning;
+        std::atomic<int>        mActiveProducers;
+        std::atomic<bool>       mSleeping;
+        std::atomic<int>        mFlushWaiters;
+        bool                    mQuit;
+        std::thread             mThread;
+        std::mutex              mWakeMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDrained;
+
+        static GN_TLS bool      msIsWriterThread;
+
+    public:
+
+        AsyncLogWriter()
+            : mSlots(NULL)
+            , mTail(0)
+            , mHead(0)
+            , mRunning(false)
+            , mActiveProducers(0)
+            , mSleeping(false)
+            , mFlushWaiters(0)
+            , mQuit(false)
+        {
+            mConsumerLock.clear();
+        }
+
+        ~AsyncLogWriter()
+        {
+            stop();
+            ::free( mSlots );
+        }
+
+        bool running() const { return mRunning; }
+
+        /// start the writer thread
+        void start()
+        {
+            if( mRunning ) return;
+
+            if( NULL == mSlots )
+            {
+                mSlots = (Slot*)::malloc( sizeof(Slot) * RING_SIZE );
+                if( NULL == mSlots ) return;
+            }
+            for( size_t i = 0; i < RING_SIZE; ++i )
+            {
+                new (&mSlots[i].seq) std::atomic<size_t>( i );
+            }
+            mTail = 0;
+            mHead = 0;
+            mQuit = false;
+            mThread = std::thread( [this]{ threadProc(); } );
+            mRunning = true;
+        }
+
+        /// Stop the writer thread. All pending records are delivered before the function returns.
+        void stop()
+        {
+            if( !mRunning ) return;
+
+            // reject new records, then wait for in-flight producers.
+            mRunning = false;
+            while( mActiveProducers > 0 ) std::this_thread::yield();
+
+            {
+                std::lock_guard<std::mutex> lock( mWakeMutex );
+                mQuit = true;
+            }
+            mWake.notify_one();
+            if( mThread.joinable() )
+            {
+                if( msIsWriterThread ) mThread.detach(); else mThread.join();
+            }
+
+            // deliver whatever is left.
+            drain();
+        }
+
+        ///
+        /// Queue the message. Return false if the message has to be delivered synchronously.
+        ///
+        template<typename CHAR>
+        bool push( LoggerImpl & logger, const Logger::LogDesc & desc, const CHAR * msg )
+        {
+            // FATAL message is delivered synchronously, with everything queued before it.
+            // Messages logged by receivers on the writer thread are delivered synchronously too.
+            if( desc.level <= Logger::FATAL || msIsWriterThread )
+            {
+                flush();
+                return false;
+            }
+
+            ++mActiveProducers;
+            if( !mRunning ) { --mActiveProducers; return false; }
+
+            // claim a slot
+            size_t pos = mTail.load( std::memory_order_relaxed );
+            Slot * slot;
+            for(;;)
+            {
+                slot = &mSlots[pos & (RING_SIZE-1)];
+                size_t seq = slot->seq.load( std::memory_order_acquire );
+                intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+                if( 0 == dif )
+                {
+                    if( mTail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) break;
+                }
+                else if( dif < 0 )
+                {
+                    // ring buffer is full: wake up the writer and wait for free slot.
+                    wakeup();
+                    std::this_thread::yield();
+                    pos = mTail.load( std::memory_order_relaxed );
+                }
+                else
+                {
+                    pos = mTail.load( std::memory_order_relaxed );
+                }
+            }
+
+            // fill the record
+            Record & r = slot->record;
+            r.logger = &logger;
+            r.desc = desc;
+            r.wide = sizeof(CHAR) > 1;
+            static const CHAR EMPTY[] = { 0 };
+            if( NULL == msg ) msg = EMPTY;
+            size_t bytes = ( str::length( msg ) + 1 ) * sizeof(CHAR);
+            if( bytes <= INLINE_TEXT_SIZE )
+            {
+                r.heapText = NULL;
+                memcpy( r.text, msg, bytes );
+            }
+            else
+            {
+                r.heapText = (char*)::malloc( bytes );
+                if( r.heapText ) memcpy( r.heapText, msg, bytes );
+                else memset( r.text, 0, sizeof(CHAR) );
+            }
+
+            // publish
+            slot->seq.store( pos + 1, std::memory_order_release );
+            --mActiveProducers;
+
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if( mSleeping.load( std::memory_order_relaxed ) ) wakeup();
+
+            return true;
+        }
+
+        ///
+        /// Block until all records queued before this call are delivered.
+        ///
+        void flush()
+        {
+            if( NULL == mSlots ) return;
+
+            if( !mRunning || msIsWriterThread )
+            {
+                drain();
+                return;
+            }
+
+            size_t target = mTail.load();
+            std::unique_lock<std::mutex> lock( mWakeMutex );
+            ++mFlushWaiters;
+            mWake.notify_one();
+            mDrained.wait( lock, [&]{ return mHead.load() >= target || !mRunning; } );
+            --mFlushWaiters;
+        }
+
+        ///
+        /// Write text of records that are not delivered yet to stderr, on crash. This runs
+        /// in signal handler, so it only reads published records and calls write().
+        /// Receivers are not called: they may format, allocate or take locks.
+        ///
+        void dumpOnCrash() const;
+
+    private:
+
+        void wakeup()
+        {
+            std::lock_guard<std::mutex> lock( mWakeMutex );
+            mWake.notify_one();
+        }
+
+        bool empty() const
+        {
+            size_t head = mHead.load( std::memory_order_relaxed );
+            return mSlots[head & (RING_SIZE-1)].seq.load( std::memory_order_acquire ) != head + 1;
+        }
+
+        /// Deliver all published records. Return number of delivered records.
+        size_t drain()
+        {
+            while( mConsumerLock.test_and_set( std::memory_order_acquire ) ) std::this_thread::yield();
+            size_t n = drainLocked();
+            mConsumerLock.clear( std::memory_order_release );
+            return n;
+        }
+
+        ///
+        /// Deliver all published records, caller must hold the consumer lock.
+        ///
+        size_t drainLocked();
+
+        void threadProc()
+        {
+            msIsWriterThread = true;
+            for(;;)
+            {
+                size_t n = drain();
+
+                if( mFlushWaiters > 0 )
+                {
+                    std::lock_guard<std::mutex> lock( mWakeMutex );
+                    mDrained.notify_all();
+                }
+
+                if( 0 == n )
+                {
+                    // Flush waiters don't wake us up by themselves: records they wait for are
+                    // not published yet, and the producers wake us up when they are.
+                    std::unique_lock<std::mutex> lock( mWakeMutex );
+                    mSleeping = true;
+                    std::atomic_thread_fence( std::memory_order_seq_cst );
+                    if( mQuit && empty() ) break;
+                    mWake.wait_for( lock, std::chrono::milliseconds(10), [this]{ return mQuit || !empty(); } );
+                    mSleeping = false;
+                }
+            }
+            mSleeping = false;
+
+            std::lock_guard<std::mutex> lock( mWakeMutex );
+            mDrained.notify_all();
+        }
+    };
+
+    GN_TLS bool AsyncLogWriter::msIsWriterThread = false;
+
     ///
     /// Logger implementation class
     ///
@@ -448,9 +737,10 @@ namespace GN
     {
     public:
 
-        LoggerImpl( const char * name, LocalMutex & mutex )
+        LoggerImpl( const char * name, LocalMutex & mutex, AsyncLogWriter & writer )
             : Logger( sDuplicateName(name) )
             , mGlobalMutex( mutex )
+            , mWriter( writer )
             , mInheritLevel(true)
             , mInheritEnabled(true) {}
 
@@ -470,6 +760,16 @@ namespace GN
             recursiveUpdateEnabled( isEnabled() );
         }
 
+        ///
+        /// Send message to receivers of this logger and all its ancestors.
+        ///
+        template<typename CHAR>
+        void deliver( const LogDesc & desc, const CHAR * msg )
+        {
+            std::lock_guard<LocalMutex> m(mGlobalMutex);
+            recursiveLog( *this, desc, msg );
+        }
+
     public:
 
         virtual void setLevel( int level )
@@ -488,14 +788,14 @@ namespace GN
 
         virtual void doLog( const LogDesc & desc, const char * msg )
         {
-            std::lock_guard<LocalMutex> m(mGlobalMutex);
-            recursiveLog( *this, desc, msg );
+            if( mWriter.running() && mWriter.push( *this, desc, msg ) ) return;
+            deliver( desc, msg );
         }
 
         virtual void doLog( const LogDesc & desc, const wchar_t * msg )
         {
-            std::lock_guard<LocalMutex> m(mGlobalMutex);
-            recursiveLog( *this, desc, msg );
+            if( mWriter.running() && mWriter.push( *this, desc, msg ) ) return;
+            deliver( desc, msg );
         }
 
         virtual void addReceiver( Receiver * r )
@@ -520,7 +820,8 @@ namespace GN
 
     private:
 
-        LocalMutex & mGlobalMutex;
+        LocalMutex     & mGlobalMutex;
+        AsyncLogWriter & mWriter;
 
         std::set<Receiver*> mReceivers;
         bool mInheritLevel;
@@ -588,6 +889,129 @@ namespace GN
         }
     };
 
+    //
+    //
+    // -------------------------------------------------------------------------
+    inline size_t AsyncLogWriter::drainLocked()
+    {
+        size_t n = 0;
+        for(;;)
+        {
+            size_t head = mHead.load( std::memory_order_relaxed );
+            Slot & slot = mSlots[head & (RING_SIZE-1)];
+            if( slot.seq.load( std::memory_order_acquire ) != head + 1 ) break;
+
+            Record & r = slot.record;
+            if( r.wide )
+                r.logger->deliver( r.desc, (const wchar_t*)r.message() );
+            else
+                r.logger->deliver( r.desc, (const char*)r.message() );
+            ::free( r.heapText );
+
+            // release the slot to producers
+            slot.seq.store( head + RING_SIZE, std::memory_order_release );
+            mHead.store( head + 1, std::memory_order_release );
+            ++n;
+        }
+        return n;
+    }
+
+    ///
+    /// Write string to stderr. Safe to call in signal handler.
+    ///
+    static void sWriteOnCrash( const char * s )
+    {
+        size_t n = strlen( s );
+#if GN_POSIX
+        while( n > 0 )
+        {
+            ssize_t written = ::write( STDERR_FILENO, s, n );
+            if( written <= 0 ) return;
+            s += written;
+            n -= (size_t)written;
+        }
+#elif GN_WINPC
+        DWORD written;
+        ::WriteFile( ::GetStdHandle( STD_ERROR_HANDLE ), s, (DWORD)n, &written, NULL );
+#else
+        GN_UNUSED_PARAM( n );
+#endif
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    inline void AsyncLogWriter::dumpOnCrash() const
+    {
+        if( NULL == mSlots ) return;
+
+        size_t tail = mTail.load( std::memory_order_acquire );
+        for( size_t pos = mHead.load( std::memory_order_acquire ); pos != tail; ++pos )
+        {
+            const Slot & slot = mSlots[pos & (RING_SIZE-1)];
+            if( slot.seq.load( std::memory_order_acquire ) != pos + 1 ) break; // not published yet
+
+            // wide text can't be written as is.
+            const Record & r = slot.record;
+            if( r.wide ) continue;
+
+            sWriteOnCrash( r.logger->getName() );
+            sWriteOnCrash( " : " );
+            sWriteOnCrash( (const char*)r.message() );
+            sWriteOnCrash( "\n" );
+        }
+    }
+
+    static void sFlushLogOnCrash();
+
+#if GN_POSIX
+    static const int CRASH_SIGNALS[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTRAP };
+    static struct sigaction sOldCrashActions[GN_ARRAY_COUNT(CRASH_SIGNALS)];
+
+    static void sCrashSignalHandler( int sig )
+    {
+        sFlushLogOnCrash();
+
+        // restore previous handler, then re-raise the signal.
+        for( size_t i = 0; i < GN_ARRAY_COUNT(CRASH_SIGNALS); ++i )
+        {
+            if( CRASH_SIGNALS[i] == sig ) sigaction( sig, &sOldCrashActions[i], NULL );
+        }
+        raise( sig );
+    }
+#elif GN_WINPC
+    static LPTOP_LEVEL_EXCEPTION_FILTER sOldExceptionFilter = NULL;
+
+    static LONG WINAPI sUnhandledExceptionFilter( EXCEPTION_POINTERS * ep )
+    {
+        sFlushLogOnCrash();
+        return sOldExceptionFilter ? sOldExceptionFilter( ep ) : EXCEPTION_CONTINUE_SEARCH;
+    }
+#endif
+
+    ///
+    /// Make sure queued log messages reach receivers, when the process crashes.
+    ///
+    static void sInstallCrashHandlers()
+    {
+        static bool sInstalled = false;
+        if( sInstalled ) return;
+        sInstalled = true;
+
+#if GN_POSIX
+        struct sigaction sa;
+        memset( &sa, 0, sizeof(sa) );
+        sa.sa_handler = sCrashSignalHandler;
+        sigemptyset( &sa.sa_mask );
+        for( size_t i = 0; i < GN_ARRAY_COUNT(CRASH_SIGNALS); ++i )
+        {
+            sigaction( CRASH_SIGNALS[i], &sa, &sOldCrashActions[i] );
+        }
+#elif GN_WINPC
+        sOldExceptionFilter = ::SetUnhandledExceptionFilter( sUnhandledExceptionFilter );
+#endif
+    }
+
     ///
     /// Log container
     ///
@@ -596,6 +1020,7 @@ namespace GN
         // Note: Logger map is case "insensitive"
         typedef GN::StringMap<char,LoggerImpl*,GN::str::INSENSITIVE> LoggerMap;
 
+        AsyncLogWriter  mWriter;
         ConsoleReceiver mCr;
         FileReceiver    mFr;
         DebugReceiver   mDr;
@@ -631,7 +1056,7 @@ namespace GN
 
     public:
 
-        LoggerContainer() : mRootLogger("ROOT",mMutex)
+        LoggerContainer() : mRootLogger("ROOT",mMutex,mWriter)
         {
             // config root logger
             mRootLogger.setLevel( Logger::INFO );
@@ -641,10 +1066,15 @@ namespace GN
 #endif
             mRootLogger.addReceiver( &mFr );
             mRootLogger.addReceiver( &mDr );
+
+            if( getEnvBoolean( "GN_LOG_ASYNC" ) ) setAsync( true );
         }
 
         ~LoggerContainer()
         {
+            // deliver pending messages while all loggers and receivers are still alive.
+            mWriter.stop();
+
             static Logger * sLogger = getLogger("GN.core.LoggerContainer");
             StrA loggerTree;
             GN_VERBOSE(sLogger)(
@@ -676,7 +1106,7 @@ namespace GN
             if( NULL != pplogger ) { GN_ASSERT( *pplogger ); return *pplogger; }
 
             // not found. create new one.
-            AutoObjPtr<LoggerImpl> newLogger( new LoggerImpl(n,mMutex) );
+            AutoObjPtr<LoggerImpl> newLogger( new LoggerImpl(n,mMutex,mWriter) );
             mLoggers[n] = newLogger;
 
             // update logger tree
@@ -688,8 +1118,24 @@ namespace GN
             // sucess
             return newLogger.detach();
         }
+
+        AsyncLogWriter & writer() { return mWriter; }
+
+        void setAsync( bool async )
+        {
+            if( async )
+            {
+                mWriter.start();
+                sInstallCrashHandlers();
+            }
+            else
+            {
+                mWriter.stop();
+            }
+        }
     };
 
+
     LoggerContainer * msInstancePtr = 0;
 
     //
@@ -710,4 +1156,38 @@ namespace GN
         LoggerContainer & lc = sGetLoggerContainer();
         return lc.getLogger( name );
     }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    GN_API void setLogAsync( bool async )
+    {
+        sGetLoggerContainer().setAsync( async );
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    GN_API bool isLogAsync()
+    {
+        return sGetLoggerContainer().writer().running();
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    GN_API void flushLog()
+    {
+        sGetLoggerContainer().writer().flush();
+        ::fflush( stdout );
+        ::fflush( stderr );
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    static void sFlushLogOnCrash()
+    {
+        sGetLoggerContainer().writer().dumpOnCrash();
+    }
 }
@@ -107,6 +107,7 @@ GN::internal::handleAssertFailure(
 
     if( debuggerBreak )
     {
+        GN::flushLog();
         GN::breakIntoDebugger();
     }
 }
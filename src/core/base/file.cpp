@@ -1,4 +1,9 @@
 #include "pch.h"
+#if GN_MSWIN
+#include <io.h>
+#elif GN_POSIX
+#include <sys/mman.h>
+#endif
 
 using namespace GN;
 
@@ -311,6 +316,9 @@ GN_API void GN::DiskFile::close() throw()
 {
     GN_GUARD_ALWAYS;
 
+    // release memory mapping
+    if( mMapping ) unmap();
+
     // close file
     if( getFILE() ) ::fclose( getFILE() );
 
@@ -322,6 +330,108 @@ GN_API void GN::DiskFile::close() throw()
     GN_UNGUARD_ALWAYS_NO_THROW;
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void * GN::DiskFile::map( size_t offset, size_t length, bool readonly )
+{
+    GN_GUARD;
+
+    if( 0 == getFILE() )
+    {
+        GN_ERROR(sLogger)( "NULL file pointer!" );
+        return 0;
+    }
+
+    if( mMapping )
+    {
+        GN_ERROR(sLogger)( "%s : file is mapped already!", name().rawptr() );
+        return 0;
+    }
+
+    if( 0 == length || offset > mSize || length > mSize - offset )
+    {
+        GN_ERROR(sLogger)( "%s : invalid mapping range!", name().rawptr() );
+        return 0;
+    }
+
+    // pending writes must reach the file, before it is mapped.
+    ::fflush( getFILE() );
+
+#if GN_MSWIN
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    size_t start = offset - offset % si.dwAllocationGranularity;
+
+    HANDLE fh = (HANDLE)_get_osfhandle( _fileno( getFILE() ) );
+    HANDLE mapping = CreateFileMappingA( fh, NULL, readonly ? PAGE_READONLY : PAGE_READWRITE, 0, 0, NULL );
+    if( NULL == mapping )
+    {
+        GN_ERROR(sLogger)( "%s : CreateFileMapping() failed: %s", name().rawptr(), getWin32LastErrorInfo() );
+        return 0;
+    }
+
+    DWORD access = readonly ? FILE_MAP_READ : FILE_MAP_WRITE;
+    void * view = MapViewOfFile( mapping, access, (DWORD)( (uint64)start >> 32 ), (DWORD)start, offset + length - start );
+    if( NULL == view )
+    {
+        GN_ERROR(sLogger)( "%s : MapViewOfFile() failed: %s", name().rawptr(), getWin32LastErrorInfo() );
+        CloseHandle( mapping );
+        return 0;
+    }
+    mMappingFile = mapping;
+#elif GN_POSIX
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+    size_t start = offset - offset % page;
+
+    int prot = readonly ? PROT_READ : ( PROT_READ | PROT_WRITE );
+    void * view = mmap( 0, offset + length - start, prot, readonly ? MAP_PRIVATE : MAP_SHARED, fileno( getFILE() ), (off_t)start );
+    if( MAP_FAILED == view )
+    {
+        GN_ERROR(sLogger)( "%s : mmap() failed: %s", name().rawptr(), errno2str( errno ) );
+        return 0;
+    }
+#else
+    GN_UNUSED_PARAM( readonly );
+    GN_ERROR(sLogger)( "%s : memory mapping is not supported on this platform!", name().rawptr() );
+    return 0;
+#endif
+
+    // success
+    mMapping = view;
+    mMappingSize = offset + length - start;
+    return (uint8*)view + ( offset - start );
+
+    GN_UNGUARD;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::DiskFile::unmap()
+{
+    GN_GUARD;
+
+    if( 0 == mMapping )
+    {
+        GN_ERROR(sLogger)( "%s : file is not mapped!", name().rawptr() );
+        return;
+    }
+
+#if GN_MSWIN
+    UnmapViewOfFile( mMapping );
+    CloseHandle( (HANDLE)mMappingFile );
+#elif GN_POSIX
+    munmap( mMapping, mMappingSize );
+#endif
+
+    mMapping = 0;
+    mMappingSize = 0;
+    mMappingFile = 0;
+
+    GN_UNGUARD;
+}
+
 // *****************************************************************************
 //                   implementation of TempFile
 // *****************************************************************************
@@ -0,0 +1,389 @@
+#include "pch.h"
+
+using namespace GN;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+//
+// Update plane cache of a rejected volume.
+// -----------------------------------------------------------------------------
+static inline void sCachePlane( uint8 * planeCache, size_t i, int plane )
+{
+    if( planeCache ) planeCache[i] = (uint8)plane;
+}
+
+//
+// Scalar test of one box (center and half extent) or sphere (center and radius in ex).
+// Return index of the rejecting plane, or -1 if the volume is visible.
+// -----------------------------------------------------------------------------
+template<bool SPHERE>
+static inline int sTestScalar(
+    const Frustum & f,
+    float cx, float cy, float cz,
+    float ex, float ey, float ez,
+    int firstPlane )
+{
+    for( int k = 0; k < Frustum::NUM_PLANES; ++k )
+    {
+        // start with the cached plane, then the rest in order.
+        int i = 0 == k ? firstPlane : ( k <= firstPlane ? k - 1 : k );
+        const Plane3f & p = f.planes[i];
+        float dist = p.n.x * cx + p.n.y * cy + p.n.z * cz + p.d;
+        float r = SPHERE ? ex : fabs( p.n.x * ex ) + fabs( p.n.y * ey ) + fabs( p.n.z * ez );
+        if( dist + r < 0 ) return i;
+    }
+    return -1;
+}
+
+//
+// Scalar cull of one volume. Visible index is always written, and counted only
+// when the volume is visible, so the caller needs no branch.
+// -----------------------------------------------------------------------------
+template<bool SPHERE>
+static inline size_t sCullOne(
+    uint32 * visible, size_t base, size_t i,
+    const Frustum & f,
+    float cx, float cy, float cz,
+    float ex, float ey, float ez,
+    uint8 * planeCache )
+{
+    int first = planeCache ? planeCache[i] : 0;
+    GN_ASSERT( first < Frustum::NUM_PLANES );
+    int rejected = sTestScalar<SPHERE>( f, cx, cy, cz, ex, ey, ez, first );
+    *visible = (uint32)( base + i );
+    if( rejected < 0 ) return 1;
+    sCachePlane( planeCache, i, rejected );
+    return 0;
+}
+
+#if GN_SIMD
+
+using namespace GN::simd;
+
+//
+// Frustum planes, splatted for 4-wide tests.
+// -----------------------------------------------------------------------------
+struct SimdFrustum
+{
+    GN_CASSERT( sizeof(Plane3f) == 4 * sizeof(float) );
+
+    Float4 nx[Frustum::NUM_PLANES];
+    Float4 ny[Frustum::NUM_PLANES];
+    Float4 nz[Frustum::NUM_PLANES];
+    Float4 ax[Frustum::NUM_PLANES]; // |nx|
+    Float4 ay[Frustum::NUM_PLANES]; // |ny|
+    Float4 az[Frustum::NUM_PLANES]; // |nz|
+    Float4 d[Frustum::NUM_PLANES];
+
+    explicit SimdFrustum( const Frustum & f )
+    {
+        for( int i = 0; i < Frustum::NUM_PLANES; ++i )
+        {
+            const Plane3f & p = f.planes[i];
+            nx[i] = splat( p.n.x );
+            ny[i] = splat( p.n.y );
+            nz[i] = splat( p.n.z );
+            ax[i] = splat( fabs( p.n.x ) );
+            ay[i] = splat( fabs( p.n.y ) );
+            az[i] = splat( fabs( p.n.z ) );
+            d[i]  = splat( p.d );
+        }
+    }
+};
+
+//
+// Signed distance of 4 volumes to one plane per lane. Negative means the volume
+// is completely outside of the plane.
+// -----------------------------------------------------------------------------
+template<bool SPHERE>
+static GN_FORCE_INLINE Float4 sDistance4(
+    Float4 nx, Float4 ny, Float4 nz, Float4 d,
+    Float4 ax, Float4 ay, Float4 az,
+    Float4 cx, Float4 cy, Float4 cz,
+    Float4 ex, Float4 ey, Float4 ez )
+{
+    Float4 dist = madd( nx, cx, madd( ny, cy, madd( nz, cz, d ) ) );
+    Float4 r = SPHERE ? ex : madd( ax, ex, madd( ay, ey, mul( az, ez ) ) );
+    return add( dist, r );
+}
+
+//
+// Cull 4 volumes in SoA registers: boxes as center and half extent, spheres as
+// center and radius in ex. Return number of visible volumes.
+//
+// All 6 planes are tested without branches, since groups of 4 volumes with mixed
+// results are common and early outs would mostly be mispredicted.
+// -----------------------------------------------------------------------------
+template<bool SPHERE>
+static GN_FORCE_INLINE size_t sCull4(
+    uint32 * visible, size_t base, size_t i,
+    const Frustum & f, const SimdFrustum & sf,
+    Float4 cx, Float4 cy, Float4 cz,
+    Float4 ex, Float4 ey, Float4 ez,
+    uint8 * planeCache )
+{
+    int out;
+
+    if( planeCache )
+    {
+        // test each lane against the plane that rejected it last time. Invisible
+        // groups usually end here.
+        Float4 nx = load( &f.planes[planeCache[i+0]].n.x );
+        Float4 ny = load( &f.planes[planeCache[i+1]].n.x );
+        Float4 nz = load( &f.planes[planeCache[i+2]].n.x );
+        Float4 d  = load( &f.planes[planeCache[i+3]].n.x );
+        simd::transpose( nx, ny, nz, d );
+        Float4 dist = sDistance4<SPHERE>( nx, ny, nz, d, abs( nx ), abs( ny ), abs( nz ), cx, cy, cz, ex, ey, ez );
+        out = movemask( cmplt( dist, zero() ) );
+
+        if( 0xF != out )
+        {
+            // find the most rejecting plane of each lane.
+            Float4 minDist = sDistance4<SPHERE>( sf.nx[0], sf.ny[0], sf.nz[0], sf.d[0], sf.ax[0], sf.ay[0], sf.az[0], cx, cy, cz, ex, ey, ez );
+            Float4 minPlane = zero();
+            for( int p = 1; p < Frustum::NUM_PLANES; ++p )
+            {
+                dist = sDistance4<SPHERE>( sf.nx[p], sf.ny[p], sf.nz[p], sf.d[p], sf.ax[p], sf.ay[p], sf.az[p], cx, cy, cz, ex, ey, ez );
+                Float4 closer = cmplt( dist, minDist );
+                minDist  = minimum( dist, minDist );
+                minPlane = select( closer, splat( (float)p ), minPlane );
+            }
+
+            int rejected = movemask( cmplt( minDist, zero() ) ) & ~out;
+            if( rejected )
+            {
+                float planes[4];
+                store( planes, minPlane );
+                for( int k = 0; k < 4; ++k )
+                {
+                    if( rejected & (1<<k) ) planeCache[i+k] = (uint8)planes[k];
+                }
+            }
+            out |= rejected;
+        }
+    }
+    else
+    {
+        Float4 minDist = sDistance4<SPHERE>( sf.nx[0], sf.ny[0], sf.nz[0], sf.d[0], sf.ax[0], sf.ay[0], sf.az[0], cx, cy, cz, ex, ey, ez );
+        for( int p = 1; p < Frustum::NUM_PLANES; ++p )
+        {
+            minDist = minimum( minDist, sDistance4<SPHERE>( sf.nx[p], sf.ny[p], sf.nz[p], sf.d[p], sf.ax[p], sf.ay[p], sf.az[p], cx, cy, cz, ex, ey, ez ) );
+        }
+        out = movemask( cmplt( minDist, zero() ) );
+    }
+
+    // compact visible indices, without branches.
+    size_t n = 0;
+    for( int k = 0; k < 4; ++k )
+    {
+        visible[n] = (uint32)( base + i + k );
+        n += ( ~out >> k ) & 1;
+    }
+    return n;
+}
+
+//
+// Load 2 packed boxes (12 floats) as x, y, z of [pos0, size0, pos1, size1]
+// -----------------------------------------------------------------------------
+static GN_FORCE_INLINE void sLoadPacked2Boxes( const float * p, Float4 & x, Float4 & y, Float4 & z )
+{
+    Float4 a = load( p );     // x0 y0 z0 w0
+    Float4 b = load( p + 4 ); // h0 d0 x1 y1
+    Float4 c = load( p + 8 ); // z1 w1 h1 d1
+    x = shuffle<0,3,0,2>( a, shuffle<2,2,1,1>( b, c ) );
+    y = shuffle<0,2,0,2>( shuffle<1,1,0,0>( a, b ), shuffle<3,3,2,2>( b, c ) );
+    z = shuffle<0,2,0,3>( shuffle<2,2,1,1>( a, b ), c );
+}
+
+#endif // GN_SIMD
+
+//
+// Cull packed boxes. Indices written to visible are offset by base.
+// -----------------------------------------------------------------------------
+static size_t sCullBoxes( uint32 * visible, size_t base, const Frustum & f, const Boxf * boxes, size_t count, uint8 * planeCache )
+{
+    size_t n = 0;
+    size_t i = 0;
+
+#if GN_SIMD
+    SimdFrustum sf( f );
+    Float4 half = splat( 0.5f );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Float4 x01, y01, z01, x23, y23, z23;
+        sLoadPacked2Boxes( &boxes[i].x, x01, y01, z01 );
+        sLoadPacked2Boxes( &boxes[i+2].x, x23, y23, z23 );
+
+        // SoA position and size
+        Float4 px = shuffle<0,2,0,2>( x01, x23 );
+        Float4 py = shuffle<0,2,0,2>( y01, y23 );
+        Float4 pz = shuffle<0,2,0,2>( z01, z23 );
+        Float4 ex = mul( shuffle<1,3,1,3>( x01, x23 ), half );
+        Float4 ey = mul( shuffle<1,3,1,3>( y01, y23 ), half );
+        Float4 ez = mul( shuffle<1,3,1,3>( z01, z23 ), half );
+
+        n += sCull4<false>(
+            visible + n, base, i, f, sf,
+            add( px, ex ), add( py, ey ), add( pz, ez ),
+            abs( ex ), abs( ey ), abs( ez ),
+            planeCache );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const Boxf & b = boxes[i];
+        float ex = b.w * 0.5f, ey = b.h * 0.5f, ez = b.d * 0.5f;
+        n += sCullOne<false>( visible + n, base, i, f, b.x + ex, b.y + ey, b.z + ez, fabs( ex ), fabs( ey ), fabs( ez ), planeCache );
+    }
+
+    return n;
+}
+
+//
+// Cull boxes in SoA arrays.
+// -----------------------------------------------------------------------------
+static size_t sCullBoxesSoA(
+    uint32 * visible, size_t base, const Frustum & f,
+    const float * cx, const float * cy, const float * cz,
+    const float * ex, const float * ey, const float * ez,
+    size_t count, uint8 * planeCache )
+{
+    size_t n = 0;
+    size_t i = 0;
+
+#if GN_SIMD
+    SimdFrustum sf( f );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        n += sCull4<false>(
+            visible + n, base, i, f, sf,
+            load( cx + i ), load( cy + i ), load( cz + i ),
+            load( ex + i ), load( ey + i ), load( ez + i ),
+            planeCache );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        n += sCullOne<false>( visible + n, base, i, f, cx[i], cy[i], cz[i], ex[i], ey[i], ez[i], planeCache );
+    }
+
+    return n;
+}
+
+//
+// Cull packed spheres.
+// -----------------------------------------------------------------------------
+static size_t sCullSpheres( uint32 * visible, size_t base, const Frustum & f, const Spheref * spheres, size_t count, uint8 * planeCache )
+{
+    size_t n = 0;
+    size_t i = 0;
+
+#if GN_SIMD
+    SimdFrustum sf( f );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Float4 x = load( &spheres[i+0].center.x );
+        Float4 y = load( &spheres[i+1].center.x );
+        Float4 z = load( &spheres[i+2].center.x );
+        Float4 r = load( &spheres[i+3].center.x );
+        simd::transpose( x, y, z, r );
+        n += sCull4<true>( visible + n, base, i, f, sf, x, y, z, r, r, r, planeCache );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const Spheref & s = spheres[i];
+        n += sCullOne<true>( visible + n, base, i, f, s.center.x, s.center.y, s.center.z, s.radius, 0, 0, planeCache );
+    }
+
+    return n;
+}
+
+//
+// Split [0, count) into chunks, cull them in parallel, each into its own range of
+// the visible array, then compact the results.
+// -----------------------------------------------------------------------------
+template<typename CULL_RANGE>
+static size_t sCullParallel( JobSystem & js, uint32 * visible, size_t count, const CULL_RANGE & cullRange )
+{
+    const size_t CHUNK = 16 * 1024;
+
+    size_t numChunks = ( count + CHUNK - 1 ) / CHUNK;
+    if( numChunks <= 1 || 0 == js.getWorkerCount() ) return cullRange( visible, 0, count );
+
+    DynaArray<size_t> counts( numChunks );
+    js.parallelFor( 0, numChunks, [&]( size_t begin, size_t end ) {
+        for( size_t c = begin; c < end; ++c )
+        {
+            size_t first = c * CHUNK;
+            counts[c] = cullRange( visible + first, first, math::getmin( CHUNK, count - first ) );
+        }
+    }, 1, "frustum culling" );
+
+    size_t n = counts[0];
+    for( size_t c = 1; c < numChunks; ++c )
+    {
+        memmove( visible + n, visible + c * CHUNK, counts[c] * sizeof(uint32) );
+        n += counts[c];
+    }
+    return n;
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::cullBoxes( uint32 * visible, const Frustum & frustum, const Boxf * boxes, size_t count, uint8 * planeCache )
+{
+    return sCullBoxes( visible, 0, frustum, boxes, count, planeCache );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::cullBoxes(
+    uint32        * visible,
+    const Frustum & frustum,
+    const float   * centerX, const float * centerY, const float * centerZ,
+    const float   * extentX, const float * extentY, const float * extentZ,
+    size_t          count,
+    uint8         * planeCache )
+{
+    return sCullBoxesSoA( visible, 0, frustum, centerX, centerY, centerZ, extentX, extentY, extentZ, count, planeCache );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::cullSpheres( uint32 * visible, const Frustum & frustum, const Spheref * spheres, size_t count, uint8 * planeCache )
+{
+    return sCullSpheres( visible, 0, frustum, spheres, count, planeCache );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::cullBoxes( JobSystem & js, uint32 * visible, const Frustum & frustum, const Boxf * boxes, size_t count, uint8 * planeCache )
+{
+    return sCullParallel( js, visible, count, [&]( uint32 * v, size_t first, size_t n ) {
+        return sCullBoxes( v, first, frustum, boxes + first, n, planeCache ? planeCache + first : NULL );
+    } );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::cullSpheres( JobSystem & js, uint32 * visible, const Frustum & frustum, const Spheref * spheres, size_t count, uint8 * planeCache )
+{
+    return sCullParallel( js, visible, count, [&]( uint32 * v, size_t first, size_t n ) {
+        return sCullSpheres( v, first, frustum, spheres + first, n, planeCache ? planeCache + first : NULL );
+    } );
+}
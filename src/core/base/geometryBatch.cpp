@@ -0,0 +1,517 @@
+#include "pch.h"
+
+using namespace GN;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+template<typename T>
+static inline T * sAdvance( T * p, size_t stride )
+{
+    return (T*)( (uint8*)p + stride );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+template<typename T>
+static inline const T * sAdvance( const T * p, size_t stride )
+{
+    return (const T*)( (const uint8*)p + stride );
+}
+
+//
+// Affine matrix has no projection, so transformed points never need division by w.
+// -----------------------------------------------------------------------------
+static inline bool sIsAffine( const Matrix44f & m )
+{
+    return 0.0f == m[3][0] && 0.0f == m[3][1] && 0.0f == m[3][2] && 1.0f == m[3][3];
+}
+
+//
+// Scalar version of the point/vector transformation, used for the remainders
+// of SIMD loops. Unlike Matrix44::transformPoint(), it does not complain about w == 0.
+// -----------------------------------------------------------------------------
+template<bool POINT, bool PROJECTIVE>
+static inline void sTransformScalar( float & ox, float & oy, float & oz, const Matrix44f & m, float x, float y, float z )
+{
+    float rx = m[0][0] * x + m[0][1] * y + m[0][2] * z;
+    float ry = m[1][0] * x + m[1][1] * y + m[1][2] * z;
+    float rz = m[2][0] * x + m[2][1] * y + m[2][2] * z;
+    if( POINT )
+    {
+        rx += m[0][3];
+        ry += m[1][3];
+        rz += m[2][3];
+    }
+    if( PROJECTIVE )
+    {
+        float w = m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3];
+        if( 0.0f != w )
+        {
+            float k = 1.0f / w;
+            rx *= k;
+            ry *= k;
+            rz *= k;
+        }
+    }
+    ox = rx;
+    oy = ry;
+    oz = rz;
+}
+
+#if GN_SIMD
+
+using namespace GN::simd;
+
+///
+/// Matrix with every element broadcasted to all lanes, for SoA kernels.
+///
+struct SplatMatrix
+{
+    Float4 e[4][4];
+
+    explicit SplatMatrix( const Matrix44f & m )
+    {
+        for( int r = 0; r < 4; ++r )
+        {
+            for( int c = 0; c < 4; ++c )
+            {
+                e[r][c] = splat( m[r][c] );
+            }
+        }
+    }
+};
+
+///
+/// Matrix stored in columns, for AoS kernels (see simd::transformByColumns()).
+///
+struct ColumnMatrix
+{
+    Float4 c0, c1, c2, c3;
+
+    explicit ColumnMatrix( const Matrix44f & m )
+    {
+        c0 = load( m[0].data() );
+        c1 = load( m[1].data() );
+        c2 = load( m[2].data() );
+        c3 = load( m[3].data() );
+        simd::transpose( c0, c1, c2, c3 );
+    }
+};
+
+//
+// Transform 4 points/vectors in SoA layout.
+// -----------------------------------------------------------------------------
+template<bool POINT, bool PROJECTIVE>
+static GN_FORCE_INLINE void sTransformSoA( Float4 & x, Float4 & y, Float4 & z, const SplatMatrix & m )
+{
+    Float4 ox = madd( m.e[0][2], z, madd( m.e[0][1], y, mul( m.e[0][0], x ) ) );
+    Float4 oy = madd( m.e[1][2], z, madd( m.e[1][1], y, mul( m.e[1][0], x ) ) );
+    Float4 oz = madd( m.e[2][2], z, madd( m.e[2][1], y, mul( m.e[2][0], x ) ) );
+    if( POINT )
+    {
+        ox = add( ox, m.e[0][3] );
+        oy = add( oy, m.e[1][3] );
+        oz = add( oz, m.e[2][3] );
+    }
+    if( PROJECTIVE )
+    {
+        Float4 w = madd( m.e[3][2], z, madd( m.e[3][1], y, madd( m.e[3][0], x, m.e[3][3] ) ) );
+        Float4 one = splat( 1.0f );
+        Float4 k = div( one, select( cmpeq( w, zero() ), one, w ) );
+        ox = mul( ox, k );
+        oy = mul( oy, k );
+        oz = mul( oz, k );
+    }
+    x = ox;
+    y = oy;
+    z = oz;
+}
+
+//
+// Load 4 packed Vector3f (12 floats) into SoA registers.
+// -----------------------------------------------------------------------------
+static GN_FORCE_INLINE void sLoadPacked4( const float * p, Float4 & x, Float4 & y, Float4 & z )
+{
+    Float4 a = load( p );     // x0 y0 z0 x1
+    Float4 b = load( p + 4 ); // y1 z1 x2 y2
+    Float4 c = load( p + 8 ); // z2 x3 y3 z3
+    x = shuffle<0,3,0,2>( a, shuffle<2,2,1,1>( b, c ) );
+    y = shuffle<0,2,0,2>( shuffle<1,1,0,0>( a, b ), shuffle<3,3,2,2>( b, c ) );
+    z = shuffle<0,2,0,3>( shuffle<2,2,1,1>( a, b ), c );
+}
+
+//
+// Store SoA registers as 4 packed Vector3f.
+// -----------------------------------------------------------------------------
+static GN_FORCE_INLINE void sStorePacked4( float * p, Float4 x, Float4 y, Float4 z )
+{
+    store( p,     shuffle<0,2,0,2>( shuffle<0,0,0,0>( x, y ), shuffle<0,0,1,1>( z, x ) ) );
+    store( p + 4, shuffle<0,2,0,2>( shuffle<1,1,1,1>( y, z ), shuffle<2,2,2,2>( x, y ) ) );
+    store( p + 8, shuffle<0,2,0,2>( shuffle<2,2,3,3>( z, x ), shuffle<3,3,3,3>( y, z ) ) );
+}
+
+//
+// Transform one point/vector with a column matrix.
+// -----------------------------------------------------------------------------
+template<bool POINT, bool PROJECTIVE>
+static GN_FORCE_INLINE void sTransformOne( Vector3f & dst, const ColumnMatrix & m, const Vector3f & src )
+{
+    Float4 r = madd( m.c2, splat( src.z ), madd( m.c1, splat( src.y ), mul( m.c0, splat( src.x ) ) ) );
+    if( POINT ) r = add( r, m.c3 );
+    if( PROJECTIVE )
+    {
+        Float4 w = lane<3>( r );
+        r = div( r, select( cmpeq( w, zero() ), splat( 1.0f ), w ) );
+    }
+    float tmp[4];
+    store( tmp, r );
+    dst.set( tmp[0], tmp[1], tmp[2] );
+}
+
+#endif // GN_SIMD
+
+//
+//
+// -----------------------------------------------------------------------------
+template<bool POINT, bool PROJECTIVE>
+static void sTransformAoS( Vector3f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count )
+{
+    size_t i = 0;
+
+#if GN_SIMD
+    if( sizeof(Vector3f) == dstStride && sizeof(Vector3f) == srcStride )
+    {
+        SplatMatrix sm( m );
+        for( ; i + 4 <= count; i += 4 )
+        {
+            Float4 x, y, z;
+            sLoadPacked4( &src[i].x, x, y, z );
+            sTransformSoA<POINT, PROJECTIVE>( x, y, z, sm );
+            sStorePacked4( &dst[i].x, x, y, z );
+        }
+        dst += i;
+        src += i;
+    }
+    else
+    {
+        ColumnMatrix cm( m );
+        for( ; i < count; ++i )
+        {
+            sTransformOne<POINT, PROJECTIVE>( *dst, cm, *src );
+            dst = sAdvance( dst, dstStride );
+            src = sAdvance( src, srcStride );
+        }
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        sTransformScalar<POINT, PROJECTIVE>( dst->x, dst->y, dst->z, m, src->x, src->y, src->z );
+        dst = sAdvance( dst, dstStride );
+        src = sAdvance( src, srcStride );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+template<bool POINT>
+static void sTransformSoAArrays(
+    float * dstX, float * dstY, float * dstZ,
+    const Matrix44f & m,
+    const float * srcX, const float * srcY, const float * srcZ,
+    size_t count )
+{
+    bool projective = POINT && !sIsAffine( m );
+
+    size_t i = 0;
+
+#if GN_SIMD
+    SplatMatrix sm( m );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Float4 x = load( srcX + i );
+        Float4 y = load( srcY + i );
+        Float4 z = load( srcZ + i );
+        if( projective )
+            sTransformSoA<POINT, true>( x, y, z, sm );
+        else
+            sTransformSoA<POINT, false>( x, y, z, sm );
+        store( dstX + i, x );
+        store( dstY + i, y );
+        store( dstZ + i, z );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        if( projective )
+            sTransformScalar<POINT, true>( dstX[i], dstY[i], dstZ[i], m, srcX[i], srcY[i], srcZ[i] );
+        else
+            sTransformScalar<POINT, false>( dstX[i], dstY[i], dstZ[i], m, srcX[i], srcY[i], srcZ[i] );
+    }
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformPoints( Vector3f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count )
+{
+    if( sIsAffine( m ) )
+        sTransformAoS<true, false>( dst, dstStride, m, src, srcStride, count );
+    else
+        sTransformAoS<true, true>( dst, dstStride, m, src, srcStride, count );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformPoints( Vector4f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count )
+{
+    size_t i = 0;
+
+#if GN_SIMD
+    if( sizeof(Vector3f) == srcStride )
+    {
+        // 4 points at a time in SoA, then transpose back to 4 rows of (x, y, z, w).
+        SplatMatrix sm( m );
+        for( ; i + 4 <= count; i += 4 )
+        {
+            Float4 x, y, z;
+            sLoadPacked4( &src->x, x, y, z );
+            Float4 w = madd( sm.e[3][2], z, madd( sm.e[3][1], y, madd( sm.e[3][0], x, sm.e[3][3] ) ) );
+            sTransformSoA<true, false>( x, y, z, sm );
+            simd::transpose( x, y, z, w );
+            store( dst->data(), x ); dst = sAdvance( dst, dstStride );
+            store( dst->data(), y ); dst = sAdvance( dst, dstStride );
+            store( dst->data(), z ); dst = sAdvance( dst, dstStride );
+            store( dst->data(), w ); dst = sAdvance( dst, dstStride );
+            src += 4;
+        }
+    }
+    else
+    {
+        ColumnMatrix cm( m );
+        for( ; i < count; ++i )
+        {
+            store( dst->data(), madd( cm.c2, splat( src->z ), madd( cm.c1, splat( src->y ), madd( cm.c0, splat( src->x ), cm.c3 ) ) ) );
+            dst = sAdvance( dst, dstStride );
+            src = sAdvance( src, srcStride );
+        }
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        m.transform( *dst, Vector4f( *src, 1.0f ) );
+        dst = sAdvance( dst, dstStride );
+        src = sAdvance( src, srcStride );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformVectors( Vector3f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count )
+{
+    sTransformAoS<false, false>( dst, dstStride, m, src, srcStride, count );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformVector4s( Vector4f * dst, const Matrix44f & m, const Vector4f * src, size_t count )
+{
+#if GN_SIMD
+    ColumnMatrix cm( m );
+    for( size_t i = 0; i < count; ++i )
+    {
+        store( dst[i].data(), transformByColumns( cm.c0, cm.c1, cm.c2, cm.c3, load( src[i].data() ) ) );
+    }
+#else
+    for( size_t i = 0; i < count; ++i )
+    {
+        m.transform( dst[i], Vector4f( src[i] ) );
+    }
+#endif
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformPointsSoA(
+    float * dstX, float * dstY, float * dstZ,
+    const Matrix44f & m,
+    const float * srcX, const float * srcY, const float * srcZ,
+    size_t count )
+{
+    sTransformSoAArrays<true>( dstX, dstY, dstZ, m, srcX, srcY, srcZ, count );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::transformVectorsSoA(
+    float * dstX, float * dstY, float * dstZ,
+    const Matrix44f & m,
+    const float * srcX, const float * srcY, const float * srcZ,
+    size_t count )
+{
+    sTransformSoAArrays<false>( dstX, dstY, dstZ, m, srcX, srcY, srcZ, count );
+}
+
+//
+// Affine matrix: transform the center, and project the half extents onto each
+// axis with the absolute values of the matrix (Arvo's method). Otherwise, bound
+// the 8 transformed corners.
+// -----------------------------------------------------------------------------
+GN_API void GN::transformBoxes( Boxf * dst, const Matrix44f & m, const Boxf * src, size_t count )
+{
+    if( !sIsAffine( m ) )
+    {
+        for( size_t i = 0; i < count; ++i )
+        {
+            Vector3f corners[8];
+            for( int c = 0; c < 8; ++c ) corners[c] = src[i].corner( c );
+            transformPoints( corners, m, corners, 8 );
+            calculateBoundingBox( dst[i], corners, sizeof(Vector3f), 8 );
+        }
+        return;
+    }
+
+#if GN_SIMD
+    ColumnMatrix cm( m );
+    Float4 a0 = simd::abs( cm.c0 );
+    Float4 a1 = simd::abs( cm.c1 );
+    Float4 a2 = simd::abs( cm.c2 );
+    Float4 half = splat( 0.5f );
+    for( size_t i = 0; i < count; ++i )
+    {
+        const Boxf & b = src[i];
+        Float4 h = mul( simd::set( b.w, b.h, b.d, 0.0f ), half );
+        Float4 c = add( simd::set( b.x, b.y, b.z, 0.0f ), h );
+        h = simd::abs( h );
+
+        Float4 nc = madd( cm.c2, lane<2>( c ), madd( cm.c1, lane<1>( c ), madd( cm.c0, lane<0>( c ), cm.c3 ) ) );
+        Float4 nh = madd( a2, lane<2>( h ), madd( a1, lane<1>( h ), mul( a0, lane<0>( h ) ) ) );
+
+        float p[4], s[4];
+        store( p, sub( nc, nh ) );
+        store( s, add( nh, nh ) );
+        dst[i].set( p[0], p[1], p[2], s[0], s[1], s[2] );
+    }
+#else
+    for( size_t i = 0; i < count; ++i )
+    {
+        const Boxf & b = src[i];
+        Vector3f h( b.w * 0.5f, b.h * 0.5f, b.d * 0.5f );
+        Vector3f c( b.x + h.x, b.y + h.y, b.z + h.z );
+        h.set( fabs( h.x ), fabs( h.y ), fabs( h.z ) );
+
+        Vector3f nc, nh;
+        m.transformPoint( nc, c );
+        nh.x = fabs( m[0][0] ) * h.x + fabs( m[0][1] ) * h.y + fabs( m[0][2] ) * h.z;
+        nh.y = fabs( m[1][0] ) * h.x + fabs( m[1][1] ) * h.y + fabs( m[1][2] ) * h.z;
+        nh.z = fabs( m[2][0] ) * h.x + fabs( m[2][1] ) * h.y + fabs( m[2][2] ) * h.z;
+        dst[i].set( nc.x - nh.x, nc.y - nh.y, nc.z - nh.z, nh.x * 2.0f, nh.y * 2.0f, nh.z * 2.0f );
+    }
+#endif
+}
+
+#if GN_SIMD
+
+//
+// dst = a * [b0, b1, b2, b3]. dst could be a.
+// -----------------------------------------------------------------------------
+static GN_FORCE_INLINE void sMultiply( Matrix44f & dst, const Matrix44f & a, Float4 b0, Float4 b1, Float4 b2, Float4 b3 )
+{
+    Float4 r[4];
+    for( int i = 0; i < 4; ++i )
+    {
+        Float4 ai = load( a[i].data() );
+        Float4 t = mul( lane<0>( ai ), b0 );
+        t = madd( lane<1>( ai ), b1, t );
+        t = madd( lane<2>( ai ), b2, t );
+        r[i] = madd( lane<3>( ai ), b3, t );
+    }
+    for( int i = 0; i < 4; ++i ) store( dst[i].data(), r[i] );
+}
+
+#endif
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::multiplyMatrices( Matrix44f * dst, const Matrix44f * a, const Matrix44f * b, size_t count )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+#if GN_SIMD
+        sMultiply( dst[i], a[i], load( b[i][0].data() ), load( b[i][1].data() ), load( b[i][2].data() ), load( b[i][3].data() ) );
+#else
+        dst[i] = a[i] * b[i];
+#endif
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::multiplyMatrices( Matrix44f * dst, const Matrix44f & a, const Matrix44f * b, size_t count )
+{
+#if GN_SIMD
+    // elements of a stay in registers, only rows of b[i] are loaded.
+    SplatMatrix sa( a );
+    for( size_t i = 0; i < count; ++i )
+    {
+        Float4 b0 = load( b[i][0].data() );
+        Float4 b1 = load( b[i][1].data() );
+        Float4 b2 = load( b[i][2].data() );
+        Float4 b3 = load( b[i][3].data() );
+        for( int r = 0; r < 4; ++r )
+        {
+            Float4 t = mul( sa.e[r][0], b0 );
+            t = madd( sa.e[r][1], b1, t );
+            t = madd( sa.e[r][2], b2, t );
+            store( dst[i][r].data(), madd( sa.e[r][3], b3, t ) );
+        }
+    }
+#else
+    for( size_t i = 0; i < count; ++i )
+    {
+        dst[i] = a * b[i];
+    }
+#endif
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::multiplyMatrices( Matrix44f * dst, const Matrix44f * a, const Matrix44f & b, size_t count )
+{
+#if GN_SIMD
+    Float4 b0 = load( b[0].data() );
+    Float4 b1 = load( b[1].data() );
+    Float4 b2 = load( b[2].data() );
+    Float4 b3 = load( b[3].data() );
+    for( size_t i = 0; i < count; ++i )
+    {
+        sMultiply( dst[i], a[i], b0, b1, b2, b3 );
+    }
+#else
+    for( size_t i = 0; i < count; ++i )
+    {
+        dst[i] = a[i] * b;
+    }
+#endif
+}
@@ -0,0 +1,673 @@
+#include "pch.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+using namespace GN;
+
+static GN::Logger * sLogger = GN::getLogger("GN.base.JobSystem");
+
+// number of failed attempts to find a job before a worker goes to sleep.
+static const size_t IDLE_SPIN_COUNT = 256;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+//
+// Get profiler timer of a job name. Timers are cached per thread, by address of the name,
+// so creating a job doesn't allocate or take the profiler mutex, except for the first time.
+// -----------------------------------------------------------------------------
+static ProfileTimer * sGetJobTimer( const char * name )
+{
+    struct Entry
+    {
+        const char *   name;
+        ProfileTimer * timer;
+    };
+    static thread_local Entry cache[64];
+
+    uintptr_t h = (uintptr_t)name;
+    Entry & e = cache[( h ^ ( h >> 6 ) ) & 63];
+    if( e.name != name )
+    {
+        e.timer = &ProfilerManager::sGetGlobalInstance().getTimer( name );
+        e.name  = name;
+    }
+    return e.timer;
+}
+
+// *****************************************************************************
+// local classes
+// *****************************************************************************
+
+///
+/// Job implementation
+///
+class JobImpl : public Job
+{
+public:
+
+    JobFunc                func;
+    ProfileTimer *         timer;
+    bool                   mainThreadOnly;
+    std::atomic<bool>      submitted;
+    std::atomic<bool>      done;
+    std::atomic<sint32>    pending;    ///< 1 (released by submit) + number of unfinished dependencies.
+    std::mutex             mutex;      ///< protects successors and done flag transition.
+    std::vector<JobImpl*>  successors; ///< jobs waiting for this one. Each holds one reference.
+
+    JobImpl( const char * name, JobFunc && f, bool mainOnly )
+        : func( std::move( f ) )
+        , timer( NULL )
+        , mainThreadOnly( mainOnly )
+        , submitted( false )
+        , done( false )
+        , pending( 1 )
+    {
+        if( name && PM_OFF != ProfilerManager::sGetMode() )
+        {
+            timer = sGetJobTimer( name );
+        }
+    }
+
+    bool isDone() const { return done.load( std::memory_order_acquire ); }
+};
+
+///
+/// Chase-Lev work stealing deque. Owner thread pushes and pops at bottom, other
+/// threads steal from top. See "Correct and Efficient Work-Stealing for Weak
+/// Memory Models" (Le, Pop, Cohen, Nardelli, PPoPP'13).
+///
+class WorkStealingDeque : public NoCopy
+{
+    struct Buffer
+    {
+        sint64                  capacity; // power of 2
+        std::atomic<JobImpl*> * slots;
+        Buffer *                prev;     // retired buffer, freed with the deque. Thieves may still read it.
+
+        Buffer( sint64 c, Buffer * p ) : capacity( c ), slots( new std::atomic<JobImpl*>[(size_t)c] ), prev( p ) {}
+        ~Buffer() { delete [] slots; }
+
+        JobImpl * get( sint64 i ) const { return slots[i & (capacity-1)].load( std::memory_order_relaxed ); }
+        void put( sint64 i, JobImpl * j ) { slots[i & (capacity-1)].store( j, std::memory_order_relaxed ); }
+
+        Buffer * grow( sint64 bottom, sint64 top )
+        {
+            Buffer * b = new Buffer( capacity * 2, this );
+            for( sint64 i = top; i < bottom; ++i ) b->put( i, get( i ) );
+            return b;
+        }
+    };
+
+    alignas(GN_CACHE_LINE_SIZE) std::atomic<sint64>  mTop;
+    alignas(GN_CACHE_LINE_SIZE) std::atomic<sint64>  mBottom;
+    alignas(GN_CACHE_LINE_SIZE) std::atomic<Buffer*> mBuffer;
+
+public:
+
+    WorkStealingDeque() : mTop( 0 ), mBottom( 0 ), mBuffer( new Buffer( 256, NULL ) ) {}
+
+    ~WorkStealingDeque()
+    {
+        Buffer * b = mBuffer.load();
+        while( b )
+        {
+            Buffer * p = b->prev;
+            delete b;
+            b = p;
+        }
+    }
+
+    bool empty() const
+    {
+        return mBottom.load( std::memory_order_relaxed ) <= mTop.load( std::memory_order_relaxed );
+    }
+
+    /// Owner only
+    void push( JobImpl * j )
+    {
+        sint64 b = mBottom.load( std::memory_order_relaxed );
+        sint64 t = mTop.load( std::memory_order_acquire );
+        Buffer * a = mBuffer.load( std::memory_order_relaxed );
+        if( b - t > a->capacity - 1 )
+        {
+            a = a->grow( b, t );
+            mBuffer.store( a, std::memory_order_release );
+        }
+        a->put( b, j );
+        std::atomic_thread_fence( std::memory_order_release );
+        mBottom.store( b + 1, std::memory_order_relaxed );
+    }
+
+    /// Owner only
+    JobImpl * pop()
+    {
+        sint64 b = mBottom.load( std::memory_order_relaxed ) - 1;
+        Buffer * a = mBuffer.load( std::memory_order_relaxed );
+        mBottom.store( b, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        sint64 t = mTop.load( std::memory_order_relaxed );
+        JobImpl * j = NULL;
+        if( t <= b )
+        {
+            j = a->get( b );
+            if( t == b )
+            {
+                // last item: race with thieves.
+                if( !mTop.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) j = NULL;
+                mBottom.store( b + 1, std::memory_order_relaxed );
+            }
+        }
+        else
+        {
+            mBottom.store( b + 1, std::memory_order_relaxed );
+        }
+        return j;
+    }
+
+    /// Any thread. Might return NULL when racing with other thieves, even if deque is not empty.
+    JobImpl * steal()
+    {
+        sint64 t = mTop.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        sint64 b = mBottom.load( std::memory_order_acquire );
+        if( t >= b ) return NULL;
+        Buffer * a = mBuffer.load( std::memory_order_acquire );
+        JobImpl * j = a->get( t );
+        if( !mTop.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) return NULL;
+        return j;
+    }
+};
+
+///
+/// Per thread info
+///
+struct JobThreadInfo
+{
+    const void * owner;  ///< the job system this worker thread belongs to
+    sint32       worker; ///< worker index, or -1 for non-worker threads
+    uint32       random; ///< xorshift state used to pick victims
+};
+static thread_local JobThreadInfo tInfo = { NULL, -1, 0 };
+
+// *****************************************************************************
+// JobSystem::Impl
+// *****************************************************************************
+
+class GN::JobSystem::Impl
+{
+    struct Worker
+    {
+        WorkStealingDeque deque;
+        std::thread       thread;
+    };
+
+    std::vector<Worker*>     mWorkers;
+    std::thread::id          mMainThread;
+
+    std::mutex               mInjectMutex;  ///< protects mInjectQueue
+    std::deque<JobImpl*>     mInjectQueue;  ///< jobs submitted from non-worker threads
+    std::atomic<size_t>      mInjectCount;
+
+    std::mutex               mMainMutex;    ///< protects mMainQueue
+    std::deque<JobImpl*>     mMainQueue;    ///< jobs bound to main thread
+
+    std::mutex               mSleepMutex;
+    std::condition_variable  mSleepCond;
+    std::atomic<uint32>      mSleeping;
+    std::atomic<bool>        mQuit;
+
+    std::atomic<sint64>      mUnfinished;   ///< submitted but not finished jobs
+
+public:
+
+    Impl( uint32 numWorkers )
+        : mMainThread( std::this_thread::get_id() )
+        , mInjectCount( 0 )
+        , mSleeping( 0 )
+        , mQuit( false )
+        , mUnfinished( 0 )
+    {
+        if( 0 == numWorkers )
+        {
+            uint32 n = std::thread::hardware_concurrency();
+            numWorkers = n > 1 ? n - 1 : 1;
+        }
+        for( uint32 i = 0; i < numWorkers; ++i ) mWorkers.push_back( new Worker );
+        for( uint32 i = 0; i < numWorkers; ++i )
+        {
+            mWorkers[i]->thread = std::thread( [this, i]{ workerProc( i ); } );
+        }
+        GN_VERBOSE(sLogger)( "Job system started with %u workers.", numWorkers );
+    }
+
+    ~Impl()
+    {
+        waitUntil( [this]{ return 0 == mUnfinished.load( std::memory_order_acquire ); } );
+
+        mQuit = true;
+        {
+            std::lock_guard<std::mutex> lock( mSleepMutex );
+            mSleepCond.notify_all();
+        }
+        for( Worker * w : mWorkers )
+        {
+            w->thread.join();
+            delete w;
+        }
+    }
+
+    uint32 getWorkerCount() const { return (uint32)mWorkers.size(); }
+
+    bool isMainThread() const { return std::this_thread::get_id() == mMainThread; }
+
+    void addDependency( JobImpl * job, JobImpl * dependsOn )
+    {
+        if( job->submitted )
+        {
+            GN_ERROR(sLogger)( "Can't add dependency to a submitted job." );
+            return;
+        }
+        std::lock_guard<std::mutex> lock( dependsOn->mutex );
+        if( dependsOn->done.load( std::memory_order_relaxed ) ) return;
+        job->pending.fetch_add( 1 );
+        job->incref();
+        dependsOn->successors.push_back( job );
+    }
+
+    void submit( JobImpl * job )
+    {
+        if( job->submitted.exchange( true ) )
+        {
+            GN_ERROR(sLogger)( "Job is submitted more than once." );
+            return;
+        }
+        mUnfinished.fetch_add( 1 );
+        if( 1 == job->pending.fetch_sub( 1 ) )
+        {
+            job->incref();
+            schedule( job );
+        }
+    }
+
+    ///
+    /// Queue a ready job. The queue takes over one reference of the job.
+    ///
+    void schedule( JobImpl * job )
+    {
+        if( job->mainThreadOnly )
+        {
+            std::lock_guard<std::mutex> lock( mMainMutex );
+            mMainQueue.push_back( job );
+            return;
+        }
+
+        if( this == tInfo.owner && tInfo.worker >= 0 )
+        {
+            mWorkers[tInfo.worker]->deque.push( job );
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock( mInjectMutex );
+            mInjectQueue.push_back( job );
+            mInjectCount.fetch_add( 1 );
+        }
+
+        // wake up a sleeping worker. See workerProc() for the pairing fence.
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if( mSleeping.load( std::memory_order_relaxed ) > 0 )
+        {
+            std::lock_guard<std::mutex> lock( mSleepMutex );
+            mSleepCond.notify_one();
+        }
+    }
+
+    void execute( JobImpl * job )
+    {
+        if( job->timer ) job->timer->start();
+        job->func();
+        if( job->timer ) job->timer->stop();
+        job->func = nullptr; // release captured objects as early as possible.
+
+        std::vector<JobImpl*> successors;
+        {
+            std::lock_guard<std::mutex> lock( job->mutex );
+            job->done.store( true, std::memory_order_release );
+            successors.swap( job->successors );
+        }
+        for( JobImpl * s : successors )
+        {
+            // the last finished dependency passes its reference to the queue.
+            if( 1 == s->pending.fetch_sub( 1 ) ) schedule( s );
+            else s->decref();
+        }
+
+        mUnfinished.fetch_sub( 1, std::memory_order_release );
+        job->decref();
+    }
+
+    size_t processMainThreadJobs()
+    {
+        size_t n = 0;
+        while( JobImpl * j = popMainQueue() )
+        {
+            execute( j );
+            ++n;
+        }
+        return n;
+    }
+
+    ///
+    /// Run other jobs until the condition is true.
+    ///
+    template<typename COND>
+    void waitUntil( const COND & cond )
+    {
+        bool main = isMainThread();
+        sint32 worker = this == tInfo.owner ? tInfo.worker : -1;
+        size_t idle = 0;
+        while( !cond() )
+        {
+            JobImpl * j = findJob( worker, main );
+            if( j )
+            {
+                execute( j );
+                idle = 0;
+            }
+            else if( ++idle > IDLE_SPIN_COUNT )
+            {
+                std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void waitAll()
+    {
+        waitUntil( [this]{ return 0 == mUnfinished.load( std::memory_order_acquire ); } );
+    }
+
+private:
+
+    JobImpl * popMainQueue()
+    {
+        std::lock_guard<std::mutex> lock( mMainMutex );
+        if( mMainQueue.empty() ) return NULL;
+        JobImpl * j = mMainQueue.front();
+        mMainQueue.pop_front();
+        return j;
+    }
+
+    JobImpl * popInjectQueue()
+    {
+        if( 0 == mInjectCount.load( std::memory_order_relaxed ) ) return NULL;
+        std::lock_guard<std::mutex> lock( mInjectMutex );
+        if( mInjectQueue.empty() ) return NULL;
+        JobImpl * j = mInjectQueue.front();
+        mInjectQueue.pop_front();
+        mInjectCount.fetch_sub( 1 );
+        return j;
+    }
+
+    JobImpl * findJob( sint32 worker, bool main )
+    {
+        JobImpl * j;
+
+        if( main && NULL != ( j = popMainQueue() ) ) return j;
+
+        if( worker >= 0 && NULL != ( j = mWorkers[worker]->deque.pop() ) ) return j;
+
+        if( NULL != ( j = popInjectQueue() ) ) return j;
+
+        // steal from a random victim, then try others in order.
+        size_t n = mWorkers.size();
+        uint32 r = tInfo.random;
+        if( 0 == r ) r = (uint32)std::hash<std::thread::id>()( std::this_thread::get_id() ) | 1;
+        r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+        tInfo.random = r;
+        for( size_t k = 0; k < n; ++k )
+        {
+            size_t victim = ( r + k ) % n;
+            if( (sint32)victim == worker ) continue;
+            if( NULL != ( j = mWorkers[victim]->deque.steal() ) ) return j;
+        }
+
+        return NULL;
+    }
+
+    bool hasWork() const
+    {
+        if( mInjectCount.load( std::memory_order_relaxed ) > 0 ) return true;
+        for( const Worker * w : mWorkers ) if( !w->deque.empty() ) return true;
+        return false;
+    }
+
+    void workerProc( uint32 index )
+    {
+        tInfo.owner = this;
+        tInfo.worker = (sint32)index;
+        ProfilerManager::sSetThreadName( str::format( "GN.JobWorker.%u", index ).rawptr() );
+
+        size_t idle = 0;
+        while( !mQuit.load( std::memory_order_relaxed ) )
+        {
+            JobImpl * j = findJob( (sint32)index, false );
+            if( j )
+            {
+                execute( j );
+                idle = 0;
+                continue;
+            }
+
+            if( ++idle < IDLE_SPIN_COUNT )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Go to sleep. Pairs with the fence in schedule(): either the scheduler sees
+            // mSleeping > 0 and notifies under the mutex, or this thread sees the new job.
+            std::unique_lock<std::mutex> lock( mSleepMutex );
+            mSleeping.fetch_add( 1 );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if( !mQuit && !hasWork() )
+            {
+                mSleepCond.wait_for( lock, std::chrono::milliseconds( 10 ) );
+            }
+            mSleeping.fetch_sub( 1 );
+            idle = 0;
+        }
+    }
+};
+
+// *****************************************************************************
+// JobSystem
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobSystem::JobSystem( uint32 numWorkers )
+{
+    // make sure profiler outlives the global job system, since workers report to it.
+    ProfilerManager::sGetGlobalInstance();
+    mImpl = new Impl( numWorkers );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobSystem::~JobSystem()
+{
+    delete mImpl;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobSystem & GN::JobSystem::sGetGlobalInstance()
+{
+    static JobSystem sInstance;
+    return sInstance;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint32 GN::JobSystem::getWorkerCount() const
+{
+    return mImpl->getWorkerCount();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::JobSystem::isMainThread() const
+{
+    return mImpl->isMainThread();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobHandle GN::JobSystem::create( const char * name, JobFunc func, bool mainThreadOnly )
+{
+    return JobHandle( new JobImpl( name, std::move( func ), mainThreadOnly ) );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::JobSystem::addDependency( const JobHandle & job, const JobHandle & dependsOn )
+{
+    if( !job || !dependsOn ) return;
+    mImpl->addDependency( (JobImpl*)job.rawptr(), (JobImpl*)dependsOn.rawptr() );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::JobSystem::submit( const JobHandle & job )
+{
+    if( !job ) return;
+    mImpl->submit( (JobImpl*)job.rawptr() );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobHandle GN::JobSystem::run( const char * name, JobFunc func, const JobHandle * dependencies, size_t numDependencies )
+{
+    JobHandle job = create( name, std::move( func ) );
+    for( size_t i = 0; i < numDependencies; ++i ) addDependency( job, dependencies[i] );
+    submit( job );
+    return job;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::JobHandle GN::JobSystem::runOnMainThread( const char * name, JobFunc func, const JobHandle * dependencies, size_t numDependencies )
+{
+    JobHandle job = create( name, std::move( func ), true );
+    for( size_t i = 0; i < numDependencies; ++i ) addDependency( job, dependencies[i] );
+    submit( job );
+    return job;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::JobSystem::wait( const JobHandle & job )
+{
+    if( !job ) return;
+    JobImpl * j = (JobImpl*)job.rawptr();
+    if( !j->submitted )
+    {
+        GN_ERROR(sLogger)( "Waiting for a job that is not submitted." );
+        return;
+    }
+    if( j->mainThreadOnly && !mImpl->isMainThread() && !j->isDone() )
+    {
+        GN_WARN(sLogger)( "Waiting for main thread job on other thread. Make sure main thread calls processMainThreadJobs()." );
+    }
+    mImpl->waitUntil( [j]{ return j->isDone(); } );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::JobSystem::waitAll()
+{
+    mImpl->waitAll();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::JobSystem::processMainThreadJobs()
+{
+    if( !mImpl->isMainThread() )
+    {
+        GN_ERROR(sLogger)( "processMainThreadJobs() must be called on main thread." );
+        return 0;
+    }
+    return mImpl->processMainThreadJobs();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::JobSystem::parallelFor( size_t begin, size_t end, const JobRangeFunc & func, size_t grainSize, const char * name )
+{
+    if( begin >= end ) return;
+
+    size_t count = end - begin;
+    if( 0 == grainSize )
+    {
+        // about 8 chunks per thread: enough for load balancing, few enough to keep overhead low.
+        size_t chunks = ( (size_t)getWorkerCount() + 1 ) * 8;
+        grainSize = std::max<size_t>( 1, count / chunks );
+    }
+
+    if( count <= grainSize )
+    {
+        func( begin, end );
+        return;
+    }
+
+    struct Context
+    {
+        JobSystem &           js;
+        const JobRangeFunc &  func;
+        size_t                grainSize;
+        const char *          name;
+        std::atomic<size_t>   remaining;
+
+        Context( JobSystem & j, const JobRangeFunc & f, size_t g, const char * n, size_t r )
+            : js( j ), func( f ), grainSize( g ), name( n ), remaining( r ) {}
+
+        // split off upper halves as new jobs, then process the lowest part locally.
+        void process( size_t b, size_t e )
+        {
+            while( e - b > grainSize )
+            {
+                size_t mid = b + ( e - b ) / 2;
+                js.run( name, [this, mid, e]{ process( mid, e ); } );
+                e = mid;
+            }
+            func( b, e );
+            remaining.fetch_sub( e - b, std::memory_order_release );
+        }
+    };
+
+    Context ctx( *this, func, grainSize, name, count );
+    ctx.process( begin, end );
+    mImpl->waitUntil( [&ctx]{ return 0 == ctx.remaining.load( std::memory_order_acquire ); } );
+}
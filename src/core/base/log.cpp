@@ -1,4 +1,53 @@
 #include "pch.h"
+#include <memory>
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+///
+/// Format the message into a heap buffer owned by the calling thread, then log it.
+/// The buffer is allocated on first use, so logging neither allocates per call nor
+/// needs a large stack. Messages logged by receivers while the buffer is in use get
+/// a buffer of their own.
+// -----------------------------------------------------------------------------
+template<typename CHAR>
+static void sFormatAndLog( GN::Logger & logger, const GN::Logger::LogDesc & desc, const CHAR * fmt, va_list args )
+{
+    static const size_t BUFFER_SIZE = 16384;
+    static thread_local std::unique_ptr<CHAR[]> tBuffer;
+    static thread_local bool tBusy = false;
+
+    std::unique_ptr<CHAR[]> nested;
+    CHAR * buf;
+    if( tBusy )
+    {
+        nested.reset( new CHAR[BUFFER_SIZE] );
+        buf = nested.get();
+    }
+    else
+    {
+        if( !tBuffer ) tBuffer.reset( new CHAR[BUFFER_SIZE] );
+        buf = tBuffer.get();
+        tBusy = true;
+    }
+
+    if( GN::str::isEmpty( fmt ) )
+    {
+        buf[0] = 0;
+    }
+    else
+    {
+        GN::str::formatvTo( buf, BUFFER_SIZE, fmt, args );
+    }
+    logger.doLog( desc, buf );
+
+    if( !nested ) tBusy = false;
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
 
 //
 //
@@ -6,12 +55,10 @@
 void GN::Logger::LogHelper::operator()( const char * fmt, ... )
 {
     GN_ASSERT( mLogger );
-    StrA s;
     va_list arglist;
     va_start( arglist, fmt );
-    s.formatv( fmt, arglist );
+    sFormatAndLog( *mLogger, mDesc, fmt, arglist );
     va_end( arglist );
-    mLogger->doLog( mDesc, s );
 }
 
 //
@@ -20,10 +67,8 @@ void GN::Logger::LogHelper::operator()( const char * fmt, ... )
 void GN::Logger::LogHelper::operator()( const wchar_t * fmt, ... )
 {
     GN_ASSERT( mLogger );
-    StrW s;
     va_list arglist;
     va_start( arglist, fmt );
-    s.formatv( fmt, arglist );
+    sFormatAndLog( *mLogger, mDesc, fmt, arglist );
     va_end( arglist );
-    mLogger->doLog( mDesc, s );
 }
@@ -0,0 +1,558 @@
+#include "pch.h"
+#include <algorithm>
+
+using namespace GN;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+//
+// Clip a polygon against the near plane (z >= 0 in D3D clip space). Return number
+// of output vertices.
+// -----------------------------------------------------------------------------
+static size_t sClipNear( Vector4f * out, const Vector4f * in, size_t count )
+{
+    size_t n = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const Vector4f & a = in[i];
+        const Vector4f & b = in[( i + 1 ) % count];
+        if( a.z >= 0 ) out[n++] = a;
+        if( ( a.z >= 0 ) != ( b.z >= 0 ) )
+        {
+            float t = a.z / ( a.z - b.z );
+            out[n++] = a + ( b - a ) * t;
+        }
+    }
+    return n;
+}
+
+//
+// Get screen space bounds of 8 corners of a box. Return -1 if the box is
+// completely in front of the near plane, 1 if it crosses the near plane, 0 otherwise.
+// -----------------------------------------------------------------------------
+static int sProjectBox( Vector3f & vmin, Vector3f & vmax, const Matrix44f & m, const Boxf & box, float width, float height )
+{
+    // clip space position of the min corner, and of the 3 edges.
+    Vector4f c0 = m * Vector4f( box.x, box.y, box.z, 1.0f );
+    Vector4f ex( m.rows[0].x, m.rows[1].x, m.rows[2].x, m.rows[3].x );
+    Vector4f ey( m.rows[0].y, m.rows[1].y, m.rows[2].y, m.rows[3].y );
+    Vector4f ez( m.rows[0].z, m.rows[1].z, m.rows[2].z, m.rows[3].z );
+    ex *= box.w;
+    ey *= box.h;
+    ez *= box.d;
+
+    vmin.set( FLT_MAX, FLT_MAX, FLT_MAX );
+    vmax.set( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    int front = 0;
+    for( int i = 0; i < 8; ++i )
+    {
+        Vector4f c = c0;
+        if( i & 1 ) c += ex;
+        if( i & 2 ) c += ey;
+        if( i & 4 ) c += ez;
+
+        if( c.z < 0 || c.w < 0 )
+        {
+            ++front;
+            continue;
+        }
+
+        float invw = 1.0f / c.w;
+        Vector3f s( ( c.x * invw * 0.5f + 0.5f ) * width, ( 0.5f - c.y * invw * 0.5f ) * height, c.z * invw );
+        vmin.set( math::getmin( vmin.x, s.x ), math::getmin( vmin.y, s.y ), math::getmin( vmin.z, s.z ) );
+        vmax.set( math::getmax( vmax.x, s.x ), math::getmax( vmax.y, s.y ), math::getmax( vmax.z, s.z ) );
+    }
+    if( 8 == front ) return -1;
+    if( 0 != front ) return 1;
+    return 0;
+}
+
+//
+// Rasterize one row of a triangle, 4 pixels at a time. x0 must be aligned to 4.
+// -----------------------------------------------------------------------------
+static inline void sRasterizeRow(
+    float       * depth,
+    sint32         x0,
+    sint32         x1,
+    float         cy,
+    const float   e[3][3],
+    const float   z[3] )
+{
+#if GN_SIMD
+    using namespace simd;
+
+    const Float4 offsets = set( 0.5f, 1.5f, 2.5f, 3.5f );
+    Float4 fx = add( splat( (float)x0 ), offsets );
+
+    // edge and depth values of the first 4 pixels, and their increments.
+    Float4 e0 = madd( splat( e[0][0] ), fx, splat( e[0][1] * cy + e[0][2] ) );
+    Float4 e1 = madd( splat( e[1][0] ), fx, splat( e[1][1] * cy + e[1][2] ) );
+    Float4 e2 = madd( splat( e[2][0] ), fx, splat( e[2][1] * cy + e[2][2] ) );
+    Float4 zz = madd( splat( z[0] ), fx, splat( z[1] * cy + z[2] ) );
+    Float4 d0 = splat( e[0][0] * 4 );
+    Float4 d1 = splat( e[1][0] * 4 );
+    Float4 d2 = splat( e[2][0] * 4 );
+    Float4 dz = splat( z[0] * 4 );
+    Float4 zero = simd::zero();
+
+    for( sint32 x = x0; x <= x1; x += 4 )
+    {
+        Float4 outside = cmplt( minimum( e0, minimum( e1, e2 ) ), zero );
+        if( 0xF != movemask( outside ) )
+        {
+            Float4 d = load( depth + x );
+            store( depth + x, select( outside, d, minimum( d, maximum( zz, zero ) ) ) );
+        }
+        e0 = add( e0, d0 );
+        e1 = add( e1, d1 );
+        e2 = add( e2, d2 );
+        zz = add( zz, dz );
+    }
+#else
+    for( sint32 x = x0; x <= x1; ++x )
+    {
+        float fx = x + 0.5f;
+        if( e[0][0] * fx + e[0][1] * cy + e[0][2] < 0 ||
+            e[1][0] * fx + e[1][1] * cy + e[1][2] < 0 ||
+            e[2][0] * fx + e[2][1] * cy + e[2][2] < 0 ) continue;
+        float d = math::getmax( z[0] * fx + z[1] * cy + z[2], 0.0f );
+        if( d < depth[x] ) depth[x] = d;
+    }
+#endif
+}
+
+//
+// Return the farthest depth of a block.
+// -----------------------------------------------------------------------------
+static inline float sBlockMax( const float * depth, size_t pitch )
+{
+    GN_CASSERT( 8 == OcclusionBuffer::BLOCK_SIZE );
+#if GN_SIMD
+    using namespace simd;
+    Float4 m0 = load( depth ), m1 = load( depth + 4 );
+    for( size_t y = 1; y < OcclusionBuffer::BLOCK_SIZE; ++y )
+    {
+        m0 = maximum( m0, load( depth + y * pitch ) );
+        m1 = maximum( m1, load( depth + y * pitch + 4 ) );
+    }
+    m0 = maximum( m0, m1 );
+    m0 = maximum( m0, shuffle<2, 3, 0, 1>( m0 ) );
+    m0 = maximum( m0, shuffle<1, 0, 3, 2>( m0 ) );
+    return getX( m0 );
+#else
+    float m = depth[0];
+    for( size_t y = 0; y < OcclusionBuffer::BLOCK_SIZE; ++y )
+    {
+        for( size_t x = 0; x < OcclusionBuffer::BLOCK_SIZE; ++x ) m = math::getmax( m, depth[y * pitch + x] );
+    }
+    return m;
+#endif
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::OcclusionBuffer::OcclusionBuffer()
+    : mWidth( 0 )
+    , mHeight( 0 )
+    , mBinsX( 0 )
+    , mBinsY( 0 )
+{
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::OcclusionBuffer::~OcclusionBuffer()
+{
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::OcclusionBuffer::init( uint32 width, uint32 height )
+{
+    if( 0 == width || 0 == height )
+    {
+        GN_ERROR(getLogger("GN.base.OcclusionBuffer"))( "Occlusion buffer size can't be zero." );
+        return false;
+    }
+
+    mWidth  = math::alignToPowerOf2<uint32>( width, BLOCK_SIZE );
+    mHeight = math::alignToPowerOf2<uint32>( height, BLOCK_SIZE );
+    mBinsX  = ( mWidth + BIN_SIZE - 1 ) / BIN_SIZE;
+    mBinsY  = ( mHeight + BIN_SIZE - 1 ) / BIN_SIZE;
+
+    if( !mDepth.resize( mWidth * mHeight ) ||
+        !mBlockDepth.resize( ( mWidth / BLOCK_SIZE ) * ( mHeight / BLOCK_SIZE ) ) )
+    {
+        mWidth = mHeight = mBinsX = mBinsY = 0;
+        return false;
+    }
+    mBins.clear();
+    mBins.resize( mBinsX * mBinsY );
+
+    clear();
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::clear()
+{
+    for( float & d : mDepth ) d = 1.0f;
+    for( float & d : mBlockDepth ) d = 1.0f;
+    mTriangles.clear();
+    for( auto & b : mBins ) b.clear();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::addOccluder(
+    const Matrix44f & clipFromObject,
+    const Vector3f  * positions,
+    size_t            strideInBytes,
+    size_t            numVertices,
+    const uint32    * indices,
+    size_t            numIndices )
+{
+    addTriangles( clipFromObject, positions, strideInBytes, numVertices, indices, numIndices );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::addOccluder(
+    const Matrix44f & clipFromObject,
+    const Vector3f  * positions,
+    size_t            strideInBytes,
+    size_t            numVertices,
+    const uint16    * indices,
+    size_t            numIndices )
+{
+    addTriangles( clipFromObject, positions, strideInBytes, numVertices, indices, numIndices );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::render()
+{
+    for( size_t i = 0; i < mBins.size(); ++i ) renderBin( i );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::render( JobSystem & js )
+{
+    js.parallelFor( 0, mBins.size(), [this]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; ++i ) renderBin( i );
+    }, 1, "occlusion rendering" );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::OcclusionBuffer::testBox( const Matrix44f & clipFromObject, const Boxf & box ) const
+{
+    if( 0 == mWidth ) return true;
+
+    Vector3f vmin, vmax;
+    int r = sProjectBox( vmin, vmax, clipFromObject, box, (float)mWidth, (float)mHeight );
+    if( r < 0 ) return false;
+    if( r > 0 ) return true;
+
+    // behind far plane
+    if( vmin.z > 1.0f ) return false;
+
+    // off screen
+    if( vmax.x < 0 || vmax.y < 0 || vmin.x >= (float)mWidth || vmin.y >= (float)mHeight ) return false;
+
+    // pixels touched by the box. Coordinates are not negative after clamping, so
+    // conversions round them down.
+    sint32 x0 = (sint32)math::getmax( vmin.x, 0.0f );
+    sint32 y0 = (sint32)math::getmax( vmin.y, 0.0f );
+    sint32 x1 = math::getmin( (sint32)vmax.x, (sint32)mWidth - 1 );
+    sint32 y1 = math::getmin( (sint32)vmax.y, (sint32)mHeight - 1 );
+
+    const sint32 blocksX = mWidth / BLOCK_SIZE;
+    for( sint32 by = y0 / BLOCK_SIZE; by <= y1 / BLOCK_SIZE; ++by )
+    {
+        for( sint32 bx = x0 / BLOCK_SIZE; bx <= x1 / BLOCK_SIZE; ++bx )
+        {
+            // the whole block is in front of the box
+            if( mBlockDepth[by * blocksX + bx] <= vmin.z ) continue;
+
+            sint32 px0 = math::getmax( x0, bx * BLOCK_SIZE );
+            sint32 px1 = math::getmin( x1, bx * BLOCK_SIZE + BLOCK_SIZE - 1 );
+            sint32 py0 = math::getmax( y0, by * BLOCK_SIZE );
+            sint32 py1 = math::getmin( y1, by * BLOCK_SIZE + BLOCK_SIZE - 1 );
+            for( sint32 y = py0; y <= py1; ++y )
+            {
+                const float * row = mDepth.rawptr() + y * mWidth;
+                for( sint32 x = px0; x <= px1; ++x )
+                {
+                    if( row[x] > vmin.z ) return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+size_t GN::OcclusionBuffer::testBoxes( uint32 * visible, const Matrix44f & clipFromWorld, const Boxf * boxes, size_t count ) const
+{
+    size_t n = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( testBox( clipFromWorld, boxes[i] ) ) visible[n++] = (uint32)i;
+    }
+    return n;
+}
+
+// *****************************************************************************
+// private functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+template<typename INDEX>
+void GN::OcclusionBuffer::addTriangles(
+    const Matrix44f & m,
+    const Vector3f  * positions,
+    size_t            stride,
+    size_t            numVertices,
+    const INDEX     * indices,
+    size_t            numIndices )
+{
+    if( 0 == mWidth || 0 == numVertices ) return;
+
+    if( !mClipVertices.resize( numVertices ) ) return;
+    transformPoints( mClipVertices.rawptr(), sizeof(Vector4f), m, positions, stride, numVertices );
+    const Vector4f * clip = mClipVertices.rawptr();
+
+    size_t numTriangles = ( indices ? numIndices : numVertices ) / 3;
+    for( size_t i = 0; i < numTriangles; ++i )
+    {
+        Vector4f v[3];
+        bool valid = true;
+        for( size_t k = 0; k < 3; ++k )
+        {
+            size_t index = indices ? (size_t)indices[i * 3 + k] : i * 3 + k;
+            if( index >= numVertices ) { valid = false; break; }
+            v[k] = clip[index];
+        }
+        if( valid ) addTriangle( v );
+    }
+}
+
+//
+// Cull the triangle against the frustum, clip it against near plane, and bin it.
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::addTriangle( const Vector4f * v )
+{
+    // trivial rejection against left, right, bottom, top, near and far planes.
+    if( ( v[0].x < -v[0].w && v[1].x < -v[1].w && v[2].x < -v[2].w ) ||
+        ( v[0].x >  v[0].w && v[1].x >  v[1].w && v[2].x >  v[2].w ) ||
+        ( v[0].y < -v[0].w && v[1].y < -v[1].w && v[2].y < -v[2].w ) ||
+        ( v[0].y >  v[0].w && v[1].y >  v[1].w && v[2].y >  v[2].w ) ||
+        ( v[0].z < 0 && v[1].z < 0 && v[2].z < 0 ) ||
+        ( v[0].z > v[0].w && v[1].z > v[1].w && v[2].z > v[2].w ) )
+    {
+        return;
+    }
+
+    Vector4f clipped[4];
+    size_t n = 3;
+    const Vector4f * poly = v;
+    if( v[0].z < 0 || v[1].z < 0 || v[2].z < 0 )
+    {
+        n = sClipNear( clipped, v, 3 );
+        poly = clipped;
+    }
+
+    Vector3f screen[4];
+    for( size_t i = 0; i < n; ++i )
+    {
+        const Vector4f & c = poly[i];
+        if( c.w <= 0 ) return;
+        float invw = 1.0f / c.w;
+        screen[i].set( ( c.x * invw * 0.5f + 0.5f ) * mWidth, ( 0.5f - c.y * invw * 0.5f ) * mHeight, c.z * invw );
+    }
+
+    // triangle fan
+    for( size_t i = 2; i < n; ++i )
+    {
+        Vector3f t[3] = { screen[0], screen[i - 1], screen[i] };
+        binTriangle( t );
+    }
+}
+
+//
+// Setup edge functions and depth plane of a screen space triangle, and add it
+// to all bins that it touches.
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::binTriangle( const Vector3f * s )
+{
+    float dx1 = s[1].x - s[0].x, dy1 = s[1].y - s[0].y, dz1 = s[1].z - s[0].z;
+    float dx2 = s[2].x - s[0].x, dy2 = s[2].y - s[0].y, dz2 = s[2].z - s[0].z;
+    float area = dx1 * dy2 - dx2 * dy1;
+    if( fabs( area ) < 1e-8f ) return;
+
+    // make the winding positive, so edge functions are positive inside.
+    int i1 = 1, i2 = 2;
+    if( area < 0 ) { i1 = 2; i2 = 1; }
+    const Vector3f * v[3] = { &s[0], &s[i1], &s[i2] };
+
+    Triangle t;
+    for( int k = 0; k < 3; ++k )
+    {
+        const Vector3f & a = *v[( k + 1 ) % 3];
+        const Vector3f & b = *v[( k + 2 ) % 3];
+        t.edges[k][0] = a.y - b.y;
+        t.edges[k][1] = b.x - a.x;
+        t.edges[k][2] = -( t.edges[k][0] * a.x + t.edges[k][1] * a.y );
+    }
+    t.z[0] = ( dz1 * dy2 - dz2 * dy1 ) / area;
+    t.z[1] = ( dz2 * dx1 - dz1 * dx2 ) / area;
+    t.z[2] = s[0].z - t.z[0] * s[0].x - t.z[1] * s[0].y;
+    t.minZ = math::getmax( math::getmin( s[0].z, math::getmin( s[1].z, s[2].z ) ), 0.0f );
+
+    // pixels whose centers are inside of the triangle bounds
+    float minx = math::getmin( s[0].x, math::getmin( s[1].x, s[2].x ) );
+    float maxx = math::getmax( s[0].x, math::getmax( s[1].x, s[2].x ) );
+    float miny = math::getmin( s[0].y, math::getmin( s[1].y, s[2].y ) );
+    float maxy = math::getmax( s[0].y, math::getmax( s[1].y, s[2].y ) );
+    t.minX = math::getmax( (sint32)ceilf( minx - 0.5f ), 0 );
+    t.minY = math::getmax( (sint32)ceilf( miny - 0.5f ), 0 );
+    t.maxX = math::getmin( (sint32)floorf( maxx - 0.5f ), (sint32)mWidth - 1 );
+    t.maxY = math::getmin( (sint32)floorf( maxy - 0.5f ), (sint32)mHeight - 1 );
+    if( t.minX > t.maxX || t.minY > t.maxY ) return;
+
+    uint32 index = (uint32)mTriangles.size();
+    if( !mTriangles.append( t ) ) return;
+
+    for( sint32 by = t.minY / BIN_SIZE; by <= t.maxY / BIN_SIZE; ++by )
+    {
+        for( sint32 bx = t.minX / BIN_SIZE; bx <= t.maxX / BIN_SIZE; ++bx )
+        {
+            mBins[by * mBinsX + bx].append( index );
+        }
+    }
+}
+
+//
+// Rasterize all triangles of a bin front to back, then update its hierarchical depth.
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::renderBin( size_t bin )
+{
+    DynaArray<uint32> & triangles = mBins[bin];
+    if( triangles.empty() ) return;
+
+    const sint32 binX0 = (sint32)( bin % mBinsX ) * BIN_SIZE;
+    const sint32 binY0 = (sint32)( bin / mBinsX ) * BIN_SIZE;
+    const sint32 binX1 = math::getmin<sint32>( binX0 + BIN_SIZE, mWidth ) - 1;
+    const sint32 binY1 = math::getmin<sint32>( binY0 + BIN_SIZE, mHeight ) - 1;
+    const uint32 blocksX = mWidth / BLOCK_SIZE;
+
+    // Sort by nearest depth. Ties are broken by index, to keep the order stable.
+    const Triangle * tris = mTriangles.rawptr();
+    std::sort( triangles.begin(), triangles.end(), [tris]( uint32 a, uint32 b ) {
+        return tris[a].minZ < tris[b].minZ || ( tris[a].minZ == tris[b].minZ && a < b );
+    } );
+
+    // Hierarchical depth of the bin is refreshed every few triangles, to reject
+    // the ones that are behind what is rendered so far.
+    const size_t REFRESH_INTERVAL = 16;
+    size_t rendered = 0;
+
+    for( uint32 index : triangles )
+    {
+        const Triangle & t = tris[index];
+
+        sint32 x0 = math::getmax( t.minX, binX0 );
+        sint32 x1 = math::getmin( t.maxX, binX1 );
+        sint32 y0 = math::getmax( t.minY, binY0 );
+        sint32 y1 = math::getmin( t.maxY, binY1 );
+
+        if( rendered >= REFRESH_INTERVAL )
+        {
+            updateBlockDepth( bin );
+            rendered = 0;
+        }
+        bool hidden = true;
+        for( sint32 by = y0 / BLOCK_SIZE; hidden && by <= y1 / BLOCK_SIZE; ++by )
+        {
+            for( sint32 bx = x0 / BLOCK_SIZE; bx <= x1 / BLOCK_SIZE; ++bx )
+            {
+                if( mBlockDepth[by * blocksX + bx] > t.minZ ) { hidden = false; break; }
+            }
+        }
+        if( hidden ) continue;
+        ++rendered;
+
+        // The range of pixels inside of the triangle is computed for each row, one
+        // pixel wider on both sides, so rounding never drops a pixel. Edge functions
+        // decide the coverage at the end.
+        float inva[3];
+        for( int k = 0; k < 3; ++k ) inva[k] = 0 != t.edges[k][0] ? 1.0f / t.edges[k][0] : 0.0f;
+
+        for( sint32 y = y0; y <= y1; ++y )
+        {
+            float cy = y + 0.5f;
+            float xmin = (float)x0, xmax = (float)x1;
+            bool empty = false;
+            for( int k = 0; k < 3; ++k )
+            {
+                // a * ( x + 0.5 ) + b * cy + c >= 0
+                float a = t.edges[k][0];
+                float r = t.edges[k][1] * cy + t.edges[k][2] + a * 0.5f;
+                if( a > 0 )      xmin = math::getmax( xmin, -r * inva[k] - 1.0f );
+                else if( a < 0 ) xmax = math::getmin( xmax, -r * inva[k] + 1.0f );
+                else if( r < 0 ) empty = true;
+            }
+            if( empty || xmin > xmax ) continue;
+
+            // Rows start from 4 aligned column. Bins and width are multiple of 8, so
+            // the last 4 pixels never go beyond the bin. xmin >= 0 here, so the
+            // conversion rounds it down.
+            sRasterizeRow( mDepth.rawptr() + y * mWidth, (sint32)xmin & ~3, (sint32)xmax, cy, t.edges, t.z );
+        }
+    }
+
+    updateBlockDepth( bin );
+}
+
+//
+// Update hierarchical depth of blocks in a bin.
+// -----------------------------------------------------------------------------
+void GN::OcclusionBuffer::updateBlockDepth( size_t bin )
+{
+    const sint32 binX0 = (sint32)( bin % mBinsX ) * BIN_SIZE;
+    const sint32 binY0 = (sint32)( bin / mBinsX ) * BIN_SIZE;
+    const sint32 binX1 = math::getmin<sint32>( binX0 + BIN_SIZE, mWidth ) - 1;
+    const sint32 binY1 = math::getmin<sint32>( binY0 + BIN_SIZE, mHeight ) - 1;
+    const uint32 blocksX = mWidth / BLOCK_SIZE;
+
+    for( sint32 y = binY0; y <= binY1; y += BLOCK_SIZE )
+    {
+        for( sint32 x = binX0; x <= binX1; x += BLOCK_SIZE )
+        {
+            mBlockDepth[( y / BLOCK_SIZE ) * blocksX + x / BLOCK_SIZE] = sBlockMax( mDepth.rawptr() + y * mWidth + x, mWidth );
+        }
+    }
+}
@@ -1,5 +1,20 @@
 #include "pch.h"
 #include "garnet/base/profiler.h"
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#define GN_PROFILER_HAS_PERF_EVENT 1
+#else
+#define GN_PROFILER_HAS_PERF_EVENT 0
+#endif
+
+static GN::Logger * sLogger = GN::getLogger("GN.base.Profiler");
 
 static GN::StrA sTime2Str( double time )
 {
@@ -19,6 +34,1075 @@ static GN::StrA sTime2Str( double time )
     }
 }
 
+// *****************************************************************************
+// Profile Histogram
+// *****************************************************************************
+
+struct GN::ProfileTimer::Histograms
+{
+    ProfileHistogram total;
+    ProfileHistogram current; ///< rolling window in progress
+    ProfileHistogram last;    ///< last complete rolling window
+};
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfileHistogram::clear()
+{
+    mCount = 0;
+    memset( mBuckets, 0, sizeof(mBuckets) );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfileHistogram::record( uint64 nanoseconds )
+{
+    ++mCount;
+    ++mBuckets[sGetBucketIndex( nanoseconds )];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfileHistogram::merge( const ProfileHistogram & other )
+{
+    mCount += other.mCount;
+    for( size_t i = 0; i < BUCKET_COUNT; ++i ) mBuckets[i] += other.mBuckets[i];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileHistogram::getPercentile( double percentile ) const
+{
+    if( 0 == mCount ) return 0;
+
+    if( percentile < 0 ) percentile = 0;
+    if( percentile > 100 ) percentile = 100;
+
+    // rank of the sample, 1 based.
+    uint64 rank = (uint64)ceil( percentile / 100.0 * (double)mCount );
+    if( rank < 1 ) rank = 1;
+
+    uint64 accumulated = 0;
+    for( size_t i = 0; i < BUCKET_COUNT; ++i )
+    {
+        accumulated += mBuckets[i];
+        if( accumulated >= rank )
+        {
+            // use middle of the bucket
+            double ns = (double)sGetBucketLowerBound( i ) + (double)( sGetBucketWidth( i ) - 1 ) / 2.0;
+            return ns / 1e9;
+        }
+    }
+
+    return 0;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API size_t GN::ProfileHistogram::sGetBucketIndex( uint64 v )
+{
+    if( v < SUB_BUCKET_COUNT ) return (size_t)v;
+
+    const uint64 MAX_VALUE = ( (uint64)1 << MAX_VALUE_BITS ) - 1;
+    if( v > MAX_VALUE ) v = MAX_VALUE;
+
+    // index of highest set bit
+#if GN_MSVC
+    unsigned long msb;
+    _BitScanReverse64( &msb, v );
+#else
+    unsigned int msb = 63 - __builtin_clzll( v );
+#endif
+
+    // row 0 holds values in [0, SUB_BUCKET_COUNT), row r>0 holds [SUB_BUCKET_COUNT, 2*SUB_BUCKET_COUNT) << (r-1)
+    size_t shift = msb - SUB_BUCKET_BITS;
+    size_t sub   = (size_t)( v >> shift ) & ( SUB_BUCKET_COUNT - 1 );
+    return ( shift + 1 ) * SUB_BUCKET_COUNT + sub;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::ProfileHistogram::sGetBucketLowerBound( size_t index )
+{
+    size_t row = index / SUB_BUCKET_COUNT;
+    size_t sub = index % SUB_BUCKET_COUNT;
+    if( 0 == row ) return sub;
+    return ( (uint64)( SUB_BUCKET_COUNT + sub ) ) << ( row - 1 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::ProfileHistogram::sGetBucketWidth( size_t index )
+{
+    size_t row = index / SUB_BUCKET_COUNT;
+    return 0 == row ? 1 : ( (uint64)1 << ( row - 1 ) );
+}
+
+// *****************************************************************************
+// Per-thread profiler data
+// *****************************************************************************
+
+namespace GN
+{
+    static const size_t EVENT_BUFFER_SIZE = 64 * 1024; ///< events per thread, must be power of 2.
+    static const size_t FLAT_CHUNK_SIZE   = 256;       ///< timers per flat statistics chunk
+    static const size_t MAX_FLAT_CHUNKS   = 64;
+    static const uint32 INVALID_TIMER     = 0xFFFFFFFF;
+    static const size_t MAX_RECORD_EVENTS = 16 * 1024 * 1024; ///< event budget of TM_RECORD mode
+
+    /// current profiler mode
+    static std::atomic<int> sMode( PM_FULL );
+
+    /// hardware counters enabled or not
+    static std::atomic<bool> sHardwareCounters( false );
+
+    enum ProfilerEventType
+    {
+        PET_BEGIN,
+        PET_END,
+        PET_GAP,   ///< some events are lost because of buffer overflow.
+
+        PET_TYPE_MASK    = 0xFF,
+        PET_HAS_COUNTERS = 0x100, ///< flag: hardware counters of the event are stored in ProfilerThreadData::counters
+    };
+
+    struct ProfilerEvent
+    {
+        uint32 timerId;
+        uint32 type;
+        sint64 time;
+    };
+
+    ///
+    /// Flat statistics of one timer on one thread, used in PM_LOW_OVERHEAD mode. The atomics
+    /// are only written by the owner thread, so plain load/store is enough.
+    ///
+    struct FlatStat
+    {
+        std::atomic<uint64> count;
+        std::atomic<sint64> sum;
+        std::atomic<sint64> min;
+        std::atomic<sint64> max;
+        sint64              start;
+    };
+
+    struct FlatChunk
+    {
+        FlatStat stats[FLAT_CHUNK_SIZE];
+    };
+
+    /// FlatStat values that are already merged into timers.
+    struct FlatMerged
+    {
+        uint64 count;
+        sint64 sum;
+    };
+
+    struct CallNode
+    {
+        uint32 timerId;
+        uint32 parent;
+        uint32 firstChild;
+        uint32 nextSibling;
+        uint64 count;
+        sint64 inclusive;
+        sint64 children;
+        sint64 min;
+        sint64 max;
+        uint64 counters[PC_COUNT];
+    };
+
+    struct TraceEvent
+    {
+        sint64 time;
+        uint32 timerId;
+        uint32 threadId;
+        uint32 type;
+    };
+
+    struct StackEntry
+    {
+        uint32 node;
+        sint64 start;
+        bool   hasCounters;
+        uint64 counters[PC_COUNT];
+    };
+
+    struct ProfilerThreadData
+    {
+        // written by the owner thread
+        ProfilerEvent           * events;
+        std::atomic<size_t>       writePos;
+        std::atomic<size_t>       readPos;
+        std::atomic<uint64>       dropped;
+        bool                      gapPending;
+        std::atomic<FlatChunk*>   flat[MAX_FLAT_CHUNKS];
+        std::atomic<bool>         orphaned;
+
+        // hardware counters, used by owner thread only.
+        int                       perfState; ///< 0: not opened yet, 1: opened, -1: unavailable
+        int                       perfFds[PC_COUNT];
+        uint64                 (* counters)[PC_COUNT]; ///< counter values of events, parallel to event buffer.
+
+        // owned by the aggregator (guarded by ProfilerCore::mutex)
+        uint32                    threadId;
+        StrA                      name;
+        DynaArray<CallNode>       tree;
+        DynaArray<StackEntry>     stack;
+        DynaArray<FlatMerged>     merged;
+
+        ProfilerThreadData()
+            : events( (ProfilerEvent*)HeapMemory::alloc( sizeof(ProfilerEvent) * EVENT_BUFFER_SIZE ) )
+            , writePos(0)
+            , readPos(0)
+            , dropped(0)
+            , gapPending(false)
+            , orphaned(false)
+            , perfState(0)
+            , counters(NULL)
+            , threadId(0)
+        {
+            for( size_t i = 0; i < PC_COUNT; ++i ) perfFds[i] = -1;
+            for( size_t i = 0; i < MAX_FLAT_CHUNKS; ++i ) flat[i] = NULL;
+            resetTree();
+        }
+
+        ~ProfilerThreadData()
+        {
+            HeapMemory::dealloc( events );
+            closeCounters();
+            if( counters ) HeapMemory::dealloc( counters );
+            for( size_t i = 0; i < MAX_FLAT_CHUNKS; ++i ) delete flat[i].load();
+        }
+
+        void resetTree()
+        {
+            tree.clear();
+            stack.clear();
+            CallNode root = { INVALID_TIMER, 0, 0, 0, 0, 0, 0, 0, 0, {} };
+            tree.append( root );
+        }
+
+        /// Open hardware counters of calling thread. Return false if not available.
+        bool openCounters()
+        {
+#if GN_PROFILER_HAS_PERF_EVENT
+            static const uint64 CONFIGS[PC_COUNT] =
+            {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES,
+            };
+
+            for( size_t i = 0; i < PC_COUNT; ++i )
+            {
+                perf_event_attr attr;
+                memset( &attr, 0, sizeof(attr) );
+                attr.size           = sizeof(attr);
+                attr.type           = PERF_TYPE_HARDWARE;
+                attr.config         = CONFIGS[i];
+                attr.read_format    = PERF_FORMAT_GROUP;
+                attr.disabled       = 0 == i;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                perfFds[i] = (int)syscall( __NR_perf_event_open, &attr, 0, -1, 0 == i ? -1 : perfFds[0], 0 );
+                if( perfFds[i] < 0 )
+                {
+                    static std::atomic_flag sWarned = ATOMIC_FLAG_INIT;
+                    if( !sWarned.test_and_set() )
+                    {
+                        GN_WARN(sLogger)( "Hardware performance counters are not available: %s. "
+                            "Check /proc/sys/kernel/perf_event_paranoid.", strerror( errno ) );
+                    }
+                    closeCounters();
+                    return false;
+                }
+            }
+
+            if( 0 != ioctl( perfFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP ) )
+            {
+                closeCounters();
+                return false;
+            }
+
+            counters = (uint64(*)[PC_COUNT])HeapMemory::alloc( sizeof(uint64) * PC_COUNT * EVENT_BUFFER_SIZE );
+            return NULL != counters;
+#else
+            return false;
+#endif
+        }
+
+        void closeCounters()
+        {
+#if GN_PROFILER_HAS_PERF_EVENT
+            for( size_t i = 0; i < PC_COUNT; ++i )
+            {
+                if( perfFds[i] >= 0 ) close( perfFds[i] );
+                perfFds[i] = -1;
+            }
+#endif
+            // Note: counter buffer is kept, since events in the buffer may still refer to it.
+        }
+
+        /// Read hardware counters of calling thread. Return false if not available.
+        bool readCounters( uint64 * values )
+        {
+            if( 0 == perfState ) perfState = openCounters() ? 1 : -1;
+            if( perfState < 0 ) return false;
+#if GN_PROFILER_HAS_PERF_EVENT
+            struct { uint64 nr; uint64 values[PC_COUNT]; } group;
+            if( sizeof(group) != read( perfFds[0], &group, sizeof(group) ) || PC_COUNT != group.nr ) return false;
+            memcpy( values, group.values, sizeof(group.values) );
+            return true;
+#else
+            GN_UNUSED_PARAM( values );
+            return false;
+#endif
+        }
+
+        /// called by the owner thread
+        void push( uint32 timerId, ProfilerEventType type, sint64 time, const uint64 * eventCounters = NULL )
+        {
+            size_t w = writePos.load( std::memory_order_relaxed );
+            size_t r = readPos.load( std::memory_order_acquire );
+            size_t needed = gapPending ? 2 : 1;
+            if( EVENT_BUFFER_SIZE - ( w - r ) < needed )
+            {
+                dropped.store( dropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+                gapPending = true;
+                return;
+            }
+            if( gapPending )
+            {
+                ProfilerEvent & gap = events[w & (EVENT_BUFFER_SIZE-1)];
+                gap.timerId = INVALID_TIMER;
+                gap.type = PET_GAP;
+                gap.time = time;
+                ++w;
+                gapPending = false;
+            }
+            ProfilerEvent & e = events[w & (EVENT_BUFFER_SIZE-1)];
+            e.timerId = timerId;
+            e.type = type;
+            e.time = time;
+            if( eventCounters && counters )
+            {
+                memcpy( counters[w & (EVENT_BUFFER_SIZE-1)], eventCounters, sizeof(uint64) * PC_COUNT );
+                e.type |= PET_HAS_COUNTERS;
+            }
+            writePos.store( w + 1, std::memory_order_release );
+        }
+
+        /// called by the owner thread. Return NULL if timer id is out of range.
+        FlatStat * flatStat( uint32 timerId )
+        {
+            size_t c = timerId / FLAT_CHUNK_SIZE;
+            if( c >= MAX_FLAT_CHUNKS ) return NULL;
+            FlatChunk * chunk = flat[c].load( std::memory_order_relaxed );
+            if( NULL == chunk )
+            {
+                chunk = new FlatChunk;
+                for( size_t i = 0; i < FLAT_CHUNK_SIZE; ++i )
+                {
+                    FlatStat & s = chunk->stats[i];
+                    s.count = 0;
+                    s.sum = 0;
+                    s.min = LLONG_MAX;
+                    s.max = 0;
+                    s.start = 0;
+                }
+                flat[c].store( chunk, std::memory_order_release );
+            }
+            return &chunk->stats[timerId % FLAT_CHUNK_SIZE];
+        }
+    };
+
+    ///
+    /// Process-wide profiler state: timer registry, per-thread data and the aggregator thread.
+    ///
+    struct ProfilerCore
+    {
+        std::mutex                        mutex;
+        std::vector<ProfileTimer*>        timers; ///< indexed by timer id
+        std::vector<ProfilerThreadData*>  threads;
+        uint32                            nextThreadId;
+        std::atomic<uint64>               frameCount;
+        std::atomic<uint64>               lostEvents; ///< dropped events of exited threads
+        std::vector<StrA>                 threadNames; ///< indexed by thread id
+
+        // timeline trace
+        TraceMode                         traceMode;
+        sint64                            traceWindow; ///< in cycles, for TM_FLIGHT_RECORDER
+        std::deque<TraceEvent>            trace;
+
+        // slow frame dump
+        std::atomic<sint64>               frameStart;
+        double                            slowFrameThreshold;
+        StrA                              slowFrameDumpPrefix;
+        TraceFormat                       slowFrameDumpFormat;
+
+        // histogram rolling window
+        double                            histogramWindow; ///< in seconds
+        sint64                            histogramWindowStart;
+
+        std::thread                       thread;
+        std::mutex                        wakeMutex;
+        std::condition_variable           wake;
+        bool                              quit;
+
+        static double secondsPerCycle() { return 1.0 / (double)Clock::sGetSystemCycleFrequency(); }
+
+        ProfilerCore()
+            : nextThreadId(0)
+            , frameCount(0)
+            , lostEvents(0)
+            , traceMode(TM_OFF)
+            , traceWindow(0)
+            , frameStart(0)
+            , slowFrameThreshold(0)
+            , slowFrameDumpFormat(TF_CHROME_JSON)
+            , histogramWindow( 1.0 )
+            , histogramWindowStart( Clock::sGetSystemCycleCount() )
+            , quit(false)
+        {
+        }
+
+        ~ProfilerCore()
+        {
+            if( thread.joinable() )
+            {
+                {
+                    std::lock_guard<std::mutex> lock( wakeMutex );
+                    quit = true;
+                }
+                wake.notify_one();
+                thread.join();
+            }
+            for( ProfilerThreadData * t : threads ) delete t;
+        }
+
+        uint32 registerTimer( ProfileTimer * t )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            timers.push_back( t );
+            return (uint32)( timers.size() - 1 );
+        }
+
+        void unregisterTimer( uint32 id )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            if( id < timers.size() ) timers[id] = NULL;
+        }
+
+        ProfileTimer * getTimer( uint32 id ) const
+        {
+            return id < timers.size() ? timers[id] : NULL;
+        }
+
+        ProfilerThreadData * createThreadData()
+        {
+            ProfilerThreadData * t = new ProfilerThreadData;
+            std::lock_guard<std::mutex> lock( mutex );
+            t->threadId = nextThreadId++;
+            threadNames.push_back( StrA() );
+            threads.push_back( t );
+            if( !thread.joinable() ) thread = std::thread( [this]{ threadProc(); } );
+            return t;
+        }
+
+        /// Drain all threads. Caller must hold the mutex.
+        void aggregateLocked()
+        {
+            for( size_t i = 0; i < threads.size(); )
+            {
+                ProfilerThreadData * t = threads[i];
+                drain( *t );
+                mergeFlat( *t );
+                if( t->orphaned && t->readPos.load() == t->writePos.load() )
+                {
+                    // Note: call tree of exited thread is discarded.
+                    lostEvents += t->dropped;
+                    delete t;
+                    threads.erase( threads.begin() + i );
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+
+            // rotate histogram windows
+            sint64 now = Clock::sGetSystemCycleCount();
+            if( (double)( now - histogramWindowStart ) * secondsPerCycle() >= histogramWindow )
+            {
+                for( ProfileTimer * t : timers )
+                {
+                    if( NULL == t || NULL == t->mHistograms ) continue;
+                    t->mHistograms->last = t->mHistograms->current;
+                    t->mHistograms->current.clear();
+                }
+                histogramWindowStart = now;
+            }
+
+            // discard events that are out of flight recorder window.
+            if( TM_FLIGHT_RECORDER == traceMode && !trace.empty() )
+            {
+                sint64 oldest = trace.back().time - traceWindow;
+                while( trace.front().time < oldest ) trace.pop_front();
+            }
+        }
+
+        void resetLocked()
+        {
+            for( ProfileTimer * t : timers )
+            {
+                if( NULL == t ) continue;
+                t->mCount = 0;
+                t->mSum = 0;
+                t->mMin = DBL_MAX;
+                t->mMax = 0;
+                for( size_t c = 0; c < PC_COUNT; ++c ) t->mCounters[c] = 0;
+                t->mElements = 0;
+                if( t->mHistograms )
+                {
+                    t->mHistograms->total.clear();
+                    t->mHistograms->current.clear();
+                    t->mHistograms->last.clear();
+                }
+            }
+            histogramWindowStart = Clock::sGetSystemCycleCount();
+            for( ProfilerThreadData * t : threads )
+            {
+                drain( *t );
+                mergeFlat( *t );
+                t->resetTree();
+            }
+        }
+
+        void updateTimer( uint32 timerId, uint64 count, sint64 sum, sint64 min, sint64 max )
+        {
+            ProfileTimer * timer = getTimer( timerId );
+            if( NULL == timer || 0 == count ) return;
+            double dmin = (double)min * secondsPerCycle();
+            double dmax = (double)max * secondsPerCycle();
+            timer->mCount += count;
+            timer->mSum += (double)sum * secondsPerCycle();
+            if( dmin < timer->mMin ) timer->mMin = dmin;
+            if( dmax > timer->mMax ) timer->mMax = dmax;
+        }
+
+        void recordHistogram( uint32 timerId, sint64 cycles )
+        {
+            ProfileTimer * timer = getTimer( timerId );
+            if( NULL == timer ) return;
+            if( NULL == timer->mHistograms ) timer->mHistograms = new ProfileTimer::Histograms;
+            uint64 ns = cycles > 0 ? (uint64)( (double)cycles * secondsPerCycle() * 1e9 ) : 0;
+            timer->mHistograms->total.record( ns );
+            timer->mHistograms->current.record( ns );
+        }
+
+        uint32 findOrAddChild( ProfilerThreadData & t, uint32 parent, uint32 timerId )
+        {
+            uint32 last = 0;
+            for( uint32 c = t.tree[parent].firstChild; 0 != c; c = t.tree[c].nextSibling )
+            {
+                if( t.tree[c].timerId == timerId ) return c;
+                last = c;
+            }
+            CallNode n = { timerId, parent, 0, 0, 0, 0, 0, LLONG_MAX, 0, {} };
+            uint32 index = (uint32)t.tree.size();
+            t.tree.append( n );
+            if( 0 == last ) t.tree[parent].firstChild = index; else t.tree[last].nextSibling = index;
+            return index;
+        }
+
+        void drain( ProfilerThreadData & t )
+        {
+            size_t r = t.readPos.load( std::memory_order_relaxed );
+            size_t w = t.writePos.load( std::memory_order_acquire );
+            for( ; r != w; ++r )
+            {
+                const ProfilerEvent & e = t.events[r & (EVENT_BUFFER_SIZE-1)];
+                const uint64 * eventCounters = ( e.type & PET_HAS_COUNTERS ) ? t.counters[r & (EVENT_BUFFER_SIZE-1)] : NULL;
+                uint32 type = e.type & PET_TYPE_MASK;
+
+                if( TM_FLIGHT_RECORDER == traceMode || ( TM_RECORD == traceMode && trace.size() < MAX_RECORD_EVENTS ) )
+                {
+                    TraceEvent te = { e.time, e.timerId, t.threadId, type };
+                    trace.push_back( te );
+                }
+
+                switch( type )
+                {
+                    case PET_BEGIN:
+                    {
+                        uint32 parent = t.stack.empty() ? 0 : t.stack.back().node;
+                        StackEntry s = { findOrAddChild( t, parent, e.timerId ), e.time, NULL != eventCounters, {} };
+                        if( eventCounters ) memcpy( s.counters, eventCounters, sizeof(s.counters) );
+                        t.stack.append( s );
+                        break;
+                    }
+
+                    case PET_END:
+                    {
+                        // find matching begin. Unmatched end event is ignored.
+                        size_t i = t.stack.size();
+                        while( i > 0 && t.tree[t.stack[i-1].node].timerId != e.timerId ) --i;
+                        if( 0 == i ) break;
+                        StackEntry s = t.stack[i-1];
+                        t.stack.resize( i - 1 );
+
+                        sint64 d = e.time - s.start;
+                        CallNode & n = t.tree[s.node];
+                        ++n.count;
+                        n.inclusive += d;
+                        if( d < n.min ) n.min = d;
+                        if( d > n.max ) n.max = d;
+                        t.tree[n.parent].children += d;
+                        updateTimer( e.timerId, 1, d, d, d );
+                        recordHistogram( e.timerId, d );
+
+                        if( s.hasCounters && eventCounters )
+                        {
+                            ProfileTimer * timer = getTimer( e.timerId );
+                            for( size_t c = 0; c < PC_COUNT; ++c )
+                            {
+                                uint64 delta = eventCounters[c] - s.counters[c];
+                                n.counters[c] += delta;
+                                if( timer ) timer->mCounters[c] += delta;
+                            }
+                        }
+                        break;
+                    }
+
+                    default:
+                        // lost events: open scopes can't be closed correctly anymore.
+                        t.stack.clear();
+                        break;
+                }
+            }
+            t.readPos.store( r, std::memory_order_release );
+        }
+
+        void mergeFlat( ProfilerThreadData & t )
+        {
+            for( size_t c = 0; c < MAX_FLAT_CHUNKS; ++c )
+            {
+                FlatChunk * chunk = t.flat[c].load( std::memory_order_acquire );
+                if( NULL == chunk ) continue;
+                FlatMerged zero = { 0, 0 };
+                while( t.merged.size() < ( c + 1 ) * FLAT_CHUNK_SIZE ) t.merged.append( zero );
+                for( size_t i = 0; i < FLAT_CHUNK_SIZE; ++i )
+                {
+                    const FlatStat & s = chunk->stats[i];
+                    FlatMerged & m = t.merged[c * FLAT_CHUNK_SIZE + i];
+                    uint64 count = s.count.load( std::memory_order_relaxed );
+                    if( count == m.count ) continue;
+                    sint64 sum = s.sum.load( std::memory_order_relaxed );
+                    updateTimer( (uint32)( c * FLAT_CHUNK_SIZE + i ), count - m.count, sum - m.sum, s.min, s.max );
+                    m.count = count;
+                    m.sum = sum;
+                }
+            }
+        }
+
+        void threadProc()
+        {
+            for(;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock( wakeMutex );
+                    wake.wait_for( lock, std::chrono::milliseconds(10), [this]{ return quit; } );
+                    if( quit ) break;
+                }
+                std::lock_guard<std::mutex> lock( mutex );
+                aggregateLocked();
+            }
+        }
+
+        void appendCallTree( DynaArray<ProfileCallNode> & result, const ProfilerThreadData & t, uint32 index, size_t depth ) const
+        {
+            const CallNode & n = t.tree[index];
+            ProfileCallNode r;
+            if( 0 == index )
+            {
+                r.timer = NULL;
+                r.name = t.name.empty() ? "<unnamed thread>" : t.name.rawptr();
+            }
+            else
+            {
+                r.timer = getTimer( n.timerId );
+                if( NULL == r.timer ) return; // timer is deleted.
+                r.name = r.timer->getName();
+            }
+            r.threadId  = t.threadId;
+            r.depth     = depth;
+            r.count     = n.count;
+            r.inclusive = (double)n.inclusive * secondsPerCycle();
+            r.exclusive = (double)( n.inclusive - n.children ) * secondsPerCycle();
+            r.min       = 0 == n.count ? 0 : (double)n.min * secondsPerCycle();
+            r.max       = (double)n.max * secondsPerCycle();
+            memcpy( r.counters, n.counters, sizeof(r.counters) );
+            if( 0 == index )
+            {
+                // thread root: total time of top-level scopes.
+                r.inclusive = (double)n.children * secondsPerCycle();
+                r.exclusive = 0;
+            }
+            result.append( r );
+
+            for( uint32 c = n.firstChild; 0 != c; c = t.tree[c].nextSibling )
+            {
+                appendCallTree( result, t, c, depth + 1 );
+            }
+        }
+    };
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    static ProfilerCore & sGetCore()
+    {
+        static ProfilerCore sCore;
+        return sCore;
+    }
+
+    static GN_TLS ProfilerThreadData * tThreadData = NULL;
+
+    ///
+    /// Mark thread data as orphaned when thread exits.
+    ///
+    struct ProfilerThreadDataOwner
+    {
+        ProfilerThreadData * data;
+
+        ProfilerThreadDataOwner() : data( sGetCore().createThreadData() ) { tThreadData = data; }
+
+        ~ProfilerThreadDataOwner() { tThreadData = NULL; data->closeCounters(); data->orphaned = true; }
+    };
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    static ProfilerThreadData * sGetThreadData()
+    {
+        ProfilerThreadData * t = tThreadData;
+        if( NULL == t )
+        {
+            static thread_local ProfilerThreadDataOwner sOwner;
+            t = sOwner.data;
+        }
+        return t;
+    }
+}
+
+// *****************************************************************************
+// Trace export
+// *****************************************************************************
+
+namespace GN
+{
+    ///
+    /// Snapshot of captured trace, taken under the core lock so that exporting
+    /// doesn't block the aggregator.
+    ///
+    struct TraceSnapshot
+    {
+        std::vector<TraceEvent> events;      ///< sorted by time, with unmatched end events removed.
+        std::vector<StrA>       timerNames;  ///< indexed by timer id
+        std::vector<StrA>       threadNames; ///< indexed by thread id
+        sint64                  baseTime;
+        double                  nsPerCycle;
+
+        const char * timerName( uint32 id ) const
+        {
+            return ( id < timerNames.size() && !timerNames[id].empty() ) ? timerNames[id].rawptr() : "<unknown>";
+        }
+
+        double toNs( sint64 time ) const { return (double)( time - baseTime ) * nsPerCycle; }
+    };
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    static void sTakeTraceSnapshot( TraceSnapshot & snapshot )
+    {
+        ProfilerCore & core = sGetCore();
+        {
+            std::lock_guard<std::mutex> lock( core.mutex );
+            core.aggregateLocked();
+            snapshot.events.assign( core.trace.begin(), core.trace.end() );
+            snapshot.threadNames = core.threadNames;
+            snapshot.timerNames.resize( core.timers.size() );
+            for( size_t i = 0; i < core.timers.size(); ++i )
+            {
+                if( core.timers[i] ) snapshot.timerNames[i] = core.timers[i]->getName();
+            }
+            if( TM_FLIGHT_RECORDER == core.traceMode && !snapshot.events.empty() )
+            {
+                // events are only roughly trimmed by the aggregator.
+                sint64 newest = LLONG_MIN;
+                for( const TraceEvent & e : snapshot.events ) if( e.time > newest ) newest = e.time;
+                sint64 oldest = newest - core.traceWindow;
+                snapshot.events.erase(
+                    std::remove_if( snapshot.events.begin(), snapshot.events.end(), [=]( const TraceEvent & e ) { return e.time < oldest; } ),
+                    snapshot.events.end() );
+            }
+        }
+
+        std::stable_sort( snapshot.events.begin(), snapshot.events.end(),
+            []( const TraceEvent & a, const TraceEvent & b ) { return a.time < b.time; } );
+
+        // remove end events whose begin is not captured.
+        std::vector<std::vector<uint32>> stacks( snapshot.threadNames.size() );
+        size_t count = 0;
+        for( const TraceEvent & e : snapshot.events )
+        {
+            if( e.threadId >= stacks.size() ) stacks.resize( e.threadId + 1 );
+            std::vector<uint32> & stack = stacks[e.threadId];
+            if( PET_BEGIN == e.type )
+            {
+                stack.push_back( e.timerId );
+            }
+            else if( PET_END == e.type )
+            {
+                auto i = std::find( stack.rbegin(), stack.rend(), e.timerId );
+                if( stack.rend() == i ) continue;
+                stack.resize( stack.size() - ( i - stack.rbegin() ) - 1 );
+            }
+            else
+            {
+                stack.clear();
+            }
+            snapshot.events[count++] = e;
+        }
+        snapshot.events.resize( count );
+
+        snapshot.baseTime = snapshot.events.empty() ? 0 : snapshot.events.front().time;
+        snapshot.nsPerCycle = 1e9 / (double)Clock::sGetSystemCycleFrequency();
+    }
+
+    ///
+    /// Buffered file writer
+    ///
+    struct TraceWriter
+    {
+        File        & file;
+        std::string buffer; // Note: StrA can't hold binary data.
+        bool        ok;
+
+        TraceWriter( File & f ) : file(f), ok(true) {}
+
+        void append( const char * s, size_t len )
+        {
+            buffer.append( s, len );
+            if( buffer.size() >= 64 * 1024 ) flush();
+        }
+
+        void append( const char * s ) { append( s, str::length( s ) ); }
+
+        void append( const StrA & s ) { append( s.rawptr(), s.size() ); }
+
+        bool flush()
+        {
+            if( ok && !buffer.empty() ) ok = file.write( buffer.data(), buffer.size(), NULL );
+            buffer.clear();
+            return ok;
+        }
+    };
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    static void sAppendJsonString( TraceWriter & w, const char * s )
+    {
+        w.append( "\"", 1 );
+        for( ; *s; ++s )
+        {
+            char c = *s;
+            if( '"' == c || '\\' == c )
+            {
+                char esc[2] = { '\\', c };
+                w.append( esc, 2 );
+            }
+            else if( (unsigned char)c < 0x20 )
+            {
+                w.append( str::format( "\\u%04x", (unsigned int)c ) );
+            }
+            else
+            {
+                w.append( &c, 1 );
+            }
+        }
+        w.append( "\"", 1 );
+    }
+
+    //
+    // Chrome trace event format: https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+    // -------------------------------------------------------------------------
+    static bool sWriteChromeJson( File & file, const TraceSnapshot & snapshot )
+    {
+        TraceWriter w( file );
+
+        w.append( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+        bool first = true;
+        for( size_t i = 0; i < snapshot.threadNames.size(); ++i )
+        {
+            StrA name = snapshot.threadNames[i].empty() ? str::format( "thread %u", (uint32)i ) : snapshot.threadNames[i];
+            w.append( str::format( "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", (uint32)i + 1 ) );
+            sAppendJsonString( w, name.rawptr() );
+            w.append( "}}" );
+            first = false;
+        }
+
+        for( const TraceEvent & e : snapshot.events )
+        {
+            const char * ph = PET_BEGIN == e.type ? "B" : PET_END == e.type ? "E" : "i";
+            w.append( str::format( "%s{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":",
+                first ? "" : ",\n", ph, e.threadId + 1, snapshot.toNs( e.time ) / 1000.0 ) );
+            sAppendJsonString( w, PET_GAP == e.type ? "<events lost>" : snapshot.timerName( e.timerId ) );
+            if( PET_GAP == e.type ) w.append( ",\"s\":\"t\"" );
+            w.append( "}" );
+            first = false;
+        }
+
+        w.append( "\n]}\n" );
+
+        return w.flush();
+    }
+
+    ///
+    /// Minimal protobuf encoder
+    ///
+    struct ProtoBuffer
+    {
+        std::string data;
+
+        void varint( uint64 v )
+        {
+            while( v >= 0x80 ) { data.push_back( (char)( ( v & 0x7F ) | 0x80 ) ); v >>= 7; }
+            data.push_back( (char)v );
+        }
+
+        void field( uint32 id, uint64 v ) { varint( id << 3 ); varint( v ); }
+
+        void field( uint32 id, const char * s, size_t len ) { varint( ( id << 3 ) | 2 ); varint( len ); data.append( s, len ); }
+
+        void field( uint32 id, const char * s ) { field( id, s, str::length( s ) ); }
+
+        void field( uint32 id, const ProtoBuffer & m ) { field( id, m.data.data(), m.data.size() ); }
+    };
+
+    //
+    // Perfetto trace format: https://perfetto.dev/docs/reference/trace-packet-proto
+    // -------------------------------------------------------------------------
+    static bool sWritePerfetto( File & file, const TraceSnapshot & snapshot )
+    {
+        // field numbers from perfetto protos
+        enum
+        {
+            TRACE_PACKET = 1,
+
+            PACKET_TIMESTAMP = 8,
+            PACKET_SEQUENCE_ID = 10,
+            PACKET_TRACK_EVENT = 11,
+            PACKET_TRACK_DESCRIPTOR = 60,
+
+            TRACK_UUID = 1,
+            TRACK_PROCESS = 3,
+            TRACK_THREAD = 4,
+
+            PROCESS_PID = 1,
+            PROCESS_NAME = 6,
+
+            THREAD_PID = 1,
+            THREAD_TID = 2,
+            THREAD_NAME = 5,
+
+            EVENT_TYPE = 9,
+            EVENT_TRACK_UUID = 11,
+            EVENT_NAME = 23,
+
+            TYPE_SLICE_BEGIN = 1,
+            TYPE_SLICE_END = 2,
+            TYPE_INSTANT = 3,
+
+            PID = 1,
+            PROCESS_UUID = 1,
+            THREAD_UUID_BASE = 100,
+            SEQUENCE_ID = 1,
+        };
+
+        TraceWriter w( file );
+
+        auto writePacket = [&]( const ProtoBuffer & packet )
+        {
+            ProtoBuffer p;
+            p.field( TRACE_PACKET, packet );
+            w.append( p.data.data(), p.data.size() );
+        };
+
+        // process and thread tracks
+        {
+            ProtoBuffer process, track, packet;
+            process.field( PROCESS_PID, (uint64)PID );
+            process.field( PROCESS_NAME, "garnet" );
+            track.field( TRACK_UUID, (uint64)PROCESS_UUID );
+            track.field( TRACK_PROCESS, process );
+            packet.field( PACKET_TRACK_DESCRIPTOR, track );
+            writePacket( packet );
+        }
+        for( size_t i = 0; i < snapshot.threadNames.size(); ++i )
+        {
+            StrA name = snapshot.threadNames[i].empty() ? str::format( "thread %u", (uint32)i ) : snapshot.threadNames[i];
+            ProtoBuffer thread, track, packet;
+            thread.field( THREAD_PID, (uint64)PID );
+            thread.field( THREAD_TID, (uint64)i + 1 );
+            thread.field( THREAD_NAME, name.rawptr(), name.size() );
+            track.field( TRACK_UUID, (uint64)THREAD_UUID_BASE + i );
+            track.field( TRACK_THREAD, thread );
+            packet.field( PACKET_TRACK_DESCRIPTOR, track );
+            writePacket( packet );
+        }
+
+        for( const TraceEvent & e : snapshot.events )
+        {
+            ProtoBuffer event, packet;
+            if( PET_BEGIN == e.type )
+            {
+                event.field( EVENT_TYPE, (uint64)TYPE_SLICE_BEGIN );
+                event.field( EVENT_NAME, snapshot.timerName( e.timerId ) );
+            }
+            else if( PET_END == e.type )
+            {
+                event.field( EVENT_TYPE, (uint64)TYPE_SLICE_END );
+            }
+            else
+            {
+                event.field( EVENT_TYPE, (uint64)TYPE_INSTANT );
+                event.field( EVENT_NAME, "<events lost>" );
+            }
+            event.field( EVENT_TRACK_UUID, (uint64)THREAD_UUID_BASE + e.threadId );
+
+            packet.field( PACKET_TIMESTAMP, (uint64)snapshot.toNs( e.time ) );
+            packet.field( PACKET_SEQUENCE_ID, (uint64)SEQUENCE_ID );
+            packet.field( PACKET_TRACK_EVENT, event );
+            writePacket( packet );
+        }
+
+        return w.flush();
+    }
+}
+
 // *****************************************************************************
 // Profile Timer
 // *****************************************************************************
@@ -26,15 +1110,17 @@ static GN::StrA sTime2Str( double time )
 //
 //
 // -----------------------------------------------------------------------------
-GN_API GN::ProfileTimer::ProfileTimer( Clock & c )
-    : clock(c)
-    , count(0)
-    , timesum(0)
-    , timemin( DBL_MAX )
-    , timemax( 0 )
-    , timestart(0)
-    , impl(NULL)
+GN_API GN::ProfileTimer::ProfileTimer( const char * name )
+    : mName(name)
+    , mCount(0)
+    , mSum(0)
+    , mMin( DBL_MAX )
+    , mMax( 0 )
+    , mHistograms( NULL )
+    , mElements( 0 )
 {
+    for( size_t i = 0; i < PC_COUNT; ++i ) mCounters[i] = 0;
+    mId = sGetCore().registerTimer( this );
 }
 
 //
@@ -42,6 +1128,87 @@ GN_API GN::ProfileTimer::ProfileTimer( Clock & c )
 // -----------------------------------------------------------------------------
 GN_API GN::ProfileTimer::~ProfileTimer()
 {
+    sGetCore().unregisterTimer( mId );
+    delete mHistograms;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::ProfileTimer::getCount() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return mCount;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileTimer::getSum() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return mSum;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileTimer::getMin() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return 0 == mCount ? 0 : mMin;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileTimer::getMax() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return mMax;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileTimer::getAverage() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return 0 == mCount ? 0 : mSum / (double)mCount;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::ProfileTimer::getCounter( ProfileCounter c ) const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return mCounters[c];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfileTimer::getIpc() const
+{
+    std::lock_guard<std::mutex> lock( sGetCore().mutex );
+    return 0 == mCounters[PC_CYCLES] ? 0 : (double)mCounters[PC_INSTRUCTIONS] / (double)mCounters[PC_CYCLES];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::ProfileTimer::getHistogram( ProfileHistogram & result, ProfileHistogramRange range ) const
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    if( NULL == mHistograms )
+    {
+        result.clear();
+        return false;
+    }
+    result = PHR_LAST_WINDOW == range ? mHistograms->last : mHistograms->total;
+    return result.getCount() > 0;
 }
 
 //
@@ -49,7 +1216,28 @@ GN_API GN::ProfileTimer::~ProfileTimer()
 // -----------------------------------------------------------------------------
 GN_API void GN::ProfileTimer::start()
 {
-    timestart = clock.getTimeD();
+    int mode = sMode.load( std::memory_order_relaxed );
+    if( PM_OFF == mode ) return;
+
+    ProfilerThreadData * t = sGetThreadData();
+    sint64 now = Clock::sGetSystemCycleCount();
+    if( PM_FULL == mode )
+    {
+        uint64 counters[PC_COUNT];
+        if( sHardwareCounters.load( std::memory_order_relaxed ) && t->readCounters( counters ) )
+        {
+            t->push( mId, PET_BEGIN, now, counters );
+        }
+        else
+        {
+            t->push( mId, PET_BEGIN, now );
+        }
+    }
+    else
+    {
+        FlatStat * s = t->flatStat( mId );
+        if( s ) s->start = now;
+    }
 }
 
 //
@@ -57,18 +1245,48 @@ GN_API void GN::ProfileTimer::start()
 // -----------------------------------------------------------------------------
 GN_API void GN::ProfileTimer::stop()
 {
-    double t = clock.getTimeD() - timestart;
-    if( t < timemin ) timemin = t;
-    if( t > timemax ) timemax = t;
-    timesum += t;
-    timestart = 0;
-    ++count;
+    int mode = sMode.load( std::memory_order_relaxed );
+    if( PM_OFF == mode ) return;
+
+    if( PM_FULL == mode )
+    {
+        // read counters first, to keep cost of reading them out of the measured time.
+        uint64 counters[PC_COUNT];
+        bool hasCounters = sHardwareCounters.load( std::memory_order_relaxed ) && sGetThreadData()->readCounters( counters );
+        sint64 now = Clock::sGetSystemCycleCount();
+        sGetThreadData()->push( mId, PET_END, now, hasCounters ? counters : NULL );
+    }
+    else
+    {
+        sint64 now = Clock::sGetSystemCycleCount();
+        ProfilerThreadData * t = sGetThreadData();
+        FlatStat * s = t->flatStat( mId );
+        if( NULL == s || 0 == s->start ) return;
+        sint64 d = now - s->start;
+        s->start = 0;
+        s->count.store( s->count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        s->sum.store( s->sum.load( std::memory_order_relaxed ) + d, std::memory_order_relaxed );
+        if( d < s->min.load( std::memory_order_relaxed ) ) s->min.store( d, std::memory_order_relaxed );
+        if( d > s->max.load( std::memory_order_relaxed ) ) s->max.store( d, std::memory_order_relaxed );
+    }
 }
 
 // *****************************************************************************
 // Profile Manager
 // *****************************************************************************
 
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::ProfilerManager::ProfilerManager()
+{
+    // make sure the core outlives the manager.
+    sGetCore();
+
+    const char * perf = getenv( "GN_PROFILER_PERF" );
+    if( perf && 0 == str::compare( perf, "1" ) ) sEnableHardwareCounters( true );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -80,6 +1298,283 @@ GN_API GN::ProfilerManager::~ProfilerManager()
     toString( s );
     printf( "%s\n", s.rawptr() );
 #endif
+
+    for( TimerMap::KeyValuePair * p = mTimers.first(); NULL != p; p = mTimers.next( p ) )
+    {
+        delete p->value;
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::reset()
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.resetLocked();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::ProfileTimer & GN::ProfilerManager::getTimer( const StrA & name )
+{
+    GN_ASSERT( !name.empty() );
+
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    ProfilerTimerImpl ** p = mTimers.find( name.rawptr() );
+    if( NULL != p ) return **p;
+
+    // create new timer. Note that timer name points to the key stored in the map.
+    TimerMap::KeyValuePair * kv = mTimers.insert( name.rawptr(), NULL );
+    kv->value = new ProfilerTimerImpl( kv->key );
+    return *kv->value;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::aggregate() const
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.aggregateLocked();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::getCallTree( DynaArray<ProfileCallNode> & result ) const
+{
+    result.clear();
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.aggregateLocked();
+    for( const ProfilerThreadData * t : core.threads )
+    {
+        core.appendCallTree( result, *t, 0, 0 );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::setHistogramWindow( double seconds )
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.histogramWindow = seconds;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::sSetMode( ProfilerMode mode )
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.aggregateLocked();
+    // scopes opened in the previous mode won't be closed properly.
+    for( ProfilerThreadData * t : core.threads ) t->stack.clear();
+    sMode = mode;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::ProfilerMode GN::ProfilerManager::sGetMode()
+{
+    return (ProfilerMode)sMode.load();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::nextFrame()
+{
+    ProfilerCore & core = sGetCore();
+    ProfileTimer * frame = mFrameTimer.load( std::memory_order_acquire );
+    if( NULL == frame )
+    {
+        frame = &getTimer( "Frame" );
+        mFrameTimer.store( frame, std::memory_order_release );
+    }
+    uint64 frameIndex = core.frameCount++;
+    if( frameIndex > 0 ) frame->stop();
+
+    sint64 now = Clock::sGetSystemCycleCount();
+    sint64 last = core.frameStart.exchange( now );
+    if( frameIndex > 0 && core.slowFrameThreshold > 0 && TM_OFF != core.traceMode &&
+        (double)( now - last ) * ProfilerCore::secondsPerCycle() > core.slowFrameThreshold )
+    {
+        StrA filename = str::format( "%s%llu%s",
+            core.slowFrameDumpPrefix.rawptr(),
+            frameIndex,
+            TF_PERFETTO == core.slowFrameDumpFormat ? ".perfetto-trace" : ".json" );
+        if( saveTrace( filename, core.slowFrameDumpFormat ) )
+        {
+            GN_INFO(sLogger)( "Frame %llu takes %fms. Trace is saved to %s.",
+                frameIndex, (double)( now - last ) * ProfilerCore::secondsPerCycle() * 1000.0, filename.rawptr() );
+        }
+
+        // time spent on the dump doesn't belong to the next frame.
+        core.frameStart = Clock::sGetSystemCycleCount();
+    }
+
+    frame->start();
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API uint64 GN::ProfilerManager::getFrameCount() const
+{
+    return sGetCore().frameCount;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::startTrace( TraceMode mode, double flightRecorderSeconds )
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    // events generated before this point are not captured.
+    core.aggregateLocked();
+    core.trace.clear();
+    core.traceWindow = (sint64)( flightRecorderSeconds * (double)Clock::sGetSystemCycleFrequency() );
+    core.traceMode = mode;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::stopTrace()
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.aggregateLocked();
+    core.traceMode = TM_OFF;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::TraceMode GN::ProfilerManager::getTraceMode() const
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    return core.traceMode;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::ProfilerManager::saveTrace( File & file, TraceFormat format ) const
+{
+    TraceSnapshot snapshot;
+    sTakeTraceSnapshot( snapshot );
+
+    bool ok = TF_PERFETTO == format ? sWritePerfetto( file, snapshot ) : sWriteChromeJson( file, snapshot );
+    if( !ok )
+    {
+        GN_ERROR(sLogger)( "Fail to write trace file." );
+    }
+    return ok;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::ProfilerManager::saveTrace( const StrA & filename, TraceFormat format ) const
+{
+    AutoObjPtr<File> fp( fs::openFile( filename, "wb" ) );
+    if( !fp )
+    {
+        GN_ERROR(sLogger)( "Fail to open trace file %s.", filename.rawptr() );
+        return false;
+    }
+    return saveTrace( *fp, format );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::setSlowFrameDump( double thresholdSeconds, const StrA & prefix, TraceFormat format )
+{
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    core.slowFrameThreshold = thresholdSeconds;
+    core.slowFrameDumpPrefix = prefix;
+    core.slowFrameDumpFormat = format;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::ProfilerManager::sEnableHardwareCounters( bool enable )
+{
+    if( !enable )
+    {
+        sHardwareCounters = false;
+        return true;
+    }
+
+    // check availability on calling thread.
+    uint64 counters[PC_COUNT];
+    if( !sGetThreadData()->readCounters( counters ) ) return false;
+
+    sHardwareCounters = true;
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::ProfilerManager::sIsHardwareCountersEnabled()
+{
+    return sHardwareCounters;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::ProfilerManager::sSetThreadName( const char * name )
+{
+    ProfilerThreadData * t = sGetThreadData();
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> lock( core.mutex );
+    t->name = name;
+    core.threadNames[t->threadId] = name;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API double GN::ProfilerManager::sMeasureScopeOverhead( size_t iterations )
+{
+    if( 0 == iterations ) return 0;
+
+    ProfilerTimerImpl timer( "<overhead>" );
+
+    // make sure thread data is created and event buffer is empty.
+    sGetThreadData();
+    sGetGlobalInstance().aggregate();
+    if( iterations > EVENT_BUFFER_SIZE / 2 ) iterations = EVENT_BUFFER_SIZE / 2;
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    for( size_t i = 0; i < iterations; ++i )
+    {
+        timer.start();
+        timer.stop();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    sGetGlobalInstance().aggregate();
+
+    return std::chrono::duration<double>( end - begin ).count() / (double)iterations;
 }
 
 //
@@ -87,7 +1582,12 @@ GN_API GN::ProfilerManager::~ProfilerManager()
 // -----------------------------------------------------------------------------
 GN_API void GN::ProfilerManager::toString( GN::StrA & rval ) const
 {
-    std::lock_guard<SpinLoop> lock( mMutex );
+    aggregate();
+
+    DynaArray<ProfileCallNode> tree;
+    getCallTree( tree );
+
+    std::lock_guard<std::mutex> lock( mMutex );
 
     if( mTimers.empty() ) { rval = ""; return; }
 
@@ -97,21 +1597,97 @@ GN_API void GN::ProfilerManager::toString( GN::StrA & rval ) const
         "                         profile result\n"
         "---------------------------------------------------------------------\n"
         "\n";
-    const StringMap<char,ProfilerTimerImpl>::KeyValuePair * i;
+    // Read statistics under the core lock, so the aggregator doesn't change them half way.
+    ProfilerCore & core = sGetCore();
+    std::lock_guard<std::mutex> coreLock( core.mutex );
+    const TimerMap::KeyValuePair * i;
     for( i = mTimers.first(); i != NULL; i = mTimers.next( i ) )
     {
-        const ProfilerTimerImpl & t = i->value;
+        const ProfilerTimerImpl & t = *i->value;
         rval += GN::str::format(
             "    %s :\n"
-            "        count(%d), sum(%s), ave(%s), min(%s), max(%s)\n"
-            "\n",
+            "        count(%llu), sum(%s), ave(%s), min(%s), max(%s)\n",
             i->key,
-            t.count,
-            sTime2Str( t.timesum ).rawptr(),
-            sTime2Str( 0 == t.count ? 0 : ( t.timesum / t.count ) ).rawptr(),
-            sTime2Str( 0 == t.count ? 0 : t.timemin ).rawptr(),
-            sTime2Str( 0 == t.count ? 0 : t.timemax ).rawptr() );
+            t.mCount,
+            sTime2Str( t.mSum ).rawptr(),
+            sTime2Str( 0 == t.mCount ? 0 : t.mSum / (double)t.mCount ).rawptr(),
+            sTime2Str( 0 == t.mCount ? 0 : t.mMin ).rawptr(),
+            sTime2Str( t.mMax ).rawptr() );
+        if( t.mHistograms && t.mHistograms->total.getCount() > 0 )
+        {
+            const ProfileHistogram & histogram = t.mHistograms->total;
+            rval += GN::str::format(
+                "        p50(%s), p90(%s), p99(%s), p99.9(%s)\n",
+                sTime2Str( histogram.getPercentile( 50 ) ).rawptr(),
+                sTime2Str( histogram.getPercentile( 90 ) ).rawptr(),
+                sTime2Str( histogram.getPercentile( 99 ) ).rawptr(),
+                sTime2Str( histogram.getPercentile( 99.9 ) ).rawptr() );
+        }
+        const uint64 * counters = t.mCounters;
+        if( counters[PC_CYCLES] > 0 )
+        {
+            rval += GN::str::format(
+                "        cycles(%llu), instructions(%llu), ipc(%.2f), cache-misses(%llu), branch-misses(%llu)\n",
+                counters[PC_CYCLES],
+                counters[PC_INSTRUCTIONS],
+                (double)counters[PC_INSTRUCTIONS] / (double)counters[PC_CYCLES],
+                counters[PC_CACHE_MISSES],
+                counters[PC_BRANCH_MISSES] );
+        }
+        uint64 elements = t.getElements();
+        if( elements > 0 )
+        {
+            double e = (double)elements;
+            rval += GN::str::format( "        elements(%llu), time/element(%s)", elements, sTime2Str( t.mSum / e ).rawptr() );
+            if( counters[PC_CYCLES] > 0 )
+            {
+                rval += GN::str::format(
+                    ", cycles/element(%.1f), cache-misses/element(%.3f), branch-misses/element(%.3f)",
+                    (double)counters[PC_CYCLES] / e,
+                    (double)counters[PC_CACHE_MISSES] / e,
+                    (double)counters[PC_BRANCH_MISSES] / e );
+            }
+            rval += "\n";
+        }
+        rval += "\n";
+    }
+
+    if( !tree.empty() )
+    {
+        rval +=
+            "---------------------------------------------------------------------\n"
+            "                     call tree (inclusive/exclusive)\n"
+            "---------------------------------------------------------------------\n"
+            "\n";
+        for( size_t n = 0; n < tree.size(); ++n )
+        {
+            const ProfileCallNode & c = tree[n];
+            if( 0 == c.depth )
+            {
+                rval += GN::str::format( "    [thread %u] %s\n", c.threadId, c.name );
+                continue;
+            }
+            for( size_t d = 0; d < c.depth; ++d ) rval += "    ";
+            rval += GN::str::format(
+                "%s : count(%llu), incl(%s), excl(%s), max(%s)",
+                c.name,
+                c.count,
+                sTime2Str( c.inclusive ).rawptr(),
+                sTime2Str( c.exclusive ).rawptr(),
+                sTime2Str( c.max ).rawptr() );
+            if( c.counters[PC_CYCLES] > 0 )
+            {
+                rval += GN::str::format(
+                    ", ipc(%.2f), cache-misses(%llu), branch-misses(%llu)",
+                    (double)c.counters[PC_INSTRUCTIONS] / (double)c.counters[PC_CYCLES],
+                    c.counters[PC_CACHE_MISSES],
+                    c.counters[PC_BRANCH_MISSES] );
+            }
+            rval += "\n";
+        }
+        rval += "\n";
     }
+
     rval +=
         "=====================================================================\n"
         "\n";
@@ -0,0 +1,337 @@
+#include "pch.h"
+#include <climits>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#else
+#include <condition_variable>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+using namespace GN;
+
+// max spins before a thread parks itself in the kernel.
+static const sint32 MAX_SPIN_COUNT = 1000;
+
+// spins used by objects that do not adapt their spin count.
+static const sint32 FIXED_SPIN_COUNT = 100;
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+///
+/// Spinning only makes sense when the lock owner could run at the same time.
+///
+static bool sCanSpin()
+{
+    static const bool multiCore = std::thread::hardware_concurrency() > 1;
+    return multiCore;
+}
+
+#if !defined(__linux__)
+
+///
+/// Fallback of futex: threads waiting on addresses that hash to the same bucket share one
+/// condition variable. Wake-ups are broadcast to the bucket, and waiters re-check their value.
+///
+struct ParkingBucket
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    uint32                  waiters = 0;
+};
+
+static ParkingBucket & sGetBucket( const void * addr )
+{
+    static ParkingBucket buckets[64];
+    return buckets[( ( (size_t)addr ) >> 4 ) % GN_ARRAY_COUNT( buckets )];
+}
+
+#endif
+
+// *****************************************************************************
+// wait on address
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::sync::waitOnAddress( std::atomic<uint32> & addr, uint32 expected, TimeInNanoSecond timeout )
+{
+    if( 0 == timeout ) return addr.load( std::memory_order_acquire ) != expected;
+
+#if defined(__linux__)
+    struct timespec ts, * pts = NULL;
+    if( INFINITE_TIME != timeout )
+    {
+        ts.tv_sec  = (time_t)( timeout / 1000000000 );
+        ts.tv_nsec = (long)( timeout % 1000000000 );
+        pts = &ts;
+    }
+    // std::atomic<uint32> has the same layout as uint32.
+    long r = syscall( SYS_futex, (uint32*)&addr, FUTEX_WAIT_PRIVATE, expected, pts, NULL, 0 );
+    return !( -1 == r && ETIMEDOUT == errno );
+#else
+    ParkingBucket & b = sGetBucket( &addr );
+    std::unique_lock<std::mutex> lock( b.mutex );
+    if( addr.load( std::memory_order_acquire ) != expected ) return true;
+    ++b.waiters;
+    bool woken = true;
+    if( INFINITE_TIME == timeout )
+    {
+        b.cond.wait( lock );
+    }
+    else
+    {
+        woken = std::cv_status::no_timeout == b.cond.wait_for( lock, std::chrono::nanoseconds( timeout ) );
+    }
+    --b.waiters;
+    return woken;
+#endif
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::sync::wakeByAddress( std::atomic<uint32> & addr, uint32 count )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, (uint32*)&addr, FUTEX_WAKE_PRIVATE, (int)std::min<uint32>( count, INT_MAX ), NULL, NULL, 0 );
+#else
+    // waking too many is allowed.
+    GN_UNUSED_PARAM( count );
+    wakeAllByAddress( addr );
+#endif
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::sync::wakeAllByAddress( std::atomic<uint32> & addr )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, (uint32*)&addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0 );
+#else
+    ParkingBucket & b = sGetBucket( &addr );
+    // Take the bucket lock so a waiter could not miss the wake-up between checking
+    // the value and starting to wait.
+    std::lock_guard<std::mutex> lock( b.mutex );
+    if( b.waiters > 0 ) b.cond.notify_all();
+#endif
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API void GN::sync::cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__( "yield" );
+#endif
+}
+
+// *****************************************************************************
+// Mutex
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::Mutex::lockSlow()
+{
+    // spin up to twice the recent average before parking.
+    sint32 avg = mSpinCount.load( std::memory_order_relaxed );
+    sint32 maxSpin = sCanSpin() ? std::min( MAX_SPIN_COUNT, avg * 2 + 10 ) : 0;
+    for( sint32 i = 0; i < maxSpin; ++i )
+    {
+        sync::cpuRelax();
+        if( 0 == mState.load( std::memory_order_relaxed ) && tryLock() )
+        {
+            mSpinCount.store( avg + ( i - avg ) / 8, std::memory_order_relaxed );
+            return;
+        }
+    }
+
+    // Park. Mark the lock as contended, so unlock() knows there might be waiters.
+    while( 0 != mState.exchange( 2, std::memory_order_acquire ) )
+    {
+        sync::waitOnAddress( mState, 2 );
+    }
+    mSpinCount.store( avg + ( maxSpin - avg ) / 8, std::memory_order_relaxed );
+}
+
+// *****************************************************************************
+// RWLock
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::RWLock::lockSlow()
+{
+    sint32 spin = sCanSpin() ? FIXED_SPIN_COUNT : 0;
+    for(;;)
+    {
+        uint32 s = mState.load( std::memory_order_relaxed );
+        if( 0 == ( s & ( WRITER_LOCKED | READER_MASK ) ) )
+        {
+            // Keep the waiting flags. They might be stale, which only costs a spurious wake-up.
+            if( mState.compare_exchange_weak( s, s | WRITER_LOCKED, std::memory_order_acquire, std::memory_order_relaxed ) ) return;
+            continue;
+        }
+
+        if( spin > 0 )
+        {
+            --spin;
+            sync::cpuRelax();
+            continue;
+        }
+
+        // Flag writer waiting, which also blocks new readers.
+        if( 0 == ( s & WRITER_WAITING ) &&
+            !mState.compare_exchange_weak( s, s | WRITER_WAITING, std::memory_order_relaxed ) )
+        {
+            continue;
+        }
+        sync::waitOnAddress( mState, s | WRITER_WAITING );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::RWLock::lockSharedSlow()
+{
+    sint32 spin = sCanSpin() ? FIXED_SPIN_COUNT : 0;
+    for(;;)
+    {
+        uint32 s = mState.load( std::memory_order_relaxed );
+        if( 0 == ( s & ( WRITER_LOCKED | WRITER_WAITING ) ) )
+        {
+            GN_ASSERT( ( s & READER_MASK ) < READER_MASK );
+            if( mState.compare_exchange_weak( s, s + 1, std::memory_order_acquire, std::memory_order_relaxed ) ) return;
+            continue;
+        }
+
+        if( spin > 0 )
+        {
+            --spin;
+            sync::cpuRelax();
+            continue;
+        }
+
+        if( 0 == ( s & READER_WAITING ) &&
+            !mState.compare_exchange_weak( s, s | READER_WAITING, std::memory_order_relaxed ) )
+        {
+            continue;
+        }
+        sync::waitOnAddress( mState, s | READER_WAITING );
+    }
+}
+
+// *****************************************************************************
+// Semaphore
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+WaitResult GN::Semaphore::acquire( TimeInNanoSecond timeout )
+{
+    if( tryAcquire() ) return WaitResult::COMPLETED;
+
+    for( sint32 i = sCanSpin() ? FIXED_SPIN_COUNT : 0; i > 0; --i )
+    {
+        sync::cpuRelax();
+        if( tryAcquire() ) return WaitResult::COMPLETED;
+    }
+
+    sync::Deadline deadline( timeout );
+    for(;;)
+    {
+        TimeInNanoSecond remaining = deadline.remaining();
+        if( 0 == remaining ) return tryAcquire() ? WaitResult::COMPLETED : WaitResult::TIMEDOUT;
+
+        mWaiters.fetch_add( 1, std::memory_order_seq_cst );
+        sync::waitOnAddress( mCount, 0, remaining );
+        mWaiters.fetch_sub( 1, std::memory_order_relaxed );
+
+        if( tryAcquire() ) return WaitResult::COMPLETED;
+    }
+}
+
+// *****************************************************************************
+// SyncEvent
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+WaitResult GN::SyncEvent::wait( TimeInNanoSecond timeout ) const
+{
+    sync::Deadline deadline( timeout );
+    sint32 spin = sCanSpin() ? FIXED_SPIN_COUNT : 0;
+    for(;;)
+    {
+        uint32 s = mState.load( std::memory_order_acquire );
+        if( ST_SIGNALED == s )
+        {
+            if( mManualReset ) return WaitResult::COMPLETED;
+            if( mState.compare_exchange_weak( s, ST_UNSIGNALED, std::memory_order_acquire, std::memory_order_relaxed ) ) return WaitResult::COMPLETED;
+            continue;
+        }
+        if( ST_KILLED == s ) return WaitResult::KILLED;
+
+        if( spin > 0 )
+        {
+            --spin;
+            sync::cpuRelax();
+            continue;
+        }
+
+        TimeInNanoSecond remaining = deadline.remaining();
+        if( 0 == remaining ) return WaitResult::TIMEDOUT;
+
+        mWaiters.fetch_add( 1, std::memory_order_seq_cst );
+        sync::waitOnAddress( mState, ST_UNSIGNALED, remaining );
+        mWaiters.fetch_sub( 1, std::memory_order_relaxed );
+    }
+}
+
+// *****************************************************************************
+// Barrier
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::Barrier::arriveAndWait()
+{
+    uint32 gen = mGeneration.load( std::memory_order_acquire );
+
+    if( mArrived.fetch_add( 1, std::memory_order_acq_rel ) + 1 == mCount )
+    {
+        // last one: reset for next phase, then release everyone.
+        mArrived.store( 0, std::memory_order_relaxed );
+        mGeneration.fetch_add( 1, std::memory_order_release );
+        sync::wakeAllByAddress( mGeneration );
+        return true;
+    }
+
+    for( sint32 i = sCanSpin() ? FIXED_SPIN_COUNT : 0; i > 0; --i )
+    {
+        if( gen != mGeneration.load( std::memory_order_acquire ) ) return false;
+        sync::cpuRelax();
+    }
+    while( gen == mGeneration.load( std::memory_order_acquire ) )
+    {
+        sync::waitOnAddress( mGeneration, gen );
+    }
+    return false;
+}
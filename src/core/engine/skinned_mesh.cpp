@@ -913,7 +913,7 @@ bool GN::engine::SkinnedMesh::loadFromFatModel( const GN::gfx::FatModel & fatmod
         {
             // setup mesh descriptor
             MeshResourceDesc merd;
-            memset( &merd, 0, sizeof(merd) );
+            merd.clear();
             merd.prim = fatmesh.primitive;
             merd.numvtx = fatmesh.vertices.getVertexCount();
             merd.numidx = fatmesh.indices.size();
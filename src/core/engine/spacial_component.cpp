@@ -23,7 +23,7 @@ GN::engine::SpacialComponent::SpacialComponent()
     , mSelfBBox( 0, 0, 0, 0, 0, 0 )
     , mLocal2Parent( Matrix44f::sIdentity() )
     , mParent2Local( Matrix44f::sIdentity() )
-    , mLocal2Root( Matrix44f::sIdentity() )
+    , mLocal2Root()
     , mRoot2Local( Matrix44f::sIdentity() )
     , mTransformDirty( false )
     , mBBoxDirty( false )
@@ -125,39 +125,29 @@ void GN::engine::SpacialComponent::calcTransform()
 {
     GN_ASSERT( mTransformDirty );
 
-    // TODO: optimize with SIMD instructions
-
-    Matrix33f r33;
-    Matrix44f r, t, s;
-
     // object will be:
     //
     //  1. scaled in its local space
     //  2. rotated around its local origin
     //  3. moved to localtion defined by "position" in parent space
+    //
+    // The kind of the transformation is tracked, so that the inverses use
+    // the cheapest method.
 
-    mRotation.toMatrix33( r33 );
-    r.set( r33 );
-
-    t.translate( mPosition );
-
-    s.identity();
-    s[0][0] = mScale[0];
-    s[1][1] = mScale[1];
-    s[2][2] = mScale[2];
-
-    mLocal2Parent = t * r * s;
-    mParent2Local = Matrix44f::sInverse( mLocal2Parent );
+    Transformf local2Parent = Transformf::sTRS( mPosition, mRotation, mScale );
+    mLocal2Parent = local2Parent.matrix();
+    mParent2Local = Transformf::sInverse( local2Parent ).matrix();
 
     SpacialComponent * parent = getParent();
     if( parent )
     {
-        mLocal2Root = parent->getLocal2Root() * mLocal2Parent;
-        mRoot2Local = Matrix44f::sInverse( mLocal2Root );
+        parent->validateTransform();
+        mLocal2Root = parent->mLocal2Root * local2Parent;
+        mRoot2Local = Transformf::sInverse( mLocal2Root ).matrix();
     }
     else
     {
-        mLocal2Root = mLocal2Parent;
+        mLocal2Root = local2Parent;
         mRoot2Local = mParent2Local;
     }
 
@@ -192,46 +182,19 @@ void GN::engine::SpacialComponent::calcBoundingBox()
     // gather child bounding boxes
     for( SpacialComponent * child = getFirstChild(); child; child = child->getNextSibling() )
     {
-        const Boxf & childbb = child->getUberBoundingBox();
-
         // translate child bounding box into this component's local space
-        const Matrix44f & mat = child->getLocal2Parent();
-
-        for( int i = 0; i < 8; ++i )
-        {
-            Vector4f v( childbb.corner(i), 1.0f );
-            v = mat * v;
-
-            if( v.x < mUberBBox.x )
-            {
-                mUberBBox.w += mUberBBox.x - v.x;
-                mUberBBox.x = v.x;
-            }
-            else if( v.x > (mUberBBox.x+mUberBBox.w) )
-            {
-                mUberBBox.w = v.x - mUberBBox.x;
-            }
-
-            if( v.y < mUberBBox.y )
-            {
-                mUberBBox.h += mUberBBox.y - v.y;
-                mUberBBox.y = v.y;
-            }
-            else if( v.y > (mUberBBox.y+mUberBBox.h) )
-            {
-                mUberBBox.h = v.y - mUberBBox.y;
-            }
-
-            if( v.z < mUberBBox.z )
-            {
-                mUberBBox.d += mUberBBox.z - v.z;
-                mUberBBox.z = v.z;
-            }
-            else if( v.z > (mUberBBox.z+mUberBBox.d) )
-            {
-                mUberBBox.d = v.z - mUberBBox.z;
-            }
-        }
+        Boxf childbb;
+        transformBoxes( &childbb, child->getLocal2Parent(), &child->getUberBoundingBox(), 1 );
+
+        float x1 = math::getmax( mUberBBox.x + mUberBBox.w, childbb.x + childbb.w );
+        float y1 = math::getmax( mUberBBox.y + mUberBBox.h, childbb.y + childbb.h );
+        float z1 = math::getmax( mUberBBox.z + mUberBBox.d, childbb.z + childbb.d );
+        mUberBBox.x = math::getmin( mUberBBox.x, childbb.x );
+        mUberBBox.y = math::getmin( mUberBBox.y, childbb.y );
+        mUberBBox.z = math::getmin( mUberBBox.z, childbb.z );
+        mUberBBox.w = x1 - mUberBBox.x;
+        mUberBBox.h = y1 - mUberBBox.y;
+        mUberBBox.d = z1 - mUberBBox.z;
     }
 
     mBBoxDirty = false;
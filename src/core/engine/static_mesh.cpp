@@ -179,7 +179,7 @@ bool GN::engine::StaticMesh::loadFromFatModel( const GN::gfx::FatModel & fatmode
         {
             // setup mesh descriptor
             MeshResourceDesc merd;
-            memset( &merd, 0, sizeof(merd) );
+            merd.clear();
             merd.prim = fatmesh.primitive;
             merd.numvtx = fatmesh.vertices.getVertexCount();
             merd.numidx = fatmesh.indices.size();
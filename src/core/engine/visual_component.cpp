@@ -125,8 +125,14 @@ void GN::engine::VisualComponent::clear()
 // -----------------------------------------------------------------------------
 void GN::engine::VisualComponent::draw( const SpacialComponent * sc ) const
 {
-    // update world transformation.
-    if( sc ) updateWorldTransform( sc->getLocal2Root() );
+    if( sc )
+    {
+        // skip components that are completely out of view.
+        if( !isVisible( *sc ) ) return;
+
+        // update world transformation.
+        updateWorldTransform( sc->getLocal2Root() );
+    }
 
     // draw models
     GN_GPU_DEBUG_MARK_BEGIN( getGpu(), "VisualComponent::draw" );
@@ -152,6 +158,28 @@ void GN::engine::VisualComponent::drawModel( size_t modelIndex, const SpacialCom
     GN_GPU_DEBUG_MARK_END( getGpu() );
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::engine::VisualComponent::isVisible( const SpacialComponent & sc ) const
+{
+    const Boxf & bbox = sc.getUberBoundingBox();
+
+    // bounding box is never set. Can't tell.
+    if( 0 == bbox.w && 0 == bbox.h && 0 == bbox.d ) return true;
+
+    GpuResourceDatabase * gdb = getGdb();
+    GN_ASSERT( gdb );
+
+    const Matrix44f pv = *(const Matrix44f *)gdb->getStandardUniformResource(StandardUniform::Index::MATRIX_PV)->uniform()->getval();
+
+    // Test in object space. Use [-w, w] depth range, which is conservative for both
+    // D3D and OpenGL style projections.
+    Frustum frustum;
+    frustum.fromMatrix( pv * sc.getLocal2Root(), false );
+    return frustum.testBox( bbox );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
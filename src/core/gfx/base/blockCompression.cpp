@@ -0,0 +1,2009 @@
+#include "pch.h"
+#include <algorithm>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.blockCompression");
+
+// *****************************************************************************
+// local types
+// *****************************************************************************
+
+namespace
+{
+    typedef BlockCompressionQuality Quality;
+
+    ///
+    /// 4x4 pixels of one block, row major. Channels are 0..255, or -127..127 for SNORM formats.
+    ///
+    struct Pixels
+    {
+        sint32 c[16][4];
+    };
+
+    ///
+    /// pixels of one BC7 subset
+    ///
+    struct PixelList
+    {
+        uint32 count;
+        uint8  pixels[16];
+    };
+
+    ///
+    /// quantized BC7 endpoints of one subset
+    ///
+    struct Bc7Endpoints
+    {
+        sint32 code[2][4];  ///< stored bits, without p-bit
+        sint32 pbit[2];
+        sint32 value[2][4]; ///< 8-bit values, that the decoder reconstructs
+    };
+
+    ///
+    /// layout of one BC7 mode
+    ///
+    struct Bc7Mode
+    {
+        uint32 subsets;
+        uint32 partitionBits;
+        uint32 rotationBits;
+        uint32 indexModeBits;
+        uint32 colorBits;
+        uint32 alphaBits;
+        uint32 endpointPBits; ///< one p-bit per endpoint
+        uint32 sharedPBits;   ///< one p-bit per subset
+        uint32 indexBits;
+        uint32 index2Bits;    ///< bits of the secondary index set, of mode 4 and 5.
+    };
+
+    typedef void (*EncodeBlockFunc)( uint8 * block, const Pixels & px, bool snorm, Quality quality );
+    typedef void (*DecodeBlockFunc)( const uint8 * block, Pixels & px, bool snorm );
+
+    ///
+    /// block codec of one color layout
+    ///
+    struct BlockCodec
+    {
+        ColorFormat::Layout layout;
+        uint32              blockBytes;
+        bool                allowSnorm; ///< BC4 and BC5 could be signed, others could be sRGB
+        EncodeBlockFunc     encode;
+        DecodeBlockFunc     decode;
+    };
+
+    ///
+    /// little endian bit stream writer. The block must be zero initialized.
+    ///
+    struct BitWriter
+    {
+        uint8 * block;
+        uint32  pos;
+
+        BitWriter( uint8 * b ) : block( b ), pos( 0 ) {}
+
+        void write( uint32 value, uint32 bits )
+        {
+            while( bits > 0 )
+            {
+                uint32 n = math::getmin( bits, 8 - ( pos & 7 ) );
+                block[pos >> 3] |= (uint8)( ( value & ( ( 1u << n ) - 1 ) ) << ( pos & 7 ) );
+                value >>= n;
+                pos += n;
+                bits -= n;
+            }
+        }
+    };
+
+    ///
+    /// little endian bit stream reader
+    ///
+    struct BitReader
+    {
+        const uint8 * block;
+        uint32        pos;
+
+        BitReader( const uint8 * b ) : block( b ), pos( 0 ) {}
+
+        uint32 read( uint32 bits )
+        {
+            uint32 value = 0;
+            for( uint32 done = 0; done < bits; )
+            {
+                uint32 n = math::getmin( bits - done, 8 - ( pos & 7 ) );
+                value |= (uint32)( ( block[pos >> 3] >> ( pos & 7 ) ) & ( ( 1u << n ) - 1 ) ) << done;
+                pos += n;
+                done += n;
+            }
+            return value;
+        }
+    };
+}
+
+// *****************************************************************************
+// common utilities
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline sint32 sClamp( sint32 v, sint32 lo, sint32 hi )
+{
+    return v < lo ? lo : ( v > hi ? hi : v );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline sint32 sRound( float v )
+{
+    return (sint32)lrintf( v );
+}
+
+#if GN_SIMD
+
+///
+/// 1 in lanes of channels [first, last), 0 in others.
+// -----------------------------------------------------------------------------
+static inline GN::simd::Float4 sChannelMask( uint32 first, uint32 last )
+{
+    float m[4];
+    for( uint32 c = 0; c < 4; ++c ) m[c] = ( first <= c && c < last ) ? 1.0f : 0.0f;
+    return GN::simd::load( m );
+}
+
+///
+/// Load up to 4 pixels, transposed: ch[c] holds channel c of each pixel. Lanes past "count"
+/// repeat the last pixel.
+// -----------------------------------------------------------------------------
+static inline void sLoadChannels( GN::simd::Float4 ch[4], const Pixels & px, const uint8 * pixels, uint32 count )
+{
+    using namespace GN::simd;
+    for( uint32 j = 0; j < 4; ++j ) ch[j] = toFloat( loadInt( px.c[pixels[j < count ? j : count - 1]] ) );
+    transpose( ch[0], ch[1], ch[2], ch[3] );
+}
+
+///
+/// Nearest palette entry of 4 pixels loaded by sLoadChannels(), in channels [first, last).
+/// Ties go to the lower index. Return indices, and squared distances in "dist".
+// -----------------------------------------------------------------------------
+static inline GN::simd::Int4 sNearest( GN::simd::Float4 & dist, const GN::simd::Float4 ch[4], const float (*pal)[4], uint32 n, uint32 first, uint32 last )
+{
+    using namespace GN::simd;
+    Float4 best = splat( 1e30f ), index = zero();
+    for( uint32 k = 0; k < n; ++k )
+    {
+        Float4 d = zero();
+        for( uint32 c = first; c < last; ++c )
+        {
+            Float4 diff = sub( ch[c], splat( pal[k][c] ) );
+            d = madd( diff, diff, d );
+        }
+        Float4 closer = cmplt( d, best );
+        best = select( closer, d, best );
+        index = select( closer, splat( (float)k ), index );
+    }
+    dist = best;
+    return toInt( index );
+}
+
+#endif // GN_SIMD
+
+///
+/// Mean and covariance matrix of pixels, in channels [first, last). Other channels of both
+/// are zero.
+// -----------------------------------------------------------------------------
+static void sCovariance( float mean[4], float cov[4][4], const Pixels & px, const PixelList & list, uint32 first, uint32 last )
+{
+#if GN_SIMD
+    using namespace GN::simd;
+    Float4 mask = sChannelMask( first, last );
+    Float4 sum = zero();
+    for( uint32 i = 0; i < list.count; ++i ) sum = add( sum, toFloat( loadInt( px.c[list.pixels[i]] ) ) );
+    Float4 m = mul( div( sum, splat( (float)list.count ) ), mask );
+
+    Float4 c0 = zero(), c1 = zero(), c2 = zero(), c3 = zero();
+    for( uint32 i = 0; i < list.count; ++i )
+    {
+        Float4 d = mul( sub( toFloat( loadInt( px.c[list.pixels[i]] ) ), m ), mask );
+        c0 = madd( d, lane<0>( d ), c0 );
+        c1 = madd( d, lane<1>( d ), c1 );
+        c2 = madd( d, lane<2>( d ), c2 );
+        c3 = madd( d, lane<3>( d ), c3 );
+    }
+    store( mean, m );
+    store( cov[0], c0 );
+    store( cov[1], c1 );
+    store( cov[2], c2 );
+    store( cov[3], c3 );
+#else
+    memset( cov, 0, sizeof(float) * 16 );
+    for( uint32 c = 0; c < 4; ++c ) mean[c] = 0;
+    for( uint32 c = first; c < last; ++c )
+    {
+        float sum = 0;
+        for( uint32 i = 0; i < list.count; ++i ) sum += (float)px.c[list.pixels[i]][c];
+        mean[c] = sum / (float)list.count;
+    }
+
+    for( uint32 i = 0; i < list.count; ++i )
+    {
+        const sint32 * p = px.c[list.pixels[i]];
+        float d[4];
+        for( uint32 c = first; c < last; ++c ) d[c] = (float)p[c] - mean[c];
+        for( uint32 a = first; a < last; ++a )
+            for( uint32 b = a; b < last; ++b )
+                cov[a][b] += d[a] * d[b];
+    }
+    for( uint32 a = first; a < last; ++a )
+        for( uint32 b = first; b < a; ++b )
+            cov[a][b] = cov[b][a];
+#endif
+}
+
+#if GN_SIMD
+
+///
+/// Power iteration of a covariance matrix from sCovariance(), started from the column of the
+/// largest variance. The matrix is scaled by its trace, so its eigenvalues are in [0, 1], and
+/// the largest is at least 1/4: the iteration needs no normalization on the way. Return the
+/// trace. If it is zero, "a" and "c" are not set.
+// -----------------------------------------------------------------------------
+static inline float sPowerIteration( GN::simd::Float4 & a, GN::simd::Float4 c[4], const float cov[4][4], uint32 first, uint32 last, uint32 iterations )
+{
+    using namespace GN::simd;
+    float trace = cov[0][0] + cov[1][1] + cov[2][2] + cov[3][3];
+    if( trace <= 0 ) return 0;
+
+    uint32 start = first;
+    for( uint32 k = first; k < last; ++k ) if( cov[k][k] > cov[start][start] ) start = k;
+
+    Float4 scale = splat( 1.0f / trace );
+    for( uint32 k = 0; k < 4; ++k ) c[k] = mul( load( cov[k] ), scale );
+    a = c[start]; // the matrix is symmetric, rows are columns.
+    for( uint32 k = 0; k < iterations; ++k ) a = transformByColumns( c[0], c[1], c[2], c[3], a );
+    return trace;
+}
+
+#endif // GN_SIMD
+
+///
+/// Principal axis of a covariance matrix from sCovariance(), of unit length, or zero if the
+/// matrix is zero. Power iteration, started from the column of the largest variance.
+// -----------------------------------------------------------------------------
+static void sPrincipalAxis( float axis[4], const float cov[4][4], uint32 first, uint32 last, uint32 iterations )
+{
+#if GN_SIMD
+    using namespace GN::simd;
+    Float4 a, c[4];
+    Float4 len2 = zero();
+    if( sPowerIteration( a, c, cov, first, last, iterations ) > 0 ) len2 = dot4( a, a );
+    store( axis, getX( len2 ) > 0 ? div( a, sqrt( len2 ) ) : zero() );
+#else
+    uint32 start = first;
+    for( uint32 c = first; c < last; ++c ) if( cov[c][c] > cov[start][start] ) start = c;
+    for( uint32 c = 0; c < 4; ++c ) axis[c] = cov[c][start];
+
+    for( uint32 k = 0; k < iterations; ++k )
+    {
+        float v[4];
+        float m = 0;
+        for( uint32 a = first; a < last; ++a )
+        {
+            v[a] = 0;
+            for( uint32 b = first; b < last; ++b ) v[a] += cov[a][b] * axis[b];
+            m = math::getmax( m, fabsf( v[a] ) );
+        }
+        if( m <= 0 ) break;
+        for( uint32 c = first; c < last; ++c ) axis[c] = v[c] / m;
+    }
+
+    float len = 0;
+    for( uint32 c = first; c < last; ++c ) len += axis[c] * axis[c];
+    len = sqrtf( len );
+    for( uint32 c = first; c < last; ++c ) axis[c] = len > 0 ? axis[c] / len : 0;
+#endif
+}
+
+///
+/// Fit a line through pixels, in channels [first, last). Axis is of unit length, or zero
+/// if all pixels are the same.
+// -----------------------------------------------------------------------------
+static void sFitLine( float mean[4], float axis[4], const Pixels & px, const PixelList & list, uint32 first, uint32 last, uint32 iterations = 8 )
+{
+    float cov[4][4];
+    sCovariance( mean, cov, px, list, first, last );
+    sPrincipalAxis( axis, cov, first, last, iterations );
+}
+
+///
+/// End points of the line fit, by projecting pixels onto the axis.
+// -----------------------------------------------------------------------------
+static void sLineEndpoints( float e0[4], float e1[4], const float mean[4], const float axis[4], const Pixels & px, const PixelList & list, uint32 first, uint32 last )
+{
+    float tmin = 0, tmax = 0;
+    for( uint32 i = 0; i < list.count; ++i )
+    {
+        const sint32 * p = px.c[list.pixels[i]];
+        float t = 0;
+        for( uint32 c = first; c < last; ++c ) t += ( (float)p[c] - mean[c] ) * axis[c];
+        tmin = math::getmin( tmin, t );
+        tmax = math::getmax( tmax, t );
+    }
+    for( uint32 c = first; c < last; ++c )
+    {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+}
+
+///
+/// Least squares end points, given the weight of e1 (0..1) of each pixel. Return false, if the
+/// system is singular, like when all pixels use the same weight.
+// -----------------------------------------------------------------------------
+static bool sLeastSquaresEndpoints( float e0[4], float e1[4], const Pixels & px, const PixelList & list, const float * weights, uint32 first, uint32 last )
+{
+    float aa = 0, ab = 0, bb = 0;
+    float ax[4] = {}, bx[4] = {};
+    for( uint32 i = 0; i < list.count; ++i )
+    {
+        float b = weights[i];
+        if( b < 0 ) continue; // not on the line, like transparent BC1 pixels
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        const sint32 * p = px.c[list.pixels[i]];
+        for( uint32 c = first; c < last; ++c )
+        {
+            ax[c] += a * (float)p[c];
+            bx[c] += b * (float)p[c];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+    if( fabsf( det ) < 1e-6f ) return false;
+    float inv = 1.0f / det;
+    for( uint32 c = first; c < last; ++c )
+    {
+        e0[c] = ( ax[c] * bb - bx[c] * ab ) * inv;
+        e1[c] = ( bx[c] * aa - ax[c] * ab ) * inv;
+    }
+    return true;
+}
+
+// *****************************************************************************
+// BC1 color block, also the color part of BC2 and BC3
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline uint32 sPack565( const float c[3] )
+{
+    sint32 r = sClamp( sRound( c[0] * 31.0f / 255.0f ), 0, 31 );
+    sint32 g = sClamp( sRound( c[1] * 63.0f / 255.0f ), 0, 63 );
+    sint32 b = sClamp( sRound( c[2] * 31.0f / 255.0f ), 0, 31 );
+    return (uint32)( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline void sUnpack565( sint32 rgb[3], uint32 c )
+{
+    sint32 r = ( c >> 11 ) & 31, g = ( c >> 5 ) & 63, b = c & 31;
+    rgb[0] = ( r << 3 ) | ( r >> 2 );
+    rgb[1] = ( g << 2 ) | ( g >> 4 );
+    rgb[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sBc1Palette( sint32 pal[4][3], uint32 c0, uint32 c1, bool fourColors )
+{
+    sUnpack565( pal[0], c0 );
+    sUnpack565( pal[1], c1 );
+    for( int c = 0; c < 3; ++c )
+    {
+        if( fourColors )
+        {
+            pal[2][c] = ( pal[0][c] * 2 + pal[1][c] ) / 3;
+            pal[3][c] = ( pal[0][c] + pal[1][c] * 2 ) / 3;
+        }
+        else
+        {
+            pal[2][c] = ( pal[0][c] + pal[1][c] ) / 2;
+            pal[3][c] = 0;
+        }
+    }
+}
+
+///
+/// Nearest palette entry of each pixel. Transparent pixels take index 3 of 3-color blocks.
+/// Return squared error of opaque pixels.
+// -----------------------------------------------------------------------------
+static uint32 sBc1Indices( uint8 indices[16], const Pixels & px, const bool transparent[16], uint32 c0, uint32 c1, bool fourColors )
+{
+    sint32 pal[4][3];
+    sBc1Palette( pal, c0, c1, fourColors );
+
+    uint32 error = 0;
+#if GN_SIMD
+    using namespace GN::simd;
+    static const uint8 ALL[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    float fpal[4][4] = {};
+    for( int k = 0; k < 4; ++k )
+        for( int c = 0; c < 3; ++c )
+            fpal[k][c] = (float)pal[k][c];
+
+    for( int i = 0; i < 16; i += 4 )
+    {
+        Float4 ch[4], dist;
+        sLoadChannels( ch, px, ALL + i, 4 );
+        sint32 nearest[4];
+        float d[4];
+        storeInt( nearest, sNearest( dist, ch, fpal, 4, 0, 3 ) );
+        store( d, dist );
+        for( int j = 0; j < 4; ++j )
+        {
+            if( transparent[i + j] )
+            {
+                indices[i + j] = 3;
+                continue;
+            }
+            indices[i + j] = (uint8)nearest[j];
+            error += (uint32)d[j];
+        }
+    }
+#else
+    for( int i = 0; i < 16; ++i )
+    {
+        if( transparent[i] )
+        {
+            indices[i] = 3;
+            continue;
+        }
+        uint32 best = UINT_MAX;
+        for( int k = 0; k < 4; ++k )
+        {
+            sint32 dr = px.c[i][0] - pal[k][0];
+            sint32 dg = px.c[i][1] - pal[k][1];
+            sint32 db = px.c[i][2] - pal[k][2];
+            uint32 d = (uint32)( dr * dr + dg * dg + db * db );
+            if( d < best )
+            {
+                best = d;
+                indices[i] = (uint8)k;
+            }
+        }
+        error += best;
+    }
+#endif
+    return error;
+}
+
+///
+/// Best 5 and 6-bit end points of a single 8-bit value, at 1/3 of the way from e0 to e1.
+///
+struct SingleColorTables
+{
+    uint8 e5[256][2];
+    uint8 e6[256][2];
+
+    SingleColorTables()
+    {
+        build( e5, 5 );
+        build( e6, 6 );
+    }
+
+    static void build( uint8 table[256][2], uint32 bits )
+    {
+        sint32 n = 1 << bits;
+        for( sint32 v = 0; v < 256; ++v )
+        {
+            sint32 best = INT_MAX;
+            for( sint32 a = 0; a < n; ++a )
+            for( sint32 b = 0; b < n; ++b )
+            {
+                sint32 ea = 5 == bits ? ( ( a << 3 ) | ( a >> 2 ) ) : ( ( a << 2 ) | ( a >> 4 ) );
+                sint32 eb = 5 == bits ? ( ( b << 3 ) | ( b >> 2 ) ) : ( ( b << 2 ) | ( b >> 4 ) );
+                sint32 d = abs( ( ea * 2 + eb ) / 3 - v );
+                if( d < best )
+                {
+                    best = d;
+                    table[v][0] = (uint8)a;
+                    table[v][1] = (uint8)b;
+                }
+            }
+        }
+    }
+};
+
+//
+//
+// -----------------------------------------------------------------------------
+static const SingleColorTables & sSingleColorTables()
+{
+    static const SingleColorTables t;
+    return t;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sWriteBc1( uint8 * block, uint32 c0, uint32 c1, const uint8 indices[16] )
+{
+    block[0] = (uint8)c0;
+    block[1] = (uint8)( c0 >> 8 );
+    block[2] = (uint8)c1;
+    block[3] = (uint8)( c1 >> 8 );
+    uint32 bits = 0;
+    for( int i = 0; i < 16; ++i ) bits |= (uint32)indices[i] << ( i * 2 );
+    block[4] = (uint8)bits;
+    block[5] = (uint8)( bits >> 8 );
+    block[6] = (uint8)( bits >> 16 );
+    block[7] = (uint8)( bits >> 24 );
+}
+
+///
+/// Encode color of a block. With "bc1", pixels of alpha < 128 are encoded as transparent
+/// pixels of a 3-color block. Otherwise, blocks are always 4-color, as BC2 and BC3 require.
+// -----------------------------------------------------------------------------
+static void sEncodeBc1Color( uint8 * block, const Pixels & px, bool bc1, Quality quality )
+{
+    bool transparent[16];
+    PixelList opaque;
+    opaque.count = 0;
+    for( int i = 0; i < 16; ++i )
+    {
+        transparent[i] = bc1 && px.c[i][3] < 128;
+        if( !transparent[i] ) opaque.pixels[opaque.count++] = (uint8)i;
+    }
+
+    // fully transparent
+    if( 0 == opaque.count )
+    {
+        uint8 indices[16];
+        memset( indices, 3, sizeof(indices) );
+        sWriteBc1( block, 0, 0, indices );
+        return;
+    }
+    bool fourColors = opaque.count == 16;
+
+    // single color, matched at 1/3 of the way between end points.
+    bool single = true;
+    for( uint32 i = 1; i < opaque.count && single; ++i )
+    {
+        const sint32 * a = px.c[opaque.pixels[0]];
+        const sint32 * b = px.c[opaque.pixels[i]];
+        single = a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    }
+    if( single && fourColors )
+    {
+        const SingleColorTables & t = sSingleColorTables();
+        const sint32 * c = px.c[0];
+        uint32 c0 = ( (uint32)t.e5[c[0]][0] << 11 ) | ( (uint32)t.e6[c[1]][0] << 5 ) | t.e5[c[2]][0];
+        uint32 c1 = ( (uint32)t.e5[c[0]][1] << 11 ) | ( (uint32)t.e6[c[1]][1] << 5 ) | t.e5[c[2]][1];
+        uint8 indices[16];
+        if( c0 == c1 ) memset( indices, 0, sizeof(indices) );
+        else if( c0 > c1 ) memset( indices, 2, sizeof(indices) );
+        else
+        {
+            std::swap( c0, c1 );
+            memset( indices, 3, sizeof(indices) );
+        }
+        sWriteBc1( block, c0, c1, indices );
+        return;
+    }
+
+    // initial end points
+    float e0[4], e1[4];
+    if( Quality::FAST == quality )
+    {
+        // bounding box, inset by 1/16 of its size, on the diagonal the pixels lean to.
+        float lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 }, mean[3] = { 0, 0, 0 };
+        for( uint32 i = 0; i < opaque.count; ++i )
+        {
+            const sint32 * p = px.c[opaque.pixels[i]];
+            for( int c = 0; c < 3; ++c )
+            {
+                lo[c] = math::getmin( lo[c], (float)p[c] );
+                hi[c] = math::getmax( hi[c], (float)p[c] );
+                mean[c] += (float)p[c];
+            }
+        }
+        float cov[3] = { 0, 0, 0 };
+        for( int c = 0; c < 3; ++c ) mean[c] /= (float)opaque.count;
+        for( uint32 i = 0; i < opaque.count; ++i )
+        {
+            const sint32 * p = px.c[opaque.pixels[i]];
+            float dr = (float)p[0] - mean[0];
+            cov[1] += dr * ( (float)p[1] - mean[1] );
+            cov[2] += dr * ( (float)p[2] - mean[2] );
+        }
+        for( int c = 0; c < 3; ++c )
+        {
+            float inset = ( hi[c] - lo[c] ) / 16.0f;
+            e0[c] = hi[c] - inset;
+            e1[c] = lo[c] + inset;
+        }
+        for( int c = 1; c < 3; ++c ) if( cov[c] < 0 ) std::swap( e0[c], e1[c] );
+    }
+    else
+    {
+        float mean[4], axis[4];
+        sFitLine( mean, axis, px, opaque, 0, 3 );
+        sLineEndpoints( e1, e0, mean, axis, px, opaque, 0, 3 );
+    }
+
+    uint32 c0 = sPack565( e0 ), c1 = sPack565( e1 );
+    uint8 indices[16];
+    uint32 error = sBc1Indices( indices, px, transparent, c0, c1, fourColors );
+
+    // refine end points with least squares, from indices of the last pass.
+    uint32 iterations = Quality::FAST == quality ? 0 : ( Quality::NORMAL == quality ? 1 : 4 );
+    for( uint32 k = 0; k < iterations && error > 0; ++k )
+    {
+        static const float WEIGHTS4[] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        static const float WEIGHTS3[] = { 0.0f, 1.0f, 0.5f, -1.0f };
+        float weights[16];
+        for( uint32 i = 0; i < opaque.count; ++i )
+        {
+            uint32 idx = indices[opaque.pixels[i]];
+            weights[i] = fourColors ? WEIGHTS4[idx] : WEIGHTS3[idx];
+        }
+        if( !sLeastSquaresEndpoints( e0, e1, px, opaque, weights, 0, 3 ) ) break;
+
+        uint32 n0 = sPack565( e0 ), n1 = sPack565( e1 );
+        uint8 newIndices[16];
+        uint32 newError = sBc1Indices( newIndices, px, transparent, n0, n1, fourColors );
+        if( newError >= error ) break;
+        c0 = n0;
+        c1 = n1;
+        error = newError;
+        memcpy( indices, newIndices, sizeof(indices) );
+    }
+
+    // opaque BC1 blocks could use the 3-color mode too, for its mid point and black.
+    if( bc1 && fourColors && Quality::HIGH == quality && error > 0 )
+    {
+        uint8 indices3[16];
+        uint32 error3 = sBc1Indices( indices3, px, transparent, c0, c1, false );
+        if( error3 < error )
+        {
+            fourColors = false;
+            memcpy( indices, indices3, sizeof(indices) );
+        }
+    }
+
+    // order of end points selects the mode
+    if( fourColors )
+    {
+        static const uint8 SWAP[] = { 1, 0, 3, 2 };
+        if( c0 == c1 ) memset( indices, 0, sizeof(indices) );
+        else if( c0 < c1 )
+        {
+            std::swap( c0, c1 );
+            for( int i = 0; i < 16; ++i ) indices[i] = SWAP[indices[i]];
+        }
+    }
+    else if( c0 > c1 )
+    {
+        static const uint8 SWAP[] = { 1, 0, 2, 3 };
+        std::swap( c0, c1 );
+        for( int i = 0; i < 16; ++i ) indices[i] = SWAP[indices[i]];
+    }
+
+    sWriteBc1( block, c0, c1, indices );
+}
+
+///
+/// Decode color of a block. BC2 and BC3 blocks are always 4-color.
+// -----------------------------------------------------------------------------
+static void sDecodeBc1Color( const uint8 * block, Pixels & px, bool bc1 )
+{
+    uint32 c0 = block[0] | ( (uint32)block[1] << 8 );
+    uint32 c1 = block[2] | ( (uint32)block[3] << 8 );
+    uint32 bits = block[4] | ( (uint32)block[5] << 8 ) | ( (uint32)block[6] << 16 ) | ( (uint32)block[7] << 24 );
+    bool fourColors = !bc1 || c0 > c1;
+
+    sint32 pal[4][3];
+    sBc1Palette( pal, c0, c1, fourColors );
+    for( int i = 0; i < 16; ++i )
+    {
+        uint32 idx = ( bits >> ( i * 2 ) ) & 3;
+        px.c[i][0] = pal[idx][0];
+        px.c[i][1] = pal[idx][1];
+        px.c[i][2] = pal[idx][2];
+        px.c[i][3] = ( !fourColors && 3 == idx ) ? 0 : 255;
+    }
+}
+
+// *****************************************************************************
+// BC4 single channel block, also the alpha part of BC3 and channels of BC5
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sBc4Palette( sint32 pal[8], sint32 e0, sint32 e1, bool snorm )
+{
+    pal[0] = e0;
+    pal[1] = e1;
+    if( e0 > e1 )
+    {
+        for( sint32 i = 1; i < 7; ++i ) pal[i + 1] = ( e0 * ( 7 - i ) + e1 * i ) / 7;
+    }
+    else
+    {
+        for( sint32 i = 1; i < 5; ++i ) pal[i + 1] = ( e0 * ( 5 - i ) + e1 * i ) / 5;
+        pal[6] = snorm ? -127 : 0;
+        pal[7] = snorm ? 127 : 255;
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static uint32 sBc4Indices( uint8 indices[16], const sint32 values[16], sint32 e0, sint32 e1, bool snorm )
+{
+    sint32 pal[8];
+    sBc4Palette( pal, e0, e1, snorm );
+    uint32 error = 0;
+    for( int i = 0; i < 16; ++i )
+    {
+        uint32 best = UINT_MAX;
+        for( int k = 0; k < 8; ++k )
+        {
+            sint32 d = values[i] - pal[k];
+            if( (uint32)( d * d ) < best )
+            {
+                best = (uint32)( d * d );
+                indices[i] = (uint8)k;
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc4Channel( uint8 * block, const sint32 values[16], bool snorm, Quality quality )
+{
+    const sint32 lowest = snorm ? -127 : 0, highest = snorm ? 127 : 255;
+
+    sint32 lo = highest, hi = lowest;
+    for( int i = 0; i < 16; ++i )
+    {
+        lo = math::getmin( lo, values[i] );
+        hi = math::getmax( hi, values[i] );
+    }
+
+    // 8 values between min and max
+    sint32 e0 = hi, e1 = lo;
+    uint8 indices[16];
+    uint32 error = sBc4Indices( indices, values, e0, e1, snorm );
+
+    // 6 values between inner min and max, plus both extremes.
+    if( Quality::FAST != quality && error > 0 )
+    {
+        sint32 lo6 = highest, hi6 = lowest;
+        for( int i = 0; i < 16; ++i )
+        {
+            if( values[i] == lowest || values[i] == highest ) continue;
+            lo6 = math::getmin( lo6, values[i] );
+            hi6 = math::getmax( hi6, values[i] );
+        }
+        if( lo6 > hi6 ) lo6 = hi6 = lowest;
+        uint8 indices6[16];
+        uint32 error6 = sBc4Indices( indices6, values, lo6, hi6, snorm );
+        if( error6 < error )
+        {
+            e0 = lo6;
+            e1 = hi6;
+            error = error6;
+            memcpy( indices, indices6, sizeof(indices) );
+        }
+    }
+
+    // search around min and max of the 8-value mode
+    if( Quality::HIGH == quality && error > 0 )
+    {
+        for( sint32 d0 = -2; d0 <= 2; ++d0 )
+        for( sint32 d1 = -2; d1 <= 2; ++d1 )
+        {
+            sint32 a = sClamp( hi + d0, lowest, highest );
+            sint32 b = sClamp( lo + d1, lowest, highest );
+            if( a <= b ) continue;
+            uint8 candidate[16];
+            uint32 e = sBc4Indices( candidate, values, a, b, snorm );
+            if( e < error )
+            {
+                e0 = a;
+                e1 = b;
+                error = e;
+                memcpy( indices, candidate, sizeof(indices) );
+            }
+        }
+    }
+
+    block[0] = (uint8)e0;
+    block[1] = (uint8)e1;
+    uint64 bits = 0;
+    for( int i = 0; i < 16; ++i ) bits |= (uint64)indices[i] << ( i * 3 );
+    for( int i = 0; i < 6; ++i ) block[2 + i] = (uint8)( bits >> ( i * 8 ) );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeBc4Channel( const uint8 * block, Pixels & px, uint32 channel, bool snorm )
+{
+    sint32 e0 = snorm ? math::getmax<sint32>( (sint8)block[0], -127 ) : block[0];
+    sint32 e1 = snorm ? math::getmax<sint32>( (sint8)block[1], -127 ) : block[1];
+    sint32 pal[8];
+    sBc4Palette( pal, e0, e1, snorm );
+
+    uint64 bits = 0;
+    for( int i = 0; i < 6; ++i ) bits |= (uint64)block[2 + i] << ( i * 8 );
+    for( int i = 0; i < 16; ++i ) px.c[i][channel] = pal[( bits >> ( i * 3 ) ) & 7];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline void sGetChannel( sint32 values[16], const Pixels & px, uint32 channel )
+{
+    for( int i = 0; i < 16; ++i ) values[i] = px.c[i][channel];
+}
+
+// *****************************************************************************
+// BC1 - BC5 blocks
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc1( uint8 * block, const Pixels & px, bool, Quality quality )
+{
+    sEncodeBc1Color( block, px, true, quality );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeBc1( const uint8 * block, Pixels & px, bool )
+{
+    sDecodeBc1Color( block, px, true );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc2( uint8 * block, const Pixels & px, bool, Quality quality )
+{
+    uint64 bits = 0;
+    for( int i = 0; i < 16; ++i ) bits |= (uint64)( ( px.c[i][3] * 15 + 127 ) / 255 ) << ( i * 4 );
+    for( int i = 0; i < 8; ++i ) block[i] = (uint8)( bits >> ( i * 8 ) );
+    sEncodeBc1Color( block + 8, px, false, quality );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeBc2( const uint8 * block, Pixels & px, bool )
+{
+    sDecodeBc1Color( block + 8, px, false );
+    for( int i = 0; i < 16; ++i ) px.c[i][3] = ( ( block[i / 2] >> ( ( i & 1 ) * 4 ) ) & 15 ) * 17;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc3( uint8 * block, const Pixels & px, bool, Quality quality )
+{
+    sint32 alpha[16];
+    sGetChannel( alpha, px, 3 );
+    sEncodeBc4Channel( block, alpha, false, quality );
+    sEncodeBc1Color( block + 8, px, false, quality );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeBc3( const uint8 * block, Pixels & px, bool )
+{
+    sDecodeBc1Color( block + 8, px, false );
+    sDecodeBc4Channel( block, px, 3, false );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc4( uint8 * block, const Pixels & px, bool snorm, Quality quality )
+{
+    sint32 red[16];
+    sGetChannel( red, px, 0 );
+    sEncodeBc4Channel( block, red, snorm, quality );
+}
+
+///
+/// BC4 decodes to (R, 0, 0, 1)
+// -----------------------------------------------------------------------------
+static void sDecodeBc4( const uint8 * block, Pixels & px, bool snorm )
+{
+    for( int i = 0; i < 16; ++i )
+    {
+        px.c[i][1] = 0;
+        px.c[i][2] = 0;
+        px.c[i][3] = snorm ? 127 : 255;
+    }
+    sDecodeBc4Channel( block, px, 0, snorm );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeBc5( uint8 * block, const Pixels & px, bool snorm, Quality quality )
+{
+    sint32 values[16];
+    sGetChannel( values, px, 0 );
+    sEncodeBc4Channel( block, values, snorm, quality );
+    sGetChannel( values, px, 1 );
+    sEncodeBc4Channel( block + 8, values, snorm, quality );
+}
+
+///
+/// BC5 decodes to (R, G, 0, 1)
+// -----------------------------------------------------------------------------
+static void sDecodeBc5( const uint8 * block, Pixels & px, bool snorm )
+{
+    for( int i = 0; i < 16; ++i )
+    {
+        px.c[i][2] = 0;
+        px.c[i][3] = snorm ? 127 : 255;
+    }
+    sDecodeBc4Channel( block, px, 0, snorm );
+    sDecodeBc4Channel( block + 8, px, 1, snorm );
+}
+
+// *****************************************************************************
+// BC7
+// *****************************************************************************
+
+static const Bc7Mode sBc7Modes[8] =
+{
+    // subsets, partition, rotation, index mode, color, alpha, endpoint p-bits, shared p-bits, index, index2
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+    { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+    { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+/// interpolation weights of 2, 3 and 4-bit indices, out of 64
+static const sint32 sBc7Weights2[] = { 0, 21, 43, 64 };
+static const sint32 sBc7Weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const sint32 sBc7Weights4[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// 2-subset partitions. Bit i is the subset of pixel i.
+static const uint16 sBc7Partitions2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+/// 3-subset partitions, 2 bits per pixel, pixel i at bit 2*i.
+static uint32 sBc7Partitions3[64];
+
+/// 3-subset partitions, as listed in the format specification.
+static const uint8 sBc7Partitions3Table[64][16] =
+{
+    { 0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2 }, { 0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1 },
+    { 0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1 }, { 0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1 },
+    { 0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2 }, { 0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2 },
+    { 0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1 }, { 0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1 },
+    { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2 }, { 0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2 },
+    { 0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2 }, { 0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2 },
+    { 0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2 }, { 0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2 },
+    { 0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2 }, { 0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0 },
+    { 0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2 }, { 0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0 },
+    { 0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2 }, { 0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1 },
+    { 0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2 }, { 0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1 },
+    { 0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2 }, { 0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0 },
+    { 0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0 }, { 0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2 },
+    { 0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0 }, { 0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1 },
+    { 0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2 }, { 0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2 },
+    { 0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1 }, { 0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1 },
+    { 0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2 }, { 0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1 },
+    { 0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2 }, { 0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0 },
+    { 0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0 }, { 0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0 },
+    { 0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0 }, { 0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1 },
+    { 0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1 }, { 0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2 },
+    { 0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1 }, { 0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2 },
+    { 0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1 }, { 0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1 },
+    { 0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1 }, { 0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1 },
+    { 0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2 }, { 0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1 },
+    { 0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2 }, { 0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2 },
+    { 0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2 }, { 0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2 },
+    { 0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2 }, { 0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2 },
+    { 0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2 }, { 0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2 },
+    { 0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2 }, { 0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2 },
+    { 0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1 }, { 0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2 },
+    { 0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2 }, { 0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0 },
+};
+
+/// anchor pixel of the second subset of 2-subset partitions
+static const uint8 sBc7Anchors2[64] =
+{
+    15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+    15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+    15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+     6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+};
+
+/// anchor pixel of the second subset of 3-subset partitions
+static const uint8 sBc7Anchors3a[64] =
+{
+     3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+     3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+     8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+     3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+};
+
+/// anchor pixel of the third subset of 3-subset partitions
+static const uint8 sBc7Anchors3b[64] =
+{
+    15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+    15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+    15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+    15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+};
+
+//
+//
+// -----------------------------------------------------------------------------
+static const uint32 * sBc7GetPartitions3()
+{
+    // pack the table once, to look up subsets by shifts.
+    static const bool packed = []() {
+        for( int p = 0; p < 64; ++p )
+        {
+            uint32 bits = 0;
+            for( int i = 0; i < 16; ++i ) bits |= (uint32)sBc7Partitions3Table[p][i] << ( i * 2 );
+            sBc7Partitions3[p] = bits;
+        }
+        return true;
+    }();
+    (void)packed;
+    return sBc7Partitions3;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline uint32 sBc7Subset( uint32 subsets, uint32 partition, uint32 pixel )
+{
+    if( 2 == subsets ) return ( sBc7Partitions2[partition] >> pixel ) & 1;
+    if( 3 == subsets ) return ( sBc7GetPartitions3()[partition] >> ( pixel * 2 ) ) & 3;
+    return 0;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline uint32 sBc7Anchor( uint32 subsets, uint32 partition, uint32 subset )
+{
+    if( 0 == subset ) return 0;
+    if( 2 == subsets ) return sBc7Anchors2[partition];
+    return 1 == subset ? sBc7Anchors3a[partition] : sBc7Anchors3b[partition];
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline const sint32 * sBc7Weights( uint32 indexBits )
+{
+    return 2 == indexBits ? sBc7Weights2 : ( 3 == indexBits ? sBc7Weights3 : sBc7Weights4 );
+}
+
+///
+/// Expand n-bit endpoint value to 8 bits, by replicating high bits.
+// -----------------------------------------------------------------------------
+static inline sint32 sBc7Expand( sint32 v, uint32 bits )
+{
+    v <<= ( 8 - bits );
+    return v | ( v >> bits );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline sint32 sBc7Interpolate( sint32 e0, sint32 e1, sint32 w )
+{
+    return ( e0 * ( 64 - w ) + e1 * w + 32 ) >> 6;
+}
+
+///
+/// Nearest code of each 8-bit value, for 4 to 8-bit end points, without p-bit, or with a p-bit
+/// of 0 or 1 as the lowest bit.
+///
+struct Bc7QuantizeTables
+{
+    uint8 code[5][3][256];  ///< [bits - 4][p + 1][value]
+    uint8 value[5][3][256]; ///< the 8-bit value, that the decoder expands the code to
+
+    Bc7QuantizeTables()
+    {
+        for( sint32 bits = 4; bits <= 8; ++bits )
+        for( sint32 p = -1; p <= 1; ++p )
+        {
+            sint32 total = bits + ( p >= 0 ? 1 : 0 );
+            if( total > 8 ) continue;
+            for( sint32 v = 0; v < 256; ++v )
+            {
+                sint32 best = INT_MAX;
+                for( sint32 c = 0; c < ( 1 << bits ); ++c )
+                {
+                    sint32 e = sBc7Expand( p >= 0 ? ( c << 1 ) | p : c, (uint32)total );
+                    sint32 d = abs( e - v );
+                    if( d < best )
+                    {
+                        best = d;
+                        code[bits - 4][p + 1][v] = (uint8)c;
+                        value[bits - 4][p + 1][v] = (uint8)e;
+                    }
+                }
+            }
+        }
+    }
+};
+
+//
+//
+// -----------------------------------------------------------------------------
+static const Bc7QuantizeTables & sBc7QuantizeTables()
+{
+    static const Bc7QuantizeTables t;
+    return t;
+}
+
+///
+/// Quantize a channel to "bits" bits, with a fixed p-bit as the lowest bit, if p >= 0.
+/// Return the stored code, and the 8-bit value the decoder expands it to.
+// -----------------------------------------------------------------------------
+static sint32 sBc7Quantize( sint32 & value, float v, uint32 bits, sint32 p )
+{
+    GN_ASSERT( 4 <= bits && bits + ( p >= 0 ? 1 : 0 ) <= 8 );
+    const Bc7QuantizeTables & t = sBc7QuantizeTables();
+    sint32 target = sClamp( sRound( v ), 0, 255 );
+    value = t.value[bits - 4][p + 1][target];
+    return t.code[bits - 4][p + 1][target];
+}
+
+///
+/// Quantize both end points, with given p-bits (-1 for none).
+// -----------------------------------------------------------------------------
+static void sBc7QuantizeEndpoints( Bc7Endpoints & ep, const float e0[4], const float e1[4], uint32 first, uint32 last, const uint32 bits[4], sint32 p0, sint32 p1 )
+{
+    ep.pbit[0] = p0;
+    ep.pbit[1] = p1;
+    for( uint32 c = first; c < last; ++c )
+    {
+        ep.code[0][c] = sBc7Quantize( ep.value[0][c], e0[c], bits[c], p0 );
+        ep.code[1][c] = sBc7Quantize( ep.value[1][c], e1[c], bits[c], p1 );
+    }
+}
+
+///
+/// Nearest interpolated color of each pixel of the subset. SIMD code tests all entries of the
+/// palette, 4 pixels at a time. Scalar code projects pixels onto the line between end points,
+/// and tests only the closest 3 entries. Return squared error.
+// -----------------------------------------------------------------------------
+static uint32 sBc7Indices( uint8 * indices, const Bc7Endpoints & ep, const Pixels & px, const PixelList & list, uint32 first, uint32 last, uint32 indexBits )
+{
+    const sint32 * weights = sBc7Weights( indexBits );
+    const sint32 n = 1 << indexBits;
+
+#if GN_SIMD
+    using namespace GN::simd;
+    float pal[16][4];
+    for( sint32 k = 0; k < n; ++k )
+        for( uint32 c = first; c < last; ++c )
+            pal[k][c] = (float)sBc7Interpolate( ep.value[0][c], ep.value[1][c], weights[k] );
+
+    uint32 error = 0;
+    for( uint32 i = 0; i < list.count; i += 4 )
+    {
+        uint32 count = math::getmin( list.count - i, 4u );
+        Float4 ch[4], dist;
+        sLoadChannels( ch, px, list.pixels + i, count );
+        sint32 nearest[4];
+        float d[4];
+        storeInt( nearest, sNearest( dist, ch, pal, (uint32)n, first, last ) );
+        store( d, dist );
+        for( uint32 j = 0; j < count; ++j )
+        {
+            indices[list.pixels[i + j]] = (uint8)nearest[j];
+            error += (uint32)d[j];
+        }
+    }
+    return error;
+#else
+    sint32 pal[16][4];
+    for( sint32 k = 0; k < n; ++k )
+        for( uint32 c = first; c < last; ++c )
+            pal[k][c] = sBc7Interpolate( ep.value[0][c], ep.value[1][c], weights[k] );
+
+    sint32 dir[4];
+    sint32 len2 = 0;
+    for( uint32 c = first; c < last; ++c )
+    {
+        dir[c] = ep.value[1][c] - ep.value[0][c];
+        len2 += dir[c] * dir[c];
+    }
+    float scale = len2 > 0 ? (float)( n - 1 ) / (float)len2 : 0.0f;
+
+    uint32 error = 0;
+    for( uint32 i = 0; i < list.count; ++i )
+    {
+        const sint32 * p = px.c[list.pixels[i]];
+        sint32 t = 0;
+        for( uint32 c = first; c < last; ++c ) t += ( p[c] - ep.value[0][c] ) * dir[c];
+        sint32 k0 = sClamp( sRound( (float)t * scale ), 0, n - 1 );
+
+        uint32 best = UINT_MAX;
+        for( sint32 k = math::getmax( k0 - 1, 0 ); k <= math::getmin( k0 + 1, n - 1 ); ++k )
+        {
+            uint32 d = 0;
+            for( uint32 c = first; c < last; ++c )
+            {
+                sint32 diff = p[c] - pal[k][c];
+                d += (uint32)( diff * diff );
+            }
+            if( d < best )
+            {
+                best = d;
+                indices[list.pixels[i]] = (uint8)k;
+            }
+        }
+        error += best;
+    }
+    return error;
+#endif
+}
+
+///
+/// Squared quantization error of an end point with the p-bit.
+// -----------------------------------------------------------------------------
+static float sBc7PBitError( const float e[4], uint32 first, uint32 last, const uint32 bits[4], sint32 p )
+{
+    float error = 0;
+    for( uint32 c = first; c < last; ++c )
+    {
+        sint32 value;
+        sBc7Quantize( value, e[c], bits[c], p );
+        error += ( (float)value - e[c] ) * ( (float)value - e[c] );
+    }
+    return error;
+}
+
+///
+/// Fit end points and indices of one subset, in channels [first, last). pbitMode is 0 for
+/// no p-bits, 1 for one p-bit per end point, 2 for one shared p-bit. P-bits are picked by
+/// quantization error of end points, or by error of the whole subset with "searchPBits".
+/// Return squared error.
+// -----------------------------------------------------------------------------
+static uint32 sBc7FitSubset(
+    Bc7Endpoints    & ep,
+    uint8           * indices,
+    const Pixels    & px,
+    const PixelList & list,
+    uint32            first,
+    uint32            last,
+    const uint32      bits[4],
+    uint32            pbitMode,
+    uint32            indexBits,
+    uint32            iterations,
+    bool              searchPBits )
+{
+    static const sint32 PBITS[3][4][2] =
+    {
+        { { -1, -1 } },
+        { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } },
+        { { 0, 0 }, { 1, 1 } },
+    };
+    static const uint32 NUM_PBITS[3] = { 1, 4, 2 };
+
+    float e0[4], e1[4];
+    {
+        float mean[4], axis[4];
+        sFitLine( mean, axis, px, list, first, last );
+        sLineEndpoints( e0, e1, mean, axis, px, list, first, last );
+    }
+
+    // opaque subsets need p-bits of 1, to reach alpha of 255.
+    bool opaque = false;
+    if( 1 == pbitMode && 4 == last )
+    {
+        opaque = true;
+        for( uint32 i = 0; i < list.count && opaque; ++i ) opaque = 255 == px.c[list.pixels[i]][3];
+    }
+
+    uint32 bestError = UINT_MAX;
+    uint8 candidate[16];
+    for( uint32 k = 0; k <= iterations; ++k )
+    {
+        sint32 pbits[4][2];
+        uint32 numPBits = 0;
+        if( opaque )
+        {
+            pbits[0][0] = pbits[0][1] = 1;
+            numPBits = 1;
+        }
+        else if( searchPBits || 0 == pbitMode )
+        {
+            for( ; numPBits < NUM_PBITS[pbitMode]; ++numPBits )
+            {
+                pbits[numPBits][0] = PBITS[pbitMode][numPBits][0];
+                pbits[numPBits][1] = PBITS[pbitMode][numPBits][1];
+            }
+        }
+        else if( 1 == pbitMode )
+        {
+            pbits[0][0] = sBc7PBitError( e0, first, last, bits, 1 ) < sBc7PBitError( e0, first, last, bits, 0 ) ? 1 : 0;
+            pbits[0][1] = sBc7PBitError( e1, first, last, bits, 1 ) < sBc7PBitError( e1, first, last, bits, 0 ) ? 1 : 0;
+            numPBits = 1;
+        }
+        else
+        {
+            float error0 = sBc7PBitError( e0, first, last, bits, 0 ) + sBc7PBitError( e1, first, last, bits, 0 );
+            float error1 = sBc7PBitError( e0, first, last, bits, 1 ) + sBc7PBitError( e1, first, last, bits, 1 );
+            pbits[0][0] = pbits[0][1] = error1 < error0 ? 1 : 0;
+            numPBits = 1;
+        }
+
+        bool improved = false;
+        for( uint32 p = 0; p < numPBits; ++p )
+        {
+            Bc7Endpoints q;
+            sBc7QuantizeEndpoints( q, e0, e1, first, last, bits, pbits[p][0], pbits[p][1] );
+            uint32 error = sBc7Indices( candidate, q, px, list, first, last, indexBits );
+            if( error < bestError )
+            {
+                bestError = error;
+                ep = q;
+                for( uint32 i = 0; i < list.count; ++i ) indices[list.pixels[i]] = candidate[list.pixels[i]];
+                improved = true;
+            }
+        }
+        if( !improved || 0 == bestError || k == iterations ) break;
+
+        // least squares end points from the best indices so far
+        const sint32 * weights = sBc7Weights( indexBits );
+        float w[16];
+        for( uint32 i = 0; i < list.count; ++i ) w[i] = (float)weights[indices[list.pixels[i]]] / 64.0f;
+        if( !sLeastSquaresEndpoints( e0, e1, px, list, w, first, last ) ) break;
+    }
+    return bestError;
+}
+
+///
+/// Swap end points of a subset, if its anchor index has the highest bit set, which the block
+/// does not store.
+// -----------------------------------------------------------------------------
+static void sBc7FixAnchor( Bc7Endpoints & ep, uint8 * indices, const PixelList & list, uint32 anchor, uint32 indexBits, uint32 first, uint32 last )
+{
+    uint32 maxIndex = ( 1u << indexBits ) - 1;
+    if( indices[anchor] <= maxIndex / 2 ) return;
+    for( uint32 c = first; c < last; ++c )
+    {
+        std::swap( ep.code[0][c], ep.code[1][c] );
+        std::swap( ep.value[0][c], ep.value[1][c] );
+    }
+    std::swap( ep.pbit[0], ep.pbit[1] );
+    for( uint32 i = 0; i < list.count; ++i ) indices[list.pixels[i]] = (uint8)( maxIndex - indices[list.pixels[i]] );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sBc7GetSubsets( PixelList lists[3], uint32 subsets, uint32 partition )
+{
+    for( uint32 s = 0; s < subsets; ++s ) lists[s].count = 0;
+    for( uint32 i = 0; i < 16; ++i )
+    {
+        PixelList & l = lists[sBc7Subset( subsets, partition, i )];
+        l.pixels[l.count++] = (uint8)i;
+    }
+}
+
+///
+/// Encode block with mode 0, 1, 2, 3, 6 or 7, that share indices between color and alpha.
+/// The block is written only if its squared error is less than "bestError". Return the error.
+// -----------------------------------------------------------------------------
+static uint32 sBc7EncodeCombined( uint8 * block, uint32 bestError, const Pixels & px, uint32 mode, uint32 partition, uint32 iterations, bool searchPBits )
+{
+    const Bc7Mode & m = sBc7Modes[mode];
+    const uint32 bits[4] = { m.colorBits, m.colorBits, m.colorBits, m.alphaBits };
+    const uint32 last = m.alphaBits ? 4 : 3;
+    const uint32 pbitMode = m.endpointPBits ? 1 : ( m.sharedPBits ? 2 : 0 );
+
+    PixelList lists[3];
+    sBc7GetSubsets( lists, m.subsets, partition );
+
+    Bc7Endpoints ep[3];
+    uint8 indices[16];
+    uint32 error = 0;
+    for( uint32 s = 0; s < m.subsets; ++s )
+    {
+        error += sBc7FitSubset( ep[s], indices, px, lists[s], 0, last, bits, pbitMode, m.indexBits, iterations, searchPBits );
+    }
+    if( !m.alphaBits )
+    {
+        for( int i = 0; i < 16; ++i ) error += (uint32)( ( 255 - px.c[i][3] ) * ( 255 - px.c[i][3] ) );
+    }
+    if( error >= bestError ) return error;
+    for( uint32 s = 0; s < m.subsets; ++s )
+    {
+        sBc7FixAnchor( ep[s], indices, lists[s], sBc7Anchor( m.subsets, partition, s ), m.indexBits, 0, last );
+    }
+
+    memset( block, 0, 16 );
+    BitWriter w( block );
+    w.write( 1u << mode, mode + 1 );
+    w.write( partition, m.partitionBits );
+    for( uint32 c = 0; c < last; ++c )
+        for( uint32 s = 0; s < m.subsets; ++s )
+        {
+            w.write( (uint32)ep[s].code[0][c], bits[c] );
+            w.write( (uint32)ep[s].code[1][c], bits[c] );
+        }
+    for( uint32 s = 0; s < m.subsets; ++s )
+    {
+        if( m.endpointPBits )
+        {
+            w.write( (uint32)ep[s].pbit[0], 1 );
+            w.write( (uint32)ep[s].pbit[1], 1 );
+        }
+        else if( m.sharedPBits )
+        {
+            w.write( (uint32)ep[s].pbit[0], 1 );
+        }
+    }
+    for( uint32 i = 0; i < 16; ++i )
+    {
+        uint32 s = sBc7Subset( m.subsets, partition, i );
+        w.write( indices[i], m.indexBits - ( i == sBc7Anchor( m.subsets, partition, s ) ? 1 : 0 ) );
+    }
+    GN_ASSERT( 128 == w.pos );
+    return error;
+}
+
+///
+/// Encode block with mode 4 or 5, that have separate color and alpha indices. Rotation swaps
+/// alpha with one of the color channels. The block is written only if its squared error is
+/// less than "bestError". Return the error.
+// -----------------------------------------------------------------------------
+static uint32 sBc7EncodeSeparate( uint8 * block, uint32 bestError, const Pixels & px, uint32 mode, uint32 rotation, uint32 indexMode, uint32 iterations )
+{
+    const Bc7Mode & m = sBc7Modes[mode];
+    const uint32 bits[4] = { m.colorBits, m.colorBits, m.colorBits, m.alphaBits };
+    const uint32 colorIndexBits = indexMode ? m.index2Bits : m.indexBits;
+    const uint32 alphaIndexBits = indexMode ? m.indexBits : m.index2Bits;
+
+    Pixels rotated = px;
+    if( rotation > 0 )
+    {
+        for( int i = 0; i < 16; ++i ) std::swap( rotated.c[i][rotation - 1], rotated.c[i][3] );
+    }
+
+    PixelList all;
+    all.count = 16;
+    for( int i = 0; i < 16; ++i ) all.pixels[i] = (uint8)i;
+
+    Bc7Endpoints ep;
+    uint8 colorIndices[16], alphaIndices[16];
+    uint32 error = sBc7FitSubset( ep, colorIndices, rotated, all, 0, 3, bits, 0, colorIndexBits, iterations, false );
+    Bc7Endpoints alpha;
+    error += sBc7FitSubset( alpha, alphaIndices, rotated, all, 3, 4, bits, 0, alphaIndexBits, iterations, false );
+    if( error >= bestError ) return error;
+    sBc7FixAnchor( ep, colorIndices, all, 0, colorIndexBits, 0, 3 );
+    sBc7FixAnchor( alpha, alphaIndices, all, 0, alphaIndexBits, 3, 4 );
+
+    memset( block, 0, 16 );
+    BitWriter w( block );
+    w.write( 1u << mode, mode + 1 );
+    w.write( rotation, m.rotationBits );
+    w.write( indexMode, m.indexModeBits );
+    for( uint32 c = 0; c < 3; ++c )
+    {
+        w.write( (uint32)ep.code[0][c], m.colorBits );
+        w.write( (uint32)ep.code[1][c], m.colorBits );
+    }
+    w.write( (uint32)alpha.code[0][3], m.alphaBits );
+    w.write( (uint32)alpha.code[1][3], m.alphaBits );
+
+    // primary indices go first, and their width is "indexBits".
+    const uint8 * primary = indexMode ? alphaIndices : colorIndices;
+    const uint8 * secondary = indexMode ? colorIndices : alphaIndices;
+    for( uint32 i = 0; i < 16; ++i ) w.write( primary[i], m.indexBits - ( 0 == i ? 1 : 0 ) );
+    for( uint32 i = 0; i < 16; ++i ) w.write( secondary[i], m.index2Bits - ( 0 == i ? 1 : 0 ) );
+    GN_ASSERT( 128 == w.pos );
+    return error;
+}
+
+///
+/// Squared distance of pixels to the principal axis, from their covariance matrix: the total
+/// variance, less the variance along the axis.
+// -----------------------------------------------------------------------------
+static float sLineError( const float cov[4][4], uint32 channels )
+{
+#if GN_SIMD
+    // variance along the axis is the Rayleigh quotient, no need to normalize the axis.
+    using namespace GN::simd;
+    Float4 a, c[4];
+    float trace = sPowerIteration( a, c, cov, 0, channels, 4 );
+    if( trace <= 0 ) return 0;
+    float len2 = getX( dot4( a, a ) );
+    if( len2 <= 0 ) return trace;
+    Float4 v = transformByColumns( c[0], c[1], c[2], c[3], a );
+    return trace * ( 1.0f - getX( dot4( a, v ) ) / len2 );
+#else
+    float axis[4];
+    sPrincipalAxis( axis, cov, 0, channels, 4 );
+    float error = 0;
+    for( uint32 a = 0; a < channels; ++a )
+    {
+        float v = 0;
+        for( uint32 b = 0; b < channels; ++b ) v += cov[a][b] * axis[b];
+        error += cov[a][a] - axis[a] * v;
+    }
+    return error;
+#endif
+}
+
+///
+/// Score all 64 partitions by how well their subsets fit, lower is better. HIGH quality fits a
+/// line to each subset. Others only sum the variance of subsets, from running sums of pixels
+/// and squares.
+// -----------------------------------------------------------------------------
+static void sBc7ScorePartitions( float scores[64], const Pixels & px, uint32 subsets, uint32 channels, bool fitLines )
+{
+    if( fitLines )
+    {
+#if GN_SIMD
+        // covariance of a subset is the sum of outer products of its pixels, less the outer
+        // product of their sum over the count. So pixels are read once per partition, and
+        // sums of subset 0 are what other subsets leave of the whole block.
+        using namespace GN::simd;
+        Float4 mask = sChannelMask( 0, channels );
+        Float4 moments[16][5]; // pixel, and columns of its outer product
+        Float4 total[5] = { zero(), zero(), zero(), zero(), zero() };
+        for( uint32 i = 0; i < 16; ++i )
+        {
+            Float4 v = mul( toFloat( loadInt( px.c[i] ) ), mask );
+            moments[i][0] = v;
+            moments[i][1] = mul( v, lane<0>( v ) );
+            moments[i][2] = mul( v, lane<1>( v ) );
+            moments[i][3] = mul( v, lane<2>( v ) );
+            moments[i][4] = mul( v, lane<3>( v ) );
+            for( uint32 j = 0; j < 5; ++j ) total[j] = add( total[j], moments[i][j] );
+        }
+
+        // subsets of pixels are packed in 1 or 2 bits
+        const uint32 shift = 2 == subsets ? 1 : 2;
+        const uint32 subsetMask = 2 == subsets ? 1 : 3;
+        for( uint32 p = 0; p < 64; ++p )
+        {
+            uint32 bits = 2 == subsets ? sBc7Partitions2[p] : sBc7GetPartitions3()[p];
+            Float4 sums[3][5];
+            float count[3] = { 16.0f, 0, 0 };
+            for( uint32 s = 1; s < subsets; ++s )
+                for( uint32 j = 0; j < 5; ++j )
+                    sums[s][j] = zero();
+            for( uint32 i = 0; i < 16; ++i, bits >>= shift )
+            {
+                uint32 s = bits & subsetMask;
+                if( 0 == s ) continue;
+                count[s] += 1.0f;
+                for( uint32 j = 0; j < 5; ++j ) sums[s][j] = add( sums[s][j], moments[i][j] );
+            }
+            for( uint32 j = 0; j < 5; ++j )
+            {
+                sums[0][j] = total[j];
+                for( uint32 s = 1; s < subsets; ++s ) sums[0][j] = sub( sums[0][j], sums[s][j] );
+            }
+            for( uint32 s = 1; s < subsets; ++s ) count[0] -= count[s];
+
+            float score = 0;
+            for( uint32 s = 0; s < subsets; ++s )
+            {
+                const Float4 * m = sums[s];
+                Float4 mean = mul( m[0], splat( 1.0f / count[s] ) );
+                float cov[4][4];
+                store( cov[0], nmadd( m[0], lane<0>( mean ), m[1] ) );
+                store( cov[1], nmadd( m[0], lane<1>( mean ), m[2] ) );
+                store( cov[2], nmadd( m[0], lane<2>( mean ), m[3] ) );
+                store( cov[3], nmadd( m[0], lane<3>( mean ), m[4] ) );
+                score += sLineError( cov, channels );
+            }
+            scores[p] = score;
+        }
+#else
+        for( uint32 p = 0; p < 64; ++p )
+        {
+            PixelList lists[3];
+            sBc7GetSubsets( lists, subsets, p );
+            float score = 0;
+            for( uint32 s = 0; s < subsets; ++s )
+            {
+                float mean[4], cov[4][4];
+                sCovariance( mean, cov, px, lists[s], 0, channels );
+                score += sLineError( cov, channels );
+            }
+            scores[p] = score;
+        }
+#endif
+        return;
+    }
+
+    // sum of squares is the same for all partitions, so only the means matter.
+    GN_ASSERT( 2 == subsets );
+    sint32 total[4] = {};
+    for( uint32 i = 0; i < 16; ++i )
+        for( uint32 c = 0; c < channels; ++c )
+            total[c] += px.c[i][c];
+
+    for( uint32 p = 0; p < 64; ++p )
+    {
+        sint32 sum1[4] = {}, n1 = 0;
+        for( uint32 mask = sBc7Partitions2[p], i = 0; mask; mask >>= 1, ++i )
+        {
+            if( 0 == ( mask & 1 ) ) continue;
+            ++n1;
+            for( uint32 c = 0; c < channels; ++c ) sum1[c] += px.c[i][c];
+        }
+        float mean0 = 0, mean1 = 0;
+        for( uint32 c = 0; c < channels; ++c )
+        {
+            float s0 = (float)( total[c] - sum1[c] ), s1 = (float)sum1[c];
+            mean0 += s0 * s0;
+            mean1 += s1 * s1;
+        }
+        scores[p] = -( ( n1 < 16 ? mean0 / (float)( 16 - n1 ) : 0 ) + ( n1 > 0 ? mean1 / (float)n1 : 0 ) );
+    }
+}
+
+///
+/// Best "count" of the first "numPartitions" partitions, by scores of sBc7ScorePartitions().
+// -----------------------------------------------------------------------------
+static void sBc7RankPartitions( uint32 * ranked, uint32 count, const float scores[64], uint32 numPartitions )
+{
+    uint32 order[64];
+    for( uint32 p = 0; p < numPartitions; ++p ) order[p] = p;
+    std::partial_sort( order, order + count, order + numPartitions, [&]( uint32 a, uint32 b ) { return scores[a] < scores[b]; } );
+    memcpy( ranked, order, count * sizeof(uint32) );
+}
+
+///
+/// Rotation of mode 4 and 5, that leaves three channels of the best line fit for the color. The
+/// channel swapped with alpha has indices of its own, so it adds little error.
+// -----------------------------------------------------------------------------
+static uint32 sBc7BestRotation( const Pixels & px )
+{
+    PixelList all;
+    all.count = 16;
+    for( int i = 0; i < 16; ++i ) all.pixels[i] = (uint8)i;
+
+    float mean[4], cov[4][4];
+    sCovariance( mean, cov, px, all, 0, 4 );
+
+    uint32 best = 0;
+    float bestError = 0;
+    for( uint32 rotation = 0; rotation < 4; ++rotation )
+    {
+        // covariance of the color channels, without the one that goes to alpha.
+        uint32 apart = rotation > 0 ? rotation - 1 : 3;
+        uint32 color[3];
+        for( uint32 c = 0, n = 0; c < 4; ++c ) if( c != apart ) color[n++] = c;
+        float sub[4][4] = {};
+        for( uint32 a = 0; a < 3; ++a )
+            for( uint32 b = 0; b < 3; ++b )
+                sub[a][b] = cov[color[a]][color[b]];
+
+        float error = sLineError( sub, 3 );
+        if( 0 == rotation || error < bestError )
+        {
+            best = rotation;
+            bestError = error;
+        }
+    }
+    return best;
+}
+
+///
+/// Try modes by quality preset, keep the block of the least error.
+// -----------------------------------------------------------------------------
+static void sEncodeBc7( uint8 * block, const Pixels & px, bool, Quality quality )
+{
+    bool opaque = true;
+    for( int i = 0; i < 16 && opaque; ++i ) opaque = 255 == px.c[i][3];
+
+    // Encoders write the block only if it is better. So the block always holds the best so far.
+    uint32 bestError = UINT_MAX;
+    auto combined = [&]( uint32 mode, uint32 partition, uint32 iterations, bool searchPBits ) {
+        bestError = math::getmin( bestError, sBc7EncodeCombined( block, bestError, px, mode, partition, iterations, searchPBits ) );
+    };
+    auto separate = [&]( uint32 mode, uint32 rotation, uint32 indexMode, uint32 iterations ) {
+        bestError = math::getmin( bestError, sBc7EncodeSeparate( block, bestError, px, mode, rotation, indexMode, iterations ) );
+    };
+
+    // mode 6 fits any block, and does well on smooth ones.
+    bool high = Quality::HIGH == quality;
+    uint32 iterations = Quality::FAST == quality ? 0 : ( high ? 2 : 1 );
+    combined( 6, 0, iterations, high );
+    if( Quality::FAST == quality || 0 == bestError ) return;
+
+    float scores[64];
+    uint32 ranked[64];
+    uint32 tries = high ? 4 : 2;
+
+    if( opaque )
+    {
+        // 2 subsets, for edges and multiple colors
+        sBc7ScorePartitions( scores, px, 2, 3, high );
+        sBc7RankPartitions( ranked, tries, scores, 64 );
+        for( uint32 i = 0; i < tries; ++i ) combined( 1, ranked[i], iterations, high );
+        if( high )
+        {
+            for( uint32 i = 0; i < tries; ++i ) combined( 3, ranked[i], iterations, high );
+
+            // 3 subsets. Mode 0 uses the first 16 partitions only.
+            sBc7ScorePartitions( scores, px, 3, 3, true );
+            sBc7RankPartitions( ranked, tries, scores, 64 );
+            for( uint32 i = 0; i < tries; ++i ) combined( 2, ranked[i], iterations, high );
+            sBc7RankPartitions( ranked, tries, scores, 16 );
+            for( uint32 i = 0; i < tries; ++i ) combined( 0, ranked[i], iterations, high );
+        }
+    }
+    else
+    {
+        // alpha that does not follow color
+        separate( 5, 0, 0, iterations );
+        sBc7ScorePartitions( scores, px, 2, 4, high );
+        sBc7RankPartitions( ranked, tries, scores, 64 );
+        for( uint32 i = 0; i < tries; ++i ) combined( 7, ranked[i], iterations, high );
+    }
+
+    if( high )
+    {
+        uint32 rotation = sBc7BestRotation( px );
+        if( rotation > 0 || opaque ) separate( 5, rotation, 0, iterations );
+        separate( 4, rotation, 0, iterations );
+        separate( 4, rotation, 1, iterations );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeBc7( const uint8 * block, Pixels & px, bool )
+{
+    uint32 mode = 0;
+    while( mode < 8 && 0 == ( ( block[0] >> mode ) & 1 ) ) ++mode;
+    if( 8 == mode )
+    {
+        // reserved mode decodes to transparent black
+        memset( &px, 0, sizeof(px) );
+        return;
+    }
+
+    const Bc7Mode & m = sBc7Modes[mode];
+    BitReader r( block );
+    r.read( mode + 1 );
+    uint32 partition = r.read( m.partitionBits );
+    uint32 rotation = r.read( m.rotationBits );
+    uint32 indexMode = r.read( m.indexModeBits );
+
+    sint32 ep[3][2][4];
+    for( uint32 c = 0; c < 3; ++c )
+        for( uint32 s = 0; s < m.subsets; ++s )
+            for( uint32 e = 0; e < 2; ++e )
+                ep[s][e][c] = (sint32)r.read( m.colorBits );
+    for( uint32 s = 0; s < m.subsets; ++s )
+        for( uint32 e = 0; e < 2; ++e )
+            ep[s][e][3] = m.alphaBits ? (sint32)r.read( m.alphaBits ) : 255;
+
+    // p-bits, then expand to 8 bits.
+    uint32 colorBits = m.colorBits, alphaBits = m.alphaBits;
+    if( m.endpointPBits || m.sharedPBits )
+    {
+        for( uint32 s = 0; s < m.subsets; ++s )
+        {
+            sint32 p0 = (sint32)r.read( 1 );
+            sint32 p1 = m.endpointPBits ? (sint32)r.read( 1 ) : p0;
+            for( uint32 c = 0; c < ( m.alphaBits ? 4u : 3u ); ++c )
+            {
+                ep[s][0][c] = ( ep[s][0][c] << 1 ) | p0;
+                ep[s][1][c] = ( ep[s][1][c] << 1 ) | p1;
+            }
+        }
+        ++colorBits;
+        if( alphaBits ) ++alphaBits;
+    }
+    for( uint32 s = 0; s < m.subsets; ++s )
+        for( uint32 e = 0; e < 2; ++e )
+        {
+            for( uint32 c = 0; c < 3; ++c ) ep[s][e][c] = sBc7Expand( ep[s][e][c], colorBits );
+            if( alphaBits ) ep[s][e][3] = sBc7Expand( ep[s][e][3], alphaBits );
+        }
+
+    uint32 indices[16], indices2[16];
+    for( uint32 i = 0; i < 16; ++i )
+    {
+        uint32 s = sBc7Subset( m.subsets, partition, i );
+        indices[i] = r.read( m.indexBits - ( i == sBc7Anchor( m.subsets, partition, s ) ? 1 : 0 ) );
+    }
+    if( m.index2Bits )
+    {
+        for( uint32 i = 0; i < 16; ++i ) indices2[i] = r.read( m.index2Bits - ( 0 == i ? 1 : 0 ) );
+    }
+
+    for( uint32 i = 0; i < 16; ++i )
+    {
+        const sint32 (*e)[4] = ep[sBc7Subset( m.subsets, partition, i )];
+        sint32 wc, wa;
+        if( !m.index2Bits )
+        {
+            wc = wa = sBc7Weights( m.indexBits )[indices[i]];
+        }
+        else if( indexMode )
+        {
+            wc = sBc7Weights( m.index2Bits )[indices2[i]];
+            wa = sBc7Weights( m.indexBits )[indices[i]];
+        }
+        else
+        {
+            wc = sBc7Weights( m.indexBits )[indices[i]];
+            wa = sBc7Weights( m.index2Bits )[indices2[i]];
+        }
+        for( uint32 c = 0; c < 3; ++c ) px.c[i][c] = sBc7Interpolate( e[0][c], e[1][c], wc );
+        px.c[i][3] = sBc7Interpolate( e[0][3], e[1][3], wa );
+        if( rotation > 0 ) std::swap( px.c[i][rotation - 1], px.c[i][3] );
+    }
+}
+
+// *****************************************************************************
+// codec table
+// *****************************************************************************
+
+static const BlockCodec sBlockCodecs[] =
+{
+    { ColorFormat::LAYOUT_DXT1,  8,  false, sEncodeBc1, sDecodeBc1 },
+    { ColorFormat::LAYOUT_DXT3,  16, false, sEncodeBc2, sDecodeBc2 },
+    { ColorFormat::LAYOUT_DXT5,  16, false, sEncodeBc3, sDecodeBc3 },
+    { ColorFormat::LAYOUT_DXT5A, 8,  true,  sEncodeBc4, sDecodeBc4 },
+    { ColorFormat::LAYOUT_DXN,   16, true,  sEncodeBc5, sDecodeBc5 },
+    { ColorFormat::LAYOUT_BC7,   16, false, sEncodeBc7, sDecodeBc7 },
+};
+
+///
+/// Return codec of the format, or NULL. Color channels could be UNORM, or SNORM for BC4/BC5,
+/// or GNORM (sRGB) for the others. Alpha must be UNORM.
+// -----------------------------------------------------------------------------
+static const BlockCodec * sGetBlockCodec( ColorFormat format )
+{
+    if( !format.valid() ) return NULL;
+    for( size_t i = 0; i < GN_ARRAY_COUNT( sBlockCodecs ); ++i )
+    {
+        const BlockCodec & c = sBlockCodecs[i];
+        if( c.layout != format.layout ) continue;
+        bool signOk =
+            ColorFormat::SIGN_UNORM == format.sign012 ||
+            ( c.allowSnorm ? ColorFormat::SIGN_SNORM : ColorFormat::SIGN_GNORM ) == format.sign012;
+        bool alphaOk =
+            ColorFormat::SIGN_UNORM == format.sign3 ||
+            ( c.allowSnorm && format.sign3 == format.sign012 );
+        return signOk && alphaOk ? &c : NULL;
+    }
+    return NULL;
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::isCompressibleColorFormat( ColorFormat format )
+{
+    return NULL != sGetBlockCodec( format );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API GN::gfx::ColorFormat GN::gfx::getUncompressedColorFormat( ColorFormat format )
+{
+    if( !sGetBlockCodec( format ) ) return ColorFormat::UNKNOWN;
+    if( ColorFormat::SIGN_SNORM == format.sign012 ) return ColorFormat::RGBA_8_8_8_8_SNORM;
+    if( ColorFormat::SIGN_GNORM == format.sign012 ) return ColorFormat::RGBA_8_8_8_8_UNORM_SRGB;
+    return ColorFormat::RGBA_8_8_8_8_UNORM;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::encodeBlocks( ColorFormat format, const void * pixels, size_t pitch, void * blocks, size_t count, BlockCompressionQuality quality )
+{
+    const BlockCodec * codec = sGetBlockCodec( format );
+    if( !codec )
+    {
+        GN_ERROR(sLogger)( "Can't encode color format %s.", format.toString().rawptr() );
+        return false;
+    }
+
+    bool snorm = ColorFormat::SIGN_SNORM == format.sign012;
+    uint8 * dst = (uint8*)blocks;
+    for( size_t b = 0; b < count; ++b, dst += codec->blockBytes )
+    {
+        Pixels px;
+        for( int y = 0; y < 4; ++y )
+        {
+            const uint8 * row = (const uint8*)pixels + y * pitch + b * 16;
+            for( int x = 0; x < 4; ++x )
+                for( int c = 0; c < 4; ++c )
+                {
+                    uint8 v = row[x * 4 + c];
+                    px.c[y * 4 + x][c] = snorm ? math::getmax<sint32>( (sint8)v, -127 ) : v;
+                }
+        }
+        codec->encode( dst, px, snorm, quality );
+    }
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::decodeBlocks( ColorFormat format, const void * blocks, size_t count, void * pixels, size_t pitch )
+{
+    const BlockCodec * codec = sGetBlockCodec( format );
+    if( !codec )
+    {
+        GN_ERROR(sLogger)( "Can't decode color format %s.", format.toString().rawptr() );
+        return false;
+    }
+
+    bool snorm = ColorFormat::SIGN_SNORM == format.sign012;
+    const uint8 * src = (const uint8*)blocks;
+    for( size_t b = 0; b < count; ++b, src += codec->blockBytes )
+    {
+        Pixels px;
+        codec->decode( src, px, snorm );
+        for( int y = 0; y < 4; ++y )
+        {
+            uint8 * row = (uint8*)pixels + y * pitch + b * 16;
+            for( int x = 0; x < 4; ++x )
+                for( int c = 0; c < 4; ++c )
+                    row[x * 4 + c] = (uint8)px.c[y * 4 + x][c];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,882 @@
+#include "pch.h"
+#include <algorithm>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.colorConvert");
+
+// *****************************************************************************
+// local types
+// *****************************************************************************
+
+namespace
+{
+    /// pixels converted at a time through the float RGBA buffer
+    const size_t CHUNK_SIZE = 64;
+
+    struct PixelCodec;
+
+    typedef void (*DecodeFunc)( const PixelCodec &, const uint8 * src, Vector4f * dst, size_t count );
+    typedef void (*EncodeFunc)( const PixelCodec &, const Vector4f * src, uint8 * dst, size_t count );
+    typedef void (*DirectFunc)( const uint8 * src, uint8 * dst, size_t count );
+
+    ///
+    /// how to read and write pixels of one color format, built from the layout table.
+    ///
+    struct PixelCodec
+    {
+        struct Channel
+        {
+            uint32 shift;  ///< bit offset in the pixel
+            uint32 bits;
+            uint32 sign;   ///< ColorFormat::Sign
+            uint32 rgba;   ///< RGBA component that is written to this channel, 4 if none
+            float  scale;  ///< 1 / maximum value, for normalized channels
+        };
+
+        uint32     bytes;        ///< bytes per pixel
+        uint32     numChannels;
+        Channel    channels[4];
+        uint32     swizzle[4];   ///< where R, G, B and A come from: channel 0-3, SWIZZLE_0 or SWIZZLE_1
+        DecodeFunc decode;
+        EncodeFunc encode;
+    };
+
+    ///
+    /// sRGB tables of 8-bit channels
+    ///
+    struct Srgb8Tables
+    {
+        float toLinear[256];
+
+        /// encoded value of linear c is the number of thresholds not greater than c. The last
+        /// one is a sentinel, greater than 1.
+        float thresholds[256];
+
+        /// encoded value of the start of each of 4096 equal ranges in [0, 1]. Thresholds are
+        /// farther apart than the ranges, so no more than one of them is in a range.
+        uint8 buckets[4096];
+
+        Srgb8Tables();
+    };
+}
+
+// *****************************************************************************
+// channel conversion
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline float sSrgbToLinear( float c )
+{
+    return c <= 0.04045f ? c / 12.92f : powf( ( c + 0.055f ) / 1.055f, 2.4f );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline float sLinearToSrgb( float c )
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * powf( c, 1.0f / 2.4f ) - 0.055f;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+Srgb8Tables::Srgb8Tables()
+{
+    for( int i = 0; i < 256; ++i ) toLinear[i] = sSrgbToLinear( (float)i / 255.0f );
+    for( int i = 0; i < 255; ++i ) thresholds[i] = sSrgbToLinear( ( (float)i + 0.5f ) / 255.0f );
+    thresholds[255] = 2.0f;
+    for( int i = 0; i < 4096; ++i ) buckets[i] = (uint8)( std::upper_bound( thresholds, thresholds + 255, (float)i / 4096.0f ) - thresholds );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static const Srgb8Tables & sSrgb8()
+{
+    static const Srgb8Tables sTables;
+    return sTables;
+}
+
+///
+/// Linear [0, 1] to 8-bit sRGB. Exact inverse of Srgb8Tables::toLinear.
+// -----------------------------------------------------------------------------
+static inline uint32 sEncodeSrgb8( const Srgb8Tables & t, float c )
+{
+    c = c > 0.0f ? math::getmin( c, 1.0f ) : 0.0f; // and NaN
+    uint32 e = t.buckets[math::getmin( (uint32)( c * 4096.0f ), 4095u )];
+    return e + ( c >= t.thresholds[e] );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static float sHalfToFloat( uint32 h )
+{
+    uint32 s = ( h & 0x8000 ) << 16;
+    uint32 e = ( h >> 10 ) & 0x1F;
+    uint32 m = h & 0x3FF;
+    uint32 f;
+    if( 0 == e )
+    {
+        // zero and denormals: m * 2^-24
+        float v = (float)m * ( 1.0f / 16777216.0f );
+        return s ? -v : v;
+    }
+    else if( 31 == e )
+    {
+        f = s | 0x7F800000 | ( m << 13 );
+    }
+    else
+    {
+        f = s | ( ( e + 112 ) << 23 ) | ( m << 13 );
+    }
+    float r;
+    memcpy( &r, &f, 4 );
+    return r;
+}
+
+///
+/// float to half, rounded to nearest even.
+// -----------------------------------------------------------------------------
+static uint32 sFloatToHalf( float v )
+{
+    uint32 f;
+    memcpy( &f, &v, 4 );
+    uint32 s = ( f >> 16 ) & 0x8000;
+    uint32 a = f & 0x7FFFFFFF;
+
+    if( a > 0x7F800000 ) return s | 0x7E00;           // NaN
+    if( a >= 0x477FF000 ) return s | 0x7C00;          // overflow to infinity
+    if( a < 0x38800000 )
+    {
+        // denormal, in units of 2^-24. Might round up to the smallest normal.
+        return s | (uint32)lrintf( fabsf( v ) * 16777216.0f );
+    }
+
+    // rebias exponent, and round mantissa. Carry goes to exponent.
+    uint32 r = a - ( 112u << 23 );
+    return s | ( ( r + 0xFFF + ( ( r >> 13 ) & 1 ) ) >> 13 );
+}
+
+///
+/// Read bits of a channel, in little endian order.
+// -----------------------------------------------------------------------------
+static inline uint32 sReadBits( const uint8 * pixel, uint32 shift, uint32 bits )
+{
+    const uint8 * p = pixel + ( shift >> 3 );
+    uint32 bit = shift & 7;
+    uint32 n = ( bit + bits + 7 ) >> 3;
+    uint64 v = 0;
+    for( uint32 i = 0; i < n; ++i ) v |= (uint64)p[i] << ( i * 8 );
+    return (uint32)( ( v >> bit ) & ( ( (uint64)1 << bits ) - 1 ) );
+}
+
+///
+/// Write bits of a channel. Bits of the channel must be zero.
+// -----------------------------------------------------------------------------
+static inline void sWriteBits( uint8 * pixel, uint32 shift, uint32 bits, uint32 value )
+{
+    uint8 * p = pixel + ( shift >> 3 );
+    uint32 bit = shift & 7;
+    uint32 n = ( bit + bits + 7 ) >> 3;
+    uint64 v = ( (uint64)value & ( ( (uint64)1 << bits ) - 1 ) ) << bit;
+    for( uint32 i = 0; i < n; ++i ) p[i] |= (uint8)( v >> ( i * 8 ) );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline sint32 sSignExtend( uint32 v, uint32 bits )
+{
+    return (sint32)( v << ( 32 - bits ) ) >> ( 32 - bits );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline float sDecodeChannel( const PixelCodec::Channel & c, uint32 v )
+{
+    switch( c.sign )
+    {
+        case ColorFormat::SIGN_UNORM:
+            return c.bits > 24 ? (float)( (double)v / 4294967295.0 ) : (float)v * c.scale;
+
+        case ColorFormat::SIGN_SNORM:
+        {
+            sint32 i = sSignExtend( v, c.bits );
+            float f = c.bits > 24 ? (float)( (double)i / 2147483647.0 ) : (float)i * c.scale;
+            return f < -1.0f ? -1.0f : f;
+        }
+
+        case ColorFormat::SIGN_GNORM:
+            return 8 == c.bits ? sSrgb8().toLinear[v] : sSrgbToLinear( (float)v * c.scale );
+
+        case ColorFormat::SIGN_UINT:
+            return (float)v;
+
+        case ColorFormat::SIGN_SINT:
+            return (float)sSignExtend( v, c.bits );
+
+        case ColorFormat::SIGN_FLOAT:
+        {
+            if( 16 == c.bits ) return sHalfToFloat( v );
+            float f;
+            memcpy( &f, &v, 4 );
+            return f;
+        }
+
+        default:
+            GN_UNEXPECTED();
+            return 0;
+    }
+}
+
+///
+/// clamp to [0, 1]. NaN goes to 0.
+// -----------------------------------------------------------------------------
+static inline float sSaturate( float v )
+{
+    return !( v > 0.0f ) ? 0.0f : ( v > 1.0f ? 1.0f : v );
+}
+
+///
+/// clamp to [lo, hi]. NaN goes to 0.
+// -----------------------------------------------------------------------------
+static inline double sClamp( float v, double lo, double hi )
+{
+    if( v != v ) return 0;
+    return v < lo ? lo : ( v > hi ? hi : (double)v );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static inline uint32 sEncodeChannel( const PixelCodec::Channel & c, float v )
+{
+    double maxu = (double)( ( (uint64)1 << c.bits ) - 1 );
+    double maxs = (double)( ( (uint64)1 << ( c.bits - 1 ) ) - 1 );
+
+    switch( c.sign )
+    {
+        case ColorFormat::SIGN_UNORM:
+            if( c.bits > 24 ) return (uint32)llrint( (double)sSaturate( v ) * maxu );
+            return (uint32)lrintf( sSaturate( v ) * (float)maxu );
+
+        case ColorFormat::SIGN_SNORM:
+        {
+            float f = v < -1.0f ? -1.0f : ( v > 1.0f ? 1.0f : ( v == v ? v : 0.0f ) );
+            if( c.bits > 24 ) return (uint32)(sint32)llrint( (double)f * maxs );
+            return (uint32)lrintf( f * (float)maxs );
+        }
+
+        case ColorFormat::SIGN_GNORM:
+            if( 8 == c.bits ) return sEncodeSrgb8( sSrgb8(), v );
+            return (uint32)lrintf( sLinearToSrgb( sSaturate( v ) ) * (float)maxu );
+
+        case ColorFormat::SIGN_UINT:
+            return (uint32)llrint( sClamp( v, 0, maxu ) );
+
+        case ColorFormat::SIGN_SINT:
+            return (uint32)(sint32)llrint( sClamp( v, -maxs - 1, maxs ) );
+
+        case ColorFormat::SIGN_FLOAT:
+        {
+            if( 16 == c.bits ) return sFloatToHalf( v );
+            uint32 u;
+            memcpy( &u, &v, 4 );
+            return u;
+        }
+
+        default:
+            GN_UNEXPECTED();
+            return 0;
+    }
+}
+
+// *****************************************************************************
+// pixel codecs
+// *****************************************************************************
+
+///
+/// Decode any convertible format, one channel at a time.
+// -----------------------------------------------------------------------------
+static void sDecodeGeneric( const PixelCodec & codec, const uint8 * src, Vector4f * dst, size_t count )
+{
+    // indexed by swizzle: channel 0-3, then constant 0 and 1.
+    float values[6] = { 0, 0, 0, 0, 0, 1 };
+
+    for( size_t i = 0; i < count; ++i, src += codec.bytes )
+    {
+        for( uint32 k = 0; k < codec.numChannels; ++k )
+        {
+            const PixelCodec::Channel & c = codec.channels[k];
+            values[k] = sDecodeChannel( c, sReadBits( src, c.shift, c.bits ) );
+        }
+        dst[i].set( values[codec.swizzle[0]], values[codec.swizzle[1]], values[codec.swizzle[2]], values[codec.swizzle[3]] );
+    }
+}
+
+///
+/// Encode any convertible format, one channel at a time.
+// -----------------------------------------------------------------------------
+static void sEncodeGeneric( const PixelCodec & codec, const Vector4f * src, uint8 * dst, size_t count )
+{
+    for( size_t i = 0; i < count; ++i, dst += codec.bytes )
+    {
+        const float rgba[5] = { src[i].x, src[i].y, src[i].z, src[i].w, 1.0f };
+        memset( dst, 0, codec.bytes );
+        for( uint32 k = 0; k < codec.numChannels; ++k )
+        {
+            const PixelCodec::Channel & c = codec.channels[k];
+            sWriteBits( dst, c.shift, c.bits, sEncodeChannel( c, rgba[c.rgba] ) );
+        }
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sDecodeFloat4( const PixelCodec &, const uint8 * src, Vector4f * dst, size_t count )
+{
+    memcpy( dst, src, count * sizeof(Vector4f) );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sEncodeFloat4( const PixelCodec &, const Vector4f * src, uint8 * dst, size_t count )
+{
+    memmove( dst, src, count * sizeof(Vector4f) );
+}
+
+///
+/// 8-bit RGBA/BGRA/RGBX/BGRX UNORM to float, 4 pixels a time.
+// -----------------------------------------------------------------------------
+template<bool BGR, bool X>
+static void sDecode8888( const PixelCodec &, const uint8 * src, Vector4f * dst, size_t count )
+{
+    const float scale = 1.0f / 255.0f;
+    size_t i = 0;
+
+#if GN_SIMD
+    using namespace simd;
+    const Float4 vscale = splat( scale );
+    const Float4 one = splat( 1.0f );
+    const Float4 wmask = cmpeq( set( 0, 0, 0, 1 ), one );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Int4 p[4];
+        unpackBytes( loadInt( src + i * 4 ), p[0], p[1], p[2], p[3] );
+        for( int k = 0; k < 4; ++k )
+        {
+            Float4 f = mul( toFloat( p[k] ), vscale );
+            if( BGR ) f = shuffle<2, 1, 0, 3>( f );
+            if( X ) f = select( wmask, one, f );
+            store( &dst[i + k].x, f );
+        }
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const uint8 * p = src + i * 4;
+        float r = (float)p[BGR ? 2 : 0] * scale;
+        float g = (float)p[1] * scale;
+        float b = (float)p[BGR ? 0 : 2] * scale;
+        float a = X ? 1.0f : (float)p[3] * scale;
+        dst[i].set( r, g, b, a );
+    }
+}
+
+///
+/// float to 8-bit RGBA/BGRA/RGBX/BGRX UNORM, 4 pixels a time.
+// -----------------------------------------------------------------------------
+template<bool BGR, bool X>
+static void sEncode8888( const PixelCodec &, const Vector4f * src, uint8 * dst, size_t count )
+{
+    size_t i = 0;
+
+#if GN_SIMD
+    using namespace simd;
+    const Float4 zero4 = zero();
+    const Float4 one = splat( 1.0f );
+    const Float4 s255 = splat( 255.0f );
+    const Float4 wmask = cmpeq( set( 0, 0, 0, 1 ), one );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Int4 q[4];
+        for( int k = 0; k < 4; ++k )
+        {
+            Float4 f = load( &src[i + k].x );
+            if( BGR ) f = shuffle<2, 1, 0, 3>( f );
+            if( X ) f = select( wmask, one, f );
+            f = minimum( maximum( f, zero4 ), one ); // max() first, so NaN goes to 0
+            q[k] = toInt( mul( f, s255 ) );
+        }
+        storeInt( dst + i * 4, packBytes( q[0], q[1], q[2], q[3] ) );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        uint8 * p = dst + i * 4;
+        const Vector4f & c = src[i];
+        p[BGR ? 2 : 0] = (uint8)lrintf( sSaturate( c.x ) * 255.0f );
+        p[1]           = (uint8)lrintf( sSaturate( c.y ) * 255.0f );
+        p[BGR ? 0 : 2] = (uint8)lrintf( sSaturate( c.z ) * 255.0f );
+        p[3]           = X ? 255 : (uint8)lrintf( sSaturate( c.w ) * 255.0f );
+    }
+}
+
+///
+/// 8-bit sRGB RGBA to linear float, through lookup table.
+// -----------------------------------------------------------------------------
+static void sDecodeSrgba8( const PixelCodec &, const uint8 * src, Vector4f * dst, size_t count )
+{
+    const float * toLinear = sSrgb8().toLinear;
+    for( size_t i = 0; i < count; ++i, src += 4 )
+    {
+        dst[i].set( toLinear[src[0]], toLinear[src[1]], toLinear[src[2]], (float)src[3] * ( 1.0f / 255.0f ) );
+    }
+}
+
+///
+/// linear float to 8-bit sRGB RGBA, by binary search in the table.
+// -----------------------------------------------------------------------------
+static void sEncodeSrgba8( const PixelCodec &, const Vector4f * src, uint8 * dst, size_t count )
+{
+    const Srgb8Tables & t = sSrgb8();
+    for( size_t i = 0; i < count; ++i, dst += 4 )
+    {
+        const Vector4f & c = src[i];
+        dst[0] = (uint8)sEncodeSrgb8( t, c.x );
+        dst[1] = (uint8)sEncodeSrgb8( t, c.y );
+        dst[2] = (uint8)sEncodeSrgb8( t, c.z );
+        dst[3] = (uint8)lrintf( sSaturate( c.w ) * 255.0f );
+    }
+}
+
+///
+/// formats with their own decoder and encoder
+///
+static const struct
+{
+    ColorFormat::Alias format;
+    DecodeFunc         decode;
+    EncodeFunc         encode;
+}
+sFastCodecs[] =
+{
+    { ColorFormat::RGBA_8_8_8_8_UNORM,      sDecode8888<false, false>, sEncode8888<false, false> },
+    { ColorFormat::RGBX_8_8_8_8_UNORM,      sDecode8888<false, true>,  sEncode8888<false, true>  },
+    { ColorFormat::BGRA_8_8_8_8_UNORM,      sDecode8888<true, false>,  sEncode8888<true, false>  },
+    { ColorFormat::BGRX_8_8_8_8_UNORM,      sDecode8888<true, true>,   sEncode8888<true, true>   },
+    { ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, sDecodeSrgba8,             sEncodeSrgba8             },
+    { ColorFormat::RGBA_32_32_32_32_FLOAT,  sDecodeFloat4,             sEncodeFloat4             },
+};
+
+///
+/// Build pixel codec of a format. Return false, if the format is not convertible.
+// -----------------------------------------------------------------------------
+static bool sGetCodec( PixelCodec & codec, ColorFormat format )
+{
+    if( !format.valid() ) return false;
+
+    const ColorLayoutDesc & ld = format.layoutDesc();
+    if( 1 != ld.blockWidth || 1 != ld.blockHeight ) return false;
+    if( 0 == ld.bits || 0 != ( ld.bits % 8 ) ) return false;
+    if( 0 == ld.numChannels || ld.numChannels > 4 ) return false;
+
+    codec.bytes = ld.bits / 8;
+    codec.numChannels = ld.numChannels;
+
+    for( uint32 k = 0; k < codec.numChannels; ++k )
+    {
+        PixelCodec::Channel & c = codec.channels[k];
+        c.shift = ld.channels[k].shift;
+        c.bits  = ld.channels[k].bits;
+        c.sign  = 3 == k ? format.sign3 : format.sign012;
+        c.rgba  = 4;
+        c.scale = 0;
+        if( 0 == c.bits || c.bits > 32 || c.shift + c.bits > ld.bits ) return false;
+
+        switch( c.sign )
+        {
+            case ColorFormat::SIGN_UNORM :
+            case ColorFormat::SIGN_GNORM :
+                c.scale = 1.0f / (float)( ( (uint64)1 << c.bits ) - 1 );
+                break;
+
+            case ColorFormat::SIGN_SNORM :
+                if( c.bits < 2 ) return false;
+                c.scale = 1.0f / (float)( ( (uint64)1 << ( c.bits - 1 ) ) - 1 );
+                break;
+
+            case ColorFormat::SIGN_UINT :
+            case ColorFormat::SIGN_SINT :
+                break;
+
+            case ColorFormat::SIGN_FLOAT :
+                if( 16 != c.bits && 32 != c.bits ) return false;
+                break;
+
+            default:
+                // bias and gamma integers are not supported.
+                return false;
+        }
+    }
+
+    const uint32 swizzles[4] = { format.swizzle0, format.swizzle1, format.swizzle2, format.swizzle3 };
+    for( uint32 i = 0; i < 4; ++i )
+    {
+        uint32 s = swizzles[i];
+        if( s < 4 )
+        {
+            if( s >= codec.numChannels ) return false;
+            if( 4 == codec.channels[s].rgba ) codec.channels[s].rgba = i;
+        }
+        codec.swizzle[i] = s;
+    }
+
+    codec.decode = sDecodeGeneric;
+    codec.encode = sEncodeGeneric;
+    for( size_t i = 0; i < GN_ARRAY_COUNT( sFastCodecs ); ++i )
+    {
+        if( sFastCodecs[i].format == format )
+        {
+            codec.decode = sFastCodecs[i].decode;
+            codec.encode = sFastCodecs[i].encode;
+            break;
+        }
+    }
+
+    return true;
+}
+
+// *****************************************************************************
+// direct conversions
+// *****************************************************************************
+
+///
+/// between 8-bit RGBA, BGRA, RGBX and BGRX: swap R and B, and/or set alpha to 255.
+// -----------------------------------------------------------------------------
+template<bool SWAP, bool FORCE_ALPHA>
+static void sConvert8888( const uint8 * src, uint8 * dst, size_t count )
+{
+    size_t i = 0;
+
+#if GN_SIMD
+    using namespace simd;
+    const Int4 ag = splatInt( (sint32)0xFF00FF00 );
+    const Int4 lo = splatInt( 0xFF );
+    const Int4 alpha = splatInt( (sint32)0xFF000000 );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        Int4 v = loadInt( src + i * 4 );
+        if( SWAP ) v = orInt( andInt( v, ag ), orInt( andInt( shiftRight<16>( v ), lo ), shiftLeft<16>( andInt( v, lo ) ) ) );
+        if( FORCE_ALPHA ) v = orInt( v, alpha );
+        storeInt( dst + i * 4, v );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        const uint8 * s = src + i * 4;
+        uint8 * d = dst + i * 4;
+        uint8 r = s[0], g = s[1], b = s[2], a = s[3];
+        d[0] = SWAP ? b : r;
+        d[1] = g;
+        d[2] = SWAP ? r : b;
+        d[3] = FORCE_ALPHA ? 255 : a;
+    }
+}
+
+///
+/// 8-bit RGB/BGR to RGBA/BGRA.
+// -----------------------------------------------------------------------------
+template<bool SWAP>
+static void sConvert888To8888( const uint8 * src, uint8 * dst, size_t count )
+{
+    for( size_t i = 0; i < count; ++i, src += 3, dst += 4 )
+    {
+        dst[0] = SWAP ? src[2] : src[0];
+        dst[1] = src[1];
+        dst[2] = SWAP ? src[0] : src[2];
+        dst[3] = 255;
+    }
+}
+
+///
+/// format pairs that are converted without going through float
+///
+static const struct
+{
+    ColorFormat::Alias src;
+    ColorFormat::Alias dst;
+    DirectFunc         func;
+}
+sDirectConversions[] =
+{
+    { ColorFormat::RGBA_8_8_8_8_UNORM, ColorFormat::BGRA_8_8_8_8_UNORM, sConvert8888<true, false>  },
+    { ColorFormat::BGRA_8_8_8_8_UNORM, ColorFormat::RGBA_8_8_8_8_UNORM, sConvert8888<true, false>  },
+    { ColorFormat::RGBA_8_8_8_8_UNORM, ColorFormat::RGBX_8_8_8_8_UNORM, sConvert8888<false, true>  },
+    { ColorFormat::RGBX_8_8_8_8_UNORM, ColorFormat::RGBA_8_8_8_8_UNORM, sConvert8888<false, true>  },
+    { ColorFormat::BGRA_8_8_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM, sConvert8888<false, true>  },
+    { ColorFormat::BGRX_8_8_8_8_UNORM, ColorFormat::BGRA_8_8_8_8_UNORM, sConvert8888<false, true>  },
+    { ColorFormat::RGBA_8_8_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::BGRX_8_8_8_8_UNORM, ColorFormat::RGBA_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::BGRA_8_8_8_8_UNORM, ColorFormat::RGBX_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::RGBX_8_8_8_8_UNORM, ColorFormat::BGRA_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::RGBX_8_8_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::BGRX_8_8_8_8_UNORM, ColorFormat::RGBX_8_8_8_8_UNORM, sConvert8888<true, true>   },
+    { ColorFormat::RGB_8_8_8_UNORM,    ColorFormat::RGBA_8_8_8_8_UNORM, sConvert888To8888<false>   },
+    { ColorFormat::BGR_8_8_8_UNORM,    ColorFormat::RGBA_8_8_8_8_UNORM, sConvert888To8888<true>    },
+    { ColorFormat::RGB_8_8_8_UNORM,    ColorFormat::BGRA_8_8_8_8_UNORM, sConvert888To8888<true>    },
+    { ColorFormat::BGR_8_8_8_UNORM,    ColorFormat::BGRA_8_8_8_8_UNORM, sConvert888To8888<false>   },
+};
+
+// *****************************************************************************
+// PixelConverter
+// *****************************************************************************
+
+namespace
+{
+    ///
+    /// Convert pixels between two formats, with everything looked up once.
+    ///
+    struct PixelConverter
+    {
+        PixelCodec src;
+        PixelCodec dst;
+        DirectFunc direct;
+        bool       copy;
+
+        bool init( ColorFormat srcFormat, ColorFormat dstFormat )
+        {
+            if( !sGetCodec( src, srcFormat ) )
+            {
+                GN_ERROR(sLogger)( "Can't convert from color format %s.", srcFormat.toString().rawptr() );
+                return false;
+            }
+            if( !sGetCodec( dst, dstFormat ) )
+            {
+                GN_ERROR(sLogger)( "Can't convert to color format %s.", dstFormat.toString().rawptr() );
+                return false;
+            }
+
+            copy = srcFormat == dstFormat;
+            direct = NULL;
+            for( size_t i = 0; i < GN_ARRAY_COUNT( sDirectConversions ); ++i )
+            {
+                if( sDirectConversions[i].src == srcFormat && sDirectConversions[i].dst == dstFormat )
+                {
+                    direct = sDirectConversions[i].func;
+                    break;
+                }
+            }
+            return true;
+        }
+
+        void convert( const uint8 * s, uint8 * d, size_t count ) const
+        {
+            if( copy )
+            {
+                if( s != d ) memmove( d, s, count * src.bytes );
+                return;
+            }
+
+            if( direct )
+            {
+                direct( s, d, count );
+                return;
+            }
+
+            // skip the float buffer, if either side is float RGBA already.
+            if( sDecodeFloat4 == dst.decode && 0 == ( (size_t)d & 3 ) )
+            {
+                src.decode( src, s, (Vector4f*)d, count );
+                return;
+            }
+            if( sDecodeFloat4 == src.decode && 0 == ( (size_t)s & 3 ) )
+            {
+                dst.encode( dst, (const Vector4f*)s, d, count );
+                return;
+            }
+
+            Vector4f buffer[CHUNK_SIZE];
+            while( count > 0 )
+            {
+                size_t n = math::getmin( count, CHUNK_SIZE );
+                src.decode( src, s, buffer, n );
+                dst.encode( dst, buffer, d, n );
+                s += n * src.bytes;
+                d += n * dst.bytes;
+                count -= n;
+            }
+        }
+    };
+}
+
+///
+/// Convert one image, optionally in parallel.
+// -----------------------------------------------------------------------------
+static bool sConvertImage( const ImageDesc & srcDesc, const void * src, ColorFormat dstFormat, RawImage & dst, JobSystem * js, BlockCompressionQuality quality )
+{
+    if( srcDesc.empty() || !srcDesc.valid() || NULL == src )
+    {
+        GN_ERROR(sLogger)( "Invalid source image." );
+        return false;
+    }
+
+    // block compressed formats convert through their uncompressed pixel formats.
+    ColorFormat srcFormat = srcDesc.format();
+    bool decode = isCompressibleColorFormat( srcFormat );
+    bool encode = isCompressibleColorFormat( dstFormat );
+    ColorFormat srcPixelFormat = decode ? getUncompressedColorFormat( srcFormat ) : srcFormat;
+    ColorFormat dstPixelFormat = encode ? getUncompressedColorFormat( dstFormat ) : dstFormat;
+
+    PixelConverter conv;
+    if( !conv.init( srcPixelFormat, dstPixelFormat ) ) return false;
+    for( size_t i = 0; i < srcDesc.planes.size(); ++i )
+    {
+        if( srcDesc.planes[i].format != srcDesc.format() )
+        {
+            GN_ERROR(sLogger)( "All planes of the source image must have the same format." );
+            return false;
+        }
+    }
+
+    const ImagePlaneDesc & base = srcDesc.plane();
+    RawImage image( ImageDesc( ImagePlaneDesc::make( dstFormat, base.width, base.height, base.depth ), srcDesc.layers, srcDesc.levels ) );
+    if( image.empty() || NULL == image.data() || image.desc().planes.size() != srcDesc.planes.size() )
+    {
+        GN_ERROR(sLogger)( "Failed to create destination image." );
+        return false;
+    }
+
+    for( uint32 level = 0; level < srcDesc.levels; ++level )
+    for( uint32 layer = 0; layer < srcDesc.layers; ++layer )
+    {
+        const ImagePlaneDesc & sp = srcDesc.plane( layer, level );
+        const ImagePlaneDesc & dp = image.desc( layer, level );
+        GN_ASSERT( sp.width == dp.width && sp.height == dp.height && sp.depth == dp.depth );
+
+        const uint8 * s = (const uint8*)src;
+        uint8 * d = image.data();
+
+        if( decode || encode )
+        {
+            // Strips of 4 pixel rows, as wide as whole blocks. Rows and columns beyond the
+            // image replicate the last ones, so padding pixels do not skew end points.
+            size_t blocksX = ( sp.width + 3 ) / 4;
+            size_t stripPitch = blocksX * 16;
+            size_t numStrips = ( sp.height + 3 ) / 4 * sp.depth;
+            auto strips = [&]( size_t begin, size_t end ) {
+                DynaArray<uint8> decoded( decode ? stripPitch * 4 : 0 );
+                DynaArray<uint8> pixels( encode ? stripPitch * 4 : 0 );
+                for( size_t t = begin; t < end; ++t )
+                {
+                    size_t blocksY = ( sp.height + 3 ) / 4;
+                    uint32 y0 = (uint32)( t % blocksY * 4 ), z = (uint32)( t / blocksY );
+                    if( decode ) decodeBlocks( srcFormat, s + sp.pixel( 0, y0, z ), blocksX, decoded.rawptr(), stripPitch );
+                    for( uint32 i = 0; i < 4; ++i )
+                    {
+                        uint32 y = math::getmin( y0 + i, sp.height - 1 );
+                        const uint8 * from = decode ? decoded.rawptr() + ( y - y0 ) * stripPitch : s + sp.pixel( 0, y, z );
+                        if( encode )
+                        {
+                            uint8 * row = pixels.rawptr() + i * stripPitch;
+                            conv.convert( from, row, sp.width );
+                            for( size_t x = sp.width; x < blocksX * 4; ++x ) memcpy( row + x * 4, row + ( sp.width - 1 ) * 4, 4 );
+                        }
+                        else if( y0 + i < sp.height )
+                        {
+                            conv.convert( from, d + dp.pixel( 0, y, z ), sp.width );
+                        }
+                    }
+                    if( encode ) encodeBlocks( dstFormat, pixels.rawptr(), stripPitch, d + dp.pixel( 0, y0, z ), blocksX, quality );
+                }
+            };
+
+            if( js && numStrips > 1 )
+            {
+                // encoding is slow, so a few blocks per job is enough.
+                size_t grain = encode ? math::getmax<size_t>( 1, 256 / blocksX ) : math::getmax<size_t>( 1, 1024 / blocksX );
+                js->parallelFor( 0, numStrips, strips, grain, "convert image blocks" );
+            }
+            else
+            {
+                strips( 0, numStrips );
+            }
+            continue;
+        }
+
+        auto rows = [&]( size_t begin, size_t end ) {
+            for( size_t r = begin; r < end; ++r )
+            {
+                size_t y = r % sp.height, z = r / sp.height;
+                conv.convert( s + sp.pixel( 0, y, z ), d + dp.pixel( 0, y, z ), sp.width );
+            }
+        };
+
+        size_t numRows = (size_t)sp.height * sp.depth;
+        if( js && numRows > 1 )
+        {
+            // a few thousand pixels per job.
+            size_t grain = math::getmax<size_t>( 1, 4096 / sp.width );
+            js->parallelFor( 0, numRows, rows, grain, "convert image" );
+        }
+        else
+        {
+            rows( 0, numRows );
+        }
+    }
+
+    dst = std::move( image );
+    return true;
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::isConvertibleColorFormat( ColorFormat format )
+{
+    PixelCodec codec;
+    return sGetCodec( codec, format );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::convertPixels( ColorFormat srcFormat, const void * src, ColorFormat dstFormat, void * dst, size_t count )
+{
+    PixelConverter conv;
+    if( !conv.init( srcFormat, dstFormat ) ) return false;
+    conv.convert( (const uint8*)src, (uint8*)dst, count );
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::convertImage( const ImageDesc & srcDesc, const void * src, ColorFormat dstFormat, RawImage & dst, BlockCompressionQuality quality )
+{
+    return sConvertImage( srcDesc, src, dstFormat, dst, NULL, quality );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::convertImage( const ImageDesc & srcDesc, const void * src, ColorFormat dstFormat, RawImage & dst, JobSystem & js, BlockCompressionQuality quality )
+{
+    return sConvertImage( srcDesc, src, dstFormat, dst, &js, quality );
+}
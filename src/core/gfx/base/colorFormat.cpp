@@ -183,6 +183,12 @@ enum DXGI_FORMAT
 	DXGI_FORMAT_B5G5R5A1_UNORM	= 86,
 	DXGI_FORMAT_B8G8R8A8_UNORM	= 87,
 	DXGI_FORMAT_B8G8R8X8_UNORM	= 88,
+	DXGI_FORMAT_BC6H_TYPELESS	= 94,
+	DXGI_FORMAT_BC6H_UF16	= 95,
+	DXGI_FORMAT_BC6H_SF16	= 96,
+	DXGI_FORMAT_BC7_TYPELESS	= 97,
+	DXGI_FORMAT_BC7_UNORM	= 98,
+	DXGI_FORMAT_BC7_UNORM_SRGB	= 99,
 	DXGI_FORMAT_FORCE_UINT	= 0xffffffffUL
 };
 
@@ -217,7 +223,7 @@ GN_API const GN::gfx::ColorLayoutDesc GN::gfx::ALL_COLOR_LAYOUTS[] =
     { 8 , 1 , 1  , 1   , 1 , { { 0 , 1  }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_1,
     { 1 , 1 , 1  , 8   , 2 , { { 0 , 4  }, { 4  , 4  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_4_4,
     { 1 , 1 , 2  , 16  , 4 , { { 0 , 4  }, { 4  , 4  }, { 8  , 4  }, { 12 , 4  } } }, //LAYOUT_4_4_4_4,
-    { 1 , 1 , 2  , 16  , 4 , { { 0 , 5  }, { 10 , 5  }, { 15 , 5  }, { 15 , 1  } } }, //LAYOUT_5_5_5_1,
+    { 1 , 1 , 2  , 16  , 4 , { { 0 , 5  }, { 5  , 5  }, { 10 , 5  }, { 15 , 1  } } }, //LAYOUT_5_5_5_1,
     { 1 , 1 , 2  , 16  , 3 , { { 0 , 5  }, { 5  , 6  }, { 11 , 5  }, { 0  , 0  } } }, //LAYOUT_5_6_5,
     { 1 , 1 , 1  , 8   , 1 , { { 0 , 8  }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_8,
     { 1 , 1 , 2  , 16  , 2 , { { 0 , 8  }, { 8  , 8  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_8_8,
@@ -228,7 +234,7 @@ GN_API const GN::gfx::ColorLayoutDesc GN::gfx::ALL_COLOR_LAYOUTS[] =
     { 1 , 1 , 4  , 32  , 4 , { { 0 , 10 }, { 10 , 10 }, { 20 , 10 }, { 30 , 2  } } }, //LAYOUT_10_10_10_2,
     { 1 , 1 , 2  , 16  , 1 , { { 0 , 16 }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_16,
     { 1 , 1 , 4  , 32  , 2 , { { 0 , 16 }, { 16 , 16 }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_16_16,
-    { 1 , 1 , 8  , 64  , 4 , { { 0 , 16 }, { 16 , 16 }, { 32 , 16 }, { 48 , 1  } } }, //LAYOUT_16_16_16_16,
+    { 1 , 1 , 8  , 64  , 4 , { { 0 , 16 }, { 16 , 16 }, { 32 , 16 }, { 48 , 16 } } }, //LAYOUT_16_16_16_16,
     { 1 , 1 , 4  , 32  , 1 , { { 0 , 32 }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_32,
     { 1 , 1 , 8  , 64  , 2 , { { 0 , 32 }, { 32 , 32 }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_32_32,
     { 1 , 1 , 12 , 96  , 3 , { { 0 , 32 }, { 32 , 32 }, { 64 , 32 }, { 0  , 0  } } }, //LAYOUT_32_32_32,
@@ -248,6 +254,7 @@ GN_API const GN::gfx::ColorLayoutDesc GN::gfx::ALL_COLOR_LAYOUTS[] =
     { 4 , 4 , 8  , 4   , 4 , { { 0 , 1  }, { 1  , 1  }, { 2  , 1  }, { 3  , 1  } } }, //LAYOUT_DXT3A_AS_1_1_1_1,
     { 2 , 1 , 4  , 16  , 4 , { { 0 , 0  }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_GRGB,
     { 2 , 1 , 4  , 16  , 4 , { { 0 , 0  }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_RGBG,
+    { 4 , 4 , 16 , 8   , 4 , { { 0 , 0  }, { 0  , 0  }, { 0  , 0  }, { 0  , 0  } } }, //LAYOUT_BC7,
 };
 //GN_CASSERT( GN_ARRAY_COUNT(GN::gfx::ALL_COLOR_LAYOUTS) == GN::gfx::NUM_COLOR_LAYOUTS );
 
@@ -346,7 +353,8 @@ GN_API void GN::gfx::ColorFormat::toString( GN::StrA & s ) const
                 "LAYOUT_CTX1",
                 "LAYOUT_DXT3A_AS_1_1_1_1",
                 "LAYOUT_GRGB",
-                "LAYOUT_RGBG"
+                "LAYOUT_RGBG",
+                "LAYOUT_BC7"
             };
 
             return ( layout < GN_ARRAY_COUNT(LAYOUT_STRING) ) ? LAYOUT_STRING[layout] : "INVALID_LAYOUT";
@@ -580,6 +588,12 @@ GN_API const char * GN::gfx::dxgiFormat2Str( int dxgifmt )
         { DXGI_FORMAT_B5G5R5A1_UNORM            , "DXGI_FORMAT_B5G5R5A1_UNORM" },
         { DXGI_FORMAT_B8G8R8A8_UNORM            , "DXGI_FORMAT_B8G8R8A8_UNORM" },
         { DXGI_FORMAT_B8G8R8X8_UNORM            , "DXGI_FORMAT_B8G8R8X8_UNORM" },
+        { DXGI_FORMAT_BC6H_TYPELESS             , "DXGI_FORMAT_BC6H_TYPELESS" },
+        { DXGI_FORMAT_BC6H_UF16                 , "DXGI_FORMAT_BC6H_UF16" },
+        { DXGI_FORMAT_BC6H_SF16                 , "DXGI_FORMAT_BC6H_SF16" },
+        { DXGI_FORMAT_BC7_TYPELESS              , "DXGI_FORMAT_BC7_TYPELESS" },
+        { DXGI_FORMAT_BC7_UNORM                 , "DXGI_FORMAT_BC7_UNORM" },
+        { DXGI_FORMAT_BC7_UNORM_SRGB            , "DXGI_FORMAT_BC7_UNORM_SRGB" },
     };
 
     for( size_t i = 0; i < sizeof(sTable)/sizeof(sTable[0]); ++i )
@@ -76,3 +76,5 @@ GN_DEFINE_COLOR_FORMAT_CONVERTION( DXT5A_UNORM                 , UNKNOWN       ,
 GN_DEFINE_COLOR_FORMAT_CONVERTION( DXT5A_SNORM                 , UNKNOWN       , BC4_SNORM                )
 GN_DEFINE_COLOR_FORMAT_CONVERTION( DXN_UNORM                   , UNKNOWN       , BC5_UNORM                )
 GN_DEFINE_COLOR_FORMAT_CONVERTION( DXN_SNORM                   , UNKNOWN       , BC5_SNORM                )
+GN_DEFINE_COLOR_FORMAT_CONVERTION( BC7_UNORM                   , UNKNOWN       , BC7_UNORM                )
+GN_DEFINE_COLOR_FORMAT_CONVERTION( BC7_UNORM_SRGB              , UNKNOWN       , BC7_UNORM_SRGB           )
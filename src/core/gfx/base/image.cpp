@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "imageDDS.h"
+#include "imageEXR.h"
+#include "imagePNG.h"
+#include "imageTGA.h"
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_ASSERT GN_ASSERT
 #define STBI_MALLOC GN::HeapMemory::alloc
@@ -175,6 +178,7 @@ GN_API void GN::gfx::ImageDesc::reset(const ImagePlaneDesc & basemap, uint32_t l
 
     // build full mipmap chain
     ImagePlaneDesc mip = basemap;
+    planes.clear();
     levels = 0;
     for(;;) {
         for(size_t i = 0; i < layers_; ++i) {
@@ -191,7 +195,9 @@ GN_API void GN::gfx::ImageDesc::reset(const ImagePlaneDesc & basemap, uint32_t l
         if (mip.width > 1) mip.width >>= 1;
         if (mip.height > 1) mip.height >>= 1;
         if (mip.depth > 1) mip.depth >>= 1;
+        auto offset = mip.offset;
         mip = ImagePlaneDesc::make(mip.format, mip.width, mip.height, mip.depth, mip.step, 0, 0, mip.rowAlignment);
+        mip.offset = offset;
     }
 
     layers = layers_;
@@ -205,6 +211,31 @@ GN_API void GN::gfx::ImageDesc::reset(const ImagePlaneDesc & basemap, uint32_t l
 // RawImage
 // *****************************************************************************
 
+///
+/// Read header and pixels with one of the image readers.
+// -----------------------------------------------------------------------------
+template<class READER>
+static GN::gfx::RawImage sReadImage(READER & reader) {
+    auto desc = reader.readHeader();
+    if (desc.empty()) return {};
+    auto image = RawImage(std::move(desc));
+    if (image.empty() || !reader.readPixels(image.data(), image.size())) return {};
+    return image;
+}
+
+///
+/// Convert loaded image to the requested format. UNKNOWN keeps the format of the file.
+// -----------------------------------------------------------------------------
+static GN::gfx::RawImage sConvertTo(GN::gfx::RawImage && image, GN::gfx::ColorFormat format) {
+    if (image.empty() || GN::gfx::ColorFormat::UNKNOWN == format || image.format() == format) return std::move(image);
+    GN::gfx::RawImage converted;
+    if (!GN::gfx::convertImage(image.desc(), image.data(), format, converted)) {
+        GN_ERROR(sLogger)("Failed to convert loaded image from %s to %s.", image.format().toString().rawptr(), format.toString().rawptr());
+        return {};
+    }
+    return converted;
+}
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -232,48 +263,165 @@ GN::gfx::RawImage::RawImage(ImageDesc&& desc, const void * initialContent, size_
 //
 //
 // -----------------------------------------------------------------------------
-GN::gfx::RawImage GN::gfx::RawImage::load(File & fp) {
+GN::gfx::RawImage GN::gfx::RawImage::load(File & fp, ColorFormat format) {
 
     auto begin = fp.tell();
+    auto end = fp.size();
+    size_t size = end > begin ? end - begin : 0;
+    if (0 == size) {
+        GN_ERROR(sLogger)("Failed to load image from file: empty file.");
+        return {};
+    }
 
-    // setup stbi io callback
-    stbi_io_callbacks io = {};
-    io.read = [](void* user, char* data, int size) -> int {
-        auto fp = (GN::File*)user;
-        size_t read = 0;
-        if (!fp->read(data, size, &read)) return 0;
-        return (int)read;
-    };
-    io.skip = [](void* user, int n) {
-        auto fp = (GN::File*)user;
-        fp->seek((size_t)n, GN::FileSeek::CUR);
-    };
-    io.eof = [](void* user) -> int {
-        auto fp = (GN::File*)user;
-        return fp->eof();
-    };
+    // decode in place, from memory mapping of the file
+    if (fp.caps().map) {
+        const void * data = fp.map(begin, size, true);
+        if (data) {
+            auto image = load(data, size, format);
+            fp.unmap();
+            return image;
+        }
+    }
 
-    // Load from common image file via stb_image library
-    // TODO: hdr/grayscale support
-    int x,y,n;
-    auto data = stbi_load_from_callbacks(&io, &fp, &x, &y, &n, 4);
-    if (data) {
-        auto image = RawImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA_8_8_8_8_UNORM, (uint32_t)x, (uint32_t)y)), data);
-        GN_ASSERT(image.desc().valid());
-        stbi_image_free(data);
-        return image;
+    // DDS reads pixels straight from the file.
+    DDSReader dds(fp);
+    if (dds.checkFormat()) {
+        return sConvertTo(sReadImage(dds), format);
     }
 
-    // try read as DDS
+    // others are decoded from memory
     fp.seek(begin, GN::FileSeek::SET);
-    DDSReader dds(fp);
+    DynaArray<uint8> buffer(size);
+    size_t read;
+    if (!fp.read(buffer.rawptr(), size, &read) || read != size) {
+        GN_ERROR(sLogger)("Failed to load image from file: read error.");
+        return {};
+    }
+    return load(buffer.rawptr(), size, format);
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::gfx::RawImage GN::gfx::RawImage::load(const void * data, size_t size, ColorFormat format) {
+
+    if (NULL == data || 0 == size) {
+        GN_ERROR(sLogger)("Failed to load image from memory: empty data.");
+        return {};
+    }
+
+    // EXR is decoded directly into the final image.
+    EXRReader exr(data, size);
+    if (exr.checkFormat()) {
+        return sConvertTo(sReadImage(exr), format);
+    }
+
+    MemFile<const uint8> mf((const uint8*)data, size);
+    DDSReader dds(mf);
     if (dds.checkFormat()) {
-        auto image = RawImage(dds.readHeader());
-        if (image.empty()) return {};
-        if (!dds.readPixels(image.data(), image.size())) return {};
-        return image;
+        return sConvertTo(sReadImage(dds), format);
     }
 
-    GN_ERROR(sLogger)("Failed to load image from file: unrecognized file format.");
+    // Load other common image files via stb_image library, keeping channel count, 16-bit
+    // channels, and float channels of HDR. There's no 3-channel 16-bit format. So 16-bit RGB
+    // gets alpha.
+    static const ColorFormat::Alias FORMATS[3][4] = {
+        { ColorFormat::L_8_UNORM,  ColorFormat::LA_8_8_UNORM,   ColorFormat::RGB_8_8_8_UNORM,    ColorFormat::RGBA_8_8_8_8_UNORM },
+        { ColorFormat::L_16_UNORM, ColorFormat::LA_16_16_UNORM, ColorFormat::UNKNOWN,            ColorFormat::RGBA_16_16_16_16_UNORM },
+        { ColorFormat::UNKNOWN,    ColorFormat::UNKNOWN,        ColorFormat::RGB_32_32_32_FLOAT, ColorFormat::RGBA_32_32_32_32_FLOAT },
+    };
+    auto stbData = (const stbi_uc*)data;
+    int x, y, n;
+    if (stbi_info_from_memory(stbData, (int)size, &x, &y, &n) && n >= 1 && n <= 4) {
+        int kind = stbi_is_hdr_from_memory(stbData, (int)size) ? 2 : stbi_is_16_bit_from_memory(stbData, (int)size) ? 1 : 0;
+        int channels = n;
+        while (ColorFormat::UNKNOWN == FORMATS[kind][channels - 1]) ++channels;
+        void * pixels = 2 == kind ? (void*)stbi_loadf_from_memory(stbData, (int)size, &x, &y, &n, channels)
+                      : 1 == kind ? (void*)stbi_load_16_from_memory(stbData, (int)size, &x, &y, &n, channels)
+                      : (void*)stbi_load_from_memory(stbData, (int)size, &x, &y, &n, channels);
+        if (pixels) {
+            // stb_image rows are packed, ours are aligned to 4 bytes. The image takes over the
+            // buffer of stb_image (allocated by HeapMemory), unless rows need padding.
+            ImageDesc desc(ImagePlaneDesc::make(FORMATS[kind][channels - 1], (uint32_t)x, (uint32_t)y));
+            GN_ASSERT(desc.valid());
+            const ImagePlaneDesc & plane = desc.plane(0, 0);
+            size_t rowBytes = (size_t)x * plane.step / 8;
+            if (plane.pitch == rowBytes && 0 == ((size_t)pixels % plane.rowAlignment)) {
+                return sConvertTo(RawImage(Adopt{}, std::move(desc), (uint8_t*)pixels), format);
+            }
+            auto image = RawImage(std::move(desc));
+            for (int row = 0; row < y; ++row) {
+                memcpy(image.pixel(0, 0, 0, row), (const uint8_t*)pixels + row * rowBytes, rowBytes);
+            }
+            stbi_image_free(pixels);
+            return sConvertTo(std::move(image), format);
+        }
+    }
+
+    GN_ERROR(sLogger)("Failed to load image: unrecognized file format.");
     return {};
 }
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::gfx::RawImage::verify(const void * data, size_t size) {
+    PNGChecker png(data, size);
+    if (png.checkFormat() && !png.checkChunks()) {
+        GN_ERROR(sLogger)("Corrupted PNG file.");
+        return false;
+    }
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::gfx::RawImage::load(JobSystem & js, const StrA * filenames, size_t count, RawImage * images, ColorFormat format) {
+    if (0 == count) return;
+    GN_ASSERT(filenames && images);
+    js.parallelFor(0, count, [filenames, images, format](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            images[i] = load(filenames[i], format);
+        }
+    }, 1, "load images");
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::gfx::RawImage::save(File & fp, ImageFileFormat format) const {
+    if (empty()) {
+        GN_ERROR(sLogger)("Can't save empty image.");
+        return false;
+    }
+
+    switch (format) {
+        case ImageFileFormat::DDS:
+        case ImageFileFormat::DDS_DX10:
+            return DDSWriter(fp).write(mDesc, mPixels, ImageFileFormat::DDS_DX10 == format);
+
+        case ImageFileFormat::PNG:
+            return PNGWriter(fp).write(mDesc.plane(0, 0), mPixels);
+
+        case ImageFileFormat::TGA:
+            return TGAWriter(fp).write(mDesc.plane(0, 0), mPixels);
+
+        default:
+            GN_ERROR(sLogger)("Invalid image file format: %d", (int)format);
+            return false;
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+AsyncResult<GN::gfx::RawImage> GN::gfx::RawImage::loadAsync(const StrA & filename, ColorFormat format, AsyncPriority priority, AsyncLoader & loader) {
+    // resolve relative path now, in case current directory changes before the load starts.
+    StrA fullFileName = fs::resolvePath(fs::getCurrentDir(), filename);
+
+    return loader.run<RawImage>("RawImage::loadAsync", priority, [fullFileName, format](RawImage & image) {
+        image = load(fullFileName, format);
+        return !image.empty();
+    });
+}
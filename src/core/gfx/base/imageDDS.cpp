@@ -34,8 +34,10 @@ enum DdsFlag
     DDS_DDSD_CAPS               = 0x00000001                     ,
     DDS_DDSD_HEIGHT             = 0x00000002                     ,
     DDS_DDSD_WIDTH              = 0x00000004                     ,
+    DDS_DDSD_PITCH              = 0x00000008                     ,
     DDS_DDSD_PIXELFORMAT        = 0x00001000                     ,
     DDS_DDSD_MIPMAPCOUNT        = 0x00020000                     ,
+    DDS_DDSD_LINEARSIZE         = 0x00080000                     ,
     DDS_DDSD_DEPTH              = 0x00800000                     ,
     DDS_CAPS_ALPHA              = 0x00000002                     ,
     DDS_CAPS_COMPLEX            = 0x00000008                     ,
@@ -63,6 +65,7 @@ enum DdsFlag
     DDS_FOURCC_G32R32F          = 115                            ,
     DDS_FOURCC_A32B32G32R32F    = 116                            ,
     DDS_FOURCC_CxV8U8           = 117                            ,
+    DDS_FOURCC_DX10             = MAKE_FOURCC('D', 'X', '1', '0') ,
 };
 
 ///
@@ -132,6 +135,17 @@ struct DX10Info
     uint32 reserved;
 };
 
+///
+/// DX10 header values
+///
+enum Dx10Flag
+{
+    DX10_DIMENSION_TEXTURE1D    = 2,
+    DX10_DIMENSION_TEXTURE2D    = 3,
+    DX10_DIMENSION_TEXTURE3D    = 4,
+    DX10_MISC_TEXTURECUBE       = 0x4,
+};
+
 // *****************************************************************************
 // local functions
 // *****************************************************************************
@@ -174,6 +188,21 @@ static uint32 sGetImageDepth( const DDSFileHeader & header )
     return DDS_DDSD_DEPTH & header.flags ? header.depth : 1;
 }
 
+///
+/// Get rows of pixels, or of blocks, of the plane: bytes of a row packed in DDS file, and
+/// bytes from one row to next in memory.
+// -----------------------------------------------------------------------------
+static void sGetPlaneRows( const GN::gfx::ImagePlaneDesc & p, uint32 & rows, uint32 & rowBytes, uint32 & rowPitch )
+{
+    const GN::gfx::ColorLayoutDesc & ld = p.format.layoutDesc();
+    rows = ( p.height + ld.blockHeight - 1 ) / ld.blockHeight;
+    if( 1 == ld.blockWidth )
+        rowBytes = ( p.width * ld.bits + 7 ) / 8;
+    else
+        rowBytes = ( p.width + ld.blockWidth - 1 ) / ld.blockWidth * ld.blockBytes;
+    rowPitch = p.pitch * ld.blockHeight;
+}
+
 //
 /// \brief return FMT_INVAID if falied
 // -----------------------------------------------------------------------------
@@ -288,9 +317,12 @@ GN::gfx::ImageDesc DDSReader::readHeader()
         return {};
     }
 
+    // grok image dimension
+    uint32 faces = sGetImageFaceCount( mHeader );
+    if( 0 == faces ) return {};
+
     // get image format
-    GN::gfx::ColorFormat format;
-    if( GN_MAKE_FOURCC('D','X','1','0') == mHeader.ddpf.fourcc )
+    if( DDS_FOURCC_DX10 == mHeader.ddpf.fourcc )
     {
         // read DX10 info
         DX10Info dx10;
@@ -301,6 +333,12 @@ GN::gfx::ImageDesc DDSReader::readHeader()
 
         mOriginalFormat = GN::gfx::dxgiFormat2ColorFormat( dx10.format );
         if( GN::gfx::ColorFormat::UNKNOWN == mOriginalFormat ) return {};
+
+        // texture arrays, and arrays of cube maps
+        if( DX10_DIMENSION_TEXTURE3D != dx10.dim )
+        {
+            faces = ( DX10_MISC_TEXTURECUBE & dx10.miscFlag ? 6 : 1 ) * std::max<uint32>( dx10.arraySize, 1 );
+        }
     }
     else
     {
@@ -309,13 +347,8 @@ GN::gfx::ImageDesc DDSReader::readHeader()
     }
 
     // BGR format is not compatible with D3D10/D3D11 hardware. So we need to convert it to RGB format.
-    // sUpdateSwizzle() will update format swizzle from BGR to RGB. And we'll do data convertion later
-    // in readImage() function.
-    mFormatConversion = sCheckFormatConversion(mOriginalFormat);
-
-    // grok image dimension
-    uint32 faces = sGetImageFaceCount( mHeader );
-    if( 0 == faces ) return {};
+    // Pixels are converted in readPixels().
+    GN::gfx::ColorFormat loadedFormat = sGetLoadedFormat( mOriginalFormat );
     uint32 width = mHeader.width;
     uint32 height = mHeader.height;
     uint32 depth = sGetImageDepth( mHeader );
@@ -328,7 +361,7 @@ GN::gfx::ImageDesc DDSReader::readHeader()
     if( 0 == levels ) levels = 1;
 
     // grok mipmaps
-    mImgDesc = GN::gfx::ImageDesc(GN::gfx::ImagePlaneDesc::make(mOriginalFormat, width, height, depth), faces, levels);
+    mImgDesc = GN::gfx::ImageDesc(GN::gfx::ImagePlaneDesc::make(loadedFormat, width, height, depth), faces, levels);
     GN_ASSERT( mImgDesc.valid() );
 
     // success
@@ -353,20 +386,48 @@ bool DDSReader::readPixels(void * o_data, size_t o_size) const
         return false;
     }
 
-    size_t read;
-    if (!mFile->read(o_data, mImgDesc.size, &read) || read != mImgDesc.size) {
-        GN_ERROR(sLogger)("failed to read DDS pixels.");
-        return false;
+    // DDS file stores all levels of one layer (face), then the next layer. Rows are packed.
+    uint8 * out = (uint8*)o_data;
+    for( uint32 layer = 0; layer < mImgDesc.layers; ++layer )
+    for( uint32 level = 0; level < mImgDesc.levels; ++level )
+    {
+        const GN::gfx::ImagePlaneDesc & p = mImgDesc.plane( layer, level );
+        uint32 rows, rowBytes, rowPitch;
+        sGetPlaneRows( p, rows, rowBytes, rowPitch );
+
+        size_t read;
+        if( rowBytes == rowPitch && rowPitch * rows == p.slice )
+        {
+            // packed in memory too
+            if (!mFile->read(out + p.offset, p.size, &read) || read != p.size) {
+                GN_ERROR(sLogger)("failed to read DDS pixels.");
+                return false;
+            }
+            continue;
+        }
+
+        for( uint32 z = 0; z < p.depth; ++z )
+        for( uint32 r = 0; r < rows; ++r )
+        {
+            if (!mFile->read(out + p.offset + z * p.slice + r * rowPitch, rowBytes, &read) || read != rowBytes) {
+                GN_ERROR(sLogger)("failed to read DDS pixels.");
+                return false;
+            }
+        }
     }
 
-    // Do format conversion, if needed.
-    if( FC_NONE != mFormatConversion )
+    // Do format conversion in place, if needed. Pixels of both formats have the same size.
+    if( mOriginalFormat != mImgDesc.format() )
     {
-        // There might be gaps between each mipmap level, or even between each scan line.
-        // But we assume that the data in the gaps are not important and could be converted
-        // as well without any side effects. We also assume that each scan line always starts
-        // from pixel size aligned address (4 bytes aligned for 8888 format) regardless of gaps.
-        sConvertFormat( mFormatConversion, mOriginalFormat, mImgDesc.format(), o_data, mImgDesc.size );
+        for( const GN::gfx::ImagePlaneDesc & p : mImgDesc.planes )
+        {
+            for( uint32 z = 0; z < p.depth; ++z )
+            for( uint32 y = 0; y < p.height; ++y )
+            {
+                uint8 * row = (uint8*)o_data + p.pixel( 0, y, z );
+                GN::gfx::convertPixels( mOriginalFormat, row, p.format, row, p.width );
+            }
+        }
     }
 
     // success
@@ -382,63 +443,174 @@ bool DDSReader::readPixels(void * o_data, size_t o_size) const
 //
 //
 // -----------------------------------------------------------------------------
-DDSReader::FormatConversion
-DDSReader::sCheckFormatConversion( GN::gfx::ColorFormat & format )
+GN::gfx::ColorFormat DDSReader::sGetLoadedFormat( GN::gfx::ColorFormat format )
 {
     using namespace GN::gfx;
 
-    if( ColorFormat::LAYOUT_8_8_8_8 == format.layout &&
-        ColorFormat::SWIZZLE_B == format.swizzle0 &&
-        ColorFormat::SWIZZLE_G == format.swizzle1 &&
-        ColorFormat::SWIZZLE_R == format.swizzle2 )
+    if( ColorFormat::BGRA_8_8_8_8_UNORM == format || ColorFormat::BGRX_8_8_8_8_UNORM == format )
     {
-        format.swizzle0 = ColorFormat::SWIZZLE_R;
-        format.swizzle1 = ColorFormat::SWIZZLE_G;
-        format.swizzle2 = ColorFormat::SWIZZLE_B;
-        format.swizzle3 = ColorFormat::SWIZZLE_A;
-        return FC_BGRX8888_TO_RGBA8888;
+        return ColorFormat::RGBA_8_8_8_8_UNORM;
     }
     else
     {
-        return FC_NONE;
+        return format;
     }
 }
 
+// *****************************************************************************
+// DDSWriter public functions
+// *****************************************************************************
+
 //
 //
 // -----------------------------------------------------------------------------
-void DDSReader::sConvertFormat(
-    FormatConversion fc,
-    GN::gfx::ColorFormat from,
-    GN::gfx::ColorFormat to,
-    void * data,
-    size_t size )
+bool DDSWriter::write( const GN::gfx::ImageDesc & desc, const void * pixels, bool forceDX10 )
 {
+    GN_GUARD;
+
     using namespace GN::gfx;
 
-    GN_UNUSED_PARAM( to );
+    if( desc.empty() || !desc.valid() || NULL == pixels )
+    {
+        GN_ERROR(sLogger)( "Invalid image." );
+        return false;
+    }
+
+    const ImagePlaneDesc & base = desc.plane();
+    ColorFormat format = base.format;
+    for( const ImagePlaneDesc & p : desc.planes )
+    {
+        if( p.format != format || p.step != format.getBitsPerPixel() )
+        {
+            GN_ERROR(sLogger)( "DDS needs planes of the same format, and packed pixels." );
+            return false;
+        }
+    }
+
+    bool cube = 6 == desc.layers && base.width == base.height && 1 == base.depth;
+    bool volume = base.depth > 1;
+    if( volume && desc.layers > 1 )
+    {
+        GN_ERROR(sLogger)( "DDS can't hold arrays of volume textures." );
+        return false;
+    }
+
+    // Legacy pixel format, if any. Premultiplied DXT2 and DXT4 are read as DXT3 and DXT5, but
+    // never written.
+    const DDPixelFormat * legacy = NULL;
+    if( !forceDX10 && ( 1 == desc.layers || cube ) )
+    {
+        for( const DdpfDesc & d : s_ddpfDescTable )
+        {
+            if( d.clrfmt == format && DDS_FOURCC_DXT2 != d.ddpf.fourcc && DDS_FOURCC_DXT4 != d.ddpf.fourcc )
+            {
+                legacy = &d.ddpf;
+                break;
+            }
+        }
+    }
+    int dxgi = colorFormat2DxgiFormat( format );
+    if( NULL == legacy && 0 == dxgi )
+    {
+        GN_ERROR(sLogger)( "Color format %s has no DDS format.", format.toString().rawptr() );
+        return false;
+    }
+
+    // header
+    uint32 rows, rowBytes, rowPitch;
+    sGetPlaneRows( base, rows, rowBytes, rowPitch );
+    bool blocks = format.layoutDesc().blockHeight > 1;
+
+    DDSFileHeader header;
+    memset( &header, 0, sizeof(header) );
+    header.size = sizeof(header);
+    header.flags = DDS_DDSD_CAPS | DDS_DDSD_HEIGHT | DDS_DDSD_WIDTH | DDS_DDSD_PIXELFORMAT | ( blocks ? DDS_DDSD_LINEARSIZE : DDS_DDSD_PITCH );
+    header.height = base.height;
+    header.width = base.width;
+    header.pitchOrLinearSize = blocks ? rowBytes * rows : rowBytes;
+    header.caps = DDS_CAPS_TEXTURE;
+    if( desc.levels > 1 )
+    {
+        header.flags |= DDS_DDSD_MIPMAPCOUNT;
+        header.mipCount = desc.levels;
+        header.caps |= DDS_CAPS_COMPLEX | DDS_CAPS_MIPMAP;
+    }
+    if( volume )
+    {
+        header.flags |= DDS_DDSD_DEPTH;
+        header.depth = base.depth;
+        header.caps |= DDS_CAPS_COMPLEX;
+        header.caps2 = DDS_CAPS2_VOLUME;
+    }
+    if( cube )
+    {
+        header.caps |= DDS_CAPS_COMPLEX;
+        header.caps2 = DDS_CAPS2_CUBEMAP | DDS_CAPS2_CUBEMAP_ALLFACES;
+    }
+    if( legacy )
+    {
+        header.ddpf = *legacy;
+    }
+    else
+    {
+        header.ddpf.size = DDS_DDPF_SIZE;
+        header.ddpf.flags = DDS_DDPF_FOURCC;
+        header.ddpf.fourcc = DDS_FOURCC_DX10;
+    }
 
-    if( FC_BGRX8888_TO_RGBA8888 == fc )
+    size_t written;
+    if( !mFile->write( "DDS ", 4, &written ) || 4 != written ||
+        !mFile->write( &header, sizeof(header), &written ) || sizeof(header) != written )
     {
-        GN_ASSERT( ColorFormat::LAYOUT_8_8_8_8 == from.layout );
-        GN_ASSERT( ColorFormat::LAYOUT_8_8_8_8 == to.layout );
+        GN_ERROR(sLogger)( "fail to write DDS file header!" );
+        return false;
+    }
 
-        size_t   numPixels = size / 4;
-        uint32 * pixels = (uint32*)data;
-        uint32 * end = pixels + numPixels;
-        for( ; pixels < end; ++pixels )
+    if( NULL == legacy )
+    {
+        DX10Info dx10;
+        dx10.format = dxgi;
+        dx10.dim = volume ? DX10_DIMENSION_TEXTURE3D : DX10_DIMENSION_TEXTURE2D;
+        dx10.miscFlag = cube ? DX10_MISC_TEXTURECUBE : 0;
+        dx10.arraySize = cube ? 1 : desc.layers;
+        dx10.reserved = 0;
+        if( !mFile->write( &dx10, sizeof(dx10), &written ) || sizeof(dx10) != written )
         {
-            // Determine Alpha channel.
-            uint32 a;
-            switch( from.swizzle3 )
+            GN_ERROR(sLogger)( "fail to write DX10 info header!" );
+            return false;
+        }
+    }
+
+    // pixels, in the order of readPixels()
+    GN::DynaArray<uint8> packed;
+    for( uint32 layer = 0; layer < desc.layers; ++layer )
+    for( uint32 level = 0; level < desc.levels; ++level )
+    {
+        const ImagePlaneDesc & p = desc.plane( layer, level );
+        sGetPlaneRows( p, rows, rowBytes, rowPitch );
+
+        const uint8 * src = (const uint8*)pixels + p.offset;
+        size_t size = (size_t)rowBytes * rows * p.depth;
+        if( rowBytes != rowPitch || rowPitch * rows != p.slice )
+        {
+            packed.resize( size );
+            uint8 * dst = packed.rawptr();
+            for( uint32 z = 0; z < p.depth; ++z )
+            for( uint32 r = 0; r < rows; ++r, dst += rowBytes )
             {
-                case ColorFormat::SWIZZLE_0 : a = 0; break;
-                case ColorFormat::SWIZZLE_1 : a = 0xFF000000; break;
-                default                     : a = ((*pixels)&0xFF000000);
+                memcpy( dst, src + z * p.slice + r * rowPitch, rowBytes );
             }
+            src = packed.rawptr();
+        }
 
-            //        A              R                         G                       B
-            *pixels = a | (((*pixels)&0xFF0000)>>16) | ((*pixels)&0xFF00) | (((*pixels)&0xFF)<<16);
+        if( !mFile->write( src, size, &written ) || size != written )
+        {
+            GN_ERROR(sLogger)( "failed to write DDS pixels." );
+            return false;
         }
     }
+
+    return true;
+
+    GN_UNGUARD;
 }
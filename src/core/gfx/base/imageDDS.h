@@ -2,7 +2,7 @@
 #define __GN_GFX_IMAGEDDS_H__
 // *****************************************************************************
 /// \file
-/// \brief   DDS image reader
+/// \brief   DDS image reader and writer
 /// \author  chenlee (2005.6.2)
 // *****************************************************************************
 
@@ -54,24 +54,16 @@ class DDSReader
     DDSFileHeader      mHeader;
     GN::gfx::ImageDesc mImgDesc;
 
-    enum FormatConversion
-    {
-        FC_NONE,
-        FC_BGRX8888_TO_RGBA8888,
-    };
-
-    GN::gfx::ColorFormat mOriginalFormat;
-    FormatConversion     mFormatConversion;
+    GN::gfx::ColorFormat mOriginalFormat; ///< format of pixels in the file
 
-    static FormatConversion sCheckFormatConversion( GN::gfx::ColorFormat & );
-    static void sConvertFormat( FormatConversion fc, GN::gfx::ColorFormat from, GN::gfx::ColorFormat to, void * data, size_t size );
+    static GN::gfx::ColorFormat sGetLoadedFormat( GN::gfx::ColorFormat );
 
 public:
 
     ///
     /// Constructor
     ///
-    DDSReader(GN::File & f) : mFile(&f), mFormatConversion(FC_NONE)
+    DDSReader(GN::File & f) : mFile(&f)
     {
     }
 
@@ -98,6 +90,29 @@ public:
     bool readPixels(void * o_buf, size_t o_size) const;
 };
 
+///
+/// dds image writer
+///
+class DDSWriter
+{
+    GN::File * mFile;
+
+public:
+
+    ///
+    /// Constructor
+    ///
+    DDSWriter(GN::File & f) : mFile(&f)
+    {
+    }
+
+    ///
+    /// Write header and pixels of all planes. Use DX10 header, if forced, or if the legacy
+    /// header can't describe the color format or the layers.
+    ///
+    bool write(const GN::gfx::ImageDesc & desc, const void * pixels, bool forceDX10);
+};
+
 // *****************************************************************************
 //                                     EOF
 // *****************************************************************************
@@ -0,0 +1,349 @@
+#include "pch.h"
+#include "imageEXR.h"
+#include <zlib.h>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.image");
+
+// *****************************************************************************
+// local types
+// *****************************************************************************
+
+/// EXR compression methods
+enum
+{
+    EXR_NO_COMPRESSION   = 0,
+    EXR_RLE_COMPRESSION  = 1,
+    EXR_ZIPS_COMPRESSION = 2, ///< zlib, one scanline per chunk
+    EXR_ZIP_COMPRESSION  = 3, ///< zlib, 16 scanlines per chunk
+};
+
+/// EXR pixel types
+enum
+{
+    EXR_UINT  = 0,
+    EXR_HALF  = 1,
+    EXR_FLOAT = 2,
+};
+
+///
+/// Little endian reader of the header, which stops at the end of data.
+///
+struct EXRStream
+{
+    const uint8 * ptr;
+    const uint8 * end;
+
+    bool fail() const { return NULL == ptr; }
+
+    const uint8 * bytes( size_t count )
+    {
+        if( NULL == ptr || (size_t)( end - ptr ) < count ) { ptr = NULL; return NULL; }
+        const uint8 * p = ptr;
+        ptr += count;
+        return p;
+    }
+
+    uint32 u32()
+    {
+        const uint8 * p = bytes( 4 );
+        return p ? ( p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32)p[3] << 24 ) ) : 0;
+    }
+
+    /// null terminated string, of up to 255 characters
+    const char * str()
+    {
+        if( NULL == ptr ) return NULL;
+        const uint8 * p = (const uint8*)memchr( ptr, 0, std::min<size_t>( end - ptr, 256 ) );
+        if( NULL == p ) { ptr = NULL; return NULL; }
+        const char * s = (const char*)ptr;
+        ptr = p + 1;
+        return s;
+    }
+};
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+///
+/// Decode RLE data of EXR: a negative count is followed by that many literal bytes, others
+/// by one byte to repeat count + 1 times.
+// -----------------------------------------------------------------------------
+static bool sDecodeRLE( const uint8 * src, size_t srcSize, uint8 * dst, size_t dstSize )
+{
+    const uint8 * srcEnd = src + srcSize;
+    uint8 * dstEnd = dst + dstSize;
+    while( src < srcEnd )
+    {
+        int count = (sint8)*src++;
+        if( count < 0 )
+        {
+            if( srcEnd - src < -count || dstEnd - dst < -count ) return false;
+            memcpy( dst, src, -count );
+            src += -count;
+            dst += -count;
+        }
+        else
+        {
+            if( src == srcEnd || dstEnd - dst < count + 1 ) return false;
+            memset( dst, *src++, count + 1 );
+            dst += count + 1;
+        }
+    }
+    return dst == dstEnd;
+}
+
+///
+/// Undo the byte predictor and the split of even and odd bytes, which EXR applies to
+/// data before RLE and zlib compression.
+// -----------------------------------------------------------------------------
+static void sUnpredict( uint8 * tmp, uint8 * dst, size_t size )
+{
+    for( size_t i = 1; i < size; ++i ) tmp[i] = (uint8)( tmp[i - 1] + tmp[i] - 128 );
+
+    const uint8 * even = tmp;
+    const uint8 * odd = tmp + ( size + 1 ) / 2;
+    for( size_t i = 0; i < size; ++i ) dst[i] = ( i & 1 ) ? *odd++ : *even++;
+}
+
+// *****************************************************************************
+// EXRReader public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::gfx::ImageDesc EXRReader::readHeader()
+{
+    GN_GUARD;
+
+    EXRStream s = { mData, mData + mSize };
+    s.bytes( 4 );
+    uint32 version = s.u32();
+    if( s.fail() || 2 != ( version & 0xFF ) || ( version & ~0x4FF ) )
+    {
+        GN_ERROR(sLogger)( "Unsupported EXR file: version 0x%X. Only single part scanline images are supported.", version );
+        return {};
+    }
+
+    // attributes, until an empty name
+    bool hasChannels = false, hasCompression = false, hasDataWindow = false;
+    sint32 maxX = -1, maxY = -1;
+    for( ;; )
+    {
+        const char * name = s.str();
+        if( s.fail() || 0 == *name ) break;
+        const char * type = s.str();
+        uint32 size = s.u32();
+        const uint8 * value = s.bytes( size );
+        if( s.fail() ) break;
+
+        if( 0 == strcmp( name, "channels" ) && 0 == strcmp( type, "chlist" ) )
+        {
+            EXRStream c = { value, value + size };
+            for( ;; )
+            {
+                const char * ch = c.str();
+                if( c.fail() || 0 == *ch ) break;
+                Channel channel;
+                channel.type = c.u32();
+                c.bytes( 4 ); // pLinear and reserved
+                uint32 xSampling = c.u32();
+                uint32 ySampling = c.u32();
+                if( c.fail() ) break;
+                if( channel.type > EXR_FLOAT || 1 != xSampling || 1 != ySampling )
+                {
+                    GN_ERROR(sLogger)( "Unsupported EXR channel %s: type %u, sampling %ux%u.", ch, channel.type, xSampling, ySampling );
+                    return {};
+                }
+                static const char * NAMES[] = { "R", "G", "B", "A", "Y" };
+                channel.component = -1;
+                for( int i = 0; i < 5 && EXR_UINT != channel.type; ++i ) if( 0 == strcmp( ch, NAMES[i] ) ) channel.component = i;
+                mChannels.append( channel );
+            }
+            hasChannels = !c.fail() && !mChannels.empty();
+        }
+        else if( 0 == strcmp( name, "compression" ) && 1 == size )
+        {
+            mCompression = value[0];
+            hasCompression = true;
+        }
+        else if( 0 == strcmp( name, "dataWindow" ) && 16 == size )
+        {
+            EXRStream w = { value, value + size };
+            mMinX = (sint32)w.u32();
+            mMinY = (sint32)w.u32();
+            maxX = (sint32)w.u32();
+            maxY = (sint32)w.u32();
+            hasDataWindow = true;
+        }
+    }
+    if( s.fail() || !hasChannels || !hasCompression || !hasDataWindow )
+    {
+        GN_ERROR(sLogger)( "Invalid EXR header." );
+        return {};
+    }
+    if( mCompression > EXR_ZIP_COMPRESSION )
+    {
+        GN_ERROR(sLogger)( "Unsupported EXR compression: %u.", mCompression );
+        return {};
+    }
+    sint64 width = (sint64)maxX - mMinX + 1;
+    sint64 height = (sint64)maxY - mMinY + 1;
+    if( width <= 0 || height <= 0 || width > 0x10000 || height > 0x10000 )
+    {
+        GN_ERROR(sLogger)( "Invalid EXR data window: (%d, %d) - (%d, %d).", mMinX, mMinY, maxX, maxY );
+        return {};
+    }
+
+    bool color[5] = {}, floats = false;
+    mLineBytes = 0;
+    for( const Channel & c : mChannels )
+    {
+        mLineBytes += ( EXR_HALF == c.type ? 2 : 4 ) * (size_t)width;
+        if( c.component < 0 ) continue;
+        color[c.component] = true;
+        floats |= EXR_FLOAT == c.type;
+    }
+    if( !color[0] && !color[1] && !color[2] && !color[4] )
+    {
+        GN_ERROR(sLogger)( "EXR file has no R, G, B or Y channel." );
+        return {};
+    }
+
+    mOffsets = s.ptr - mData;
+    ColorFormat format = !floats ? ColorFormat::RGBA_16_16_16_16_FLOAT : color[3] ? ColorFormat::RGBA_32_32_32_32_FLOAT : ColorFormat::RGB_32_32_32_FLOAT;
+    mImgDesc = ImageDesc( ImagePlaneDesc::make( format, (uint32)width, (uint32)height ) );
+    return mImgDesc;
+
+    GN_UNGUARD;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool EXRReader::readPixels( void * o_data, size_t o_size )
+{
+    GN_GUARD;
+
+    if( mImgDesc.empty() )
+    {
+        GN_ERROR(sLogger)( "EXR header is not read yet." );
+        return false;
+    }
+    if( NULL == o_data || o_size < mImgDesc.size )
+    {
+        GN_ERROR(sLogger)( "output buffer is NULL or not large enough." );
+        return false;
+    }
+
+    const ImagePlaneDesc & p = mImgDesc.plane();
+    const bool halfs = ColorFormat::RGBA_16_16_16_16_FLOAT == p.format;
+    const size_t components = p.format.layoutDesc().numChannels;
+    const size_t componentBytes = halfs ? 2 : 4;
+    const uint32 linesPerChunk = EXR_ZIP_COMPRESSION == mCompression ? 16 : 1;
+    const size_t chunks = ( p.height + linesPerChunk - 1 ) / linesPerChunk;
+    if( mOffsets + chunks * 8 > mSize )
+    {
+        GN_ERROR(sLogger)( "EXR scanline offset table is truncated." );
+        return false;
+    }
+
+    // missing channels are 0, and alpha is 1.
+    const uint16 HALF_ONE = 0x3C00;
+    const float FLOAT_ONE = 1.0f;
+    for( uint32 y = 0; y < p.height; ++y )
+    {
+        uint8 * row = (uint8*)o_data + p.pixel( 0, y, 0 );
+        memset( row, 0, p.width * p.step / 8 );
+        if( 4 != components ) continue;
+        for( uint32 x = 0; x < p.width; ++x )
+        {
+            memcpy( row + ( x * 4 + 3 ) * componentBytes, halfs ? (const void*)&HALF_ONE : (const void*)&FLOAT_ONE, componentBytes );
+        }
+    }
+
+    DynaArray<uint8> chunk( mLineBytes * linesPerChunk ), tmp( mLineBytes * linesPerChunk );
+    DynaArray<float> floats( p.width );
+    for( size_t i = 0; i < chunks; ++i )
+    {
+        EXRStream s = { mData + mOffsets + i * 8, mData + mSize };
+        uint64 offset = s.u32();
+        offset |= (uint64)s.u32() << 32;
+        if( offset > mSize ) offset = mSize;
+        s.ptr = mData + offset;
+        sint32 y = (sint32)s.u32();
+        uint32 size = s.u32();
+        const uint8 * data = s.bytes( size );
+        sint64 first = (sint64)y - mMinY;
+        if( s.fail() || first < 0 || first >= p.height )
+        {
+            GN_ERROR(sLogger)( "Invalid EXR scanline chunk #%u.", (uint32)i );
+            return false;
+        }
+        uint32 lines = std::min<uint32>( linesPerChunk, p.height - (uint32)first );
+        size_t bytes = mLineBytes * lines;
+
+        // Chunks that don't get smaller are stored uncompressed.
+        bool ok = true;
+        if( EXR_NO_COMPRESSION == mCompression || size == bytes )
+        {
+            ok = size == bytes;
+            if( ok ) memcpy( chunk.rawptr(), data, bytes );
+        }
+        else if( EXR_RLE_COMPRESSION == mCompression )
+        {
+            ok = sDecodeRLE( data, size, tmp.rawptr(), bytes );
+            if( ok ) sUnpredict( tmp.rawptr(), chunk.rawptr(), bytes );
+        }
+        else
+        {
+            uLongf unzipped = (uLongf)bytes;
+            ok = Z_OK == uncompress( tmp.rawptr(), &unzipped, data, size ) && unzipped == bytes;
+            if( ok ) sUnpredict( tmp.rawptr(), chunk.rawptr(), bytes );
+        }
+        if( !ok )
+        {
+            GN_ERROR(sLogger)( "Fail to decompress EXR scanline chunk #%u.", (uint32)i );
+            return false;
+        }
+
+        // Scanlines hold all samples of each channel in turn. EXR is little endian, like the hosts.
+        const uint8 * src = chunk.rawptr();
+        for( uint32 l = 0; l < lines; ++l )
+        {
+            uint8 * row = (uint8*)o_data + p.pixel( 0, (uint32)first + l, 0 );
+            for( const Channel & c : mChannels )
+            {
+                size_t sampleBytes = EXR_HALF == c.type ? 2 : 4;
+                if( c.component >= 0 )
+                {
+                    const uint8 * samples = src;
+                    if( !halfs && EXR_HALF == c.type )
+                    {
+                        convertPixels( ColorFormat::R_16_FLOAT, src, ColorFormat::R_32_FLOAT, floats.rawptr(), p.width );
+                        samples = (const uint8*)floats.rawptr();
+                    }
+                    int firstComponent = 4 == c.component ? 0 : c.component;
+                    int lastComponent = 4 == c.component ? 2 : c.component;
+                    for( int k = firstComponent; k <= lastComponent; ++k )
+                    {
+                        uint8 * dst = row + k * componentBytes;
+                        for( uint32 x = 0; x < p.width; ++x )
+                        {
+                            memcpy( dst + x * components * componentBytes, samples + x * componentBytes, componentBytes );
+                        }
+                    }
+                }
+                src += sampleBytes * p.width;
+            }
+        }
+    }
+
+    return true;
+
+    GN_UNGUARD;
+}
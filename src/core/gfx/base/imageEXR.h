@@ -0,0 +1,62 @@
+#ifndef __GN_GFX_IMAGEEXR_H__
+#define __GN_GFX_IMAGEEXR_H__
+// *****************************************************************************
+/// \file
+/// \brief   OpenEXR image reader
+// *****************************************************************************
+
+///
+/// OpenEXR image reader, of a subset of the format: single part scanline images, with
+/// uncompressed, RLE, ZIPS or ZIP compression, and HALF or FLOAT channels without subsampling.
+/// R, G, B, A and Y channels are read, others are skipped.
+///
+class EXRReader
+{
+    /// channel of the file
+    struct Channel
+    {
+        int    component; ///< 0-3 for R, G, B and A, 4 for Y (gray), -1 for other and UINT channels.
+        uint32 type;      ///< 0: UINT, 1: HALF, 2: FLOAT
+    };
+
+    const uint8 *          mData;
+    size_t                 mSize;
+    GN::DynaArray<Channel> mChannels;
+    uint32                 mCompression;
+    sint32                 mMinX, mMinY;
+    size_t                 mLineBytes;  ///< bytes of one scanline of all channels in the file
+    size_t                 mOffsets;    ///< offset of the scanline offset table
+    GN::gfx::ImageDesc     mImgDesc;
+
+public:
+
+    ///
+    /// Constructor
+    ///
+    EXRReader(const void * data, size_t size) : mData((const uint8*)data), mSize(size), mCompression(0), mMinX(0), mMinY(0), mLineBytes(0), mOffsets(0)
+    {
+    }
+
+    ///
+    /// Check EXR magic number
+    ///
+    bool checkFormat() const { return mSize >= 4 && 0x76 == mData[0] && 0x2F == mData[1] && 0x31 == mData[2] && 0x01 == mData[3]; }
+
+    ///
+    /// Read EXR header. Images of HALF channels are read as RGBA16F, with alpha of 1 when the
+    /// file has none. Images with FLOAT channels are read as RGB32F or RGBA32F. Y is read into
+    /// R, G and B.
+    ///
+    GN::gfx::ImageDesc readHeader();
+
+    ///
+    /// Decode pixels into the output buffer, which has the layout of the image descriptor
+    /// returned by readHeader().
+    ///
+    bool readPixels(void * o_buf, size_t o_size);
+};
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_GFX_IMAGEEXR_H__
@@ -0,0 +1,303 @@
+#include "pch.h"
+#include "imagePNG.h"
+#include <zlib.h>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.image");
+
+// *****************************************************************************
+// local functions
+// *****************************************************************************
+
+/// size of IDAT chunks
+static const size_t IDAT_SIZE = 256 * 1024;
+
+/// Zlib compression level. Level 2 is as fast as level 1 and 5% smaller, while the default
+/// level 6 is another 15% smaller, but 5x slower.
+static const int ZLIB_LEVEL = 2;
+
+///
+/// store 32-bit integer in big endian
+// -----------------------------------------------------------------------------
+static inline void sPutU32( uint8 * p, uint32 v )
+{
+    p[0] = (uint8)( v >> 24 );
+    p[1] = (uint8)( v >> 16 );
+    p[2] = (uint8)( v >> 8 );
+    p[3] = (uint8)v;
+}
+
+///
+/// write one chunk: length, type, data and CRC of type and data.
+// -----------------------------------------------------------------------------
+static bool sWriteChunk( File & fp, const char * type, const uint8 * data, size_t size )
+{
+    uint8 head[8], tail[4];
+    sPutU32( head, (uint32)size );
+    memcpy( head + 4, type, 4 );
+
+    uLong crc = crc32( 0, head + 4, 4 );
+    if( size > 0 ) crc = crc32( crc, data, (uInt)size );
+    sPutU32( tail, (uint32)crc );
+
+    size_t written;
+    if( !fp.write( head, 8, &written ) || 8 != written ) return false;
+    if( size > 0 && ( !fp.write( data, size, &written ) || size != written ) ) return false;
+    if( !fp.write( tail, 4, &written ) || 4 != written ) return false;
+    return true;
+}
+
+///
+/// load big endian 32-bit integer
+// -----------------------------------------------------------------------------
+static inline uint32 sGetU32( const uint8 * p )
+{
+    return ( (uint32)p[0] << 24 ) | ( (uint32)p[1] << 16 ) | ( (uint32)p[2] << 8 ) | p[3];
+}
+
+///
+/// Paeth predictor of the PNG specification, without branches: a is left, b is up, and c is
+/// up-left byte.
+// -----------------------------------------------------------------------------
+static inline int sPaeth( int a, int b, int c )
+{
+    int pa = abs( b - c );
+    int pb = abs( a - c );
+    int pc = abs( a + b - c - c );
+    int bc = pb <= pc ? b : c;
+    return ( pa <= pb && pa <= pc ) ? a : bc;
+}
+
+///
+/// Filter one row with the PNG filter, that has the least sum of absolute residuals among
+/// Sub, Up and Paeth (the heuristic of the PNG specification). The first row always uses Sub.
+/// Output is the filter type byte, followed by the filtered row.
+// -----------------------------------------------------------------------------
+static void sFilterRow( uint8 * out, const uint8 * cur, const uint8 * prev, size_t rowBytes, size_t bpp, uint8 * scratch )
+{
+    uint8 * sub = out + 1;
+    if( NULL == prev )
+    {
+        out[0] = 1;
+        memcpy( sub, cur, bpp );
+        for( size_t i = bpp; i < rowBytes; ++i ) sub[i] = (uint8)( cur[i] - cur[i - bpp] );
+        return;
+    }
+
+    // The first pixel has no left neighbor, so that Sub is None and Paeth is Up.
+    uint8 * up = scratch;
+    uint8 * paeth = scratch + rowBytes;
+    for( size_t i = 0; i < bpp; ++i )
+    {
+        sub[i] = cur[i];
+        up[i] = paeth[i] = (uint8)( cur[i] - prev[i] );
+    }
+    for( size_t i = bpp; i < rowBytes; ++i )
+    {
+        sub[i] = (uint8)( cur[i] - cur[i - bpp] );
+        up[i] = (uint8)( cur[i] - prev[i] );
+        paeth[i] = (uint8)( cur[i] - sPaeth( cur[i - bpp], prev[i], prev[i - bpp] ) );
+    }
+
+    // Residuals are signed bytes.
+    uint32 sumSub = 0, sumUp = 0, sumPaeth = 0;
+    for( size_t i = 0; i < rowBytes; ++i )
+    {
+        sumSub += (uint32)abs( (int8_t)sub[i] );
+        sumUp += (uint32)abs( (int8_t)up[i] );
+        sumPaeth += (uint32)abs( (int8_t)paeth[i] );
+    }
+
+    if( sumSub <= sumUp && sumSub <= sumPaeth )
+    {
+        out[0] = 1;
+    }
+    else if( sumUp <= sumPaeth )
+    {
+        out[0] = 2;
+        memcpy( sub, up, rowBytes );
+    }
+    else
+    {
+        out[0] = 4;
+        memcpy( sub, paeth, rowBytes );
+    }
+}
+
+// *****************************************************************************
+// PNGChecker public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool PNGChecker::checkFormat() const
+{
+    static const uint8 SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    return mSize >= 8 && 0 == memcmp( mData, SIGNATURE, 8 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool PNGChecker::checkChunks() const
+{
+    GN_ASSERT( checkFormat() );
+
+    // chunk: length, type, data and CRC of type and data.
+    size_t pos = 8;
+    while( mSize - pos >= 12 )
+    {
+        const uint8 * chunk = mData + pos;
+        size_t length = sGetU32( chunk );
+        if( length > mSize - pos - 12 ) break;
+
+        uint32 crc = (uint32)crc32( crc32( 0, NULL, 0 ), chunk + 4, (uInt)( length + 4 ) );
+        if( crc != sGetU32( chunk + 8 + length ) )
+        {
+            GN_ERROR(sLogger)( "PNG chunk '%.4s' has incorrect CRC.", (const char*)chunk + 4 );
+            return false;
+        }
+
+        if( 0 == memcmp( chunk + 4, "IEND", 4 ) ) return true;
+
+        pos += 12 + length;
+    }
+
+    GN_ERROR(sLogger)( "PNG data ends before IEND chunk." );
+    return false;
+}
+
+// *****************************************************************************
+// PNGWriter public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool PNGWriter::write( const ImagePlaneDesc & plane, const void * pixels )
+{
+    GN_GUARD;
+
+    if( plane.empty() || NULL == pixels || !isConvertibleColorFormat( plane.format ) || plane.step != plane.format.getBitsPerPixel() )
+    {
+        GN_ERROR(sLogger)( "PNG writer needs non-empty image of convertible format and packed pixels." );
+        return false;
+    }
+
+    // sRGB channels are stored as is, so PNG holds the same bytes as the image.
+    ColorFormat src = plane.format;
+    if( ColorFormat::SIGN_GNORM == src.sign012 ) src.sign012 = ColorFormat::SIGN_UNORM;
+    if( ColorFormat::SIGN_GNORM == src.sign3 ) src.sign3 = ColorFormat::SIGN_UNORM;
+
+    // Pick PNG color type from the swizzle.
+    bool gray = src.swizzle0 == src.swizzle1 && src.swizzle1 == src.swizzle2;
+    bool alpha = src.swizzle3 < ColorFormat::SWIZZLE_0;
+    uint8 colorType;
+    ColorFormat dst;
+    size_t bpp;
+    if( gray )
+    {
+        colorType = alpha ? 4 : 0;
+        dst = alpha ? ColorFormat::LA_8_8_UNORM : ColorFormat::L_8_UNORM;
+        bpp = alpha ? 2 : 1;
+    }
+    else
+    {
+        colorType = alpha ? 6 : 2;
+        dst = alpha ? ColorFormat::RGBA_8_8_8_8_UNORM : ColorFormat::RGB_8_8_8_UNORM;
+        bpp = alpha ? 4 : 3;
+    }
+    size_t width = plane.width;
+    size_t rowBytes = width * bpp;
+
+    // signature and header
+    static const uint8 SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8 ihdr[13];
+    sPutU32( ihdr, plane.width );
+    sPutU32( ihdr + 4, plane.height );
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = colorType;
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // no interlace
+    size_t written;
+    if( !mFile->write( SIGNATURE, 8, &written ) || 8 != written || !sWriteChunk( *mFile, "IHDR", ihdr, 13 ) )
+    {
+        GN_ERROR(sLogger)( "fail to write PNG header!" );
+        return false;
+    }
+
+    // Buffers: 2 converted rows, filtered row, 2 rows of filter scratch and compressed data.
+    DynaArray<uint8> buffer( rowBytes * 5 + 1 + IDAT_SIZE );
+    uint8 * converted[2] = { buffer.rawptr(), buffer.rawptr() + rowBytes };
+    uint8 * filtered = buffer.rawptr() + rowBytes * 2;
+    uint8 * scratch = filtered + rowBytes + 1;
+    uint8 * idat = scratch + rowBytes * 2;
+
+    z_stream zs;
+    memset( &zs, 0, sizeof(zs) );
+    if( Z_OK != deflateInit( &zs, ZLIB_LEVEL ) )
+    {
+        GN_ERROR(sLogger)( "fail to initialize zlib." );
+        return false;
+    }
+    zs.next_out = idat;
+    zs.avail_out = (uInt)IDAT_SIZE;
+
+    // Filter and deflate rows. Full IDAT chunks are written as soon as they are ready.
+    bool ok = true;
+    const uint8 * prev = NULL;
+    for( uint32 y = 0; ok && y <= plane.height; ++y )
+    {
+        int flush = Z_FINISH;
+        if( y < plane.height )
+        {
+            const uint8 * row = (const uint8*)pixels + plane.pixel( 0, y, 0 );
+            const uint8 * cur = row;
+            if( src != dst )
+            {
+                uint8 * buf = converted[y & 1];
+                convertPixels( src, row, dst, buf, width );
+                cur = buf;
+            }
+            sFilterRow( filtered, cur, prev, rowBytes, bpp, scratch );
+            prev = cur;
+            zs.next_in = filtered;
+            zs.avail_in = (uInt)( rowBytes + 1 );
+            flush = Z_NO_FLUSH;
+        }
+
+        for(;;)
+        {
+            int err = deflate( &zs, flush );
+            if( Z_OK != err && Z_STREAM_END != err && Z_BUF_ERROR != err )
+            {
+                GN_ERROR(sLogger)( "zlib error: %d", err );
+                ok = false;
+                break;
+            }
+            if( 0 == zs.avail_out || ( Z_STREAM_END == err && zs.avail_out < IDAT_SIZE ) )
+            {
+                ok = sWriteChunk( *mFile, "IDAT", idat, IDAT_SIZE - zs.avail_out );
+                zs.next_out = idat;
+                zs.avail_out = (uInt)IDAT_SIZE;
+                if( !ok ) break;
+            }
+            if( Z_STREAM_END == err || ( Z_NO_FLUSH == flush && 0 == zs.avail_in && zs.avail_out > 0 ) ) break;
+        }
+    }
+    deflateEnd( &zs );
+
+    if( !ok || !sWriteChunk( *mFile, "IEND", NULL, 0 ) )
+    {
+        GN_ERROR(sLogger)( "fail to write PNG pixels." );
+        return false;
+    }
+
+    return true;
+
+    GN_UNGUARD;
+}
@@ -0,0 +1,62 @@
+#ifndef __GN_GFX_IMAGEPNG_H__
+#define __GN_GFX_IMAGEPNG_H__
+// *****************************************************************************
+/// \file
+/// \brief   PNG image checker and writer
+// *****************************************************************************
+
+///
+/// png file checker. png files are decoded by stb_image, which doesn't verify chunk CRCs.
+///
+class PNGChecker
+{
+    const uint8 * mData;
+    size_t        mSize;
+
+public:
+
+    ///
+    /// Constructor
+    ///
+    PNGChecker(const void * data, size_t size) : mData((const uint8*)data), mSize(size)
+    {
+    }
+
+    ///
+    /// Check PNG signature
+    ///
+    bool checkFormat() const;
+
+    ///
+    /// Verify length and CRC of all chunks, till the IEND chunk.
+    ///
+    bool checkChunks() const;
+};
+
+///
+/// png image writer
+///
+class PNGWriter
+{
+    GN::File * mFile;
+
+public:
+
+    ///
+    /// Constructor
+    ///
+    PNGWriter(GN::File & f) : mFile(&f)
+    {
+    }
+
+    ///
+    /// Write the plane (first slice of it) as 8-bit gray, gray + alpha, RGB or RGBA image.
+    /// sRGB channels are written as is. The format must be convertible.
+    ///
+    bool write(const GN::gfx::ImagePlaneDesc & plane, const void * pixels);
+};
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_GFX_IMAGEPNG_H__
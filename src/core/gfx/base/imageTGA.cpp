@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "imageTGA.h"
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.image");
+
+// *****************************************************************************
+// local types
+// *****************************************************************************
+
+///
+/// TGA file header
+///
+#pragma pack(push, 1)
+struct TGAFileHeader
+{
+    uint8  idLength;
+    uint8  colorMapType;
+    uint8  imageType;    ///< 2: true color, 3: gray
+    uint16 colorMapStart;
+    uint16 colorMapLength;
+    uint8  colorMapBits;
+    uint16 x;
+    uint16 y;
+    uint16 width;
+    uint16 height;
+    uint8  bits;
+    uint8  descriptor;   ///< alpha bits, and 0x20 for top-left origin
+};
+#pragma pack(pop)
+GN_CASSERT( sizeof(TGAFileHeader) == 18 );
+
+// *****************************************************************************
+// TGAWriter public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool TGAWriter::write( const ImagePlaneDesc & plane, const void * pixels )
+{
+    GN_GUARD;
+
+    if( plane.empty() || NULL == pixels || !isConvertibleColorFormat( plane.format ) || plane.step != plane.format.getBitsPerPixel() )
+    {
+        GN_ERROR(sLogger)( "TGA writer needs non-empty image of convertible format and packed pixels." );
+        return false;
+    }
+    if( plane.width > 0xFFFF || plane.height > 0xFFFF )
+    {
+        GN_ERROR(sLogger)( "Image is too large for TGA: %ux%u.", plane.width, plane.height );
+        return false;
+    }
+
+    // sRGB channels are stored as is, so TGA holds the same bytes as the image.
+    ColorFormat src = plane.format;
+    if( ColorFormat::SIGN_GNORM == src.sign012 ) src.sign012 = ColorFormat::SIGN_UNORM;
+    if( ColorFormat::SIGN_GNORM == src.sign3 ) src.sign3 = ColorFormat::SIGN_UNORM;
+
+    // TGA has no gray + alpha. Such images are stored as BGRA.
+    bool alpha = src.swizzle3 < ColorFormat::SWIZZLE_0;
+    bool gray = !alpha && src.swizzle0 == src.swizzle1 && src.swizzle1 == src.swizzle2;
+    ColorFormat dst = gray ? ColorFormat::L_8_UNORM : alpha ? ColorFormat::BGRA_8_8_8_8_UNORM : ColorFormat::BGR_8_8_8_UNORM;
+
+    TGAFileHeader header;
+    memset( &header, 0, sizeof(header) );
+    header.imageType = gray ? 3 : 2;
+    header.width = (uint16)plane.width;
+    header.height = (uint16)plane.height;
+    header.bits = dst.getBitsPerPixel();
+    header.descriptor = 0x20 | ( alpha ? 8 : 0 );
+
+    size_t written;
+    if( !mFile->write( &header, sizeof(header), &written ) || sizeof(header) != written )
+    {
+        GN_ERROR(sLogger)( "fail to write TGA file header!" );
+        return false;
+    }
+
+    // Convert a band of rows at a time, to make fewer and larger writes.
+    size_t rowBytes = plane.width * header.bits / 8;
+    size_t bandRows = std::max<size_t>( 1, 256 * 1024 / rowBytes );
+    DynaArray<uint8> band( rowBytes * std::min<size_t>( bandRows, plane.height ) );
+    for( uint32 y = 0; y < plane.height; y += (uint32)bandRows )
+    {
+        size_t rows = std::min<size_t>( bandRows, plane.height - y );
+        for( size_t r = 0; r < rows; ++r )
+        {
+            const uint8 * row = (const uint8*)pixels + plane.pixel( 0, y + r, 0 );
+            convertPixels( src, row, dst, band.rawptr() + r * rowBytes, plane.width );
+        }
+        if( !mFile->write( band.rawptr(), rows * rowBytes, &written ) || rows * rowBytes != written )
+        {
+            GN_ERROR(sLogger)( "fail to write TGA pixels." );
+            return false;
+        }
+    }
+
+    return true;
+
+    GN_UNGUARD;
+}
@@ -0,0 +1,34 @@
+#ifndef __GN_GFX_IMAGETGA_H__
+#define __GN_GFX_IMAGETGA_H__
+// *****************************************************************************
+/// \file
+/// \brief   TGA image writer
+// *****************************************************************************
+
+///
+/// tga image writer
+///
+class TGAWriter
+{
+    GN::File * mFile;
+
+public:
+
+    ///
+    /// Constructor
+    ///
+    TGAWriter(GN::File & f) : mFile(&f)
+    {
+    }
+
+    ///
+    /// Write the plane (first slice of it) as uncompressed 8-bit gray, BGR or BGRA image.
+    /// sRGB channels are written as is. The format must be convertible.
+    ///
+    bool write(const GN::gfx::ImagePlaneDesc & plane, const void * pixels);
+};
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_GFX_IMAGETGA_H__
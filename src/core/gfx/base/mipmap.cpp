@@ -0,0 +1,562 @@
+#include "pch.h"
+#include <math.h>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.base.mipmap");
+
+// *****************************************************************************
+// local types
+// *****************************************************************************
+
+namespace
+{
+    /// destination rows filtered per job
+    const uint32 BAND_ROWS = 8;
+
+    /// Filters are downscaled by at most 3x (3 pixels to 1), so 3-lobe kernels read at most 19
+    /// source pixels.
+    const uint32 MAX_TAPS = 32;
+
+    ///
+    /// Taps of the filter along one axis. Every destination pixel reads the same number of
+    /// source pixels, with clamped indices and normalized weights. Short ones are padded with
+    /// zero weights.
+    ///
+    struct AxisFilter
+    {
+        uint32            taps;
+        DynaArray<uint32> index;  ///< taps * destination size
+        DynaArray<float>  weight; ///< taps * destination size
+
+        /// first and last source pixel read by destination pixels in [begin, end)
+        void range( uint32 begin, uint32 end, uint32 & first, uint32 & last ) const
+        {
+            first = UINT_MAX;
+            last = 0;
+            for( size_t i = begin * taps; i < end * taps; ++i )
+            {
+                if( index[i] < first ) first = index[i];
+                if( index[i] > last ) last = index[i];
+            }
+        }
+    };
+
+    ///
+    /// how pixels of the image are read and written in the float RGBA filtering space.
+    ///
+    struct PixelSpace
+    {
+        ColorFormat format;       ///< image format, with signs changed for the color space
+        bool        premultiply;  ///< alpha weighted filtering
+        bool        normalMap;
+        bool        biasedNormal; ///< UNORM normal, [0, 1] mapped to [-1, 1]
+        bool        computeZ;     ///< normal format without Z channel
+    };
+}
+
+// *****************************************************************************
+// filter kernels
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static double sSinc( double x )
+{
+    if( fabs( x ) < 1e-6 ) return 1.0;
+    x *= GN_PI;
+    return sin( x ) / x;
+}
+
+///
+/// modified Bessel function of the first kind, order 0
+// -----------------------------------------------------------------------------
+static double sBesselI0( double x )
+{
+    double sum = 1.0, term = 1.0, q = x * x / 4.0;
+    for( int k = 1; k < 50 && term > sum * 1e-12; ++k )
+    {
+        term *= q / ( (double)k * k );
+        sum += term;
+    }
+    return sum;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static double sKaiser( double x )
+{
+    const double WIDTH = 3.0, ALPHA = 4.0;
+    if( fabs( x ) >= WIDTH ) return 0.0;
+    double t = x / WIDTH;
+    return sSinc( x ) * sBesselI0( ALPHA * sqrt( 1.0 - t * t ) ) / sBesselI0( ALPHA );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static double sLanczos( double x )
+{
+    if( fabs( x ) >= 3.0 ) return 0.0;
+    return sSinc( x ) * sSinc( x / 3.0 );
+}
+
+///
+/// Build taps of one axis, from srcSize pixels to dstSize pixels. Box filter weights source
+/// pixels by how much they are covered by the destination pixel. Windowed sinc filters are
+/// stretched by the scale, so they cut off frequencies that the destination can not hold.
+// -----------------------------------------------------------------------------
+static void sBuildAxisFilter( AxisFilter & f, uint32 srcSize, uint32 dstSize, MipmapFilter filter )
+{
+    if( srcSize == dstSize )
+    {
+        f.taps = 1;
+        f.index.resize( dstSize );
+        f.weight.resize( dstSize );
+        for( uint32 i = 0; i < dstSize; ++i ) { f.index[i] = i; f.weight[i] = 1.0f; }
+        return;
+    }
+
+    double scale = (double)srcSize / dstSize;
+    double radius = ( MipmapFilter::BOX == filter ? 0.5 : 3.0 ) * scale;
+    int span = (int)ceil( radius * 2.0 ) + 3;
+
+    // weights of all pixels in the span, trimmed to non-zero ones.
+    DynaArray<double> w( dstSize * span );
+    DynaArray<int> first( dstSize ), count( dstSize );
+    uint32 taps = 1;
+    for( uint32 i = 0; i < dstSize; ++i )
+    {
+        double center = ( i + 0.5 ) * scale;
+        int begin = (int)floor( center - radius ) - 1;
+        int lo = span, hi = -1;
+        for( int t = 0; t < span; ++t )
+        {
+            double j = begin + t, v;
+            if( MipmapFilter::BOX == filter )
+                v = math::getmax( 0.0, math::getmin( j + 1.0, center + radius ) - math::getmax( j, center - radius ) );
+            else if( MipmapFilter::KAISER == filter )
+                v = sKaiser( ( j + 0.5 - center ) / scale );
+            else
+                v = sLanczos( ( j + 0.5 - center ) / scale );
+            if( fabs( v ) < 1e-7 ) v = 0.0;
+            w[i * span + t] = v;
+            if( 0.0 != v ) { lo = math::getmin( lo, t ); hi = t; }
+        }
+        GN_ASSERT( hi >= lo );
+        first[i] = lo;
+        count[i] = hi - lo + 1;
+        taps = math::getmax<uint32>( taps, count[i] );
+    }
+    GN_ASSERT( taps <= MAX_TAPS );
+
+    f.taps = taps;
+    f.index.resize( dstSize * taps );
+    f.weight.resize( dstSize * taps );
+    for( uint32 i = 0; i < dstSize; ++i )
+    {
+        double center = ( i + 0.5 ) * scale;
+        int begin = (int)floor( center - radius ) - 1 + first[i];
+        const double * src = &w[i * span + first[i]];
+        double sum = 0;
+        for( int t = 0; t < count[i]; ++t ) sum += src[t];
+        for( uint32 t = 0; t < taps; ++t )
+        {
+            int j = begin + math::getmin<int>( t, count[i] - 1 );
+            f.index[i * taps + t] = (uint32)math::clamp<int>( j, 0, (int)srcSize - 1 );
+            f.weight[i * taps + t] = (int)t < count[i] ? (float)( src[t] / sum ) : 0.0f;
+        }
+    }
+}
+
+// *****************************************************************************
+// row kernels
+// *****************************************************************************
+
+///
+/// filter one row along X
+// -----------------------------------------------------------------------------
+static void sFilterRow( const AxisFilter & f, const Vector4f * src, Vector4f * dst, uint32 count )
+{
+    const uint32 * index = f.index.rawptr();
+    const float * weight = f.weight.rawptr();
+    uint32 taps = f.taps;
+
+#if GN_SIMD
+    using namespace GN::simd;
+    if( 2 == taps )
+    {
+        // box filter of even sizes
+        for( uint32 i = 0; i < count; ++i, index += 2, weight += 2 )
+        {
+            Float4 a = mul( splat( weight[0] ), load( &src[index[0]].x ) );
+            store( &dst[i].x, madd( splat( weight[1] ), load( &src[index[1]].x ), a ) );
+        }
+        return;
+    }
+    for( uint32 i = 0; i < count; ++i, index += taps, weight += taps )
+    {
+        Float4 acc = zero();
+        for( uint32 t = 0; t < taps; ++t ) acc = madd( splat( weight[t] ), load( &src[index[t]].x ), acc );
+        store( &dst[i].x, acc );
+    }
+#else
+    for( uint32 i = 0; i < count; ++i, index += taps, weight += taps )
+    {
+        Vector4f acc( 0, 0, 0, 0 );
+        for( uint32 t = 0; t < taps; ++t )
+        {
+            const Vector4f & s = src[index[t]];
+            float w = weight[t];
+            acc.x += s.x * w; acc.y += s.y * w; acc.z += s.z * w; acc.w += s.w * w;
+        }
+        dst[i] = acc;
+    }
+#endif
+}
+
+///
+/// dst += sum of rows[t] * weights[t]
+// -----------------------------------------------------------------------------
+static void sAccumulateRows( const Vector4f * const * rows, const float * weights, uint32 taps, Vector4f * dst, uint32 count )
+{
+#if GN_SIMD
+    using namespace GN::simd;
+    Float4 w[MAX_TAPS];
+    for( uint32 t = 0; t < taps; ++t ) w[t] = splat( weights[t] );
+    for( uint32 x = 0; x < count; ++x )
+    {
+        Float4 acc = load( &dst[x].x );
+        for( uint32 t = 0; t < taps; ++t ) acc = madd( w[t], load( &rows[t][x].x ), acc );
+        store( &dst[x].x, acc );
+    }
+#else
+    for( uint32 x = 0; x < count; ++x )
+    {
+        Vector4f & d = dst[x];
+        for( uint32 t = 0; t < taps; ++t )
+        {
+            const Vector4f & s = rows[t][x];
+            float w = weights[t];
+            d.x += s.x * w; d.y += s.y * w; d.z += s.z * w; d.w += s.w * w;
+        }
+    }
+#endif
+}
+
+///
+/// Read pixels into the filtering space: premultiply alpha, or unpack normals.
+// -----------------------------------------------------------------------------
+static void sDecodeRow( const PixelSpace & ps, const uint8 * src, Vector4f * dst, uint32 count )
+{
+    convertPixels( ps.format, src, ColorFormat::FLOAT4, dst, count );
+
+    if( ps.premultiply )
+    {
+#if GN_SIMD
+        using namespace GN::simd;
+        Float4 one = splat( 1.0f );
+        for( uint32 x = 0; x < count; ++x )
+        {
+            // multiply by [ a, a, a, 1 ]
+            Float4 v = load( &dst[x].x );
+            Float4 a = shuffle<3, 3, 3, 3>( v );
+            Float4 a1 = shuffle<0, 0, 0, 0>( a, one );
+            store( &dst[x].x, mul( v, shuffle<0, 1, 0, 2>( a, a1 ) ) );
+        }
+#else
+        for( uint32 x = 0; x < count; ++x )
+        {
+            Vector4f & v = dst[x];
+            v.x *= v.w; v.y *= v.w; v.z *= v.w;
+        }
+#endif
+    }
+    else if( ps.normalMap )
+    {
+        for( uint32 x = 0; x < count; ++x )
+        {
+            Vector4f & v = dst[x];
+            if( ps.biasedNormal ) { v.x = v.x * 2.0f - 1.0f; v.y = v.y * 2.0f - 1.0f; v.z = v.z * 2.0f - 1.0f; }
+            if( ps.computeZ ) v.z = sqrtf( math::getmax( 0.0f, 1.0f - v.x * v.x - v.y * v.y ) );
+        }
+    }
+}
+
+///
+/// Renormalize filtered normals, to unit length.
+// -----------------------------------------------------------------------------
+static void sNormalizeRow( Vector4f * row, uint32 count )
+{
+    for( uint32 x = 0; x < count; ++x )
+    {
+        Vector4f & v = row[x];
+        float len2 = v.x * v.x + v.y * v.y + v.z * v.z;
+        if( len2 > 1e-12f )
+        {
+            float s = 1.0f / sqrtf( len2 );
+            v.x *= s; v.y *= s; v.z *= s;
+        }
+        else
+        {
+            v.x = 0; v.y = 0; v.z = 1.0f;
+        }
+    }
+}
+
+///
+/// Write filtered pixels: undo premultiplied alpha, or pack normals.
+// -----------------------------------------------------------------------------
+static void sEncodeRow( const PixelSpace & ps, Vector4f * src, uint8 * dst, uint32 count )
+{
+    if( ps.premultiply )
+    {
+        // sharp filters may ring out of [0, 1].
+#if GN_SIMD
+        using namespace GN::simd;
+        Float4 zero4 = zero(), one = splat( 1.0f );
+        for( uint32 x = 0; x < count; ++x )
+        {
+            // [ x / a, y / a, z / a, a ]
+            Float4 v = load( &src[x].x );
+            Float4 a = minimum( maximum( shuffle<3, 3, 3, 3>( v ), zero4 ), one );
+            Float4 inv = select( cmplt( zero4, a ), div( one, a ), zero4 );
+            Float4 r = mul( v, shuffle<0, 1, 0, 2>( inv, shuffle<0, 0, 0, 0>( inv, one ) ) );
+            store( &src[x].x, shuffle<0, 1, 0, 2>( r, shuffle<2, 2, 3, 3>( r, a ) ) );
+        }
+#else
+        for( uint32 x = 0; x < count; ++x )
+        {
+            Vector4f & v = src[x];
+            v.w = math::clamp( v.w, 0.0f, 1.0f );
+            float s = v.w > 0 ? 1.0f / v.w : 0.0f;
+            v.x *= s; v.y *= s; v.z *= s;
+        }
+#endif
+    }
+    else if( ps.normalMap && ps.biasedNormal )
+    {
+        for( uint32 x = 0; x < count; ++x )
+        {
+            Vector4f & v = src[x];
+            v.x = v.x * 0.5f + 0.5f; v.y = v.y * 0.5f + 0.5f; v.z = v.z * 0.5f + 0.5f;
+        }
+    }
+
+    convertPixels( ColorFormat::FLOAT4, src, ps.format, dst, count );
+}
+
+// *****************************************************************************
+// mipmap generation
+// *****************************************************************************
+
+///
+/// Pick how pixels are read and written, for the color space. Return false, if the format
+/// does not fit the color space.
+// -----------------------------------------------------------------------------
+static bool sSetupPixelSpace( PixelSpace & ps, ColorFormat format, MipmapColorSpace colorSpace, bool alphaWeighted )
+{
+    if( MipmapColorSpace::AUTO == colorSpace )
+    {
+        colorSpace = ColorFormat::SIGN_GNORM == format.sign012 ? MipmapColorSpace::SRGB : MipmapColorSpace::LINEAR;
+    }
+
+    // GNORM channels decode to linear values, and UNORM channels are read as they are.
+    ps.format = format;
+    if( MipmapColorSpace::SRGB == colorSpace )
+    {
+        if( ColorFormat::SIGN_UNORM != format.sign012 && ColorFormat::SIGN_GNORM != format.sign012 )
+        {
+            GN_ERROR(sLogger)( "sRGB mipmaps need UNORM or GNORM color channels: %s.", format.toString().rawptr() );
+            return false;
+        }
+        ps.format.sign012 = ColorFormat::SIGN_GNORM;
+    }
+    else if( ColorFormat::SIGN_GNORM == format.sign012 )
+    {
+        ps.format.sign012 = ColorFormat::SIGN_UNORM;
+    }
+
+    ps.normalMap = MipmapColorSpace::NORMAL_MAP == colorSpace;
+    ps.biasedNormal = ps.normalMap && ColorFormat::SIGN_UNORM == ps.format.sign012;
+    ps.computeZ = ps.normalMap && format.swizzle2 >= ColorFormat::SWIZZLE_0;
+    ps.premultiply = alphaWeighted && !ps.normalMap && format.swizzle3 < ColorFormat::SWIZZLE_0;
+    return true;
+}
+
+///
+/// Filter one layer: each level from the one above it, in float RGBA.
+// -----------------------------------------------------------------------------
+static void sFilterLayer( RawImage & image, uint32 layer, const PixelSpace & ps, MipmapFilter filter, JobSystem * js )
+{
+    const ImageDesc & desc = image.desc();
+    DynaArray<Vector4f> prev, next;
+
+    for( uint32 level = 1; level < desc.levels; ++level )
+    {
+        const ImagePlaneDesc & sp = desc.plane( layer, level - 1 );
+        const ImagePlaneDesc & dp = desc.plane( layer, level );
+        uint32 sw = sp.width, sh = sp.height, sd = sp.depth;
+        uint32 dw = dp.width, dh = dp.height, dd = dp.depth;
+
+        AxisFilter fx, fy, fz;
+        sBuildAxisFilter( fx, sw, dw, filter );
+        sBuildAxisFilter( fy, sh, dh, filter );
+        sBuildAxisFilter( fz, sd, dd, filter );
+
+        // the last level is not read by any other.
+        bool keep = level + 1 < desc.levels;
+        if( keep ) next.resize( (size_t)dw * dh * dd );
+
+        uint32 numBands = ( dh + BAND_ROWS - 1 ) / BAND_ROWS;
+        auto bands = [&]( size_t begin, size_t end ) {
+            DynaArray<Vector4f> fetched( 1 == level ? sw : 0 );
+            DynaArray<Vector4f> horz( (size_t)( BAND_ROWS * 3 + MAX_TAPS ) * dw );
+            DynaArray<Vector4f> band( (size_t)BAND_ROWS * dw );
+            for( size_t b = begin; b < end; ++b )
+            {
+                uint32 z = (uint32)( b / numBands );
+                uint32 y0 = (uint32)( b % numBands ) * BAND_ROWS;
+                uint32 y1 = math::getmin( y0 + BAND_ROWS, dh );
+                uint32 first, last;
+                fy.range( y0, y1, first, last );
+                GN_ASSERT( ( last - first + 1 ) * dw <= horz.size() );
+
+                memset( (void*)band.rawptr(), 0, sizeof(Vector4f) * ( y1 - y0 ) * dw );
+                for( uint32 tz = 0; tz < fz.taps; ++tz )
+                {
+                    uint32 sz = fz.index[z * fz.taps + tz];
+                    float wz = fz.weight[z * fz.taps + tz];
+                    if( 0.0f == wz ) continue;
+
+                    // filter source rows along X
+                    for( uint32 y = first; y <= last; ++y )
+                    {
+                        const Vector4f * row;
+                        if( 1 == level )
+                        {
+                            sDecodeRow( ps, image.pixel( layer, 0, 0, y, sz ), fetched.rawptr(), sw );
+                            row = fetched.rawptr();
+                        }
+                        else
+                        {
+                            row = prev.rawptr() + ( (size_t)sz * sh + y ) * sw;
+                        }
+                        sFilterRow( fx, row, horz.rawptr() + ( y - first ) * dw, dw );
+                    }
+
+                    // then along Y (and Z)
+                    for( uint32 y = y0; y < y1; ++y )
+                    {
+                        const Vector4f * rows[MAX_TAPS];
+                        float weights[MAX_TAPS];
+                        for( uint32 t = 0; t < fy.taps; ++t )
+                        {
+                            rows[t] = horz.rawptr() + ( fy.index[y * fy.taps + t] - first ) * dw;
+                            weights[t] = fy.weight[y * fy.taps + t] * wz;
+                        }
+                        sAccumulateRows( rows, weights, fy.taps, band.rawptr() + ( y - y0 ) * dw, dw );
+                    }
+                }
+
+                for( uint32 y = y0; y < y1; ++y )
+                {
+                    Vector4f * row = band.rawptr() + ( y - y0 ) * dw;
+                    if( ps.normalMap ) sNormalizeRow( row, dw );
+                    if( keep ) memcpy( next.rawptr() + ( (size_t)z * dh + y ) * dw, row, sizeof(Vector4f) * dw );
+                    sEncodeRow( ps, row, image.pixel( layer, level, 0, y, z ), dw );
+                }
+            }
+        };
+
+        size_t numJobs = (size_t)numBands * dd;
+        if( js && numJobs > 1 )
+        {
+            js->parallelFor( 0, numJobs, bands, 1, "generate mipmaps" );
+        }
+        else
+        {
+            bands( 0, numJobs );
+        }
+
+        prev.swap( next );
+    }
+}
+
+///
+/// Copy the base level into a new image with full mipmap chain, then filter the rest.
+// -----------------------------------------------------------------------------
+static bool sGenerateMipmaps( RawImage & image, JobSystem * js, MipmapFilter filter, MipmapColorSpace colorSpace, bool alphaWeighted )
+{
+    if( image.empty() || NULL == image.data() )
+    {
+        GN_ERROR(sLogger)( "Can't generate mipmaps for empty image." );
+        return false;
+    }
+
+    const ImageDesc & desc = image.desc();
+    ColorFormat format = desc.format();
+    if( !isConvertibleColorFormat( format ) )
+    {
+        GN_ERROR(sLogger)( "Can't generate mipmaps for color format %s.", format.toString().rawptr() );
+        return false;
+    }
+
+    PixelSpace ps;
+    if( !sSetupPixelSpace( ps, format, colorSpace, alphaWeighted ) ) return false;
+    if( !isConvertibleColorFormat( ps.format ) )
+    {
+        GN_ERROR(sLogger)( "Can't generate mipmaps for color format %s.", format.toString().rawptr() );
+        return false;
+    }
+
+    const ImagePlaneDesc & base = desc.plane();
+    RawImage result( ImageDesc( ImagePlaneDesc::make( format, base.width, base.height, base.depth ), desc.layers, 0 ) );
+    if( result.empty() || NULL == result.data() )
+    {
+        GN_ERROR(sLogger)( "Failed to create mipmapped image." );
+        return false;
+    }
+
+    size_t rowBytes = (size_t)base.width * base.step / 8;
+    for( uint32 layer = 0; layer < desc.layers; ++layer )
+    {
+        const ImagePlaneDesc & sp = desc.plane( layer, 0 );
+        for( uint32 z = 0; z < sp.depth; ++z )
+        for( uint32 y = 0; y < sp.height; ++y )
+        {
+            memcpy( result.pixel( layer, 0, 0, y, z ), image.pixel( layer, 0, 0, y, z ), rowBytes );
+        }
+    }
+
+    for( uint32 layer = 0; layer < desc.layers; ++layer )
+    {
+        sFilterLayer( result, layer, ps, filter, js );
+    }
+
+    image = std::move( result );
+    return true;
+}
+
+// *****************************************************************************
+// public functions
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::RawImage::generateMipmaps( MipmapFilter filter, MipmapColorSpace colorSpace, bool alphaWeighted )
+{
+    return sGenerateMipmaps( *this, NULL, filter, colorSpace, alphaWeighted );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API bool GN::gfx::RawImage::generateMipmaps( JobSystem & js, MipmapFilter filter, MipmapColorSpace colorSpace, bool alphaWeighted )
+{
+    return sGenerateMipmaps( *this, &js, filter, colorSpace, alphaWeighted );
+}
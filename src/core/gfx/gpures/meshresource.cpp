@@ -91,9 +91,15 @@ GN::gfx::MeshResource::Impl::applyToContext( GpuContext & context ) const
 void
 GN::gfx::MeshResource::Impl::calculateBoundingBox( Box<float> & box ) const
 {
+    if( mDesc.hasBounds )
+    {
+        box = mDesc.bounds.box;
+        return;
+    }
+
     MeshResourceDesc desc;
 
-    (MeshResourceDescBase)desc = mDesc;
+    (MeshResourceDescBase&)desc = mDesc;
 
     DynaArray<uint8> buffers[GpuContext::MAX_VERTEX_BUFFERS];
     for( size_t i = 0; i < GpuContext::MAX_VERTEX_BUFFERS; ++i )
@@ -115,9 +121,15 @@ GN::gfx::MeshResource::Impl::calculateBoundingBox( Box<float> & box ) const
 void
 GN::gfx::MeshResource::Impl::calculateBoundingSphere( Sphere<float> & sphere ) const
 {
+    if( mDesc.hasBounds )
+    {
+        sphere = mDesc.bounds.sphere;
+        return;
+    }
+
     MeshResourceDesc desc;
 
-    (MeshResourceDescBase)desc = mDesc;
+    (MeshResourceDescBase&)desc = mDesc;
 
     DynaArray<uint8> buffers[GpuContext::MAX_VERTEX_BUFFERS];
     for( size_t i = 0; i < GpuContext::MAX_VERTEX_BUFFERS; ++i )
@@ -149,6 +161,10 @@ bool GN::gfx::MeshResource::Impl::create( const MeshResourceDesc & desc )
     // store descriptor
     mDesc = desc;
 
+    // Dynamic vertices are rewritten through the GPU vertex buffer, which precomputed
+    // bounds don't follow. Bounds of such mesh are always calculated from current vertices.
+    if( desc.dynavb ) mDesc.hasBounds = false;
+
     Gpu & gpu = getGdb().getGpu();
 
     // initialize vertex buffers
@@ -320,6 +336,54 @@ GN::gfx::MeshResource::loadFromFile(
     return m;
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+AsyncResult< AutoRef<MeshResource> >
+GN::gfx::MeshResource::loadFromFileAsync(
+    GpuResourceDatabase & db,
+    const char          * filename,
+    AsyncPriority         priority,
+    AsyncLoader         & loader )
+{
+    typedef AutoRef<MeshResource> Result;
+
+    if( NULL == filename )
+    {
+        GN_INFO(sLogger)( "Null filename string." );
+        return loader.run<Result>( "MeshResource::loadFromFileAsync", priority, []( Result & ) { return false; } );
+    }
+
+    StrA abspath = fs::resolvePath( fs::getCurrentDir(), filename );
+
+    // Reuse existing resource, if possible. No need to touch the file then.
+    Result existing( db.findResource<MeshResource>( filename ) );
+    if( !existing ) existing = db.findResource<MeshResource>( abspath );
+    if( existing )
+    {
+        return loader.run<Result>( "MeshResource::loadFromFileAsync", priority, nullptr,
+            [existing]( Result & r ) { r = existing; return true; } );
+    }
+
+    AutoRef<MeshLoadingStage> stage = referenceTo( new MeshLoadingStage );
+    GpuResourceDatabase * pdb = &db;
+
+    return loader.run<Result>( "MeshResource::loadFromFileAsync", priority,
+        // worker thread: load vertex and index data
+        [stage, abspath]( Result & ) {
+            stage->blob = stage->desc.loadFromFile( abspath );
+            return !!stage->blob;
+        },
+        // main thread: create GPU buffers, unless someone else loaded it in the meantime.
+        [stage, abspath, pdb]( Result & r ) {
+            r = pdb->findResource<MeshResource>( abspath );
+            if( r ) return true;
+            r = pdb->createResource<MeshResource>( abspath );
+            if( !r || !r->reset( &stage->desc ) ) { r.clear(); return false; }
+            return true;
+        } );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -25,6 +25,15 @@ namespace GN { namespace gfx
         bool analyze( const MeshVertexFormat & vf );
     };
 
+    ///
+    /// Mesh data loaded by a worker thread, waiting for GPU buffer creation.
+    ///
+    struct MeshLoadingStage : public RefCounter
+    {
+        MeshResourceDesc desc; ///< points into blob
+        AutoRef<Blob>    blob;
+    };
+
     ///
     /// Mesh resource implementation class
     ///
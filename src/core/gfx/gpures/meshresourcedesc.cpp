@@ -33,7 +33,7 @@ struct MeshBinaryFileHeaderV2
 {
     char                tag[16];      ///< must be "GARNET MESH BIN\0"
     uint32              endian;       ///< endian tag: 0x01020304 means file is in the same endian as the host OS.
-    uint32              version;      ///< mesh binary version must be 0x00010000
+    uint32              version;      ///< mesh binary version: 0x00010000, or 0x00010001 if MeshBounds follows the header
     uint32              prim;         ///< primitive type
     uint32              numvtx;       ///< number of vertices
     uint32              numidx;       ///< number of indices. 0 means non-indexed mesh
@@ -54,6 +54,13 @@ GN_CASSERT( sizeof(MESH_BINARY_TAG_V2) == 16 );
 
 static const uint32 MESH_BINARY_ENDIAN_TAG_V2 = 0x01020304;
 
+static const uint32 MESH_BINARY_VERSION_V2 = 0x00010000;
+
+static const uint32 MESH_BINARY_VERSION_V2_BOUNDS = 0x00010001;
+
+// bounds are stored in mesh binary as is.
+GN_CASSERT( 51 * sizeof(float) == sizeof(MeshBounds) );
+
 struct MeshVertexPosition
 {
     const float * x;
@@ -214,7 +221,9 @@ bool sGetMeshVertexPositions( MeshVertexPosition & pos, const MeshResourceDesc &
         GN_ERROR(sLogger)( "AABB calculation failed: unsupported vertex format %s", positionElement->format.toString().rawptr() );
         return false;
     }
-    pos.strideX = pos.strideY = pos.strideZ = desc.strides[positionElement->stream];
+    size_t stride = desc.strides[positionElement->stream];
+    if( 0 == stride ) stride = desc.vtxfmt.calcStreamStride( positionElement->stream );
+    pos.strideX = pos.strideY = pos.strideZ = stride;
 
     return true;
 }
@@ -280,12 +289,20 @@ AutoRef<Blob> sLoadFromMeshBinaryFile( File & fp, MeshResourceDesc & desc )
         GN_ERROR(sLogger)( "Unsupported endian." );
         return AutoRef<Blob>::NULLREF;
     }
-    if( 0x00010000 != header.version ) // version must be 1.0
+    if( MESH_BINARY_VERSION_V2 != header.version && MESH_BINARY_VERSION_V2_BOUNDS != header.version )
     {
         GN_ERROR(sLogger)( "Unsupported mesh version." );
         return AutoRef<Blob>::NULLREF;
     }
 
+    // read bounds
+    desc.hasBounds = MESH_BINARY_VERSION_V2_BOUNDS == header.version;
+    if( desc.hasBounds && !fp.read( &desc.bounds, sizeof(desc.bounds), NULL ) )
+    {
+        GN_ERROR(sLogger)( "Fail to read mesh bounds." );
+        return AutoRef<Blob>::NULLREF;
+    }
+
     // analyze vertex format
     VertexFormatProperties vfp;
     if( !vfp.analyze( header.vtxfmt ) ) return AutoRef<Blob>::NULLREF;
@@ -710,7 +727,13 @@ uint32 GN::gfx::MeshResourceDescBase::getIdxBufSize() const
 void
 GN::gfx::MeshResourceDesc::calculateBoundingBox( Box<float> & box ) const
 {
-    box.x = box.y = box.w = box.h = 0.0f;
+    if( hasBounds )
+    {
+        box = bounds.box;
+        return;
+    }
+
+    box.x = box.y = box.z = box.w = box.h = box.d = 0.0f;
 
     MeshVertexPosition positions;
 
@@ -725,6 +748,12 @@ GN::gfx::MeshResourceDesc::calculateBoundingBox( Box<float> & box ) const
 void
 GN::gfx::MeshResourceDesc::calculateBoundingSphere( Sphere<float> & sphere ) const
 {
+    if( hasBounds )
+    {
+        sphere = bounds.sphere;
+        return;
+    }
+
     sphere.center.set( 0, 0, 0 );
     sphere.radius = 0;
 
@@ -735,6 +764,88 @@ GN::gfx::MeshResourceDesc::calculateBoundingSphere( Sphere<float> & sphere ) con
     GN::calculateBoundingSphere( sphere, positions.x, positions.strideX, positions.y, positions.strideY, positions.z, positions.strideZ, numvtx );
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::gfx::MeshResourceDesc::calculateBounds()
+{
+    hasBounds = false;
+
+    MeshVertexPosition positions;
+
+    if( !sGetMeshVertexPositions( positions, *this ) ) return false;
+
+    if( positions.y != positions.x + 1 || positions.z != positions.x + 2 )
+    {
+        GN_ERROR(sLogger)( "Bounds calculation failed: position must have 3 or 4 components." );
+        return false;
+    }
+
+    const Vector3f * p = (const Vector3f *)positions.x;
+    size_t stride = positions.strideX;
+
+    GN::calculateBoundingBox( bounds.box, p, stride, numvtx );
+    GN::calculateMinimalBoundingSphere( bounds.sphere, p, stride, numvtx );
+    GN::calculateOrientedBoundingBox( bounds.obb, p, stride, numvtx );
+    GN::calculateDop( bounds.dop, p, stride, numvtx );
+
+    hasBounds = true;
+    return true;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::gfx::MeshResourceDesc::addOccluder( OcclusionBuffer & ob, const Matrix44f & clipFromObject ) const
+{
+    MeshVertexPosition positions;
+
+    if( !sGetMeshVertexPositions( positions, *this ) ) return false;
+
+    if( positions.y != positions.x + 1 || positions.z != positions.x + 2 )
+    {
+        GN_ERROR(sLogger)( "Occluder mesh position must have 3 or 4 components." );
+        return false;
+    }
+
+    const Vector3f * p = (const Vector3f *)positions.x;
+    size_t stride = positions.strideX;
+    bool indexed = numidx > 0 && NULL != indices;
+
+    if( PrimitiveType::TRIANGLE_LIST == prim )
+    {
+        if( !indexed )
+            ob.addOccluder( clipFromObject, p, stride, numvtx, (const uint32*)NULL, 0 );
+        else if( idx32 )
+            ob.addOccluder( clipFromObject, p, stride, numvtx, (const uint32*)indices, numidx );
+        else
+            ob.addOccluder( clipFromObject, p, stride, numvtx, (const uint16*)indices, numidx );
+    }
+    else if( PrimitiveType::TRIANGLE_STRIP == prim )
+    {
+        // convert to triangle list.
+        size_t count = indexed ? numidx : numvtx;
+        if( count < 3 ) return true;
+        DynaArray<uint32> list( ( count - 2 ) * 3 );
+        for( size_t i = 0; i + 2 < count; ++i )
+        {
+            for( size_t k = 0; k < 3; ++k )
+            {
+                size_t j = i + k;
+                list[i * 3 + k] = !indexed ? (uint32)j : idx32 ? ((const uint32*)indices)[j] : ((const uint16*)indices)[j];
+            }
+        }
+        ob.addOccluder( clipFromObject, p, stride, numvtx, list.rawptr(), list.size() );
+    }
+    else
+    {
+        GN_ERROR(sLogger)( "Unsupported occluder primitive type: %s", prim.toString() );
+        return false;
+    }
+
+    return true;
+}
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -782,7 +893,7 @@ bool GN::gfx::MeshResourceDesc::saveToFile( File & fp ) const
     MeshBinaryFileHeaderV2 header;
     memcpy( header.tag, MESH_BINARY_TAG_V2, sizeof(MESH_BINARY_TAG_V2) );
     header.endian = MESH_BINARY_ENDIAN_TAG_V2;
-    header.version = 0x00010000;
+    header.version = hasBounds ? MESH_BINARY_VERSION_V2_BOUNDS : MESH_BINARY_VERSION_V2;
     header.prim   = this->prim;
     header.numvtx = (uint32)this->numvtx;
     header.numidx = (uint32)this->numidx;
@@ -828,6 +939,13 @@ bool GN::gfx::MeshResourceDesc::saveToFile( File & fp ) const
         return false;
     }
 
+    // write bounds
+    if( hasBounds && !fp.write( &bounds, sizeof(bounds), NULL ) )
+    {
+        GN_ERROR(sLogger)( "Fail to write mesh bounds." );
+        return false;
+    }
+
     // write vertex buffers
     for( size_t i = 0; i < GpuContext::MAX_VERTEX_BUFFERS; ++i )
     {
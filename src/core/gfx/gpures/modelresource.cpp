@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "modelresource.h"
+#include "meshresource.h"
+#include "textureresource.h"
 
 using namespace GN;
 using namespace GN::gfx;
@@ -25,6 +27,81 @@ static StrA sResolveResourcePath( const StrA & basedir, const StrA & path )
     }
 }
 
+///
+/// Model descriptor and external resource data, loaded by a worker thread.
+///
+struct ModelLoadingStage : public RefCounter
+{
+    struct TextureImage
+    {
+        StrA     name;
+        RawImage image;
+    };
+
+    ModelResourceDesc                desc;
+    AutoRef<MeshLoadingStage>        mesh;      ///< null, if mesh is not from file or failed to load.
+    DynaArray<TextureImage>          textures;
+
+    ///
+    /// Load everything that does not need the GPU. Failing to prefetch a mesh or
+    /// a texture is not an error here: ModelResource::reset() reports it later.
+    ///
+    bool load( const StrA & filename )
+    {
+        if( !loadFromXmlFile( desc, filename ) ) return false;
+
+        if( !desc.mesh.empty() && '@' != desc.mesh[0] )
+        {
+            mesh = referenceTo( new MeshLoadingStage );
+            mesh->blob = mesh->desc.loadFromFile( desc.mesh );
+            if( !mesh->blob ) mesh.clear();
+        }
+
+        for( const StringMap<char,ModelResourceDesc::ModelTextureDesc>::KeyValuePair * iter = desc.textures.first();
+             iter != NULL;
+             iter = desc.textures.next( iter ) )
+        {
+            const StrA & name = iter->value.resourceName;
+            if( name.empty() || '@' == name[0] ) continue;
+
+            TextureImage ti;
+            ti.name = name;
+            ti.image = RawImage::load( name );
+            if( !ti.image.empty() ) textures.append( std::move( ti ) );
+        }
+
+        return true;
+    }
+
+    ///
+    /// Create the prefetched GPU resources, if they are not in the database yet.
+    /// Must be called on the thread that owns the GPU. Database does not hold references
+    /// to the new resources, so the caller keeps them alive till the model references them.
+    ///
+    void createResources( GpuResourceDatabase & db, DynaArray<AutoRef<GpuResource> > & created )
+    {
+        if( mesh )
+        {
+            StrA meshname = fs::resolvePath( fs::getCurrentDir(), desc.mesh );
+            if( !db.findResource<MeshResource>( meshname ) )
+            {
+                AutoRef<MeshResource> m = db.createResource<MeshResource>( meshname );
+                if( m && m->reset( &mesh->desc ) ) created.append( m );
+            }
+        }
+
+        for( size_t i = 0; i < textures.size(); ++i )
+        {
+            StrA texname = fs::resolvePath( fs::getCurrentDir(), textures[i].name );
+            if( !db.findResource<TextureResource>( texname ) )
+            {
+                AutoRef<TextureResource> t = createTextureResourceFromImage( db, texname, textures[i].image );
+                if( t ) created.append( t );
+            }
+        }
+    }
+};
+
 //
 //
 // -----------------------------------------------------------------------------
@@ -1433,6 +1510,55 @@ GN::gfx::ModelResource::loadFromFile(
     return m;
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+AsyncResult< AutoRef<ModelResource> >
+GN::gfx::ModelResource::loadFromFileAsync(
+    GpuResourceDatabase & db,
+    const char          * filename,
+    AsyncPriority         priority,
+    AsyncLoader         & loader )
+{
+    typedef AutoRef<ModelResource> Result;
+
+    if( NULL == filename )
+    {
+        GN_INFO(sLogger)( "Null filename string." );
+        return loader.run<Result>( "ModelResource::loadFromFileAsync", priority, []( Result & ) { return false; } );
+    }
+
+    StrA abspath = fs::resolvePath( fs::getCurrentDir(), filename );
+
+    // Reuse existing resource, if possible. No need to touch the file then.
+    Result existing( db.findResource<ModelResource>( filename ) );
+    if( !existing ) existing = db.findResource<ModelResource>( abspath );
+    if( existing )
+    {
+        return loader.run<Result>( "ModelResource::loadFromFileAsync", priority, nullptr,
+            [existing]( Result & r ) { r = existing; return true; } );
+    }
+
+    AutoRef<ModelLoadingStage> stage = referenceTo( new ModelLoadingStage );
+    GpuResourceDatabase * pdb = &db;
+
+    return loader.run<Result>( "ModelResource::loadFromFileAsync", priority,
+        // worker thread: parse model file, load mesh and texture data.
+        [stage, abspath]( Result & ) {
+            return stage->load( abspath );
+        },
+        // main thread: create GPU resources, then the model itself.
+        [stage, abspath, pdb]( Result & r ) {
+            r = pdb->findResource<ModelResource>( abspath );
+            if( r ) return true;
+            DynaArray<AutoRef<GpuResource> > created;
+            stage->createResources( *pdb, created );
+            r = pdb->createResource<ModelResource>( abspath );
+            if( !r || !r->reset( &stage->desc ) ) { r.clear(); return false; }
+            return true;
+        } );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
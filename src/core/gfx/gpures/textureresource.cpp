@@ -10,6 +10,59 @@ static GN::Logger * sLogger = GN::getLogger("GN.gfx.gpures");
 // Local stuff
 // *****************************************************************************
 
+///
+/// Staged data of asynchronous texture loading
+///
+struct TextureLoadingStage : public RefCounter
+{
+    RawImage image;
+};
+
+//
+//
+// -----------------------------------------------------------------------------
+AutoRef<TextureResource>
+GN::gfx::createTextureResourceFromImage(
+    GpuResourceDatabase & db,
+    const char          * name,
+    const RawImage      & fileImage )
+{
+    // Images keep the format of the file, like 8-bit RGB, which the GPU may not support.
+    // Those are converted to RGBA8, or to RGBA16F if they are float.
+    RawImage converted;
+    const RawImage * src = &fileImage;
+    if( !db.getGpu().checkTextureFormatSupport( fileImage.format(), TextureUsage::DEFAULT ) )
+    {
+        ColorFormat fallback = ColorFormat::SIGN_FLOAT == fileImage.format().sign012 ? ColorFormat::RGBA_16_16_16_16_FLOAT : ColorFormat::RGBA8;
+        if( convertImage( fileImage.desc(), fileImage.data(), fallback, converted ) ) src = &converted;
+    }
+    const RawImage & image = *src;
+
+    // create texture
+    TextureDesc td;
+    td.fromImageDesc(image.desc());
+    AutoRef<Texture> tex = attachTo( db.getGpu().createTexture( td ) );
+    if( !tex ) return AutoRef<TextureResource>::NULLREF;
+
+    // update texture content
+    for( uint32 f = 0; f < td.faces; ++f )
+    for( uint32 l = 0; l < td.levels; ++l )
+    {
+        auto & md = image.desc(f, l);
+        tex->updateMipmap( f, l, 0, md.pitch, md.slice, image.data() + md.offset, SurfaceUpdateFlag::DEFAULT );
+    }
+
+    // create new texture resource
+    AutoRef<TextureResource> texres = db.createResource<TextureResource>( name );
+    if( 0 == texres ) return AutoRef<TextureResource>::NULLREF;
+
+    // attach the texture to the resource
+    texres->setTexture( tex );
+
+    // success
+    return texres;
+}
+
 // *****************************************************************************
 // GN::gfx::TextureResource
 // *****************************************************************************
@@ -56,29 +109,54 @@ GN::gfx::TextureResource::loadFromFile(
     auto image = RawImage::load(filename);
     if (image.empty()) return AutoRef<TextureResource>::NULLREF;
 
-    // create texture
-    TextureDesc td;
-    td.fromImageDesc(image.desc());
-    AutoRef<Texture> tex = attachTo( db.getGpu().createTexture( td ) );
-    if( !tex ) return AutoRef<TextureResource>::NULLREF;
+    return createTextureResourceFromImage( db, filename, image );
+}
 
-    // update texture content
-    for( uint32 f = 0; f < td.faces; ++f )
-    for( uint32 l = 0; l < td.levels; ++l )
+//
+//
+// -----------------------------------------------------------------------------
+AsyncResult< AutoRef<TextureResource> >
+GN::gfx::TextureResource::loadFromFileAsync(
+    GpuResourceDatabase & db,
+    const char          * filename,
+    AsyncPriority         priority,
+    AsyncLoader         & loader )
+{
+    typedef AutoRef<TextureResource> Result;
+
+    if( NULL == filename )
     {
-        auto & md = image.desc(f, l);
-        tex->updateMipmap( f, l, 0, md.pitch, md.slice, image.data() + md.offset, SurfaceUpdateFlag::DEFAULT );
+        GN_INFO(sLogger)( "Null filename string." );
+        return loader.run<Result>( "TextureResource::loadFromFileAsync", priority, []( Result & ) { return false; } );
     }
 
-    // create new texture resource
-    texres = db.createResource<TextureResource>( filename );
-    if( 0 == texres ) return AutoRef<TextureResource>::NULLREF;
+    StrA abspath = fs::resolvePath( fs::getCurrentDir(), filename );
 
-    // attach the texture to the resource
-    texres->setTexture( tex );
+    // Reuse existing resource, if possible. No need to touch the file then.
+    Result existing( db.findResource<TextureResource>( filename ) );
+    if( !existing ) existing = db.findResource<TextureResource>( abspath );
+    if( existing )
+    {
+        return loader.run<Result>( "TextureResource::loadFromFileAsync", priority, nullptr,
+            [existing]( Result & r ) { r = existing; return true; } );
+    }
 
-    // success
-    return texres;
+    AutoRef<TextureLoadingStage> stage = referenceTo( new TextureLoadingStage );
+    GpuResourceDatabase * pdb = &db;
+
+    return loader.run<Result>( "TextureResource::loadFromFileAsync", priority,
+        // worker thread: load and decode the image
+        [stage, abspath]( Result & ) {
+            GN_INFO(sLogger)( "Load texture from file: %s", abspath.rawptr() );
+            stage->image = RawImage::load( abspath );
+            return !stage->image.empty();
+        },
+        // main thread: create the texture, unless someone else loaded it in the meantime.
+        [stage, abspath, pdb]( Result & r ) {
+            r = pdb->findResource<TextureResource>( abspath );
+            if( !r ) r = createTextureResourceFromImage( *pdb, abspath, stage->image );
+            return !!r;
+        } );
 }
 
 //
@@ -11,6 +11,11 @@
 namespace GN { namespace gfx
 {
     bool registerTextureResourceFactory( GpuResourceDatabase & db );
+
+    ///
+    /// Create named texture resource from image. Must be called on the thread that owns the GPU.
+    ///
+    AutoRef<TextureResource> createTextureResourceFromImage( GpuResourceDatabase & db, const char * name, const RawImage & image );
 }}
 
 // *****************************************************************************
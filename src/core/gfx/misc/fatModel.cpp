@@ -273,6 +273,53 @@ bool GN::gfx::FatVertexBuffer::GenerateVertexStream(
     return true;
 }
 
+// *****************************************************************************
+// FatMesh
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::gfx::FatMesh::addOccluder( OcclusionBuffer & ob, const Matrix44f & clipFromObject ) const
+{
+    const FatVertexBuffer::VertexElement * pos = vertices.getPosition();
+    if( NULL == pos ) return false;
+
+    const Vector3f * p = (const Vector3f *)pos->f32;
+    const size_t stride = sizeof(FatVertexBuffer::VertexElement);
+    const uint32 numvtx = vertices.getVertexCount();
+
+    if( PrimitiveType::TRIANGLE_LIST == primitive )
+    {
+        if( indices.empty() )
+            ob.addOccluder( clipFromObject, p, stride, numvtx, (const uint32*)NULL, 0 );
+        else
+            ob.addOccluder( clipFromObject, p, stride, numvtx, indices.rawptr(), indices.size() );
+    }
+    else if( PrimitiveType::TRIANGLE_STRIP == primitive )
+    {
+        // convert to triangle list.
+        size_t count = indices.empty() ? numvtx : indices.size();
+        if( count < 3 ) return true;
+        DynaArray<uint32> list( ( count - 2 ) * 3 );
+        for( size_t i = 0; i + 2 < count; ++i )
+        {
+            for( size_t k = 0; k < 3; ++k )
+            {
+                list[i * 3 + k] = indices.empty() ? (uint32)( i + k ) : indices[i + k];
+            }
+        }
+        ob.addOccluder( clipFromObject, p, stride, numvtx, list.rawptr(), list.size() );
+    }
+    else
+    {
+        GN_ERROR(sLogger)( "Unsupported occluder primitive type: %s", primitive.toString() );
+        return false;
+    }
+
+    return true;
+}
+
 // *****************************************************************************
 // FatSkeleton
 // *****************************************************************************
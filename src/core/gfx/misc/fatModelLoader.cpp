@@ -2813,6 +2813,22 @@ bool GN::gfx::FatModel::loadFromFile( const StrA & filename )
     return noerr;
 }
 
+//
+//
+// -----------------------------------------------------------------------------
+AsyncResult<GN::gfx::FatModel> GN::gfx::FatModel::loadFromFileAsync(
+    const StrA &  filename,
+    AsyncPriority priority,
+    AsyncLoader & loader )
+{
+    // resolve relative path now, in case current directory changes before the load starts.
+    StrA fullFileName = fs::resolvePath( fs::getCurrentDir(), filename );
+
+    return loader.run<FatModel>( "FatModel::loadFromFileAsync", priority, [fullFileName]( FatModel & fm ) {
+        return fm.loadFromFile( fullFileName );
+    } );
+}
+
 //
 //
 // -----------------------------------------------------------------------------
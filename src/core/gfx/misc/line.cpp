@@ -553,6 +553,29 @@ void GN::gfx::ThickLineRenderer::drawEnd()
 //
 // -----------------------------------------------------------------------------
 void GN::gfx::ThickLineRenderer::line( const ThickLineVertex & v0, const ThickLineVertex & v1 )
+{
+    ThickLineVertex v[2] = { v0, v1 };
+    lineList( v, 2 );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::gfx::ThickLineRenderer::line( float x1, float y1, float z1, float x2, float y2, float z2, uint32 color )
+{
+    ThickLineVertex v[2] =
+    {
+        { x1, y1, z1, 0, 0, color },
+        { x2, y2, z2, 1, 1, color },
+    };
+    lineList( v, 2 );
+}
+
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::gfx::ThickLineRenderer::lineList( const ThickLineVertex * vertices, size_t numverts )
 {
     if( !m_Drawing )
     {
@@ -560,10 +583,37 @@ void GN::gfx::ThickLineRenderer::line( const ThickLineVertex & v0, const ThickLi
         return;
     }
 
-    EndPoint e0, e1;
-    calcEndPoint( e0, v0 );
-    calcEndPoint( e1, v1 );
+    // transform vertices in batches: to clip space, if line width is in screen
+    // space, or to view space otherwise.
+    const Matrix44f & transform = m_Parameters.widthInScreenSpace ? m_Parameters.wvp : m_Parameters.worldview;
+    static const size_t BATCH = 64;
+    Vector4f centers[BATCH];
+
+    numverts &= ~(size_t)1;
+    for( size_t base = 0; base < numverts; base += BATCH )
+    {
+        size_t count = math::getmin( BATCH, numverts - base );
+        transformPoints( centers, sizeof(Vector4f), transform, (const Vector3f*)&vertices[base].x, sizeof(ThickLineVertex), count );
+
+        for( size_t i = 0; i < count; i += 2 )
+        {
+            EndPoint e0, e1;
+            calcEndPoint( e0, vertices[base+i], centers[i] );
+            calcEndPoint( e1, vertices[base+i+1], centers[i+1] );
+            addLine( e0, e1 );
+        }
+    }
+}
+
+// *****************************************************************************
+// private methods
+// *****************************************************************************
 
+//
+// Add a line between two end points as a hexagon
+// -----------------------------------------------------------------------------
+void GN::gfx::ThickLineRenderer::addLine( EndPoint & e0, EndPoint & e1 )
+{
     PrivateVertex * v = newPolygon6();
 
     if( e0.post * e1.posw < e1.post * e0.posw )
@@ -657,63 +707,26 @@ void GN::gfx::ThickLineRenderer::line( const ThickLineVertex & v0, const ThickLi
     }
 }
 
-//
-//
-// -----------------------------------------------------------------------------
-void GN::gfx::ThickLineRenderer::line( float x1, float y1, float z1, float x2, float y2, float z2, uint32 color )
-{
-    ThickLineVertex v[2] =
-    {
-        { x1, y1, z1, 0, 0, color },
-        { x2, y2, z2, 1, 1, color },
-    };
-    lineList( v, 2 );
-}
-
-
-//
-//
-// -----------------------------------------------------------------------------
-void GN::gfx::ThickLineRenderer::lineList( const ThickLineVertex * vertices, size_t numverts )
-{
-    size_t numLines = numverts / 2;
-    for( size_t i = 0; i < numLines; ++i )
-    {
-        line( vertices[i*2+0], vertices[i*2+1] );
-    }
-}
-
-// *****************************************************************************
-// private methods
-// *****************************************************************************
-
 //
 // Expand thick line vertex to a quad
 // -----------------------------------------------------------------------------
 void GN::gfx::ThickLineRenderer::calcEndPoint(
     EndPoint              & endpoint,
-    const ThickLineVertex & vertex )
+    const ThickLineVertex & vertex,
+    const Vector4f        & transformed )
 {
     // determine center position and end point size
-    Vector4f center;
+    Vector4f center = transformed;
     float half_w;
     float half_h;
     if( m_Parameters.widthInScreenSpace )
     {
-        // translate vertex into clip space
-        center.set( vertex.x, vertex.y, vertex.z, 1.0f );
-        center = m_Parameters.wvp * center;
-
         // get end point positions in clip space
         half_w = m_Parameters.endPointHalfWidth * center.w;
         half_h = m_Parameters.endPointHalfHeight * center.w;
     }
     else
     {
-        // translate vertex into view space
-        center.set( vertex.x, vertex.y, vertex.z, 1.0f );
-        center = m_Parameters.worldview * center;
-
         // get position of left-top corner in view space
         float half_size = m_Parameters.width / 2.0f * center.w;
         Vector4f topleft = center + Vector4f( -half_size, half_size, 0.0f, 0.0f );
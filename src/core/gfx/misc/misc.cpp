@@ -14,6 +14,14 @@ GN::gfx::loadTextureFromFile( Gpu & gpu, const char * filename )
     auto image = RawImage::load(filename);
     if (image.empty()) return 0;
 
+    // fall back to RGBA8 (or RGBA16F for float) for file formats that the GPU doesn't support.
+    if( !gpu.checkTextureFormatSupport( image.format(), TextureUsage::DEFAULT ) )
+    {
+        ColorFormat fallback = ColorFormat::SIGN_FLOAT == image.format().sign012 ? ColorFormat::RGBA_16_16_16_16_FLOAT : ColorFormat::RGBA8;
+        RawImage converted;
+        if( convertImage( image.desc(), image.data(), fallback, converted ) ) image = std::move(converted);
+    }
+
     // create texture
     TextureDesc td;
     td.fromImageDesc( image.desc() );
@@ -1425,7 +1425,11 @@ sSaveModelHierarchyToXML( const ModelHierarchyDesc & desc, const char * filename
         i = desc.meshes.next( i ) )
     {
         const StrA & oldMeshName = i->key;
-        const MeshResourceDesc & mesh = i->value;
+
+        // Store precomputed bounds with the mesh, so loaders don't need to calculate them.
+        // Meshes without 3D float positions are saved without bounds.
+        MeshResourceDesc mesh = i->value;
+        if( !mesh.hasBounds ) mesh.calculateBounds();
 
         StrA newMeshName = str::format( "%s.%d.mesh.bin", basename.rawptr(), meshindex );
 
@@ -32,7 +32,7 @@ GN_API GN::gfx::Gpu * GN::gfx::createOGLGpu( const GN::gfx::GpuOptions & o, uint
 
     if( 0 != (creationFlags & GPU_CREATION_MULTIPLE_THREADS) )
     {
-        return createMultiThreadGpu( o, sCreateOGLGpuPrivate, 0 );
+        return createMultiThreadGpu( localOptions, sCreateOGLGpuPrivate, 0 );
     }
     else
     {
@@ -1,7 +1,9 @@
 #include "pch.h"
 #include "cmdbuf.h"
 
-static GN::Logger * sLogger = GN::getLogger("GN.base.RingBuffer");
+static GN::Logger * sLogger = GN::getLogger("GN.base.CommandBuffer");
+
+using namespace GN;
 
 // *****************************************************************************
 // GN::CommandBuffer - Initialize and shutdown
@@ -19,46 +21,35 @@ bool GN::CommandBuffer::init( size_t bufferSize )
 
     GN_ASSERT( NULL == m_Buffer );
 
-    if( bufferSize < 16 )
+    if( bufferSize < 256 )
+    {
+        GN_WARN(sLogger)( "The command buffer size is adjusted to 256 bytes." );
+        bufferSize = 256;
+    }
+    if( bufferSize > 0x80000000 )
     {
-        GN_WARN(sLogger)( "The command buffer size is adjusted to 16 bytes." );
-        bufferSize = 16;
+        GN_ERROR(sLogger)( "The command buffer size must be less than 2GB." );
+        return failure();
     }
 
-    // allocate 16 byte aligned ring buffer (double sized, to handle rewind issue)
-    m_Buffer = (uint8*)HeapMemory::alignedAlloc( bufferSize * 2, 16 );
+    // round up to power of 2, so cursors can wrap around 2^32 freely.
+    uint32 size = 256;
+    while( size < bufferSize ) size <<= 1;
+
+    // allocate 16 byte aligned ring buffer
+    m_Buffer = (uint8*)HeapMemory::alignedAlloc( size, 16 );
     if( NULL == m_Buffer ) return failure();
-    m_Size = bufferSize;
+    m_Size = size;
+    m_Mask = size - 1;
 
-    // initialize read and write counters
+    // initialize read and write cursors
     //   *   used bytes = (written - readen)
     //   *   free bytes = m_Size - (written - readen)
     m_ReadenCursor  = 0;
     m_WrittenCursor = 0;
     m_ReadingToken = NULL;
     m_WritingToken = NULL;
-    memoryBarrier();
-
-    // initialize internal events
-    if( !m_ConsumptionEvent.create( SyncEvent::UNSIGNALED, SyncEvent::AUTO_RESET ) ||
-        !m_NotEmpty.create(SyncEvent::UNSIGNALED, SyncEvent::MANUAL_RESET) )
-    {
-        return failure();
-    }
-
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-    // initialize fence array
-    size_t maxFenceCount = m_Size / 16;
-    m_Fences = (FenceInternal*)HeapMemory::alloc( maxFenceCount * sizeof(FenceInternal) );
-    if( NULL == m_Fences ) return failure();
-    for( size_t i = 0; i < maxFenceCount; ++i )
-    {
-        m_Fences[i].event = NULL;
-        m_Fences[i].prev = (i > 0) ? &m_Fences[i-1] : NULL;
-        m_Fences[i].next = ((i+1) < maxFenceCount) ? &m_Fences[i+1] : NULL;
-    }
-    m_NextFreeFence = m_Fences;
-#endif
+    m_Cancelled = false;
 
     // success
     return success();
@@ -73,36 +64,12 @@ void GN::CommandBuffer::quit()
 {
     GN_GUARD;
 
-    // Invalidate tokenID, to unblock any thread that are waiting for consumption tokenID.
-    // Note that tokenID value is 16 byte aligned. so -1 would never be a valid tokenID.
-    m_ReadenCursor = (uint32)-1;
-
-    // delete events
-    m_NotEmpty.destroy();
-    m_ConsumptionEvent.destroy();
-
-    // TODO:
-    //  - Wait for current producer and consumer
-    //  - Cancel incoming producers and consumers
-    //  - Clear initialize flag
+    // Release any thread that is still waiting. Caller must make sure that
+    // no thread enters the buffer after this point.
+    if( m_Buffer ) cancel();
 
     // deallocate ring buffer
-	safeHeapDealloc( m_Buffer );
-
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-    // deallocate fence array
-    if( NULL != m_Fences )
-    {
-        size_t maxFenceCount = m_Size / 16;
-        for( size_t i = 0; i < maxFenceCount; ++i )
-        {
-            safeDelete( m_Fences[i].event );
-        }
-        HeapMemory::dealloc( m_Fences );
-        m_Fences = NULL;
-        m_NextFreeFence = NULL;
-    }
-#endif
+    if( m_Buffer ) HeapMemory::dealloc( m_Buffer );
 
     // standard quit procedure
     GN_STDCLASS_QUIT();
@@ -114,37 +81,28 @@ void GN::CommandBuffer::quit()
 // GN::CommandBuffer - Public Methods
 // *****************************************************************************
 
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-
-//
-//
-// -----------------------------------------------------------------------------
-GN::CommandBuffer::Fence GN::CommandBuffer::insertFence()
-{
-}
-
 //
 //
 // -----------------------------------------------------------------------------
 GN::CommandBuffer::OperationResult
-GN::CommandBuffer::waitForFence( Fence fence )
+GN::CommandBuffer::waitForFence( Fence fence, TimeInNanoSecond timeoutTime )
 {
-    /*for(;;)
+    sync::Deadline deadline( timeoutTime );
+    for(;;)
     {
-        uint32 rf = m_ReadenCursor;
-        memoryBarrier();
+        uint32 rc = m_ReadenCursor.load( std::memory_order_acquire );
+        if( (sint32)( rc - fence ) >= 0 ) return OPERATION_SUCCEEDED;
 
-        if( rf >= tokenID )
-        {
-            return (uint32)-1 == rf ? OPERATION_CANCELLED : OPERATION_SUCCEEDED;
-        }
+        if( m_Cancelled ) return OPERATION_CANCELLED;
 
-        // TODO: use a event to save some CPU.
-        ::Sleep(1);
-    }*/
-}
+        TimeInNanoSecond remaining = deadline.remaining();
+        if( 0 == remaining ) return OPERATION_TIMEDOUT;
 
-#endif
+        m_ReadWaiters.fetch_add( 1 );
+        if( m_ReadenCursor.load() == rc && !m_Cancelled ) sync::waitOnAddress( m_ReadenCursor, rc, remaining );
+        m_ReadWaiters.fetch_sub( 1 );
+    }
+}
 
 //
 //
@@ -156,60 +114,69 @@ GN::CommandBuffer::beginProduce(
     Token *     token,
     SyncEvent * optionalCompletionEvent )
 {
+    GN_ASSERT( PADDING_COMMAND != command );
+
     // align command size to 16 bytes
-    size_t cmdsize = (sizeof(TokenInternal) + parameterSize + 15) & ~15;
-    if( cmdsize > m_Size )
+    uint32 cmdsize = ( sizeof(TokenInternal) + parameterSize + 15 ) & ~15;
+    if( cmdsize > m_Size || parameterSize > 0xFFF0 )
     {
         GN_ERROR(sLogger)( "Command size is too large." );
         return OPERATION_FAILED;
     }
-    parameterSize = (uint16)( cmdsize - sizeof(TokenInternal) );
 
     m_ProducerLock.lock();
 
-    if( NULL != m_WritingToken )
+    if( m_Cancelled )
     {
         m_ProducerLock.unlock();
-        return OPERATION_FAILED;
+        return OPERATION_CANCELLED;
     }
 
-    for(;;)
-    {
-        // cache read/write tokenID to local variable
-        size_t rc = m_ReadenCursor;
-        size_t wc = m_WrittenCursor;
-        GN_ASSERT(rc >= 0 && wc >= 0);
-        memoryBarrier();
+    GN_ASSERT( NULL == m_WritingToken );
 
-        size_t usedBytes = wc - rc;
-        size_t freeBytes = m_Size - usedBytes;
+    uint32 wc = m_WrittenCursor.load( std::memory_order_relaxed );
 
-        if( freeBytes >= cmdsize )
+    // Command does not fit in the tail of the ring. Fill the tail with a
+    // padding command, and start over from the head.
+    uint32 tail = m_Size - ( wc & m_Mask );
+    if( tail < cmdsize )
+    {
+        if( !waitForSpace( tail ) )
         {
-            m_WritingToken = (TokenInternal*)(m_Buffer + ( wc % m_Size )); // TODO: align buffer size to power of 2 to save this mod operation.);
-            m_WritingToken->commandId = command;
-            m_WritingToken->parameterSize = (uint16)parameterSize;
-            m_WritingToken->endOffset = (uint32)(wc + cmdsize);
-            m_WritingToken->completionEvent = optionalCompletionEvent;
+            m_ProducerLock.unlock();
+            return OPERATION_CANCELLED;
+        }
+        TokenInternal * pad = (TokenInternal*)( m_Buffer + ( wc & m_Mask ) );
+        pad->commandId = PADDING_COMMAND;
+        pad->parameterSize = 0;
+        pad->endOffset = wc + tail;
+        pad->completionEvent = NULL;
+        wc += tail;
+        publishWrittenCursor( wc );
+    }
 
-            if( token )
-            {
-                token->commandID = command;
-                token->parameterSize = parameterSize;
-                token->pParameterBuffer = (void*)(m_WritingToken+1);
-            }
+    // wait for consumption, if there's no enough space in ring buffer.
+    if( !waitForSpace( cmdsize ) )
+    {
+        m_ProducerLock.unlock();
+        return OPERATION_CANCELLED;
+    }
 
-            // production succeeds.
-            return OPERATION_SUCCEEDED;
-        }
+    m_WritingToken = (TokenInternal*)( m_Buffer + ( wc & m_Mask ) );
+    m_WritingToken->commandId = command;
+    m_WritingToken->parameterSize = (uint16)( cmdsize - sizeof(TokenInternal) );
+    m_WritingToken->endOffset = wc + cmdsize;
+    m_WritingToken->completionEvent = optionalCompletionEvent;
 
-        // There's no enough space in ring buffer, wait for consumption
-        else if( !m_ConsumptionEvent.wait() )
-        {
-            m_ProducerLock.unlock();
-            return OPERATION_FAILED;
-        }
+    if( token )
+    {
+        token->commandID = command;
+        token->parameterSize = m_WritingToken->parameterSize;
+        token->pParameterBuffer = (void*)( m_WritingToken + 1 );
     }
+
+    // production succeeds. Producer lock is released in endProduce().
+    return OPERATION_SUCCEEDED;
 }
 
 //
@@ -217,27 +184,15 @@ GN::CommandBuffer::beginProduce(
 // -----------------------------------------------------------------------------
 void GN::CommandBuffer::endProduce()
 {
-    // Enter production lock again, which prevents all thread except the one
-    // who calls beginProduce().
-    std::lock_guard<Mutex> lock( m_ProducerLock );
-
     if( NULL == m_WritingToken )
     {
         // This means endProduce() is called without beginProduce().
         return;
     }
 
-    // Updating written tokenID and m_NotEmpty event should be an
-    // atomic operation.
-    m_DataLock.lock();
-    {
-        GN_ASSERT( m_WrittenCursor + m_WritingToken->parameterSize + sizeof(TokenInternal) == m_WritingToken->endOffset );
-        m_WrittenCursor = m_WritingToken->endOffset;
-        GN_ASSERT(m_WrittenCursor >= 0);
-        m_WritingToken = NULL;
-        m_NotEmpty.signal();
-    }
-    m_DataLock.unlock();
+    uint32 end = m_WritingToken->endOffset;
+    m_WritingToken = NULL;
+    publishWrittenCursor( end );
 
     // Leave the production lock which is entered in beginProduce()
     m_ProducerLock.unlock();
@@ -256,76 +211,63 @@ GN::CommandBuffer::beginConsume( Token * token, TimeInNanoSecond timeoutTime )
 
     m_ConsumerLock.lock();
 
-    GN::CommandBuffer::OperationResult hr = OPERATION_SUCCEEDED;
-
     if( NULL != m_ReadingToken )
     {
         // beginConsume is called more than once without endConsume.
-        hr = OPERATION_FAILED;
+        m_ConsumerLock.unlock();
+        return OPERATION_FAILED;
     }
 
-    // wait for production of next command
-    if( OPERATION_SUCCEEDED == hr )
+    sync::Deadline deadline( timeoutTime );
+    OperationResult hr;
+    for(;;)
     {
-        for(;;)
-        {
-            // cache production fences
-            uint32 wc = m_WrittenCursor;
-            memoryBarrier();
+        uint32 rc = m_ReadenCursor.load( std::memory_order_relaxed );
+        uint32 wc = m_WrittenCursor.load( std::memory_order_acquire );
 
-            size_t usedBytes = wc - m_ReadenCursor;
+        if( rc != wc )
+        {
+            TokenInternal * t = (TokenInternal*)( m_Buffer + ( rc & m_Mask ) );
 
-            if( usedBytes < sizeof(TokenInternal) )
-            {
-                WaitResult waitResult = m_NotEmpty.wait( timeoutTime );
-
-                if( WaitResult::TIMEDOUT == waitResult )
-                {
-                    hr = OPERATION_TIMEDOUT;
-                    break;
-                }
-                else if( WaitResult::KILLED == waitResult )
-                {
-                    // exit signal is received
-                    hr = OPERATION_CANCELLED;
-                    break;
-                }
-                else
-                {
-                    GN_ASSERT( WaitResult::COMPLETED == waitResult );
-                }
-            }
-            else
+            // skip padding at the end of the ring
+            if( PADDING_COMMAND == t->commandId )
             {
-                break;
+                publishReadenCursor( t->endOffset );
+                continue;
             }
+
+            // full command including all parameters should have been written to command buffer.
+            GN_ASSERT( wc - rc >= t->parameterSize + sizeof(TokenInternal) );
+
+            m_ReadingToken = t;
+            token->commandID = t->commandId;
+            token->parameterSize = t->parameterSize;
+            token->pParameterBuffer = (void*)( t + 1 );
+
+            // Consumer lock is released in endConsume().
+            return OPERATION_SUCCEEDED;
         }
-    }
 
-    if( OPERATION_SUCCEEDED == hr )
-    {
-        // get command header and parameter
-        m_ReadingToken = (TokenInternal*)( m_Buffer + (m_ReadenCursor % m_Size) );
-
-#if GN_ENABLE_ASSERT
-        // full command including all parameters should have been written to command buffer.
-        uint32 wc = m_WrittenCursor;
-        memoryBarrier();
-        size_t cmdsize = m_ReadingToken->parameterSize + sizeof(TokenInternal);
-        GN_ASSERT( wc - m_ReadenCursor >= cmdsize );
-#endif
-
-        // update output token
-        token->commandID = m_ReadingToken->commandId;
-        token->parameterSize = m_ReadingToken->parameterSize;
-        token->pParameterBuffer = (void**)(m_ReadingToken+1);
-    }
+        if( m_Cancelled )
+        {
+            hr = OPERATION_CANCELLED;
+            break;
+        }
 
-    if( OPERATION_SUCCEEDED != hr )
-    {
-        m_ConsumerLock.unlock();
+        TimeInNanoSecond remaining = deadline.remaining();
+        if( 0 == remaining )
+        {
+            hr = OPERATION_TIMEDOUT;
+            break;
+        }
+
+        // wait for production of next command
+        m_WriteWaiters.fetch_add( 1 );
+        if( m_WrittenCursor.load() == wc && !m_Cancelled ) sync::waitOnAddress( m_WrittenCursor, wc, remaining );
+        m_WriteWaiters.fetch_sub( 1 );
     }
 
+    m_ConsumerLock.unlock();
     return hr;
 }
 
@@ -334,10 +276,6 @@ GN::CommandBuffer::beginConsume( Token * token, TimeInNanoSecond timeoutTime )
 // -----------------------------------------------------------------------------
 void GN::CommandBuffer::endConsume()
 {
-    // Enter consumer lock again here, to prevent all thread other than the
-    // one that calls beginConsume()
-    std::lock_guard<Mutex>lock( m_ConsumerLock );
-
     if( NULL == m_ReadingToken )
     {
         // endConsume() is called without beginConsume()
@@ -345,22 +283,9 @@ void GN::CommandBuffer::endConsume()
     }
 
     SyncEvent * completionEvent = m_ReadingToken->completionEvent;
-    m_ReadenCursor += m_ReadingToken->parameterSize + sizeof(TokenInternal);
+    uint32      end = m_ReadingToken->endOffset;
     m_ReadingToken = NULL;
-    m_ConsumptionEvent.signal();
-
-    // Checking written tokenID and updating m_NotEmpty event should be an
-    // atomic operation.
-    m_DataLock.lock();
-    {
-        uint32 wf = m_WrittenCursor;
-        memoryBarrier();
-        if( wf == m_ReadenCursor )
-        {
-            m_NotEmpty.unsignal();
-        }
-    }
-    m_DataLock.unlock();
+    publishReadenCursor( end );
 
     // trigger completion event
     if( completionEvent ) completionEvent->signal();
@@ -368,3 +293,62 @@ void GN::CommandBuffer::endConsume()
     // Leave the critical section that is entered in beginConsume()
     m_ConsumerLock.unlock();
 }
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::CommandBuffer::cancel()
+{
+    m_Cancelled = true;
+
+    // A waiter might have checked the flag right before it is set, but not be
+    // sleeping yet. So keep waking until every waiter has left.
+    do
+    {
+        sync::wakeAllByAddress( m_ReadenCursor );
+        sync::wakeAllByAddress( m_WrittenCursor );
+        if( 0 == m_ReadWaiters.load() && 0 == m_WriteWaiters.load() ) break;
+        std::this_thread::yield();
+    } while( true );
+}
+
+// *****************************************************************************
+// GN::CommandBuffer - Private Methods
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+bool GN::CommandBuffer::waitForSpace( uint32 bytes )
+{
+    for(;;)
+    {
+        uint32 rc = m_ReadenCursor.load( std::memory_order_acquire );
+        uint32 wc = m_WrittenCursor.load( std::memory_order_relaxed );
+        if( m_Size - ( wc - rc ) >= bytes ) return true;
+
+        if( m_Cancelled ) return false;
+
+        m_ReadWaiters.fetch_add( 1 );
+        if( m_ReadenCursor.load() == rc && !m_Cancelled ) sync::waitOnAddress( m_ReadenCursor, rc );
+        m_ReadWaiters.fetch_sub( 1 );
+    }
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::CommandBuffer::publishWrittenCursor( uint32 wc )
+{
+    m_WrittenCursor.store( wc );
+    if( m_WriteWaiters.load() ) sync::wakeAllByAddress( m_WrittenCursor );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+void GN::CommandBuffer::publishReadenCursor( uint32 rc )
+{
+    m_ReadenCursor.store( rc );
+    if( m_ReadWaiters.load() ) sync::wakeAllByAddress( m_ReadenCursor );
+}
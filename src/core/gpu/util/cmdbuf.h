@@ -6,13 +6,20 @@
 /// \author  chenli@@REDMOND (2010.8.2)
 // *****************************************************************************
 
-// Note: built-in fence is not implemented yet.
-#define GN_COMMAND_BUFFER_BUILT_IN_FENCE 0
-
 namespace GN
 {
     ///
-    /// Command buffer class
+    /// Command buffer class: a ring buffer of variable sized commands, with
+    /// multiple producers and one consumer.
+    ///
+    /// Every command is a 16 bytes header followed by its parameters, rounded
+    /// up to 16 bytes. Commands never straddle the end of the ring: when the
+    /// tail is too small, producer fills it with a padding command that is
+    /// skipped by consumer.
+    ///
+    /// Read and write cursors are byte counters that only grow (modulo 2^32).
+    /// The write cursor is used as a fence: once the read cursor passes it,
+    /// every command produced before the fence is consumed.
     ///
     class CommandBuffer : public StdClass
     {
@@ -24,10 +31,11 @@ namespace GN
 
     public:
 
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
+        ///
+        /// Fence value. Compared with wraparound, so a fence must be waited
+        /// before another 2GB of commands go through the buffer.
+        ///
         typedef uint32 Fence;
-        static const Fence INVALID_FENCE = 0;
-#endif
 
         enum OperationResult
         {
@@ -44,6 +52,11 @@ namespace GN
             void * pParameterBuffer; ///< command
         };
 
+        ///
+        /// Command ID reserved for padding at the end of the ring.
+        ///
+        static const uint16 PADDING_COMMAND = 0xFFFF;
+
         // ********************************
         // ctor/dtor
         // ********************************
@@ -66,10 +79,15 @@ namespace GN
         void clear()
         {
             m_Buffer = NULL;
-            m_ReadenCursor = (uint32)-1;
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-            m_Fences = NULL;
-#endif
+            m_Size = 0;
+            m_Mask = 0;
+            m_ReadenCursor = 0;
+            m_WrittenCursor = 0;
+            m_ReadingToken = NULL;
+            m_WritingToken = NULL;
+            m_ReadWaiters = 0;
+            m_WriteWaiters = 0;
+            m_Cancelled = false;
         }
         //@}
 
@@ -78,33 +96,35 @@ namespace GN
         // ********************************
     public:
 
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-
-        typedef uint32 Fence;
-
-        static const Fence INVALID_FENCE = 0;
+        ///
+        /// Return a fence that is passed when all commands posted so far are consumed.
+        ///
+        Fence insertFence() const { return m_WrittenCursor.load( std::memory_order_acquire ); }
 
-        /// Insert a new fence to the command buffer.
         ///
-        /// Return:
-        ///     Fence ID, if succeeds.
-        ///     INVALID_FENCE, if failed.
-        Fence insertFence();
+        /// Check if all commands before the fence are consumed. Never blocks.
+        ///
+        bool isFencePassed( Fence fence ) const
+        {
+            return (sint32)( m_ReadenCursor.load( std::memory_order_acquire ) - fence ) >= 0;
+        }
 
         // Wait for commands before specific fence are all consumed
         // Return:
-        //      OPERATION_SUCCEEDED, if all commands before the token are consumed.
+        //      OPERATION_SUCCEEDED, if all commands before the fence are consumed.
+        //      OPERATION_TIMEDOUT, if timed out.
         //      OPERATION_CANCELLED, if the command buffer is shutting down.
         //
         // Note: calling this from consumer thread would dead lock the application.
-        OperationResult waitForFence( Fence fence );
-
-#endif
+        OperationResult waitForFence( Fence fence, TimeInNanoSecond timeoutTime = INFINITE_TIME );
 
         // Return:
         //      OPERATION_SUCCEEDED, if production succeeds.
         //      OPERATION_CANCELLED if command buffer is shutting down.
-        //      OPERATION_FAILED for other failures, like not paired with endProduce().
+        //      OPERATION_FAILED for other failures, like command is too large.
+        //
+        // Note: on success, the producer lock is held until endProduce(), which
+        //       must be called by the same thread.
         OperationResult beginProduce( uint16 command, uint16 parameterSize, Token * token, SyncEvent * optionalCompletionEvent = NULL );
         void            endProduce();
 
@@ -231,11 +251,10 @@ namespace GN
         OperationResult beginConsume( Token * token, TimeInNanoSecond timeoutTime = INFINITE_TIME );
         void            endConsume();
 
-
-        // The event is in signaled state, as long as the buffer is not empty.
-        // Please DO NOT change state of this event manually, or it'll break command
-        // buffer's internal logic.
-        const SyncEvent & GetNotEmptyEvent() const { return m_NotEmpty; }
+        ///
+        /// Cancel all pending and future waits. Commands still in the buffer are dropped.
+        ///
+        void cancel();
 
         // utilities to parse command parameter buffer
 
@@ -279,56 +298,43 @@ namespace GN
     private:
 
         // Command token
-        struct TokenInternal
+        struct alignas(16) TokenInternal
         {
             uint16      commandId;           ///< command ID ( 2 bytes )
             uint16      parameterSize;       ///< command parameter size. this header is not included.
-            uint32      endOffset;           ///< Ring buffer offset in bytes of the end of the command.
+            uint32      endOffset;           ///< Ring buffer cursor of the end of the command.
             SyncEvent * completionEvent;     ///< Optional event that gets signaled when the command is consumed.
-#if !GN_X64
-            uint32      _padding; // pad to 16 bytes to get a good cache alignment
-#endif
         };
         GN_CASSERT( 16 == sizeof(TokenInternal) );
 
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-        union FenceInternal
-        {
-            uint32          offset; //< The offset of the command in the command buffer.
-            SyncEvent     * event;  //< The completion event pointer.
-            FenceInternal * prev;   //< Points to the previous free fence in the free list.
-            FenceInternal * next;   //< Points to the next free fence in the free list.
-        };
-#endif
-
         // ring buffer
-        uint8 *          m_Buffer;
-        size_t           m_Size;
-        uint8 *          m_End;
-        volatile uint32  m_ReadenCursor;     // Ring buffer offset pointing to the next byte that will be used for consumption.
-        volatile uint32  m_WrittenCursor;    // Ring buffer offset pointing to the next byte that will be used for production.
-        TokenInternal *  m_ReadingToken;     // Pointer to the current consuming token. Should be NULL outside of beginConsume() and endConsume().
-        TokenInternal *  m_WritingToken;     // Pointer to the current producing token. Should be NULL outside of beginProdue() and endProduce().
-        SyncEvent        m_ConsumptionEvent; // auto-reset event that is signaled whenever a command is consumed, and unsignaled when buffer is full.
-        SyncEvent        m_NotEmpty;         // manual-reset event that remains signaled when command buffer is not empty.
-
-#if GN_COMMAND_BUFFER_BUILT_IN_FENCE
-        // Fence
-        FenceInternal *  m_Fences;
-        FenceInternal *  m_NextFreeFence;
-#endif
+        uint8 *                m_Buffer;
+        uint32                 m_Size;             // ring buffer size, power of 2.
+        uint32                 m_Mask;             // m_Size - 1
+        std::atomic<uint32>    m_ReadenCursor;     // Cursor of the next byte that will be used for consumption. Written by consumer only.
+        std::atomic<uint32>    m_WrittenCursor;    // Cursor of the next byte that will be used for production. Written by producer only.
+        TokenInternal *        m_ReadingToken;     // Pointer to the current consuming token. Should be NULL outside of beginConsume() and endConsume().
+        TokenInternal *        m_WritingToken;     // Pointer to the current producing token. Should be NULL outside of beginProdue() and endProduce().
+        std::atomic<uint32>    m_ReadWaiters;      // number of threads waiting on m_ReadenCursor (producers and fence waiters)
+        std::atomic<uint32>    m_WriteWaiters;     // number of threads waiting on m_WrittenCursor (consumer)
+        std::atomic<bool>      m_Cancelled;
 
         Mutex m_ProducerLock; // To serialize multiple producers.
         Mutex m_ConsumerLock; // To serialize multiple consumers.
-        Mutex m_DataLock;     // To protect internal shared data.
 
         // ********************************
         // private functions
         // ********************************
     private:
 
-        // Internal version of produce function that support producing token command
-        OperationResult beginProduceInternal( uint16 command, uint16 parameterSize, Token * token = NULL, SyncEvent * optionalCompletionEvent = NULL );
+        // wait until there are at least 'bytes' free bytes in the ring.
+        bool waitForSpace( uint32 bytes );
+
+        // publish new written cursor, and wake up consumer.
+        void publishWrittenCursor( uint32 wc );
+
+        // publish new readen cursor, and wake up producers and fence waiters.
+        void publishReadenCursor( uint32 rc );
     };
 }
 
@@ -50,7 +50,7 @@ GN_API Gpu * GN::gfx::createGpu( const GpuOptions & inputOptions, uint32 creatio
     {
         case GpuAPI::OGL   : return createOGLGpu( ro, creationFlags );
         case GpuAPI::D3D11 : return createD3DGpu( ro, creationFlags );
-        case GpuAPI::FAKE  : GN_UNIMPL(); return 0;
+        case GpuAPI::FAKE  : return createFakeGpu( ro, creationFlags );
         default : GN_ERROR(sLogger)( "Invalid API(%d)", ro.api.toRawEnum() ); return 0;
     }
 }
\ No newline at end of file
@@ -0,0 +1,547 @@
+#include "pch.h"
+#include "mtgpu.h"
+#include <garnet/GNwin.h>
+
+using namespace GN;
+using namespace GN::gfx;
+
+static GN::Logger * sLogger = GN::getLogger("GN.gfx.gpu.fake");
+
+// *****************************************************************************
+// Fake GPU resources
+// *****************************************************************************
+
+///
+/// Fake GPU does not create any native window. This one just reports back
+/// buffer size as its client size.
+///
+class FakeRenderWindow : public GN::win::Window
+{
+    Vector2<uint32_t> mSize;
+
+public:
+
+    FakeRenderWindow() : mSize( 640, 480 ) {}
+
+    void setSize( uint32 w, uint32 h ) { mSize.set( w, h ); }
+
+    //@{
+    intptr_t getDisplayHandle() const { return (intptr_t)1; }
+    intptr_t getMonitorHandle() const { return (intptr_t)1; }
+    intptr_t getWindowHandle() const { return (intptr_t)1; }
+    intptr_t getModuleHandle() const { return (intptr_t)1; }
+    Vector2<uint32_t> getClientSize() const { return mSize; }
+    void show() {}
+    void hide() {}
+    void minimize() {}
+    void moveTo( int, int ) {}
+    void setClientSize( size_t, size_t ) {}
+    bool runUntilNoNewEvents(bool) { return false; }
+    //@}
+};
+
+///
+/// Fake GPU program has no parameter at all.
+///
+class FakeGpuProgram : public GpuProgram
+{
+    class EmptyParameterDesc : public GpuProgramParameterDesc
+    {
+    public:
+        EmptyParameterDesc()
+        {
+            mUniformArray = NULL;
+            mUniformArrayStride = 0;
+            mTextureArray = NULL;
+            mTextureArrayStride = 0;
+            mAttributeArray = NULL;
+            mAttributeArrayStride = 0;
+        }
+    };
+
+    EmptyParameterDesc mParam;
+
+public:
+
+    virtual const GpuProgramParameterDesc & getParameterDesc() const { return mParam; }
+};
+
+///
+/// Uniform that lives in system memory.
+///
+class FakeUniform : public Uniform
+{
+    DynaArray<uint8> mData;
+
+public:
+
+    explicit FakeUniform( uint32 size ) : mData( size ) { memset( mData.rawptr(), 0, size ); }
+
+    virtual uint32       size() const { return (uint32)mData.size(); }
+    virtual const void * getval() const { return mData.rawptr(); }
+    virtual void         update( uint32 offset, uint32 length, const void * data )
+    {
+        if( offset >= mData.size() || 0 == length || NULL == data ) return;
+        if( offset + length > mData.size() ) length = (uint32)mData.size() - offset;
+        memcpy( mData.rawptr() + offset, data, length );
+    }
+};
+
+///
+/// Texture that lives in system memory. Each subresource is stored tightly
+/// packed, one block row after another.
+///
+class FakeTexture : public Texture
+{
+    DynaArray< DynaArray<uint8> > mSubresources; ///< indexed by face * levels + level
+
+    struct BlockLayout
+    {
+        uint32 blockWidth, blockHeight, blockBytes;
+        uint32 blocksX, blocksY;
+        uint32 rowPitch, slicePitch;
+    };
+
+    void getBlockLayout( uint32 level, BlockLayout & bl ) const
+    {
+        const ColorLayoutDesc & ld = getDesc().format.layoutDesc();
+        const Vector3<uint32> & sz = getMipSize( level );
+        bl.blockWidth  = ld.blockWidth ? ld.blockWidth : 1;
+        bl.blockHeight = ld.blockHeight ? ld.blockHeight : 1;
+        bl.blockBytes  = ld.blockBytes;
+        bl.blocksX     = ( sz.x + bl.blockWidth - 1 ) / bl.blockWidth;
+        bl.blocksY     = ( sz.y + bl.blockHeight - 1 ) / bl.blockHeight;
+        bl.rowPitch    = bl.blocksX * bl.blockBytes;
+        bl.slicePitch  = bl.rowPitch * bl.blocksY;
+    }
+
+public:
+
+    bool init( const TextureDesc & desc )
+    {
+        if( !setDesc( desc ) ) return false;
+
+        const TextureDesc & d = getDesc();
+        mSubresources.resize( d.faces * d.levels );
+        for( uint32 level = 0; level < d.levels; ++level )
+        {
+            setMipSize(
+                level,
+                math::getmax( d.width >> level, 1u ),
+                math::getmax( d.height >> level, 1u ),
+                math::getmax( d.depth >> level, 1u ) );
+
+            BlockLayout bl;
+            getBlockLayout( level, bl );
+            size_t bytes = (size_t)bl.slicePitch * getMipSize( level ).z;
+            for( uint32 face = 0; face < d.faces; ++face )
+            {
+                DynaArray<uint8> & s = mSubresources[face * d.levels + level];
+                s.resize( bytes );
+                memset( s.rawptr(), 0, bytes );
+            }
+        }
+
+        return true;
+    }
+
+    virtual void updateMipmap(
+        uint32              face,
+        uint32              level,
+        const Box<uint32> * area,
+        uint32              rowPitch,
+        uint32              slicePitch,
+        const void        * data,
+        SurfaceUpdateFlag )
+    {
+        const TextureDesc & d = getDesc();
+        if( face >= d.faces || level >= d.levels )
+        {
+            GN_ERROR(sLogger)( "Invalid subresource: face=%u, level=%u", face, level );
+            return;
+        }
+        if( NULL == data ) return;
+
+        const Vector3<uint32> & sz = getMipSize( level );
+        Box<uint32> box( 0, 0, 0, sz.x, sz.y, sz.z );
+        if( area ) box = *area;
+        if( box.x + box.w > sz.x || box.y + box.h > sz.y || box.z + box.d > sz.z )
+        {
+            GN_ERROR(sLogger)( "Update area is out of mipmap range." );
+            return;
+        }
+
+        BlockLayout bl;
+        getBlockLayout( level, bl );
+
+        // source pitches are measured per block row, which is the same as per
+        // texel row for uncompressed formats.
+        uint32 bx    = box.x / bl.blockWidth;
+        uint32 by    = box.y / bl.blockHeight;
+        uint32 bw    = ( box.w + bl.blockWidth - 1 ) / bl.blockWidth;
+        uint32 bh    = ( box.h + bl.blockHeight - 1 ) / bl.blockHeight;
+        uint32 bytes = bw * bl.blockBytes;
+        if( 0 == rowPitch ) rowPitch = bytes;
+        if( 0 == slicePitch ) slicePitch = rowPitch * bh;
+
+        uint8       * dst = mSubresources[face * d.levels + level].rawptr();
+        const uint8 * src = (const uint8*)data;
+        for( uint32 z = 0; z < box.d; ++z )
+        {
+            for( uint32 y = 0; y < bh; ++y )
+            {
+                memcpy(
+                    dst + ( box.z + z ) * bl.slicePitch + ( by + y ) * bl.rowPitch + bx * bl.blockBytes,
+                    src + z * slicePitch + y * rowPitch,
+                    bytes );
+            }
+        }
+    }
+
+    virtual void readMipmap( uint32 face, uint32 level, MipmapData & data )
+    {
+        const TextureDesc & d = getDesc();
+        if( face >= d.faces || level >= d.levels )
+        {
+            GN_ERROR(sLogger)( "Invalid subresource: face=%u, level=%u", face, level );
+            return;
+        }
+
+        BlockLayout bl;
+        getBlockLayout( level, bl );
+        data.rowPitch = bl.rowPitch;
+        data.slicePitch = bl.slicePitch;
+        data.data = mSubresources[face * d.levels + level];
+    }
+
+    virtual void generateMipmapPyramid()
+    {
+        // Content of lower levels is not filtered. Fake GPU only keeps data
+        // that was explicitly written.
+    }
+
+    virtual void * getAPIDependentData() const { return (void*)this; }
+};
+
+///
+/// Vertex buffer that lives in system memory.
+///
+class FakeVtxBuf : public VtxBuf
+{
+    DynaArray<uint8> mData;
+
+public:
+
+    void init( const VtxBufDesc & desc )
+    {
+        setDesc( desc );
+        mData.resize( desc.length );
+        memset( mData.rawptr(), 0, desc.length );
+    }
+
+    virtual void update( uint32 offset, uint32 length, const void * data, SurfaceUpdateFlag )
+    {
+        if( 0 == length ) length = (uint32)mData.size() - offset;
+        if( NULL == data || offset + length > mData.size() )
+        {
+            GN_ERROR(sLogger)( "Invalid vertex buffer update range." );
+            return;
+        }
+        memcpy( mData.rawptr() + offset, data, length );
+    }
+
+    virtual void readback( DynaArray<uint8> & data ) { data = mData; }
+};
+
+///
+/// Index buffer that lives in system memory.
+///
+class FakeIdxBuf : public IdxBuf
+{
+    DynaArray<uint8> mData;
+    uint32           mStride;
+
+public:
+
+    void init( const IdxBufDesc & desc )
+    {
+        setDesc( desc );
+        mStride = desc.bits32 ? 4 : 2;
+        mData.resize( desc.numidx * mStride );
+        memset( mData.rawptr(), 0, mData.size() );
+    }
+
+    virtual void update( uint32 startidx, uint32 numidx, const void * data, SurfaceUpdateFlag )
+    {
+        uint32 total = (uint32)mData.size() / mStride;
+        if( 0 == numidx ) numidx = total - startidx;
+        if( NULL == data || startidx + numidx > total )
+        {
+            GN_ERROR(sLogger)( "Invalid index buffer update range." );
+            return;
+        }
+        memcpy( mData.rawptr() + startidx * mStride, data, numidx * mStride );
+    }
+
+    virtual void readback( DynaArray<uint8> & data ) { data = mData; }
+};
+
+// *****************************************************************************
+// Fake GPU
+// *****************************************************************************
+
+///
+/// GPU that does no rendering at all. Resources live in system memory, so
+/// their content can be read back; clearScreen() fills the back buffer, draw
+/// calls are counted and dropped. Useful for headless tests and to measure
+/// front end overhead.
+///
+class FakeGpu : public Gpu, public StdClass
+{
+    GN_DECLARE_STDCLASS( FakeGpu, StdClass );
+
+    // ********************************
+    // ctor/dtor
+    // ********************************
+
+    //@{
+public:
+    FakeGpu()          { clear(); }
+    virtual ~FakeGpu() { quit(); }
+    //@}
+
+    // ********************************
+    // from StdClass
+    // ********************************
+
+    //@{
+public:
+    bool init( const GpuOptions & o )
+    {
+        GN_GUARD;
+
+        // standard init procedure
+        GN_STDCLASS_INIT();
+
+        mOptions = o;
+
+        mDispDesc.displayHandle = mWindow.getDisplayHandle();
+        mDispDesc.monitorHandle = mWindow.getMonitorHandle();
+        mDispDesc.windowHandle  = mWindow.getWindowHandle();
+        mDispDesc.width         = o.displayMode.width ? o.displayMode.width : 640;
+        mDispDesc.height        = o.displayMode.height ? o.displayMode.height : 480;
+        mDispDesc.depth         = 32;
+        mDispDesc.refrate       = 60;
+        mWindow.setSize( mDispDesc.width, mDispDesc.height );
+
+        mCaps.maxTex1DSize[0] = 16384;
+        mCaps.maxTex1DSize[1] = 2048;
+        mCaps.maxTex2DSize[0] = 16384;
+        mCaps.maxTex2DSize[1] = 16384;
+        mCaps.maxTex2DSize[2] = 2048;
+        mCaps.maxTex3DSize[0] = 2048;
+        mCaps.maxTex3DSize[1] = 2048;
+        mCaps.maxTex3DSize[2] = 2048;
+        mCaps.maxTex3DSize[3] = 1;
+        mCaps.maxTextures = GpuContext::MAX_TEXTURES;
+        mCaps.maxColorRenderTargets = GpuContext::MAX_COLOR_RENDER_TARGETS;
+        mCaps.shaderModels = 0;
+
+        mBackBuffer.resize( mDispDesc.width * mDispDesc.height * 4 );
+        memset( mBackBuffer.rawptr(), 0, mBackBuffer.size() );
+
+        // success
+        return success();
+
+        GN_UNGUARD;
+    }
+
+    void quit()
+    {
+        GN_GUARD;
+
+        mContext.clear();
+        mUserData.clear();
+        mBackBuffer.clear();
+
+        // standard quit procedure
+        GN_STDCLASS_QUIT();
+
+        GN_UNGUARD;
+    }
+
+private:
+    void clear()
+    {
+        mNumFrames = 0;
+        mNumDraws = 0;
+    }
+    //@}
+
+    // ********************************
+    // from Gpu
+    // ********************************
+public:
+
+    //@{
+
+    virtual const GpuOptions & getOptions() const { return mOptions; }
+    virtual const DispDesc & getDispDesc() const { return mDispDesc; }
+    virtual GN::win::Window & getRenderWindow() const { return const_cast<FakeRenderWindow&>( mWindow ); }
+    virtual void * getD3DDevice() const { return NULL; }
+    virtual void * getOGLRC() const { return NULL; }
+
+    virtual const GpuCaps & caps() const { return mCaps; }
+    virtual bool checkTextureFormatSupport( ColorFormat format, TextureUsage ) const { return format.valid(); }
+
+    virtual GpuProgram * createGpuProgram( const GpuProgramDesc & ) { return referenceTo( new FakeGpuProgram ).detach(); }
+    virtual Uniform * createUniform( uint32 size ) { return referenceTo( new FakeUniform( size ) ).detach(); }
+    virtual Texture * createTexture( const TextureDesc & desc )
+    {
+        AutoRef<FakeTexture> tex = referenceTo( new FakeTexture );
+        if( !tex->init( desc ) ) return NULL;
+        return tex.detach();
+    }
+    virtual VtxBuf * createVtxBuf( const VtxBufDesc & desc )
+    {
+        AutoRef<FakeVtxBuf> vb = referenceTo( new FakeVtxBuf );
+        vb->init( desc );
+        return vb.detach();
+    }
+    virtual IdxBuf * createIdxBuf( const IdxBufDesc & desc )
+    {
+        AutoRef<FakeIdxBuf> ib = referenceTo( new FakeIdxBuf );
+        ib->init( desc );
+        return ib.detach();
+    }
+
+    virtual void bindContext( const GpuContext & c ) { mContext = c; }
+    virtual void rebindContext() {}
+    virtual const GpuContext & getContext() const { return mContext; }
+
+    virtual void present() { ++mNumFrames; }
+
+    virtual void clearScreen( const Vector4f & c, float, uint8, uint32 flags )
+    {
+        if( 0 == ( flags & CLEAR_C ) ) return;
+        uint8 rgba[4];
+        for( int i = 0; i < 4; ++i ) rgba[i] = (uint8)( math::clamp( c[i], 0.0f, 1.0f ) * 255.0f + 0.5f );
+        uint8 * p = mBackBuffer.rawptr();
+        for( size_t i = 0; i < mBackBuffer.size(); i += 4 ) memcpy( p + i, rgba, 4 );
+    }
+
+    virtual void drawIndexed( PrimitiveType, uint32, uint32, uint32, uint32, uint32 ) { ++mNumDraws; }
+    virtual void draw( PrimitiveType, uint32, uint32 ) { ++mNumDraws; }
+    virtual void drawIndexedUp( PrimitiveType, uint32, uint32, const void *, uint32, const uint16 * ) { ++mNumDraws; }
+    virtual void drawUp( PrimitiveType, uint32, const void *, uint32 ) { ++mNumDraws; }
+
+    virtual GpuSignals & getSignals() { return mSignals; }
+
+    virtual void getBackBufferContent( BackBufferContent & c )
+    {
+        c.data = mBackBuffer;
+        c.format = ColorFormat::RGBA_8_8_8_8_UNORM;
+        c.width = mDispDesc.width;
+        c.height = mDispDesc.height;
+        c.pitch = mDispDesc.width * 4;
+    }
+
+    virtual void setUserData( const Guid & id, const void * data, uint32 length )
+    {
+        DynaArray<uint8> * currentUserData = mUserData.find( id );
+
+        if( NULL == data && 0 == length )
+        {
+            // delete existing data
+            if( currentUserData ) mUserData.remove( id );
+            else GN_ERROR(sLogger)( "Invalid user data GUID." );
+        }
+        else
+        {
+            DynaArray<uint8> & ud = currentUserData ? *currentUserData : mUserData[id];
+            if( NULL != data && length > 0 )
+            {
+                ud.resize( length );
+                memcpy( ud.rawptr(), data, length );
+            }
+            else
+            {
+                ud.clear();
+            }
+        }
+    }
+
+    virtual const void * getUserData( const Guid & id, uint32 * length ) const
+    {
+        const DynaArray<uint8> * currentUserData = mUserData.find( id );
+        if( NULL == currentUserData )
+        {
+            GN_ERROR(sLogger)( "Invalid user data GUID." );
+            if( length ) *length = 0;
+            return NULL;
+        }
+        if( length ) *length = (uint32)currentUserData->size();
+        return currentUserData->rawptr();
+    }
+
+    virtual bool hasUserData( const Guid & id ) const { return NULL != mUserData.find( id ); }
+
+    virtual void debugEnableParameterCheck( bool ) {}
+    virtual void debugDumpNextFrame( uint32, uint32 ) {}
+    virtual void debugMarkBegin( const char * ) {}
+    virtual void debugMarkEnd() {}
+    virtual void debugMarkSet( const char * ) {}
+
+    //@}
+
+    // ********************************
+    // private variables
+    // ********************************
+private:
+
+    GpuOptions                             mOptions;
+    DispDesc                               mDispDesc;
+    FakeRenderWindow                       mWindow;
+    GpuCaps                                mCaps;
+    GpuContext                             mContext;
+    GpuSignals                             mSignals;
+    DynaArray<uint8>                       mBackBuffer;
+    Dictionary<Guid, DynaArray<uint8> >    mUserData;
+    uint64                                 mNumFrames;
+    uint64                                 mNumDraws;
+};
+
+// *****************************************************************************
+// GPU creator
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static Gpu * sCreateFakeGpuPrivate( const GpuOptions & o, void * )
+{
+    GN_GUARD;
+
+    GN::AutoObjPtr<FakeGpu> p( new FakeGpu );
+    if( !p->init( o ) ) return 0;
+    return p.detach();
+
+    GN_UNGUARD;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN_API Gpu * GN::gfx::createFakeGpu( const GpuOptions & o, uint32 creationFlags )
+{
+    GpuOptions lo = o;
+    lo.api = GpuAPI::FAKE;
+    if( 0 != (creationFlags & GPU_CREATION_MULTIPLE_THREADS) )
+    {
+        return createMultiThreadGpu( lo, sCreateFakeGpuPrivate, 0 );
+    }
+    else
+    {
+        return sCreateFakeGpuPrivate( lo, 0 );
+    }
+}
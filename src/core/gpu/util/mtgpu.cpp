@@ -15,25 +15,6 @@ using namespace GN::gfx;
 // Local types and data
 // *****************************************************************************
 
-struct CommandHeader
-{
-    uint16 cid;    ///< command ID ( 2 bytes )
-    uint16 size;   ///< command parameter size. command header is not included.
-    uint32 fence;  ///< command fence
-};
-
-struct DrawLineParams
-{
-    uint32 options;
-    void    * positions;
-    uint32    stride;
-    uint32    numpoints;
-    uint32    rgba;
-    Matrix44f model;
-    Matrix44f view;
-    Matrix44f proj;
-};
-
 template<typename T>
 static inline void sReplaceAutoRefPtr( AutoRef<T> & ref, T * newptr )
 {
@@ -70,27 +51,24 @@ bool GN::gfx::MultiThreadGpu::init(
     // initialize ring buffer
     if( !mCommandBuffer.init( mo.commandBufferSize ) ) return failure();
 
-    // initialize sync objects
-    mGpuCreationStatus = 2; // 2 is "not done yet";
-    if( !mWaitForIdleFence.create( SyncEvent::UNSIGNALED, SyncEvent::AUTO_RESET ) ||
-        !mPresentFence.create( SyncEvent::SIGNALED, SyncEvent::AUTO_RESET ) )
-    {
-        return failure();
-    }
-
-    // create thread
-    Thread::Procedure proc = makeDelegate( this, &GN::gfx::MultiThreadGpu::threadProc );
-    mThread = Thread::sCreate( proc, (void*)&ro );
-    if( 0 == mThread ) return failure();
+    // one fence slot per frame in flight. Initial fences are passed already.
+    mFrameFences.resize( ro.maxFramesInFlight );
+    for( uint32 i = 0; i < mFrameFences.size(); ++i ) mFrameFences[i] = mCommandBuffer.insertFence();
+    mFrameIndex = 0;
 
-    // wait for the GPU creation
-    while( 2 == mGpuCreationStatus ) Thread::sSleepCurrentThread(0);
-    if( 1 != mGpuCreationStatus ) return failure();
+    // create GPU thread, and wait for the GPU creation
+    mGpuCreated = false;
+    if( !mGpuCreationDone.create( SyncEvent::UNSIGNALED, SyncEvent::MANUAL_RESET ) ) return failure();
+    GpuOptions threadOptions = ro;
+    mThread = std::thread( [this, threadOptions]{ threadProc( threadOptions ); } );
+    mGpuCreationDone.wait();
+    if( !mGpuCreated ) return failure();
 
     // initialize front end variables
     mMultithreadOptions = mo;
     mCommandBuffer.postCommand1( CMD_GET_GPU_OPTIONS, &mGpuOptions );
     mCommandBuffer.postCommand1( CMD_GET_DISP_DESC, &mDispDesc );
+    mCommandBuffer.postCommand1( CMD_GET_RENDER_WINDOW, &mRenderWindow );
     mCommandBuffer.postCommand1( CMD_GET_D3D_DEVICE, &mD3DDevice );
     mCommandBuffer.postCommand1( CMD_GET_OGL_RC, &mOGLRC );
     mCommandBuffer.postCommand1( CMD_GET_CAPS, &mCaps );
@@ -113,14 +91,16 @@ void GN::gfx::MultiThreadGpu::quit()
     // clear context
     mGpuContext.clear();
 
-    if( mThread )
+    if( mThread.joinable() )
     {
-        mCommandBuffer.postCommand0( CMD_SHUTDOWN );
-        Thread::sJoin( mThread );
-        mThread = 0;
+        // GPU thread exits by itself, if GPU creation failed.
+        if( mGpuCreated ) mCommandBuffer.postCommand0( CMD_SHUTDOWN );
+        mThread.join();
     }
 
     mCommandBuffer.quit();
+    mGpuCreationDone.destroy();
+    mFrameFences.clear();
 
     // standard quit procedure
     GN_STDCLASS_QUIT();
@@ -137,8 +117,7 @@ void GN::gfx::MultiThreadGpu::quit()
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadGpu::waitForIdle()
 {
-    mCommandBuffer.postCommand0( CMD_FENCE, &mWaitForIdleFence );
-    mWaitForIdleFence.wait();
+    mCommandBuffer.waitForFence( mCommandBuffer.insertFence() );
 }
 
 // *****************************************************************************
@@ -148,18 +127,13 @@ void GN::gfx::MultiThreadGpu::waitForIdle()
 //
 //
 // -----------------------------------------------------------------------------
-void GN::gfx::MultiThreadGpu::threadProc( void * param )
+void GN::gfx::MultiThreadGpu::threadProc( const GpuOptions & ro )
 {
     // create the GPU instance
-    GN_ASSERT( 2 == mGpuCreationStatus );
-    const GpuOptions * ro = (const GpuOptions*)param;
-    mGpu = mCreator( *ro, mCreationContext );
-    if( NULL == mGpu )
-    {
-        mGpuCreationStatus = 0;
-        return;
-    }
-    mGpuCreationStatus = 1;
+    mGpu = mCreator( ro, mCreationContext );
+    mGpuCreated = NULL != mGpu;
+    mGpuCreationDone.signal();
+    if( NULL == mGpu ) return;
 
     // command loop
     for(;;)
@@ -205,7 +179,7 @@ bool GN::gfx::MultiThreadGpu::checkTextureFormatSupport( ColorFormat format, Tex
 GpuProgram * GN::gfx::MultiThreadGpu::createGpuProgram( const GpuProgramDesc & desc )
 {
     GpuProgram * gp = NULL;
-    mCommandBuffer.postCommand3( CMD_CREATE_GPU_PROGRAM, &gp, &desc );
+    mCommandBuffer.postCommand2( CMD_CREATE_GPU_PROGRAM, &gp, &desc );
     waitForIdle();
     if( NULL == gp ) return NULL;
 
@@ -347,7 +321,7 @@ void GN::gfx::MultiThreadGpu::bindContext( const GpuContext & inputrc )
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadGpu::rebindContext()
 {
-    mCommandBuffer.postCommand0( CMD_BIND_CONTEXT );
+    mCommandBuffer.postCommand0( CMD_REBIND_CONTEXT );
 }
 
 //
@@ -364,20 +338,18 @@ const GpuContext & GN::gfx::MultiThreadGpu::getContext() const
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadGpu::present()
 {
-    SyncEvent * fence;
-    if( mMultithreadOptions.cacheOneFrameAtMost )
-    {
-        // wait for the previous present to complete, to ensure that
-        // we cache only one full frame in the command buffer.
-        mPresentFence.wait();
-        fence = &mPresentFence;
-    }
-    else
+    mCommandBuffer.postCommand0( CMD_PRESENT );
+
+    if( !mFrameFences.empty() )
     {
-        fence = NULL;
+        // Wait for the present that is maxFramesInFlight frames older, to
+        // limit number of frames queued in the command buffer. Then reuse
+        // its slot for this frame.
+        CommandBuffer::Fence & oldest = mFrameFences[mFrameIndex];
+        mCommandBuffer.waitForFence( oldest );
+        oldest = mCommandBuffer.insertFence();
+        mFrameIndex = ( mFrameIndex + 1 ) % mFrameFences.size();
     }
-
-    mCommandBuffer.postCommand0( CMD_PRESENT, fence );
 }
 
 //
@@ -471,48 +443,6 @@ void GN::gfx::MultiThreadGpu::drawUp(
     mCommandBuffer.postCommand4( CMD_DRAW_UP, prim, numvtx, vb, strideInBytes );
 }
 
-//
-//
-// -----------------------------------------------------------------------------
-void
-GN::gfx::MultiThreadGpu::drawLines(
-    uint32         options,
-    const void *      positions,
-    uint32            stride,
-    uint32            numpoints,
-    uint32            rgba,
-    const Matrix44f & model,
-    const Matrix44f & view,
-    const Matrix44f & proj )
-{
-    uint32 length = stride * numpoints;
-
-    void * tmpbuf = HeapMemory::alloc( length );
-    if( NULL == tmpbuf )
-    {
-        GN_ERROR(sLogger)( "fail to allocate temporary buffer." );
-        return;
-    }
-    memcpy( tmpbuf, positions, length );
-
-    CommandBuffer::Token token;
-    if( CommandBuffer::OPERATION_SUCCEEDED == mCommandBuffer.beginProduce( CMD_DRAW_LINES, sizeof(DrawLineParams), &token ) )
-    {
-        DrawLineParams * dlp = (DrawLineParams*)token.pParameterBuffer;
-
-        dlp->options   = options;
-        dlp->positions = tmpbuf;
-        dlp->stride    = stride;
-        dlp->numpoints = numpoints;
-        dlp->rgba      = rgba;
-        dlp->model     = model;
-        dlp->view      = view;
-        dlp->proj      = proj;
-
-        mCommandBuffer.endProduce();
-    }
-}
-
 //
 //
 // -----------------------------------------------------------------------------
@@ -522,19 +452,14 @@ void GN::gfx::MultiThreadGpu::getBackBufferContent( BackBufferContent & result )
     waitForIdle();
 }
 
-//
-//
-// -----------------------------------------------------------------------------
-void GN::gfx::MultiThreadGpu::processRenderWindowMessages( bool blockWhileMinimized )
-{
-    mCommandBuffer.postCommand1( CMD_PROCESS_RENDER_WINDOW_MESSAGES, blockWhileMinimized );
-}
-
 //
 //
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadGpu::setUserData( const Guid & id, const void * data, uint32 length )
 {
+    // user data is not touched by GPU commands, so it is safe to access it
+    // directly, once GPU thread is idle.
+    waitForIdle();
     mGpu->setUserData( id, data, length );
 }
 
@@ -543,6 +468,7 @@ void GN::gfx::MultiThreadGpu::setUserData( const Guid & id, const void * data, u
 // -----------------------------------------------------------------------------
 const void * GN::gfx::MultiThreadGpu::getUserData( const Guid & id, uint32 * length ) const
 {
+    const_cast<MultiThreadGpu*>(this)->waitForIdle();
     return mGpu->getUserData( id, length );
 }
 
@@ -551,6 +477,7 @@ const void * GN::gfx::MultiThreadGpu::getUserData( const Guid & id, uint32 * len
 // -----------------------------------------------------------------------------
 bool GN::gfx::MultiThreadGpu::hasUserData( const Guid & id ) const
 {
+    const_cast<MultiThreadGpu*>(this)->waitForIdle();
     return mGpu->hasUserData( id );
 }
 
@@ -633,27 +560,28 @@ namespace GN { namespace gfx
     //
     //
     // -------------------------------------------------------------------------
-    void func_FENCE( Gpu &, void *, uint32 )
+    void func_GET_GPU_OPTIONS( Gpu & r, void * p, uint32 )
     {
-        // do nothing
+        GpuOptions ** ro = (GpuOptions **)p;
+        **ro = r.getOptions();
     }
 
     //
     //
     // -------------------------------------------------------------------------
-    void func_GET_GPU_OPTIONS( Gpu & r, void * p, uint32 )
+    void func_GET_DISP_DESC( Gpu & r, void * p, uint32 )
     {
-        GpuOptions ** ro = (GpuOptions **)p;
-        memcpy( *ro, &r.getOptions(), sizeof(**ro) );
+        DispDesc ** dd = (DispDesc**)p;
+        **dd = r.getDispDesc();
     }
 
     //
     //
     // -------------------------------------------------------------------------
-    void func_GET_DISP_DESC( Gpu & r, void * p, uint32 )
+    void func_GET_RENDER_WINDOW( Gpu & r, void * p, uint32 )
     {
-        DispDesc ** dd = (DispDesc**)p;
-        memcpy( *dd, &r.getDispDesc(), sizeof(**dd) );
+        GN::win::Window *** w = (GN::win::Window***)p;
+        **w = &r.getRenderWindow();
     }
 
     //
@@ -680,7 +608,7 @@ namespace GN { namespace gfx
     void func_GET_CAPS( Gpu & r, void * p, uint32 )
     {
         GpuCaps ** caps = (GpuCaps**)p;
-        memcpy( *caps, &r.caps(), sizeof(**caps) );
+        **caps = r.caps();
     }
 
     //
@@ -924,26 +852,6 @@ namespace GN { namespace gfx
         HeapMemory::dealloc( dup->vertexData );
     }
 
-    //
-    //
-    // -------------------------------------------------------------------------
-    void func_DRAW_LINES( Gpu & r, void * p, uint32 )
-    {
-        DrawLineParams * dlp = (DrawLineParams*)p;
-
-        r.drawLines(
-            dlp->options,
-            dlp->positions,
-            dlp->stride,
-            dlp->numpoints,
-            dlp->rgba,
-            dlp->model,
-            dlp->view,
-            dlp->proj );
-
-        HeapMemory::dealloc( dlp->positions );
-    }
-
     //
     //
     // -------------------------------------------------------------------------
@@ -968,15 +876,6 @@ namespace GN { namespace gfx
         r.getBackBufferContent( **param );
     }
 
-    //
-    //
-    // -------------------------------------------------------------------------
-    void func_PROCESS_RENDER_WINDOW_MESSAGES( Gpu & r, void * p, uint32 )
-    {
-        bool * blockWhileMinimized = (bool*)p;
-        r.processRenderWindowMessages( *blockWhileMinimized );
-    }
-
     //
     //
     // -------------------------------------------------------------------------
@@ -6,9 +6,6 @@
 /// \author  chenli@@REDMOND (2009.1.2)
 // *****************************************************************************
 
-#if 0 // disabled for now
-
-#include "../../gpu/gpupch.h"
 #include "cmdbuf.h"
 
 namespace GN { namespace gfx
@@ -22,15 +19,9 @@ namespace GN { namespace gfx
         ///
         size_t commandBufferSize;
 
-        ///
-        /// Set it to true to limit number of commands cached in command buffer to at most one frame. Default is true.
-        ///
-        bool cacheOneFrameAtMost;
-
         /// ctor
         MultiThreadGpuOptions()
             : commandBufferSize( 4 * 1024 * 1024 )
-            , cacheOneFrameAtMost( true )
         {
         }
     };
@@ -41,7 +32,11 @@ namespace GN { namespace gfx
     typedef GN::gfx::Gpu * (*CreateSingleThreadFunc)( const GN::gfx::GpuOptions & options, void * context );
 
     ///
-    /// Multi thread GPU wrapper
+    /// Multi thread GPU wrapper. The real GPU lives in a dedicated thread, and
+    /// consumes commands posted by the front end thread.
+    ///
+    /// All methods must be called from one front end thread. Number of frames
+    /// queued in the command buffer is limited by GpuOptions::maxFramesInFlight.
     ///
     class MultiThreadGpu : public Gpu, public StdClass
     {
@@ -68,9 +63,11 @@ namespace GN { namespace gfx
     private:
         void clear()
         {
-            mThread = 0;
             mCreator = NULL;
             mGpu = NULL;
+            mRenderWindow = NULL;
+            mSignals = NULL;
+            mFrameIndex = 0;
         }
         //@}
 
@@ -82,8 +79,13 @@ namespace GN { namespace gfx
         //@{
 
         CommandBuffer & cmdbuf() { return mCommandBuffer; }
+
+        /// Wait until all posted commands are executed by the GPU thread.
         void waitForIdle();
 
+        /// Get the single thread GPU that runs in GPU thread.
+        Gpu & getRealGpu() const { GN_ASSERT( mGpu ); return *mGpu; }
+
         //@}
 
         // ********************************
@@ -91,11 +93,12 @@ namespace GN { namespace gfx
         // ********************************
     private:
 
-        CommandBuffer      mCommandBuffer;
-        volatile uint32    mGpuCreationStatus; ///< 0: creation failed, 1: creation succeeded, 2: creation is not finished yet.
-        SyncEvent          mWaitForIdleFence;
-        SyncEvent          mPresentFence;
-        Thread::Identifier mThread;
+        CommandBuffer                     mCommandBuffer;
+        std::thread                       mThread;
+        bool                              mGpuCreated;
+        SyncEvent                         mGpuCreationDone;
+        DynaArray<CommandBuffer::Fence>   mFrameFences; ///< fences of recent presents, one slot per frame in flight.
+        uint32                            mFrameIndex;
 
         // ********************************
         // front end variables
@@ -105,6 +108,7 @@ namespace GN { namespace gfx
         MultiThreadGpuOptions mMultithreadOptions;
         GpuOptions            mGpuOptions;
         DispDesc              mDispDesc;
+        GN::win::Window     * mRenderWindow;
         void *                mD3DDevice;
         void *                mOGLRC;
         GpuCaps               mCaps;
@@ -126,7 +130,7 @@ namespace GN { namespace gfx
         // ********************************
     private:
 
-        void threadProc( void * );
+        void threadProc( const GpuOptions & );
 
         // ********************************
         // rendering methods from Gpu
@@ -137,14 +141,14 @@ namespace GN { namespace gfx
 
         virtual const GpuOptions & getOptions() const { return mGpuOptions; }
         virtual const DispDesc & getDispDesc() const { return mDispDesc; }
+        virtual GN::win::Window & getRenderWindow() const { GN_ASSERT( mRenderWindow ); return *mRenderWindow; }
         virtual void * getD3DDevice() const { return mD3DDevice; }
         virtual void * getOGLRC() const { return mOGLRC; }
 
         virtual const GpuCaps & caps() const { return mCaps; }
         virtual bool checkTextureFormatSupport( ColorFormat format, TextureUsage usages ) const;
 
-        virtual Blob * compileGpuProgram( const GpuProgramDesc & desc );
-        virtual GpuProgram * createGpuProgram( const void * compiledGpuProgramBinary, uint32 length );
+        virtual GpuProgram * createGpuProgram( const GpuProgramDesc & desc );
         virtual Uniform * createUniform( uint32 size );
         virtual Texture * createTexture( const TextureDesc & desc );
         virtual VtxBuf * createVtxBuf( const VtxBufDesc & );
@@ -160,37 +164,28 @@ namespace GN { namespace gfx
                                   uint8            s,
                                   uint32        flags );
         virtual void drawIndexed( PrimitiveType prim,
-                                  uint32        numprim,
+                                  uint32        numidx,
                                   uint32        basevtx,
                                   uint32        startvtx,
                                   uint32        numvtx,
                                   uint32        startidx );
         virtual void draw( PrimitiveType prim,
-                           uint32        numprim,
+                           uint32        numvtx,
                            uint32        startvtx );
         virtual void drawIndexedUp(
                              PrimitiveType  prim,
-                             uint32         numprim,
+                             uint32         numidx,
                              uint32         numvtx,
                              const void *   vertexData,
                              uint32         strideInBytes,
                              const uint16 * indexData );
         virtual void drawUp( PrimitiveType prim,
-                             uint32        numprim,
+                             uint32        numvtx,
                              const void *  vertexData,
                              uint32        strideInBytes );
-        virtual void drawLines( uint32         options,
-                                const void *      positions,
-                                uint32            stride,
-                                uint32            count,
-                                uint32            rgba,
-                                const Matrix44f & model,
-                                const Matrix44f & view,
-                                const Matrix44f & proj );
 
         virtual GpuSignals & getSignals() { GN_ASSERT(mSignals); return *mSignals; }
         virtual void getBackBufferContent( BackBufferContent & );
-        virtual void processRenderWindowMessages( bool blockWhileMinimized );
         virtual void setUserData( const Guid & id, const void * data, uint32 length );
         virtual const void * getUserData( const Guid & id, uint32 * length ) const;
         virtual bool hasUserData( const Guid & id ) const;
@@ -215,31 +210,9 @@ namespace GN { namespace gfx
         return r;
         GN_UNGUARD;
     }
-}}3
-
-#else
-
-namespace GN { namespace gfx
-{
-    ///
-    /// Function type to create renderer.
-    ///
-    typedef GN::gfx::Gpu * (*CreateSingleThreadFunc)( const GN::gfx::GpuOptions & options, void * context );
-
-    ///
-    /// Create multi-threads GPU
-    // -------------------------------------------------------------------------
-    inline Gpu * createMultiThreadGpu( const GpuOptions & go, CreateSingleThreadFunc creator, void * context )
-    {
-        return creator(go, context);
-    }
-    
 }}
 
-#endif
-
 // *****************************************************************************
 //                                     EOF
 // *****************************************************************************
 #endif // __GN_GFX_UTIL_GPU_MTGPU_H__
-
@@ -9,14 +9,13 @@ namespace GN { namespace gfx
 {
 
 void func_SHUTDOWN( Gpu &, void *, uint32 );
-void func_FENCE( Gpu &, void *, uint32 );
 void func_GET_GPU_OPTIONS( Gpu &, void *, uint32 );
 void func_GET_DISP_DESC( Gpu &, void *, uint32 );
+void func_GET_RENDER_WINDOW( Gpu &, void *, uint32 );
 void func_GET_D3D_DEVICE( Gpu &, void *, uint32 );
 void func_GET_OGL_RC( Gpu &, void *, uint32 );
 void func_GET_CAPS( Gpu &, void *, uint32 );
 void func_CHECK_TEXTURE_FORMAT_SUPPORT( Gpu &, void *, uint32 );
-void func_GET_DEFAULT_TEXTURE_FORMAT( Gpu &, void *, uint32 );
 void func_CREATE_GPU_PROGRAM( Gpu &, void *, uint32 );
 void func_CREATE_UNIFORM( Gpu &, void *, uint32 );
 void func_CREATE_TEXTURE( Gpu &, void *, uint32 );
@@ -30,9 +29,7 @@ void func_DRAW_INDEXED( Gpu &, void *, uint32 );
 void func_DRAW( Gpu &, void *, uint32 );
 void func_DRAW_INDEXED_UP( Gpu &, void *, uint32 );
 void func_DRAW_UP( Gpu &, void *, uint32 );
-void func_DRAW_LINES( Gpu &, void *, uint32 );
 void func_GET_BACK_BUFFER_CONTENT( Gpu &, void *, uint32 );
-void func_PROCESS_RENDER_WINDOW_MESSAGES( Gpu &, void *, uint32 );
 void func_DEBUG_ENABLE_PARAMETER_CHECK( Gpu &, void *, uint32 );
 void func_DEBUG_DUMP_NEXT_FRAME( Gpu &, void *, uint32 );
 void func_DEBUG_MARK_BEGIN( Gpu &, void *, uint32 );
@@ -45,8 +42,7 @@ void func_UNIFORM_UPDATE( Gpu &, void *, uint32 );
 void func_TEXTURE_DESTROY( Gpu &, void *, uint32 );
 void func_TEXTURE_UPDATE_MIPMAP( Gpu &, void *, uint32 );
 void func_TEXTURE_READ_MIPMAP( Gpu &, void *, uint32 );
-void func_TEXTURE_BLOB_WRITE( Gpu &, void *, uint32 );
-void func_TEXTURE_BLOB_READ( Gpu &, void *, uint32 );
+void func_TEXTURE_GENERATE_MIPMAP( Gpu &, void *, uint32 );
 void func_VTXBUF_DESTROY( Gpu &, void *, uint32 );
 void func_VTXBUF_UPDATE( Gpu &, void *, uint32 );
 void func_VTXBUF_READBACK( Gpu &, void *, uint32 );
@@ -57,14 +53,13 @@ void func_GET_SIGNALS( Gpu &, void *, uint32 );
 
 const GpuCommandHandler g_gpuCommandHandlers[] = {
 &func_SHUTDOWN,
-&func_FENCE,
 &func_GET_GPU_OPTIONS,
 &func_GET_DISP_DESC,
+&func_GET_RENDER_WINDOW,
 &func_GET_D3D_DEVICE,
 &func_GET_OGL_RC,
 &func_GET_CAPS,
 &func_CHECK_TEXTURE_FORMAT_SUPPORT,
-&func_GET_DEFAULT_TEXTURE_FORMAT,
 &func_CREATE_GPU_PROGRAM,
 &func_CREATE_UNIFORM,
 &func_CREATE_TEXTURE,
@@ -78,9 +73,7 @@ const GpuCommandHandler g_gpuCommandHandlers[] = {
 &func_DRAW,
 &func_DRAW_INDEXED_UP,
 &func_DRAW_UP,
-&func_DRAW_LINES,
 &func_GET_BACK_BUFFER_CONTENT,
-&func_PROCESS_RENDER_WINDOW_MESSAGES,
 &func_DEBUG_ENABLE_PARAMETER_CHECK,
 &func_DEBUG_DUMP_NEXT_FRAME,
 &func_DEBUG_MARK_BEGIN,
@@ -93,8 +86,7 @@ const GpuCommandHandler g_gpuCommandHandlers[] = {
 &func_TEXTURE_DESTROY,
 &func_TEXTURE_UPDATE_MIPMAP,
 &func_TEXTURE_READ_MIPMAP,
-&func_TEXTURE_BLOB_WRITE,
-&func_TEXTURE_BLOB_READ,
+&func_TEXTURE_GENERATE_MIPMAP,
 &func_VTXBUF_DESTROY,
 &func_VTXBUF_UPDATE,
 &func_VTXBUF_READBACK,
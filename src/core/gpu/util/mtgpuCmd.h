@@ -10,15 +10,13 @@ namespace GN { namespace gfx
 ///
 enum GpuCommand {
     CMD_SHUTDOWN,
-    CMD_FENCE,
     CMD_GET_GPU_OPTIONS,///< get GPU options
     CMD_GET_DISP_DESC,///< get display descriptor
+    CMD_GET_RENDER_WINDOW,
     CMD_GET_D3D_DEVICE,
     CMD_GET_OGL_RC,
     CMD_GET_CAPS,
     CMD_CHECK_TEXTURE_FORMAT_SUPPORT,
-    CMD_GET_DEFAULT_TEXTURE_FORMAT,
-    CMD_COMPILE_GPU_PROGRAM,
     CMD_CREATE_GPU_PROGRAM,
     CMD_CREATE_UNIFORM,
     CMD_CREATE_TEXTURE,
@@ -32,9 +30,7 @@ enum GpuCommand {
     CMD_DRAW,
     CMD_DRAW_INDEXED_UP,
     CMD_DRAW_UP,
-    CMD_DRAW_LINES,
     CMD_GET_BACK_BUFFER_CONTENT,
-    CMD_PROCESS_RENDER_WINDOW_MESSAGES,
     CMD_DEBUG_ENABLE_PARAMETER_CHECK,
     CMD_DEBUG_DUMP_NEXT_FRAME,
     CMD_DEBUG_MARK_BEGIN,
@@ -47,8 +43,7 @@ enum GpuCommand {
     CMD_TEXTURE_DESTROY,
     CMD_TEXTURE_UPDATE_MIPMAP,
     CMD_TEXTURE_READ_MIPMAP,
-    CMD_TEXTURE_BLOB_WRITE,
-    CMD_TEXTURE_BLOB_READ,
+    CMD_TEXTURE_GENERATE_MIPMAP,
     CMD_VTXBUF_DESTROY,
     CMD_VTXBUF_UPDATE,
     CMD_VTXBUF_READBACK,
@@ -90,7 +90,9 @@ void GN::gfx::MultiThreadIdxBuf::update( uint32 startidx, uint32 numidx, const v
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadIdxBuf::readback( DynaArray<uint8> & data )
 {
+    // round trip: wait until GPU thread has filled the data.
     mGpu.cmdbuf().postCommand2( CMD_IDXBUF_READBACK, mIdxBuf, &data );
+    mGpu.waitForIdle();
 }
 
 // *****************************************************************************
@@ -113,6 +115,7 @@ namespace GN { namespace gfx
     // -------------------------------------------------------------------------
     void func_IDXBUF_UPDATE( Gpu &, void * p, uint32 )
     {
+#pragma pack( push, 1 )
         struct IdxBufUpdateParam
         {
             IdxBuf          * idxbuf;
@@ -121,6 +124,7 @@ namespace GN { namespace gfx
             void            * data;
             SurfaceUpdateFlag flag;
         };
+#pragma pack( pop )
 
         IdxBufUpdateParam * vbup = (IdxBufUpdateParam*)p;
 
@@ -134,14 +138,16 @@ namespace GN { namespace gfx
     // -------------------------------------------------------------------------
     void func_IDXBUF_READBACK( Gpu &, void * p, uint32 )
     {
+#pragma pack( push, 1 )
         struct IdxBufReadBackParam
         {
             IdxBuf             * ib;
             DynaArray<uint8> * buf;
         };
+#pragma pack( pop )
         IdxBufReadBackParam * vbrp = (IdxBufReadBackParam*)p;
 
         vbrp->ib->readback( *vbrp->buf );
-     }
+    }
 }}
 
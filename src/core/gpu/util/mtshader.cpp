@@ -51,6 +51,10 @@ bool GN::gfx::MultiThreadUniform::init( Uniform * uni )
     mFrontEndData = (uint8*)HeapMemory::alloc(mSize);
     if( NULL == mFrontEndData ) return failure();
 
+    // uniform is just created, and GPU thread is idle. So it is safe to read
+    // its initial value directly.
+    memcpy( mFrontEndData, uni->getval(), mSize );
+
     // success
     return success();
 
@@ -96,6 +100,12 @@ void GN::gfx::MultiThreadUniform::update( uint32 offset, uint32 length, const vo
 
     memcpy( mFrontEndData + offset, data, length );
 
+    if( sizeof(UniformUpdateParam) + length > 0xFFF0 )
+    {
+        GN_ERROR(getLogger("GN.gfx.Uniform"))( "Uniform update is too large for command buffer!" );
+        return;
+    }
+
     uint16 cmdsize = (uint16)( sizeof(UniformUpdateParam) + length );
     CommandBuffer::Token token;
     if( CommandBuffer::OPERATION_SUCCEEDED == mGpu.cmdbuf().beginProduce( CMD_UNIFORM_UPDATE, cmdsize, &token ) )
@@ -111,10 +121,6 @@ void GN::gfx::MultiThreadUniform::update( uint32 offset, uint32 length, const vo
 
         mGpu.cmdbuf().endProduce();
     }
-    else
-    {
-        GN_UNIMPL();
-    }
 }
 
 // *****************************************************************************
@@ -137,7 +143,7 @@ bool GN::gfx::MultiThreadGpuProgram::init( GpuProgram * gp )
     mGpuProgram = gp;
 
     // get parameter informations
-    volatile GpuProgramInitParam gpip;
+    GpuProgramInitParam gpip;
     gpip.gp = mGpuProgram;
     mGpu.cmdbuf().postCommand1( CMD_GPU_PROGRAM_INIT, &gpip );
     mGpu.waitForIdle();
@@ -50,6 +50,10 @@ bool GN::gfx::MultiThreadTexture::init( Texture * tex )
         setMipSize( i, mTexture->getMipSize( i ) );
     }
 
+    // The texture is just created, and GPU thread is idle. So it is safe to
+    // query the real texture directly.
+    mAPIDependentData = mTexture->getAPIDependentData();
+
     // success
     return success();
 
@@ -99,7 +103,10 @@ void GN::gfx::MultiThreadTexture::updateMipmap(
 
     const Vector3<uint32> & mipsize = getMipSize( level );
 
-    uint32 dataSize = slicePitch * mipsize.z;
+    // size of the source data: full slices of the updated area.
+    uint32 depth    = area ? area->d : mipsize.z;
+    uint32 height   = area ? area->h : mipsize.y;
+    uint32 dataSize = slicePitch ? slicePitch * depth : rowPitch * height;
 
     void * tmpbuf = HeapMemory::alloc( dataSize );
     if( NULL == tmpbuf )
@@ -132,31 +139,9 @@ void GN::gfx::MultiThreadTexture::updateMipmap(
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadTexture::readMipmap( uint32 face, uint32 level, MipmapData & data )
 {
-    GN_UNUSED_PARAM( face );
-    GN_UNUSED_PARAM( level );
-    GN_UNUSED_PARAM( data );
-    GN_UNIMPL();
-}
-
-
-//
-//
-// -----------------------------------------------------------------------------
-void GN::gfx::MultiThreadTexture::blobWrite( const void * data, uint32 length )
-{
-    GN_UNUSED_PARAM( data );
-    GN_UNUSED_PARAM( length );
-    GN_UNIMPL();
-}
-
-//
-//
-// -----------------------------------------------------------------------------
-uint32 GN::gfx::MultiThreadTexture::blobRead( void * data )
-{
-    GN_UNUSED_PARAM( data );
-    GN_UNIMPL();
-    return 0;
+    // round trip: wait until GPU thread has filled the data.
+    mGpu.cmdbuf().postCommand4( CMD_TEXTURE_READ_MIPMAP, mTexture, face, level, &data );
+    mGpu.waitForIdle();
 }
 
 //
@@ -164,17 +149,7 @@ uint32 GN::gfx::MultiThreadTexture::blobRead( void * data )
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadTexture::generateMipmapPyramid()
 {
-    GN_UNIMPL();
-}
-
-
-//
-//
-// -----------------------------------------------------------------------------
-void * GN::gfx::MultiThreadTexture::getAPIDependentData() const
-{
-    GN_UNIMPL();
-    return 0;
+    mGpu.cmdbuf().postCommand1( CMD_TEXTURE_GENERATE_MIPMAP, mTexture );
 }
 
 // *****************************************************************************
@@ -214,24 +189,28 @@ namespace GN { namespace gfx
     //
     //
     // -------------------------------------------------------------------------
-    void func_TEXTURE_READ_MIPMAP( Gpu &, void *, uint32 )
+    void func_TEXTURE_READ_MIPMAP( Gpu &, void * p, uint32 )
     {
-        GN_UNIMPL();
+#pragma pack( push, 1 )
+        struct ReadMipmapParam
+        {
+            Texture    * tex;
+            uint32       face;
+            uint32       level;
+            MipmapData * data;
+        };
+#pragma pack( pop )
+        ReadMipmapParam * rmp = (ReadMipmapParam*)p;
+
+        rmp->tex->readMipmap( rmp->face, rmp->level, *rmp->data );
     }
 
     //
     //
     // -------------------------------------------------------------------------
-    void func_TEXTURE_BLOB_WRITE( Gpu &, void *, uint32 )
+    void func_TEXTURE_GENERATE_MIPMAP( Gpu &, void * p, uint32 )
     {
-        GN_UNIMPL();
-    }
-
-    //
-    //
-    // -------------------------------------------------------------------------
-    void func_TEXTURE_BLOB_READ( Gpu &, void *, uint32 )
-    {
-        GN_UNIMPL();
+        Texture ** tex = (Texture**)p;
+        (*tex)->generateMipmapPyramid();
     }
 }}
@@ -36,7 +36,7 @@ namespace GN { namespace gfx
         bool init( Texture * );
         void quit();
     private:
-        void clear() { mTexture = NULL; }
+        void clear() { mTexture = NULL; mAPIDependentData = NULL; }
         //@}
 
         // ********************************
@@ -59,10 +59,8 @@ namespace GN { namespace gfx
                              const void        * data,
                              SurfaceUpdateFlag   flag );
         void   readMipmap( uint32 face, uint32 level, MipmapData & data );
-        void   blobWrite( const void * data, uint32 length );
-        uint32 blobRead( void * data );
         void   generateMipmapPyramid();
-        void * getAPIDependentData() const;
+        void * getAPIDependentData() const { return mAPIDependentData; }
 
         // ********************************
         // private variables
@@ -70,7 +68,8 @@ namespace GN { namespace gfx
     private:
 
         MultiThreadGpu & mGpu;
-        Texture             * mTexture;
+        Texture        * mTexture;
+        void           * mAPIDependentData; ///< cached at creation time, since it never changes.
 
         // ********************************
         // private functions
@@ -88,7 +88,9 @@ void GN::gfx::MultiThreadVtxBuf::update( uint32 offset, uint32 length, const voi
 // -----------------------------------------------------------------------------
 void GN::gfx::MultiThreadVtxBuf::readback( DynaArray<uint8> & data )
 {
+    // round trip: wait until GPU thread has filled the data.
     mGpu.cmdbuf().postCommand2( CMD_VTXBUF_READBACK, mVtxBuf, &data );
+    mGpu.waitForIdle();
 }
 
 // *****************************************************************************
@@ -111,6 +113,7 @@ namespace GN { namespace gfx
     // -------------------------------------------------------------------------
     void func_VTXBUF_UPDATE( Gpu &, void * p, uint32 )
     {
+#pragma pack( push, 1 )
         struct VtxBufUpdateParam
         {
             VtxBuf          * vtxbuf;
@@ -119,6 +122,7 @@ namespace GN { namespace gfx
             void            * data;
             SurfaceUpdateFlag flag;
         };
+#pragma pack( pop )
 
         VtxBufUpdateParam * vbup = (VtxBufUpdateParam*)p;
 
@@ -132,13 +136,15 @@ namespace GN { namespace gfx
     // -------------------------------------------------------------------------
     void func_VTXBUF_READBACK( Gpu &, void * p, uint32 )
     {
+#pragma pack( push, 1 )
         struct VtxBufReadBackParam
         {
             VtxBuf             * vb;
             DynaArray<uint8> * buf;
         };
+#pragma pack( pop )
         VtxBufReadBackParam * vbrp = (VtxBufReadBackParam*)p;
 
         vbrp->vb->readback( *vbrp->buf );
-     }
+    }
 }}
@@ -51,6 +51,9 @@ namespace GN
 // basic sync. primitives
 #include "base/sync.h"
 
+// lock-free queues
+#include "base/concurrentQueue.h"
+
 // single/double linked list
 #include "base/link.h"
 
@@ -60,9 +63,13 @@ namespace GN
 // string types
 #include "base/string.h"
 
+// deferred binary logging
+#include "base/binaryLog.h"
+
 // math library
 #include "base/math.h"
 #include "base/geometry.h"
+#include "base/frustum.h"
 
 // misc.
 #include "base/misc.h"
@@ -79,6 +86,7 @@ namespace GN
 
 // array types
 #include "base/array.h"
+#include "base/occlusion.h"
 
 // dictionary type
 #include "base/dict.h"
@@ -117,6 +125,12 @@ namespace GN
 // light-weight performance profiler
 #include "base/profiler.h"
 
+// job system
+#include "base/jobs.h"
+
+// asynchronous operations
+#include "base/async.h"
+
 // XML parser
 #include "base/xml.h"
 
@@ -0,0 +1,334 @@
+#ifndef __GN_BASE_ASYNC_H__
+#define __GN_BASE_ASYNC_H__
+// *****************************************************************************
+/// \file
+/// \brief   Prioritized, cancellable asynchronous operations on top of JobSystem
+// *****************************************************************************
+
+#include <functional>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#include <coroutine>
+#define GN_HAS_COROUTINE 1 ///< AsyncResult can be co_await'ed.
+#else
+#define GN_HAS_COROUTINE 0
+#endif
+
+namespace GN
+{
+    class AsyncLoader;
+
+    ///
+    /// Priority of asynchronous operations. Queued operations with higher priority start first.
+    ///
+    struct AsyncPriority
+    {
+        enum Enum
+        {
+            HIGH,
+            NORMAL,
+            LOW,
+            NUM_PRIORITIES,
+        };
+
+        GN_DEFINE_ENUM_CLASS_HELPERS( AsyncPriority, Enum );
+    };
+
+    ///
+    /// Status of asynchronous operations
+    ///
+    struct AsyncStatus
+    {
+        enum Enum
+        {
+            QUEUED,    ///< waiting for a free loader slot.
+            WORKING,   ///< work function is running on a worker thread.
+            FINISHING, ///< waiting for, or running, the finish function on main thread.
+            SUCCEEDED, ///< done.
+            FAILED,    ///< done. Work or finish function returned false.
+            CANCELLED, ///< done. Cancelled before the result is produced.
+        };
+
+        GN_DEFINE_ENUM_CLASS_HELPERS( AsyncStatus, Enum );
+    };
+
+    ///
+    /// Untyped part of an asynchronous operation. See AsyncResult for the typed handle.
+    ///
+    /// An operation runs in two stages: the work function runs on a job system worker
+    /// (file I/O, decoding, CPU processing), then the optional finish function runs on the
+    /// main thread of the job system (GPU resource creation and anything else that is
+    /// bound to the owning thread).
+    ///
+    class GN_API AsyncOperation : public RefCounter
+    {
+        friend class AsyncLoader;
+
+    public:
+
+        /// \name status query
+        //@{
+        const char *  getName() const { return mName; }
+        AsyncStatus   getStatus() const { return (AsyncStatus::Enum)mStatus.load( std::memory_order_acquire ); }
+        AsyncPriority getPriority() const { return (AsyncPriority::Enum)mPriority.load( std::memory_order_relaxed ); }
+        bool          isDone() const { return getStatus() >= AsyncStatus::SUCCEEDED; }
+        bool          succeeded() const { return AsyncStatus::SUCCEEDED == getStatus(); }
+        bool          isCancelRequested() const { return mCancelRequested.load( std::memory_order_relaxed ); }
+        //@}
+
+        ///
+        /// Change priority. Only affects operations that are still queued.
+        ///
+        void setPriority( AsyncPriority );
+
+        ///
+        /// Request cancellation. Queued operations are cancelled immediately. Running
+        /// operations are cancelled at the next stage boundary. No effect after done.
+        ///
+        void cancel();
+
+        ///
+        /// Call the function on main thread after the operation is done, no matter it
+        /// succeeded or not. The callback is always deferred to the next
+        /// AsyncLoader::update() (or JobSystem::processMainThreadJobs()), even if the
+        /// operation is already done.
+        ///
+        void onComplete( std::function<void()> callback );
+
+        ///
+        /// Block until the operation is done. When called on main thread, main thread
+        /// jobs are processed while waiting. Do not call it from inside a job.
+        ///
+        void wait();
+
+    protected:
+
+        ///
+        /// protected ctor
+        ///
+        AsyncOperation( AsyncLoader & loader, const char * name, AsyncPriority priority );
+
+        ///
+        /// protected dtor
+        ///
+        virtual ~AsyncOperation() {}
+
+        /// \name stages, implemented by subclass
+        //@{
+        virtual bool work() = 0;                 ///< runs on worker thread
+        virtual bool finish() = 0;               ///< runs on main thread
+        virtual bool hasFinishStage() const = 0;
+        virtual void releaseStages() = 0;        ///< free stage functions once done
+        //@}
+
+    private:
+
+        AsyncLoader &                      mLoader;
+        const char *                       mName;
+        std::atomic<uint32>                mStatus;
+        std::atomic<uint32>                mPriority;
+        std::atomic<bool>                  mCancelRequested;
+        Mutex                              mCallbackLock;
+        DynaArray<std::function<void()> >  mCallbacks;
+    };
+
+    ///
+    /// Asynchronous operation that produces a value of type T.
+    ///
+    template<typename T>
+    class AsyncValue : public AsyncOperation
+    {
+    public:
+
+        ///
+        /// Stage function. Fills in (or modifies) the value, returns false on failure.
+        ///
+        typedef std::function<bool( T & )> StageFunc;
+
+        ///
+        /// ctor
+        ///
+        AsyncValue( AsyncLoader & loader, const char * name, AsyncPriority priority, StageFunc w, StageFunc f )
+            : AsyncOperation( loader, name, priority )
+            , mWork( std::move( w ) )
+            , mFinish( std::move( f ) )
+        {
+        }
+
+        ///
+        /// Return the value. Only meaningful after the operation is done.
+        ///
+        T & value() { return mValue; }
+
+    protected:
+
+        //@{
+        virtual bool work()                 { return mWork ? mWork( mValue ) : true; }
+        virtual bool finish()               { return mFinish( mValue ); }
+        virtual bool hasFinishStage() const { return (bool)mFinish; }
+        virtual void releaseStages()        { mWork = nullptr; mFinish = nullptr; }
+        //@}
+
+    private:
+
+        T         mValue;
+        StageFunc mWork;
+        StageFunc mFinish;
+    };
+
+    ///
+    /// Reference counted handle of an asynchronous operation that produces a value of type T.
+    ///
+    /// Three ways to consume the value:
+    ///
+    ///     // 1. callback, runs on main thread:
+    ///     RawImage::loadAsync( "a.png" ).then( []( AsyncResult<RawImage> & r ){ ... } );
+    ///
+    ///     // 2. future style, blocks:
+    ///     RawImage img = std::move( RawImage::loadAsync( "a.png" ).get() );
+    ///
+    ///     // 3. C++20 coroutine (GN_HAS_COROUTINE), resumes on main thread:
+    ///     RawImage img = co_await RawImage::loadAsync( "a.png" );
+    ///
+    template<typename T>
+    class AsyncResult
+    {
+        AutoRef< AsyncValue<T> > mOp;
+
+    public:
+
+        /// \name ctor
+        //@{
+        AsyncResult() {}
+        explicit AsyncResult( AsyncValue<T> * op ) : mOp( op ) {}
+        //@}
+
+        /// \name status
+        //@{
+        bool             empty() const { return !mOp; }
+        AsyncOperation * operation() const { return mOp.rawptr(); }
+        AsyncStatus      getStatus() const { return mOp ? mOp->getStatus() : AsyncStatus( AsyncStatus::FAILED ); }
+        bool             isDone() const { return !mOp || mOp->isDone(); }
+        bool             succeeded() const { return mOp && mOp->succeeded(); }
+        //@}
+
+        /// \name control
+        //@{
+        void cancel() const { if( mOp ) mOp->cancel(); }
+        void setPriority( AsyncPriority p ) const { if( mOp ) mOp->setPriority( p ); }
+        void wait() const { if( mOp ) mOp->wait(); }
+        //@}
+
+        ///
+        /// Return the value. Operation must be done. Value is default constructed, if the
+        /// operation failed or was cancelled.
+        ///
+        T & value() const { GN_ASSERT( mOp && mOp->isDone() ); return mOp->value(); }
+
+        ///
+        /// Wait for the operation, then return the value.
+        ///
+        T & get() const { GN_ASSERT( mOp ); mOp->wait(); return mOp->value(); }
+
+        ///
+        /// Call func( AsyncResult<T> & ) on main thread, after the operation is done.
+        ///
+        template<typename FUNC>
+        const AsyncResult & then( FUNC func ) const
+        {
+            if( !mOp ) return *this;
+            AsyncResult self( *this );
+            mOp->onComplete( [self, func]() mutable { func( self ); } );
+            return *this;
+        }
+
+#if GN_HAS_COROUTINE
+        /// \name awaitable interface. Value is moved out of the operation on resume.
+        //@{
+        bool await_ready() const { return isDone(); }
+        void await_suspend( std::coroutine_handle<> h ) const { mOp->onComplete( [h]{ h.resume(); } ); }
+        T    await_resume() const { return std::move( mOp->value() ); }
+        //@}
+#endif
+    };
+
+    ///
+    /// Schedules asynchronous operations on a JobSystem. At most maxConcurrentOperations
+    /// work stages run at the same time; queued operations start in priority order, and
+    /// FIFO within the same priority.
+    ///
+    /// Finish stages and completion callbacks run on main thread of the job system, in
+    /// update(). For GPU resources, that must be the thread that owns the GPU.
+    ///
+    class GN_API AsyncLoader : public NoCopy
+    {
+        friend class AsyncOperation;
+
+    public:
+
+        ///
+        /// ctor. 0 concurrent operations means number of workers of the job system.
+        ///
+        explicit AsyncLoader( JobSystem & js, uint32 maxConcurrentOperations = 0 );
+
+        ///
+        /// Cancel queued operations, and wait for running ones.
+        ///
+        ~AsyncLoader();
+
+        ///
+        /// The global loader, on top of the global job system.
+        ///
+        static AsyncLoader & sGetGlobalInstance();
+
+        ///
+        /// Return the job system that runs the operations.
+        ///
+        JobSystem & getJobSystem() const;
+
+        ///
+        /// Queue an operation that produces a T. The work function runs on a worker thread,
+        /// the finish function (optional) runs on main thread after that. Name must be a
+        /// static string.
+        ///
+        template<typename T>
+        AsyncResult<T> run(
+            const char *                               name,
+            AsyncPriority                              priority,
+            typename AsyncValue<T>::StageFunc          work,
+            typename AsyncValue<T>::StageFunc          finish = nullptr )
+        {
+            AsyncResult<T> r( new AsyncValue<T>( *this, name, priority, std::move( work ), std::move( finish ) ) );
+            enqueue( r.operation() );
+            return r;
+        }
+
+        ///
+        /// Run finish stages and completion callbacks. Must be called on main thread,
+        /// usually once per frame. Return number of jobs executed.
+        ///
+        size_t update();
+
+        ///
+        /// Wait for all operations to be done.
+        ///
+        void waitAll();
+
+        ///
+        /// Return number of operations that are not done yet.
+        ///
+        uint32 getPendingCount() const;
+
+    private:
+
+        void enqueue( AsyncOperation * );
+
+        class Impl;
+        Impl * mImpl;
+    };
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_ASYNC_H__
@@ -132,6 +132,7 @@
 #define GN_X86 0 ///< 32-bit x86
 #define GN_X64 0 ///< 64-bit amd64
 #define GN_PPC 0 ///< power pc
+#define GN_ARM64 0 ///< 64-bit arm
 
 /// \def GN_CPU
 /// Indicate current CPU
@@ -148,10 +149,20 @@
 #undef GN_X86
 #define GN_X86 1
 #define GN_CPU x86
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#undef GN_ARM64
+#define GN_ARM64 1
+#define GN_CPU arm64
 #else
 #error "Unknown CPU"
 #endif
 
+///
+/// Size of CPU cache line. Data written by different threads are put on different
+/// cache lines to avoid false sharing.
+///
+#define GN_CACHE_LINE_SIZE 64
+
 // *****************************************************************************
 // 辨识endian
 // *****************************************************************************
@@ -160,7 +171,7 @@
 #define GN_LITTLE_ENDIAN defined(__LITTLE_ENDIAN__) ///< true on little endian machine
 #define GN_BIT_ENDIAN    defined(__BIG_ENDIAN__)    ///< true on big endian machine
 #else
-#define GN_LITTLE_ENDIAN  ( GN_X64 || GN_X86 ) ///< true on little endian machine
+#define GN_LITTLE_ENDIAN  ( GN_X64 || GN_X86 || GN_ARM64 ) ///< true on little endian machine
 #define GN_BIG_ENDIAN     GN_PPC               ///< true on big endian machine
 #endif
 
@@ -177,6 +188,8 @@
 ///
 #if GN_MSVC
 #define GN_FORCE_INLINE   __forceinline
+#elif GN_GCC
+#define GN_FORCE_INLINE   inline __attribute__((always_inline))
 #else
 #define GN_FORCE_INLINE   inline
 #endif
@@ -0,0 +1,386 @@
+#ifndef __GN_BASE_BINARYLOG_H__
+#define __GN_BASE_BINARYLOG_H__
+// *****************************************************************************
+/// \file
+/// \brief   deferred binary logging
+///
+/// Binary log macros record only a pointer to a static log site (format string
+/// and source location) plus the raw argument values into a per-thread buffer.
+/// Text rendering (printf-style formatting) happens later on a background
+/// decoder thread, which then sends the text to the logger's receivers and the
+/// decoded, typed fields to binary log sinks.
+///
+/// Usage:
+///     GN_BINFO( sLogger, "frame %d took %f ms", frame, ms );
+///     GN_BINFO( sLogger, "texture loaded", GN::logField("name", name), GN::logField("bytes", size) );
+///
+/// Named fields (created by GN::logField) are not consumed by the format string.
+/// They are appended to the rendered text as " key=value" and exposed by name to sinks.
+///
+/// FATAL records are decoded and delivered synchronously by the calling thread, after
+/// all records written before them, like GN_FATAL messages of the text logger.
+// *****************************************************************************
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <string.h>
+
+/// Binary log macros, with user specified source code location
+//@{
+#if GN_ENABLE_LOG
+#define GN_BLOG_EX( logger, level, func, file, line, fmt, ... ) \
+    do { \
+        if( (logger)->isOn( level ) ) \
+        { \
+            static const GN::BinaryLogSite __GN_blog_site( level, func, file, line, "" fmt ); \
+            GN::binaryLog( logger, __GN_blog_site, ##__VA_ARGS__ ); \
+        } \
+    } while( 0 )
+#else
+#define GN_BLOG_EX( logger, level, func, file, line, fmt, ... ) do {} while( 0 )
+#endif
+//@}
+
+///
+/// General binary log macro, with automatic source code location
+///
+#define GN_BLOG( logger, level, fmt, ... ) GN_BLOG_EX( logger, level, GN_FUNCTION, __FILE__, __LINE__, fmt, ##__VA_ARGS__ )
+
+/// \name binary log macros for each log level
+//@{
+#define GN_BFATAL( logger, fmt, ... )    GN_BLOG( logger, GN::Logger::FATAL, fmt, ##__VA_ARGS__ )
+#define GN_BERROR( logger, fmt, ... )    GN_BLOG( logger, GN::Logger::ERROR_, fmt, ##__VA_ARGS__ )
+#define GN_BWARN( logger, fmt, ... )     GN_BLOG( logger, GN::Logger::WARN, fmt, ##__VA_ARGS__ )
+#define GN_BINFO( logger, fmt, ... )     GN_BLOG( logger, GN::Logger::INFO, fmt, ##__VA_ARGS__ )
+#define GN_BVERBOSE( logger, fmt, ... )  GN_BLOG( logger, GN::Logger::VERBOSE, fmt, ##__VA_ARGS__ )
+#define GN_BVVERBOSE( logger, fmt, ... ) GN_BLOG( logger, GN::Logger::VVERBOSE, fmt, ##__VA_ARGS__ )
+//@}
+
+///
+/// Debug only binary log macros (no effect to non-debug build)
+///
+//@{
+#if GN_BUILD_DEBUG_ENABLED
+#define GN_BTRACE( logger, fmt, ... )   GN_BINFO( logger, fmt, ##__VA_ARGS__ )
+#define GN_BVTRACE( logger, fmt, ... )  GN_BVERBOSE( logger, fmt, ##__VA_ARGS__ )
+#define GN_BVVTRACE( logger, fmt, ... ) GN_BVVERBOSE( logger, fmt, ##__VA_ARGS__ )
+#else
+#define GN_BTRACE( logger, fmt, ... )   do {} while( 0 )
+#define GN_BVTRACE( logger, fmt, ... )  do {} while( 0 )
+#define GN_BVVTRACE( logger, fmt, ... ) do {} while( 0 )
+#endif
+//@}
+
+namespace GN
+{
+    ///
+    /// Static description of a binary log call site.
+    ///
+    struct GN_API BinaryLogSite
+    {
+        uint32       id;    ///< unique, sequential id of the site.
+        int          level; ///< log level
+        const char * func;  ///< function name
+        const char * file;  ///< source file name
+        int          line;  ///< line number
+        const char * fmt;   ///< printf-style format string (must be string literal)
+
+        ///
+        /// Construct the site and assign an unique id to it.
+        ///
+        BinaryLogSite( int level_, const char * func_, const char * file_, int line_, const char * fmt_ );
+    };
+
+    ///
+    /// Type of binary log field
+    ///
+    enum BinaryLogFieldType
+    {
+        BLFT_SINT,    ///< signed integer, stored as sint64
+        BLFT_UINT,    ///< unsigned integer, stored as uint64
+        BLFT_DOUBLE,  ///< floating point, stored as double
+        BLFT_POINTER, ///< pointer
+        BLFT_STRING,  ///< copy of a null-terminated string
+    };
+
+    ///
+    /// Decoded binary log field
+    ///
+    struct BinaryLogField
+    {
+        const char       * key;  ///< Field name. NULL for positional (format string) arguments.
+        BinaryLogFieldType type; ///< field type
+        union
+        {
+            sint64         s;
+            uint64         u;
+            double         d;
+            const void   * p;
+        };
+        const char       * str;    ///< string value, valid only for BLFT_STRING.
+        size_t             length; ///< string length, valid only for BLFT_STRING.
+    };
+
+    ///
+    /// Decoded binary log record
+    ///
+    struct BinaryLogRecord
+    {
+        Logger                * logger;     ///< the logger
+        const BinaryLogSite   * site;       ///< the log site
+        uint32                  threadId;   ///< sequential id of the logging thread.
+        uint64                  timestamp;  ///< time when the message is logged, in nanoseconds (steady clock).
+        size_t                  fieldCount; ///< number of fields
+        const BinaryLogField  * fields;     ///< field array
+        const char            * text;       ///< rendered text message
+    };
+
+    ///
+    /// Receive decoded binary log records (on the decoder thread), for machine consumption.
+    ///
+    struct BinaryLogSink
+    {
+        ///
+        /// virtual destructor
+        ///
+        virtual ~BinaryLogSink() {}
+
+        ///
+        /// deal with decoded binary log record.
+        ///
+        virtual void onRecord( const BinaryLogRecord & ) = 0;
+    };
+
+    /// \name binary log sink management
+    //@{
+    GN_API void addBinaryLogSink( BinaryLogSink * );
+    GN_API void removeBinaryLogSink( BinaryLogSink * );
+    //@}
+
+    ///
+    /// Block until all binary log records written before this call are decoded and
+    /// delivered to loggers and sinks.
+    ///
+    GN_API void flushBinaryLog();
+
+    ///
+    /// Return number of binary log records dropped because of per-thread buffer overflow.
+    ///
+    GN_API uint64 getBinaryLogDropCount();
+
+    ///
+    /// Named binary log field
+    ///
+    template<typename T>
+    struct LogField
+    {
+        const char * key;   ///< field name (must be string literal)
+        const T    & value; ///< field value
+    };
+
+    ///
+    /// Create a named binary log field
+    ///
+    template<typename T>
+    inline LogField<T> logField( const char * key, const T & value ) { return LogField<T>{ key, value }; }
+
+    namespace internal
+    {
+        ///
+        /// Per-thread binary log buffer
+        ///
+        struct GN_API BinaryLogBuffer
+        {
+            /// record header
+            struct RecordHeader
+            {
+                uint32                size;       ///< record size in bytes, including the header.
+                uint32                fieldCount; ///< number of fields. 0xFFFFFFFF means padding to end of buffer.
+                Logger              * logger;
+                const BinaryLogSite * site;
+                uint64                timestamp;
+            };
+
+            /// field header
+            struct FieldHeader
+            {
+                uint16 type;      ///< BinaryLogFieldType
+                uint16 hasKey;    ///< if non-zero, the header is followed by key pointer.
+                uint32 strLength; ///< string length, excluding null terminator.
+            };
+
+            uint8               * data;
+            size_t                capacity;  ///< buffer size, power of 2
+            std::atomic<size_t>   writePos;  ///< only modified by the owner thread
+            std::atomic<size_t>   readPos;   ///< only modified by the decoder thread
+            std::atomic<uint64>   dropped;
+            std::atomic<bool>     orphaned;  ///< set when the owner thread exits.
+            uint32                threadId;
+
+            ///
+            /// Reserve space for a record. Return NULL if the buffer is full.
+            ///
+            uint8 * beginWrite( size_t bytes );
+
+            ///
+            /// Publish the record.
+            ///
+            void endWrite( size_t bytes )
+            {
+                writePos.store( writePos.load( std::memory_order_relaxed ) + bytes, std::memory_order_release );
+            }
+        };
+
+        ///
+        /// Get binary log buffer of the calling thread.
+        ///
+        GN_API BinaryLogBuffer & getThreadBinaryLogBuffer();
+
+        ///
+        /// Get current timestamp in nanoseconds
+        ///
+        GN_API uint64 getBinaryLogTimestamp();
+
+        ///
+        /// Flush the binary log, then decode and deliver the record on the calling thread.
+        ///
+        GN_API void deliverBinaryLogRecordNow( const uint8 * record );
+
+        /// round up to multiple of 8.
+        inline size_t blogAlign( size_t n ) { return ( n + 7 ) & ~(size_t)7; }
+
+        /// \name get encoded size of the fields
+        //@{
+        template<typename T> inline size_t blogSize( const T & ) { return sizeof(BinaryLogBuffer::FieldHeader) + 8; }
+        inline size_t blogSize( const char * s ) { return sizeof(BinaryLogBuffer::FieldHeader) + blogAlign( ( s ? strlen(s) : 0 ) + 1 ); }
+        inline size_t blogSize( char * s ) { return blogSize( (const char*)s ); }
+        inline size_t blogSize( const StrA & s ) { return sizeof(BinaryLogBuffer::FieldHeader) + blogAlign( s.size() + 1 ); }
+        template<typename T> inline size_t blogSize( const LogField<T> & f ) { return 8 + blogSize( f.value ); }
+        //@}
+
+        ///
+        /// write field header
+        ///
+        inline uint8 * blogWriteHeader( uint8 * p, BinaryLogFieldType type, const char * key, size_t strLength )
+        {
+            BinaryLogBuffer::FieldHeader * h = (BinaryLogBuffer::FieldHeader*)p;
+            h->type = (uint16)type;
+            h->hasKey = NULL != key;
+            h->strLength = (uint32)strLength;
+            p += sizeof(*h);
+            if( key ) { memcpy( p, &key, sizeof(key) ); p += 8; }
+            return p;
+        }
+
+        /// \name encode fields
+        //@{
+        template<typename T>
+        inline uint8 * blogWrite( uint8 * p, const T & v, const char * key = NULL )
+        {
+            if constexpr( std::is_floating_point<T>::value )
+            {
+                double d = (double)v;
+                p = blogWriteHeader( p, BLFT_DOUBLE, key, 0 );
+                memcpy( p, &d, 8 );
+            }
+            else if constexpr( std::is_pointer<T>::value )
+            {
+                const void * ptr = (const void*)v;
+                p = blogWriteHeader( p, BLFT_POINTER, key, 0 );
+                memset( p, 0, 8 );
+                memcpy( p, &ptr, sizeof(ptr) );
+            }
+            else if constexpr( std::is_signed<T>::value || std::is_enum<T>::value )
+            {
+                sint64 s = (sint64)v;
+                p = blogWriteHeader( p, BLFT_SINT, key, 0 );
+                memcpy( p, &s, 8 );
+            }
+            else
+            {
+                static_assert( std::is_arithmetic<T>::value, "unsupported binary log argument type" );
+                uint64 u = (uint64)v;
+                p = blogWriteHeader( p, BLFT_UINT, key, 0 );
+                memcpy( p, &u, 8 );
+            }
+            return p + 8;
+        }
+        inline uint8 * blogWriteString( uint8 * p, const char * s, size_t n, const char * key )
+        {
+            p = blogWriteHeader( p, BLFT_STRING, key, n );
+            if( n ) memcpy( p, s, n );
+            p[n] = 0;
+            return p + blogAlign( n + 1 );
+        }
+        inline uint8 * blogWrite( uint8 * p, const char * s, const char * key = NULL ) { return blogWriteString( p, s ? s : "", s ? strlen(s) : 0, key ); }
+        inline uint8 * blogWrite( uint8 * p, char * s, const char * key = NULL ) { return blogWrite( p, (const char*)s, key ); }
+        inline uint8 * blogWrite( uint8 * p, const StrA & s, const char * key = NULL ) { return blogWriteString( p, s.rawptr(), s.size(), key ); }
+        template<typename T>
+        inline uint8 * blogWrite( uint8 * p, const LogField<T> & f, const char * = NULL ) { return blogWrite( p, f.value, f.key ); }
+        //@}
+
+        inline size_t blogSizeAll() { return 0; }
+        template<typename T, typename... ARGS>
+        inline size_t blogSizeAll( const T & t, const ARGS & ... args ) { return blogSize( t ) + blogSizeAll( args... ); }
+
+        inline uint8 * blogWriteAll( uint8 * p ) { return p; }
+        template<typename T, typename... ARGS>
+        inline uint8 * blogWriteAll( uint8 * p, const T & t, const ARGS & ... args ) { return blogWriteAll( blogWrite( p, t ), args... ); }
+
+        ///
+        /// encode the whole record: header, then fields.
+        ///
+        template<typename... ARGS>
+        inline void blogWriteRecord( uint8 * p, size_t bytes, Logger * logger, const BinaryLogSite & site, const ARGS & ... args )
+        {
+            BinaryLogBuffer::RecordHeader * h = (BinaryLogBuffer::RecordHeader*)p;
+            h->size = (uint32)bytes;
+            h->fieldCount = (uint32)sizeof...(args);
+            h->logger = logger;
+            h->site = &site;
+            h->timestamp = getBinaryLogTimestamp();
+            blogWriteAll( p + sizeof(*h), args... );
+        }
+    }
+
+    ///
+    /// Write binary log record to the calling thread's log buffer. Record is silently
+    /// dropped (and counted) if the buffer is full. FATAL record is never dropped: it is
+    /// delivered synchronously.
+    ///
+    template<typename... ARGS>
+    inline void binaryLog( Logger * logger, const BinaryLogSite & site, const ARGS & ... args )
+    {
+        using namespace internal;
+
+        size_t bytes = sizeof(BinaryLogBuffer::RecordHeader) + blogSizeAll( args... );
+
+        if( site.level <= Logger::FATAL )
+        {
+            std::unique_ptr<uint64[]> record( new uint64[( bytes + 7 ) / 8] );
+            blogWriteRecord( (uint8*)record.get(), bytes, logger, site, args... );
+            deliverBinaryLogRecordNow( (const uint8*)record.get() );
+            return;
+        }
+
+        BinaryLogBuffer & buffer = getThreadBinaryLogBuffer();
+        uint8 * p = buffer.beginWrite( bytes );
+        if( NULL == p ) return;
+
+        blogWriteRecord( p, bytes, logger, site, args... );
+
+        buffer.endWrite( bytes );
+    }
+
+    ///
+    /// Render printf-style format string with decoded binary log fields. Named fields are
+    /// appended as " key=value". Exposed mainly for offline decoders and unit tests.
+    ///
+    GN_API void renderBinaryLogText( StrA & result, const char * fmt, const BinaryLogField * fields, size_t count );
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_BINARYLOG_H__
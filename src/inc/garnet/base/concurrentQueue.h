@@ -0,0 +1,487 @@
+#ifndef __GN_BASE_CONCURRENTQUEUE_H__
+#define __GN_BASE_CONCURRENTQUEUE_H__
+// *****************************************************************************
+/// \file
+/// \brief   Lock-free queues for passing data between threads
+// *****************************************************************************
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace GN
+{
+    ///
+    /// Bounded single-producer single-consumer queue on a ring buffer. Capacity is rounded
+    /// up to power of 2. Each side caches the other side's index, so in steady state push
+    /// and pop touch no cache line written by the other thread.
+    ///
+    template<typename T>
+    class SpscRingBuffer : public NoCopy
+    {
+    public:
+
+        typedef T ValueType;
+        static const bool BOUNDED = true;
+
+        explicit SpscRingBuffer( size_t capacity )
+            : mMask( sRoundUpPow2( capacity ) - 1 )
+            , mItems( (T*)HeapMemory::alignedAlloc( sizeof(T) * ( mMask + 1 ), GN_CACHE_LINE_SIZE ) )
+            , mHead( 0 ), mTailCache( 0 ), mTail( 0 ), mHeadCache( 0 )
+        {
+        }
+
+        ~SpscRingBuffer()
+        {
+            size_t head = mHead.load( std::memory_order_acquire );
+            for( size_t i = mTail.load( std::memory_order_acquire ); i != head; ++i ) mItems[i & mMask].~T();
+            HeapMemory::dealloc( mItems );
+        }
+
+        size_t capacity() const { return mMask + 1; }
+
+        ///
+        /// Producer only. Return false if the queue is full.
+        ///
+        template<typename U>
+        bool tryPush( U && value )
+        {
+            size_t head = mHead.load( std::memory_order_relaxed );
+            if( head - mTailCache > mMask )
+            {
+                mTailCache = mTail.load( std::memory_order_acquire );
+                if( head - mTailCache > mMask ) return false;
+            }
+            new( &mItems[head & mMask] ) T( std::forward<U>( value ) );
+            mHead.store( head + 1, std::memory_order_release );
+            return true;
+        }
+
+        ///
+        /// Consumer only. Return false if the queue is empty.
+        ///
+        bool tryPop( T & value )
+        {
+            size_t tail = mTail.load( std::memory_order_relaxed );
+            if( tail == mHeadCache )
+            {
+                mHeadCache = mHead.load( std::memory_order_acquire );
+                if( tail == mHeadCache ) return false;
+            }
+            T & item = mItems[tail & mMask];
+            value = std::move( item );
+            item.~T();
+            mTail.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        ///
+        /// Approximate number of items in the queue.
+        ///
+        size_t size() const { return mHead.load( std::memory_order_acquire ) - mTail.load( std::memory_order_acquire ); }
+
+    private:
+
+        static size_t sRoundUpPow2( size_t n )
+        {
+            size_t p = 1;
+            while( p < n ) p <<= 1;
+            return p;
+        }
+
+        const size_t mMask;
+        T * const    mItems;
+
+        // producer side
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mHead;
+        size_t                                          mTailCache;
+
+        // consumer side
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mTail;
+        size_t                                          mHeadCache;
+    };
+
+    ///
+    /// Bounded multi-producer multi-consumer queue (Dmitry Vyukov's algorithm). Each slot
+    /// has a sequence number telling whether it is ready for the producer or the consumer
+    /// of the current lap, so producers and consumers only contend on their own index.
+    /// Also serves as the bounded MPSC queue.
+    ///
+    template<typename T>
+    class MpmcRingBuffer : public NoCopy
+    {
+    public:
+
+        typedef T ValueType;
+        static const bool BOUNDED = true;
+
+        explicit MpmcRingBuffer( size_t capacity )
+            : mMask( sRoundUpPow2( capacity < 2 ? 2 : capacity ) - 1 )
+            , mCells( (Cell*)HeapMemory::alignedAlloc( sizeof(Cell) * ( mMask + 1 ), GN_CACHE_LINE_SIZE ) )
+            , mHead( 0 ), mTail( 0 )
+        {
+            for( size_t i = 0; i <= mMask; ++i ) new( &mCells[i].sequence ) std::atomic<size_t>( i );
+        }
+
+        ~MpmcRingBuffer()
+        {
+            size_t head = mHead.load( std::memory_order_acquire );
+            for( size_t i = mTail.load( std::memory_order_acquire ); i != head; ++i ) ( (T*)mCells[i & mMask].storage )->~T();
+            HeapMemory::dealloc( mCells );
+        }
+
+        size_t capacity() const { return mMask + 1; }
+
+        ///
+        /// Thread safe. Return false if the queue is full.
+        ///
+        template<typename U>
+        bool tryPush( U && value )
+        {
+            size_t pos = mHead.load( std::memory_order_relaxed );
+            Cell * cell;
+            for(;;)
+            {
+                cell = &mCells[pos & mMask];
+                size_t seq = cell->sequence.load( std::memory_order_acquire );
+                intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                if( 0 == diff )
+                {
+                    if( mHead.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) break;
+                }
+                else if( diff < 0 )
+                {
+                    return false; // full
+                }
+                else
+                {
+                    pos = mHead.load( std::memory_order_relaxed );
+                }
+            }
+            new( cell->storage ) T( std::forward<U>( value ) );
+            cell->sequence.store( pos + 1, std::memory_order_release );
+            return true;
+        }
+
+        ///
+        /// Thread safe. Return false if the queue is empty.
+        ///
+        bool tryPop( T & value )
+        {
+            size_t pos = mTail.load( std::memory_order_relaxed );
+            Cell * cell;
+            for(;;)
+            {
+                cell = &mCells[pos & mMask];
+                size_t seq = cell->sequence.load( std::memory_order_acquire );
+                intptr_t diff = (intptr_t)seq - (intptr_t)( pos + 1 );
+                if( 0 == diff )
+                {
+                    if( mTail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) break;
+                }
+                else if( diff < 0 )
+                {
+                    return false; // empty
+                }
+                else
+                {
+                    pos = mTail.load( std::memory_order_relaxed );
+                }
+            }
+            T & item = *(T*)cell->storage;
+            value = std::move( item );
+            item.~T();
+            cell->sequence.store( pos + mMask + 1, std::memory_order_release );
+            return true;
+        }
+
+    private:
+
+        struct Cell
+        {
+            std::atomic<size_t>         sequence;
+            alignas(T) unsigned char    storage[sizeof(T)];
+        };
+
+        static size_t sRoundUpPow2( size_t n )
+        {
+            size_t p = 1;
+            while( p < n ) p <<= 1;
+            return p;
+        }
+
+        const size_t mMask;
+        Cell * const mCells;
+
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mHead; ///< next position to push
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<size_t> mTail; ///< next position to pop
+    };
+
+    ///
+    /// Unbounded single-producer single-consumer queue on a linked list. Nodes released by
+    /// the consumer are recycled by the producer, so steady state does no heap allocation.
+    ///
+    template<typename T>
+    class SpscQueue : public NoCopy
+    {
+    public:
+
+        typedef T ValueType;
+        static const bool BOUNDED = false;
+
+        SpscQueue()
+        {
+            Node * n = new Node;
+            mTail.store( n, std::memory_order_relaxed );
+            mHead = mFirst = mTailCopy = n;
+        }
+
+        ~SpscQueue()
+        {
+            // items live in the nodes after the dummy node.
+            for( Node * n = mTail.load( std::memory_order_acquire )->next.load( std::memory_order_acquire ); n; n = n->next.load( std::memory_order_relaxed ) )
+            {
+                ( (T*)n->storage )->~T();
+            }
+            Node * n = mFirst;
+            while( n )
+            {
+                Node * next = n->next.load( std::memory_order_relaxed );
+                delete n;
+                n = next;
+            }
+        }
+
+        ///
+        /// Producer only. Always succeeds.
+        ///
+        template<typename U>
+        bool tryPush( U && value )
+        {
+            Node * n = allocNode();
+            new( n->storage ) T( std::forward<U>( value ) );
+            n->next.store( NULL, std::memory_order_relaxed );
+            mHead->next.store( n, std::memory_order_release );
+            mHead = n;
+            return true;
+        }
+
+        ///
+        /// Consumer only. Return false if the queue is empty.
+        ///
+        bool tryPop( T & value )
+        {
+            Node * t = mTail.load( std::memory_order_relaxed );
+            Node * next = t->next.load( std::memory_order_acquire );
+            if( NULL == next ) return false;
+            T & item = *(T*)next->storage;
+            value = std::move( item );
+            item.~T();
+            // next becomes the new dummy node; t could be recycled by the producer.
+            mTail.store( next, std::memory_order_release );
+            return true;
+        }
+
+    private:
+
+        struct Node
+        {
+            std::atomic<Node*>       next;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            Node() : next( NULL ) {}
+        };
+
+        Node * allocNode()
+        {
+            // nodes in [mFirst, mTailCopy) are consumed, and safe to reuse.
+            if( mFirst == mTailCopy )
+            {
+                mTailCopy = mTail.load( std::memory_order_acquire );
+                if( mFirst == mTailCopy ) return new Node;
+            }
+            Node * n = mFirst;
+            mFirst = mFirst->next.load( std::memory_order_relaxed );
+            return n;
+        }
+
+        // consumer side
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<Node*> mTail; ///< dummy node before the first item
+
+        // producer side
+        alignas(GN_CACHE_LINE_SIZE) Node * mHead;             ///< last node
+        Node *                             mFirst;            ///< oldest node, for recycling
+        Node *                             mTailCopy;
+    };
+
+    ///
+    /// Unbounded multi-producer single-consumer queue (Dmitry Vyukov's algorithm). Push is
+    /// wait-free: one atomic exchange. Note that tryPop() could briefly report empty while
+    /// a producer is in the middle of push, even if later pushes have completed.
+    ///
+    template<typename T>
+    class MpscQueue : public NoCopy
+    {
+    public:
+
+        typedef T ValueType;
+        static const bool BOUNDED = false;
+
+        MpscQueue()
+        {
+            Node * n = new Node;
+            mHead.store( n, std::memory_order_relaxed );
+            mTail = n;
+        }
+
+        ~MpscQueue()
+        {
+            Node * n = mTail;
+            while( n )
+            {
+                Node * next = n->next.load( std::memory_order_acquire );
+                if( n != mTail ) ( (T*)n->storage )->~T();
+                delete n;
+                n = next;
+            }
+        }
+
+        ///
+        /// Thread safe. Always succeeds.
+        ///
+        template<typename U>
+        bool tryPush( U && value )
+        {
+            Node * n = new Node;
+            new( n->storage ) T( std::forward<U>( value ) );
+            Node * prev = mHead.exchange( n, std::memory_order_acq_rel );
+            prev->next.store( n, std::memory_order_release );
+            return true;
+        }
+
+        ///
+        /// Consumer only. Return false if the queue is empty.
+        ///
+        bool tryPop( T & value )
+        {
+            Node * t = mTail;
+            Node * next = t->next.load( std::memory_order_acquire );
+            if( NULL == next ) return false;
+            T & item = *(T*)next->storage;
+            value = std::move( item );
+            item.~T();
+            mTail = next;
+            delete t;
+            return true;
+        }
+
+    private:
+
+        struct Node
+        {
+            std::atomic<Node*>       next;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            Node() : next( NULL ) {}
+        };
+
+        alignas(GN_CACHE_LINE_SIZE) std::atomic<Node*> mHead; ///< last pushed node, shared by producers
+        alignas(GN_CACHE_LINE_SIZE) Node *             mTail; ///< dummy node before the first item
+    };
+
+    ///
+    /// Adds blocking push/pop to one of the queues above. Threads that find the queue
+    /// empty (or full, for bounded queues) sleep on a semaphore instead of spinning.
+    /// The producer/consumer rules of the underlying queue still apply.
+    ///
+    ///     BlockingQueue<MpscQueue<Command>> q;
+    ///     q.push( cmd );                   // producer threads
+    ///     Command c;
+    ///     if( WaitResult::COMPLETED == q.pop( c, timeout ) ) ... // consumer thread
+    ///
+    template<typename QUEUE>
+    class BlockingQueue : public NoCopy
+    {
+    public:
+
+        ///
+        /// Construct with the underlying queue's constructor arguments.
+        ///
+        template<typename... ARGS>
+        explicit BlockingQueue( ARGS &&... args )
+            : mQueue( std::forward<ARGS>( args )... )
+            , mItems( 0 )
+            , mSpaces( sInitialSpaces( mQueue ) )
+        {
+        }
+
+        ///
+        /// Push an item. Block while a bounded queue is full.
+        ///
+        template<typename U>
+        void push( U && value )
+        {
+            if( QUEUE::BOUNDED ) mSpaces.acquire();
+            // Could fail briefly even when there is space: MpmcRingBuffer slot is still being
+            // released by a consumer that has not finished tryPop().
+            while( !mQueue.tryPush( std::forward<U>( value ) ) ) sync::cpuRelax();
+            mItems.release();
+        }
+
+        ///
+        /// Push an item if there is space, without blocking.
+        ///
+        template<typename U>
+        bool tryPush( U && value )
+        {
+            if( QUEUE::BOUNDED && !mSpaces.tryAcquire() ) return false;
+            while( !mQueue.tryPush( std::forward<U>( value ) ) ) sync::cpuRelax();
+            mItems.release();
+            return true;
+        }
+
+        ///
+        /// Pop an item. Block until there is one, or timeout.
+        ///
+        WaitResult pop( typename QUEUE::ValueType & value, TimeInNanoSecond timeout = INFINITE_TIME )
+        {
+            WaitResult wr = mItems.acquire( timeout );
+            if( WaitResult::COMPLETED != wr ) return wr;
+            // Counted items are published, but an earlier slot might still be in the middle of a push.
+            while( !mQueue.tryPop( value ) ) sync::cpuRelax();
+            if( QUEUE::BOUNDED ) mSpaces.release();
+            return WaitResult::COMPLETED;
+        }
+
+        ///
+        /// Pop an item if there is one, without blocking.
+        ///
+        bool tryPop( typename QUEUE::ValueType & value )
+        {
+            if( !mItems.tryAcquire() ) return false;
+            while( !mQueue.tryPop( value ) ) sync::cpuRelax();
+            if( QUEUE::BOUNDED ) mSpaces.release();
+            return true;
+        }
+
+    private:
+
+        template<typename Q>
+        static uint32 sInitialSpaces( const Q & q ) { return Q::BOUNDED ? (uint32)sCapacity( q, 0 ) : 0; }
+
+        template<typename Q>
+        static auto sCapacity( const Q & q, int ) -> decltype( q.capacity() ) { return q.capacity(); }
+
+        template<typename Q>
+        static size_t sCapacity( const Q &, ... ) { return 0; }
+
+        QUEUE     mQueue;
+        Semaphore mItems;
+        Semaphore mSpaces;
+    };
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_CONCURRENTQUEUE_H__
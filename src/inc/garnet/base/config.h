@@ -20,6 +20,11 @@
 #define GN_ENABLE_ASSERT GN_BUILD_DEBUG_ENABLED
 #endif
 
+/// \def GN_ENABLE_SIMD        Use SSE/AVX/NEON implementation of float math classes.
+#ifndef GN_ENABLE_SIMD
+#define GN_ENABLE_SIMD 1
+#endif
+
 /// \def GN_ENABLE_GPU_DEBUG_MARK      Enable GPU Debug markers
 #ifndef GN_ENABLE_GPU_DEBUG_MARK
 #define GN_ENABLE_GPU_DEBUG_MARK (GN_BUILD_DEBUG_ENABLED || GN_BUILD_PROFILING_ENABLED)
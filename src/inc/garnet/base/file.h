@@ -262,9 +262,13 @@ namespace GN
     class GN_API DiskFile : public StdFile
     {
         size_t mSize;
+        void * mMapping;     ///< start of the mapped view, aligned to page (or allocation granularity)
+        size_t mMappingSize; ///< size of the mapped view
+        void * mMappingFile; ///< file mapping handle (used on Windows only)
+
     public:
 
-        DiskFile() : StdFile(0), mSize(0) {}
+        DiskFile() : StdFile(0), mSize(0), mMapping(0), mMappingSize(0), mMappingFile(0) { setCaps( 0xFF ); }
         ~DiskFile() { close(); }
 
         ///
@@ -288,6 +292,13 @@ namespace GN
         // from File
     public:
         size_t size() const { return mSize; }
+
+        ///
+        /// Map part of the file into memory, one range at a time. Writable mapping needs the
+        /// file to be opened for writing. The mapping is released by unmap() or close().
+        ///
+        void * map( size_t offset, size_t length, bool readonly );
+        void unmap();
     };
 
     ///
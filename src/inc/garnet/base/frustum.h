@@ -0,0 +1,146 @@
+#ifndef __GN_BASE_FRUSTUM_H__
+#define __GN_BASE_FRUSTUM_H__
+// *****************************************************************************
+/// \file
+/// \brief   View frustum and batch frustum culling of bounding volumes
+// *****************************************************************************
+
+namespace GN
+{
+    class JobSystem;
+
+    ///
+    /// View frustum, defined by 6 normalized planes. Plane normals point to the inside
+    /// of the frustum, so a point p is inside when plane * p >= 0 for all planes.
+    ///
+    struct Frustum
+    {
+        ///
+        /// plane indices
+        ///
+        enum PlaneIndex
+        {
+            PLANE_LEFT,
+            PLANE_RIGHT,
+            PLANE_BOTTOM,
+            PLANE_TOP,
+            PLANE_NEAR,
+            PLANE_FAR,
+            NUM_PLANES,
+        };
+
+        Plane3f planes[NUM_PLANES]; ///< frustum planes
+
+        ///
+        /// Extract frustum planes from a projection matrix (Gribb-Hartmann). Bounding volumes are
+        /// then tested in the space that the matrix transforms from: pass proj * view to cull in
+        /// world space, or proj * view * world to cull in object space.
+        ///
+        /// \param zeroToOneDepth  true, if clip space depth range is [0, w] (D3D); false, if it is
+        ///                        [-w, w] (OpenGL). False is conservative for both.
+        ///
+        void fromMatrix( const Matrix44f & m, bool zeroToOneDepth )
+        {
+            const Vector4f & r0 = m.rows[0];
+            const Vector4f & r1 = m.rows[1];
+            const Vector4f & r2 = m.rows[2];
+            const Vector4f & r3 = m.rows[3];
+            sSetPlane( planes[PLANE_LEFT],   r3 + r0 );
+            sSetPlane( planes[PLANE_RIGHT],  r3 - r0 );
+            sSetPlane( planes[PLANE_BOTTOM], r3 + r1 );
+            sSetPlane( planes[PLANE_TOP],    r3 - r1 );
+            sSetPlane( planes[PLANE_NEAR],   zeroToOneDepth ? r2 : r3 + r2 );
+            sSetPlane( planes[PLANE_FAR],    r3 - r2 );
+        }
+
+        ///
+        /// Return false if the box is completely outside of the frustum. Boxes intersecting
+        /// the frustum corners might be reported as visible.
+        ///
+        bool testBox( const Boxf & b ) const
+        {
+            Vector3f e( b.w * 0.5f, b.h * 0.5f, b.d * 0.5f );
+            Vector3f c( b.x + e.x, b.y + e.y, b.z + e.z );
+            for( int i = 0; i < NUM_PLANES; ++i )
+            {
+                const Plane3f & p = planes[i];
+                float r = fabs( p.n.x * e.x ) + fabs( p.n.y * e.y ) + fabs( p.n.z * e.z );
+                if( p * c + r < 0 ) return false;
+            }
+            return true;
+        }
+
+        ///
+        /// Return false if the sphere is completely outside of the frustum.
+        ///
+        bool testSphere( const Spheref & s ) const
+        {
+            for( int i = 0; i < NUM_PLANES; ++i )
+            {
+                if( planes[i] * s.center + s.radius < 0 ) return false;
+            }
+            return true;
+        }
+
+    private:
+
+        static void sSetPlane( Plane3f & p, const Vector4f & v )
+        {
+            p.n.set( v.x, v.y, v.z );
+            p.d = v.w;
+            p.normalize();
+        }
+    };
+
+    /// \name Batch frustum culling
+    ///
+    /// Test arrays of bounding volumes against a frustum, using SIMD instructions when
+    /// available, 4 volumes at a time. Indices of volumes that are not completely outside
+    /// are written to "visible" in ascending order, which must have room for "count"
+    /// indices. Return number of visible volumes.
+    ///
+    /// The optional plane cache (one byte per volume, zero initialized by caller, and then
+    /// owned by the culling functions) records the plane that rejected each volume last time. That plane is tested first on the
+    /// next call, which rejects most of the still invisible volumes with one plane test,
+    /// since the view usually moves little between frames.
+    //@{
+
+    ///
+    /// Cull axis aligned boxes.
+    ///
+    GN_API size_t cullBoxes( uint32 * visible, const Frustum & frustum, const Boxf * boxes, size_t count, uint8 * planeCache = NULL );
+
+    ///
+    /// Cull axis aligned boxes stored as separated arrays of centers and half extents.
+    ///
+    GN_API size_t cullBoxes(
+        uint32        * visible,
+        const Frustum & frustum,
+        const float   * centerX, const float * centerY, const float * centerZ,
+        const float   * extentX, const float * extentY, const float * extentZ,
+        size_t          count,
+        uint8         * planeCache = NULL );
+
+    ///
+    /// Cull spheres.
+    ///
+    GN_API size_t cullSpheres( uint32 * visible, const Frustum & frustum, const Spheref * spheres, size_t count, uint8 * planeCache = NULL );
+
+    ///
+    /// Cull boxes with worker threads of the job system. Large arrays are split into chunks,
+    /// culled in parallel, and the visible indices are compacted afterwards.
+    ///
+    GN_API size_t cullBoxes( JobSystem & js, uint32 * visible, const Frustum & frustum, const Boxf * boxes, size_t count, uint8 * planeCache = NULL );
+
+    ///
+    /// Cull spheres with worker threads of the job system.
+    ///
+    GN_API size_t cullSpheres( JobSystem & js, uint32 * visible, const Frustum & frustum, const Spheref * spheres, size_t count, uint8 * planeCache = NULL );
+
+    //@}
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_FRUSTUM_H__
@@ -7,6 +7,7 @@
 // *****************************************************************************
 
 #include <Eigen/Eigen>
+#include "simd.h"
 
 // Garnet system uses right hand system by default. Define this macro to 1 to
 // use left hand system.
@@ -1237,10 +1238,7 @@ namespace GN
         operator * ( const Matrix44 & m, const Vector4<T> & v )
         {
             Vector4<T> ret;
-            ret.x = Vector4<T>::sDot( m[0], v );
-            ret.y = Vector4<T>::sDot( m[1], v );
-            ret.z = Vector4<T>::sDot( m[2], v );
-            ret.w = Vector4<T>::sDot( m[3], v );
+            m.transform( ret, v );
             return ret;
         }
         friend Matrix44 operator * ( const Matrix44 & m, T f )
@@ -1346,6 +1344,36 @@ namespace GN
             r.inverse();
             return r;
         }
+        ///
+        /// Invert affine matrix, which last row is (0, 0, 0, 1). Cheaper than inverse().
+        ///
+        Matrix44 & invertAffine();
+        static Matrix44 sInvertAffine( const Matrix44 & src )
+        {
+            Matrix44 r(src);
+            r.invertAffine();
+            return r;
+        }
+        ///
+        /// Invert rigid transformation: rotation and translation only. The cheapest one.
+        ///
+        Matrix44 & invertRigid();
+        static Matrix44 sInvertRigid( const Matrix44 & src )
+        {
+            Matrix44 r(src);
+            r.invertRigid();
+            return r;
+        }
+        ///
+        /// Invert translate * rotate * scale matrix. Scale could be non-uniform.
+        ///
+        Matrix44 & invertTRS();
+        static Matrix44 sInvertTRS( const Matrix44 & src )
+        {
+            Matrix44 r(src);
+            r.invertTRS();
+            return r;
+        }
         Matrix44 & invtrans()
         {
             inverse();
@@ -1494,6 +1522,18 @@ namespace GN
 #endif
         }
         ///
+        /// transform a 4-D column vector by this matrix. dst and src can be the same.
+        ///
+        void transform( Vector4<T> & dst, const Vector4<T> & src ) const
+        {
+            Vector4<T> tmp;
+            tmp.x = Vector4<T>::sDot( rows[0], src );
+            tmp.y = Vector4<T>::sDot( rows[1], src );
+            tmp.z = Vector4<T>::sDot( rows[2], src );
+            tmp.w = Vector4<T>::sDot( rows[3], src );
+            dst = tmp;
+        }
+        ///
         /// transform a 3-D point by this matrix.
         ///
         /// This function treads input vector as (x, y, z, 1)
@@ -1640,12 +1680,21 @@ namespace GN
         ///
         friend Quaternion
         operator * ( const Quaternion & q1, const Quaternion & q2 )
+        {
+            Quaternion result;
+            sMultiply( result, q1, q2 );
+            return result;
+        }
+        ///
+        /// concatnate. dst can be the same as q1 or q2.
+        ///
+        static void sMultiply( Quaternion & dst, const Quaternion & q1, const Quaternion & q2 )
         {
             Quaternion result;
             result.w = q1.w * q2.w - Vector3<T>::sDot( q1.v, q2.v );
             result.v = Vector3<T>::sCross( q1.v, q2.v );
             result.v += q1.w * q2.v + q2.w * q1.v;
-            return result;
+            dst = result;
         }
 
         ///
@@ -1886,6 +1935,109 @@ namespace GN
         }
     };
 
+    ///
+    /// 4x4 transformation matrix that remembers what kind of transformation it
+    /// is, so that it is inverted with the cheapest method.
+    ///
+    template < typename T >
+    class Transform
+    {
+    public:
+
+        ///
+        /// Transformation kinds, from the simplest to the most general.
+        ///
+        enum Kind
+        {
+            IDENTITY, ///< identity matrix
+            RIGID,    ///< rotation and translation
+            SIMILAR,  ///< rotation, translation and uniform scale
+            TRS,      ///< translate * rotate * scale, scale could be non-uniform.
+            AFFINE,   ///< any matrix with last row of (0, 0, 0, 1)
+            GENERAL,  ///< any matrix, including projections.
+        };
+
+        ///
+        /// Default is identity.
+        ///
+        Transform() : mMatrix( Matrix44<T>::sIdentity() ), mKind( IDENTITY ) {}
+
+        ///
+        /// Construct from matrix. Caller is responsible for the correctness of the kind.
+        ///
+        explicit Transform( const Matrix44<T> & m, Kind k = GENERAL ) : mMatrix( m ), mKind( k ) {}
+
+        ///
+        /// Object is scaled, then rotated around local origin, then moved to position.
+        ///
+        static Transform sTRS( const Vector3<T> & position, const Quaternion<T> & rotation, const Vector3<T> & scale )
+        {
+            Transform t;
+            rotation.toMatrix44( t.mMatrix );
+            for( int r = 0; r < 3; ++r )
+            {
+                t.mMatrix[r][0] *= scale.x;
+                t.mMatrix[r][1] *= scale.y;
+                t.mMatrix[r][2] *= scale.z;
+            }
+            t.mMatrix[0][3] = position.x;
+            t.mMatrix[1][3] = position.y;
+            t.mMatrix[2][3] = position.z;
+            if( scale.x != scale.y || scale.x != scale.z ) t.mKind = TRS;
+            else if( (T)1 != scale.x ) t.mKind = SIMILAR;
+            else t.mKind = RIGID;
+            return t;
+        }
+
+        const Matrix44<T> & matrix() const { return mMatrix; }
+        Kind                kind() const { return mKind; }
+
+        ///
+        /// Invert with the cheapest method for the kind.
+        ///
+        Transform & inverse()
+        {
+            switch( mKind )
+            {
+                case IDENTITY : break;
+                case RIGID    : mMatrix.invertRigid(); break;
+                case SIMILAR  : mMatrix.invertTRS(); break;
+                case TRS      : mMatrix.invertTRS(); mKind = AFFINE; break; // S^-1 * R^-1 * T^-1 is not TRS any more.
+                case AFFINE   : mMatrix.invertAffine(); break;
+                default       : mMatrix.inverse(); break;
+            }
+            return *this;
+        }
+        static Transform sInverse( const Transform & src )
+        {
+            Transform r(src);
+            r.inverse();
+            return r;
+        }
+
+        ///
+        /// Kind of a * b
+        ///
+        static Kind sCombine( Kind a, Kind b )
+        {
+            if( IDENTITY == a ) return b;
+            if( IDENTITY == b ) return a;
+            if( GENERAL == a || GENERAL == b ) return GENERAL;
+            if( a <= SIMILAR && b <= TRS ) return a > b ? a : b; // uniform scale commutes with rotation.
+            return AFFINE;
+        }
+
+        friend Transform operator * ( const Transform & a, const Transform & b )
+        {
+            return Transform( a.mMatrix * b.mMatrix, sCombine( a.mKind, b.mKind ) );
+        }
+
+    private:
+
+        Matrix44<T> mMatrix;
+        Kind        mKind;
+    };
+
     ///
     /// 3D plane class
     ///
@@ -1967,7 +2119,7 @@ namespace GN
         ///
         friend T operator * ( const Plane3 & p, const Vector3<T> & v )
         {
-            return Vector3<T>::dot( p.n, v ) + p.d;
+            return Vector3<T>::sDot( p.n, v ) + p.d;
         }
         ///
         /// dot production with 3D vector
@@ -2038,7 +2190,7 @@ namespace GN
                                   const Vector3<T> & normal )
         {
             n = normal;
-            d = Vector3<T>::dot( -n, point );
+            d = Vector3<T>::sDot( -n, point );
             return *this;
         }
         ///
@@ -2049,7 +2201,7 @@ namespace GN
                              const Vector3<T> & v3 )
         {
             n = Vector3<T>::cross( v2 - v1, v3 - v1 );
-            d = Vector3<T>::dot( -n, v1 );
+            d = Vector3<T>::sDot( -n, v1 );
             return *this;
         }
         ///
@@ -2529,10 +2681,110 @@ namespace GN
             return *this;
         }
     };
+
+    ///
+    /// Oriented bounding box
+    ///
+    template < typename T >
+    class OrientedBox
+    {
+    public :
+
+        ///
+        /// element type
+        ///
+        typedef T ElementType;
+
+        Vector3<T> center;  ///< box center
+        Vector3<T> axes[3]; ///< box axes, orthonormal
+        Vector3<T> extents; ///< half size along each axis
+
+        ///
+        /// box volume
+        ///
+        T volume() const { return extents.x * extents.y * extents.z * (T)8; }
+
+        ///
+        /// return true if the point is inside the box.
+        ///
+        bool contains( const Vector3<T> & p ) const
+        {
+            Vector3<T> d = p - center;
+            return fabs( Vector3<T>::sDot( d, axes[0] ) ) <= extents.x
+                && fabs( Vector3<T>::sDot( d, axes[1] ) ) <= extents.y
+                && fabs( Vector3<T>::sDot( d, axes[2] ) ) <= extents.z;
+        }
+    };
+
+    ///
+    /// Discrete oriented polytope (k-DOP): intersection of K/2 slabs along fixed axes.
+    /// Supported K and the axes used:
+    ///
+    ///     - 8:  4 cube diagonals (1,1,1), (1,1,-1), (1,-1,1), (-1,1,1)
+    ///     - 14: x, y, z and the 4 cube diagonals
+    ///     - 18: x, y, z and 6 edge diagonals (1,1,0), (1,-1,0), (1,0,1), (1,0,-1), (0,1,1), (0,1,-1)
+    ///     - 26: all of the above
+    ///
+    /// Axes are not normalized, so slab values are projections scaled by axis length.
+    ///
+    template < int K >
+    class Dop
+    {
+        GN_CASSERT( 8 == K || 14 == K || 18 == K || 26 == K );
+
+    public :
+
+        enum { NUM_AXES = K / 2 }; ///< number of slabs
+
+        float minimum[NUM_AXES]; ///< slab minimums
+        float maximum[NUM_AXES]; ///< slab maximums
+
+        ///
+        /// Get axis of the i-th slab.
+        ///
+        static Vector3<float> sGetAxis( size_t i )
+        {
+            static const float AXES[13][3] = {
+                {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+                {1, 1, 1}, {1, 1,-1}, {1,-1, 1}, {-1, 1, 1},
+                {1, 1, 0}, {1,-1, 0}, {1, 0, 1}, {1, 0,-1}, {0, 1, 1}, {0, 1,-1},
+            };
+            GN_ASSERT( i < NUM_AXES );
+            if( 8 == K ) i += 3;
+            else if( 18 == K && i >= 3 ) i += 4;
+            return Vector3<float>( AXES[i][0], AXES[i][1], AXES[i][2] );
+        }
+
+        ///
+        /// return true if the point is inside the polytope.
+        ///
+        bool contains( const Vector3<float> & p ) const
+        {
+            for( size_t i = 0; i < NUM_AXES; ++i )
+            {
+                float d = Vector3<float>::sDot( p, sGetAxis( i ) );
+                if( d < minimum[i] || d > maximum[i] ) return false;
+            }
+            return true;
+        }
+
+        ///
+        /// return true if the two polytopes overlap on all axes (conservative intersection test).
+        ///
+        bool overlaps( const Dop & other ) const
+        {
+            for( size_t i = 0; i < NUM_AXES; ++i )
+            {
+                if( minimum[i] > other.maximum[i] || maximum[i] < other.minimum[i] ) return false;
+            }
+            return true;
+        }
+    };
 }
 
 #include "matrix.inl"
 #include "quaternion.inl"
+#include "geometrySimd.inl"
 
 namespace GN
 {
@@ -2564,6 +2816,9 @@ namespace GN
     typedef Quaternion<float>   Quaternionf;
     typedef Quaternion<double>  Quaterniond;
 
+    typedef Transform<float>    Transformf;
+    typedef Transform<double>   Transformd;
+
     typedef Plane3<float>       Plane3f;
     typedef Plane3<double>      Plane3d;
     typedef Plane3<int>         Plane3i;
@@ -2579,10 +2834,19 @@ namespace GN
     typedef Sphere<float>       Spheref;
     typedef Sphere<double>      Sphered;
     typedef Sphere<int>         Spherei;
+
+    typedef OrientedBox<float>  OrientedBoxf;
+    typedef OrientedBox<double> OrientedBoxd;
+
+    typedef Dop<8>              Dop8;
+    typedef Dop<14>             Dop14;
+    typedef Dop<18>             Dop18;
+    typedef Dop<26>             Dop26;
     //@}
 
     ///
-    /// Calculate bounding sphere.
+    /// Calculate bounding sphere: the smaller of the sphere around the bounding box and,
+    /// when x, y and z are adjacent floats of one vertex stream, Ritter's sphere.
     ///
     GN_API void calculateBoundingSphere(
         Spheref & result,
@@ -2601,8 +2865,43 @@ namespace GN
     ///
     GN_API void calculateBoundingSphereFromBoundingBox( Spheref & result, const Boxf & bbox );
 
+    /// \name Tight bounding volumes
     ///
-    /// Calculate axis aligned bounding box.
+    /// Positions are read from a strided vertex stream. Stride is in bytes.
+    //@{
+
+    ///
+    /// Calculate bounding sphere with Ritter's algorithm: start from the most separated
+    /// pair of axis extreme points, then grow to include outliers. Fast and usually
+    /// within 5-20% of the minimal radius.
+    ///
+    GN_API void calculateBoundingSphereRitter( Spheref & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+
+    ///
+    /// Calculate minimal bounding sphere with Welzl's algorithm, in expected linear time.
+    /// Exact up to floating point tolerance. Slower than Ritter's algorithm, since it
+    /// works on a shuffled copy of the positions.
+    ///
+    GN_API void calculateMinimalBoundingSphere( Spheref & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+
+    ///
+    /// Calculate oriented bounding box, with axes from principal component analysis of the
+    /// positions. Fall back to the axis aligned box, if that is smaller.
+    ///
+    GN_API void calculateOrientedBoundingBox( OrientedBoxf & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+
+    ///
+    /// Calculate k-DOP.
+    ///
+    GN_API void calculateDop( Dop8 & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+    GN_API void calculateDop( Dop14 & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+    GN_API void calculateDop( Dop18 & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+    GN_API void calculateDop( Dop26 & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+    //@}
+
+    ///
+    /// Calculate axis aligned bounding box. Uses SIMD instructions, when x, y and z are
+    /// adjacent floats of one vertex stream.
     ///
     GN_API void calculateBoundingBox(
         Boxf & result,
@@ -2615,6 +2914,92 @@ namespace GN
     /// Calculate axis aligned bounding box.
     ///
     GN_API void calculateBoundingBox( Boxf & result, const Vector3f * positions, size_t strideInBytes, size_t count );
+
+    /// \name Batch transformations
+    ///
+    /// Transform arrays of data by one matrix, using SIMD instructions when available.
+    /// Source and destination could be the same array, but must not partially overlap.
+    /// Strides are in bytes.
+    //@{
+
+    ///
+    /// Transform points, same as Matrix44f::transformPoint(): input is (x, y, z, 1),
+    /// result is divided by w, unless w is zero.
+    ///
+    GN_API void transformPoints( Vector3f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count );
+
+    ///
+    /// Transform packed points.
+    ///
+    inline void transformPoints( Vector3f * dst, const Matrix44f & m, const Vector3f * src, size_t count )
+    {
+        transformPoints( dst, sizeof(Vector3f), m, src, sizeof(Vector3f), count );
+    }
+
+    ///
+    /// Transform points to homogeneous space (e.g. clip space): input is (x, y, z, 1), no division by w.
+    ///
+    GN_API void transformPoints( Vector4f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count );
+
+    ///
+    /// Transform vectors, same as Matrix44f::transformVector(): input is (x, y, z, 0).
+    /// To transform normals, use invtrans of the desired matrix.
+    ///
+    GN_API void transformVectors( Vector3f * dst, size_t dstStride, const Matrix44f & m, const Vector3f * src, size_t srcStride, size_t count );
+
+    ///
+    /// Transform packed vectors.
+    ///
+    inline void transformVectors( Vector3f * dst, const Matrix44f & m, const Vector3f * src, size_t count )
+    {
+        transformVectors( dst, sizeof(Vector3f), m, src, sizeof(Vector3f), count );
+    }
+
+    ///
+    /// Transform packed 4D vectors: dst[i] = m * src[i]
+    ///
+    GN_API void transformVector4s( Vector4f * dst, const Matrix44f & m, const Vector4f * src, size_t count );
+
+    ///
+    /// Transform points stored in structure-of-arrays layout. Same rules as transformPoints().
+    ///
+    GN_API void transformPointsSoA(
+        float * dstX, float * dstY, float * dstZ,
+        const Matrix44f & m,
+        const float * srcX, const float * srcY, const float * srcZ,
+        size_t count );
+
+    ///
+    /// Transform vectors stored in structure-of-arrays layout. Same rules as transformVectors().
+    ///
+    GN_API void transformVectorsSoA(
+        float * dstX, float * dstY, float * dstZ,
+        const Matrix44f & m,
+        const float * srcX, const float * srcY, const float * srcZ,
+        size_t count );
+
+    ///
+    /// Transform axis aligned boxes. The result is the axis aligned bounding box of the
+    /// transformed source box. Source boxes with negative extents are handled as if normalized.
+    ///
+    GN_API void transformBoxes( Boxf * dst, const Matrix44f & m, const Boxf * src, size_t count );
+
+    ///
+    /// dst[i] = a[i] * b[i]
+    ///
+    GN_API void multiplyMatrices( Matrix44f * dst, const Matrix44f * a, const Matrix44f * b, size_t count );
+
+    ///
+    /// dst[i] = a * b[i]
+    ///
+    GN_API void multiplyMatrices( Matrix44f * dst, const Matrix44f & a, const Matrix44f * b, size_t count );
+
+    ///
+    /// dst[i] = a[i] * b
+    ///
+    GN_API void multiplyMatrices( Matrix44f * dst, const Matrix44f * a, const Matrix44f & b, size_t count );
+
+    //@}
 }
 
 // *****************************************************************************
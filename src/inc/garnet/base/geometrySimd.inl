@@ -0,0 +1,326 @@
+// *****************************************************************************
+// SIMD specializations of float geometry classes. Layout and interface are the
+// same as the generic templates; only the implementation differs.
+// *****************************************************************************
+
+#if GN_SIMD
+
+namespace GN
+{
+    // *************************************************************************
+    // Vector4f
+    // *************************************************************************
+
+    template<> inline Vector4<float> & Vector4<float>::operator += ( const Vector4<float> & v )
+    {
+        simd::store( &x, simd::add( simd::load( &x ), simd::load( &v.x ) ) );
+        return *this;
+    }
+
+    template<> inline Vector4<float> & Vector4<float>::operator -= ( const Vector4<float> & v )
+    {
+        simd::store( &x, simd::sub( simd::load( &x ), simd::load( &v.x ) ) );
+        return *this;
+    }
+
+    template<> inline Vector4<float> & Vector4<float>::operator *= ( float f )
+    {
+        simd::store( &x, simd::mul( simd::load( &x ), simd::splat( f ) ) );
+        return *this;
+    }
+
+    template<> inline Vector4<float> & Vector4<float>::operator *= ( const Vector4<float> & v )
+    {
+        simd::store( &x, simd::mul( simd::load( &x ), simd::load( &v.x ) ) );
+        return *this;
+    }
+
+    template<> inline float Vector4<float>::sDot( const Vector4<float> & v1, const Vector4<float> & v2 )
+    {
+        return simd::getX( simd::dot4( simd::load( &v1.x ), simd::load( &v2.x ) ) );
+    }
+
+    template<> inline void Vector4<float>::sNormalize( Vector4<float> & o, const Vector4<float> & i )
+    {
+        simd::Float4 v = simd::load( &i.x );
+        simd::Float4 l = simd::sqrt( simd::dot4( v, v ) );
+        if( simd::getX( l ) > 0.0f )
+        {
+            simd::store( &o.x, simd::div( v, l ) );
+        }
+        else
+        {
+            simd::store( &o.x, simd::zero() );
+        }
+    }
+
+    // *************************************************************************
+    // Matrix44f
+    // *************************************************************************
+
+    //
+    // Matrix multiply: row r of the result is sum( rows[r][k] * m[k] ).
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::operator *= ( const Matrix44<float> & m )
+    {
+#if GN_SIMD_AVX
+        // two rows per iteration
+        __m256 a01 = _mm256_loadu_ps( rows[0].data() );
+        __m256 a23 = _mm256_loadu_ps( rows[2].data() );
+        __m256 b0  = _mm256_broadcast_ps( (const __m128*)m[0].data() );
+        __m256 b1  = _mm256_broadcast_ps( (const __m128*)m[1].data() );
+        __m256 b2  = _mm256_broadcast_ps( (const __m128*)m[2].data() );
+        __m256 b3  = _mm256_broadcast_ps( (const __m128*)m[3].data() );
+
+#if GN_SIMD_FMA
+#define GN_MADD256( a, b, c ) _mm256_fmadd_ps( a, b, c )
+#else
+#define GN_MADD256( a, b, c ) _mm256_add_ps( _mm256_mul_ps( a, b ), c )
+#endif
+        __m256 t01 = _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, 0x00 ), b0 );
+        __m256 t23 = _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, 0x00 ), b0 );
+        t01 = GN_MADD256( _mm256_shuffle_ps( a01, a01, 0x55 ), b1, t01 );
+        t23 = GN_MADD256( _mm256_shuffle_ps( a23, a23, 0x55 ), b1, t23 );
+        t01 = GN_MADD256( _mm256_shuffle_ps( a01, a01, 0xAA ), b2, t01 );
+        t23 = GN_MADD256( _mm256_shuffle_ps( a23, a23, 0xAA ), b2, t23 );
+        t01 = GN_MADD256( _mm256_shuffle_ps( a01, a01, 0xFF ), b3, t01 );
+        t23 = GN_MADD256( _mm256_shuffle_ps( a23, a23, 0xFF ), b3, t23 );
+#undef GN_MADD256
+
+        _mm256_storeu_ps( rows[0].data(), t01 );
+        _mm256_storeu_ps( rows[2].data(), t23 );
+#else
+        simd::Float4 b0 = simd::load( m[0].data() );
+        simd::Float4 b1 = simd::load( m[1].data() );
+        simd::Float4 b2 = simd::load( m[2].data() );
+        simd::Float4 b3 = simd::load( m[3].data() );
+
+        // m could be *this, so load everything before the first store.
+        simd::Float4 a[4];
+        for( int r = 0; r < 4; ++r ) a[r] = simd::load( rows[r].data() );
+
+        for( int r = 0; r < 4; ++r )
+        {
+            simd::Float4 t = simd::mul( simd::lane<0>( a[r] ), b0 );
+            t = simd::madd( simd::lane<1>( a[r] ), b1, t );
+            t = simd::madd( simd::lane<2>( a[r] ), b2, t );
+            t = simd::madd( simd::lane<3>( a[r] ), b3, t );
+            simd::store( rows[r].data(), t );
+        }
+#endif
+        return *this;
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::transpose()
+    {
+        simd::Float4 r0 = simd::load( rows[0].data() );
+        simd::Float4 r1 = simd::load( rows[1].data() );
+        simd::Float4 r2 = simd::load( rows[2].data() );
+        simd::Float4 r3 = simd::load( rows[3].data() );
+        simd::transpose( r0, r1, r2, r3 );
+        simd::store( rows[0].data(), r0 );
+        simd::store( rows[1].data(), r1 );
+        simd::store( rows[2].data(), r2 );
+        simd::store( rows[3].data(), r3 );
+        return *this;
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    template<> inline void Matrix44<float>::transform( Vector4<float> & dst, const Vector4<float> & src ) const
+    {
+        simd::store( dst.data(), simd::transformByRows(
+            simd::load( rows[0].data() ),
+            simd::load( rows[1].data() ),
+            simd::load( rows[2].data() ),
+            simd::load( rows[3].data() ),
+            simd::load( src.data() ) ) );
+    }
+
+    //
+    // Invert with cofactors. The 2x2 sub-determinants of the upper two rows (s)
+    // and the lower two rows (c) are computed 4 at a time, then each row of the
+    // adjugate is 3 multiply-adds of a signed, swizzled column by [c,c,s,s].
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::inverse()
+    {
+        using namespace simd;
+
+        Float4 r0 = load( rows[0].data() );
+        Float4 r1 = load( rows[1].data() );
+        Float4 r2 = load( rows[2].data() );
+        Float4 r3 = load( rows[3].data() );
+
+        // s0..s3 = a00a11-a10a01, a00a12-a10a02, a00a13-a10a03, a01a12-a11a02
+        // s4..s5 = a01a13-a11a03, a02a13-a12a03. Same for c, from row 2 and 3.
+        Float4 s0123 = nmadd( shuffle<0,0,0,1>( r1 ), shuffle<1,2,3,2>( r0 ), mul( shuffle<0,0,0,1>( r0 ), shuffle<1,2,3,2>( r1 ) ) );
+        Float4 s45   = nmadd( shuffle<1,2,1,2>( r1 ), shuffle<3,3,3,3>( r0 ), mul( shuffle<1,2,1,2>( r0 ), shuffle<3,3,3,3>( r1 ) ) );
+        Float4 c0123 = nmadd( shuffle<0,0,0,1>( r3 ), shuffle<1,2,3,2>( r2 ), mul( shuffle<0,0,0,1>( r2 ), shuffle<1,2,3,2>( r3 ) ) );
+        Float4 c45   = nmadd( shuffle<1,2,1,2>( r3 ), shuffle<3,3,3,3>( r2 ), mul( shuffle<1,2,1,2>( r2 ), shuffle<3,3,3,3>( r3 ) ) );
+
+        // [c_n, c_n, s_n, s_n]
+        Float4 k0 = shuffle<0,0,0,0>( c0123, s0123 );
+        Float4 k1 = shuffle<1,1,1,1>( c0123, s0123 );
+        Float4 k2 = shuffle<2,2,2,2>( c0123, s0123 );
+        Float4 k3 = shuffle<3,3,3,3>( c0123, s0123 );
+        Float4 k4 = shuffle<0,0,0,0>( c45, s45 );
+        Float4 k5 = shuffle<1,1,1,1>( c45, s45 );
+
+        // det = s0c5 - s1c4 + s2c3 + s3c2 - s4c1 + s5c0
+        Float4 det = dot4( s0123, mul( shuffle<1,0,3,2>( c45, c0123 ), simd::set( 1.0f, -1.0f, 1.0f, 1.0f ) ) );
+        det = add( det, dot4( s45, mul( shuffle<1,0,0,0>( c0123, c0123 ), simd::set( -1.0f, 1.0f, 0.0f, 0.0f ) ) ) );
+        if( 0.0f == getX( det ) )
+        {
+            // Uninvertible matrix is rare used in 3D graphics, and usually
+            // means error. So we output a warning message here.
+            static Logger * logger = getLogger("GN.base.Matrix44");
+            GN_WARN(logger)( "Matrix is un-invertable!" );
+            return identity();
+        }
+
+        // v_j = [ a1j, -a0j, a3j, -a2j ]
+        Float4 sign = simd::set( 1.0f, -1.0f, 1.0f, -1.0f );
+        simd::transpose( r0, r1, r2, r3 );
+        Float4 v0 = mul( shuffle<1,0,3,2>( r0 ), sign );
+        Float4 v1 = mul( shuffle<1,0,3,2>( r1 ), sign );
+        Float4 v2 = mul( shuffle<1,0,3,2>( r2 ), sign );
+        Float4 v3 = mul( shuffle<1,0,3,2>( r3 ), sign );
+
+        Float4 invdet = div( splat( 1.0f ), det );
+
+        store( rows[0].data(), mul( madd( v3, k3, nmadd( v2, k4, mul( v1, k5 ) ) ), invdet ) );
+        store( rows[1].data(), mul( nmadd( v3, k1, madd( v2, k2, neg( mul( v0, k5 ) ) ) ), invdet ) );
+        store( rows[2].data(), mul( madd( v3, k0, nmadd( v1, k2, mul( v0, k4 ) ) ), invdet ) );
+        store( rows[3].data(), mul( nmadd( v2, k0, madd( v1, k1, neg( mul( v0, k3 ) ) ) ), invdet ) );
+
+        return *this;
+    }
+
+    namespace detail
+    {
+        //
+        // x0, x1, x2 are columns of the 3x3 inverse, with w = 0. The translation
+        // column is -(x0 * t.x + x1 * t.y + x2 * t.z); then transpose to rows.
+        // ---------------------------------------------------------------------
+        inline void storeAffineInverse( Matrix44<float> & m, simd::Float4 x0, simd::Float4 x1, simd::Float4 x2 )
+        {
+            using namespace simd;
+            Float4 x3 = neg( madd( x2, splat( m[2][3] ), madd( x1, splat( m[1][3] ), mul( x0, splat( m[0][3] ) ) ) ) );
+            simd::transpose( x0, x1, x2, x3 );
+            store( m[0].data(), x0 );
+            store( m[1].data(), x1 );
+            store( m[2].data(), x2 );
+            store( m[3].data(), simd::set( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        }
+    }
+
+    //
+    // Columns of the 3x3 inverse are cross products of the rows, divided by determinant.
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::invertAffine()
+    {
+        using namespace simd;
+
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        Float4 r0 = clearW( load( rows[0].data() ) );
+        Float4 r1 = clearW( load( rows[1].data() ) );
+        Float4 r2 = clearW( load( rows[2].data() ) );
+
+        Float4 x0 = cross3( r1, r2 );
+        Float4 det = dot4( r0, x0 );
+        if( 0.0f == getX( det ) )
+        {
+            GN_WARN(detail::matrixLogger())( "Matrix is un-invertable!" );
+            return identity();
+        }
+        Float4 k = div( splat( 1.0f ), det );
+
+        detail::storeAffineInverse( *this, mul( x0, k ), mul( cross3( r2, r0 ), k ), mul( cross3( r0, r1 ), k ) );
+        return *this;
+    }
+
+    //
+    // Columns of the 3x3 inverse are rows of the rotation.
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::invertRigid()
+    {
+        using namespace simd;
+
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        detail::storeAffineInverse( *this,
+            clearW( load( rows[0].data() ) ),
+            clearW( load( rows[1].data() ) ),
+            clearW( load( rows[2].data() ) ) );
+        return *this;
+    }
+
+    //
+    // Same as invertRigid(), with each column divided by the squared scale,
+    // which is the squared length of the column of the original matrix.
+    // -------------------------------------------------------------------------
+    template<> inline Matrix44<float> & Matrix44<float>::invertTRS()
+    {
+        using namespace simd;
+
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        Float4 r0 = clearW( load( rows[0].data() ) );
+        Float4 r1 = clearW( load( rows[1].data() ) );
+        Float4 r2 = clearW( load( rows[2].data() ) );
+
+        // w is set to 1 to avoid 0/0.
+        Float4 lengthSquared = madd( r2, r2, madd( r1, r1, madd( r0, r0, simd::set( 0.0f, 0.0f, 0.0f, 1.0f ) ) ) );
+        float ls[4];
+        store( ls, lengthSquared );
+        if( 0.0f == ls[0] || 0.0f == ls[1] || 0.0f == ls[2] )
+        {
+            GN_WARN(detail::matrixLogger())( "Matrix is un-invertable!" );
+            return identity();
+        }
+        Float4 k = div( splat( 1.0f ), lengthSquared );
+
+        detail::storeAffineInverse( *this, mul( r0, k ), mul( r1, k ), mul( r2, k ) );
+        return *this;
+    }
+
+    // *************************************************************************
+    // Quaternionf
+    // *************************************************************************
+
+    //
+    // [x,y,z,w] = w1*q2 + x1*[w2,-z2,y2,-x2] + y1*[z2,w2,-x2,-y2] + z1*[-y2,x2,w2,-z2]
+    // -------------------------------------------------------------------------
+    template<> inline void Quaternion<float>::sMultiply( Quaternion<float> & dst, const Quaternion<float> & q1, const Quaternion<float> & q2 )
+    {
+        using namespace simd;
+
+        Float4 a = load( &q1.v.x );
+        Float4 b = load( &q2.v.x );
+
+        Float4 r = mul( lane<3>( a ), b );
+        r = madd( lane<0>( a ), mul( shuffle<3,2,1,0>( b ), simd::set(  1.0f, -1.0f,  1.0f, -1.0f ) ), r );
+        r = madd( lane<1>( a ), mul( shuffle<2,3,0,1>( b ), simd::set(  1.0f,  1.0f, -1.0f, -1.0f ) ), r );
+        r = madd( lane<2>( a ), mul( shuffle<1,0,3,2>( b ), simd::set( -1.0f,  1.0f,  1.0f, -1.0f ) ), r );
+
+        store( &dst.v.x, r );
+    }
+
+    //
+    //
+    // -------------------------------------------------------------------------
+    template<> inline Quaternion<float> & Quaternion<float>::normalize()
+    {
+        simd::Float4 q = simd::load( &v.x );
+        simd::Float4 n = simd::sqrt( simd::dot4( q, q ) );
+        simd::store( &v.x, simd::getX( n ) > 0.0f ? simd::div( q, n ) : simd::zero() );
+        return *this;
+    }
+}
+
+#endif // GN_SIMD
@@ -0,0 +1,174 @@
+#ifndef __GN_BASE_JOBS_H__
+#define __GN_BASE_JOBS_H__
+// *****************************************************************************
+/// \file
+/// \brief   Work-stealing job system with job dependencies
+// *****************************************************************************
+
+#include <functional>
+
+namespace GN
+{
+    ///
+    /// A unit of work scheduled by JobSystem. Referenced through JobHandle.
+    ///
+    class Job : public RefCounter
+    {
+    public:
+
+        ///
+        /// Return true if the job function has returned.
+        ///
+        virtual bool isDone() const = 0;
+
+    protected:
+
+        Job() {}
+        virtual ~Job() {}
+    };
+
+    ///
+    /// Reference counted handle of a job.
+    ///
+    typedef AutoRef<Job> JobHandle;
+
+    ///
+    /// Job function
+    ///
+    typedef std::function<void()> JobFunc;
+
+    ///
+    /// Range function used by JobSystem::parallelFor(). Process elements in [begin, end).
+    ///
+    typedef std::function<void(size_t begin, size_t end)> JobRangeFunc;
+
+    ///
+    /// Job system: a pool of worker threads, each with its own job deque. Workers run jobs
+    /// from their own deque in LIFO order, and steal from other workers in FIFO order when
+    /// run out of work.
+    ///
+    /// Typical usage:
+    ///
+    ///     JobSystem & js = JobSystem::sGetGlobalInstance();
+    ///     JobHandle a = js.run( "load mesh", []{ ... } );
+    ///     JobHandle b = js.run( "load texture", []{ ... } );
+    ///     JobHandle deps[] = { a, b };
+    ///     JobHandle c = js.run( "create model", []{ ... }, deps, 2 ); // run after a and b
+    ///     js.runOnMainThread( "upload", []{ ... }, &c, 1 ); // run in processMainThreadJobs() after c
+    ///     js.wait( c );
+    ///
+    /// Named jobs are timed by the profiler (using the name as timer name), when profiler is on.
+    /// Timers are looked up by address of the name, so names must be static strings, like
+    /// string literals.
+    ///
+    class GN_API JobSystem : public NoCopy
+    {
+    public:
+
+        ///
+        /// Create job system with specific number of worker threads. 0 means one less than
+        /// number of hardware threads, since the main thread usually has its own work.
+        /// The calling thread becomes the main thread of this job system.
+        ///
+        explicit JobSystem( uint32 numWorkers = 0 );
+
+        ///
+        /// Wait for all pending jobs, then stop worker threads.
+        ///
+        ~JobSystem();
+
+        ///
+        /// The global job system, created on first call. The first caller is the main thread.
+        ///
+        static JobSystem & sGetGlobalInstance();
+
+        ///
+        /// Return number of worker threads.
+        ///
+        uint32 getWorkerCount() const;
+
+        ///
+        /// Return true if called on main thread of this job system.
+        ///
+        bool isMainThread() const;
+
+        /// \name create and schedule jobs
+        //@{
+
+        ///
+        /// Create a job without scheduling it. Call addDependency() to set up the task
+        /// graph, then submit() to schedule it. Name is optional and must be a static string.
+        ///
+        JobHandle create( const char * name, JobFunc func, bool mainThreadOnly = false );
+
+        ///
+        /// Make job wait for another job. Must be called before the job is submitted.
+        ///
+        void addDependency( const JobHandle & job, const JobHandle & dependsOn );
+
+        ///
+        /// Schedule a created job. The job runs as soon as all its dependencies are done.
+        ///
+        void submit( const JobHandle & job );
+
+        ///
+        /// Create and submit a job that runs after all the dependencies are done.
+        ///
+        JobHandle run( const char * name, JobFunc func, const JobHandle * dependencies = NULL, size_t numDependencies = 0 );
+
+        ///
+        /// Create and submit a job that runs after the previous job is done.
+        ///
+        JobHandle continueWith( const JobHandle & previous, const char * name, JobFunc func )
+        {
+            return run( name, func, &previous, 1 );
+        }
+
+        ///
+        /// Create and submit a job that runs only on the main thread, inside processMainThreadJobs()
+        /// or wait(). Used for work that is bound to main thread, like GPU resource creation.
+        ///
+        JobHandle runOnMainThread( const char * name, JobFunc func, const JobHandle * dependencies = NULL, size_t numDependencies = 0 );
+
+        //@}
+
+        /// \name wait for jobs
+        //@{
+
+        ///
+        /// Wait for a job to finish. The calling thread runs other jobs while waiting.
+        ///
+        void wait( const JobHandle & job );
+
+        ///
+        /// Wait for all submitted jobs to finish, including jobs that are waiting for dependencies.
+        ///
+        void waitAll();
+
+        ///
+        /// Run jobs queued by runOnMainThread(). Must be called on main thread, usually once
+        /// per frame. Return number of jobs executed.
+        ///
+        size_t processMainThreadJobs();
+
+        //@}
+
+        ///
+        /// Call func on sub-ranges of [begin, end) in parallel, and wait for all of them.
+        /// Ranges are split recursively until no larger than grainSize, so idle workers
+        /// could steal the other halves. Grain size 0 means choose automatically based on
+        /// range size and number of workers.
+        ///
+        void parallelFor( size_t begin, size_t end, const JobRangeFunc & func, size_t grainSize = 0, const char * name = NULL );
+
+    private:
+
+        class Impl;
+        Impl * mImpl;
+    };
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_JOBS_H__
@@ -189,6 +189,9 @@ namespace GN
         ///
         /// Log message receiver
         ///
+        /// Note: when asynchronous logging is enabled, receivers are called from the
+        /// background log writer thread.
+        ///
         struct Receiver
         {
             ///
@@ -318,6 +321,28 @@ namespace GN
     ///
     inline Logger * getRootLogger() { return getLogger( 0 ); }
 
+    ///
+    /// Enable or disable asynchronous logging.
+    ///
+    /// When enabled, log messages are formatted on the calling thread, queued to a lock-free
+    /// ring buffer, then delivered to receivers by a background writer thread. FATAL messages
+    /// are always delivered synchronously, after everything queued before them. Queued
+    /// messages are flushed on crash signals (unhandled exceptions on Windows).
+    ///
+    /// Setting environment variable GN_LOG_ASYNC to 1 enables asynchronous logging at startup.
+    ///
+    GN_API void setLogAsync( bool );
+
+    ///
+    /// Is asynchronous logging enabled?
+    ///
+    GN_API bool isLogAsync();
+
+    ///
+    /// Block until all queued log messages are delivered to receivers.
+    ///
+    GN_API void flushLog();
+
     //@}
 } // end of namespace GN
 
@@ -93,7 +93,7 @@ namespace GN
             return (n + 1) >> 1;
         }
 
-#if GN_X64
+#if GN_X64 || GN_ARM64
 
         ///
         /// 返回不小于n的最小的2的整幂
@@ -395,6 +395,110 @@
         return *this;
     }
 
+    namespace detail
+    {
+        //
+        // Store [ a | -a*t ] to m, where a is the 3x3 inverse and t is the
+        // translation of the original affine matrix.
+        // ---------------------------------------------------------------------
+        template < typename T >
+        inline void storeAffineInverse( Matrix44<T> & m, const T a[3][3] )
+        {
+            T t0 = m[0][3], t1 = m[1][3], t2 = m[2][3];
+            for( int r = 0; r < 3; ++r )
+            {
+                m[r][0] = a[r][0];
+                m[r][1] = a[r][1];
+                m[r][2] = a[r][2];
+                m[r][3] = -( a[r][0] * t0 + a[r][1] * t1 + a[r][2] * t2 );
+            }
+            m[3].set( 0, 0, 0, 1 );
+        }
+
+        inline Logger * matrixLogger()
+        {
+            static Logger * logger = getLogger("GN.base.Matrix44");
+            return logger;
+        }
+    }
+
+    //
+    // Invert the upper 3x3 with cofactors, then the translation.
+    // -------------------------------------------------------------------------
+    template < typename T >
+    Matrix44<T> & Matrix44<T>::invertAffine()
+    {
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        const Matrix44<T> & m = *this;
+
+        // a[r][c] = cofactor[c][r]
+        T a[3][3];
+        a[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+        a[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+        a[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+        T det = m[0][0] * a[0][0] + m[0][1] * a[1][0] + m[0][2] * a[2][0];
+        if( 0 == det )
+        {
+            GN_WARN(detail::matrixLogger())( "Matrix is un-invertable!" );
+            return identity();
+        }
+        T k = (T)1 / det;
+
+        a[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+        a[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+        a[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+        a[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+        a[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+        a[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+        for( int r = 0; r < 3; ++r ) for( int c = 0; c < 3; ++c ) a[r][c] *= k;
+
+        detail::storeAffineInverse( *this, a );
+        return *this;
+    }
+
+    //
+    // Inverse of rotation is its transpose.
+    // -------------------------------------------------------------------------
+    template < typename T >
+    Matrix44<T> & Matrix44<T>::invertRigid()
+    {
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        T a[3][3];
+        for( int r = 0; r < 3; ++r ) for( int c = 0; c < 3; ++c ) a[r][c] = rows[c][r];
+
+        detail::storeAffineInverse( *this, a );
+        return *this;
+    }
+
+    //
+    // Upper 3x3 is R*S, which columns are orthogonal. So the inverse S^-1 * R^T
+    // is the transpose, with each row divided by squared length of the column.
+    // -------------------------------------------------------------------------
+    template < typename T >
+    Matrix44<T> & Matrix44<T>::invertTRS()
+    {
+        GN_ASSERT( 0 == rows[3][0] && 0 == rows[3][1] && 0 == rows[3][2] && 1 == rows[3][3] );
+
+        T a[3][3];
+        for( int r = 0; r < 3; ++r )
+        {
+            T lengthSquared = rows[0][r] * rows[0][r] + rows[1][r] * rows[1][r] + rows[2][r] * rows[2][r];
+            if( 0 == lengthSquared )
+            {
+                GN_WARN(detail::matrixLogger())( "Matrix is un-invertable!" );
+                return identity();
+            }
+            T k = (T)1 / lengthSquared;
+            for( int c = 0; c < 3; ++c ) a[r][c] = rows[c][r] * k;
+        }
+
+        detail::storeAffineInverse( *this, a );
+        return *this;
+    }
+
     //
     // generate a rotate matrix by X-axis, angle is in radians
     // -------------------------------------------------------------------------
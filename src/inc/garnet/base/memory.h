@@ -44,6 +44,32 @@ namespace GN
         /// Free heap-allocated memory (aligned or unaligned). Can cross DLL boundary.
         ///
         GN_API void dealloc( void * ptr );
+
+        ///
+        /// Heap allocation statistics of the functions above.
+        ///
+        struct Statistics
+        {
+            uint64 allocCount;   ///< number of alloc() and alignedAlloc() calls
+            uint64 reallocCount; ///< number of realloc() and alignedRealloc() calls
+            uint64 freeCount;    ///< number of dealloc() calls with non-NULL pointer
+            uint64 allocBytes;   ///< total bytes requested by alloc and realloc calls
+        };
+
+        ///
+        /// Enable/disable collecting of heap allocation statistics. Disabled by default.
+        ///
+        GN_API void enableStatistics( bool enabled );
+
+        ///
+        /// Get current heap allocation statistics.
+        ///
+        GN_API void getStatistics( Statistics & );
+
+        ///
+        /// Reset heap allocation statistics to zero.
+        ///
+        GN_API void resetStatistics();
     }
 }
 
@@ -0,0 +1,172 @@
+#ifndef __GN_BASE_OCCLUSION_H__
+#define __GN_BASE_OCCLUSION_H__
+// *****************************************************************************
+/// \file
+/// \brief   CPU software occlusion culling
+// *****************************************************************************
+
+namespace GN
+{
+    class JobSystem;
+
+    ///
+    /// Software depth buffer for occlusion culling on CPU.
+    ///
+    /// Occluder triangles are transformed, clipped against the near plane, and binned into
+    /// screen bins of BIN_SIZE x BIN_SIZE pixels by addOccluder(). render() then rasterizes
+    /// the bins, optionally in parallel, and builds a hierarchical depth buffer, which holds
+    /// the farthest depth of each BLOCK_SIZE x BLOCK_SIZE block. Occludees are tested against
+    /// the hierarchical depth first, and against the full resolution depth only on blocks
+    /// that are not fully in front of them.
+    ///
+    /// Triangles of a bin are rendered front to back, and skipped when all blocks they touch
+    /// are already nearer. Each pixel keeps the nearest depth of all triangles covering its
+    /// center. Neither depends on the order of bins, so the depth buffer is identical no
+    /// matter how many threads render it.
+    ///
+    /// Matrices transform from object space to D3D style clip space (depth in [0, w]),
+    /// with column vectors, like the ones Frustum::fromMatrix() takes.
+    ///
+    /// Typical usage, once per frame:
+    ///
+    ///     ob.clear();
+    ///     for each occluder: ob.addOccluder( proj * view * world, ... );
+    ///     ob.render( js );
+    ///     n = ob.testBoxes( visible, proj * view, boxes, count );
+    ///
+    class GN_API OcclusionBuffer : public NoCopy
+    {
+    public:
+
+        enum
+        {
+            BIN_SIZE   = 64, ///< width and height of screen bins, that are rendered in parallel
+            BLOCK_SIZE = 8,  ///< width and height of hierarchical depth blocks
+        };
+
+        ///
+        /// ctor
+        ///
+        OcclusionBuffer();
+
+        ///
+        /// dtor
+        ///
+        ~OcclusionBuffer();
+
+        ///
+        /// Set buffer size. Width and height are rounded up to multiple of BLOCK_SIZE.
+        /// Also clears the buffer.
+        ///
+        bool init( uint32 width, uint32 height );
+
+        ///
+        /// buffer width in pixels
+        ///
+        uint32 getWidth() const { return mWidth; }
+
+        ///
+        /// buffer height in pixels
+        ///
+        uint32 getHeight() const { return mHeight; }
+
+        ///
+        /// Reset depth to 1 (far plane), and drop all binned triangles.
+        ///
+        void clear();
+
+        ///
+        /// Add an indexed triangle list. Triangles are rendered regardless of winding order.
+        /// NULL indices means a non-indexed list.
+        ///
+        void addOccluder(
+            const Matrix44f & clipFromObject,
+            const Vector3f  * positions,
+            size_t            strideInBytes,
+            size_t            numVertices,
+            const uint32    * indices,
+            size_t            numIndices );
+
+        ///
+        /// Add an indexed triangle list with 16-bit indices.
+        ///
+        void addOccluder(
+            const Matrix44f & clipFromObject,
+            const Vector3f  * positions,
+            size_t            strideInBytes,
+            size_t            numVertices,
+            const uint16    * indices,
+            size_t            numIndices );
+
+        ///
+        /// Rasterize binned triangles, and update the hierarchical depth buffer.
+        ///
+        void render();
+
+        ///
+        /// Rasterize binned triangles with worker threads of the job system, one bin per job.
+        ///
+        void render( JobSystem & js );
+
+        ///
+        /// Return false, if the box is completely hidden behind rendered occluders, or
+        /// completely outside of the screen. Boxes crossing the near plane are visible.
+        ///
+        bool testBox( const Matrix44f & clipFromObject, const Boxf & box ) const;
+
+        ///
+        /// Test array of boxes. Indices of visible boxes are written to "visible" in ascending
+        /// order, which must have room for "count" indices. Return number of visible boxes.
+        ///
+        size_t testBoxes( uint32 * visible, const Matrix44f & clipFromWorld, const Boxf * boxes, size_t count ) const;
+
+        ///
+        /// Get full resolution depth buffer: getWidth() * getHeight() floats, top row first.
+        ///
+        const float * getDepth() const { return mDepth.rawptr(); }
+
+        ///
+        /// Get hierarchical depth buffer: farthest depth of each block, top row first.
+        ///
+        const float * getBlockDepth() const { return mBlockDepth.rawptr(); }
+
+        ///
+        /// Return number of triangles binned since last clear(), after clipping.
+        ///
+        size_t getTriangleCount() const { return mTriangles.size(); }
+
+    private:
+
+        /// screen space triangle, ready for rasterization
+        struct Triangle
+        {
+            float  edges[3][3]; ///< edge functions a * x + b * y + c, positive inside
+            float  z[3];        ///< depth plane z = a * x + b * y + c
+            float  minZ;        ///< nearest depth
+            sint32  minX, minY;  ///< pixel bounds, inclusive
+            sint32  maxX, maxY;
+        };
+
+        uint32                        mWidth;
+        uint32                        mHeight;
+        uint32                        mBinsX;
+        uint32                        mBinsY;
+        DynaArray<float>              mDepth;
+        DynaArray<float>              mBlockDepth;
+        DynaArray<Triangle>           mTriangles;
+        DynaArray<DynaArray<uint32> > mBins;
+        DynaArray<Vector4f>           mClipVertices; ///< scratch buffer of addOccluder()
+
+        template<typename INDEX>
+        void addTriangles( const Matrix44f &, const Vector3f *, size_t, size_t, const INDEX *, size_t );
+        void addTriangle( const Vector4f * clip );
+        void binTriangle( const Vector3f * screen );
+        void renderBin( size_t bin );
+        void updateBlockDepth( size_t bin );
+    };
+}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_OCCLUSION_H__
@@ -39,6 +39,21 @@
 ///
 #define GN_FUNCTION_PROFILER() GN_SCOPE_PROFILER(_LINE__, GN_FUNCTION)
 
+///
+/// count elements processed by a previously defined profile timer, for per-element statistics
+///
+#define GN_PROFILER_ADD_ELEMENTS( name, count ) if(0) {} else GN_JOIN(__GN_profiler_,name).addElements( count )
+
+///
+/// mark frame boundary
+///
+#define GN_PROFILER_NEXT_FRAME() GN::ProfilerManager::sGetGlobalInstance().nextFrame()
+
+///
+/// name the calling thread in profile reports
+///
+#define GN_PROFILER_THREAD_NAME( name ) GN::ProfilerManager::sGetGlobalInstance().setThreadName( name )
+
 #else
 
 #define GN_DEFINE_STATIC_PROFILER( name, desc )
@@ -46,31 +61,149 @@
 #define GN_STOP_PROFILER( name )
 #define GN_SCOPE_PROFILER( name, desc )
 #define GN_FUNCTION_PROFILER()
+#define GN_PROFILER_ADD_ELEMENTS( name, count )
+#define GN_PROFILER_NEXT_FRAME()
+#define GN_PROFILER_THREAD_NAME( name )
 
 #endif
 //@}
 
 namespace GN
 {
+    ///
+    /// Profiler working mode
+    ///
+    enum ProfilerMode
+    {
+        PM_OFF,          ///< timers do nothing.
+        PM_LOW_OVERHEAD, ///< Per-thread flat statistics only. No call tree. Recursive use of same timer is not supported.
+        PM_FULL,         ///< Per-thread begin/end event timelines, aggregated into call trees.
+    };
+
+    ///
+    /// Hardware performance counters (see ProfilerManager::sEnableHardwareCounters())
+    ///
+    enum ProfileCounter
+    {
+        PC_CYCLES,
+        PC_INSTRUCTIONS,
+        PC_CACHE_MISSES,
+        PC_BRANCH_MISSES,
+        PC_COUNT,
+    };
+
+    ///
+    /// Timeline trace capturing mode. Trace events are only generated in PM_FULL mode.
+    ///
+    enum TraceMode
+    {
+        TM_OFF,             ///< no trace capturing.
+        TM_RECORD,          ///< keep all events since startTrace(), up to a fixed event budget.
+        TM_FLIGHT_RECORDER, ///< keep events of last N seconds only.
+    };
+
+    ///
+    /// Trace file format
+    ///
+    enum TraceFormat
+    {
+        TF_CHROME_JSON, ///< Chrome Trace Event JSON, for chrome://tracing and ui.perfetto.dev
+        TF_PERFETTO,    ///< Perfetto protobuf trace, for ui.perfetto.dev
+    };
+
+    ///
+    /// HDR-style latency histogram with log-bucketed values.
+    ///
+    /// Values are recorded in nanoseconds. Each power-of-2 range is split into
+    /// SUB_BUCKET_COUNT linear buckets, giving about 3% relative precision from 1ns to
+    /// 2^47ns (~39 hours). Recording is O(1) and never allocates. Histograms with the
+    /// same layout can be merged.
+    ///
+    class GN_API ProfileHistogram
+    {
+    public:
+
+        enum
+        {
+            SUB_BUCKET_BITS  = 5,
+            SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+            MAX_VALUE_BITS   = 47,
+            BUCKET_COUNT     = ( MAX_VALUE_BITS - SUB_BUCKET_BITS + 1 ) * SUB_BUCKET_COUNT,
+        };
+
+        /// ctor
+        ProfileHistogram() { clear(); }
+
+        /// clear all samples
+        void clear();
+
+        /// record one sample, in nanoseconds. Values out of range are clamped.
+        void record( uint64 nanoseconds );
+
+        /// merge samples of another histogram into this one.
+        void merge( const ProfileHistogram & );
+
+        /// number of samples
+        uint64 getCount() const { return mCount; }
+
+        ///
+        /// Get value at percentile (0-100), in seconds. Return 0 if the histogram is empty.
+        ///
+        double getPercentile( double percentile ) const;
+
+        /// \name bucket layout
+        //@{
+        static size_t sGetBucketIndex( uint64 nanoseconds );
+        static uint64 sGetBucketLowerBound( size_t index );
+        static uint64 sGetBucketWidth( size_t index );
+        //@}
+
+    private:
+
+        uint64 mCount;
+        uint64 mBuckets[BUCKET_COUNT];
+    };
+
+    ///
+    /// Histogram range of ProfileTimer
+    ///
+    enum ProfileHistogramRange
+    {
+        PHR_TOTAL,       ///< all samples since last ProfilerManager::reset()
+        PHR_LAST_WINDOW, ///< samples of last complete rolling window (see ProfilerManager::setHistogramWindow())
+    };
+
     ///
     /// profile timer
     ///
+    /// Timers can be started and stopped from any thread. Start/stop only writes into
+    /// buffers owned by the calling thread, statistics are aggregated later (see
+    /// ProfilerManager::aggregate()). Latency histograms are only collected in PM_FULL mode.
+    ///
     class GN_API ProfileTimer
     {
-        Clock & clock;
+        const char * mName;
+        uint32       mId;
 
-        size_t  count;
+        // aggregated statistics, in seconds.
+        uint64       mCount;
+        double       mSum, mMin, mMax;
 
-        double  timesum, timemin, timemax, timestart;
+        // latency histograms, created by the aggregator when first sample arrives.
+        struct Histograms;
+        Histograms * mHistograms;
 
-        void * impl;
+        // hardware counters and user counted elements
+        uint64              mCounters[PC_COUNT];
+        std::atomic<uint64> mElements;
 
         friend class ProfilerManager;
+        friend struct ProfilerCore;
 
     protected:
 
         /// ctor
-        ProfileTimer( Clock & c );
+        ProfileTimer( const char * name );
 
         /// dtor
         ~ProfileTimer();
@@ -86,12 +219,52 @@ namespace GN
         /// stop the timer
         ///
         void stop();
+
+        ///
+        /// Count elements processed by this timer, to get per-element statistics in report.
+        ///
+        void addElements( uint64 count ) { mElements.fetch_add( count, std::memory_order_relaxed ); }
+
+        /// \name aggregated statistics (call ProfilerManager::aggregate() to get latest value).
+        /// The aggregator may update them at any time. So each getter takes the profiler lock.
+        //@{
+        const char * getName() const { return mName; }
+        uint32       getId() const { return mId; }
+        uint64       getCount() const;
+        double       getSum() const;
+        double       getMin() const;
+        double       getMax() const;
+        double       getAverage() const;
+        uint64       getCounter( ProfileCounter c ) const;
+        double       getIpc() const;
+        uint64       getElements() const { return mElements.load( std::memory_order_relaxed ); }
+        //@}
+
+        ///
+        /// Get snapshot of latency histogram. Return false if there's no sample.
+        ///
+        bool getHistogram( ProfileHistogram & result, ProfileHistogramRange range = PHR_TOTAL ) const;
     };
 
     ///
-    /// Profiler Manager
+    /// Node of profile call tree.
     ///
-    /// \todo Make it thread-safe.
+    struct ProfileCallNode
+    {
+        const ProfileTimer * timer;     ///< NULL for thread root node.
+        const char         * name;      ///< timer name, or thread name for root node.
+        uint32               threadId;  ///< sequential thread id
+        size_t               depth;     ///< 0 for thread root node.
+        uint64               count;     ///< number of calls
+        double               inclusive; ///< total time, including children, in seconds.
+        double               exclusive; ///< total time, excluding children, in seconds.
+        double               min;       ///< min inclusive time of single call
+        double               max;       ///< max inclusive time of single call
+        uint64               counters[PC_COUNT]; ///< inclusive hardware counters
+    };
+
+    ///
+    /// Profiler Manager
     ///
     class GN_API ProfilerManager
     {
@@ -101,7 +274,7 @@ namespace GN
 
         //@{
     public:
-        ProfilerManager() {}
+        ProfilerManager();
         ~ProfilerManager();
         //@}
 
@@ -116,14 +289,10 @@ namespace GN
         static ProfilerManager & sGetGlobalInstance();
 
         ///
-        /// reset profiler, clear all timers
+        /// Reset profiler: clear statistics of all timers and call trees. Timers
+        /// themselves are kept, since static profilers hold references to them.
         ///
-        void reset()
-        {
-            std::lock_guard<SpinLoop> lock( mMutex );
-            mTimers.clear();
-            mClock.reset();
-        }
+        void reset();
 
         ///
         /// print profile result to string
@@ -138,19 +307,7 @@ namespace GN
         ///
         /// return a named timer
         ///
-        ProfileTimer & getTimer( const StrA & name )
-        {
-            GN_ASSERT( !name.empty() );
-
-            std::lock_guard<SpinLoop> lock( mMutex );
-
-            ProfilerTimerImpl * p = mTimers.find( name );
-            if( NULL != p ) return *p;
-
-            // create new timer
-            ProfilerTimerImpl newTimer( mClock );
-            return mTimers.insert( name, newTimer )->value;
-        }
+        ProfileTimer & getTimer( const StrA & name );
 
         ///
         /// start a profile timer
@@ -168,6 +325,96 @@ namespace GN
             getTimer(name).stop();
         }
 
+        ///
+        /// Drain per-thread buffers and update timer statistics and call trees. This is done
+        /// periodically by a background thread, call it explicitly to get up-to-date result.
+        ///
+        void aggregate() const;
+
+        ///
+        /// Get call trees of all threads in depth-first order.
+        ///
+        void getCallTree( DynaArray<ProfileCallNode> & ) const;
+
+        ///
+        /// Set length of rolling window of timer histograms. Default is 1 second.
+        ///
+        void setHistogramWindow( double seconds );
+
+        /// \name profiler mode
+        //@{
+        static void         sSetMode( ProfilerMode );
+        static ProfilerMode sGetMode();
+        //@}
+
+        ///
+        /// Mark frame boundary. Frame time statistics is reported as timer "Frame".
+        ///
+        void nextFrame();
+
+        ///
+        /// Get number of frames marked by nextFrame()
+        ///
+        uint64 getFrameCount() const;
+
+        /// \name timeline trace
+        //@{
+
+        ///
+        /// Start capturing begin/end events of all threads. Restarting clears captured events.
+        ///
+        void startTrace( TraceMode mode, double flightRecorderSeconds = 10.0 );
+
+        ///
+        /// Stop capturing. Captured events are kept until next startTrace().
+        ///
+        void stopTrace();
+
+        ///
+        /// Get current trace mode
+        ///
+        TraceMode getTraceMode() const;
+
+        ///
+        /// Write captured events to file. Events whose begin is not captured are skipped.
+        ///
+        bool saveTrace( File & file, TraceFormat format ) const;
+
+        ///
+        /// Write captured events to file.
+        ///
+        bool saveTrace( const StrA & filename, TraceFormat format ) const;
+
+        ///
+        /// Dump the trace automatically when a frame (see nextFrame()) takes longer
+        /// than the threshold. Dump file name is "<prefix><frame-number>.json" or
+        /// "<prefix><frame-number>.perfetto-trace". Set threshold to 0 to disable.
+        /// Usually used together with TM_FLIGHT_RECORDER.
+        ///
+        void setSlowFrameDump( double thresholdSeconds, const StrA & prefix, TraceFormat format = TF_CHROME_JSON );
+
+        //@}
+
+        ///
+        /// Enable hardware performance counters (Linux perf_event_open) on scopes in PM_FULL
+        /// mode. Counters are opened per thread. Return false if counters are not available
+        /// on this system, in which case timers keep working without counters. Could also be
+        /// enabled by setting environment variable GN_PROFILER_PERF=1.
+        ///
+        static bool sEnableHardwareCounters( bool enable );
+        static bool sIsHardwareCountersEnabled();
+
+        ///
+        /// Name the calling thread in profile reports.
+        ///
+        static void sSetThreadName( const char * name );
+        void setThreadName( const char * name ) { sSetThreadName( name ); }
+
+        ///
+        /// Measure average cost of one start/stop pair on the calling thread in current mode, in seconds.
+        ///
+        static double sMeasureScopeOverhead( size_t iterations = 10000 );
+
         // ********************************
         //   private variables
         // ********************************
@@ -175,15 +422,15 @@ namespace GN
 
         struct ProfilerTimerImpl : public ProfileTimer
         {
-            ProfilerTimerImpl( Clock & c ) : ProfileTimer( c ) {}
+            ProfilerTimerImpl( const char * name ) : ProfileTimer( name ) {}
             ~ProfilerTimerImpl() {}
         };
 
-        typedef StringMap<char,ProfilerTimerImpl> TimerMap;
+        typedef StringMap<char,ProfilerTimerImpl*> TimerMap;
 
-        Clock             mClock;
-        TimerMap          mTimers;
-        mutable SpinLoop  mMutex;
+        TimerMap                   mTimers;
+        mutable std::mutex         mMutex;
+        std::atomic<ProfileTimer*> mFrameTimer{ NULL }; ///< timer "Frame", cached by nextFrame()
 
         // ********************************
         //   private functions
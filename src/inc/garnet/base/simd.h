@@ -0,0 +1,327 @@
+#ifndef __GN_BASE_SIMD_H__
+#define __GN_BASE_SIMD_H__
+// *****************************************************************************
+/// \file
+/// \brief   Thin wrapper of 4-wide SIMD instructions (SSE/AVX on x86, NEON on arm64)
+// *****************************************************************************
+
+/// \def GN_SIMD_SSE    SSE2 is available (always true on x64)
+/// \def GN_SIMD_SSE4   SSE4.1 is available
+/// \def GN_SIMD_AVX    AVX is available
+/// \def GN_SIMD_FMA    fused multiply-add is available
+/// \def GN_SIMD_NEON   NEON is available (always true on arm64)
+/// \def GN_SIMD        Any of the above. If 0, float math classes use scalar code.
+
+#if GN_ENABLE_SIMD && ( GN_X64 || ( GN_X86 && ( defined(__SSE2__) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) ) ) )
+#define GN_SIMD_SSE 1
+#else
+#define GN_SIMD_SSE 0
+#endif
+
+#if GN_SIMD_SSE && defined(__AVX__)
+#define GN_SIMD_AVX 1
+#else
+#define GN_SIMD_AVX 0
+#endif
+
+#if GN_SIMD_SSE && ( defined(__SSE4_1__) || GN_SIMD_AVX )
+#define GN_SIMD_SSE4 1
+#else
+#define GN_SIMD_SSE4 0
+#endif
+
+#if GN_SIMD_SSE && ( defined(__FMA__) || defined(__AVX2__) )
+#define GN_SIMD_FMA 1
+#elif GN_ENABLE_SIMD && GN_ARM64
+#define GN_SIMD_FMA 1
+#else
+#define GN_SIMD_FMA 0
+#endif
+
+#if GN_ENABLE_SIMD && GN_ARM64
+#define GN_SIMD_NEON 1
+#else
+#define GN_SIMD_NEON 0
+#endif
+
+#define GN_SIMD ( GN_SIMD_SSE || GN_SIMD_NEON )
+
+#if GN_SIMD_SSE
+#include <immintrin.h>
+#elif GN_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if GN_SIMD
+
+namespace GN { namespace simd
+{
+    ///
+    /// Operations on 4 floats. Loads and stores are unaligned, so that they work on
+    /// Vector4f, Matrix44f and Quaternionf as they are laid out.
+    ///
+#if GN_SIMD_SSE
+    typedef __m128 Float4;
+
+    GN_FORCE_INLINE Float4 load( const float * p ) { return _mm_loadu_ps( p ); }
+    GN_FORCE_INLINE void   store( float * p, Float4 v ) { _mm_storeu_ps( p, v ); }
+    GN_FORCE_INLINE Float4 set( float x, float y, float z, float w ) { return _mm_setr_ps( x, y, z, w ); }
+    GN_FORCE_INLINE Float4 splat( float f ) { return _mm_set1_ps( f ); }
+    GN_FORCE_INLINE Float4 zero() { return _mm_setzero_ps(); }
+    GN_FORCE_INLINE float  getX( Float4 v ) { return _mm_cvtss_f32( v ); }
+
+    GN_FORCE_INLINE Float4 add( Float4 a, Float4 b ) { return _mm_add_ps( a, b ); }
+    GN_FORCE_INLINE Float4 sub( Float4 a, Float4 b ) { return _mm_sub_ps( a, b ); }
+    GN_FORCE_INLINE Float4 mul( Float4 a, Float4 b ) { return _mm_mul_ps( a, b ); }
+    GN_FORCE_INLINE Float4 div( Float4 a, Float4 b ) { return _mm_div_ps( a, b ); }
+    GN_FORCE_INLINE Float4 minimum( Float4 a, Float4 b ) { return _mm_min_ps( a, b ); }
+    GN_FORCE_INLINE Float4 maximum( Float4 a, Float4 b ) { return _mm_max_ps( a, b ); }
+    GN_FORCE_INLINE Float4 sqrt( Float4 v ) { return _mm_sqrt_ps( v ); }
+    GN_FORCE_INLINE Float4 abs( Float4 v ) { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), v ); }
+    GN_FORCE_INLINE Float4 neg( Float4 v ) { return _mm_xor_ps( _mm_set1_ps( -0.0f ), v ); }
+
+    /// [ v.x, v.y, v.z, 0 ]
+    GN_FORCE_INLINE Float4 clearW( Float4 v ) { return _mm_and_ps( v, _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) ) ); }
+
+    /// per-lane mask, all bits set where a == b.
+    GN_FORCE_INLINE Float4 cmpeq( Float4 a, Float4 b ) { return _mm_cmpeq_ps( a, b ); }
+
+    /// per-lane mask, all bits set where a < b.
+    GN_FORCE_INLINE Float4 cmplt( Float4 a, Float4 b ) { return _mm_cmplt_ps( a, b ); }
+
+    /// sign bits of the 4 lanes, packed into bit 0-3.
+    GN_FORCE_INLINE int    movemask( Float4 v ) { return _mm_movemask_ps( v ); }
+
+    /// mask ? a : b, per lane.
+    GN_FORCE_INLINE Float4 select( Float4 mask, Float4 a, Float4 b )
+    {
+#if GN_SIMD_SSE4
+        return _mm_blendv_ps( b, a, mask );
+#else
+        return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+#endif
+    }
+
+    /// a * b + c
+    GN_FORCE_INLINE Float4 madd( Float4 a, Float4 b, Float4 c )
+    {
+#if GN_SIMD_FMA
+        return _mm_fmadd_ps( a, b, c );
+#else
+        return _mm_add_ps( _mm_mul_ps( a, b ), c );
+#endif
+    }
+
+    /// c - a * b
+    GN_FORCE_INLINE Float4 nmadd( Float4 a, Float4 b, Float4 c )
+    {
+#if GN_SIMD_FMA
+        return _mm_fnmadd_ps( a, b, c );
+#else
+        return _mm_sub_ps( c, _mm_mul_ps( a, b ) );
+#endif
+    }
+
+    /// [ v[X], v[Y], v[Z], v[W] ]
+    template<int X, int Y, int Z, int W>
+    GN_FORCE_INLINE Float4 shuffle( Float4 v ) { return _mm_shuffle_ps( v, v, _MM_SHUFFLE( W, Z, Y, X ) ); }
+
+    /// [ a[X], a[Y], b[Z], b[W] ]
+    template<int X, int Y, int Z, int W>
+    GN_FORCE_INLINE Float4 shuffle( Float4 a, Float4 b ) { return _mm_shuffle_ps( a, b, _MM_SHUFFLE( W, Z, Y, X ) ); }
+
+    /// transpose 4x4 matrix, stored in 4 rows.
+    GN_FORCE_INLINE void transpose( Float4 & r0, Float4 & r1, Float4 & r2, Float4 & r3 )
+    {
+        _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    }
+
+    /// dot product, in all 4 lanes.
+    GN_FORCE_INLINE Float4 dot4( Float4 a, Float4 b )
+    {
+#if GN_SIMD_SSE4
+        return _mm_dp_ps( a, b, 0xFF );
+#else
+        Float4 m = _mm_mul_ps( a, b );
+        m = _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+#endif
+    }
+
+    ///
+    /// Operations on 4 32-bit integers, mostly for converting pixels to and from floats.
+    ///
+    typedef __m128i Int4;
+
+    GN_FORCE_INLINE Int4   loadInt( const void * p ) { return _mm_loadu_si128( (const __m128i*)p ); }
+    GN_FORCE_INLINE void   storeInt( void * p, Int4 v ) { _mm_storeu_si128( (__m128i*)p, v ); }
+    GN_FORCE_INLINE Int4   splatInt( int32_t i ) { return _mm_set1_epi32( i ); }
+    GN_FORCE_INLINE Int4   andInt( Int4 a, Int4 b ) { return _mm_and_si128( a, b ); }
+    GN_FORCE_INLINE Int4   orInt( Int4 a, Int4 b ) { return _mm_or_si128( a, b ); }
+
+    /// logical shift of each lane
+    template<int N> GN_FORCE_INLINE Int4 shiftLeft( Int4 v ) { return _mm_slli_epi32( v, N ); }
+    template<int N> GN_FORCE_INLINE Int4 shiftRight( Int4 v ) { return _mm_srli_epi32( v, N ); }
+
+    /// signed integers to floats
+    GN_FORCE_INLINE Float4 toFloat( Int4 v ) { return _mm_cvtepi32_ps( v ); }
+
+    /// floats to signed integers, rounded to nearest even
+    GN_FORCE_INLINE Int4   toInt( Float4 v ) { return _mm_cvtps_epi32( v ); }
+
+    /// zero extend 16 bytes to 4 x 4 integers: b0 gets byte 0-3, b1 gets byte 4-7, and so on.
+    GN_FORCE_INLINE void unpackBytes( Int4 v, Int4 & b0, Int4 & b1, Int4 & b2, Int4 & b3 )
+    {
+        __m128i z  = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi8( v, z );
+        __m128i hi = _mm_unpackhi_epi8( v, z );
+        b0 = _mm_unpacklo_epi16( lo, z );
+        b1 = _mm_unpackhi_epi16( lo, z );
+        b2 = _mm_unpacklo_epi16( hi, z );
+        b3 = _mm_unpackhi_epi16( hi, z );
+    }
+
+    /// inverse of unpackBytes(), saturating each lane to [0, 255].
+    GN_FORCE_INLINE Int4 packBytes( Int4 b0, Int4 b1, Int4 b2, Int4 b3 )
+    {
+        return _mm_packus_epi16( _mm_packs_epi32( b0, b1 ), _mm_packs_epi32( b2, b3 ) );
+    }
+
+#elif GN_SIMD_NEON
+    typedef float32x4_t Float4;
+
+    GN_FORCE_INLINE Float4 load( const float * p ) { return vld1q_f32( p ); }
+    GN_FORCE_INLINE void   store( float * p, Float4 v ) { vst1q_f32( p, v ); }
+    GN_FORCE_INLINE Float4 set( float x, float y, float z, float w ) { float f[4] = { x, y, z, w }; return vld1q_f32( f ); }
+    GN_FORCE_INLINE Float4 splat( float f ) { return vdupq_n_f32( f ); }
+    GN_FORCE_INLINE Float4 zero() { return vdupq_n_f32( 0.0f ); }
+    GN_FORCE_INLINE float  getX( Float4 v ) { return vgetq_lane_f32( v, 0 ); }
+
+    GN_FORCE_INLINE Float4 add( Float4 a, Float4 b ) { return vaddq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 sub( Float4 a, Float4 b ) { return vsubq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 mul( Float4 a, Float4 b ) { return vmulq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 div( Float4 a, Float4 b ) { return vdivq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 minimum( Float4 a, Float4 b ) { return vminq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 maximum( Float4 a, Float4 b ) { return vmaxq_f32( a, b ); }
+    GN_FORCE_INLINE Float4 sqrt( Float4 v ) { return vsqrtq_f32( v ); }
+    GN_FORCE_INLINE Float4 abs( Float4 v ) { return vabsq_f32( v ); }
+    GN_FORCE_INLINE Float4 neg( Float4 v ) { return vnegq_f32( v ); }
+    GN_FORCE_INLINE Float4 clearW( Float4 v ) { return vsetq_lane_f32( 0.0f, v, 3 ); }
+    GN_FORCE_INLINE Float4 cmpeq( Float4 a, Float4 b ) { return vreinterpretq_f32_u32( vceqq_f32( a, b ) ); }
+    GN_FORCE_INLINE Float4 cmplt( Float4 a, Float4 b ) { return vreinterpretq_f32_u32( vcltq_f32( a, b ) ); }
+    GN_FORCE_INLINE int    movemask( Float4 v )
+    {
+        static const int32_t shifts[4] = { 0, 1, 2, 3 };
+        uint32x4_t bits = vshrq_n_u32( vreinterpretq_u32_f32( v ), 31 );
+        return (int)vaddvq_u32( vshlq_u32( bits, vld1q_s32( shifts ) ) );
+    }
+    GN_FORCE_INLINE Float4 select( Float4 mask, Float4 a, Float4 b ) { return vbslq_f32( vreinterpretq_u32_f32( mask ), a, b ); }
+    GN_FORCE_INLINE Float4 madd( Float4 a, Float4 b, Float4 c ) { return vfmaq_f32( c, a, b ); }
+    GN_FORCE_INLINE Float4 nmadd( Float4 a, Float4 b, Float4 c ) { return vfmsq_f32( c, a, b ); }
+
+    template<int X, int Y, int Z, int W>
+    GN_FORCE_INLINE Float4 shuffle( Float4 v )
+    {
+        static const uint8_t idx[16] = {
+            X*4, X*4+1, X*4+2, X*4+3, Y*4, Y*4+1, Y*4+2, Y*4+3,
+            Z*4, Z*4+1, Z*4+2, Z*4+3, W*4, W*4+1, W*4+2, W*4+3 };
+        return vreinterpretq_f32_u8( vqtbl1q_u8( vreinterpretq_u8_f32( v ), vld1q_u8( idx ) ) );
+    }
+
+    template<int X, int Y, int Z, int W>
+    GN_FORCE_INLINE Float4 shuffle( Float4 a, Float4 b )
+    {
+        static const uint8_t idx[16] = {
+            X*4, X*4+1, X*4+2, X*4+3, Y*4, Y*4+1, Y*4+2, Y*4+3,
+            Z*4+16, Z*4+17, Z*4+18, Z*4+19, W*4+16, W*4+17, W*4+18, W*4+19 };
+        uint8x16x2_t t = { { vreinterpretq_u8_f32( a ), vreinterpretq_u8_f32( b ) } };
+        return vreinterpretq_f32_u8( vqtbl2q_u8( t, vld1q_u8( idx ) ) );
+    }
+
+    GN_FORCE_INLINE void transpose( Float4 & r0, Float4 & r1, Float4 & r2, Float4 & r3 )
+    {
+        float32x4_t t0 = vzip1q_f32( r0, r2 ); // 00 20 01 21
+        float32x4_t t1 = vzip2q_f32( r0, r2 ); // 02 22 03 23
+        float32x4_t t2 = vzip1q_f32( r1, r3 ); // 10 30 11 31
+        float32x4_t t3 = vzip2q_f32( r1, r3 ); // 12 32 13 33
+        r0 = vzip1q_f32( t0, t2 );
+        r1 = vzip2q_f32( t0, t2 );
+        r2 = vzip1q_f32( t1, t3 );
+        r3 = vzip2q_f32( t1, t3 );
+    }
+
+    GN_FORCE_INLINE Float4 dot4( Float4 a, Float4 b ) { return vdupq_n_f32( vaddvq_f32( vmulq_f32( a, b ) ) ); }
+
+    typedef int32x4_t Int4;
+
+    GN_FORCE_INLINE Int4   loadInt( const void * p ) { return vld1q_s32( (const int32_t*)p ); }
+    GN_FORCE_INLINE void   storeInt( void * p, Int4 v ) { vst1q_s32( (int32_t*)p, v ); }
+    GN_FORCE_INLINE Int4   splatInt( int32_t i ) { return vdupq_n_s32( i ); }
+    GN_FORCE_INLINE Int4   andInt( Int4 a, Int4 b ) { return vandq_s32( a, b ); }
+    GN_FORCE_INLINE Int4   orInt( Int4 a, Int4 b ) { return vorrq_s32( a, b ); }
+    template<int N> GN_FORCE_INLINE Int4 shiftLeft( Int4 v ) { return vshlq_n_s32( v, N ); }
+    template<int N> GN_FORCE_INLINE Int4 shiftRight( Int4 v ) { return vreinterpretq_s32_u32( vshrq_n_u32( vreinterpretq_u32_s32( v ), N ) ); }
+    GN_FORCE_INLINE Float4 toFloat( Int4 v ) { return vcvtq_f32_s32( v ); }
+    GN_FORCE_INLINE Int4   toInt( Float4 v ) { return vcvtnq_s32_f32( v ); }
+
+    GN_FORCE_INLINE void unpackBytes( Int4 v, Int4 & b0, Int4 & b1, Int4 & b2, Int4 & b3 )
+    {
+        uint8x16_t u  = vreinterpretq_u8_s32( v );
+        uint16x8_t lo = vmovl_u8( vget_low_u8( u ) );
+        uint16x8_t hi = vmovl_u8( vget_high_u8( u ) );
+        b0 = vreinterpretq_s32_u32( vmovl_u16( vget_low_u16( lo ) ) );
+        b1 = vreinterpretq_s32_u32( vmovl_u16( vget_high_u16( lo ) ) );
+        b2 = vreinterpretq_s32_u32( vmovl_u16( vget_low_u16( hi ) ) );
+        b3 = vreinterpretq_s32_u32( vmovl_u16( vget_high_u16( hi ) ) );
+    }
+
+    GN_FORCE_INLINE Int4 packBytes( Int4 b0, Int4 b1, Int4 b2, Int4 b3 )
+    {
+        uint16x8_t lo = vcombine_u16( vqmovun_s32( b0 ), vqmovun_s32( b1 ) );
+        uint16x8_t hi = vcombine_u16( vqmovun_s32( b2 ), vqmovun_s32( b3 ) );
+        return vreinterpretq_s32_u8( vcombine_u8( vqmovn_u16( lo ), vqmovn_u16( hi ) ) );
+    }
+#endif
+
+    /// broadcast one lane
+    template<int I>
+    GN_FORCE_INLINE Float4 lane( Float4 v ) { return shuffle<I, I, I, I>( v ); }
+
+    /// 3D cross product. w of the result is 0.
+    GN_FORCE_INLINE Float4 cross3( Float4 a, Float4 b )
+    {
+        return nmadd( shuffle<2,0,1,3>( a ), shuffle<1,2,0,3>( b ), mul( shuffle<1,2,0,3>( a ), shuffle<2,0,1,3>( b ) ) );
+    }
+
+    ///
+    /// Transform a vector by a row major matrix: [ dot(r0,v), dot(r1,v), dot(r2,v), dot(r3,v) ]
+    ///
+    GN_FORCE_INLINE Float4 transformByRows( Float4 r0, Float4 r1, Float4 r2, Float4 r3, Float4 v )
+    {
+        Float4 p0 = mul( r0, v );
+        Float4 p1 = mul( r1, v );
+        Float4 p2 = mul( r2, v );
+        Float4 p3 = mul( r3, v );
+        transpose( p0, p1, p2, p3 );
+        return add( add( p0, p1 ), add( p2, p3 ) );
+    }
+
+    ///
+    /// Transform a vector by a transposed (column major) matrix: c0 * v.x + c1 * v.y + c2 * v.z + c3 * v.w.
+    /// Faster than transformByRows() when many vectors share one matrix.
+    ///
+    GN_FORCE_INLINE Float4 transformByColumns( Float4 c0, Float4 c1, Float4 c2, Float4 c3, Float4 v )
+    {
+        Float4 r = mul( c0, lane<0>( v ) );
+        r = madd( c1, lane<1>( v ), r );
+        r = madd( c2, lane<2>( v ), r );
+        return madd( c3, lane<3>( v ), r );
+    }
+}}
+
+#endif // GN_SIMD
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_BASE_SIMD_H__
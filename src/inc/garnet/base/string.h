@@ -272,7 +272,7 @@ namespace GN
             mPtr[0] = 0;
         }
 
-        Str(const std::basic_string<CharType> & s)
+        Str(const std::basic_string<CharType> & s) : mPtr(NULL)
         {
             setCaps(s.size());
             ::memcpy(mPtr, s.c_str(), (s.size() + 1) * sizeof(CharType));
@@ -1093,7 +1093,7 @@ namespace GN
         // align caps to 2^n-1
         size_t calcCaps( size_t count )
         {
-            #if GN_X64
+            #if GN_X64 || GN_ARM64
             count |= count >> 32;
             #endif
             count |= count >> 16;
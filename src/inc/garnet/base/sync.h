@@ -14,30 +14,363 @@
 namespace GN
 {
     ///
-    /// Spinloop lock
+    /// time duration in nanoseconds
+    ///
+    typedef uint64 TimeInNanoSecond;
+
+    ///
+    /// timeout value that means wait forever
+    ///
+    const TimeInNanoSecond INFINITE_TIME = (TimeInNanoSecond)-1;
+
+    ///
+    /// result of waiting operations
+    ///
+    enum class WaitResult
+    {
+        COMPLETED, ///< the object is signaled.
+        TIMEDOUT,  ///< timeout before the object is signaled.
+        KILLED,    ///< the object is destroyed (or never created) while waiting.
+    };
+
+    ///
+    /// full memory barrier
+    ///
+    inline void memoryBarrier() { std::atomic_thread_fence( std::memory_order_seq_cst ); }
+
+    ///
+    /// low level wait-on-address primitives, used to build the sync objects below.
+    /// On Linux these map to private futexes.
+    ///
+    namespace sync
+    {
+        ///
+        /// Block calling thread as long as addr holds the expected value, until woken by
+        /// wakeByAddress() or timeout. Might return spuriously, so caller must re-check the
+        /// value in a loop. Return false on timeout.
+        ///
+        GN_API bool waitOnAddress( std::atomic<uint32> & addr, uint32 expected, TimeInNanoSecond timeout = INFINITE_TIME );
+
+        ///
+        /// Wake up to count threads blocked on addr.
+        ///
+        GN_API void wakeByAddress( std::atomic<uint32> & addr, uint32 count );
+
+        ///
+        /// Wake all threads blocked on addr.
+        ///
+        GN_API void wakeAllByAddress( std::atomic<uint32> & addr );
+
+        ///
+        /// Hint the CPU that the calling thread is in a spin-wait loop.
+        ///
+        GN_API void cpuRelax();
+
+        ///
+        /// Converts relative timeout into an absolute deadline, and back. Used by waiting
+        /// loops that might wake up several times before the timeout.
+        ///
+        class Deadline
+        {
+            typedef std::chrono::steady_clock Clock;
+
+            Clock::time_point mEnd;
+            bool              mInfinite;
+
+        public:
+
+            explicit Deadline( TimeInNanoSecond timeout )
+                : mInfinite( INFINITE_TIME == timeout )
+            {
+                if( !mInfinite ) mEnd = Clock::now() + std::chrono::nanoseconds( timeout );
+            }
+
+            /// Return remaining time, or INFINITE_TIME. 0 means expired.
+            TimeInNanoSecond remaining() const
+            {
+                if( mInfinite ) return INFINITE_TIME;
+                sint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>( mEnd - Clock::now() ).count();
+                return ns > 0 ? (TimeInNanoSecond)ns : 0;
+            }
+        };
+    }
+
+    ///
+    /// Spinloop lock. Only for very short critical sections; prefer Mutex in general.
     ///
     class SpinLoop : NoCopy
     {
-        std::atomic_flag mLock;
+        std::atomic_flag mLock = ATOMIC_FLAG_INIT;
     public:
         //@{
-        bool tryLock() { return mLock.test_and_set(); }
+        bool tryLock() { return !mLock.test_and_set( std::memory_order_acquire ); }
         void lock()
         {
             size_t i = 0;
-            while( !mLock.test_and_set() )
+            while( mLock.test_and_set( std::memory_order_acquire ) )
             {
-                ++i;
-                if( i > 1000000 )
+                if( ++i < 64 )
+                {
+                    sync::cpuRelax();
+                }
+                else
                 {
-                    std::this_thread::sleep_for( std::chrono::microseconds::min() );
+                    std::this_thread::yield();
                     i = 0;
                 }
             }
         }
-        void unlock() { mLock.clear(); }
+        void unlock() { mLock.clear( std::memory_order_release ); }
+        //@}
+    };
+
+    ///
+    /// Mutex that spins a while before parking the thread in the kernel. The spin count
+    /// adapts to how long the lock is usually held. Works with std::lock_guard.
+    ///
+    class GN_API Mutex : NoCopy
+    {
+        std::atomic<uint32> mState;     ///< 0: unlocked, 1: locked, 2: locked and might have waiters.
+        std::atomic<sint32> mSpinCount; ///< running average of spins needed to acquire the lock.
+
+        void lockSlow();
+
+    public:
+
+        //@{
+        Mutex() : mState( 0 ), mSpinCount( 0 ) {}
+        bool tryLock()
+        {
+            uint32 expected = 0;
+            return mState.compare_exchange_strong( expected, 1, std::memory_order_acquire, std::memory_order_relaxed );
+        }
+        void lock() { if( !tryLock() ) lockSlow(); }
+        void unlock()
+        {
+            if( 2 == mState.exchange( 0, std::memory_order_release ) ) sync::wakeByAddress( mState, 1 );
+        }
+        //@}
+    };
+
+    ///
+    /// Reader-writer lock. Any number of readers, or one writer. Waiting writers block new
+    /// readers, so writers are not starved by a stream of readers.
+    ///
+    class GN_API RWLock : NoCopy
+    {
+        enum
+        {
+            WRITER_LOCKED  = 0x80000000,
+            WRITER_WAITING = 0x40000000,
+            READER_WAITING = 0x20000000,
+            READER_MASK    = 0x1FFFFFFF,
+        };
+
+        std::atomic<uint32> mState;
+
+        void lockSlow();
+        void lockSharedSlow();
+
+    public:
+
+        RWLock() : mState( 0 ) {}
+
+        /// \name exclusive (writer) lock
+        //@{
+        bool tryLock()
+        {
+            uint32 s = mState.load( std::memory_order_relaxed );
+            return 0 == ( s & ( WRITER_LOCKED | READER_MASK ) )
+                && mState.compare_exchange_strong( s, s | WRITER_LOCKED, std::memory_order_acquire, std::memory_order_relaxed );
+        }
+        void lock() { if( !tryLock() ) lockSlow(); }
+        void unlock()
+        {
+            uint32 s = mState.exchange( 0, std::memory_order_release );
+            if( s & ( WRITER_WAITING | READER_WAITING ) ) sync::wakeAllByAddress( mState );
+        }
+        //@}
+
+        /// \name shared (reader) lock
+        //@{
+        bool tryLockShared()
+        {
+            uint32 s = mState.load( std::memory_order_relaxed );
+            return 0 == ( s & ( WRITER_LOCKED | WRITER_WAITING ) )
+                && mState.compare_exchange_strong( s, s + 1, std::memory_order_acquire, std::memory_order_relaxed );
+        }
+        void lockShared() { if( !tryLockShared() ) lockSharedSlow(); }
+        void unlockShared()
+        {
+            uint32 s = mState.fetch_sub( 1, std::memory_order_release ) - 1;
+            if( 0 == ( s & READER_MASK ) && ( s & WRITER_WAITING ) ) sync::wakeAllByAddress( mState );
+        }
         //@}
     };
+
+    ///
+    /// Counting semaphore
+    ///
+    class GN_API Semaphore : NoCopy
+    {
+        std::atomic<uint32> mCount;
+        std::atomic<uint32> mWaiters;
+
+    public:
+
+        explicit Semaphore( uint32 initialCount = 0 ) : mCount( initialCount ), mWaiters( 0 ) {}
+
+        ///
+        /// Decrease the count if it is not zero. Return false if the count is zero.
+        ///
+        bool tryAcquire()
+        {
+            uint32 c = mCount.load( std::memory_order_relaxed );
+            while( c > 0 )
+            {
+                if( mCount.compare_exchange_weak( c, c - 1, std::memory_order_acquire, std::memory_order_relaxed ) ) return true;
+            }
+            return false;
+        }
+
+        ///
+        /// Wait until the count is not zero, then decrease it.
+        ///
+        WaitResult acquire( TimeInNanoSecond timeout = INFINITE_TIME );
+
+        ///
+        /// Increase the count, and wake up to count waiting threads.
+        ///
+        void release( uint32 count = 1 )
+        {
+            mCount.fetch_add( count, std::memory_order_seq_cst );
+            if( mWaiters.load( std::memory_order_seq_cst ) > 0 ) sync::wakeByAddress( mCount, count );
+        }
+    };
+
+    ///
+    /// Event object that threads could wait on. An auto-reset event releases one waiting
+    /// thread and goes back to unsignaled; a manual-reset event releases all waiting threads
+    /// and stays signaled until unsignal() is called.
+    ///
+    class GN_API SyncEvent : NoCopy
+    {
+    public:
+
+        /// initial state of the event
+        enum InitialState
+        {
+            UNSIGNALED,
+            SIGNALED,
+        };
+
+        /// reset mode of the event
+        enum ResetMode
+        {
+            AUTO_RESET,
+            MANUAL_RESET,
+        };
+
+        ///
+        /// Construct a destroyed event. Call create() before use.
+        ///
+        SyncEvent() : mState( ST_KILLED ), mWaiters( 0 ), mManualReset( false ) {}
+
+        ///
+        /// Construct and create the event.
+        ///
+        SyncEvent( InitialState initialState, ResetMode resetMode ) : mState( ST_KILLED ), mWaiters( 0 ), mManualReset( false )
+        {
+            create( initialState, resetMode );
+        }
+
+        ~SyncEvent() { destroy(); }
+
+        ///
+        /// (Re)create the event. Must not be called while other threads are using the event.
+        ///
+        bool create( InitialState initialState, ResetMode resetMode )
+        {
+            mManualReset = MANUAL_RESET == resetMode;
+            mState.store( SIGNALED == initialState ? ST_SIGNALED : ST_UNSIGNALED, std::memory_order_release );
+            return true;
+        }
+
+        ///
+        /// Destroy the event. Threads blocked in wait() return WaitResult::KILLED.
+        ///
+        void destroy()
+        {
+            mState.store( ST_KILLED, std::memory_order_seq_cst );
+            if( mWaiters.load( std::memory_order_seq_cst ) > 0 ) sync::wakeAllByAddress( mState );
+        }
+
+        ///
+        /// Signal the event.
+        ///
+        void signal()
+        {
+            GN_ASSERT( ST_KILLED != mState.load( std::memory_order_relaxed ) );
+            mState.store( ST_SIGNALED, std::memory_order_seq_cst );
+            if( mWaiters.load( std::memory_order_seq_cst ) > 0 )
+            {
+                if( mManualReset ) sync::wakeAllByAddress( mState );
+                else sync::wakeByAddress( mState, 1 );
+            }
+        }
+
+        ///
+        /// Reset the event to unsignaled state.
+        ///
+        void unsignal()
+        {
+            uint32 expected = ST_SIGNALED;
+            mState.compare_exchange_strong( expected, ST_UNSIGNALED, std::memory_order_relaxed );
+        }
+
+        ///
+        /// Return true if the event is signaled.
+        ///
+        bool isSignaled() const { return ST_SIGNALED == mState.load( std::memory_order_acquire ); }
+
+        ///
+        /// Wait for the event to be signaled. Auto-reset event is reset by a successful wait.
+        ///
+        WaitResult wait( TimeInNanoSecond timeout = INFINITE_TIME ) const;
+
+    private:
+
+        enum
+        {
+            ST_UNSIGNALED,
+            ST_SIGNALED,
+            ST_KILLED,
+        };
+
+        mutable std::atomic<uint32> mState;
+        mutable std::atomic<uint32> mWaiters;
+        bool                        mManualReset;
+    };
+
+    ///
+    /// Reusable thread barrier for a fixed number of threads.
+    ///
+    class GN_API Barrier : NoCopy
+    {
+        const uint32        mCount;
+        std::atomic<uint32> mArrived;
+        std::atomic<uint32> mGeneration; ///< increased each time all threads arrive. Threads wait on this.
+
+    public:
+
+        explicit Barrier( uint32 count ) : mCount( count ), mArrived( 0 ), mGeneration( 0 ) {}
+
+        ///
+        /// Block until all threads have arrived. Return true on exactly one of the threads
+        /// (the last one arrived), which is handy for per-phase serial work.
+        ///
+        bool arriveAndWait();
+    };
 }
 
 // *****************************************************************************
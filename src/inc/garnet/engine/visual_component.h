@@ -39,9 +39,15 @@ namespace GN { namespace engine
         uint32 getModelCount() const { return mModels.size(); }
 
         /// Render all models in the component. If an spcial component is provided, it will be
-        /// used to update world transformations.
+        /// used to update world transformations, and nothing is drawn when its bounding box
+        /// is out of view.
         void draw( const SpacialComponent * sc ) const;
 
+        /// Return false if bounding box of the spacial component is completely outside of the
+        /// view frustum of current transformation. For culling many components at once, see
+        /// GN::cullBoxes().
+        bool isVisible( const SpacialComponent & sc ) const;
+
         /// Render the component to screen with specified transformation.
         void draw( const Matrix44f & proj, const Matrix44f & view, const SpacialComponent * sc ) const
         {
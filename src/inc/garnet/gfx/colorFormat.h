@@ -148,6 +148,7 @@ namespace GN { namespace gfx
             LAYOUT_DXT3A_AS_1_1_1_1,
             LAYOUT_GRGB,
             LAYOUT_RGBG,
+            LAYOUT_BC7,
             NUM_COLOR_LAYOUTS,
         };
         GN_CASSERT( NUM_COLOR_LAYOUTS <= 64 );
@@ -242,7 +243,7 @@ namespace GN { namespace gfx
 
             // 32 bits
             RGBA_8_8_8_8_UNORM          = GN_MAKE_COLOR_FORMAT( LAYOUT_8_8_8_8, SIGN_UNORM, SWIZZLE_RGBA ),
-            RGBA_8_8_8_8_UNORM_SRGB     = GN_MAKE_COLOR_FORMAT2( LAYOUT_8_8_8_8, SIGN_UNORM, SIGN_GNORM, SWIZZLE_RGBA ),
+            RGBA_8_8_8_8_UNORM_SRGB     = GN_MAKE_COLOR_FORMAT2( LAYOUT_8_8_8_8, SIGN_GNORM, SIGN_UNORM, SWIZZLE_RGBA ),
             RGBA_8_8_8_8_SNORM          = GN_MAKE_COLOR_FORMAT( LAYOUT_8_8_8_8, SIGN_SNORM, SWIZZLE_RGBA ),
             RGBA8                       = RGBA_8_8_8_8_UNORM,
             UBYTE4N                     = RGBA_8_8_8_8_UNORM,
@@ -350,6 +351,8 @@ namespace GN { namespace gfx
             DXT5A_SNORM                 = GN_MAKE_COLOR_FORMAT( LAYOUT_DXT5A, SIGN_SNORM, SWIZZLE_RGBA ),
             DXN_UNORM                   = GN_MAKE_COLOR_FORMAT( LAYOUT_DXN, SIGN_UNORM, SWIZZLE_RGBA ),
             DXN_SNORM                   = GN_MAKE_COLOR_FORMAT( LAYOUT_DXN, SIGN_SNORM, SWIZZLE_RGBA ),
+            BC7_UNORM                   = GN_MAKE_COLOR_FORMAT( LAYOUT_BC7, SIGN_UNORM, SWIZZLE_RGBA ),
+            BC7_UNORM_SRGB              = GN_MAKE_COLOR_FORMAT2( LAYOUT_BC7, SIGN_GNORM, SIGN_UNORM, SWIZZLE_RGBA ),
         };
 
         uint32           u32;   ///< color format as unsigned integer
@@ -414,10 +417,10 @@ namespace GN { namespace gfx
             : layout( l )
             , sign012( si012 )
             , sign3( si3 )
-            , swizzle0( (sw0123>>0)&3 )
-            , swizzle1( (sw0123>>3)&3 )
-            , swizzle2( (sw0123>>6)&3 )
-            , swizzle3( (sw0123>>9)&3 )
+            , swizzle0( (sw0123>>0)&7 )
+            , swizzle1( (sw0123>>3)&7 )
+            , swizzle2( (sw0123>>6)&7 )
+            , swizzle3( (sw0123>>9)&7 )
             , reserved( 0 )
         {
         }
@@ -511,6 +514,67 @@ namespace GN { namespace gfx
             (uint8_t)math::clamp(c.w * 255.0f, 0.0f, 255.0f) );
     }
 
+    ///
+    /// Return true, if convertPixels() can read and write the format: formats of 1x1 pixel blocks,
+    /// with UNORM, SNORM, GNORM (sRGB), UINT, SINT, or 16/32-bit FLOAT channels.
+    ///
+    GN_API bool isConvertibleColorFormat( ColorFormat );
+
+    ///
+    /// Convert array of pixels from one color format to another. Return false, if either format
+    /// is not convertible.
+    ///
+    /// Pixels are decoded to 32-bit float RGBA through the source swizzle, then encoded through
+    /// the destination swizzle. Channels that the destination swizzle does not read, like X of
+    /// BGRX, are written as 1. Identical formats are copied as is, and a few common pairs, like
+    /// RGBA8 and BGRA8, are converted directly.
+    ///
+    /// Source and destination could be the same buffer, if destination pixels are not larger
+    /// than source pixels.
+    ///
+    GN_API bool convertPixels( ColorFormat srcFormat, const void * src, ColorFormat dstFormat, void * dst, size_t count );
+
+    ///
+    /// Quality presets of block compression, trading encoding speed for error.
+    ///
+    enum class BlockCompressionQuality
+    {
+        FAST,   ///< bounding box end points. BC7 uses mode 6 only.
+        NORMAL, ///< principal axis end points, refined once. BC7 tries a few modes and partitions.
+        HIGH,   ///< more refinement and end point search. BC7 tries all modes.
+    };
+
+    ///
+    /// Return true, if encodeBlocks() and decodeBlocks() support the format: BC1 - BC5 (DXT1,
+    /// DXT3, DXT5, DXT5A and DXN) and BC7.
+    ///
+    GN_API bool isCompressibleColorFormat( ColorFormat );
+
+    ///
+    /// Return format of pixels that encodeBlocks() reads and decodeBlocks() writes:
+    /// RGBA_8_8_8_8_SNORM for SNORM formats, RGBA_8_8_8_8_UNORM_SRGB for sRGB formats, and
+    /// RGBA_8_8_8_8_UNORM for others. Return UNKNOWN, if the format is not compressible.
+    ///
+    GN_API ColorFormat getUncompressedColorFormat( ColorFormat );
+
+    ///
+    /// Compress a row of 4x4 pixel blocks. Pixels are 4 rows of count*4 pixels, in the
+    /// format of getUncompressedColorFormat(), "pitch" bytes apart.
+    ///
+    GN_API bool encodeBlocks(
+        ColorFormat             format,
+        const void            * pixels,
+        size_t                  pitch,
+        void                  * blocks,
+        size_t                  count,
+        BlockCompressionQuality quality = BlockCompressionQuality::NORMAL );
+
+    ///
+    /// Decompress a row of 4x4 pixel blocks, into 4 rows of pixels "pitch" bytes apart. Missing
+    /// channels decode as 0, alpha as 1. So BC4 decodes to (R,0,0,1) and BC5 to (R,G,0,1).
+    ///
+    GN_API bool decodeBlocks( ColorFormat format, const void * blocks, size_t count, void * pixels, size_t pitch );
+
     ///
     /// D3DFMT to string. Return "INVALID D3D9 FORMAT" if failed.
     ///
@@ -134,6 +134,7 @@ namespace GN { namespace gfx
         /// getXXX() helpers
         //@{
         VertexElement * getPosition() { return mElements[POSITION].rawptr(); }
+        const VertexElement * getPosition() const { return mElements[POSITION].rawptr(); }
         VertexElement * getNormal() { return mElements[NORMAL].rawptr(); }
         VertexElement * getJoints() { return mElements[JOINT_ID].rawptr(); }
         VertexElement * getTexcoord( size_t stage )
@@ -232,6 +233,9 @@ namespace GN { namespace gfx
         GN_NO_COPY(FatMesh);
         GN_DEFAULT_MOVE(FatMesh);
         FatMesh() {};
+
+        /// Add the mesh to occlusion buffer as occluder. Only triangle lists and strips are supported.
+        GN_API bool addOccluder( OcclusionBuffer & ob, const Matrix44f & clipFromObject ) const;
     };
 
     struct FatMaterial
@@ -359,6 +363,12 @@ namespace GN { namespace gfx
         /// load fatmodel from file
         bool loadFromFile( const StrA & filename );
 
+        /// load fatmodel from file on a worker thread of the loader.
+        static AsyncResult<FatModel> loadFromFileAsync(
+            const StrA &  filename,
+            AsyncPriority priority = AsyncPriority::NORMAL,
+            AsyncLoader & loader = AsyncLoader::sGetGlobalInstance() );
+
         /// save fatmodel to file.
         bool saveToFile( const StrA & filename ) const;
     };
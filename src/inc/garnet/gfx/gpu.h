@@ -209,6 +209,17 @@ namespace GN { namespace gfx
 
         //@}
 
+        /// \name Multi-thread GPU only parameters (see GPU_CREATION_MULTIPLE_THREADS)
+        //@{
+
+        ///
+        /// Maximum number of frames queued for the GPU thread. present() blocks
+        /// while more frames are queued. 0 means no limit. Default is 1.
+        ///
+        uint32 maxFramesInFlight;
+
+        //@}
+
         ///
         /// Construct default render options
         ///
@@ -223,6 +234,7 @@ namespace GN { namespace gfx
             , vsync(false)
             , debug( GN_BUILD_DEBUG_ENABLED )
             , reference(false)
+            , maxFramesInFlight(1)
         {
             displayMode.set(DisplayMode::WINDOWED, 0, 0, 0, 0);
         }
@@ -1475,6 +1487,13 @@ namespace GN { namespace gfx
     ///
     GN_API Gpu * createD3DGpu( const GpuOptions & go, uint32 creationFlags );
 
+    ///
+    /// Create fake GPU, which draws nothing. Resources keep their content in
+    /// system memory, and clearScreen() fills the back buffer. For tests and
+    /// benchmarks that need no display.
+    ///
+    GN_API Gpu * createFakeGpu( const GpuOptions & go, uint32 creationFlags );
+
     ///
     /// General GPU creator (link to both D3D and OpenGL libraries)
     ///
@@ -74,6 +74,14 @@ namespace GN { namespace gfx
         /// load texture from file. Would return existing handle, if it is already loaded.
         static AutoRef<TextureResource> loadFromFile( GpuResourceDatabase & db, const char * filename );
 
+        /// Load texture asynchronously. File loading and decoding run on a worker, texture
+        /// creation runs on main thread of the loader. The database must outlive the operation.
+        static AsyncResult< AutoRef<TextureResource> > loadFromFileAsync(
+            GpuResourceDatabase & db,
+            const char          * filename,
+            AsyncPriority         priority = AsyncPriority::NORMAL,
+            AsyncLoader         & loader = AsyncLoader::sGetGlobalInstance() );
+
         //@}
 
         /// events
@@ -366,6 +374,18 @@ namespace GN { namespace gfx
         }
     };
 
+    ///
+    /// Precomputed bounding volumes of a mesh, in object space. Optionally stored in mesh
+    /// binary files, so that they don't need to be calculated from vertices at load time.
+    ///
+    struct MeshBounds
+    {
+        Box<float>         box;    ///< axis aligned bounding box
+        Sphere<float>      sphere; ///< minimal bounding sphere
+        OrientedBox<float> obb;    ///< oriented bounding box
+        Dop26              dop;    ///< 26-DOP
+    };
+
     ///
     /// Mesh resource descriptor base (no data pointers)
     ///
@@ -380,6 +400,8 @@ namespace GN { namespace gfx
         MeshVertexFormat    vtxfmt; ///< vertex format
         uint16              strides[GpuContext::MAX_VERTEX_BUFFERS];  ///< vertex buffer strides. 0 means using vertex size defined by vertex format.
         uint32              offsets[GpuContext::MAX_VERTEX_BUFFERS];  ///< Number of bytes from vertex buffer beginning to the first element that will be used.
+        bool                hasBounds; ///< true, if bounds are valid. Clear it (or call calculateBounds() again) after changing vertices.
+        MeshBounds          bounds;    ///< precomputed bounding volumes. Ignored, if hasBounds is false.
 
         ///
         /// constructor
@@ -391,7 +413,7 @@ namespace GN { namespace gfx
         ///
         void clear()
         {
-            memset( this, 0, sizeof(*this) );
+            memset( (void*)this, 0, sizeof(*this) ); // bounds are not trivially assignable, but all zero is valid
         }
 
         ///
@@ -423,19 +445,32 @@ namespace GN { namespace gfx
         ///
         void clear()
         {
-            memset( this, 0, sizeof(*this) );
+            memset( (void*)this, 0, sizeof(*this) );
         }
 
         ///
-        /// calculate bounding box
+        /// calculate bounding box. Return precomputed one, if there is.
         ///
         void calculateBoundingBox( Box<float> & ) const;
 
         ///
-        /// calculate bounding sphere
+        /// calculate bounding sphere. Return precomputed one, if there is.
         ///
         void calculateBoundingSphere( Sphere<float> & ) const;
 
+        ///
+        /// Calculate tight bounding volumes from vertex positions, and store them in
+        /// bounds. They will be saved to mesh binary file too. Bounds are not updated
+        /// automatically: call it again after changing vertex data. Mesh resources with
+        /// dynamic vertex buffer ignore precomputed bounds.
+        ///
+        bool calculateBounds();
+
+        ///
+        /// Add the mesh to occlusion buffer as occluder. Only triangle lists and strips are supported.
+        ///
+        bool addOccluder( OcclusionBuffer & ob, const Matrix44f & clipFromObject ) const;
+
         ///
         /// Load descriptor from file, return the mesh data. Return a NULL blob for failure.
         ///
@@ -468,6 +503,11 @@ namespace GN { namespace gfx
         //@{
         static const Guid          & guid();
         static AutoRef<MeshResource> loadFromFile( GpuResourceDatabase & db, const char * filename );
+        static AsyncResult< AutoRef<MeshResource> > loadFromFileAsync(
+            GpuResourceDatabase & db,
+            const char          * filename,
+            AsyncPriority         priority = AsyncPriority::NORMAL,
+            AsyncLoader         & loader = AsyncLoader::sGetGlobalInstance() );
         //@}
 
         /// events
@@ -933,6 +973,17 @@ namespace GN { namespace gfx
         //@{
         static const Guid           & guid();
         static AutoRef<ModelResource> loadFromFile( GpuResourceDatabase & db, const char * filename );
+
+        ///
+        /// Load model asynchronously. Model descriptor, mesh data and texture images are
+        /// loaded on a worker thread; GPU resources are created on main thread of the loader.
+        /// Effects are still loaded on main thread. The database must outlive the operation.
+        ///
+        static AsyncResult< AutoRef<ModelResource> > loadFromFileAsync(
+            GpuResourceDatabase & db,
+            const char          * filename,
+            AsyncPriority         priority = AsyncPriority::NORMAL,
+            AsyncLoader         & loader = AsyncLoader::sGetGlobalInstance() );
         //@}
 
         //@{
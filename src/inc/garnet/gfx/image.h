@@ -155,6 +155,38 @@ namespace GN { namespace gfx
         void reset(const ImagePlaneDesc & basemap, uint32_t layers, uint32_t levels);
     };
 
+    ///
+    /// Resampling filters of RawImage::generateMipmaps()
+    ///
+    enum class MipmapFilter
+    {
+        BOX,     ///< average of the 2x2 (2x2x2) source pixels, weighted by coverage for odd sizes.
+        KAISER,  ///< Kaiser windowed sinc, 3 lobes. Sharper than box, with little ringing.
+        LANCZOS, ///< Lanczos windowed sinc, 3 lobes. Sharpest, with a bit more ringing.
+    };
+
+    ///
+    /// How RawImage::generateMipmaps() interprets the color channels
+    ///
+    enum class MipmapColorSpace
+    {
+        AUTO,       ///< SRGB for formats of GNORM color channels, LINEAR for others.
+        LINEAR,     ///< filter channel values as they are.
+        SRGB,       ///< filter in linear space. Color channels must be UNORM or GNORM.
+        NORMAL_MAP, ///< XYZ is a normal, [0, 1] mapped to [-1, 1] for UNORM. Renormalized after filtering.
+    };
+
+    ///
+    /// Image file formats that RawImage::save() writes
+    ///
+    enum class ImageFileFormat
+    {
+        DDS,      ///< all layers and levels. Legacy header, if the color format and layers fit in it.
+        DDS_DX10, ///< all layers and levels, always with DX10 header.
+        PNG,      ///< base level of the first layer, as 8-bit gray, gray + alpha, RGB or RGBA.
+        TGA,      ///< base level of the first layer, as 8-bit gray, RGB or RGBA, uncompressed.
+    };
+
     ///
     /// A basic image class
     ///
@@ -166,8 +198,19 @@ namespace GN { namespace gfx
         //@{
         RawImage() = default;
         RawImage(ImageDesc&& desc, const void * initialContent = nullptr, size_t initialContentSizeInbytes = 0);
+        ~RawImage() { HeapMemory::dealloc(mPixels); }
         GN_NO_COPY(RawImage);
-        GN_DEFAULT_MOVE(RawImage);
+        RawImage(RawImage && rhs) : mPixels(rhs.mPixels), mDesc(std::move(rhs.mDesc)) { rhs.mPixels = nullptr; rhs.mDesc = {}; }
+        RawImage & operator=(RawImage && rhs) {
+            if (this != &rhs) {
+                HeapMemory::dealloc(mPixels);
+                mPixels = rhs.mPixels;
+                mDesc = std::move(rhs.mDesc);
+                rhs.mPixels = nullptr;
+                rhs.mDesc = {};
+            }
+            return *this;
+        }
         //@}
 
         /// \name basic property query
@@ -212,20 +255,123 @@ namespace GN { namespace gfx
 
         /// \name load & save
         //@{
-        static RawImage load(File &);
-        static RawImage load(const StrA & filename) {
+
+        ///
+        /// Load image from the current position to the end of the file. DDS is decoded by the
+        /// built-in reader, EXR by the built-in reader of single part scanline images, and other
+        /// formats (PNG, JPEG, HDR, ...) by stb_image. Chunk CRCs of PNG are not checked, call
+        /// verify() for that. Files that support memory mapping (disk and memory files) are
+        /// decoded in place, others are read into memory with a single read.
+        ///
+        /// The image keeps channel count and bit depth of the file: gray as L8 or L16, gray with
+        /// alpha as LA8 or LA16, 16-bit color as RGBA16, Radiance HDR as RGB32F, and EXR as RGBA16F
+        /// (or RGB32F/RGBA32F for FLOAT channels). Pass a format other than UNKNOWN to convert
+        /// the image to it with convertImage(). The image is empty, if the conversion fails.
+        ///
+        static RawImage load(File &, ColorFormat format = ColorFormat::UNKNOWN);
+        static RawImage load(const StrA & filename, ColorFormat format = ColorFormat::UNKNOWN) {
             AutoObjPtr<File> fp(GN::fs::openFile(filename, "rb"));
             if (fp.empty()) return {};
-            return load(*fp);
+            return load(*fp, format);
+        }
+
+        /// Load image from a memory block of an image file.
+        static RawImage load(const void * data, size_t size, ColorFormat format = ColorFormat::UNKNOWN);
+
+        ///
+        /// Check integrity of a memory block of an image file, that load() doesn't: length and
+        /// CRC of all chunks of PNG. Files of other formats always pass.
+        ///
+        static bool verify(const void * data, size_t size);
+
+        ///
+        /// Load multiple image files with worker threads of the job system, one file per job.
+        /// images[i] is left empty, if filenames[i] fails to load.
+        ///
+        static void load(JobSystem & js, const StrA * filenames, size_t count, RawImage * images, ColorFormat format = ColorFormat::UNKNOWN);
+
+        /// Load image on a worker thread of the loader. Value is an empty image, if failed.
+        static AsyncResult<RawImage> loadAsync(const StrA & filename, AsyncPriority priority = AsyncPriority::NORMAL, AsyncLoader & loader = AsyncLoader::sGetGlobalInstance()) {
+            return loadAsync(filename, ColorFormat::UNKNOWN, priority, loader);
+        }
+
+        /// Load image on a worker thread of the loader, and convert it to the format, like load() does.
+        static AsyncResult<RawImage> loadAsync(const StrA & filename, ColorFormat format, AsyncPriority priority = AsyncPriority::NORMAL, AsyncLoader & loader = AsyncLoader::sGetGlobalInstance());
+
+        ///
+        /// Save image to file. DDS keeps the color format, with rows packed as the DDS spec
+        /// requires. 6 square layers are saved as a cube map. PNG and TGA convert pixels of
+        /// convertible color formats to 8-bit channels. Color channels of sRGB formats are
+        /// written as they are, since both file formats are sRGB by convention.
+        ///
+        /// Return false, if the color format has no DXGI format (DDS), or is not convertible
+        /// (PNG and TGA), or the file fails to write.
+        ///
+        bool save(File &, ImageFileFormat) const;
+        bool save(const StrA & filename, ImageFileFormat format) const {
+            AutoObjPtr<File> fp(GN::fs::openFile(filename, "wb"));
+            if (fp.empty()) return false;
+            return save(*fp, format);
         }
         //@}
 
+        /// \name mipmap generation
+        //@{
+
+        ///
+        /// Replace all levels below the base level with a full mipmap chain, down to 1x1x1.
+        /// Each layer (array slice or cube face) is filtered independently, with clamped edges.
+        /// Levels are filtered in 32-bit float, each from the one above it. Alpha weighted
+        /// filtering premultiplies colors with alpha, so that transparent pixels do not bleed
+        /// into opaque ones. It is ignored by formats without alpha and by normal maps.
+        ///
+        /// Return false, and leave the image untouched, if the format is not convertible
+        /// (see isConvertibleColorFormat()), or does not fit the color space.
+        ///
+        bool generateMipmaps(MipmapFilter filter = MipmapFilter::BOX, MipmapColorSpace colorSpace = MipmapColorSpace::AUTO, bool alphaWeighted = true);
+
+        /// Generate mipmaps with worker threads of the job system, a band of rows per job.
+        bool generateMipmaps(JobSystem & js, MipmapFilter filter = MipmapFilter::BOX, MipmapColorSpace colorSpace = MipmapColorSpace::AUTO, bool alphaWeighted = true);
+
+        //@}
+
     private:
 
+        struct Adopt {};
+
+        /// take over a pixel buffer allocated by HeapMemory.
+        RawImage(Adopt, ImageDesc&& desc, uint8_t * pixels) : mPixels(pixels), mDesc(std::move(desc)) {}
+
         uint8_t * mPixels = nullptr;
         
         ImageDesc mDesc;
     };
+
+    ///
+    /// Convert all planes of an image to another color format, with convertPixels(). The
+    /// destination image has the same dimension, layers and levels as the source, with default
+    /// pitches. Return false, if either format is not convertible, and leave dst untouched.
+    ///
+    /// Block compressed formats of isCompressibleColorFormat() are decoded and encoded with
+    /// decodeBlocks() and encodeBlocks(), in the given quality.
+    ///
+    GN_API bool convertImage(
+        const ImageDesc       & srcDesc,
+        const void            * src,
+        ColorFormat             dstFormat,
+        RawImage              & dst,
+        BlockCompressionQuality quality = BlockCompressionQuality::NORMAL );
+
+    ///
+    /// Convert image with worker threads of the job system, a few rows, or rows of blocks, per job.
+    ///
+    GN_API bool convertImage(
+        const ImageDesc       & srcDesc,
+        const void            * src,
+        ColorFormat             dstFormat,
+        RawImage              & dst,
+        JobSystem             & js,
+        BlockCompressionQuality quality = BlockCompressionQuality::NORMAL );
 }}
 
 // #include "image.inl"
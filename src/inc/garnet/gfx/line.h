@@ -235,7 +235,10 @@ namespace GN { namespace gfx
 
         void calcEndPoint(
             EndPoint              & endpoint,
-            const ThickLineVertex & vertex );
+            const ThickLineVertex & vertex,
+            const Vector4f        & transformed ); // vertex in clip space, or in view space
+
+        void addLine( EndPoint & e0, EndPoint & e1 );
 
         PrivateVertex * newPolygon6();
 
@@ -0,0 +1,548 @@
+#include "pch.h"
+#include "garnet/GNgfx.h"
+#include "garnet/GNengine.h"
+#include "garnet/gfx/fatModel.h"
+#include <algorithm>
+#include <vector>
+#if GN_POSIX
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#elif GN_WINPC
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+using namespace GN;
+using namespace GN::gfx;
+
+//
+// End-to-end asset loading benchmark: measures the CPU path from files on disk
+// to ready-to-draw data (FatModel, mesh descriptor + vertex data, decoded
+// image), without any GPU. Each stage loads a fixed corpus of files from the
+// media folder, plus a few files generated on startup for formats that the
+// media folder does not have.
+//
+
+// *****************************************************************************
+// Global new/delete are routed to HeapMemory, so that C++ allocations (STL,
+// assimp) are included in the allocation statistics. Clang build already does
+// it in garnet/base/memory.h.
+// *****************************************************************************
+
+#if !GN_CLANG
+void * operator new( size_t s ) { return ::GN::HeapMemory::alloc( s ); }
+void * operator new[]( size_t s ) { return ::GN::HeapMemory::alloc( s ); }
+void operator delete( void * p ) noexcept { ::GN::HeapMemory::dealloc( p ); }
+void operator delete[]( void * p ) noexcept { ::GN::HeapMemory::dealloc( p ); }
+void operator delete( void * p, size_t ) noexcept { ::GN::HeapMemory::dealloc( p ); }
+void operator delete[]( void * p, size_t ) noexcept { ::GN::HeapMemory::dealloc( p ); }
+#endif
+
+// *****************************************************************************
+// Stage definitions
+// *****************************************************************************
+
+static const size_t MAX_STEPS = 2;
+
+/// Load one file of the corpus. Returns false on failure. Time spent on each step
+/// of the stage is added to stepSeconds.
+typedef bool (*LoadFunc)( const char * filename, double * stepSeconds );
+
+struct StageDesc
+{
+    const char *    name;
+    const char *    steps[MAX_STEPS]; ///< name of each step. NULL means unused.
+    LoadFunc        load;
+    DynaArray<StrA> files;
+};
+
+struct StageResult
+{
+    StrA                name;
+    size_t              files;
+    size_t              failures;
+    uint64              fileBytes;
+    std::vector<double> samples[MAX_STEPS]; ///< seconds of each step, per repetition
+    std::vector<double> total;             ///< seconds of all steps, per repetition
+    uint64              allocCount;        ///< average per repetition
+    uint64              allocBytes;        ///< average per repetition
+    uint64              peakRssKB;
+};
+
+static uint32 sMaxJoints = 0;
+
+//
+//
+// -----------------------------------------------------------------------------
+static bool sLoadFatModel( const char * filename, double * stepSeconds )
+{
+    Clock c;
+    FatModel fm;
+    bool ok = fm.loadFromFile( filename );
+    stepSeconds[0] += c.getTimeD();
+    return ok;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static bool sLoadAndSplitFatModel( const char * filename, double * stepSeconds )
+{
+    Clock c;
+    FatModel fm;
+    if( !fm.loadFromFile( filename ) ) return false;
+    double t0 = c.getTimeD();
+    bool ok = fm.splitSkinnedMesh( sMaxJoints );
+    double t1 = c.getTimeD();
+    stepSeconds[0] += t0;
+    stepSeconds[1] += t1 - t0;
+    return ok;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static bool sLoadMesh( const char * filename, double * stepSeconds )
+{
+    Clock c;
+    MeshResourceDesc desc;
+    AutoRef<Blob> blob = desc.loadFromFile( filename );
+    stepSeconds[0] += c.getTimeD();
+    return !!blob;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static bool sLoadImage( const char * filename, double * stepSeconds )
+{
+    Clock c;
+    RawImage image = RawImage::load( filename );
+    stepSeconds[0] += c.getTimeD();
+    return !image.empty();
+}
+
+// *****************************************************************************
+// Generated corpus
+// *****************************************************************************
+
+static const char * GENERATED_OBJ = "GNbench-assets.sphere.obj";
+static const char * GENERATED_DOLPHIN = "GNbench-assets.dolphin.mesh.bin";
+static const char * GENERATED_SEAFLOOR = "GNbench-assets.seafloor.mesh.bin";
+
+//
+// Write a UV sphere to OBJ file, to be loaded through assimp.
+// -----------------------------------------------------------------------------
+static bool sGenerateObj( const char * filename, int slices, int stacks )
+{
+    AutoObjPtr<File> fp( fs::openFile( filename, "wb" ) );
+    if( !fp ) return false;
+
+    StrA line;
+    for( int j = 0; j <= stacks; ++j )
+    {
+        float v = (float)j / stacks;
+        float phi = v * GN_PI;
+        for( int i = 0; i <= slices; ++i )
+        {
+            float u = (float)i / slices;
+            float theta = u * GN_PI * 2.0f;
+            float x = sinf( phi ) * cosf( theta );
+            float y = cosf( phi );
+            float z = sinf( phi ) * sinf( theta );
+            line.format( "v %f %f %f\nvn %f %f %f\nvt %f %f\n", x, y, z, x, y, z, u, v );
+            if( !fp->write( line.rawptr(), line.size(), NULL ) ) return false;
+        }
+    }
+    for( int j = 0; j < stacks; ++j )
+    {
+        for( int i = 0; i < slices; ++i )
+        {
+            int a = j * ( slices + 1 ) + i + 1; // OBJ index is 1 based.
+            int b = a + slices + 1;
+            line.format( "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                a, a, a, b, b, b, a + 1, a + 1, a + 1,
+                a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1 );
+            if( !fp->write( line.rawptr(), line.size(), NULL ) ) return false;
+        }
+    }
+    return true;
+}
+
+//
+// Convert mesh XML to garnet mesh binary format.
+// -----------------------------------------------------------------------------
+static bool sGenerateMeshBinary( const char * src, const char * dst )
+{
+    MeshResourceDesc desc;
+    AutoRef<Blob> blob = desc.loadFromFile( src );
+    if( !blob ) return false;
+    return desc.saveToFile( dst );
+}
+
+// *****************************************************************************
+// Platform utilities
+// *****************************************************************************
+
+//
+// Drop file content from OS page cache. Return false if not supported.
+// -----------------------------------------------------------------------------
+static bool sEvictFromCache( const StrA & filename )
+{
+#if GN_POSIX && defined(POSIX_FADV_DONTNEED)
+    StrA native = fs::toNativeDiskFilePath( filename );
+    int fd = open( native.rawptr(), O_RDONLY );
+    if( fd < 0 ) return false;
+    bool ok = 0 == posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+    close( fd );
+    return ok;
+#else
+    GN_UNUSED_PARAM( filename );
+    return false;
+#endif
+}
+
+//
+// Reset peak RSS of the process. Return false if not supported.
+// -----------------------------------------------------------------------------
+static bool sResetPeakRss()
+{
+#if defined(__linux__)
+    FILE * fp = fopen( "/proc/self/clear_refs", "w" );
+    if( !fp ) return false;
+    bool ok = 0 <= fputs( "5", fp );
+    return ( 0 == fclose( fp ) ) && ok;
+#else
+    return false;
+#endif
+}
+
+//
+// Return peak RSS of the process in KB.
+// -----------------------------------------------------------------------------
+static uint64 sGetPeakRssKB()
+{
+#if defined(__linux__)
+    // VmHWM is affected by sResetPeakRss(), while ru_maxrss is not.
+    FILE * fp = fopen( "/proc/self/status", "r" );
+    if( fp )
+    {
+        char buf[256];
+        unsigned long long kb = 0;
+        bool found = false;
+        while( !found && fgets( buf, sizeof(buf), fp ) )
+        {
+            found = 1 == sscanf( buf, "VmHWM: %llu kB", &kb );
+        }
+        fclose( fp );
+        if( found ) return (uint64)kb;
+    }
+#endif
+#if GN_POSIX
+    struct rusage ru;
+    if( 0 != getrusage( RUSAGE_SELF, &ru ) ) return 0;
+#if GN_DARWIN
+    return (uint64)ru.ru_maxrss / 1024; // in bytes on Mac OS
+#else
+    return (uint64)ru.ru_maxrss;
+#endif
+#elif GN_WINPC
+    PROCESS_MEMORY_COUNTERS pmc;
+    if( !GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof(pmc) ) ) return 0;
+    return (uint64)pmc.PeakWorkingSetSize / 1024;
+#else
+    return 0;
+#endif
+}
+
+// *****************************************************************************
+// Benchmark driver
+// *****************************************************************************
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sSetupStages( DynaArray<StageDesc> & stages )
+{
+    StageDesc s;
+
+    s = StageDesc{ "ase", { "load", NULL }, sLoadFatModel, {} };
+    s.files.append( "media::boxes/boxes.ase" );
+    s.files.append( "media::model/R.F.R01/a01.ase" );
+    stages.append( s );
+
+    s = StageDesc{ "obj_assimp", { "load", NULL }, sLoadFatModel, {} };
+    s.files.append( GENERATED_OBJ );
+    stages.append( s );
+
+    s = StageDesc{ "mesh_xml", { "load", NULL }, sLoadMesh, {} };
+    s.files.append( "media::dolphin/dolphin.mesh.xml" );
+    s.files.append( "media::dolphin/seafloor.mesh.xml" );
+    stages.append( s );
+
+    s = StageDesc{ "mesh_bin", { "load", NULL }, sLoadMesh, {} };
+    s.files.append( GENERATED_DOLPHIN );
+    s.files.append( GENERATED_SEAFLOOR );
+    stages.append( s );
+
+    s = StageDesc{ "dds", { "decode", NULL }, sLoadImage, {} };
+    for( int i = 1; i <= 8; ++i ) s.files.append( str::format( "media::model/R.F.R01/RF%03d.dds", i ) );
+    s.files.append( "media::model/tiny/Tiny_skin.dds" );
+    s.files.append( "media::texture/cube1.dds" );
+    stages.append( s );
+
+    s = StageDesc{ "png", { "decode", NULL }, sLoadImage, {} };
+    s.files.append( "media::texture/rabit.png" );
+    s.files.append( "media::texture/red.png" );
+    s.files.append( "media::texture/green.png" );
+    s.files.append( "media::texture/blue.png" );
+    stages.append( s );
+
+    s = StageDesc{ "jpeg", { "decode", NULL }, sLoadImage, {} };
+    s.files.append( "media::texture/earth.jpg" );
+    s.files.append( "media::texture/rockwall.jpg" );
+    s.files.append( "media::texture/rockwall_normal.jpg" );
+    s.files.append( "media::boxes/Oldwood.jpg" );
+    s.files.append( "media::boxes/Foliage1.jpg" );
+    stages.append( s );
+
+    // Note: FBX files require the FBX SDK. They are reported as failures when it is not available.
+    s = StageDesc{ "fatmodel_skinned", { "load", "split" }, sLoadAndSplitFatModel, {} };
+    s.files.append( "media::model/tiny/tiny.fbx" );
+    s.files.append( "media::model/humanoid.fbx" );
+    s.files.append( "media::model/R.F.R01/a01.ase" );
+    stages.append( s );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static uint64 sGetFileBytes( const StrA & filename )
+{
+    AutoObjPtr<File> fp( fs::openFile( filename, "rb" ) );
+    return fp ? (uint64)fp->size() : 0;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static StageResult sRunStage( const StageDesc & stage, bool cold, size_t repetitions, bool & cacheEvicted, bool & rssReset )
+{
+    StageResult r;
+    r.name = stage.name;
+    r.files = stage.files.size();
+    r.failures = 0;
+    r.fileBytes = 0;
+    r.allocCount = 0;
+    r.allocBytes = 0;
+    for( const StrA & f : stage.files ) r.fileBytes += sGetFileBytes( f );
+
+    double steps[MAX_STEPS];
+
+    // warm up: bring files to page cache and initialize loader statics.
+    if( !cold )
+    {
+        for( const StrA & f : stage.files ) stage.load( f, steps );
+    }
+
+    rssReset = sResetPeakRss() && rssReset;
+
+    for( size_t rep = 0; rep < repetitions; ++rep )
+    {
+        if( cold )
+        {
+            for( const StrA & f : stage.files ) cacheEvicted = sEvictFromCache( f ) && cacheEvicted;
+        }
+
+        memset( steps, 0, sizeof(steps) );
+        HeapMemory::resetStatistics();
+        HeapMemory::enableStatistics( true );
+        for( const StrA & f : stage.files )
+        {
+            if( !stage.load( f, steps ) && 0 == rep ) ++r.failures;
+        }
+        HeapMemory::enableStatistics( false );
+
+        HeapMemory::Statistics hs;
+        HeapMemory::getStatistics( hs );
+        r.allocCount += hs.allocCount + hs.reallocCount;
+        r.allocBytes += hs.allocBytes;
+        double total = 0;
+        for( size_t i = 0; i < MAX_STEPS; ++i )
+        {
+            r.samples[i].push_back( steps[i] );
+            total += steps[i];
+        }
+        r.total.push_back( total );
+    }
+
+    r.allocCount /= repetitions;
+    r.allocBytes /= repetitions;
+    r.peakRssKB = sGetPeakRssKB();
+    return r;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static double sMedianMs( std::vector<double> samples )
+{
+    if( samples.empty() ) return 0;
+    std::sort( samples.begin(), samples.end() );
+    return samples[samples.size() / 2] * 1000.0;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static double sMinMs( const std::vector<double> & samples )
+{
+    return samples.empty() ? 0 : *std::min_element( samples.begin(), samples.end() ) * 1000.0;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sWriteJson(
+    FILE * fp,
+    const DynaArray<StageDesc> & stages,
+    const DynaArray<StageResult> * results,
+    const char ** modes,
+    size_t modeCount,
+    size_t repetitions,
+    bool coldSupported,
+    bool rssReset )
+{
+    fprintf( fp, "{\n  \"context\": {\n    \"suite\": \"GNbench-assets\",\n    \"build\": \"%s\",\n    \"repetitions\": %d,\n    \"cold_cache_supported\": %s,\n    \"peak_rss_per_stage\": %s\n  },\n  \"modes\": {\n",
+        GN_BUILD_DEBUG_ENABLED ? "debug" : "release",
+        (int)repetitions,
+        coldSupported ? "true" : "false",
+        rssReset ? "true" : "false" );
+    for( size_t m = 0; m < modeCount; ++m )
+    {
+        fprintf( fp, "    \"%s\": [\n", modes[m] );
+        const DynaArray<StageResult> & rs = results[m];
+        for( size_t i = 0; i < rs.size(); ++i )
+        {
+            const StageResult & r = rs[i];
+            const StageDesc * d = NULL;
+            for( const StageDesc & s : stages ) if( r.name == s.name ) d = &s;
+            GN_ASSERT( d );
+            fprintf( fp, "      { \"stage\": \"%s\", \"files\": %d, \"failures\": %d, \"file_bytes\": %llu, \"median_ms\": %.3f, \"min_ms\": %.3f,",
+                r.name.rawptr(), (int)r.files, (int)r.failures, (unsigned long long)r.fileBytes,
+                sMedianMs( r.total ), sMinMs( r.total ) );
+            fprintf( fp, " \"steps\": {" );
+            for( size_t s = 0; s < MAX_STEPS && d->steps[s]; ++s )
+            {
+                fprintf( fp, "%s \"%s\": %.3f", s ? "," : "", d->steps[s], sMedianMs( r.samples[s] ) );
+            }
+            fprintf( fp, " }, \"alloc_count\": %llu, \"alloc_bytes\": %llu, \"peak_rss_kb\": %llu }%s\n",
+                (unsigned long long)r.allocCount, (unsigned long long)r.allocBytes, (unsigned long long)r.peakRssKB,
+                i + 1 < rs.size() ? "," : "" );
+        }
+        fprintf( fp, "    ]%s\n", m + 1 < modeCount ? "," : "" );
+    }
+    fprintf( fp, "  }\n}\n" );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    const char * filter = NULL;
+    const char * json = NULL;
+    const char * cache = "both";
+    size_t       repetitions = 5;
+    sMaxJoints = engine::SkinnedMesh::sGetMaxJointsPerDraw();
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const char * a = argv[i];
+        if( 0 == str::compare( a, "--filter=", 9 ) ) filter = a + 9;
+        else if( 0 == str::compare( a, "--json=", 7 ) ) json = a + 7;
+        else if( 0 == str::compare( a, "--cache=", 8 ) ) cache = a + 8;
+        else if( 0 == str::compare( a, "--repetitions=", 14 ) ) repetitions = (size_t)atoi( a + 14 );
+        else if( 0 == str::compare( a, "--max-joints=", 13 ) ) sMaxJoints = (uint32)atoi( a + 13 );
+        else
+        {
+            printf( "usage: %s [--filter=<stage>] [--json=<file>] [--cache=warm|cold|both] [--repetitions=<n>] [--max-joints=<n>]\n", argv[0] );
+            return -1;
+        }
+    }
+    if( 0 == repetitions ) repetitions = 1;
+
+    const char * modes[2];
+    size_t modeCount = 0;
+    if( 0 == str::compare( cache, "warm" ) || 0 == str::compare( cache, "both" ) ) modes[modeCount++] = "warm";
+    if( 0 == str::compare( cache, "cold" ) || 0 == str::compare( cache, "both" ) ) modes[modeCount++] = "cold";
+    if( 0 == modeCount )
+    {
+        printf( "Invalid cache mode: %s\n", cache );
+        return -1;
+    }
+
+    // generate files that do not exist in media folder.
+    if( !sGenerateObj( GENERATED_OBJ, 256, 128 ) ||
+        !sGenerateMeshBinary( "media::dolphin/dolphin.mesh.xml", GENERATED_DOLPHIN ) ||
+        !sGenerateMeshBinary( "media::dolphin/seafloor.mesh.xml", GENERATED_SEAFLOOR ) )
+    {
+        printf( "Fail to generate benchmark corpus. Make sure media folder is accessible (set GARNET_ROOT).\n" );
+        return -1;
+    }
+    struct GeneratedFileCleaner
+    {
+        ~GeneratedFileCleaner()
+        {
+            ::remove( GENERATED_OBJ );
+            ::remove( GENERATED_DOLPHIN );
+            ::remove( GENERATED_SEAFLOOR );
+        }
+    } cleaner;
+
+    DynaArray<StageDesc> stages;
+    sSetupStages( stages );
+
+    DynaArray<StageResult> results[2];
+    bool coldSupported = true;
+    bool rssReset = true;
+
+    printf( "%-6s %-18s %6s %9s %12s %12s %14s %12s\n", "cache", "stage", "files", "failures", "median(ms)", "allocs", "alloc(KB)", "peakRSS(KB)" );
+    for( size_t m = 0; m < modeCount; ++m )
+    {
+        bool cold = 0 == str::compare( modes[m], "cold" );
+        for( const StageDesc & s : stages )
+        {
+            if( filter && NULL == strstr( s.name, filter ) ) continue;
+            StageResult r = sRunStage( s, cold, repetitions, coldSupported, rssReset );
+            printf( "%-6s %-18s %6d %9d %12.3f %12llu %14llu %12llu\n",
+                modes[m], r.name.rawptr(), (int)r.files, (int)r.failures, sMedianMs( r.total ),
+                (unsigned long long)r.allocCount, (unsigned long long)( r.allocBytes / 1024 ), (unsigned long long)r.peakRssKB );
+            results[m].append( r );
+        }
+    }
+    if( !coldSupported )
+    {
+        printf( "Warning: cold cache mode is not supported on this platform. Cold results include cached file reads.\n" );
+    }
+    if( !rssReset )
+    {
+        printf( "Warning: peak RSS can not be reset between stages. Reported value is peak of the whole process so far.\n" );
+    }
+
+    if( json )
+    {
+        FILE * fp = fopen( json, "wt" );
+        if( NULL == fp )
+        {
+            printf( "Fail to open %s.\n", json );
+            return -1;
+        }
+        sWriteJson( fp, stages, results, modes, modeCount, repetitions, coldSupported, rssReset );
+        fclose( fp );
+        printf( "results written to %s\n", json );
+    }
+
+    return 0;
+}
@@ -0,0 +1,547 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+// *****************************************************************************
+// helpers
+// *****************************************************************************
+
+static std::vector<uint64> sMakeIntKeys( size_t count )
+{
+    std::vector<uint64> keys( count );
+    uint64 seed = 12345;
+    for( size_t i = 0; i < count; ++i ) keys[i] = nextRandom64( seed ) >> 16;
+    return keys;
+}
+
+static std::vector<StrA> sMakeStrKeys( size_t count )
+{
+    std::vector<StrA> keys( count );
+    uint64 seed = 12345;
+    for( size_t i = 0; i < count; ++i ) keys[i] = str::format( "media::/objects/item_%llu.xml", ( nextRandom64( seed ) >> 16 ) % 1000000000 );
+    return keys;
+}
+
+// *****************************************************************************
+// DynaArray
+// *****************************************************************************
+
+static void DynaArray_append( State & state )
+{
+    while( state.keepRunning() )
+    {
+        DynaArray<int> a;
+        for( size_t i = 0; i < state.arg(); ++i ) a.append( (int)i );
+        doNotOptimize( a.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( DynaArray_append, 16 );
+GN_BENCHMARK_ARG( DynaArray_append, 1024 );
+GN_BENCHMARK_ARG( DynaArray_append, 65536 );
+
+static void StdVector_append( State & state )
+{
+    while( state.keepRunning() )
+    {
+        std::vector<int> a;
+        for( size_t i = 0; i < state.arg(); ++i ) a.push_back( (int)i );
+        doNotOptimize( a.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( StdVector_append, 1024 );
+
+static void DynaArray_appendReserved( State & state )
+{
+    while( state.keepRunning() )
+    {
+        DynaArray<int> a;
+        a.reserve( state.arg() );
+        for( size_t i = 0; i < state.arg(); ++i ) a.append( (int)i );
+        doNotOptimize( a.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( DynaArray_appendReserved, 1024 );
+
+static void DynaArray_appendStr( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    while( state.keepRunning() )
+    {
+        DynaArray<StrA> a;
+        for( size_t i = 0; i < keys.size(); ++i ) a.append( keys[i] );
+        doNotOptimize( a.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( DynaArray_appendStr, 1024 );
+
+static void DynaArray_copy( State & state )
+{
+    DynaArray<int> src;
+    for( size_t i = 0; i < state.arg(); ++i ) src.append( (int)i );
+    while( state.keepRunning() )
+    {
+        DynaArray<int> a( src );
+        doNotOptimize( a.rawptr() );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() * sizeof(int) );
+}
+GN_BENCHMARK_ARG( DynaArray_copy, 1024 );
+GN_BENCHMARK_ARG( DynaArray_copy, 65536 );
+
+static void DynaArray_iterate( State & state )
+{
+    DynaArray<int> a;
+    for( size_t i = 0; i < state.arg(); ++i ) a.append( (int)i );
+    while( state.keepRunning() )
+    {
+        int sum = 0;
+        for( size_t i = 0; i < a.size(); ++i ) sum += a[i];
+        doNotOptimize( sum );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( DynaArray_iterate, 65536 );
+
+static void DynaArray_insertFront( State & state )
+{
+    while( state.keepRunning() )
+    {
+        DynaArray<int> a;
+        for( size_t i = 0; i < state.arg(); ++i ) a.insert( 0, (int)i );
+        doNotOptimize( a.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( DynaArray_insertFront, 1024 );
+
+// *****************************************************************************
+// HashMap
+// *****************************************************************************
+
+typedef HashMap<uint64, int, 128> IntHashMap;
+typedef HashMap<StrA, int, 128, HashMapUtils::HashFunc_HashMethod<StrA> > StrHashMap;
+
+static void HashMap_insert( State & state )
+{
+    std::vector<uint64> keys = sMakeIntKeys( state.arg() );
+    while( state.keepRunning() )
+    {
+        IntHashMap m;
+        for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i], (int)i );
+        doNotOptimize( m.size() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( HashMap_insert, 16 );
+GN_BENCHMARK_ARG( HashMap_insert, 1024 );
+GN_BENCHMARK_ARG( HashMap_insert, 65536 );
+
+static void HashMap_find( State & state )
+{
+    std::vector<uint64> keys = sMakeIntKeys( state.arg() );
+    IntHashMap m;
+    for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i], (int)i );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( m.find( keys[k] ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( HashMap_find, 1024 );
+GN_BENCHMARK_ARG( HashMap_find, 65536 );
+
+static void HashMap_findString( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    StrHashMap m;
+    for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i], (int)i );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( m.find( keys[k] ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( HashMap_findString, 1024 );
+
+static void HashMap_remove( State & state )
+{
+    std::vector<uint64> keys = sMakeIntKeys( state.arg() );
+    while( state.keepRunning() )
+    {
+        state.pauseTiming();
+        IntHashMap m;
+        for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i], (int)i );
+        state.resumeTiming();
+        for( size_t i = 0; i < keys.size(); ++i ) m.remove( keys[i] );
+        doNotOptimize( m.size() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( HashMap_remove, 1024 );
+
+// *****************************************************************************
+// Dictionary
+// *****************************************************************************
+
+static void Dictionary_insert( State & state )
+{
+    std::vector<uint64> keys = sMakeIntKeys( state.arg() );
+    while( state.keepRunning() )
+    {
+        Dictionary<uint64, int> d;
+        for( size_t i = 0; i < keys.size(); ++i ) d.insert( keys[i], (int)i );
+        doNotOptimize( d.size() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Dictionary_insert, 16 );
+GN_BENCHMARK_ARG( Dictionary_insert, 1024 );
+GN_BENCHMARK_ARG( Dictionary_insert, 65536 );
+
+static void Dictionary_find( State & state )
+{
+    std::vector<uint64> keys = sMakeIntKeys( state.arg() );
+    Dictionary<uint64, int> d;
+    for( size_t i = 0; i < keys.size(); ++i ) d.insert( keys[i], (int)i );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( d.find( keys[k] ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( Dictionary_find, 1024 );
+GN_BENCHMARK_ARG( Dictionary_find, 65536 );
+
+static void Dictionary_findString( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    Dictionary<StrA, int> d;
+    for( size_t i = 0; i < keys.size(); ++i ) d.insert( keys[i], (int)i );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( d.find( keys[k] ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( Dictionary_findString, 1024 );
+
+// *****************************************************************************
+// StringMap
+// *****************************************************************************
+
+static void StringMap_insert( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    while( state.keepRunning() )
+    {
+        StringMap<char, int> m;
+        for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i].rawptr(), (int)i );
+        doNotOptimize( m.size() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( StringMap_insert, 16 );
+GN_BENCHMARK_ARG( StringMap_insert, 1024 );
+
+static void StringMap_find( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    StringMap<char, int> m;
+    for( size_t i = 0; i < keys.size(); ++i ) m.insert( keys[i].rawptr(), (int)i );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( m.find( keys[k].rawptr() ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( StringMap_find, 1024 );
+GN_BENCHMARK_ARG( StringMap_find, 65536 );
+
+// *****************************************************************************
+// Str and str:: utilities
+// *****************************************************************************
+
+static void Str_appendChar( State & state )
+{
+    while( state.keepRunning() )
+    {
+        StrA s;
+        for( size_t i = 0; i < state.arg(); ++i ) s.append( (char)( 'a' + i % 26 ) );
+        doNotOptimize( s.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_appendChar, 64 );
+GN_BENCHMARK_ARG( Str_appendChar, 4096 );
+
+static void Str_copy( State & state )
+{
+    StrA src( std::string( state.arg(), 'x' ) );
+    while( state.keepRunning() )
+    {
+        StrA s( src );
+        doNotOptimize( s.rawptr() );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_copy, 16 );
+GN_BENCHMARK_ARG( Str_copy, 4096 );
+
+static void Str_format( State & state )
+{
+    int i = 0;
+    while( state.keepRunning() )
+    {
+        StrA s = str::format( "mesh %d of %s : %f", i++, "media::/cube/cube.mesh.xml", 3.1415926 );
+        doNotOptimize( s.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK( Str_format );
+
+static void Str_toLower( State & state )
+{
+    StrA src( std::string( state.arg(), 'X' ) );
+    while( state.keepRunning() )
+    {
+        StrA s( src );
+        s.toLower();
+        doNotOptimize( s.rawptr() );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_toLower, 256 );
+
+static void Str_trim( State & state )
+{
+    StrA src = StrA( "    " ) + StrA( std::string( state.arg(), 'x' ) ) + StrA( " \t\n  " );
+    while( state.keepRunning() )
+    {
+        StrA s( src );
+        s.trim( " \t\n" );
+        doNotOptimize( s.rawptr() );
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( Str_trim, 64 );
+
+static void Str_hash( State & state )
+{
+    StrA src( std::string( state.arg(), 'h' ) );
+    while( state.keepRunning() )
+    {
+        doNotOptimize( src.hash() );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_hash, 16 );
+GN_BENCHMARK_ARG( Str_hash, 1024 );
+
+static void Str_compareI( State & state )
+{
+    StrA a( std::string( state.arg(), 'a' ) );
+    StrA b( std::string( state.arg(), 'A' ) );
+    while( state.keepRunning() )
+    {
+        doNotOptimize( str::compareI( a.rawptr(), b.rawptr() ) );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_compareI, 64 );
+
+static void Str_findFirstOf( State & state )
+{
+    StrA s = StrA( std::string( state.arg(), 'a' ) ) + "/";
+    while( state.keepRunning() )
+    {
+        doNotOptimize( s.findFirstOf( "/\\" ) );
+    }
+    state.setBytesProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( Str_findFirstOf, 256 );
+
+static void Str_toInteger( State & state )
+{
+    const char * text[] = { "0", "12345", "-987654321", "2147483647" };
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        int v = 0;
+        str::toInetger<int>( v, text[k & 3] );
+        doNotOptimize( v );
+        ++k;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK( Str_toInteger );
+
+static void Str_toFloatArray( State & state )
+{
+    const char * text = "1.0 2.5 -3.25 4e3 0.001 6 7.75 -8.5 9 10.125 11 12 13 14 15 16";
+    float buffer[16];
+    while( state.keepRunning() )
+    {
+        doNotOptimize( str::toFloatArray( buffer, 16, text ) );
+    }
+    state.setItemsProcessed( state.iterations() * 16 );
+}
+GN_BENCHMARK( Str_toFloatArray );
+
+// *****************************************************************************
+// HandleManager
+// *****************************************************************************
+
+struct HandleItem
+{
+    int    value;
+    void * data;
+    HandleItem() : value(0), data(NULL) {}
+    HandleItem( int v ) : value(v), data(NULL) {}
+};
+
+static void HandleManager_addRemove( State & state )
+{
+    HandleManager<HandleItem, uint32> m;
+    std::vector<uint32> handles( state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) handles[i] = m.add( HandleItem( (int)i ) );
+        for( size_t i = 0; i < state.arg(); ++i ) m.remove( handles[i] );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( HandleManager_addRemove, 1024 );
+
+static void HandleManager_get( State & state )
+{
+    HandleManager<HandleItem, uint32> m;
+    std::vector<uint32> handles( state.arg() );
+    for( size_t i = 0; i < state.arg(); ++i ) handles[i] = m.add( HandleItem( (int)i ) );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( m.get( handles[k] ).value );
+        if( ++k == handles.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( HandleManager_get, 65536 );
+
+static void NamedHandleManager_find( State & state )
+{
+    std::vector<StrA> keys = sMakeStrKeys( state.arg() );
+    NamedHandleManager<HandleItem, uint32> m;
+    for( size_t i = 0; i < keys.size(); ++i ) m.add( keys[i], HandleItem( (int)i ) );
+    size_t k = 0;
+    while( state.keepRunning() )
+    {
+        doNotOptimize( m.name2handle( keys[k] ) );
+        if( ++k == keys.size() ) k = 0;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK_ARG( NamedHandleManager_find, 1024 );
+
+// *****************************************************************************
+// ObjectPool
+// *****************************************************************************
+
+struct PoolItem
+{
+    float matrix[16];
+    int   id;
+};
+
+static void ObjectPool_allocFree( State & state )
+{
+    ObjectPool<PoolItem> pool;
+    std::vector<PoolItem*> items( state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) items[i] = pool.allocConstructed();
+        for( size_t i = 0; i < state.arg(); ++i ) pool.deconstructAndFree( items[i] );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( ObjectPool_allocFree, 1024 );
+
+static void HeapNew_allocFree( State & state )
+{
+    std::vector<PoolItem*> items( state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) items[i] = new PoolItem;
+        for( size_t i = 0; i < state.arg(); ++i ) delete items[i];
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( HeapNew_allocFree, 1024 );
+
+// *****************************************************************************
+// Variant
+// *****************************************************************************
+
+static void Variant_int( State & state )
+{
+    Variant v;
+    int i = 0;
+    while( state.keepRunning() )
+    {
+        v.seti( i++ );
+        doNotOptimize( v.getdi( 0 ) );
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK( Variant_int );
+
+static void Variant_float( State & state )
+{
+    Variant v;
+    float f = 0;
+    while( state.keepRunning() )
+    {
+        v.setf( f );
+        f += 0.5f;
+        doNotOptimize( v.getdf( 0 ) );
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK( Variant_float );
+
+static void Variant_matrix( State & state )
+{
+    Variant v;
+    Matrix44f m = Matrix44f::sIdentity();
+    while( state.keepRunning() )
+    {
+        v.setm( m );
+        doNotOptimize( v.getdm( m ) );
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+GN_BENCHMARK( Variant_matrix );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-base", argc, argv );
+}
@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+struct BenchmarkDesc
+{
+    StrA          name;
+    BenchmarkFunc func;
+    size_t        arg;
+};
+
+struct BenchmarkResult
+{
+    StrA   name;
+    size_t iterations;
+    double median; // ns per iteration
+    double min;
+    double mean;
+    double stddev;
+    double itemsPerSecond;
+    double bytesPerSecond;
+};
+
+static std::vector<BenchmarkDesc> & sGetBenchmarks()
+{
+    static std::vector<BenchmarkDesc> sBenchmarks;
+    return sBenchmarks;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+GN::bench::Registrar::Registrar( const char * name, BenchmarkFunc func, size_t arg, bool hasArg )
+{
+    BenchmarkDesc d;
+    d.name = hasArg ? str::format( "%s/%d", name, (int)arg ) : StrA( name );
+    d.func = func;
+    d.arg  = arg;
+    sGetBenchmarks().push_back( d );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static void sWriteJsonString( FILE * fp, const char * s )
+{
+    fputc( '"', fp );
+    for( ; *s; ++s )
+    {
+        if( '"' == *s || '\\' == *s ) fputc( '\\', fp );
+        fputc( *s, fp );
+    }
+    fputc( '"', fp );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+static BenchmarkResult sRun( const BenchmarkDesc & b, double minTime, size_t repetitions )
+{
+    // find iteration count that takes at least minTime.
+    size_t iterations = 1;
+    for(;;)
+    {
+        State s( iterations, b.arg );
+        b.func( s );
+        double t = s.elapsedSeconds();
+        if( t >= minTime || iterations >= ( (size_t)1 << 30 ) ) break;
+        size_t next = t > 0 ? (size_t)( (double)iterations * minTime * 1.2 / t ) : iterations * 10;
+        iterations = std::max( iterations * 2, std::min( next, iterations * 100 ) );
+    }
+
+    std::vector<double> samples;
+    uint64 items = 0, bytes = 0;
+    double total = 0;
+    for( size_t r = 0; r < repetitions; ++r )
+    {
+        State s( iterations, b.arg );
+        b.func( s );
+        samples.push_back( s.elapsedSeconds() * 1e9 / (double)iterations );
+        items += s.items();
+        bytes += s.bytes();
+        total += s.elapsedSeconds();
+    }
+    std::sort( samples.begin(), samples.end() );
+
+    BenchmarkResult result;
+    result.name = b.name;
+    result.iterations = iterations;
+    result.median = samples[samples.size() / 2];
+    result.min = samples.front();
+    result.mean = 0;
+    for( double v : samples ) result.mean += v;
+    result.mean /= (double)samples.size();
+    result.stddev = 0;
+    for( double v : samples ) result.stddev += ( v - result.mean ) * ( v - result.mean );
+    result.stddev = sqrt( result.stddev / (double)samples.size() );
+    result.itemsPerSecond = total > 0 ? (double)items / total : 0;
+    result.bytesPerSecond = total > 0 ? (double)bytes / total : 0;
+    return result;
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+int GN::bench::runAll( const char * suiteName, int argc, const char * argv[] )
+{
+    const char * filter = NULL;
+    const char * json = NULL;
+    double       minTime = 0.1;
+    size_t       repetitions = 5;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const char * a = argv[i];
+        if( 0 == str::compare( a, "--filter=", 9 ) ) filter = a + 9;
+        else if( 0 == str::compare( a, "--json=", 7 ) ) json = a + 7;
+        else if( 0 == str::compare( a, "--min-time=", 11 ) ) minTime = atof( a + 11 );
+        else if( 0 == str::compare( a, "--repetitions=", 14 ) ) repetitions = (size_t)atoi( a + 14 );
+        else
+        {
+            printf( "usage: %s [--filter=<substring>] [--json=<file>] [--min-time=<seconds>] [--repetitions=<n>]\n", argv[0] );
+            return -1;
+        }
+    }
+    if( minTime <= 0 ) minTime = 0.1;
+    if( 0 == repetitions ) repetitions = 1;
+
+    std::vector<BenchmarkResult> results;
+
+    printf( "%-40s %14s %14s %12s %12s\n", "benchmark", "median(ns)", "min(ns)", "stddev(%)", "iterations" );
+    for( const BenchmarkDesc & b : sGetBenchmarks() )
+    {
+        if( filter && NULL == strstr( b.name.rawptr(), filter ) ) continue;
+        BenchmarkResult r = sRun( b, minTime, repetitions );
+        printf( "%-40s %14.2f %14.2f %12.2f %12d\n",
+            r.name.rawptr(), r.median, r.min, r.mean > 0 ? r.stddev * 100.0 / r.mean : 0.0, (int)r.iterations );
+        results.push_back( r );
+    }
+
+    if( json )
+    {
+        FILE * fp = fopen( json, "wt" );
+        if( NULL == fp )
+        {
+            printf( "Fail to open %s.\n", json );
+            return -1;
+        }
+
+        fprintf( fp, "{\n  \"context\": {\n    \"suite\": " );
+        sWriteJsonString( fp, suiteName );
+        fprintf( fp, ",\n    \"build\": \"%s\",\n    \"hardware_threads\": %u,\n    \"min_time\": %g,\n    \"repetitions\": %d\n  },\n  \"benchmarks\": [\n",
+            GN_BUILD_DEBUG_ENABLED ? "debug" : "release",
+            std::thread::hardware_concurrency(),
+            minTime,
+            (int)repetitions );
+        for( size_t i = 0; i < results.size(); ++i )
+        {
+            const BenchmarkResult & r = results[i];
+            fprintf( fp, "    { \"name\": " );
+            sWriteJsonString( fp, r.name.rawptr() );
+            fprintf( fp, ", \"iterations\": %d, \"median_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"items_per_second\": %.1f, \"bytes_per_second\": %.1f }%s\n",
+                (int)r.iterations, r.median, r.min, r.mean, r.stddev, r.itemsPerSecond, r.bytesPerSecond,
+                i + 1 < results.size() ? "," : "" );
+        }
+        fprintf( fp, "  ]\n}\n" );
+        fclose( fp );
+        printf( "results written to %s\n", json );
+    }
+
+    return 0;
+}
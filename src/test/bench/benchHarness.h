@@ -0,0 +1,143 @@
+#ifndef __GN_TEST_BENCH_HARNESS_H__
+#define __GN_TEST_BENCH_HARNESS_H__
+// *****************************************************************************
+/// \file
+/// \brief   Minimal micro-benchmark harness, emitting JSON results.
+// *****************************************************************************
+
+#include <chrono>
+
+///
+/// Register a benchmark function: void func( GN::bench::State & )
+///
+#define GN_BENCHMARK( func ) static GN::bench::Registrar GN_JOIN(__GN_bench_,__LINE__)( #func, func, 0, false )
+
+///
+/// Register a benchmark function with an argument, accessible via State::arg().
+///
+#define GN_BENCHMARK_ARG( func, arg ) static GN::bench::Registrar GN_JOIN(__GN_bench_,__LINE__)( #func, func, arg, true )
+
+namespace GN { namespace bench
+{
+    ///
+    /// Benchmark state. Typical usage:
+    ///
+    ///     void myBench( State & state )
+    ///     {
+    ///         setup();
+    ///         while( state.keepRunning() ) { work(); }
+    ///         state.setItemsProcessed( state.iterations() * itemsPerIteration );
+    ///     }
+    ///
+    class State
+    {
+        typedef std::chrono::high_resolution_clock ClockType;
+
+        size_t                mIterations;
+        size_t                mRemaining;
+        size_t                mArg;
+        bool                  mStarted;
+        ClockType::time_point mStart;
+        ClockType::duration   mElapsed;
+        uint64                mItems;
+        uint64                mBytes;
+
+    public:
+
+        State( size_t iterations, size_t arg )
+            : mIterations( iterations )
+            , mRemaining( iterations )
+            , mArg( arg )
+            , mStarted( false )
+            , mElapsed( 0 )
+            , mItems( 0 )
+            , mBytes( 0 )
+        {
+        }
+
+        ///
+        /// Return true while there are iterations left. Timing starts at first call.
+        ///
+        bool keepRunning()
+        {
+            if( !mStarted )
+            {
+                mStarted = true;
+                mStart = ClockType::now();
+            }
+            if( mRemaining > 0 )
+            {
+                --mRemaining;
+                return true;
+            }
+            mElapsed += ClockType::now() - mStart;
+            return false;
+        }
+
+        /// \name exclude setup code inside the loop from timing
+        //@{
+        void pauseTiming() { mElapsed += ClockType::now() - mStart; }
+        void resumeTiming() { mStart = ClockType::now(); }
+        //@}
+
+        size_t iterations() const { return mIterations; }
+        size_t arg() const { return mArg; }
+        void   setItemsProcessed( uint64 n ) { mItems = n; }
+        void   setBytesProcessed( uint64 n ) { mBytes = n; }
+
+        double elapsedSeconds() const { return std::chrono::duration<double>( mElapsed ).count(); }
+        uint64 items() const { return mItems; }
+        uint64 bytes() const { return mBytes; }
+    };
+
+    typedef void (*BenchmarkFunc)( State & );
+
+    ///
+    /// Register benchmark at static initialization time.
+    ///
+    struct Registrar
+    {
+        Registrar( const char * name, BenchmarkFunc func, size_t arg, bool hasArg );
+    };
+
+    ///
+    /// Deterministic pseudo random numbers (64-bit LCG), so results are comparable between runs.
+    ///
+    inline uint64 nextRandom64( uint64 & seed )
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed;
+    }
+
+    /// uniformly distributed in [-1, 1)
+    inline float nextRandomFloat( uint64 & seed ) { return (float)( nextRandom64( seed ) >> 40 ) / (float)( 1 << 23 ) - 1.0f; }
+
+    ///
+    /// Prevent compiler from optimizing away a value.
+    ///
+    template<typename T>
+    inline void doNotOptimize( const T & value )
+    {
+#if GN_MSVC
+        static volatile const void * sink;
+        sink = &value;
+#else
+        asm volatile( "" : : "g"(&value) : "memory" );
+#endif
+    }
+
+    ///
+    /// Run registered benchmarks. Command line options:
+    ///
+    ///     --filter=<substring>    only run benchmarks whose name contains the substring
+    ///     --json=<file>           write results to JSON file
+    ///     --min-time=<seconds>    minimal time of each repetition (default 0.1)
+    ///     --repetitions=<n>       repetitions of each benchmark (default 5)
+    ///
+    int runAll( const char * suiteName, int argc, const char * argv[] );
+}}
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_TEST_BENCH_HARNESS_H__
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare two GNbench JSON result files and flag regressions.
+
+usage: compare.py baseline.json current.json [--threshold=0.10]
+
+A benchmark regresses when its median time grows by more than the threshold
+(relative) and the growth is larger than the noise (stddev) of both runs.
+Exit code is 1 if any regression is found, so the script can gate CI.
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data.get('context', {}), {b['name']: b for b in data['benchmarks']}
+
+
+def main(argv):
+    threshold = 0.10
+    files = []
+    for a in argv[1:]:
+        if a.startswith('--threshold='):
+            threshold = float(a[len('--threshold='):])
+        else:
+            files.append(a)
+    if len(files) != 2:
+        print(__doc__)
+        return 2
+
+    base_ctx, base = load(files[0])
+    curr_ctx, curr = load(files[1])
+    if base_ctx.get('build') != curr_ctx.get('build'):
+        print('warning: comparing %s build against %s build' % (base_ctx.get('build'), curr_ctx.get('build')))
+
+    regressions = 0
+    print('%-40s %14s %14s %9s  %s' % ('benchmark', 'base(ns)', 'current(ns)', 'change', 'status'))
+    for name in sorted(set(base) | set(curr)):
+        if name not in curr:
+            print('%-40s %14s %14s %9s  removed' % (name, '', '', ''))
+            continue
+        if name not in base:
+            print('%-40s %14s %14.2f %9s  new' % (name, '', curr[name]['median_ns'], ''))
+            continue
+        b = base[name]
+        c = curr[name]
+        change = (c['median_ns'] - b['median_ns']) / b['median_ns'] if b['median_ns'] > 0 else 0.0
+        noise = max(b.get('stddev_ns', 0.0), c.get('stddev_ns', 0.0))
+        delta = c['median_ns'] - b['median_ns']
+        if change > threshold and delta > noise:
+            status = 'REGRESSION'
+            regressions += 1
+        elif change < -threshold and -delta > noise:
+            status = 'improved'
+        else:
+            status = ''
+        print('%-40s %14.2f %14.2f %+8.1f%%  %s' % (name, b['median_ns'], c['median_ns'], change * 100.0, status))
+
+    if regressions:
+        print('%d regression(s) beyond %.0f%% threshold.' % (regressions, threshold * 100.0))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
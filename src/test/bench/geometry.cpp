@@ -0,0 +1,665 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+//
+// Batch transformation, matrix inverse, frustum culling, bounding volume and
+// occlusion culling benchmarks. Benchmark argument is the number of elements. Each batch function is paired with the
+// one-at-a-time loop it replaces.
+//
+
+// *****************************************************************************
+// helpers
+// *****************************************************************************
+
+/// source data is shared by all benchmarks, and only grows.
+static const Vector3f * sPoints( size_t count )
+{
+    static std::vector<Vector3f> points;
+    if( points.size() < count )
+    {
+        uint64 seed = 12345;
+        points.resize( count );
+        for( auto & p : points ) p.set( nextRandomFloat( seed ) * 100.0f, nextRandomFloat( seed ) * 100.0f, nextRandomFloat( seed ) * 100.0f );
+    }
+    return points.data();
+}
+
+static Matrix44f sAffine()
+{
+    Matrix44f r, t;
+    r.rotate( Vector3f( 1, 2, 3 ), 0.7f );
+    t.translate( 10, -20, 30 );
+    return t * r;
+}
+
+static Matrix44f sProjective()
+{
+    Matrix44f p;
+    p.perspectiveD3D( 1.0f, 1.5f, 0.1f, 100.0f );
+    return p * sAffine();
+}
+
+// *****************************************************************************
+// points and vectors, AoS
+// *****************************************************************************
+
+static void TransformPoints_loop( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector3f> dst( state.arg() );
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) m.transformPoint( dst[i], src[i] );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformPoints_loop, 1000 );
+GN_BENCHMARK_ARG( TransformPoints_loop, 100000 );
+GN_BENCHMARK_ARG( TransformPoints_loop, 10000000 );
+
+static void TransformPoints_batch( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector3f> dst( state.arg() );
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        transformPoints( dst.data(), m, src, state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformPoints_batch, 1000 );
+GN_BENCHMARK_ARG( TransformPoints_batch, 100000 );
+GN_BENCHMARK_ARG( TransformPoints_batch, 10000000 );
+
+static void TransformPointsProjective_batch( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector3f> dst( state.arg() );
+    Matrix44f m = sProjective();
+    while( state.keepRunning() )
+    {
+        transformPoints( dst.data(), m, src, state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformPointsProjective_batch, 1000 );
+GN_BENCHMARK_ARG( TransformPointsProjective_batch, 100000 );
+GN_BENCHMARK_ARG( TransformPointsProjective_batch, 10000000 );
+
+static void TransformPointsToClip_loop( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector4f> dst( state.arg() );
+    Matrix44f m = sProjective();
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) dst[i] = m * Vector4f( src[i], 1.0f );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformPointsToClip_loop, 1000 );
+GN_BENCHMARK_ARG( TransformPointsToClip_loop, 100000 );
+GN_BENCHMARK_ARG( TransformPointsToClip_loop, 10000000 );
+
+static void TransformPointsToClip_batch( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector4f> dst( state.arg() );
+    Matrix44f m = sProjective();
+    while( state.keepRunning() )
+    {
+        transformPoints( dst.data(), sizeof(Vector4f), m, src, sizeof(Vector3f), state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformPointsToClip_batch, 1000 );
+GN_BENCHMARK_ARG( TransformPointsToClip_batch, 100000 );
+GN_BENCHMARK_ARG( TransformPointsToClip_batch, 10000000 );
+
+static void TransformVectors_batch( State & state )
+{
+    const Vector3f * src = sPoints( state.arg() );
+    std::vector<Vector3f> dst( state.arg() );
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        transformVectors( dst.data(), m, src, state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformVectors_batch, 1000 );
+GN_BENCHMARK_ARG( TransformVectors_batch, 100000 );
+GN_BENCHMARK_ARG( TransformVectors_batch, 10000000 );
+
+// *****************************************************************************
+// points, SoA
+// *****************************************************************************
+
+static void TransformPointsSoA_batch( State & state )
+{
+    size_t n = state.arg();
+    const Vector3f * points = sPoints( n );
+    std::vector<float> src( n * 3 ), dst( n * 3 );
+    for( size_t i = 0; i < n; ++i )
+    {
+        src[i] = points[i].x;
+        src[n+i] = points[i].y;
+        src[n*2+i] = points[i].z;
+    }
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        transformPointsSoA( &dst[0], &dst[n], &dst[n*2], m, &src[0], &src[n], &src[n*2], n );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * n );
+}
+GN_BENCHMARK_ARG( TransformPointsSoA_batch, 1000 );
+GN_BENCHMARK_ARG( TransformPointsSoA_batch, 100000 );
+GN_BENCHMARK_ARG( TransformPointsSoA_batch, 10000000 );
+
+// *****************************************************************************
+// bounding boxes
+// *****************************************************************************
+
+static std::vector<Boxf> sBoxes( size_t count )
+{
+    const Vector3f * p = sPoints( count * 2 );
+    std::vector<Boxf> boxes( count );
+    for( size_t i = 0; i < count; ++i ) boxes[i] = Boxf( p[i*2], p[i*2] + p[i*2+1] * 0.1f );
+    return boxes;
+}
+
+static void TransformBoxes_corners( State & state )
+{
+    std::vector<Boxf> src = sBoxes( state.arg() ), dst( state.arg() );
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i )
+        {
+            Vector3f corners[8];
+            for( int c = 0; c < 8; ++c ) m.transformPoint( corners[c], src[i].corner( c ) );
+            calculateBoundingBox( dst[i], corners, sizeof(Vector3f), 8 );
+        }
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformBoxes_corners, 1000 );
+GN_BENCHMARK_ARG( TransformBoxes_corners, 100000 );
+GN_BENCHMARK_ARG( TransformBoxes_corners, 10000000 );
+
+static void TransformBoxes_batch( State & state )
+{
+    std::vector<Boxf> src = sBoxes( state.arg() ), dst( state.arg() );
+    Matrix44f m = sAffine();
+    while( state.keepRunning() )
+    {
+        transformBoxes( dst.data(), m, src.data(), state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( TransformBoxes_batch, 1000 );
+GN_BENCHMARK_ARG( TransformBoxes_batch, 100000 );
+GN_BENCHMARK_ARG( TransformBoxes_batch, 10000000 );
+
+// *****************************************************************************
+// matrix arrays
+// *****************************************************************************
+
+// 10M matrices take 640MB per array, so matrix benchmarks stop at 1M.
+
+static std::vector<Matrix44f> sMatrices( size_t count )
+{
+    const Vector3f * p = sPoints( count );
+    std::vector<Matrix44f> matrices( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        matrices[i].rotate( p[i], p[i].x );
+        matrices[i][0][3] = p[i].y;
+    }
+    return matrices;
+}
+
+static void MultiplyMatrices_loop( State & state )
+{
+    std::vector<Matrix44f> local = sMatrices( state.arg() ), world( state.arg() );
+    Matrix44f parent = sAffine();
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) world[i] = parent * local[i];
+        doNotOptimize( world.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( MultiplyMatrices_loop, 1000 );
+GN_BENCHMARK_ARG( MultiplyMatrices_loop, 100000 );
+GN_BENCHMARK_ARG( MultiplyMatrices_loop, 1000000 );
+
+static void MultiplyMatrices_batch( State & state )
+{
+    std::vector<Matrix44f> local = sMatrices( state.arg() ), world( state.arg() );
+    Matrix44f parent = sAffine();
+    while( state.keepRunning() )
+    {
+        multiplyMatrices( world.data(), parent, local.data(), state.arg() );
+        doNotOptimize( world.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( MultiplyMatrices_batch, 1000 );
+GN_BENCHMARK_ARG( MultiplyMatrices_batch, 100000 );
+GN_BENCHMARK_ARG( MultiplyMatrices_batch, 1000000 );
+
+static void MultiplyMatrixArrays_batch( State & state )
+{
+    std::vector<Matrix44f> a = sMatrices( state.arg() ), b = a, dst( state.arg() );
+    while( state.keepRunning() )
+    {
+        multiplyMatrices( dst.data(), a.data(), b.data(), state.arg() );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( MultiplyMatrixArrays_batch, 1000 );
+GN_BENCHMARK_ARG( MultiplyMatrixArrays_batch, 100000 );
+GN_BENCHMARK_ARG( MultiplyMatrixArrays_batch, 1000000 );
+
+// *****************************************************************************
+// matrix inverse
+// *****************************************************************************
+
+/// TRS matrices, as built by SpacialComponent. Rigid ones if scale is false.
+static std::vector<Matrix44f> sTRSMatrices( size_t count, bool scale )
+{
+    const Vector3f * p = sPoints( count * 2 );
+    std::vector<Matrix44f> matrices( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        const Vector3f & a = p[i*2];
+        const Vector3f & b = p[i*2+1];
+        Quaternionf q( a.x, a.y, a.z, b.x );
+        q.normalize();
+        Vector3f s = scale ? Vector3f( 1.5f + a.x * 0.01f, 2.0f, 0.5f ) : Vector3f( 1, 1, 1 );
+        matrices[i] = Transformf::sTRS( b, q, s ).matrix();
+    }
+    return matrices;
+}
+
+template<Matrix44f (*INVERT)( const Matrix44f & )>
+static void sInverse( State & state, bool scale )
+{
+    std::vector<Matrix44f> src = sTRSMatrices( state.arg(), scale ), dst( state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < state.arg(); ++i ) dst[i] = INVERT( src[i] );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+
+static void Inverse_general( State & state ) { sInverse<&Matrix44f::sInverse>( state, true ); }
+GN_BENCHMARK_ARG( Inverse_general, 1000 );
+GN_BENCHMARK_ARG( Inverse_general, 100000 );
+
+static void Inverse_affine( State & state ) { sInverse<&Matrix44f::sInvertAffine>( state, true ); }
+GN_BENCHMARK_ARG( Inverse_affine, 1000 );
+GN_BENCHMARK_ARG( Inverse_affine, 100000 );
+
+static void Inverse_TRS( State & state ) { sInverse<&Matrix44f::sInvertTRS>( state, true ); }
+GN_BENCHMARK_ARG( Inverse_TRS, 1000 );
+GN_BENCHMARK_ARG( Inverse_TRS, 100000 );
+
+static void Inverse_rigid( State & state ) { sInverse<&Matrix44f::sInvertRigid>( state, false ); }
+GN_BENCHMARK_ARG( Inverse_rigid, 1000 );
+GN_BENCHMARK_ARG( Inverse_rigid, 100000 );
+
+// *****************************************************************************
+// frustum culling
+// *****************************************************************************
+
+/// boxes scattered around the camera, about 1/8 of them are visible.
+static const Boxf * sSceneBoxes( size_t count )
+{
+    static std::vector<Boxf> boxes;
+    if( boxes.size() < count )
+    {
+        uint64 seed = 54321;
+        boxes.resize( count );
+        for( auto & b : boxes ) b.set( nextRandomFloat( seed ) * 100.0f, nextRandomFloat( seed ) * 100.0f, nextRandomFloat( seed ) * 100.0f, 1.0f, 2.0f, 1.0f );
+    }
+    return boxes.data();
+}
+
+static Frustum sFrustum()
+{
+    Matrix44f proj, view;
+    proj.perspectiveD3D( 1.0f, 1.5f, 0.1f, 100.0f );
+    view.lookAt( Vector3f( 0, 0, 0 ), Vector3f( 1, 0.5f, 1 ), Vector3f( 0, 1, 0 ) );
+    Frustum f;
+    f.fromMatrix( proj * view, true );
+    return f;
+}
+
+static void CullBoxes_loop( State & state )
+{
+    const Boxf * boxes = sSceneBoxes( state.arg() );
+    std::vector<uint32> visible( state.arg() );
+    Frustum f = sFrustum();
+    while( state.keepRunning() )
+    {
+        size_t n = 0;
+        for( size_t i = 0; i < state.arg(); ++i ) if( f.testBox( boxes[i] ) ) visible[n++] = (uint32)i;
+        doNotOptimize( n );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( CullBoxes_loop, 100000 );
+GN_BENCHMARK_ARG( CullBoxes_loop, 1000000 );
+
+static void CullBoxes_batch( State & state )
+{
+    const Boxf * boxes = sSceneBoxes( state.arg() );
+    std::vector<uint32> visible( state.arg() );
+    Frustum f = sFrustum();
+    while( state.keepRunning() )
+    {
+        doNotOptimize( cullBoxes( visible.data(), f, boxes, state.arg() ) );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( CullBoxes_batch, 100000 );
+GN_BENCHMARK_ARG( CullBoxes_batch, 1000000 );
+
+static void CullBoxes_planeCache( State & state )
+{
+    const Boxf * boxes = sSceneBoxes( state.arg() );
+    std::vector<uint32> visible( state.arg() );
+    std::vector<uint8> cache( state.arg(), 0 );
+    Frustum f = sFrustum();
+    while( state.keepRunning() )
+    {
+        doNotOptimize( cullBoxes( visible.data(), f, boxes, state.arg(), cache.data() ) );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( CullBoxes_planeCache, 100000 );
+GN_BENCHMARK_ARG( CullBoxes_planeCache, 1000000 );
+
+static void CullBoxes_parallel( State & state )
+{
+    const Boxf * boxes = sSceneBoxes( state.arg() );
+    std::vector<uint32> visible( state.arg() );
+    std::vector<uint8> cache( state.arg(), 0 );
+    Frustum f = sFrustum();
+    JobSystem & js = JobSystem::sGetGlobalInstance();
+    while( state.keepRunning() )
+    {
+        doNotOptimize( cullBoxes( js, visible.data(), f, boxes, state.arg(), cache.data() ) );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( CullBoxes_parallel, 100000 );
+GN_BENCHMARK_ARG( CullBoxes_parallel, 1000000 );
+
+// *****************************************************************************
+// bounding volumes
+// *****************************************************************************
+
+/// rotated, elongated cloud of points, like the vertices of a typical mesh.
+static const Vector3f * sMeshPoints( size_t count )
+{
+    static std::vector<Vector3f> points;
+    if( points.size() < count )
+    {
+        Vector3f a( 1, 1, 0 ), b( -1, 1, 1 );
+        a.normalize();
+        b.normalize();
+        Vector3f c = Vector3f::sCross( a, b );
+        uint64 seed = 777;
+        points.resize( count );
+        for( auto & p : points )
+        {
+            Vector3f v( nextRandomFloat( seed ), nextRandomFloat( seed ), nextRandomFloat( seed ) );
+            v.normalize();
+            v = v * sqrtf( fabs( nextRandomFloat( seed ) ) );
+            p = a * ( v.x * 20.0f ) + b * ( v.y * 5.0f ) + c * ( v.z * 2.0f ) + Vector3f( 10, 0, -3 );
+        }
+    }
+    return points.data();
+}
+
+template<typename BV, void (*CALC)( BV &, const Vector3f *, size_t, size_t )>
+static void sBoundingVolume( State & state )
+{
+    const Vector3f * points = sMeshPoints( state.arg() );
+    BV bv;
+    while( state.keepRunning() )
+    {
+        CALC( bv, points, sizeof(Vector3f), state.arg() );
+        doNotOptimize( bv );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+
+static void BoundingBox( State & state ) { sBoundingVolume<Boxf, &calculateBoundingBox>( state ); }
+GN_BENCHMARK_ARG( BoundingBox, 100000 );
+
+static void BoundingSphere_fast( State & state ) { sBoundingVolume<Spheref, &calculateBoundingSphere>( state ); }
+GN_BENCHMARK_ARG( BoundingSphere_fast, 100000 );
+
+static void BoundingSphere_ritter( State & state ) { sBoundingVolume<Spheref, &calculateBoundingSphereRitter>( state ); }
+GN_BENCHMARK_ARG( BoundingSphere_ritter, 100000 );
+
+static void BoundingSphere_minimal( State & state ) { sBoundingVolume<Spheref, &calculateMinimalBoundingSphere>( state ); }
+GN_BENCHMARK_ARG( BoundingSphere_minimal, 100000 );
+
+static void OrientedBoundingBox( State & state ) { sBoundingVolume<OrientedBoxf, &calculateOrientedBoundingBox>( state ); }
+GN_BENCHMARK_ARG( OrientedBoundingBox, 100000 );
+
+static void Dop_8( State & state ) { sBoundingVolume<Dop8, &calculateDop>( state ); }
+GN_BENCHMARK_ARG( Dop_8, 100000 );
+
+static void Dop_14( State & state ) { sBoundingVolume<Dop14, &calculateDop>( state ); }
+GN_BENCHMARK_ARG( Dop_14, 100000 );
+
+static void Dop_18( State & state ) { sBoundingVolume<Dop18, &calculateDop>( state ); }
+GN_BENCHMARK_ARG( Dop_18, 100000 );
+
+static void Dop_26( State & state ) { sBoundingVolume<Dop26, &calculateDop>( state ); }
+GN_BENCHMARK_ARG( Dop_26, 100000 );
+
+/// estimate k-DOP volume by sampling its bounding box.
+template<int K>
+static float sDopVolume( const Dop<K> & dop, const Boxf & box )
+{
+    uint64 seed = 99;
+    size_t inside = 0, samples = 200000;
+    for( size_t i = 0; i < samples; ++i )
+    {
+        Vector3f p( box.x + ( nextRandomFloat( seed ) + 1 ) * 0.5f * box.w,
+                    box.y + ( nextRandomFloat( seed ) + 1 ) * 0.5f * box.h,
+                    box.z + ( nextRandomFloat( seed ) + 1 ) * 0.5f * box.d );
+        if( dop.contains( p ) ) ++inside;
+    }
+    return box.w * box.h * box.d * inside / samples;
+}
+
+/// print volume of each bounding volume relative to the AABB (smaller is tighter).
+static void sPrintTightness()
+{
+    const size_t N = 100000;
+    const Vector3f * p = sMeshPoints( N );
+    const size_t s = sizeof(Vector3f);
+
+    Boxf box; calculateBoundingBox( box, p, s, N );
+    Spheref fast; calculateBoundingSphere( fast, p, s, N );
+    Spheref ritter; calculateBoundingSphereRitter( ritter, p, s, N );
+    Spheref minimal; calculateMinimalBoundingSphere( minimal, p, s, N );
+    OrientedBoxf obb; calculateOrientedBoundingBox( obb, p, s, N );
+    Dop8 d8; calculateDop( d8, p, s, N );
+    Dop14 d14; calculateDop( d14, p, s, N );
+    Dop18 d18; calculateDop( d18, p, s, N );
+    Dop26 d26; calculateDop( d26, p, s, N );
+
+    float aabb = box.w * box.h * box.d;
+    auto sphere = []( const Spheref & s ) { return 4.0f / 3.0f * GN_PI * s.radius * s.radius * s.radius; };
+
+    printf( "bounding volume tightness of %d points (volume / AABB volume):\n", (int)N );
+    printf( "  %-24s %8.3f\n", "AABB", 1.0f );
+    printf( "  %-24s %8.3f\n", "sphere (fast)", sphere( fast ) / aabb );
+    printf( "  %-24s %8.3f\n", "sphere (Ritter)", sphere( ritter ) / aabb );
+    printf( "  %-24s %8.3f\n", "sphere (minimal)", sphere( minimal ) / aabb );
+    printf( "  %-24s %8.3f\n", "OBB (PCA)", obb.volume() / aabb );
+    printf( "  %-24s %8.3f\n", "8-DOP", sDopVolume( d8, box ) / aabb );
+    printf( "  %-24s %8.3f\n", "14-DOP", sDopVolume( d14, box ) / aabb );
+    printf( "  %-24s %8.3f\n", "18-DOP", sDopVolume( d18, box ) / aabb );
+    printf( "  %-24s %8.3f\n\n", "26-DOP", sDopVolume( d26, box ) / aabb );
+}
+
+// *****************************************************************************
+// occlusion culling
+// *****************************************************************************
+
+/// synthetic city: a grid of buildings along streets, viewed from the street level.
+struct City
+{
+    Matrix44f              viewProj;
+    std::vector<Matrix44f> buildings; ///< clip from unit cube
+    std::vector<Boxf>      props;     ///< small boxes on the streets, behind or between buildings
+
+    City( size_t numBuildings, size_t numProps )
+    {
+        Matrix44f proj, view;
+        proj.perspectiveD3DRh( 1.0f, 16.0f / 9.0f, 0.5f, 1000.0f );
+        view.lookAtRh( Vector3f( 3, 1.8f, 0 ), Vector3f( 20, 1.8f, -100 ), Vector3f( 0, 1, 0 ) );
+        viewProj = proj * view;
+
+        uint64 seed = 2024;
+        size_t side = (size_t)sqrtf( (float)numBuildings ) + 1;
+        for( size_t i = 0; i < numBuildings; ++i )
+        {
+            float x = ( i % side ) * 20.0f - side * 10.0f, z = -( (float)( i / side ) ) * 20.0f - 10.0f;
+            Matrix44f world;
+            world.identity();
+            world.rows[0].set( 14.0f + nextRandomFloat( seed ), 0, 0, x );
+            world.rows[1].set( 0, 20.0f + nextRandomFloat( seed ) * 10.0f, 0, 0 );
+            world.rows[2].set( 0, 0, 14.0f + nextRandomFloat( seed ), z );
+            buildings.push_back( viewProj * world );
+        }
+        for( size_t i = 0; i < numProps; ++i )
+        {
+            props.push_back( Boxf( nextRandomFloat( seed ) * side * 10.0f, 0, ( nextRandomFloat( seed ) - 1 ) * side * 10.0f, 1, 2, 1 ) );
+        }
+    }
+
+    void addOccluders( OcclusionBuffer & ob ) const
+    {
+        static const Vector3f v[8] = {
+            Vector3f( 0, 0, 0 ), Vector3f( 1, 0, 0 ), Vector3f( 0, 1, 0 ), Vector3f( 1, 1, 0 ),
+            Vector3f( 0, 0, 1 ), Vector3f( 1, 0, 1 ), Vector3f( 0, 1, 1 ), Vector3f( 1, 1, 1 ) };
+        static const uint16 indices[36] = {
+            0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,  0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,  0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3 };
+        for( const Matrix44f & m : buildings ) ob.addOccluder( m, v, sizeof(Vector3f), 8, indices, 36 );
+    }
+};
+
+static const City & sCity()
+{
+    static City city( 1024, 100000 );
+    return city;
+}
+
+static void OcclusionRender_serial( State & state )
+{
+    const City & city = sCity();
+    OcclusionBuffer ob;
+    ob.init( 640, 360 );
+    while( state.keepRunning() )
+    {
+        ob.clear();
+        city.addOccluders( ob );
+        ob.render();
+        doNotOptimize( ob.getBlockDepth()[0] );
+    }
+    state.setItemsProcessed( state.iterations() * city.buildings.size() );
+}
+GN_BENCHMARK( OcclusionRender_serial );
+
+static void OcclusionRender_parallel( State & state )
+{
+    const City & city = sCity();
+    OcclusionBuffer ob;
+    ob.init( 640, 360 );
+    JobSystem & js = JobSystem::sGetGlobalInstance();
+    while( state.keepRunning() )
+    {
+        ob.clear();
+        city.addOccluders( ob );
+        ob.render( js );
+        doNotOptimize( ob.getBlockDepth()[0] );
+    }
+    state.setItemsProcessed( state.iterations() * city.buildings.size() );
+}
+GN_BENCHMARK( OcclusionRender_parallel );
+
+static void OcclusionTest_boxes( State & state )
+{
+    const City & city = sCity();
+    OcclusionBuffer ob;
+    ob.init( 640, 360 );
+    city.addOccluders( ob );
+    ob.render();
+    std::vector<uint32> visible( state.arg() );
+    while( state.keepRunning() )
+    {
+        doNotOptimize( ob.testBoxes( visible.data(), city.viewProj, city.props.data(), state.arg() ) );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() );
+}
+GN_BENCHMARK_ARG( OcclusionTest_boxes, 100000 );
+
+/// print ratio of props culled by frustum and by occlusion.
+static void sPrintOcclusion()
+{
+    const City & city = sCity();
+    OcclusionBuffer ob;
+    ob.init( 640, 360 );
+    city.addOccluders( ob );
+    ob.render();
+
+    Frustum f;
+    f.fromMatrix( city.viewProj, true );
+    std::vector<uint32> visible( city.props.size() );
+    size_t inFrustum = cullBoxes( visible.data(), f, city.props.data(), city.props.size() );
+    size_t notOccluded = ob.testBoxes( visible.data(), city.viewProj, city.props.data(), city.props.size() );
+
+    printf( "city of %d buildings (%d triangles), %d props:\n", (int)city.buildings.size(), (int)ob.getTriangleCount(), (int)city.props.size() );
+    printf( "  %-24s %8d\n", "in frustum", (int)inFrustum );
+    printf( "  %-24s %8d\n\n", "not occluded", (int)notOccluded );
+}
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    sPrintTightness();
+    sPrintOcclusion();
+    return runAll( "GNbench-geometry", argc, argv );
+}
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include "garnet/GNgfx.h"
+
+using namespace GN;
+using namespace GN::gfx;
+using namespace GN::bench;
+
+//
+// GPU submit throughput against the fake GPU, which drops every command, so
+// only front end cost is measured. Benchmark argument is 0 for the single
+// thread GPU and 1 for the multi thread GPU. Items are GPU calls.
+//
+
+static const uint32 CALLS_PER_FRAME = 1000;
+
+/// Create fake GPU. Caller owns the returned GPU.
+static Gpu * sCreateGpu( size_t multithread, uint32 framesInFlight = 2 )
+{
+    GpuOptions o;
+    o.api = GpuAPI::FAKE;
+    o.displayMode.width = 64;
+    o.displayMode.height = 64;
+    o.maxFramesInFlight = framesInFlight;
+    return createGpu( o, multithread ? GPU_CREATION_MULTIPLE_THREADS : 0 );
+}
+
+// *****************************************************************************
+// draw calls
+// *****************************************************************************
+
+static void Submit_Draw( State & state )
+{
+    Gpu * gpu = sCreateGpu( state.arg() );
+    if( !gpu ) return;
+    while( state.keepRunning() )
+    {
+        for( uint32 i = 0; i < CALLS_PER_FRAME; ++i ) gpu->draw( PrimitiveType::TRIANGLE_LIST, 3, i );
+        gpu->present();
+    }
+    state.setItemsProcessed( state.iterations() * CALLS_PER_FRAME );
+    deleteGpu( gpu );
+}
+GN_BENCHMARK_ARG( Submit_Draw, 0 );
+GN_BENCHMARK_ARG( Submit_Draw, 1 );
+
+static void Submit_DrawIndexed( State & state )
+{
+    Gpu * gpu = sCreateGpu( state.arg() );
+    if( !gpu ) return;
+    while( state.keepRunning() )
+    {
+        for( uint32 i = 0; i < CALLS_PER_FRAME; ++i ) gpu->drawIndexed( PrimitiveType::TRIANGLE_LIST, 36, 0, 0, 24, i );
+        gpu->present();
+    }
+    state.setItemsProcessed( state.iterations() * CALLS_PER_FRAME );
+    deleteGpu( gpu );
+}
+GN_BENCHMARK_ARG( Submit_DrawIndexed, 0 );
+GN_BENCHMARK_ARG( Submit_DrawIndexed, 1 );
+
+static void Submit_Clear( State & state )
+{
+    Gpu * gpu = sCreateGpu( state.arg() );
+    if( !gpu ) return;
+    while( state.keepRunning() )
+    {
+        for( uint32 i = 0; i < 16; ++i ) gpu->clearScreen();
+        gpu->present();
+    }
+    state.setItemsProcessed( state.iterations() * 16 );
+    deleteGpu( gpu );
+}
+GN_BENCHMARK_ARG( Submit_Clear, 0 );
+GN_BENCHMARK_ARG( Submit_Clear, 1 );
+
+// *****************************************************************************
+// resource uploads
+// *****************************************************************************
+
+static void Submit_VtxBufUpdate( State & state )
+{
+    Gpu * gpu = sCreateGpu( state.arg() );
+    if( !gpu ) return;
+    {
+        VtxBufDesc vbd = { 64 * 1024, true };
+        AutoRef<VtxBuf> vb = attachTo( gpu->createVtxBuf( vbd ) );
+        uint8 vertices[256] = {};
+        while( state.keepRunning() )
+        {
+            for( uint32 i = 0; i < 256; ++i ) vb->update( i * 256, sizeof(vertices), vertices );
+            gpu->present();
+        }
+        state.setItemsProcessed( state.iterations() * 256 );
+    }
+    deleteGpu( gpu );
+}
+GN_BENCHMARK_ARG( Submit_VtxBufUpdate, 0 );
+GN_BENCHMARK_ARG( Submit_VtxBufUpdate, 1 );
+
+// *****************************************************************************
+// round trip: each readback waits for GPU thread to drain the command buffer
+// *****************************************************************************
+
+static void Submit_Readback( State & state )
+{
+    Gpu * gpu = sCreateGpu( state.arg() );
+    if( !gpu ) return;
+    {
+        VtxBufDesc vbd = { 256, false };
+        AutoRef<VtxBuf> vb = attachTo( gpu->createVtxBuf( vbd ) );
+        DynaArray<uint8> data;
+        while( state.keepRunning() )
+        {
+            gpu->draw( PrimitiveType::TRIANGLE_LIST, 3, 0 );
+            vb->readback( data );
+            doNotOptimize( data.rawptr() );
+        }
+        state.setItemsProcessed( state.iterations() );
+    }
+    deleteGpu( gpu );
+}
+GN_BENCHMARK_ARG( Submit_Readback, 0 );
+GN_BENCHMARK_ARG( Submit_Readback, 1 );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-gpu", argc, argv );
+}
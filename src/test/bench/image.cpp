@@ -0,0 +1,629 @@
+#include "pch.h"
+#include "garnet/GNgfx.h"
+#include "benchHarness.h"
+#include "stb_image.h"
+#include <png.h>
+#include <stdio.h>
+#include <vector>
+extern "C" {
+#include <jpeglib.h>
+}
+
+using namespace GN;
+using namespace GN::gfx;
+using namespace GN::bench;
+
+//
+// Pixel format conversion benchmarks. Benchmark argument is the number of pixels, or the
+// number of worker threads for whole image conversion. Formats without a fast path show the
+// cost of the generic bit field codecs. Block compression benchmarks take the quality preset
+// (0 = FAST, 1 = NORMAL, 2 = HIGH) as argument. Mipmap benchmarks take the filter (0 = BOX,
+// 1 = KAISER, 2 = LANCZOS), or the number of worker threads. Image saving benchmarks take the
+// file format (0 = DDS, 1 = DDS_DX10, 2 = PNG, 3 = TGA). Image loading benchmarks take the
+// corpus (0 = PNG, 1 = JPEG), or the number of worker threads. The mixed corpus takes the
+// format to load as (0 = as in file, 1 = RGBA8), and prints the memory of the loaded images.
+//
+
+// *****************************************************************************
+// helpers
+// *****************************************************************************
+
+/// random bytes, shared by all benchmarks, and only grows.
+static const uint8 * sBytes( size_t count )
+{
+    static std::vector<uint8> bytes;
+    if( bytes.size() < count )
+    {
+        uint64 seed = 12345;
+        bytes.resize( count );
+        for( auto & b : bytes ) b = (uint8)( nextRandom64( seed ) >> 56 );
+    }
+    return bytes.data();
+}
+
+static void sConvert( State & state, ColorFormat from, ColorFormat to )
+{
+    size_t n = state.arg();
+    const uint8 * src = sBytes( n * from.getBytesPerBlock() );
+    std::vector<uint8> dst( n * to.getBytesPerBlock() );
+    while( state.keepRunning() )
+    {
+        convertPixels( from, src, to, dst.data(), n );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * n );
+    state.setBytesProcessed( state.iterations() * n * from.getBytesPerBlock() );
+}
+
+// *****************************************************************************
+// pixel arrays
+// *****************************************************************************
+
+static void ConvertRGBA8ToBGRA8( State & state ) { sConvert( state, ColorFormat::RGBA8, ColorFormat::BGRA8 ); }
+GN_BENCHMARK_ARG( ConvertRGBA8ToBGRA8, 4096 );
+GN_BENCHMARK_ARG( ConvertRGBA8ToBGRA8, 1 << 20 );
+
+static void ConvertRGB8ToRGBA8( State & state ) { sConvert( state, ColorFormat::RGB_8_8_8_UNORM, ColorFormat::RGBA8 ); }
+GN_BENCHMARK_ARG( ConvertRGB8ToRGBA8, 4096 );
+GN_BENCHMARK_ARG( ConvertRGB8ToRGBA8, 1 << 20 );
+
+static void ConvertRGBA8ToFloat4( State & state ) { sConvert( state, ColorFormat::RGBA8, ColorFormat::FLOAT4 ); }
+GN_BENCHMARK_ARG( ConvertRGBA8ToFloat4, 4096 );
+GN_BENCHMARK_ARG( ConvertRGBA8ToFloat4, 1 << 20 );
+
+static void ConvertFloat4ToRGBA8( State & state ) { sConvert( state, ColorFormat::FLOAT4, ColorFormat::RGBA8 ); }
+GN_BENCHMARK_ARG( ConvertFloat4ToRGBA8, 4096 );
+GN_BENCHMARK_ARG( ConvertFloat4ToRGBA8, 1 << 20 );
+
+// RGBA8 SNORM has no fast path. So these go through the generic bit field codecs.
+static void ConvertRGBA8SnormToFloat4_generic( State & state ) { sConvert( state, ColorFormat::RGBA_8_8_8_8_SNORM, ColorFormat::FLOAT4 ); }
+GN_BENCHMARK_ARG( ConvertRGBA8SnormToFloat4_generic, 4096 );
+GN_BENCHMARK_ARG( ConvertRGBA8SnormToFloat4_generic, 1 << 20 );
+
+static void ConvertFloat4ToRGBA8Snorm_generic( State & state ) { sConvert( state, ColorFormat::FLOAT4, ColorFormat::RGBA_8_8_8_8_SNORM ); }
+GN_BENCHMARK_ARG( ConvertFloat4ToRGBA8Snorm_generic, 4096 );
+GN_BENCHMARK_ARG( ConvertFloat4ToRGBA8Snorm_generic, 1 << 20 );
+
+static void ConvertSRGBA8ToFloat4( State & state ) { sConvert( state, ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, ColorFormat::FLOAT4 ); }
+GN_BENCHMARK_ARG( ConvertSRGBA8ToFloat4, 1 << 20 );
+
+static void ConvertFloat4ToSRGBA8( State & state ) { sConvert( state, ColorFormat::FLOAT4, ColorFormat::RGBA_8_8_8_8_UNORM_SRGB ); }
+GN_BENCHMARK_ARG( ConvertFloat4ToSRGBA8, 1 << 20 );
+
+static void ConvertBGR565ToHalf4( State & state ) { sConvert( state, ColorFormat::BGR_5_6_5_UNORM, ColorFormat::HALF4 ); }
+GN_BENCHMARK_ARG( ConvertBGR565ToHalf4, 1 << 20 );
+
+// *****************************************************************************
+// whole image, 4096 x 4096 RGBA8 to HALF4
+// *****************************************************************************
+
+static const RawImage & sImage4K()
+{
+    static RawImage image( ImageDesc( ImagePlaneDesc::make( ColorFormat::RGBA8, 4096, 4096 ) ), sBytes( 4096 * 4096 * 4 ) );
+    return image;
+}
+
+static void ConvertImage4K_serial( State & state )
+{
+    const RawImage & src = sImage4K();
+    RawImage dst;
+    while( state.keepRunning() )
+    {
+        convertImage( src.desc(), src.data(), ColorFormat::HALF4, dst );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * 4096 * 4096 );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+GN_BENCHMARK( ConvertImage4K_serial );
+
+static void ConvertImage4K_parallel( State & state )
+{
+    const RawImage & src = sImage4K();
+    RawImage dst;
+    JobSystem js( (uint32)state.arg() );
+    while( state.keepRunning() )
+    {
+        convertImage( src.desc(), src.data(), ColorFormat::HALF4, dst, js );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * 4096 * 4096 );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+GN_BENCHMARK_ARG( ConvertImage4K_parallel, 2 );
+GN_BENCHMARK_ARG( ConvertImage4K_parallel, 4 );
+GN_BENCHMARK_ARG( ConvertImage4K_parallel, 8 );
+
+// *****************************************************************************
+// block compression, of a 1024 x 1024 RGBA8 image of gradients, edges and a bit of noise
+// *****************************************************************************
+
+static const RawImage & sImage1K()
+{
+    static const RawImage image = []() {
+        std::vector<uint8> pixels( 1024 * 1024 * 4 );
+        const uint8 * noise = sBytes( pixels.size() );
+        for( uint32 y = 0; y < 1024; ++y )
+        for( uint32 x = 0; x < 1024; ++x )
+        {
+            size_t i = ( y * 1024 + x ) * 4;
+            uint32 c[4] = { x / 4, y / 4, ( ( x / 64 + y / 64 ) & 1 ) ? 200u : 40u, 255 - ( x + y ) / 8 };
+            for( int k = 0; k < 4; ++k ) pixels[i + k] = (uint8)math::clamp<uint32>( c[k] + ( noise[i + k] & 7 ), 4, 255 ) - 4;
+        }
+        return RawImage( ImageDesc( ImagePlaneDesc::make( ColorFormat::RGBA8, 1024, 1024 ) ), pixels.data() );
+    }();
+    return image;
+}
+
+static void sEncode( State & state, ColorFormat format )
+{
+    const RawImage & src = sImage1K();
+    BlockCompressionQuality quality = (BlockCompressionQuality)state.arg();
+    RawImage dst;
+    while( state.keepRunning() )
+    {
+        convertImage( src.desc(), src.data(), format, dst, quality );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * 1024 * 1024 );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+
+static void sDecode( State & state, ColorFormat format )
+{
+    const RawImage & src = sImage1K();
+    RawImage blocks, dst;
+    convertImage( src.desc(), src.data(), format, blocks, BlockCompressionQuality::FAST );
+    while( state.keepRunning() )
+    {
+        convertImage( blocks.desc(), blocks.data(), ColorFormat::RGBA8, dst );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * 1024 * 1024 );
+    state.setBytesProcessed( state.iterations() * blocks.size() );
+}
+
+static void EncodeBC1( State & state ) { sEncode( state, ColorFormat::DXT1_UNORM ); }
+GN_BENCHMARK_ARG( EncodeBC1, 0 );
+GN_BENCHMARK_ARG( EncodeBC1, 1 );
+GN_BENCHMARK_ARG( EncodeBC1, 2 );
+
+static void EncodeBC3( State & state ) { sEncode( state, ColorFormat::DXT5_UNORM ); }
+GN_BENCHMARK_ARG( EncodeBC3, 0 );
+GN_BENCHMARK_ARG( EncodeBC3, 1 );
+GN_BENCHMARK_ARG( EncodeBC3, 2 );
+
+static void EncodeBC5( State & state ) { sEncode( state, ColorFormat::DXN_UNORM ); }
+GN_BENCHMARK_ARG( EncodeBC5, 0 );
+GN_BENCHMARK_ARG( EncodeBC5, 1 );
+GN_BENCHMARK_ARG( EncodeBC5, 2 );
+
+static void EncodeBC7( State & state ) { sEncode( state, ColorFormat::BC7_UNORM ); }
+GN_BENCHMARK_ARG( EncodeBC7, 0 );
+GN_BENCHMARK_ARG( EncodeBC7, 1 );
+GN_BENCHMARK_ARG( EncodeBC7, 2 );
+
+static void DecodeBC1( State & state ) { sDecode( state, ColorFormat::DXT1_UNORM ); }
+GN_BENCHMARK( DecodeBC1 );
+
+static void DecodeBC3( State & state ) { sDecode( state, ColorFormat::DXT5_UNORM ); }
+GN_BENCHMARK( DecodeBC3 );
+
+static void DecodeBC5( State & state ) { sDecode( state, ColorFormat::DXN_UNORM ); }
+GN_BENCHMARK( DecodeBC5 );
+
+static void DecodeBC7( State & state ) { sDecode( state, ColorFormat::BC7_UNORM ); }
+GN_BENCHMARK( DecodeBC7 );
+
+// BC7 of NORMAL quality with worker threads. Argument is the number of threads.
+static void EncodeBC7_parallel( State & state )
+{
+    const RawImage & src = sImage1K();
+    RawImage dst;
+    JobSystem js( (uint32)state.arg() );
+    while( state.keepRunning() )
+    {
+        convertImage( src.desc(), src.data(), ColorFormat::BC7_UNORM, dst, js );
+        doNotOptimize( dst.data() );
+    }
+    state.setItemsProcessed( state.iterations() * 1024 * 1024 );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+GN_BENCHMARK_ARG( EncodeBC7_parallel, 2 );
+GN_BENCHMARK_ARG( EncodeBC7_parallel, 4 );
+GN_BENCHMARK_ARG( EncodeBC7_parallel, 8 );
+
+// *****************************************************************************
+// mipmap generation, of 4096 x 4096 and 8192 x 8192 sRGB RGBA8 images
+// *****************************************************************************
+
+static const RawImage & sSrgbImage( uint32 size )
+{
+    static RawImage images[2];
+    RawImage & image = images[8192 == size];
+    if( image.empty() )
+    {
+        image = RawImage( ImageDesc( ImagePlaneDesc::make( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, size, size ) ), sBytes( (size_t)size * size * 4 ) );
+    }
+    return image;
+}
+
+static void sMipmaps( State & state, uint32 size, MipmapFilter filter, JobSystem * js )
+{
+    const RawImage & src = sSrgbImage( size );
+    while( state.keepRunning() )
+    {
+        state.pauseTiming();
+        RawImage image( ImageDesc( src.desc() ), src.data() );
+        state.resumeTiming();
+        if( js ) image.generateMipmaps( *js, filter ); else image.generateMipmaps( filter );
+        doNotOptimize( image.data() );
+    }
+    state.setItemsProcessed( state.iterations() * size * size );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+
+static void Mipmaps4K( State & state ) { sMipmaps( state, 4096, (MipmapFilter)state.arg(), NULL ); }
+GN_BENCHMARK_ARG( Mipmaps4K, 0 );
+GN_BENCHMARK_ARG( Mipmaps4K, 1 );
+GN_BENCHMARK_ARG( Mipmaps4K, 2 );
+
+static void Mipmaps8K( State & state ) { sMipmaps( state, 8192, (MipmapFilter)state.arg(), NULL ); }
+GN_BENCHMARK_ARG( Mipmaps8K, 0 );
+GN_BENCHMARK_ARG( Mipmaps8K, 1 );
+GN_BENCHMARK_ARG( Mipmaps8K, 2 );
+
+// Kaiser filter with worker threads. Argument is the number of threads.
+static void Mipmaps4K_parallel( State & state )
+{
+    JobSystem js( (uint32)state.arg() );
+    sMipmaps( state, 4096, MipmapFilter::KAISER, &js );
+}
+GN_BENCHMARK_ARG( Mipmaps4K_parallel, 2 );
+GN_BENCHMARK_ARG( Mipmaps4K_parallel, 4 );
+GN_BENCHMARK_ARG( Mipmaps4K_parallel, 8 );
+
+static void Mipmaps8K_parallel( State & state )
+{
+    JobSystem js( (uint32)state.arg() );
+    sMipmaps( state, 8192, MipmapFilter::KAISER, &js );
+}
+GN_BENCHMARK_ARG( Mipmaps8K_parallel, 4 );
+GN_BENCHMARK_ARG( Mipmaps8K_parallel, 8 );
+
+// *****************************************************************************
+// image saving, of the 1024 x 1024 RGBA8 image, to a memory file
+// *****************************************************************************
+
+static void SaveImage1K( State & state )
+{
+    const RawImage & src = sImage1K();
+    VectorFile file;
+    while( state.keepRunning() )
+    {
+        file.seek( 0, FileSeek::SET );
+        src.save( file, (ImageFileFormat)state.arg() );
+        doNotOptimize( file.map( 0, 1, false ) );
+    }
+    state.setItemsProcessed( state.iterations() * 1024 * 1024 );
+    state.setBytesProcessed( state.iterations() * src.size() );
+}
+GN_BENCHMARK_ARG( SaveImage1K, 0 );
+GN_BENCHMARK_ARG( SaveImage1K, 1 );
+GN_BENCHMARK_ARG( SaveImage1K, 2 );
+GN_BENCHMARK_ARG( SaveImage1K, 3 );
+
+// *****************************************************************************
+// image loading, of a corpus of 1000 256 x 256 PNG or JPEG files in memory
+// *****************************************************************************
+
+static const size_t CORPUS_SIZE = 1000;
+
+/// libjpeg destination manager, appending to a vector.
+struct JpegDest : jpeg_destination_mgr
+{
+    std::vector<uint8> data;
+    uint8              buffer[4096];
+
+    static void init( j_compress_ptr c )
+    {
+        JpegDest * d = (JpegDest*)c->dest;
+        d->next_output_byte = d->buffer;
+        d->free_in_buffer = sizeof(d->buffer);
+    }
+
+    static JPEG_BOOL empty( j_compress_ptr c )
+    {
+        JpegDest * d = (JpegDest*)c->dest;
+        d->data.insert( d->data.end(), d->buffer, d->buffer + sizeof(d->buffer) );
+        init( c );
+        return JPEG_TRUE;
+    }
+
+    static void term( j_compress_ptr c )
+    {
+        JpegDest * d = (JpegDest*)c->dest;
+        d->data.insert( d->data.end(), d->buffer, d->buffer + sizeof(d->buffer) - d->free_in_buffer );
+    }
+};
+
+/// RGB image of quality 90, of the same pixels as the RGBA8 image.
+static std::vector<uint8> sEncodeJPG( const RawImage & image )
+{
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error( &err );
+    jpeg_create_compress( &cinfo );
+    JpegDest dest;
+    dest.init_destination = JpegDest::init;
+    dest.empty_output_buffer = JpegDest::empty;
+    dest.term_destination = JpegDest::term;
+    cinfo.dest = &dest;
+    cinfo.image_width = image.width();
+    cinfo.image_height = image.height();
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults( &cinfo );
+    jpeg_set_quality( &cinfo, 90, JPEG_TRUE );
+    jpeg_start_compress( &cinfo, JPEG_TRUE );
+    std::vector<uint8> row( image.width() * 3 );
+    while( cinfo.next_scanline < cinfo.image_height )
+    {
+        convertPixels( ColorFormat::RGBA8, image.pixel( 0, 0, 0, cinfo.next_scanline ), ColorFormat::RGB_8_8_8_UNORM, row.data(), image.width() );
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_write_scanlines( &cinfo, rows, 1 );
+    }
+    jpeg_finish_compress( &cinfo );
+    jpeg_destroy_compress( &cinfo );
+    return dest.data;
+}
+
+/// Files of the corpus are 256 x 256 windows at different offsets of the 1K image.
+static const std::vector<std::vector<uint8>> & sCorpus( int format )
+{
+    static std::vector<std::vector<uint8>> corpus[2];
+    std::vector<std::vector<uint8>> & files = corpus[format];
+    if( files.empty() )
+    {
+        const RawImage & src = sImage1K();
+        files.resize( CORPUS_SIZE );
+        for( size_t i = 0; i < CORPUS_SIZE; ++i )
+        {
+            uint32 x = (uint32)( i * 37 % 768 ), y = (uint32)( i * 101 % 768 );
+            RawImage image( ImageDesc( ImagePlaneDesc::make( ColorFormat::RGBA8, 256, 256 ) ) );
+            for( uint32 r = 0; r < 256; ++r ) memcpy( image.pixel( 0, 0, 0, r ), src.pixel( 0, 0, x, y + r ), 256 * 4 );
+            if( 0 == format )
+            {
+                VectorFile file;
+                image.save( file, ImageFileFormat::PNG );
+                const uint8 * data = (const uint8*)file.map( 0, file.size(), true );
+                files[i].assign( data, data + file.size() );
+            }
+            else
+            {
+                files[i] = sEncodeJPG( image );
+            }
+        }
+    }
+    return files;
+}
+
+static void LoadCorpus( State & state )
+{
+    const auto & files = sCorpus( (int)state.arg() );
+    while( state.keepRunning() )
+    {
+        for( const auto & f : files )
+        {
+            RawImage image = RawImage::load( f.data(), f.size() );
+            doNotOptimize( image.data() );
+        }
+    }
+    state.setItemsProcessed( state.iterations() * CORPUS_SIZE );
+}
+GN_BENCHMARK_ARG( LoadCorpus, 0 );
+GN_BENCHMARK_ARG( LoadCorpus, 1 );
+
+// Plain stb_image decoding, to native channels, for comparison.
+static void LoadCorpus_stb( State & state )
+{
+    const auto & files = sCorpus( (int)state.arg() );
+    while( state.keepRunning() )
+    {
+        for( const auto & f : files )
+        {
+            int x, y, n;
+            stbi_uc * pixels = stbi_load_from_memory( f.data(), (int)f.size(), &x, &y, &n, 0 );
+            doNotOptimize( pixels );
+            stbi_image_free( pixels );
+        }
+    }
+    state.setItemsProcessed( state.iterations() * CORPUS_SIZE );
+}
+GN_BENCHMARK_ARG( LoadCorpus_stb, 0 );
+GN_BENCHMARK_ARG( LoadCorpus_stb, 1 );
+
+// JPEG corpus from disk files, one file per job. Argument is the number of threads.
+static void LoadCorpus_parallel( State & state )
+{
+    const auto & files = sCorpus( 1 );
+    std::vector<StrA> names( CORPUS_SIZE );
+    for( size_t i = 0; i < CORPUS_SIZE; ++i )
+    {
+        TempFile tmp;
+        tmp.open( "bench", "wb", TempFile::MANUAL_DELETE );
+        tmp.write( files[i].data(), files[i].size(), NULL );
+        names[i] = tmp.name();
+        tmp.close();
+    }
+
+    std::vector<RawImage> images( CORPUS_SIZE );
+    JobSystem js( (uint32)state.arg() );
+    while( state.keepRunning() )
+    {
+        RawImage::load( js, names.data(), CORPUS_SIZE, images.data() );
+        doNotOptimize( images.data() );
+    }
+    state.setItemsProcessed( state.iterations() * CORPUS_SIZE );
+
+    for( const auto & n : names ) ::remove( n.rawptr() );
+}
+GN_BENCHMARK_ARG( LoadCorpus_parallel, 1 );
+GN_BENCHMARK_ARG( LoadCorpus_parallel, 4 );
+GN_BENCHMARK_ARG( LoadCorpus_parallel, 8 );
+
+// *****************************************************************************
+// image loading, of a mixed corpus of 100 files: 40 gray masks (PNG), 20 16-bit heightmaps
+// (PNG), 30 photos (JPEG), 5 environment maps (Radiance HDR) and 5 half float EXR files.
+// *****************************************************************************
+
+static void sPngWrite( png_structp png, png_bytep data, png_size_t size )
+{
+    std::vector<uint8> * out = (std::vector<uint8>*)png_get_io_ptr( png );
+    out->insert( out->end(), data, data + size );
+}
+
+static void sPngFlush( png_structp )
+{
+}
+
+/// 16-bit gray PNG of a smooth height field
+static std::vector<uint8> sEncodeHeightmap( uint32 size, uint32 seed )
+{
+    std::vector<uint8> out, pixels( size * size * 2 );
+    for( uint32 y = 0; y < size; ++y )
+    for( uint32 x = 0; x < size; ++x )
+    {
+        uint32 h = ( x * x * 7 + y * 131 * seed + x * y ) & 0xFFFF;
+        pixels[( y * size + x ) * 2] = (uint8)( h >> 8 ); // big endian
+        pixels[( y * size + x ) * 2 + 1] = (uint8)h;
+    }
+    png_structp png = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+    png_infop info = png_create_info_struct( png );
+    png_set_write_fn( png, &out, sPngWrite, sPngFlush );
+    png_set_IHDR( png, info, size, size, 16, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+    png_write_info( png, info );
+    for( uint32 y = 0; y < size; ++y ) png_write_row( png, &pixels[y * size * 2] );
+    png_write_end( png, NULL );
+    png_destroy_write_struct( &png, &info );
+    return out;
+}
+
+/// Radiance HDR of flat (not run length encoded) RGBE pixels
+static std::vector<uint8> sEncodeHDR( uint32 width, uint32 height )
+{
+    char header[128];
+    int n = snprintf( header, sizeof(header), "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %u +X %u\n", height, width );
+    std::vector<uint8> out( header, header + n );
+    const uint8 * noise = sBytes( width * height * 4 );
+    for( uint32 i = 0; i < width * height; ++i )
+    {
+        const uint8 * p = noise + i * 4;
+        uint8 rgbe[4] = { (uint8)( p[0] | 0x80 ), p[1], p[2], (uint8)( 124 + ( p[3] & 7 ) ) };
+        out.insert( out.end(), rgbe, rgbe + 4 );
+    }
+    return out;
+}
+
+/// uncompressed EXR of HALF A, B, G and R channels
+static std::vector<uint8> sEncodeEXR( uint32 size )
+{
+    std::vector<uint8> out = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+    auto put32 = [&]( uint32 v ) { out.insert( out.end(), (const uint8*)&v, (const uint8*)&v + 4 ); };
+    auto attribute = [&]( const char * name, const char * type, uint32 size ) {
+        out.insert( out.end(), name, name + strlen( name ) + 1 );
+        out.insert( out.end(), type, type + strlen( type ) + 1 );
+        put32( size );
+    };
+    attribute( "channels", "chlist", 4 * 18 + 1 );
+    for( const char * c : { "A", "B", "G", "R" } )
+    {
+        out.insert( out.end(), c, c + 2 );
+        put32( 1 ); put32( 0 ); put32( 1 ); put32( 1 );
+    }
+    out.push_back( 0 );
+    attribute( "compression", "compression", 1 );
+    out.push_back( 0 );
+    attribute( "dataWindow", "box2i", 16 );
+    put32( 0 ); put32( 0 ); put32( size - 1 ); put32( size - 1 );
+    out.push_back( 0 );
+
+    size_t table = out.size();
+    size_t lineBytes = size * 4 * 2;
+    out.resize( table + size * 8 );
+    const uint8 * noise = sBytes( lineBytes );
+    for( uint32 y = 0; y < size; ++y )
+    {
+        uint64 offset = out.size();
+        memcpy( &out[table + y * 8], &offset, 8 );
+        put32( y );
+        put32( (uint32)lineBytes );
+        for( size_t i = 0; i < lineBytes; i += 2 )
+        {
+            uint16 half = (uint16)( 0x3000 + ( ( noise[i] + y ) & 0x7FF ) ); // 0.125 to 0.5
+            out.insert( out.end(), (const uint8*)&half, (const uint8*)&half + 2 );
+        }
+    }
+    return out;
+}
+
+static const std::vector<std::vector<uint8>> & sMixedCorpus()
+{
+    static std::vector<std::vector<uint8>> files;
+    if( files.empty() )
+    {
+        const RawImage & src = sImage1K();
+        for( uint32 i = 0; i < 40; ++i )
+        {
+            RawImage mask( ImageDesc( ImagePlaneDesc::make( ColorFormat::L_8_UNORM, 256, 256 ) ) );
+            for( uint32 y = 0; y < 256; ++y )
+            for( uint32 x = 0; x < 256; ++x ) *mask.pixel( 0, 0, x, y ) = src.pixel( 0, 0, x + i * 8, y )[( x / 32 + i ) & 3] > 128 ? 255 : 0;
+            VectorFile file;
+            mask.save( file, ImageFileFormat::PNG );
+            const uint8 * data = (const uint8*)file.map( 0, file.size(), true );
+            files.emplace_back( data, data + file.size() );
+        }
+        for( uint32 i = 0; i < 20; ++i ) files.push_back( sEncodeHeightmap( 256, i + 1 ) );
+        const auto & photos = sCorpus( 1 );
+        for( uint32 i = 0; i < 30; ++i ) files.push_back( photos[i] );
+        for( uint32 i = 0; i < 5; ++i ) files.push_back( sEncodeHDR( 512, 256 ) );
+        for( uint32 i = 0; i < 5; ++i ) files.push_back( sEncodeEXR( 256 ) );
+    }
+    return files;
+}
+
+static void LoadMixedCorpus( State & state )
+{
+    const auto & files = sMixedCorpus();
+    ColorFormat format = 0 == state.arg() ? ColorFormat::UNKNOWN : ColorFormat::RGBA8;
+    uint64 bytes = 0;
+    while( state.keepRunning() )
+    {
+        bytes = 0;
+        for( const auto & f : files )
+        {
+            RawImage image = RawImage::load( f.data(), f.size(), format );
+            bytes += image.size();
+            doNotOptimize( image.data() );
+        }
+    }
+    state.setItemsProcessed( state.iterations() * files.size() );
+    state.setBytesProcessed( state.iterations() * bytes );
+
+    static bool printed[2];
+    if( !printed[0 != state.arg()] )
+    {
+        printed[0 != state.arg()] = true;
+        printf( "LoadMixedCorpus/%d: %.2f MB of images.\n", (int)state.arg(), bytes / 1048576.0 );
+    }
+}
+GN_BENCHMARK_ARG( LoadMixedCorpus, 0 );
+GN_BENCHMARK_ARG( LoadMixedCorpus, 1 );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-image", argc, argv );
+}
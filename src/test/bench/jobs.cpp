@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+//
+// Job system scaling benchmarks. Benchmark argument is the number of worker
+// threads. Note that the calling thread also runs jobs while waiting, so N
+// workers means up to N+1 busy threads.
+//
+
+static const size_t KERNEL_ELEMENTS = 1 << 18;
+
+/// Some floating point work per element, heavy enough that memory bandwidth is not the limit.
+static inline float sKernel( float x )
+{
+    for( int i = 0; i < 16; ++i ) x = sqrtf( x * x + 1.0f ) * 0.5f;
+    return x;
+}
+
+// *****************************************************************************
+// parallelFor
+// *****************************************************************************
+
+static void Serial_for( State & state )
+{
+    std::vector<float> data( KERNEL_ELEMENTS, 1.0f );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < data.size(); ++i ) data[i] = sKernel( data[i] );
+        doNotOptimize( data[0] );
+    }
+    state.setItemsProcessed( state.iterations() * KERNEL_ELEMENTS );
+}
+GN_BENCHMARK( Serial_for );
+
+static void JobSystem_parallelFor( State & state )
+{
+    JobSystem js( (uint32)state.arg() );
+    std::vector<float> data( KERNEL_ELEMENTS, 1.0f );
+    while( state.keepRunning() )
+    {
+        js.parallelFor( 0, data.size(), [&]( size_t b, size_t e ){
+            for( size_t i = b; i < e; ++i ) data[i] = sKernel( data[i] );
+        } );
+        doNotOptimize( data[0] );
+    }
+    state.setItemsProcessed( state.iterations() * KERNEL_ELEMENTS );
+}
+GN_BENCHMARK_ARG( JobSystem_parallelFor, 1 );
+GN_BENCHMARK_ARG( JobSystem_parallelFor, 2 );
+GN_BENCHMARK_ARG( JobSystem_parallelFor, 4 );
+GN_BENCHMARK_ARG( JobSystem_parallelFor, 8 );
+GN_BENCHMARK_ARG( JobSystem_parallelFor, 16 );
+
+// *****************************************************************************
+// Scheduling overhead: many tiny jobs
+// *****************************************************************************
+
+static void JobSystem_spawnEmpty( State & state )
+{
+    const size_t JOBS = 1000;
+    JobSystem js( (uint32)state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < JOBS; ++i ) js.run( NULL, []{} );
+        js.waitAll();
+    }
+    state.setItemsProcessed( state.iterations() * JOBS );
+}
+GN_BENCHMARK_ARG( JobSystem_spawnEmpty, 1 );
+GN_BENCHMARK_ARG( JobSystem_spawnEmpty, 4 );
+GN_BENCHMARK_ARG( JobSystem_spawnEmpty, 8 );
+GN_BENCHMARK_ARG( JobSystem_spawnEmpty, 16 );
+
+/// Jobs spawned from inside jobs go to worker deques, and are load-balanced by stealing.
+static void JobSystem_spawnNested( State & state )
+{
+    const size_t OUTER = 100;
+    const size_t INNER = 100;
+    JobSystem js( (uint32)state.arg() );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < OUTER; ++i )
+        {
+            js.run( NULL, [&js]{
+                for( size_t k = 0; k < INNER; ++k ) js.run( NULL, []{ doNotOptimize( sKernel( 1.0f ) ); } );
+            } );
+        }
+        js.waitAll();
+    }
+    state.setItemsProcessed( state.iterations() * OUTER * INNER );
+}
+GN_BENCHMARK_ARG( JobSystem_spawnNested, 1 );
+GN_BENCHMARK_ARG( JobSystem_spawnNested, 4 );
+GN_BENCHMARK_ARG( JobSystem_spawnNested, 8 );
+GN_BENCHMARK_ARG( JobSystem_spawnNested, 16 );
+
+// *****************************************************************************
+// Task graph: independent chains of dependent jobs
+// *****************************************************************************
+
+static void JobSystem_taskGraph( State & state )
+{
+    const size_t CHAINS = 64;
+    const size_t LENGTH = 16;
+    const size_t WORK = 256;
+    JobSystem js( (uint32)state.arg() );
+    std::vector<float> data( CHAINS * WORK, 1.0f );
+    while( state.keepRunning() )
+    {
+        for( size_t c = 0; c < CHAINS; ++c )
+        {
+            float * p = &data[c * WORK];
+            auto work = [p]{ for( size_t i = 0; i < WORK; ++i ) p[i] = sKernel( p[i] ); };
+            JobHandle j = js.run( NULL, work );
+            for( size_t k = 1; k < LENGTH; ++k ) j = js.continueWith( j, NULL, work );
+        }
+        js.waitAll();
+        doNotOptimize( data[0] );
+    }
+    state.setItemsProcessed( state.iterations() * CHAINS * LENGTH );
+}
+GN_BENCHMARK_ARG( JobSystem_taskGraph, 1 );
+GN_BENCHMARK_ARG( JobSystem_taskGraph, 2 );
+GN_BENCHMARK_ARG( JobSystem_taskGraph, 4 );
+GN_BENCHMARK_ARG( JobSystem_taskGraph, 8 );
+GN_BENCHMARK_ARG( JobSystem_taskGraph, 16 );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-jobs", argc, argv );
+}
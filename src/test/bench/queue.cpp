@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <deque>
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+//
+// Queue throughput benchmarks. Producers push ITEMS in total, consumers pop until all
+// items are through. Benchmark argument is the number of producers (and consumers, for
+// MPMC). Items are queue transfers.
+//
+
+static const uint32 ITEMS = 200000;
+
+///
+/// Baseline: std::deque guarded by std::mutex.
+///
+template<typename T>
+class LockedDeque
+{
+    std::mutex    mMutex;
+    std::deque<T> mItems;
+public:
+    typedef T ValueType;
+    static const bool BOUNDED = false;
+    template<typename U> bool tryPush( U && v ) { std::lock_guard<std::mutex> lock( mMutex ); mItems.push_back( std::forward<U>( v ) ); return true; }
+    bool tryPop( T & v )
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        if( mItems.empty() ) return false;
+        v = mItems.front();
+        mItems.pop_front();
+        return true;
+    }
+};
+
+template<typename QUEUE>
+static void sTransfer( State & state, QUEUE & q, size_t numProducers, size_t numConsumers )
+{
+    std::atomic<uint32> popped( 0 );
+    std::vector<std::thread> threads;
+    const uint32 perProducer = ITEMS / (uint32)numProducers;
+    const uint32 total = perProducer * (uint32)numProducers;
+    for( size_t p = 0; p < numProducers; ++p )
+    {
+        threads.emplace_back( [&]{
+            for( uint32 i = 0; i < perProducer; ++i )
+            {
+                while( !q.tryPush( i ) ) std::this_thread::yield();
+            }
+        } );
+    }
+    for( size_t c = 0; c < numConsumers; ++c )
+    {
+        threads.emplace_back( [&]{
+            uint32 v;
+            uint64 sum = 0;
+            while( popped.load( std::memory_order_relaxed ) < total )
+            {
+                if( q.tryPop( v ) ) { sum += v; popped.fetch_add( 1, std::memory_order_relaxed ); }
+                else std::this_thread::yield();
+            }
+            doNotOptimize( sum );
+        } );
+    }
+    for( auto & t : threads ) t.join();
+    state.setItemsProcessed( state.iterations() * total );
+}
+
+// *****************************************************************************
+// single producer, single consumer
+// *****************************************************************************
+
+static void SPSC_LockedDeque( State & state )
+{
+    while( state.keepRunning() ) { LockedDeque<uint32> q; sTransfer( state, q, 1, 1 ); }
+}
+GN_BENCHMARK( SPSC_LockedDeque );
+
+static void SPSC_SpscRingBuffer( State & state )
+{
+    while( state.keepRunning() ) { SpscRingBuffer<uint32> q( 4096 ); sTransfer( state, q, 1, 1 ); }
+}
+GN_BENCHMARK( SPSC_SpscRingBuffer );
+
+static void SPSC_SpscQueue( State & state )
+{
+    while( state.keepRunning() ) { SpscQueue<uint32> q; sTransfer( state, q, 1, 1 ); }
+}
+GN_BENCHMARK( SPSC_SpscQueue );
+
+// *****************************************************************************
+// multiple producers, single consumer
+// *****************************************************************************
+
+static void MPSC_LockedDeque( State & state )
+{
+    while( state.keepRunning() ) { LockedDeque<uint32> q; sTransfer( state, q, state.arg(), 1 ); }
+}
+GN_BENCHMARK_ARG( MPSC_LockedDeque, 2 );
+GN_BENCHMARK_ARG( MPSC_LockedDeque, 4 );
+
+static void MPSC_MpscQueue( State & state )
+{
+    while( state.keepRunning() ) { MpscQueue<uint32> q; sTransfer( state, q, state.arg(), 1 ); }
+}
+GN_BENCHMARK_ARG( MPSC_MpscQueue, 2 );
+GN_BENCHMARK_ARG( MPSC_MpscQueue, 4 );
+
+static void MPSC_MpmcRingBuffer( State & state )
+{
+    while( state.keepRunning() ) { MpmcRingBuffer<uint32> q( 4096 ); sTransfer( state, q, state.arg(), 1 ); }
+}
+GN_BENCHMARK_ARG( MPSC_MpmcRingBuffer, 2 );
+GN_BENCHMARK_ARG( MPSC_MpmcRingBuffer, 4 );
+
+// *****************************************************************************
+// multiple producers, multiple consumers
+// *****************************************************************************
+
+static void MPMC_LockedDeque( State & state )
+{
+    while( state.keepRunning() ) { LockedDeque<uint32> q; sTransfer( state, q, state.arg(), state.arg() ); }
+}
+GN_BENCHMARK_ARG( MPMC_LockedDeque, 2 );
+GN_BENCHMARK_ARG( MPMC_LockedDeque, 4 );
+
+static void MPMC_MpmcRingBuffer( State & state )
+{
+    while( state.keepRunning() ) { MpmcRingBuffer<uint32> q( 4096 ); sTransfer( state, q, state.arg(), state.arg() ); }
+}
+GN_BENCHMARK_ARG( MPMC_MpmcRingBuffer, 2 );
+GN_BENCHMARK_ARG( MPMC_MpmcRingBuffer, 4 );
+
+// *****************************************************************************
+// blocking adapter: consumers sleep instead of polling
+// *****************************************************************************
+
+static void MPMC_BlockingQueue( State & state )
+{
+    while( state.keepRunning() )
+    {
+        BlockingQueue<MpmcRingBuffer<uint32>> q( 4096 );
+        std::vector<std::thread> threads;
+        const size_t n = state.arg();
+        const uint32 perThread = ITEMS / (uint32)n;
+        for( size_t p = 0; p < n; ++p )
+        {
+            threads.emplace_back( [&]{ for( uint32 i = 0; i < perThread; ++i ) q.push( i ); } );
+            threads.emplace_back( [&]{ uint32 v; for( uint32 i = 0; i < perThread; ++i ) q.pop( v ); } );
+        }
+        for( auto & t : threads ) t.join();
+        state.setItemsProcessed( state.iterations() * perThread * n );
+    }
+}
+GN_BENCHMARK_ARG( MPMC_BlockingQueue, 2 );
+GN_BENCHMARK_ARG( MPMC_BlockingQueue, 4 );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-queue", argc, argv );
+}
@@ -0,0 +1,199 @@
+#include "pch.h"
+#include "benchHarness.h"
+#include <shared_mutex>
+#include <vector>
+
+using namespace GN;
+using namespace GN::bench;
+
+//
+// Lock contention benchmarks. Benchmark argument is the number of threads hammering
+// the same lock. Each iteration starts the threads, lines them up on a barrier, then
+// runs a fixed number of lock operations per thread. Items are lock acquisitions.
+//
+
+static const size_t OPS_PER_THREAD = 20000;
+
+/// Run func(threadIndex) on numThreads threads, all starting at the same time.
+template<typename FUNC>
+static void sRunThreads( size_t numThreads, const FUNC & func )
+{
+    Barrier start( (uint32)numThreads );
+    std::vector<std::thread> threads;
+    for( size_t t = 0; t < numThreads; ++t )
+    {
+        threads.emplace_back( [&, t]{ start.arriveAndWait(); func( t ); } );
+    }
+    for( auto & t : threads ) t.join();
+}
+
+// *****************************************************************************
+// exclusive lock: short critical section
+// *****************************************************************************
+
+template<typename LOCK>
+static void sLockContention( State & state )
+{
+    LOCK lock;
+    uint64 counter = 0;
+    while( state.keepRunning() )
+    {
+        sRunThreads( state.arg(), [&]( size_t ){
+            for( size_t i = 0; i < OPS_PER_THREAD; ++i )
+            {
+                std::lock_guard<LOCK> guard( lock );
+                ++counter;
+            }
+        } );
+    }
+    doNotOptimize( counter );
+    state.setItemsProcessed( state.iterations() * state.arg() * OPS_PER_THREAD );
+}
+
+static void Lock_stdMutex( State & state ) { sLockContention<std::mutex>( state ); }
+GN_BENCHMARK_ARG( Lock_stdMutex, 1 );
+GN_BENCHMARK_ARG( Lock_stdMutex, 2 );
+GN_BENCHMARK_ARG( Lock_stdMutex, 4 );
+GN_BENCHMARK_ARG( Lock_stdMutex, 8 );
+
+static void Lock_SpinLoop( State & state ) { sLockContention<SpinLoop>( state ); }
+GN_BENCHMARK_ARG( Lock_SpinLoop, 1 );
+GN_BENCHMARK_ARG( Lock_SpinLoop, 2 );
+GN_BENCHMARK_ARG( Lock_SpinLoop, 4 );
+GN_BENCHMARK_ARG( Lock_SpinLoop, 8 );
+
+static void Lock_Mutex( State & state ) { sLockContention<Mutex>( state ); }
+GN_BENCHMARK_ARG( Lock_Mutex, 1 );
+GN_BENCHMARK_ARG( Lock_Mutex, 2 );
+GN_BENCHMARK_ARG( Lock_Mutex, 4 );
+GN_BENCHMARK_ARG( Lock_Mutex, 8 );
+
+// *****************************************************************************
+// shared lock: read mostly (1 write every 16 operations)
+// *****************************************************************************
+
+static const size_t SHARED_DATA_SIZE = 64;
+
+static void ReadMostly_stdSharedMutex( State & state )
+{
+    std::shared_mutex lock;
+    uint32 data[SHARED_DATA_SIZE] = {};
+    while( state.keepRunning() )
+    {
+        sRunThreads( state.arg(), [&]( size_t t ){
+            uint32 sum = 0;
+            for( size_t i = 0; i < OPS_PER_THREAD; ++i )
+            {
+                if( 0 == ( ( i + t ) & 15 ) )
+                {
+                    std::lock_guard<std::shared_mutex> guard( lock );
+                    data[i % SHARED_DATA_SIZE]++;
+                }
+                else
+                {
+                    std::shared_lock<std::shared_mutex> guard( lock );
+                    for( size_t k = 0; k < SHARED_DATA_SIZE; ++k ) sum += data[k];
+                }
+            }
+            doNotOptimize( sum );
+        } );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() * OPS_PER_THREAD );
+}
+GN_BENCHMARK_ARG( ReadMostly_stdSharedMutex, 1 );
+GN_BENCHMARK_ARG( ReadMostly_stdSharedMutex, 4 );
+GN_BENCHMARK_ARG( ReadMostly_stdSharedMutex, 8 );
+
+static void ReadMostly_RWLock( State & state )
+{
+    RWLock lock;
+    uint32 data[SHARED_DATA_SIZE] = {};
+    while( state.keepRunning() )
+    {
+        sRunThreads( state.arg(), [&]( size_t t ){
+            uint32 sum = 0;
+            for( size_t i = 0; i < OPS_PER_THREAD; ++i )
+            {
+                if( 0 == ( ( i + t ) & 15 ) )
+                {
+                    lock.lock();
+                    data[i % SHARED_DATA_SIZE]++;
+                    lock.unlock();
+                }
+                else
+                {
+                    lock.lockShared();
+                    for( size_t k = 0; k < SHARED_DATA_SIZE; ++k ) sum += data[k];
+                    lock.unlockShared();
+                }
+            }
+            doNotOptimize( sum );
+        } );
+    }
+    state.setItemsProcessed( state.iterations() * state.arg() * OPS_PER_THREAD );
+}
+GN_BENCHMARK_ARG( ReadMostly_RWLock, 1 );
+GN_BENCHMARK_ARG( ReadMostly_RWLock, 4 );
+GN_BENCHMARK_ARG( ReadMostly_RWLock, 8 );
+
+// *****************************************************************************
+// wake-up latency: two threads ping-pong through a pair of events
+// *****************************************************************************
+
+static void PingPong_SyncEvent( State & state )
+{
+    const size_t ROUNDS = 1000;
+    SyncEvent ping( SyncEvent::UNSIGNALED, SyncEvent::AUTO_RESET );
+    SyncEvent pong( SyncEvent::UNSIGNALED, SyncEvent::AUTO_RESET );
+    std::thread other( [&]{
+        while( WaitResult::COMPLETED == ping.wait() ) pong.signal();
+    } );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < ROUNDS; ++i )
+        {
+            ping.signal();
+            pong.wait();
+        }
+    }
+    ping.destroy();
+    other.join();
+    state.setItemsProcessed( state.iterations() * ROUNDS );
+}
+GN_BENCHMARK( PingPong_SyncEvent );
+
+static void PingPong_Semaphore( State & state )
+{
+    const size_t ROUNDS = 1000;
+    Semaphore ping, pong;
+    std::atomic<bool> quit( false );
+    std::thread other( [&]{
+        for(;;)
+        {
+            ping.acquire();
+            if( quit ) break;
+            pong.release();
+        }
+    } );
+    while( state.keepRunning() )
+    {
+        for( size_t i = 0; i < ROUNDS; ++i )
+        {
+            ping.release();
+            pong.acquire();
+        }
+    }
+    quit = true;
+    ping.release();
+    other.join();
+    state.setItemsProcessed( state.iterations() * ROUNDS );
+}
+GN_BENCHMARK( PingPong_Semaphore );
+
+//
+//
+// -----------------------------------------------------------------------------
+int main( int argc, const char * argv[] )
+{
+    return runAll( "GNbench-sync", argc, argv );
+}
@@ -0,0 +1,101 @@
+#include "pch.h"
+#include <thread>
+
+//
+// Build and run co_await of AsyncResult, which is only available in C++20 (GN_HAS_COROUTINE).
+// The rest of the tree is C++17, so this test is a separate executable. Return 0 on success.
+//
+
+using namespace GN;
+
+#if GN_HAS_COROUTINE
+
+static int sFailures = 0;
+
+#define CHECK( x ) if( !(x) ) { printf( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #x ); ++sFailures; } else void(0)
+
+///
+/// Coroutine that starts right away and destroys itself when done.
+///
+struct FireAndForget
+{
+    struct promise_type
+    {
+        FireAndForget       get_return_object() { return {}; }
+        std::suspend_never  initial_suspend() { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() {}
+        void                unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct Awaited
+{
+    int             value = -1;
+    std::thread::id thread;
+    bool            done = false;
+};
+
+static FireAndForget sAwait( AsyncResult<int> op, Awaited & out )
+{
+    out.value  = co_await op;
+    out.thread = std::this_thread::get_id();
+    out.done   = true;
+}
+
+static void sWait( AsyncLoader & loader, const Awaited & a )
+{
+    while( !a.done ) { loader.update(); std::this_thread::yield(); }
+}
+
+int main( int, const char * [] )
+{
+    JobSystem   js( 2 );
+    AsyncLoader loader( js, 1 );
+    std::thread::id mainThread = std::this_thread::get_id();
+
+    // work on a worker thread, finish and resume on main thread.
+    Awaited a;
+    sAwait( loader.run<int>( "coroutine.stages", AsyncPriority::NORMAL,
+        []( int & v ) { v = 21; return true; },
+        []( int & v ) { v *= 2; return true; } ), a );
+    sWait( loader, a );
+    CHECK( 42 == a.value );
+    CHECK( mainThread == a.thread );
+
+    // already done: resumes without suspending.
+    AsyncResult<int> r = loader.run<int>( "coroutine.ready", AsyncPriority::NORMAL, []( int & v ) { v = 7; return true; } );
+    r.wait();
+    Awaited b;
+    sAwait( r, b );
+    CHECK( b.done );
+    CHECK( 7 == b.value );
+
+    // cancelled while queued behind the gate: resumes with default value.
+    std::atomic<bool> open( false );
+    AsyncResult<int> gate = loader.run<int>( "coroutine.gate", AsyncPriority::NORMAL,
+        [&]( int & ) { while( !open ) std::this_thread::yield(); return true; } );
+    AsyncResult<int> queued = loader.run<int>( "coroutine.cancelled", AsyncPriority::NORMAL, []( int & v ) { v = 1; return true; } );
+    Awaited c;
+    sAwait( queued, c );
+    queued.cancel();
+    open = true;
+    sWait( loader, c );
+    CHECK( AsyncStatus::CANCELLED == queued.getStatus() );
+    CHECK( 0 == c.value );
+
+    loader.waitAll();
+
+    printf( "%s\n", sFailures ? "FAILED" : "OK" );
+    return sFailures ? -1 : 0;
+}
+
+#else
+
+int main( int, const char * [] )
+{
+    printf( "C++20 coroutine is not supported by the compiler.\n" );
+    return 0;
+}
+
+#endif
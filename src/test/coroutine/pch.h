@@ -0,0 +1,22 @@
+#ifndef __GN_PCH_H__
+#define __GN_PCH_H__
+// *****************************************************************************
+// \file    pch.h
+// \brief   PCH header
+// *****************************************************************************
+
+#include "garnet/GNbase.h"
+
+#if GN_XBOX2
+#include <xtl.h>
+#elif GN_WINPC
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+// *****************************************************************************
+//                                     EOF
+// *****************************************************************************
+#endif // __GN_PCH_H__
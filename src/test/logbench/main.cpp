@@ -0,0 +1,105 @@
+#include "pch.h"
+#include <thread>
+#include <vector>
+
+using namespace GN;
+
+static GN::Logger * sLogger = GN::getLogger("GN.test.logbench");
+
+///
+/// Receiver that only counts messages, so the benchmark measures the logging pipeline,
+/// not the console.
+///
+struct NullReceiver : public Logger::Receiver
+{
+    std::atomic<size_t> count;
+
+    NullReceiver() : count(0) {}
+
+    virtual void onLog( Logger &, const Logger::LogDesc &, const char * ) { ++count; }
+    virtual void onLog( Logger &, const Logger::LogDesc &, const wchar_t * ) { ++count; }
+};
+
+static double sRun( size_t threadCount, size_t messagesPerThread, int level, bool binary = false )
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for( size_t t = 0; t < threadCount; ++t )
+    {
+        threads.emplace_back( [=]{
+            if( binary )
+            {
+                for( size_t i = 0; i < messagesPerThread; ++i )
+                {
+                    GN_BLOG( sLogger, level, "thread %d, message %d, value %f", (int)t, (int)i, i * 0.5 );
+                }
+            }
+            else
+            {
+                for( size_t i = 0; i < messagesPerThread; ++i )
+                {
+                    GN_LOG( sLogger, level )( "thread %d, message %d, value %f", (int)t, (int)i, i * 0.5 );
+                }
+            }
+        } );
+    }
+    for( auto & t : threads ) t.join();
+
+    // time spent by the logging threads only.
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if( binary ) flushBinaryLog(); else flushLog();
+
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+static void sReport( const char * name, size_t threadCount, size_t messagesPerThread, double seconds )
+{
+    double total = (double)( threadCount * messagesPerThread );
+    printf( "%-24s : %2d threads, %8d msgs, %8.3f ms, %10.0f msgs/s, %8.1f ns/msg\n",
+        name,
+        (int)threadCount,
+        (int)total,
+        seconds * 1000.0,
+        total / seconds,
+        seconds * 1e9 / total );
+}
+
+int main( int argc, const char * argv[] )
+{
+    size_t threadCount = 8;
+    size_t messagesPerThread = 100000;
+    if( argc > 1 ) threadCount = (size_t)atoi( argv[1] );
+    if( argc > 2 ) messagesPerThread = (size_t)atoi( argv[2] );
+    if( 0 == threadCount || 0 == messagesPerThread )
+    {
+        printf( "usage: %s [threads] [messages-per-thread]\n", argv[0] );
+        return -1;
+    }
+
+    // keep the console quiet, messages only go to the null receiver.
+    putEnv( "GN_LOG_QUIET", "1" );
+    NullReceiver r;
+    sLogger->addReceiver( &r );
+    sLogger->setLevel( Logger::INFO );
+
+    printf( "hardware threads: %d\n", (int)std::thread::hardware_concurrency() );
+
+    setLogAsync( false );
+    sReport( "sync", threadCount, messagesPerThread, sRun( threadCount, messagesPerThread, Logger::INFO ) );
+
+    setLogAsync( true );
+    sReport( "async", threadCount, messagesPerThread, sRun( threadCount, messagesPerThread, Logger::INFO ) );
+
+    sReport( "filtered (VERBOSE)", threadCount, messagesPerThread, sRun( threadCount, messagesPerThread, Logger::VERBOSE ) );
+
+    setLogAsync( false );
+    sReport( "binary", threadCount, messagesPerThread, sRun( threadCount, messagesPerThread, Logger::INFO, true ) );
+
+    sLogger->removeReceiver( &r );
+
+    printf( "delivered %d messages, %d binary records dropped\n", (int)r.count, (int)getBinaryLogDropCount() );
+
+    return 0;
+}
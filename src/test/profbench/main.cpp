@@ -0,0 +1,96 @@
+#include "pch.h"
+#include <thread>
+#include <vector>
+
+using namespace GN;
+
+static double sRun( size_t threadCount, size_t scopesPerThread )
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for( size_t t = 0; t < threadCount; ++t )
+    {
+        threads.emplace_back( [=]{
+            ProfilerManager::sSetThreadName( str::format( "worker %d", (int)t ).rawptr() );
+            ProfileTimer & outer = ProfilerManager::sGetGlobalInstance().getTimer( "profbench.outer" );
+            ProfileTimer & inner = ProfilerManager::sGetGlobalInstance().getTimer( "profbench.inner" );
+            for( size_t i = 0; i < scopesPerThread; i += 2 )
+            {
+                ScopeTimer s1( &outer );
+                ScopeTimer s2( &inner );
+            }
+        } );
+    }
+    for( auto & t : threads ) t.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    ProfilerManager::sGetGlobalInstance().aggregate();
+
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+static void sReport( const char * name, size_t threadCount, size_t scopesPerThread, double seconds )
+{
+    double total = (double)( threadCount * scopesPerThread );
+    printf( "%-24s : %2d threads, %8d scopes, %8.3f ms, %8.1f ns/scope\n",
+        name,
+        (int)threadCount,
+        (int)total,
+        seconds * 1000.0,
+        seconds * 1e9 / total );
+}
+
+int main( int argc, const char * argv[] )
+{
+    size_t threadCount = 8;
+    size_t scopesPerThread = 20000;
+    if( argc > 1 ) threadCount = (size_t)atoi( argv[1] );
+    if( argc > 2 ) scopesPerThread = (size_t)atoi( argv[2] );
+    if( 0 == threadCount || 0 == scopesPerThread )
+    {
+        printf( "usage: %s [threads] [scopes-per-thread]\n", argv[0] );
+        return -1;
+    }
+
+    printf( "hardware threads: %u\n", std::thread::hardware_concurrency() );
+
+    static const struct { ProfilerMode mode; const char * name; } MODES[] =
+    {
+        { PM_OFF,          "off" },
+        { PM_LOW_OVERHEAD, "low-overhead" },
+        { PM_FULL,         "full" },
+    };
+
+    for( const auto & m : MODES )
+    {
+        ProfilerManager::sSetMode( m.mode );
+        printf( "%-24s : single thread, %8.1f ns/scope\n", m.name, ProfilerManager::sMeasureScopeOverhead() * 1e9 );
+        sReport( m.name, threadCount, scopesPerThread, sRun( threadCount, scopesPerThread ) );
+    }
+
+    ProfilerManager::sSetMode( PM_FULL );
+
+    if( ProfilerManager::sEnableHardwareCounters( true ) )
+    {
+        printf( "%-24s : single thread, %8.1f ns/scope\n", "full+counters", ProfilerManager::sMeasureScopeOverhead() * 1e9 );
+        sReport( "full+counters", threadCount, scopesPerThread, sRun( threadCount, scopesPerThread ) );
+        ProfilerManager::sEnableHardwareCounters( false );
+    }
+    else
+    {
+        printf( "%-24s : not available\n", "full+counters" );
+    }
+
+    // capture a timeline of one run
+    ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+    pm.startTrace( TM_RECORD );
+    sRun( threadCount, 1000 );
+    pm.stopTrace();
+    pm.saveTrace( "profbench.json", TF_CHROME_JSON );
+    pm.saveTrace( "profbench.perfetto-trace", TF_PERFETTO );
+    printf( "trace saved to profbench.json and profbench.perfetto-trace\n" );
+
+    return 0;
+}
@@ -1,73 +1,217 @@
 #include "pch.h"
 #include <stdio.h>
+#include <chrono>
+#include <Eigen/Eigen>
+#if __has_include(<glm/glm.hpp>)
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
-#include <Eigen/Eigen>
+#define HAS_GLM 1
+#else
+#define HAS_GLM 0
+#endif
+#if defined(_MSC_VER)
 #include "directxmath.h"
+#define HAS_DIRECTXMATH 1
+#else
+#define HAS_DIRECTXMATH 0
+#endif
 
 using namespace GN;
-using namespace DirectX;
 
-static size_t COUNT = 1024 * 1024 * 64;
+static size_t COUNT = 1024 * 1024 * 16;
+
+// keep results alive, so the compiler can't throw the loops away.
+static volatile float sSink;
 
-template<typename V4, typename M4>
-V4 matrixTransform(const M4 & m)
+template<typename FUNC>
+static void sRun( const char * lib, const char * op, FUNC f )
 {
-    V4 v1(0.1f, 0.2f, 0.3f, 0.4f);
-    V4 v2 = V4(0.f, 0.f, 0.f, 0.f);
-    for(size_t i = 0; i < COUNT; ++i) {
-        v2 += m * v1;
-    }
-    return v2;
+    auto start = std::chrono::high_resolution_clock::now();
+    float r = f();
+    auto end = std::chrono::high_resolution_clock::now();
+    sSink = r;
+    double seconds = std::chrono::duration<double>( end - start ).count();
+    printf( "%-12s %-12s : %8.3f ms, %6.2f ns/op (%f)\n", lib, op, seconds * 1000.0, seconds * 1e9 / COUNT, r );
 }
 
-glm::vec4 glmtest(const float * t)
+// *****************************************************************************
+// garnet
+// *****************************************************************************
+
+static void sGarnet( const float * t )
 {
-    auto m = glm::translate(glm::mat4(1.), glm::vec3(t[0], t[1], t[2]));
-    GN_FUNCTION_PROFILER();
-    return matrixTransform<glm::vec4, glm::mat4>(m);
+    Matrix44f m = Matrix44f::sTranslate( Vector3f( t[0], t[1], t[2] ) );
+    Matrix44f r; r.rotateY( t[0] );
+    Quaternionf q1( 0.1f, 0.2f, 0.3f, 0.9f ); q1.normalize();
+    Quaternionf q2( t[0], t[1], t[2], 0.5f ); q2.normalize();
+
+    sRun( "garnet", "transform", [&]{
+        Vector4f v1( 0.1f, 0.2f, 0.3f, 0.4f ), v2( 0, 0, 0, 0 );
+        for( size_t i = 0; i < COUNT; ++i ) { v2 += m * v1; v1.x += 1e-7f; }
+        return v2.x + v2.y + v2.z + v2.w;
+    } );
+
+    sRun( "garnet", "multiply", [&]{
+        Matrix44f a = m;
+        for( size_t i = 0; i < COUNT; ++i ) { a *= r; a[0][3] = t[0]; }
+        return a[0][0] + a[1][1];
+    } );
+
+    sRun( "garnet", "inverse", [&]{
+        Matrix44f a = m * r;
+        float s = 0;
+        for( size_t i = 0; i < COUNT; ++i ) { a[0][3] = (float)( i & 15 ); s += Matrix44f::sInverse( a )[0][3]; }
+        return s;
+    } );
+
+    sRun( "garnet", "quaternion", [&]{
+        Quaternionf a = q1;
+        for( size_t i = 0; i < COUNT; ++i ) { a = a * q2; a.w += 1e-7f; }
+        return a.v.x + a.w;
+    } );
 }
 
-Eigen::Vector4f EigenTest(const float * t)
+// *****************************************************************************
+// Eigen
+// *****************************************************************************
+
+static void sEigen( const float * t )
 {
-    auto m = Eigen::Affine3f(Eigen::Translation<float, 3>(t[0], t[1], t[2])).matrix();
-    GN_FUNCTION_PROFILER();
-    return matrixTransform<Eigen::Vector4f, Eigen::Matrix4f>(m);
+    Eigen::Matrix4f m = Eigen::Affine3f( Eigen::Translation<float, 3>( t[0], t[1], t[2] ) ).matrix();
+    Eigen::Matrix4f r = Eigen::Affine3f( Eigen::AngleAxisf( t[0], Eigen::Vector3f::UnitY() ) ).matrix();
+    Eigen::Quaternionf q1( 0.9f, 0.1f, 0.2f, 0.3f ); q1.normalize();
+    Eigen::Quaternionf q2( 0.5f, t[0], t[1], t[2] ); q2.normalize();
+
+    sRun( "Eigen", "transform", [&]{
+        Eigen::Vector4f v1( 0.1f, 0.2f, 0.3f, 0.4f ), v2( 0, 0, 0, 0 );
+        for( size_t i = 0; i < COUNT; ++i ) { v2 += m * v1; v1.x() += 1e-7f; }
+        return v2.sum();
+    } );
+
+    sRun( "Eigen", "multiply", [&]{
+        Eigen::Matrix4f a = m;
+        for( size_t i = 0; i < COUNT; ++i ) { a = a * r; a( 0, 3 ) = t[0]; }
+        return a( 0, 0 ) + a( 1, 1 );
+    } );
+
+    sRun( "Eigen", "inverse", [&]{
+        Eigen::Matrix4f a = m * r;
+        float s = 0;
+        for( size_t i = 0; i < COUNT; ++i ) { a( 0, 3 ) = (float)( i & 15 ); s += a.inverse()( 0, 3 ); }
+        return s;
+    } );
+
+    sRun( "Eigen", "quaternion", [&]{
+        Eigen::Quaternionf a = q1;
+        for( size_t i = 0; i < COUNT; ++i ) { a = a * q2; a.w() += 1e-7f; }
+        return a.x() + a.w();
+    } );
 }
 
-DirectX::XMVECTOR DirectXMathTest(const float * t)
+// *****************************************************************************
+// glm
+// *****************************************************************************
+
+#if HAS_GLM
+static void sGlm( const float * t )
 {
-    XMMATRIX m = XMMatrixTranslation(t[0], t[1], t[2]);
-    GN_FUNCTION_PROFILER();
-    XMVECTOR v1 = XMVectorSet(0.1f, 0.2f, 0.3f, 0.4f);
-    XMVECTOR v2 = XMVectorSet(0.f, 0.f, 0.f, 0.f);
-    for (size_t i = 0; i < COUNT; ++i) {
-        v2 += XMVector4Transform(v1, m);
-    }
-    return v2;
+    glm::mat4 m = glm::translate( glm::mat4( 1.f ), glm::vec3( t[0], t[1], t[2] ) );
+    glm::mat4 r = glm::rotate( glm::mat4( 1.f ), t[0], glm::vec3( 0, 1, 0 ) );
+    glm::quat q1 = glm::normalize( glm::quat( 0.9f, 0.1f, 0.2f, 0.3f ) );
+    glm::quat q2 = glm::normalize( glm::quat( 0.5f, t[0], t[1], t[2] ) );
+
+    sRun( "glm", "transform", [&]{
+        glm::vec4 v1( 0.1f, 0.2f, 0.3f, 0.4f ), v2( 0.f );
+        for( size_t i = 0; i < COUNT; ++i ) { v2 += m * v1; v1.x += 1e-7f; }
+        return v2.x + v2.y + v2.z + v2.w;
+    } );
+
+    sRun( "glm", "multiply", [&]{
+        glm::mat4 a = m;
+        for( size_t i = 0; i < COUNT; ++i ) { a = a * r; a[3][0] = t[0]; }
+        return a[0][0] + a[1][1];
+    } );
+
+    sRun( "glm", "inverse", [&]{
+        glm::mat4 a = m * r;
+        float s = 0;
+        for( size_t i = 0; i < COUNT; ++i ) { a[3][0] = (float)( i & 15 ); s += glm::inverse( a )[3][0]; }
+        return s;
+    } );
+
+    sRun( "glm", "quaternion", [&]{
+        glm::quat a = q1;
+        for( size_t i = 0; i < COUNT; ++i ) { a = a * q2; a.w += 1e-7f; }
+        return a.x + a.w;
+    } );
 }
+#endif
+
+// *****************************************************************************
+// DirectXMath
+// *****************************************************************************
 
-int main()
+#if HAS_DIRECTXMATH
+static void sDirectXMath( const float * t )
 {
-    float t[3];
-    for (int i = 0; i < 3; ++i) {
-        t[i] = (float)rand() / RAND_MAX;
-    }
+    using namespace DirectX;
 
+    XMMATRIX m = XMMatrixTranslation( t[0], t[1], t[2] );
+    XMMATRIX r = XMMatrixRotationY( t[0] );
+    XMVECTOR q1 = XMQuaternionNormalize( XMVectorSet( 0.1f, 0.2f, 0.3f, 0.9f ) );
+    XMVECTOR q2 = XMQuaternionNormalize( XMVectorSet( t[0], t[1], t[2], 0.5f ) );
+    XMVECTOR eps = XMVectorSet( 1e-7f, 0, 0, 0 );
+
+    sRun( "DirectXMath", "transform", [&]{
+        XMVECTOR v1 = XMVectorSet( 0.1f, 0.2f, 0.3f, 0.4f ), v2 = XMVectorZero();
+        for( size_t i = 0; i < COUNT; ++i ) { v2 += XMVector4Transform( v1, m ); v1 += eps; }
+        return XMVectorGetX( XMVector4Dot( v2, XMVectorSplatOne() ) );
+    } );
+
+    sRun( "DirectXMath", "multiply", [&]{
+        XMMATRIX a = m;
+        for( size_t i = 0; i < COUNT; ++i ) { a = XMMatrixMultiply( a, r ); a.r[3] = XMVectorSetX( a.r[3], t[0] ); }
+        return XMVectorGetX( a.r[0] ) + XMVectorGetY( a.r[1] );
+    } );
+
+    sRun( "DirectXMath", "inverse", [&]{
+        XMMATRIX a = XMMatrixMultiply( m, r );
+        float s = 0;
+        for( size_t i = 0; i < COUNT; ++i ) { a.r[3] = XMVectorSetX( a.r[3], (float)( i & 15 ) ); s += XMVectorGetX( XMMatrixInverse( nullptr, a ).r[3] ); }
+        return s;
+    } );
+
+    sRun( "DirectXMath", "quaternion", [&]{
+        XMVECTOR a = q1;
+        for( size_t i = 0; i < COUNT; ++i ) { a = XMQuaternionMultiply( q2, a ) + eps; }
+        return XMVectorGetX( a ) + XMVectorGetW( a );
+    } );
+}
+#endif
+
+int main( int argc, const char * argv[] )
+{
+    if( argc > 1 ) COUNT = (size_t)atoi( argv[1] );
+    if( 0 == COUNT )
     {
-        auto v = DirectXMathTest(t);
-        printf("DirectXMath: %f, %f, %f, %f\n",
-            DirectX::XMVectorGetX(v),
-            DirectX::XMVectorGetY(v),
-            DirectX::XMVectorGetZ(v),
-            DirectX::XMVectorGetW(v));
-    }
-    {
-        auto v = glmtest(t);
-        printf("glm: %f, %f, %f, %f\n", v.x, v.y, v.z, v.w);
+        printf( "usage: %s [iterations]\n", argv[0] );
+        return -1;
     }
+
+    printf( "garnet SIMD: %s\n", GN_SIMD_AVX ? "AVX" : GN_SIMD_SSE ? "SSE" : GN_SIMD_NEON ? "NEON" : "none" );
+
+    float t[3];
+    for( int i = 0; i < 3; ++i )
     {
-        auto v = EigenTest(t);
-        printf("Eigen: %f, %f, %f, %f\n", v.x(), v.y(), v.z(), v.w());
+        t[i] = (float)rand() / RAND_MAX;
     }
+
+    sGarnet( t );
+    sEigen( t );
+#if HAS_GLM
+    sGlm( t );
+#endif
+#if HAS_DIRECTXMATH
+    sDirectXMath( t );
+#endif
 }
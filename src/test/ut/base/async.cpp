@@ -0,0 +1,114 @@
+#include "../testCommon.h"
+#include <thread>
+
+class AsyncLoaderTest : public CxxTest::TestSuite
+{
+public:
+
+    void testPriorityAndCancel()
+    {
+        using namespace GN;
+
+        JobSystem js( 1 );
+        AsyncLoader loader( js, 1 );
+
+        // occupy the only slot, so everything below stays queued.
+        std::atomic<bool> open( false );
+        AsyncResult<int> gate = loader.run<int>( "ut.async.gate", AsyncPriority::NORMAL,
+            [&]( int & ) { while( !open ) std::this_thread::yield(); return true; } );
+
+        Mutex lock;
+        DynaArray<int> order;
+        auto record = [&]( int id ) {
+            return [&, id]( int & v ) { std::lock_guard<Mutex> l( lock ); order.append( id ); v = id; return true; };
+        };
+
+        AsyncResult<int> a = loader.run<int>( "ut.async.a", AsyncPriority::LOW, record( 1 ) );
+        AsyncResult<int> b = loader.run<int>( "ut.async.b", AsyncPriority::NORMAL, record( 2 ) );
+        AsyncResult<int> c = loader.run<int>( "ut.async.c", AsyncPriority::HIGH, record( 3 ) );
+        AsyncResult<int> d = loader.run<int>( "ut.async.d", AsyncPriority::LOW, record( 4 ) );
+        AsyncResult<int> e = loader.run<int>( "ut.async.e", AsyncPriority::NORMAL, record( 5 ) );
+        d.setPriority( AsyncPriority::HIGH );
+        TS_ASSERT_EQUALS( d.operation()->getPriority(), AsyncPriority::HIGH );
+        TS_ASSERT_EQUALS( a.getStatus(), AsyncStatus::QUEUED );
+        TS_ASSERT_EQUALS( loader.getPendingCount(), 6u );
+
+        // queued operation is cancelled right away.
+        e.cancel();
+        TS_ASSERT_EQUALS( e.getStatus(), AsyncStatus::CANCELLED );
+        TS_ASSERT_EQUALS( loader.getPendingCount(), 5u );
+
+        open = true;
+        loader.waitAll();
+        TS_ASSERT_EQUALS( loader.getPendingCount(), 0u );
+        TS_ASSERT( gate.succeeded() );
+        TS_ASSERT( a.succeeded() && b.succeeded() && c.succeeded() && d.succeeded() );
+
+        // high first, FIFO within the same priority.
+        TS_ASSERT_EQUALS( order.size(), 4u );
+        if( 4 != order.size() ) return;
+        TS_ASSERT_EQUALS( order[0], 3 );
+        TS_ASSERT_EQUALS( order[1], 4 );
+        TS_ASSERT_EQUALS( order[2], 2 );
+        TS_ASSERT_EQUALS( order[3], 1 );
+        TS_ASSERT_EQUALS( d.value(), 4 );
+        TS_ASSERT_EQUALS( e.value(), 0 );
+    }
+
+    void testFinishOnMainThread()
+    {
+        using namespace GN;
+
+        JobSystem js( 2 );
+        AsyncLoader loader( js );
+        TS_ASSERT( js.isMainThread() );
+
+        std::thread::id workThread, finishThread, callbackThread;
+        AsyncResult<int> r = loader.run<int>( "ut.async.stages", AsyncPriority::NORMAL,
+            [&]( int & v ) { workThread = std::this_thread::get_id(); v = 21; return true; },
+            [&]( int & v ) { finishThread = std::this_thread::get_id(); v *= 2; return true; } );
+
+        int called = 0;
+        r.then( [&]( AsyncResult<int> & self ) {
+            callbackThread = std::this_thread::get_id();
+            called += self.value();
+        } );
+
+        // get() pumps main thread jobs while waiting.
+        TS_ASSERT_EQUALS( r.get(), 42 );
+        TS_ASSERT( r.succeeded() );
+        TS_ASSERT_DIFFERS( workThread, std::this_thread::get_id() );
+        TS_ASSERT_EQUALS( finishThread, std::this_thread::get_id() );
+
+        // callbacks of done operations are still deferred to update().
+        while( 0 == called ) loader.update();
+        TS_ASSERT_EQUALS( callbackThread, std::this_thread::get_id() );
+        r.then( [&]( AsyncResult<int> & ) { ++called; } );
+        TS_ASSERT_EQUALS( called, 42 );
+        loader.update();
+        TS_ASSERT_EQUALS( called, 43 );
+    }
+
+    void testFailure()
+    {
+        using namespace GN;
+
+        JobSystem js( 1 );
+        AsyncLoader loader( js );
+
+        bool finished = false, called = false;
+        AsyncResult<int> r = loader.run<int>( "ut.async.fail", AsyncPriority::NORMAL,
+            []( int & ) { return false; },
+            [&]( int & ) { finished = true; return true; } );
+        r.then( [&]( AsyncResult<int> & self ) { called = !self.succeeded(); } );
+        r.wait();
+        TS_ASSERT_EQUALS( r.getStatus(), AsyncStatus::FAILED );
+        TS_ASSERT( !finished );
+        while( !called ) loader.update();
+
+        // an empty result is done and failed.
+        AsyncResult<int> empty;
+        TS_ASSERT( empty.isDone() );
+        TS_ASSERT( !empty.succeeded() );
+    }
+};
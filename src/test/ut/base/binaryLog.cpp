@@ -0,0 +1,127 @@
+#include "../testCommon.h"
+
+class BinaryLogTest : public CxxTest::TestSuite
+{
+    struct TextReceiver : public GN::Logger::Receiver
+    {
+        std::mutex mutex;
+        GN::DynaArray<GN::StrA> messages;
+
+        virtual void onLog( GN::Logger &, const GN::Logger::LogDesc &, const char * msg )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            messages.append( msg );
+        }
+
+        virtual void onLog( GN::Logger &, const GN::Logger::LogDesc &, const wchar_t * ) {}
+    };
+
+    struct FieldSink : public GN::BinaryLogSink
+    {
+        std::atomic<int> records;
+        std::atomic<int> keyed;
+        sint64           bytes;
+
+        FieldSink() : records(0), keyed(0), bytes(0) {}
+
+        virtual void onRecord( const GN::BinaryLogRecord & r )
+        {
+            ++records;
+            for( size_t i = 0; i < r.fieldCount; ++i )
+            {
+                if( r.fields[i].key && 0 == GN::str::compare( r.fields[i].key, "bytes" ) )
+                {
+                    ++keyed;
+                    bytes = r.fields[i].s;
+                }
+            }
+        }
+    };
+
+public:
+
+    void testRender()
+    {
+        using namespace GN;
+
+        GN::BinaryLogField f[6];
+        memset( f, 0, sizeof(f) );
+        f[0].type = BLFT_SINT;   f[0].s = -42;
+        f[1].type = BLFT_DOUBLE; f[1].d = 3.25;
+        f[2].type = BLFT_STRING; f[2].str = "abc"; f[2].length = 3;
+        f[3].type = BLFT_UINT;   f[3].u = 255;
+        f[4].type = BLFT_SINT;   f[4].s = 7; f[4].key = "frame";
+        f[5].type = BLFT_SINT;   f[5].s = 5;
+
+        StrA text;
+        renderBinaryLogText( text, "%d %.2f [%5s] %#x %ld%%", f, 6 );
+        TS_ASSERT_EQUALS( "-42 3.25 [  abc] 0xff 5% frame=7", text );
+
+        // missing argument
+        renderBinaryLogText( text, "%d %s", f, 1 );
+        TS_ASSERT_EQUALS( "-42 %s", text );
+    }
+
+    void testBinaryLog()
+    {
+        GN::Logger * logger = GN::getLogger( "GN.test.UT.BinaryLog" );
+        TextReceiver r;
+        FieldSink s;
+        logger->addReceiver( &r );
+        GN::addBinaryLogSink( &s );
+
+        GN::StrA name( "name" );
+        GN_BINFO( logger, "int=%d uint=%u float=%.1f str=%s ptr=%p", -1, 2u, 0.5f, "hello", (void*)NULL );
+        GN_BINFO( logger, "loaded %s", name, GN::logField( "bytes", (sint64)1024 ) );
+        GN_BINFO( logger, "no arguments" );
+        GN_BVVERBOSE( logger, "filtered %d", 1 );
+
+        std::thread t( [=]{ GN_BWARN( logger, "from thread %d", 1 ); } );
+        t.join();
+
+        GN::flushBinaryLog();
+
+        TS_ASSERT_EQUALS( 4u, r.messages.size() );
+        if( 4u == r.messages.size() )
+        {
+            GN::StrA ptr = GN::str::format( "%p", (void*)NULL );
+            TS_ASSERT_EQUALS( GN::str::format( "int=-1 uint=2 float=0.5 str=hello ptr=%s", ptr.rawptr() ), r.messages[0] );
+            TS_ASSERT_EQUALS( "loaded name bytes=1024", r.messages[1] );
+            TS_ASSERT_EQUALS( "no arguments", r.messages[2] );
+            TS_ASSERT_EQUALS( "from thread 1", r.messages[3] );
+        }
+        TS_ASSERT_EQUALS( 4, s.records.load() );
+        TS_ASSERT_EQUALS( 1, s.keyed.load() );
+        TS_ASSERT_EQUALS( 1024, s.bytes );
+
+        GN::removeBinaryLogSink( &s );
+        logger->removeReceiver( &r );
+    }
+
+    void testFatalIsSynchronous()
+    {
+        GN::Logger * logger = GN::getLogger( "GN.test.UT.BinaryLog" );
+        TextReceiver r;
+        FieldSink s;
+        logger->addReceiver( &r );
+        GN::addBinaryLogSink( &s );
+
+        GN_BINFO( logger, "before fatal" );
+        GN_BFATAL( logger, "fatal %d", 1 );
+
+        // delivered before GN_BFATAL returns, after records written before it.
+        {
+            std::lock_guard<std::mutex> lock( r.mutex );
+            TS_ASSERT_EQUALS( 2u, r.messages.size() );
+            if( 2u == r.messages.size() )
+            {
+                TS_ASSERT_EQUALS( "before fatal", r.messages[0] );
+                TS_ASSERT_EQUALS( "fatal 1", r.messages[1] );
+            }
+        }
+        TS_ASSERT_EQUALS( 2, s.records.load() );
+
+        GN::removeBinaryLogSink( &s );
+        logger->removeReceiver( &r );
+    }
+};
@@ -0,0 +1,343 @@
+#include "../testCommon.h"
+#include "garnet/GNgfx.h"
+#include <vector>
+#include <math.h>
+
+class BlockCompressionTest : public CxxTest::TestSuite
+{
+    typedef GN::gfx::BlockCompressionQuality Quality;
+
+    // Reference images, RGBA8 of 64x64 pixels.
+    enum Reference
+    {
+        GRADIENT, // smooth color ramps
+        NOISE,    // random pixels, worst case
+        EDGES,    // flat shapes with hard edges
+        ALPHA,    // color ramp with a separate alpha ramp, and holes
+        NUM_REFERENCES,
+    };
+
+    static std::vector<uint8> sReference( Reference r )
+    {
+        using namespace GN;
+        std::vector<uint8> p( 64 * 64 * 4 );
+        uint64 seed = 7 + r;
+        for( uint32 y = 0; y < 64; ++y )
+        for( uint32 x = 0; x < 64; ++x )
+        {
+            uint8 * c = &p[( y * 64 + x ) * 4];
+            switch( r )
+            {
+                case GRADIENT:
+                    c[0] = (uint8)( x * 4 );
+                    c[1] = (uint8)( y * 4 );
+                    c[2] = (uint8)( 255 - ( x + y ) * 2 );
+                    c[3] = 255;
+                    break;
+                case NOISE:
+                    c[0] = (uint8)nextRandom32( seed );
+                    c[1] = (uint8)nextRandom32( seed );
+                    c[2] = (uint8)nextRandom32( seed );
+                    c[3] = 255;
+                    break;
+                case EDGES:
+                {
+                    // a disk and a bar over two halves of background
+                    static const uint8 COLORS[4][3] = { { 230, 40, 20 }, { 20, 60, 220 }, { 250, 240, 200 }, { 10, 120, 30 } };
+                    sint32 dx = (sint32)x - 20, dy = (sint32)y - 24;
+                    uint32 k = dx * dx + dy * dy < 14 * 14 ? 1 : ( abs( (sint32)x - (sint32)y - 10 ) < 6 ? 2 : ( x < 40 ? 0 : 3 ) );
+                    c[0] = COLORS[k][0];
+                    c[1] = COLORS[k][1];
+                    c[2] = COLORS[k][2];
+                    c[3] = 255;
+                    break;
+                }
+                default:
+                    c[0] = (uint8)( 128 + 100 * sin( x * 0.2 ) );
+                    c[1] = (uint8)( y * 3 );
+                    c[2] = 90;
+                    c[3] = ( x / 8 + y / 8 ) % 5 ? (uint8)( 255 - y * 4 ) : 0;
+                    break;
+            }
+        }
+        return p;
+    }
+
+    // Compress and decompress a 64x64 image, block row by block row.
+    static std::vector<uint8> sRoundTrip( GN::gfx::ColorFormat format, const std::vector<uint8> & src, Quality quality )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+        const size_t pitch = 64 * 4;
+        std::vector<uint8> blocks( 16 * format.getBytesPerBlock() );
+        std::vector<uint8> dst( src.size() );
+        for( size_t by = 0; by < 16; ++by )
+        {
+            TS_ASSERT( encodeBlocks( format, &src[by * 4 * pitch], pitch, blocks.data(), 16, quality ) );
+            TS_ASSERT( decodeBlocks( format, blocks.data(), 16, &dst[by * 4 * pitch], pitch ) );
+        }
+        return dst;
+    }
+
+    // PSNR of channels [0, channels), in dB. Identical images are 999.
+    static double sPsnr( const std::vector<uint8> & a, const std::vector<uint8> & b, uint32 channels )
+    {
+        double sse = 0;
+        size_t n = 0;
+        for( size_t i = 0; i < a.size(); i += 4 )
+            for( uint32 c = 0; c < channels; ++c, ++n )
+            {
+                double d = (double)a[i + c] - (double)b[i + c];
+                sse += d * d;
+            }
+        if( 0 == sse ) return 999.0;
+        return 10.0 * log10( 255.0 * 255.0 * n / sse );
+    }
+
+    // Check PSNR of every reference and quality. Better quality never loses.
+    static void sCheckPsnr( GN::gfx::ColorFormat format, uint32 channels, const double minPsnr[NUM_REFERENCES] )
+    {
+        for( int r = 0; r < NUM_REFERENCES; ++r )
+        {
+            std::vector<uint8> ref = sReference( (Reference)r );
+            double fast   = sPsnr( ref, sRoundTrip( format, ref, Quality::FAST ), channels );
+            double normal = sPsnr( ref, sRoundTrip( format, ref, Quality::NORMAL ), channels );
+            double high   = sPsnr( ref, sRoundTrip( format, ref, Quality::HIGH ), channels );
+            TS_ASSERT_LESS_EQUALS( minPsnr[r], fast );
+            TS_ASSERT_LESS_EQUALS( fast - 0.05, normal );
+            TS_ASSERT_LESS_EQUALS( normal - 0.05, high );
+        }
+    }
+
+public:
+
+    void testFormats()
+    {
+        using namespace GN::gfx;
+
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXT1_UNORM ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXT1_UNORM_SRGB ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXT3_UNORM ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXT5_UNORM_SRGB ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXT5A_SNORM ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::DXN_UNORM ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::BC7_UNORM ) );
+        TS_ASSERT( isCompressibleColorFormat( ColorFormat::BC7_UNORM_SRGB ) );
+        TS_ASSERT( !isCompressibleColorFormat( ColorFormat::RGBA8 ) );
+        TS_ASSERT( !isCompressibleColorFormat( ColorFormat::UNKNOWN ) );
+        TS_ASSERT( !isCompressibleColorFormat( ColorFormat( ColorFormat::LAYOUT_CTX1, ColorFormat::SIGN_UNORM, ColorFormat::SIGN_UNORM, ColorFormat::SWIZZLE_RGBA ) ) );
+
+        TS_ASSERT_EQUALS( ColorFormat::RGBA8, getUncompressedColorFormat( ColorFormat::DXT1_UNORM ) );
+        TS_ASSERT_EQUALS( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, getUncompressedColorFormat( ColorFormat::BC7_UNORM_SRGB ) );
+        TS_ASSERT_EQUALS( ColorFormat::RGBA_8_8_8_8_SNORM, getUncompressedColorFormat( ColorFormat::DXN_SNORM ) );
+        TS_ASSERT_EQUALS( ColorFormat::UNKNOWN, getUncompressedColorFormat( ColorFormat::RGBA8 ) );
+
+        TS_ASSERT_EQUALS( 16u, ColorFormat( ColorFormat::BC7_UNORM ).getBytesPerBlock() );
+        TS_ASSERT_EQUALS( 4u, ColorFormat( ColorFormat::BC7_UNORM ).layoutDesc().blockWidth );
+        TS_ASSERT_EQUALS( ColorFormat::BC7_UNORM_SRGB, dxgiFormat2ColorFormat( 99 ) );
+        TS_ASSERT_EQUALS( 98, colorFormat2DxgiFormat( ColorFormat::BC7_UNORM ) );
+
+        uint8 pixels[64] = {}, block[16];
+        TS_ASSERT( !encodeBlocks( ColorFormat::RGBA8, pixels, 16, block, 1 ) );
+        TS_ASSERT( !decodeBlocks( ColorFormat::RGBA8, block, 1, pixels, 16 ) );
+    }
+
+    void testDecodeKnownBlocks()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+        uint8 px[64];
+
+        // BC1, 4 colors: red and blue end points, every index 2 is 2/3 red.
+        const uint8 bc1[8] = { 0x00, 0xF8, 0x1F, 0x00, 0xAA, 0xAA, 0xAA, 0xAA };
+        TS_ASSERT( decodeBlocks( ColorFormat::DXT1_UNORM, bc1, 1, px, 16 ) );
+        TS_ASSERT_EQUALS( 170, px[0] );
+        TS_ASSERT_EQUALS( 0, px[1] );
+        TS_ASSERT_EQUALS( 85, px[2] );
+        TS_ASSERT_EQUALS( 255, px[3] );
+
+        // BC1, 3 colors: index 3 is transparent black.
+        const uint8 bc1t[8] = { 0x1F, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF };
+        TS_ASSERT( decodeBlocks( ColorFormat::DXT1_UNORM, bc1t, 1, px, 16 ) );
+        for( int i = 0; i < 64; ++i ) TS_ASSERT_EQUALS( 0, px[i] );
+
+        // BC4, 8 values from 255 to 0, every index 7 is 1/7 of the way.
+        const uint8 bc4[8] = { 255, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+        TS_ASSERT( decodeBlocks( ColorFormat::DXT5A_UNORM, bc4, 1, px, 16 ) );
+        TS_ASSERT_EQUALS( 36, px[60] );
+        TS_ASSERT_EQUALS( 0, px[61] );
+        TS_ASSERT_EQUALS( 255, px[63] );
+
+        // BC7 mode 6, all end points 0x7F with p-bits 1: white.
+        const uint8 bc7[16] = { 0xC0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+        TS_ASSERT( decodeBlocks( ColorFormat::BC7_UNORM, bc7, 1, px, 16 ) );
+        for( int i = 0; i < 64; ++i ) TS_ASSERT_EQUALS( 255, px[i] );
+
+        // BC7 reserved mode 8: transparent black.
+        const uint8 bc7r[16] = {};
+        TS_ASSERT( decodeBlocks( ColorFormat::BC7_UNORM, bc7r, 1, px, 16 ) );
+        for( int i = 0; i < 64; ++i ) TS_ASSERT_EQUALS( 0, px[i] );
+    }
+
+    void testSolidColors()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        uint64 seed = 99;
+        for( int k = 0; k < 64; ++k )
+        {
+            uint32 color = nextRandom32( seed );
+            uint8 src[64], dst[64], block[16];
+            for( int i = 0; i < 16; ++i ) memcpy( src + i * 4, &color, 4 );
+
+            // BC7 mode 6 shares p-bits between channels, so it is off by 1 at most.
+            TS_ASSERT( encodeBlocks( ColorFormat::BC7_UNORM, src, 16, block, 1, Quality::FAST ) );
+            TS_ASSERT( decodeBlocks( ColorFormat::BC7_UNORM, block, 1, dst, 16 ) );
+            for( int i = 0; i < 64; ++i ) TS_ASSERT_LESS_EQUALS( abs( src[i] - dst[i] ), 1 );
+
+            // BC3 alpha is exact.
+
+            TS_ASSERT( encodeBlocks( ColorFormat::DXT5_UNORM, src, 16, block, 1 ) );
+            TS_ASSERT( decodeBlocks( ColorFormat::DXT5_UNORM, block, 1, dst, 16 ) );
+            for( int i = 0; i < 16; ++i )
+            {
+                TS_ASSERT_EQUALS( src[i * 4 + 3], dst[i * 4 + 3] );
+                for( int c = 0; c < 3; ++c ) TS_ASSERT_LESS_EQUALS( abs( src[i * 4 + c] - dst[i * 4 + c] ), 4 );
+            }
+
+            // opaque blocks stay opaque
+            for( int i = 0; i < 16; ++i ) src[i * 4 + 3] = 255;
+            TS_ASSERT( encodeBlocks( ColorFormat::BC7_UNORM, src, 16, block, 1, Quality::FAST ) );
+            TS_ASSERT( decodeBlocks( ColorFormat::BC7_UNORM, block, 1, dst, 16 ) );
+            for( int i = 0; i < 16; ++i ) TS_ASSERT_EQUALS( 255, dst[i * 4 + 3] );
+            TS_ASSERT( encodeBlocks( ColorFormat::DXT1_UNORM, src, 16, block, 1, Quality::HIGH ) );
+            TS_ASSERT( decodeBlocks( ColorFormat::DXT1_UNORM, block, 1, dst, 16 ) );
+            for( int i = 0; i < 16; ++i )
+            {
+                TS_ASSERT_EQUALS( 255, dst[i * 4 + 3] );
+                for( int c = 0; c < 3; ++c ) TS_ASSERT_LESS_EQUALS( abs( src[i * 4 + c] - dst[i * 4 + c] ), 4 );
+            }
+        }
+    }
+
+    void testBc1PunchThroughAlpha()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        std::vector<uint8> ref = sReference( ALPHA );
+        std::vector<uint8> out = sRoundTrip( ColorFormat::DXT1_UNORM, ref, Quality::NORMAL );
+        for( size_t i = 0; i < ref.size(); i += 4 )
+        {
+            TS_ASSERT_EQUALS( ref[i + 3] < 128 ? 0 : 255, out[i + 3] );
+        }
+    }
+
+    void testPsnrBc1()
+    {
+        // transparent pixels of the alpha reference decode to black
+        const double MIN_PSNR[] = { 37, 12, 26, 0 };
+        sCheckPsnr( GN::gfx::ColorFormat::DXT1_UNORM, 3, MIN_PSNR );
+    }
+
+    void testPsnrBc2()
+    {
+        const double MIN_PSNR[] = { 38, 13, 27, 35 };
+        sCheckPsnr( GN::gfx::ColorFormat::DXT3_UNORM, 4, MIN_PSNR );
+    }
+
+    void testPsnrBc3()
+    {
+        const double MIN_PSNR[] = { 38, 13, 27, 37 };
+        sCheckPsnr( GN::gfx::ColorFormat::DXT5_UNORM, 4, MIN_PSNR );
+    }
+
+    void testPsnrBc4()
+    {
+        const double MIN_PSNR[] = { 50, 28, 45, 44 };
+        sCheckPsnr( GN::gfx::ColorFormat::DXT5A_UNORM, 1, MIN_PSNR );
+    }
+
+    void testPsnrBc5()
+    {
+        const double MIN_PSNR[] = { 50, 28, 47, 46 };
+        sCheckPsnr( GN::gfx::ColorFormat::DXN_UNORM, 2, MIN_PSNR );
+    }
+
+    void testPsnrBc7()
+    {
+        const double MIN_PSNR[] = { 40, 14, 32, 38 };
+        sCheckPsnr( GN::gfx::ColorFormat::BC7_UNORM, 4, MIN_PSNR );
+    }
+
+    void testSnorm()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // signed gradient through zero
+        std::vector<uint8> ref( 64 * 64 * 4 );
+        for( uint32 y = 0; y < 64; ++y )
+        for( uint32 x = 0; x < 64; ++x )
+        {
+            uint8 * c = &ref[( y * 64 + x ) * 4];
+            c[0] = (uint8)(sint8)( (sint32)x * 4 - 126 );
+            c[1] = (uint8)(sint8)( 126 - (sint32)y * 4 );
+            c[2] = 0;
+            c[3] = 127;
+        }
+        std::vector<uint8> out = sRoundTrip( ColorFormat::DXN_SNORM, ref, Quality::NORMAL );
+        TS_ASSERT_LESS_THAN( 45.0, sPsnr( ref, out, 4 ) );
+    }
+
+    void testConvertImage()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // odd size, with mipmaps down to 1x1
+        std::vector<uint8> ref = sReference( GRADIENT );
+        ImageDesc desc( ImagePlaneDesc::make( ColorFormat::RGBA8, 37, 19 ), 1, 0 );
+        RawImage src( std::move( desc ) );
+        for( const ImagePlaneDesc & p : src.desc().planes )
+            for( uint32 y = 0; y < p.height; ++y )
+                memcpy( src.data() + p.pixel( 0, y, 0 ), &ref[y * 64 * 4], p.width * 4 );
+
+        RawImage bc7, bc7p, back;
+        TS_ASSERT( convertImage( src.desc(), src.data(), ColorFormat::BC7_UNORM, bc7 ) );
+        TS_ASSERT_EQUALS( ColorFormat::BC7_UNORM, bc7.desc().format() );
+        TS_ASSERT_EQUALS( src.desc().levels, bc7.desc().levels );
+        TS_ASSERT_EQUALS( 10u * 5u * 16u, bc7.desc().plane().slice );
+
+        // jobs compress the same blocks
+        JobSystem js( 3 );
+        TS_ASSERT( convertImage( src.desc(), src.data(), ColorFormat::BC7_UNORM, bc7p, js ) );
+        TS_ASSERT_EQUALS( bc7.size(), bc7p.size() );
+        TS_ASSERT_SAME_DATA( bc7.data(), bc7p.data(), (uint32)bc7.size() );
+
+        // and back, to a different layout
+        TS_ASSERT( convertImage( bc7.desc(), bc7.data(), ColorFormat::BGRA8, back, js ) );
+        TS_ASSERT_EQUALS( 37u, back.desc().plane().width );
+        for( const ImagePlaneDesc & p : back.desc().planes )
+        {
+            const ImagePlaneDesc & sp = src.desc().plane( 0, (uint32)( &p - back.desc().planes.rawptr() ) );
+            for( uint32 y = 0; y < p.height; ++y )
+            for( uint32 x = 0; x < p.width; ++x )
+            {
+                const uint8 * a = src.data() + sp.pixel( x, y, 0 );
+                const uint8 * b = back.data() + p.pixel( x, y, 0 );
+                TS_ASSERT_LESS_EQUALS( abs( a[0] - b[2] ), 12 );
+                TS_ASSERT_LESS_EQUALS( abs( a[1] - b[1] ), 12 );
+                TS_ASSERT_LESS_EQUALS( abs( a[2] - b[0] ), 12 );
+                TS_ASSERT_EQUALS( a[3], b[3] );
+            }
+        }
+
+        // compressed to compressed
+        RawImage bc1;
+        TS_ASSERT( convertImage( bc7.desc(), bc7.data(), ColorFormat::DXT1_UNORM, bc1, Quality::FAST ) );
+        TS_ASSERT_EQUALS( 10u * 5u * 8u, bc1.desc().plane().slice );
+        TS_ASSERT( !convertImage( src.desc(), src.data(), ColorFormat( ColorFormat::LAYOUT_CTX1, ColorFormat::SIGN_UNORM, ColorFormat::SIGN_UNORM, ColorFormat::SWIZZLE_RGBA ), bc1 ) );
+    }
+};
@@ -0,0 +1,149 @@
+#include "../testCommon.h"
+#include <vector>
+
+class BoundingVolumeTest : public CxxTest::TestSuite
+{
+    // points inside of a rotated 10x2x1 box, centered at (3,-2,5).
+    static std::vector<GN::Vector4f> sRotatedBoxPoints( size_t count, GN::Vector3f axes[3] )
+    {
+        using namespace GN;
+        axes[0].set( 1, 1, 0 ); axes[0].normalize();
+        axes[1].set( -1, 1, 1 ); axes[1].normalize();
+        axes[2] = Vector3f::sCross( axes[0], axes[1] );
+
+        uint64 seed = 7;
+        std::vector<Vector4f> points( count );
+        for( auto & p : points )
+        {
+            Vector3f v = Vector3f( 3, -2, 5 )
+                       + axes[0] * ( nextRandomFloat( seed ) * 5.0f )
+                       + axes[1] * ( nextRandomFloat( seed ) * 1.0f )
+                       + axes[2] * ( nextRandomFloat( seed ) * 0.5f );
+            p.set( v.x, v.y, v.z, 1.0f );
+        }
+        return points;
+    }
+
+    static bool sSphereContains( const GN::Spheref & s, const GN::Vector3f & p, float tolerance )
+    {
+        return GN::Vector3f::sDistance( s.center, p ) <= s.radius * ( 1 + tolerance );
+    }
+
+    template<int K>
+    static void sCheckDop( const std::vector<GN::Vector4f> & points )
+    {
+        using namespace GN;
+        Dop<K> dop;
+        calculateDop( dop, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+        for( const Vector4f & p : points ) TS_ASSERT( dop.contains( Vector3f( p.x, p.y, p.z ) ) );
+        for( size_t i = 0; i < Dop<K>::NUM_AXES; ++i ) TS_ASSERT( dop.minimum[i] <= dop.maximum[i] );
+        TS_ASSERT( !dop.contains( Vector3f( 100, 100, 100 ) ) );
+        TS_ASSERT( dop.overlaps( dop ) );
+    }
+
+public:
+
+    void testBoundingBox()
+    {
+        using namespace GN;
+
+        GN::Vector3f axes[3];
+        std::vector<Vector4f> points = sRotatedBoxPoints( 1001, axes );
+
+        Vector3f vmin( points[0].x, points[0].y, points[0].z ), vmax = vmin;
+        for( const Vector4f & p : points )
+        {
+            vmin.set( math::getmin( vmin.x, p.x ), math::getmin( vmin.y, p.y ), math::getmin( vmin.z, p.z ) );
+            vmax.set( math::getmax( vmax.x, p.x ), math::getmax( vmax.y, p.y ), math::getmax( vmax.z, p.z ) );
+        }
+
+        // SIMD path (Vector3 stream) and scalar path (separated streams) should agree.
+        Boxf b1, b2;
+        calculateBoundingBox( b1, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+        calculateBoundingBox( b2, &points[0].x, sizeof(Vector4f), &points[0].y, sizeof(Vector4f), &points[0].z, sizeof(Vector4f), points.size() );
+        TS_ASSERT_EQUALS( b1.x, vmin.x ); TS_ASSERT_EQUALS( b1.w, vmax.x - vmin.x );
+        TS_ASSERT_EQUALS( b1.y, vmin.y ); TS_ASSERT_EQUALS( b1.h, vmax.y - vmin.y );
+        TS_ASSERT_EQUALS( b1.z, vmin.z ); TS_ASSERT_EQUALS( b1.d, vmax.z - vmin.z );
+        TS_ASSERT( b1 == b2 );
+    }
+
+    void testBoundingSphere()
+    {
+        using namespace GN;
+
+        GN::Vector3f axes[3];
+        std::vector<Vector4f> points = sRotatedBoxPoints( 1003, axes );
+        const Vector3f * p = (const Vector3f*)points.data();
+
+        Spheref ritter, minimal, fast;
+        calculateBoundingSphereRitter( ritter, p, sizeof(Vector4f), points.size() );
+        calculateMinimalBoundingSphere( minimal, p, sizeof(Vector4f), points.size() );
+        calculateBoundingSphere( fast, p, sizeof(Vector4f), points.size() );
+
+        for( const Vector4f & v : points )
+        {
+            Vector3f q( v.x, v.y, v.z );
+            TS_ASSERT( sSphereContains( ritter, q, 1e-5f ) );
+            TS_ASSERT( sSphereContains( minimal, q, 1e-5f ) );
+            TS_ASSERT( sSphereContains( fast, q, 1e-5f ) );
+        }
+        TS_ASSERT( minimal.radius <= ritter.radius * 1.0001f );
+        TS_ASSERT( ritter.radius <= fast.radius * 1.0001f );
+
+        // minimal sphere of a diameter is centered at its middle point
+        Vector3f two[] = { Vector3f( -1, 0, 0 ), Vector3f( 3, 0, 0 ), Vector3f( 1, 1, 0 ) };
+        calculateMinimalBoundingSphere( minimal, two, sizeof(Vector3f), 3 );
+        TS_ASSERT_DELTA( minimal.center.x, 1.0f, 1e-4f );
+        TS_ASSERT_DELTA( minimal.center.y, 0.0f, 1e-4f );
+        TS_ASSERT_DELTA( minimal.radius, 2.0f, 1e-3f );
+
+        // minimal sphere of a regular tetrahedron is its circumsphere.
+        Vector3f tetra[] = { Vector3f( 1, 1, 1 ), Vector3f( 1, -1, -1 ), Vector3f( -1, 1, -1 ), Vector3f( -1, -1, 1 ), Vector3f( 0.1f, 0.2f, 0.3f ) };
+        calculateMinimalBoundingSphere( minimal, tetra, sizeof(Vector3f), 5 );
+        TS_ASSERT_DELTA( minimal.center.length(), 0.0f, 1e-4f );
+        TS_ASSERT_DELTA( minimal.radius, sqrtf( 3.0f ), 1e-3f );
+    }
+
+    void testOrientedBox()
+    {
+        using namespace GN;
+
+        GN::Vector3f axes[3];
+        std::vector<Vector4f> points = sRotatedBoxPoints( 10000, axes );
+
+        OrientedBoxf obb;
+        calculateOrientedBoundingBox( obb, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+
+        for( const Vector4f & v : points ) TS_ASSERT( obb.contains( Vector3f( v.x, v.y, v.z ) * 0.99999f + obb.center * 0.00001f ) );
+
+        // the box is found along the generating axes, so it is much tighter than the AABB.
+        Boxf aabb;
+        calculateBoundingBox( aabb, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+        TS_ASSERT( obb.volume() < aabb.w * aabb.h * aabb.d * 0.5f );
+        TS_ASSERT_DELTA( obb.volume(), 10.0f * 2.0f * 1.0f, 1.0f ); // PCA axes are not exact
+        TS_ASSERT_DELTA( fabs( Vector3f::sDot( obb.axes[0], axes[0] ) ), 1.0f, 1e-2f );
+        TS_ASSERT_DELTA( obb.center.x, 3.0f, 0.05f );
+        TS_ASSERT_DELTA( obb.center.y, -2.0f, 0.05f );
+        TS_ASSERT_DELTA( obb.center.z, 5.0f, 0.05f );
+    }
+
+    void testDop()
+    {
+        using namespace GN;
+
+        GN::Vector3f axes[3];
+        std::vector<Vector4f> points = sRotatedBoxPoints( 1002, axes );
+        sCheckDop<8>( points );
+        sCheckDop<14>( points );
+        sCheckDop<18>( points );
+        sCheckDop<26>( points );
+
+        // 14-DOP includes the AABB slabs.
+        Dop14 dop;
+        Boxf aabb;
+        calculateDop( dop, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+        calculateBoundingBox( aabb, (const Vector3f*)points.data(), sizeof(Vector4f), points.size() );
+        TS_ASSERT_EQUALS( dop.minimum[0], aabb.x );
+        TS_ASSERT_DELTA( dop.maximum[1], aabb.y + aabb.h, 1e-5f );
+    }
+};
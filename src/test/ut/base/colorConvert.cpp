@@ -0,0 +1,294 @@
+#include "../testCommon.h"
+#include "garnet/GNgfx.h"
+#include <vector>
+
+class ColorConvertTest : public CxxTest::TestSuite
+{
+    static void sSetBits( uint8 * pixel, uint32 shift, uint32 bits, uint64 value )
+    {
+        for( uint32 i = 0; i < bits; ++i )
+        {
+            uint32 b = shift + i;
+            if( ( value >> i ) & 1 ) pixel[b / 8] |= (uint8)( 1 << ( b % 8 ) );
+            else pixel[b / 8] &= (uint8)~( 1 << ( b % 8 ) );
+        }
+    }
+
+    // Is the value of channel k preserved by the round trip through float RGBA?
+    static bool sCanRoundTrip( GN::gfx::ColorFormat f, uint32 k, uint32 bits, uint64 v )
+    {
+        using namespace GN::gfx;
+        uint32 sign = 3 == k ? f.sign3 : f.sign012;
+        if( ColorFormat::SIGN_SNORM == sign && v == ( (uint64)1 << ( bits - 1 ) ) ) return false; // -max-1 goes to -max
+        if( ColorFormat::SIGN_FLOAT == sign && 16 == bits && 0x7C00 == ( v & 0x7C00 ) && ( v & 0x3FF ) ) return false; // NaN
+        return true;
+    }
+
+    // Convert every value of every channel to float RGBA and back, with other channels
+    // set to a middle value. Channels not read by the swizzle are always 1.
+    static void sCheckRoundTrip( GN::gfx::ColorFormat f )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        TS_ASSERT( isConvertibleColorFormat( f ) );
+        const ColorLayoutDesc & ld = f.layoutDesc();
+        const uint32 bytes = ld.bits / 8;
+        const uint32 swizzles[4] = { f.swizzle0, f.swizzle1, f.swizzle2, f.swizzle3 };
+
+        uint8 base[16] = {};
+        for( uint32 k = 0; k < ld.numChannels; ++k )
+        {
+            bool used = swizzles[0] == k || swizzles[1] == k || swizzles[2] == k || swizzles[3] == k;
+            uint32 bits = ld.channels[k].bits;
+            uint32 sign = 3 == k ? f.sign3 : f.sign012;
+            uint64 one = ColorFormat::SIGN_FLOAT == sign ? ( 16 == bits ? 0x3C00 : 0x3F800000 )
+                       : ColorFormat::SIGN_UINT == sign || ColorFormat::SIGN_SINT == sign ? 1
+                       : ColorFormat::SIGN_SNORM == sign ? ( (uint64)1 << ( bits - 1 ) ) - 1
+                       : ( (uint64)1 << bits ) - 1;
+            sSetBits( base, ld.channels[k].shift, bits, used ? one / 2 : one );
+        }
+
+        for( uint32 k = 0; k < ld.numChannels; ++k )
+        {
+            if( swizzles[0] != k && swizzles[1] != k && swizzles[2] != k && swizzles[3] != k ) continue;
+
+            uint32 bits = ld.channels[k].bits;
+            uint64 count = bits <= 16 ? ( (uint64)1 << bits ) : 0x10000;
+
+            std::vector<uint8> src;
+            uint64 seed = k;
+            for( uint64 i = 0; i < count; ++i )
+            {
+                // 32-bit integers are exact in float up to 2^24
+                uint64 v = bits <= 16 ? i : ( nextRandom32( seed ) & 0xFFFFFF );
+                if( !sCanRoundTrip( f, k, bits, v ) ) continue;
+                uint8 pixel[16];
+                memcpy( pixel, base, 16 );
+                sSetBits( pixel, ld.channels[k].shift, bits, v );
+                src.insert( src.end(), pixel, pixel + bytes );
+            }
+
+            size_t n = src.size() / bytes;
+            std::vector<Vector4f> rgba( n );
+            std::vector<uint8> dst( src.size() );
+            TS_ASSERT( convertPixels( f, src.data(), ColorFormat::RGBA_32_32_32_32_FLOAT, rgba.data(), n ) );
+            TS_ASSERT( convertPixels( ColorFormat::RGBA_32_32_32_32_FLOAT, rgba.data(), f, dst.data(), n ) );
+            if( src != dst )
+            {
+                StrA msg;
+                msg.format( "%s: channel %u does not round trip.", f.toString().rawptr(), k );
+                TS_FAIL( msg.rawptr() );
+            }
+        }
+    }
+
+public:
+
+    void testConvertible()
+    {
+        using namespace GN::gfx;
+        TS_ASSERT( isConvertibleColorFormat( ColorFormat::RGBA8 ) );
+        TS_ASSERT( isConvertibleColorFormat( ColorFormat::RGBA_10_10_10_SNORM_2_UNORM ) );
+        TS_ASSERT( isConvertibleColorFormat( ColorFormat::HALF4 ) );
+        TS_ASSERT( !isConvertibleColorFormat( ColorFormat::DXT1_UNORM ) );
+        TS_ASSERT( !isConvertibleColorFormat( ColorFormat::GRGB_UNORM ) );
+        TS_ASSERT( !isConvertibleColorFormat( ColorFormat::R_24_FLOAT ) );
+        TS_ASSERT( !isConvertibleColorFormat( ColorFormat::UNKNOWN ) );
+
+        uint32 pixel = 0;
+        TS_ASSERT( !convertPixels( ColorFormat::DXT1_UNORM, &pixel, ColorFormat::RGBA8, &pixel, 1 ) );
+    }
+
+    void testRoundTrip()
+    {
+        using namespace GN::gfx;
+        const ColorFormat::Alias formats[] =
+        {
+            ColorFormat::R_8_UNORM, ColorFormat::L_8_UNORM, ColorFormat::A_8_UNORM,
+            ColorFormat::BGRA_4_4_4_4_UNORM, ColorFormat::BGRX_4_4_4_4_UNORM, ColorFormat::BGR_5_6_5_UNORM,
+            ColorFormat::BGRA_5_5_5_1_UNORM, ColorFormat::RG_8_8_UNORM, ColorFormat::RG_8_8_SNORM,
+            ColorFormat::LA_8_8_UNORM, ColorFormat::R_16_UNORM, ColorFormat::R_16_SNORM,
+            ColorFormat::R_16_UINT, ColorFormat::R_16_SINT, ColorFormat::R_16_FLOAT,
+            ColorFormat::RGB_8_8_8_UNORM, ColorFormat::BGR_8_8_8_UNORM,
+            ColorFormat::RGBA_8_8_8_8_UNORM, ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, ColorFormat::RGBA_8_8_8_8_SNORM,
+            ColorFormat::RGBX_8_8_8_8_UNORM, ColorFormat::BGRA_8_8_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM,
+            ColorFormat::RGBA_10_10_10_2_UNORM, ColorFormat::RGBA_10_10_10_2_UINT, ColorFormat::RGBA_10_10_10_SNORM_2_UNORM,
+            ColorFormat::RG_16_16_UNORM, ColorFormat::RG_16_16_SNORM, ColorFormat::RG_16_16_UINT,
+            ColorFormat::RG_16_16_SINT, ColorFormat::RG_16_16_FLOAT, ColorFormat::LA_16_16_UNORM,
+            ColorFormat::R_32_UINT, ColorFormat::R_32_SINT, ColorFormat::R_32_FLOAT,
+            ColorFormat::RGBA_16_16_16_16_UNORM, ColorFormat::RGBA_16_16_16_16_SNORM, ColorFormat::RGBA_16_16_16_16_UINT,
+            ColorFormat::RGBA_16_16_16_16_SINT, ColorFormat::RGBA_16_16_16_16_FLOAT, ColorFormat::RGBX_16_16_16_16_UNORM,
+            ColorFormat::RG_32_32_FLOAT, ColorFormat::RGB_32_32_32_UINT, ColorFormat::RGBA_32_32_32_32_SINT,
+            ColorFormat::RGBA_32_32_32_32_FLOAT,
+        };
+        for( size_t i = 0; i < GN_ARRAY_COUNT( formats ); ++i ) sCheckRoundTrip( formats[i] );
+    }
+
+    void testKnownValues()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        Vector4f c;
+        uint16 rgb565 = 0xF800;
+        convertPixels( ColorFormat::BGR_5_6_5_UNORM, &rgb565, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT( Vector4f( 1, 0, 0, 1 ) == c );
+
+        uint16 argb4444 = 0x80F0; // a = 8, g = 15
+        convertPixels( ColorFormat::BGRA_4_4_4_4_UNORM, &argb4444, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT_EQUALS( c.x, 0.0f );
+        TS_ASSERT_EQUALS( c.y, 1.0f );
+        TS_ASSERT_DELTA( c.w, 8.0f / 15.0f, 1e-6f );
+
+        uint32 snorm = 0x7F817F80;
+        convertPixels( ColorFormat::RGBA_8_8_8_8_SNORM, &snorm, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT( Vector4f( -1, 1, -1, 1 ) == c );
+
+        uint16 half[4] = { 0x3C00, 0xC000, 0x3800, 0x0001 };
+        convertPixels( ColorFormat::HALF4, half, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT( Vector4f( 1, -2, 0.5f, 1.0f / 16777216.0f ) == c );
+        c.set( 65504.0f, 1e6f, -0.0f, 1.0f / 33554432.0f );
+        convertPixels( ColorFormat::FLOAT4, &c, ColorFormat::HALF4, half, 1 );
+        TS_ASSERT_EQUALS( half[0], 0x7BFF );
+        TS_ASSERT_EQUALS( half[1], 0x7C00 );
+        TS_ASSERT_EQUALS( half[2], 0x8000 );
+        TS_ASSERT_EQUALS( half[3], 0x0000 ); // tie rounds to even
+
+        uint32 a2 = 0xC00003FF;
+        convertPixels( ColorFormat::RGBA_10_10_10_2_UNORM, &a2, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT( Vector4f( 1, 0, 0, 1 ) == c );
+
+        uint8 l8 = 51;
+        convertPixels( ColorFormat::L_8_UNORM, &l8, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT_DELTA( c.x, 0.2f, 1e-6f );
+        TS_ASSERT( c.x == c.y && c.x == c.z && 1.0f == c.w );
+        convertPixels( ColorFormat::A_8_UNORM, &l8, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT( 1.0f == c.x && 1.0f == c.y && 1.0f == c.z );
+        TS_ASSERT_DELTA( c.w, 0.2f, 1e-6f );
+
+        // sRGB is decoded to linear, alpha is not.
+        uint32 srgb = GN_RGBA8( 188, 0, 255, 188 );
+        convertPixels( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, &srgb, ColorFormat::FLOAT4, &c, 1 );
+        TS_ASSERT_DELTA( c.x, 0.5029f, 1e-4f );
+        TS_ASSERT_EQUALS( c.z, 1.0f );
+        TS_ASSERT_DELTA( c.w, 188.0f / 255.0f, 1e-6f );
+        c.set( 0.5f, -1.0f, 2.0f, 0.5f );
+        convertPixels( ColorFormat::FLOAT4, &c, ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, &srgb, 1 );
+        TS_ASSERT_EQUALS( srgb, GN_RGBA8( 188, 0, 255, 128 ) );
+
+        // out of range values are clamped.
+        c.set( 70000.0f, -5.0f, 0.4f, 1.0f );
+        uint16 us[4];
+        convertPixels( ColorFormat::FLOAT4, &c, ColorFormat::USHORT4, us, 1 );
+        TS_ASSERT( 65535 == us[0] && 0 == us[1] && 0 == us[2] && 1 == us[3] );
+
+        // X is written as 1.
+        c.set( 1.0f, 0.0f, 0.0f, 0.0f );
+        uint32 bgrx;
+        convertPixels( ColorFormat::FLOAT4, &c, ColorFormat::BGRX_8_8_8_8_UNORM, &bgrx, 1 );
+        TS_ASSERT_EQUALS( bgrx, GN_BGRA8( 255, 0, 0, 255 ) );
+    }
+
+    void testFastPaths()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // odd count, to cover the scalar tail after SIMD loops.
+        const size_t N = 1027;
+        uint64 seed = 1;
+        std::vector<uint32> rgba( N );
+        for( auto & p : rgba ) p = nextRandom32( seed );
+        std::vector<Vector4f> f( N );
+        for( auto & v : f ) v.set( (float)( nextRandom32( seed ) % 1000 ) / 800.0f - 0.1f, (float)( nextRandom32( seed ) % 256 ) / 255.0f, 0.5f / 255.0f, 2.0f / 255.0f );
+
+        const ColorFormat::Alias formats[] = {
+            ColorFormat::RGBA_8_8_8_8_UNORM, ColorFormat::BGRA_8_8_8_8_UNORM,
+            ColorFormat::RGBX_8_8_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM };
+        std::vector<uint32> direct( N ), indirect( N ), encoded( N );
+        std::vector<Vector4f> decoded( N );
+        for( auto from : formats )
+        {
+            // decode, and compare with the scalar formula.
+            TS_ASSERT( convertPixels( from, rgba.data(), ColorFormat::FLOAT4, decoded.data(), N ) );
+            ColorFormat cf( from );
+            for( size_t i = 0; i < N; ++i )
+            {
+                uint32 p = rgba[i];
+                uint32 r = cf.swizzle0 == ColorFormat::SWIZZLE_R ? p & 0xFF : ( p >> 16 ) & 0xFF;
+                float a = cf.swizzle3 == ColorFormat::SWIZZLE_1 ? 1.0f : (float)( p >> 24 ) * ( 1.0f / 255.0f );
+                TS_ASSERT_EQUALS( decoded[i].x, (float)r * ( 1.0f / 255.0f ) );
+                TS_ASSERT_EQUALS( decoded[i].w, a );
+            }
+
+            // encode, and compare with the scalar formula.
+            TS_ASSERT( convertPixels( ColorFormat::FLOAT4, f.data(), from, encoded.data(), N ) );
+            for( size_t i = 0; i < N; ++i )
+            {
+                uint32 r = (uint32)lrintf( math::clamp( f[i].x, 0.0f, 1.0f ) * 255.0f );
+                uint32 e = encoded[i];
+                TS_ASSERT_EQUALS( cf.swizzle0 == ColorFormat::SWIZZLE_R ? e & 0xFF : ( e >> 16 ) & 0xFF, r );
+                TS_ASSERT_EQUALS( ( e >> 8 ) & 0xFF, (uint32)lrintf( f[i].y * 255.0f ) );
+                TS_ASSERT_EQUALS( e >> 24, cf.swizzle3 == ColorFormat::SWIZZLE_1 ? 255u : 2u );
+            }
+
+            // direct conversions agree with going through float.
+            for( auto to : formats )
+            {
+                if( from == to ) continue; // copied as is, including X
+                TS_ASSERT( convertPixels( from, rgba.data(), to, direct.data(), N ) );
+                convertPixels( from, rgba.data(), ColorFormat::FLOAT4, decoded.data(), N );
+                convertPixels( ColorFormat::FLOAT4, decoded.data(), to, indirect.data(), N );
+                TS_ASSERT( direct == indirect );
+            }
+        }
+
+        // 24-bit to 32-bit
+        uint8 bgr[] = { 1, 2, 3, 4, 5, 6 };
+        uint32 out[2];
+        convertPixels( ColorFormat::BGR_8_8_8_UNORM, bgr, ColorFormat::RGBA8, out, 2 );
+        TS_ASSERT_EQUALS( out[0], GN_RGBA8( 3, 2, 1, 255 ) );
+        TS_ASSERT_EQUALS( out[1], GN_RGBA8( 6, 5, 4, 255 ) );
+
+        // in place
+        std::vector<uint32> inplace = rgba;
+        convertPixels( ColorFormat::BGRA8, rgba.data(), ColorFormat::RGB_8_8_8_UNORM, direct.data(), N );
+        convertPixels( ColorFormat::BGRA8, inplace.data(), ColorFormat::RGB_8_8_8_UNORM, inplace.data(), N );
+        TS_ASSERT_SAME_DATA( direct.data(), inplace.data(), (unsigned int)( N * 3 ) );
+    }
+
+    void testConvertImage()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        ImageDesc desc( ImagePlaneDesc::make( ColorFormat::RGB_8_8_8_UNORM, 37, 21, 1 ), 2, 0 );
+        RawImage src( std::move( desc ) );
+        uint64 seed = 5;
+        for( size_t i = 0; i < src.size(); ++i ) src.data()[i] = (uint8)nextRandom32( seed );
+
+        RawImage serial, parallel, back;
+        TS_ASSERT( convertImage( src.desc(), src.data(), ColorFormat::HALF4, serial ) );
+        JobSystem js( 3 );
+        TS_ASSERT( convertImage( src.desc(), src.data(), ColorFormat::HALF4, parallel, js ) );
+        TS_ASSERT_EQUALS( serial.desc().levels, src.desc().levels );
+        TS_ASSERT_EQUALS( serial.desc().layers, 2u );
+        TS_ASSERT_EQUALS( serial.format( 1, 3 ), ColorFormat::HALF4 );
+        TS_ASSERT_EQUALS( serial.size(), parallel.size() );
+        TS_ASSERT_SAME_DATA( serial.data(), parallel.data(), serial.size() );
+
+        TS_ASSERT( convertImage( serial.desc(), serial.data(), ColorFormat::RGB_8_8_8_UNORM, back, js ) );
+        for( uint32 level = 0; level < src.desc().levels; ++level )
+        for( uint32 layer = 0; layer < src.desc().layers; ++layer )
+        for( uint32 y = 0; y < src.height( layer, level ); ++y )
+        {
+            TS_ASSERT_SAME_DATA( src.pixel( layer, level, 0, y ), back.pixel( layer, level, 0, y ), src.width( layer, level ) * 3 );
+        }
+
+        // unsupported format leaves the destination untouched.
+        ColorFormat ctx1( ColorFormat::LAYOUT_CTX1, ColorFormat::SIGN_UNORM, ColorFormat::SIGN_UNORM, ColorFormat::SWIZZLE_RGBA );
+        TS_ASSERT( !convertImage( src.desc(), src.data(), ctx1, back ) );
+        TS_ASSERT_EQUALS( back.format(), ColorFormat::RGB_8_8_8_UNORM );
+    }
+};
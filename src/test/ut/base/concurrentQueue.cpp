@@ -0,0 +1,158 @@
+#include "../testCommon.h"
+#include <thread>
+#include <vector>
+
+class ConcurrentQueueTest : public CxxTest::TestSuite
+{
+    // item: producer index in high bits, per-producer sequence number in low bits.
+    static uint64 sMakeItem( uint64 producer, uint64 seq ) { return ( producer << 32 ) | seq; }
+
+    ///
+    /// Run producers and consumers on a queue, then check that every item is popped exactly
+    /// once, and each consumer sees items of each producer in the order they were pushed.
+    ///
+    template<typename QUEUE>
+    static void sStress( QUEUE & q, int numProducers, int numConsumers, uint32 itemsPerProducer )
+    {
+        using namespace GN;
+
+        const uint64 total = (uint64)numProducers * itemsPerProducer;
+        std::atomic<uint64> popped( 0 );
+        std::atomic<int> orderErrors( 0 );
+        std::vector<std::vector<uint8>> seen( numProducers, std::vector<uint8>( itemsPerProducer, 0 ) );
+        std::vector<std::thread> threads;
+
+        for( int p = 0; p < numProducers; ++p )
+        {
+            threads.emplace_back( [&, p]{
+                for( uint32 i = 0; i < itemsPerProducer; ++i )
+                {
+                    while( !q.tryPush( sMakeItem( p, i ) ) ) std::this_thread::yield();
+                }
+            } );
+        }
+
+        for( int c = 0; c < numConsumers; ++c )
+        {
+            threads.emplace_back( [&]{
+                std::vector<sint64> last( numProducers, -1 );
+                uint64 item;
+                while( popped.load() < total )
+                {
+                    if( !q.tryPop( item ) ) { std::this_thread::yield(); continue; }
+                    size_t p = (size_t)( item >> 32 );
+                    sint64 i = (sint64)( item & 0xFFFFFFFF );
+                    if( i <= last[p] ) ++orderErrors;
+                    last[p] = i;
+                    seen[p][(size_t)i]++; // each slot is written by one consumer only, if correct.
+                    ++popped;
+                }
+            } );
+        }
+
+        for( auto & t : threads ) t.join();
+
+        TS_ASSERT_EQUALS( popped.load(), total );
+        TS_ASSERT_EQUALS( orderErrors.load(), 0 );
+        size_t wrong = 0;
+        for( auto & v : seen ) for( uint8 s : v ) if( 1 != s ) ++wrong;
+        TS_ASSERT_EQUALS( wrong, 0u );
+        uint64 dummy;
+        TS_ASSERT( !q.tryPop( dummy ) );
+    }
+
+public:
+
+    void testSpscRingBuffer()
+    {
+        using namespace GN;
+
+        SpscRingBuffer<int> q( 3 );
+        TS_ASSERT_EQUALS( q.capacity(), 4u );
+        for( int i = 0; i < 4; ++i ) TS_ASSERT( q.tryPush( i ) );
+        TS_ASSERT( !q.tryPush( 4 ) );
+        int v;
+        TS_ASSERT( q.tryPop( v ) ); TS_ASSERT_EQUALS( v, 0 );
+        TS_ASSERT( q.tryPush( 4 ) );
+        for( int i = 1; i < 5; ++i ) { TS_ASSERT( q.tryPop( v ) ); TS_ASSERT_EQUALS( v, i ); }
+        TS_ASSERT( !q.tryPop( v ) );
+
+        SpscRingBuffer<uint64> q2( 64 );
+        sStress( q2, 1, 1, 200000 );
+    }
+
+    void testMpmcRingBuffer()
+    {
+        using namespace GN;
+
+        MpmcRingBuffer<StrA> q( 2 );
+        TS_ASSERT( q.tryPush( StrA( "a" ) ) );
+        TS_ASSERT( q.tryPush( StrA( "b" ) ) );
+        TS_ASSERT( !q.tryPush( StrA( "c" ) ) );
+        StrA s;
+        TS_ASSERT( q.tryPop( s ) ); TS_ASSERT_EQUALS( s, "a" );
+        TS_ASSERT( q.tryPush( StrA( "c" ) ) );
+        // remaining items are destroyed with the queue.
+
+        MpmcRingBuffer<uint64> q2( 128 );
+        sStress( q2, 4, 4, 50000 );
+        sStress( q2, 4, 1, 50000 ); // as MPSC
+    }
+
+    void testSpscQueue()
+    {
+        using namespace GN;
+
+        SpscQueue<StrA> q;
+        for( int i = 0; i < 100; ++i ) q.tryPush( str::format( "%d", i ) );
+        StrA s;
+        for( int i = 0; i < 50; ++i ) { TS_ASSERT( q.tryPop( s ) ); TS_ASSERT_EQUALS( s, str::format( "%d", i ) ); }
+
+        SpscQueue<uint64> q2;
+        sStress( q2, 1, 1, 200000 );
+    }
+
+    void testMpscQueue()
+    {
+        using namespace GN;
+
+        MpscQueue<StrA> q;
+        q.tryPush( StrA( "x" ) );
+        q.tryPush( StrA( "y" ) );
+        StrA s;
+        TS_ASSERT( q.tryPop( s ) ); TS_ASSERT_EQUALS( s, "x" );
+
+        MpscQueue<uint64> q2;
+        sStress( q2, 4, 1, 50000 );
+    }
+
+    void testBlockingQueue()
+    {
+        using namespace GN;
+
+        BlockingQueue<MpmcRingBuffer<int>> q( 4 );
+        int v;
+        TS_ASSERT( !q.tryPop( v ) );
+        TS_ASSERT( WaitResult::TIMEDOUT == q.pop( v, 1000000 ) );
+        for( int i = 0; i < 4; ++i ) TS_ASSERT( q.tryPush( i ) );
+        TS_ASSERT( !q.tryPush( 4 ) );
+
+        // producers block on the full queue until the consumer catches up.
+        const int N = 20000;
+        std::atomic<sint64> sum( 0 );
+        std::thread consumer( [&]{
+            int x;
+            for( int i = 0; i < N + 4; ++i ) { q.pop( x ); sum += x; }
+        } );
+        std::thread producer( [&]{ for( int i = 0; i < N; ++i ) q.push( 1 ); } );
+        producer.join();
+        consumer.join();
+        TS_ASSERT_EQUALS( sum.load(), (sint64)( N + 0 + 1 + 2 + 3 ) );
+
+        BlockingQueue<MpscQueue<int>> q2;
+        std::thread waiter( [&]{ int x = 0; TS_ASSERT( WaitResult::COMPLETED == q2.pop( x ) ); TS_ASSERT_EQUALS( x, 42 ); } );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        q2.push( 42 );
+        waiter.join();
+    }
+};
@@ -0,0 +1,154 @@
+#include "../testCommon.h"
+#include <vector>
+
+class FrustumTest : public CxxTest::TestSuite
+{
+    static GN::Frustum sFrustum()
+    {
+        using namespace GN;
+        Matrix44f proj, view;
+        proj.perspectiveD3DRh( 1.0f, 1.5f, 1.0f, 50.0f );
+        view.lookAtRh( Vector3f( 0, 0, 10 ), Vector3f( 0, 0, 0 ), Vector3f( 0, 1, 0 ) );
+        Frustum f;
+        f.fromMatrix( proj * view, true );
+        return f;
+    }
+
+    static std::vector<GN::Boxf> sBoxes( size_t count )
+    {
+        uint64 seed = 1;
+        std::vector<GN::Boxf> boxes( count );
+        for( auto & b : boxes )
+        {
+            b.set( nextRandomFloat( seed ) * 60, nextRandomFloat( seed ) * 60, nextRandomFloat( seed ) * 60,
+                   nextRandomFloat( seed ) * 2 + 2.1f, nextRandomFloat( seed ) * 2 + 2.1f, nextRandomFloat( seed ) * 2 + 2.1f );
+        }
+        return boxes;
+    }
+
+    static std::vector<uint32> sExpected( const GN::Frustum & f, const std::vector<GN::Boxf> & boxes )
+    {
+        std::vector<uint32> r;
+        for( size_t i = 0; i < boxes.size(); ++i ) if( f.testBox( boxes[i] ) ) r.push_back( (uint32)i );
+        return r;
+    }
+
+public:
+
+    void testFromMatrix()
+    {
+        using namespace GN;
+
+        Frustum f = sFrustum();
+
+        // camera at z = 10 looks at -z, near = 1, far = 50.
+        TS_ASSERT( f.testSphere( Spheref( 0, 0, 0, 0.1f ) ) );
+        TS_ASSERT( f.testSphere( Spheref( 0, 0, 8.5f, 0.1f ) ) );
+        TS_ASSERT( !f.testSphere( Spheref( 0, 0, 9.5f, 0.1f ) ) );   // before near plane
+        TS_ASSERT( !f.testSphere( Spheref( 0, 0, -41, 0.5f ) ) );    // behind far plane
+        TS_ASSERT( f.testSphere( Spheref( 0, 0, -41, 2 ) ) );        // intersects far plane
+        TS_ASSERT( !f.testSphere( Spheref( 0, 0, 20, 1 ) ) );        // behind camera
+        TS_ASSERT( !f.testSphere( Spheref( 20, 0, 0, 1 ) ) );
+        TS_ASSERT( !f.testSphere( Spheref( 0, -20, 0, 1 ) ) );
+
+        TS_ASSERT( f.testBox( Boxf( -1, -1, -1, 2, 2, 2 ) ) );
+        TS_ASSERT( !f.testBox( Boxf( 19, -1, -1, 2, 2, 2 ) ) );
+        TS_ASSERT( f.testBox( Boxf( -100, -1, -1, 200, 2, 2 ) ) );   // crosses the frustum
+
+        // normals are normalized, and point inside.
+        for( int i = 0; i < Frustum::NUM_PLANES; ++i )
+        {
+            TS_ASSERT_DELTA( f.planes[i].n.length(), 1.0f, 1e-5f );
+            TS_ASSERT( f.planes[i] * Vector3f( 0, 0, 0 ) > 0 );
+        }
+    }
+
+    void testCullBoxes()
+    {
+        using namespace GN;
+
+        Frustum f = sFrustum();
+        std::vector<Boxf> boxes = sBoxes( 1003 );
+        std::vector<uint32> expected = sExpected( f, boxes );
+        TS_ASSERT( expected.size() > 10 && expected.size() < 500 );
+
+        std::vector<uint32> visible( boxes.size() );
+        size_t n = cullBoxes( visible.data(), f, boxes.data(), boxes.size() );
+        TS_ASSERT_EQUALS( n, expected.size() );
+        visible.resize( n );
+        TS_ASSERT( expected == visible );
+
+        // plane cache should not change the result, neither in the first nor the second call.
+        std::vector<uint8> cache( boxes.size(), 0 );
+        for( int k = 0; k < 2; ++k )
+        {
+            visible.assign( boxes.size(), 0 );
+            n = cullBoxes( visible.data(), f, boxes.data(), boxes.size(), cache.data() );
+            visible.resize( n );
+            TS_ASSERT( expected == visible );
+        }
+        for( size_t i = 0; i < cache.size(); ++i ) TS_ASSERT( cache[i] < Frustum::NUM_PLANES );
+
+        // SoA
+        std::vector<float> c[3], e[3];
+        for( const Boxf & b : boxes )
+        {
+            c[0].push_back( b.x + b.w / 2 ); e[0].push_back( b.w / 2 );
+            c[1].push_back( b.y + b.h / 2 ); e[1].push_back( b.h / 2 );
+            c[2].push_back( b.z + b.d / 2 ); e[2].push_back( b.d / 2 );
+        }
+        visible.assign( boxes.size(), 0 );
+        n = cullBoxes( visible.data(), f, c[0].data(), c[1].data(), c[2].data(), e[0].data(), e[1].data(), e[2].data(), boxes.size() );
+        visible.resize( n );
+        TS_ASSERT( expected == visible );
+    }
+
+    void testCullSpheres()
+    {
+        using namespace GN;
+
+        Frustum f = sFrustum();
+        std::vector<Spheref> spheres;
+        for( const Boxf & b : sBoxes( 1001 ) ) spheres.push_back( Spheref( b.center(), b.w ) );
+
+        std::vector<uint32> expected;
+        for( size_t i = 0; i < spheres.size(); ++i ) if( f.testSphere( spheres[i] ) ) expected.push_back( (uint32)i );
+
+        std::vector<uint8> cache( spheres.size(), 0 );
+        for( int k = 0; k < 2; ++k )
+        {
+            std::vector<uint32> visible( spheres.size() );
+            size_t n = cullSpheres( visible.data(), f, spheres.data(), spheres.size(), cache.data() );
+            visible.resize( n );
+            TS_ASSERT( expected == visible );
+        }
+    }
+
+    void testParallel()
+    {
+        using namespace GN;
+
+        Frustum f = sFrustum();
+        std::vector<Boxf> boxes = sBoxes( 100 * 1000 + 3 );
+        std::vector<uint32> expected = sExpected( f, boxes );
+
+        JobSystem js( 3 );
+        std::vector<uint8> cache( boxes.size(), 0 );
+        for( int k = 0; k < 2; ++k )
+        {
+            std::vector<uint32> visible( boxes.size() );
+            size_t n = cullBoxes( js, visible.data(), f, boxes.data(), boxes.size(), cache.data() );
+            visible.resize( n );
+            TS_ASSERT( expected == visible );
+        }
+
+        std::vector<Spheref> spheres;
+        std::vector<uint32> expectedSpheres;
+        for( const Boxf & b : boxes ) spheres.push_back( Spheref( b.center(), b.w ) );
+        for( size_t i = 0; i < spheres.size(); ++i ) if( f.testSphere( spheres[i] ) ) expectedSpheres.push_back( (uint32)i );
+        std::vector<uint32> visible( spheres.size() );
+        size_t n = cullSpheres( js, visible.data(), f, spheres.data(), spheres.size() );
+        visible.resize( n );
+        TS_ASSERT( expectedSpheres == visible );
+    }
+};
@@ -1,10 +1,192 @@
 #include "../testCommon.h"
 #include "garnet/GNgfx.h"
 #include <png.h>
+#include <zlib.h>
+extern "C" {
+#include <jpeglib.h>
+}
 
 static uint8_t            gBuf[10000];
 static GN::MemFile<uint8> gFile(gBuf,10000,"a.png");
 
+// image with pseudo random pixels in all planes
+static GN::gfx::RawImage sMakeImage(GN::gfx::ImageDesc && desc) {
+    GN::gfx::RawImage image(std::move(desc));
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < image.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        image.data()[i] = (uint8_t)(seed >> 16);
+    }
+    return image;
+}
+
+// save to memory file, then load it back
+static GN::gfx::RawImage sSaveAndLoad(const GN::gfx::RawImage & image, GN::gfx::ImageFileFormat format, GN::VectorFile & file, GN::gfx::ColorFormat loadFormat = GN::gfx::ColorFormat::UNKNOWN) {
+    if (!image.save(file, format)) return {};
+    file.seek(0, GN::FileSeek::SET);
+    return GN::gfx::RawImage::load(file, loadFormat);
+}
+
+// compare pixels (not paddings) of one plane, of images of the same layout.
+static bool sSamePlane(const GN::gfx::RawImage & a, const GN::gfx::RawImage & b, size_t layer, size_t level) {
+    const auto & p = a.desc(layer, level);
+    const auto & ld = p.format.layoutDesc();
+    size_t rows = (p.height + ld.blockHeight - 1) / ld.blockHeight;
+    size_t rowBytes = (p.width + ld.blockWidth - 1) / ld.blockWidth * ld.blockBytes;
+    for (size_t z = 0; z < p.depth; ++z)
+    for (size_t r = 0; r < rows; ++r) {
+        size_t offset = p.offset + z * p.slice + r * p.pitch * ld.blockHeight;
+        if (0 != memcmp(a.data() + offset, b.data() + offset, rowBytes)) return false;
+    }
+    return true;
+}
+
+// write PNG with libpng, for formats that PNG writer of RawImage doesn't produce.
+static void sPngWrite(png_structp png, png_bytep data, png_size_t size) {
+    ((GN::VectorFile*)png_get_io_ptr(png))->write(data, size, nullptr);
+}
+
+static void sWritePNG(GN::VectorFile & file, uint32_t w, uint32_t h, int bitDepth, int colorType, bool interlace,
+                      const uint8_t * rows, size_t pitch, const png_color * palette = nullptr, int numPalette = 0,
+                      const uint8_t * trns = nullptr, int numTrns = 0) {
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    png_set_write_fn(png, &file, sPngWrite, nullptr);
+    png_set_IHDR(png, info, w, h, bitDepth, colorType, interlace ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    if (palette) png_set_PLTE(png, info, (png_colorp)palette, numPalette);
+    if (trns) png_set_tRNS(png, info, (png_bytep)trns, numTrns, nullptr);
+    png_write_info(png, info);
+    std::vector<png_bytep> rowPointers(h);
+    for (uint32_t y = 0; y < h; ++y) rowPointers[y] = (png_bytep)rows + y * pitch;
+    png_write_image(png, rowPointers.data());
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+}
+
+// write JPEG with libjpeg, into memory
+struct JpegDest : jpeg_destination_mgr {
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+};
+
+static std::vector<uint8_t> sWriteJPG(uint32_t w, uint32_t h, int components, const uint8_t * pixels) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error(&err);
+    jpeg_create_compress(&cinfo);
+    JpegDest dest;
+    dest.init_destination = [](j_compress_ptr c) {
+        auto d = (JpegDest*)c->dest;
+        d->next_output_byte = d->buffer;
+        d->free_in_buffer = sizeof(d->buffer);
+    };
+    dest.empty_output_buffer = [](j_compress_ptr c) -> JPEG_BOOL {
+        auto d = (JpegDest*)c->dest;
+        d->data.insert(d->data.end(), d->buffer, d->buffer + sizeof(d->buffer));
+        d->next_output_byte = d->buffer;
+        d->free_in_buffer = sizeof(d->buffer);
+        return JPEG_TRUE;
+    };
+    dest.term_destination = [](j_compress_ptr c) {
+        auto d = (JpegDest*)c->dest;
+        d->data.insert(d->data.end(), d->buffer, d->buffer + sizeof(d->buffer) - d->free_in_buffer);
+    };
+    cinfo.dest = &dest;
+    cinfo.image_width = w;
+    cinfo.image_height = h;
+    cinfo.input_components = components;
+    cinfo.in_color_space = 1 == components ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 95, JPEG_TRUE);
+    jpeg_start_compress(&cinfo, JPEG_TRUE);
+    while (cinfo.next_scanline < h) {
+        JSAMPROW row = (JSAMPROW)pixels + cinfo.next_scanline * w * components;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return dest.data;
+}
+
+// write EXR of the scanlines (all channels of each line in turn), with compression 0 (none), 2 (ZIPS) or 3 (ZIP).
+struct ExrChannel { const char * name; int type; };
+
+template<class T> static void sPut(std::vector<uint8_t> & out, T value) {
+    out.insert(out.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(T));
+}
+
+static void sPutAttribute(std::vector<uint8_t> & out, const char * name, const char * type, const std::vector<uint8_t> & value) {
+    out.insert(out.end(), name, name + strlen(name) + 1);
+    out.insert(out.end(), type, type + strlen(type) + 1);
+    sPut(out, (int32_t)value.size());
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static std::vector<uint8_t> sWriteEXR(uint32_t w, uint32_t h, const std::vector<ExrChannel> & channels, uint8_t compression, const std::vector<uint8_t> & lines) {
+    std::vector<uint8_t> out = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 }, value;
+    for (const auto & c : channels) {
+        value.insert(value.end(), c.name, c.name + strlen(c.name) + 1);
+        sPut(value, (int32_t)c.type);
+        sPut(value, (int32_t)0);
+        sPut(value, (int32_t)1);
+        sPut(value, (int32_t)1);
+    }
+    value.push_back(0);
+    sPutAttribute(out, "channels", "chlist", value);
+    sPutAttribute(out, "compression", "compression", { compression });
+    value.clear();
+    for (int32_t v : { 0, 0, (int32_t)w - 1, (int32_t)h - 1 }) sPut(value, v);
+    sPutAttribute(out, "dataWindow", "box2i", value);
+    sPutAttribute(out, "displayWindow", "box2i", value);
+    sPutAttribute(out, "lineOrder", "lineOrder", { 0 });
+    out.push_back(0);
+
+    size_t linesPerChunk = 3 == compression ? 16 : 1;
+    size_t lineBytes = lines.size() / h;
+    size_t chunks = (h + linesPerChunk - 1) / linesPerChunk;
+    size_t table = out.size();
+    out.resize(out.size() + chunks * 8);
+    for (size_t i = 0; i < chunks; ++i) {
+        uint64_t offset = out.size();
+        memcpy(&out[table + i * 8], &offset, 8);
+        size_t count = std::min<size_t>(linesPerChunk, h - i * linesPerChunk);
+        std::vector<uint8_t> data(lines.begin() + i * linesPerChunk * lineBytes, lines.begin() + (i * linesPerChunk + count) * lineBytes);
+        if (compression) {
+            // split even and odd bytes, then store differences, then deflate.
+            std::vector<uint8_t> split(data.size()), zipped(compressBound((uLong)data.size()));
+            size_t half = (data.size() + 1) / 2;
+            for (size_t k = 0; k < data.size(); ++k) split[(k & 1) ? half + k / 2 : k / 2] = data[k];
+            for (size_t k = split.size() - 1; k > 0; --k) split[k] = (uint8_t)(split[k] - split[k - 1] + 128);
+            uLongf zippedSize = (uLongf)zipped.size();
+            compress2(zipped.data(), &zippedSize, split.data(), (uLong)split.size(), 9);
+            zipped.resize(zippedSize);
+            data = zipped;
+        }
+        sPut(out, (int32_t)(i * linesPerChunk));
+        sPut(out, (int32_t)data.size());
+        out.insert(out.end(), data.begin(), data.end());
+    }
+    return out;
+}
+
+static bool sSameImage(const GN::gfx::RawImage & a, const GN::gfx::RawImage & b) {
+    if (a.empty() || b.empty()) return false;
+    const auto & da = a.desc();
+    const auto & db = b.desc();
+    if (da.layers != db.layers || da.levels != db.levels) return false;
+    for (size_t i = 0; i < da.planes.size(); ++i) {
+        const auto & pa = da.planes[i];
+        const auto & pb = db.planes[i];
+        if (pa.format != pb.format || pa.width != pb.width || pa.height != pb.height || pa.depth != pb.depth ||
+            pa.offset != pb.offset || pa.pitch != pb.pitch || pa.slice != pb.slice) return false;
+    }
+    for (size_t layer = 0; layer < da.layers; ++layer)
+    for (size_t level = 0; level < da.levels; ++level) {
+        if (!sSamePlane(a, b, layer, level)) return false;
+    }
+    return true;
+}
+
 class ImageTest : public CxxTest::TestSuite
 {
 public:
@@ -60,4 +242,419 @@ public:
         auto image = RawImage::load(gFile);
         TS_ASSERT(image.empty());
     }
+
+    void testSaveDDS() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // 2D with mipmaps, legacy header
+        auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 7, 5), 1, 0));
+        VectorFile f1;
+        auto loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f1);
+        TS_ASSERT_EQUALS(3u, loaded.desc().levels);
+        TS_ASSERT(sSameImage(image, loaded));
+        TS_ASSERT_EQUALS(4 + 124 + image.size(), f1.size());
+
+        // cube map with mipmaps
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 8, 8), 6, 0));
+        VectorFile f2;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f2);
+        TS_ASSERT_EQUALS(6u, loaded.desc().layers);
+        TS_ASSERT_EQUALS(4u, loaded.desc().levels);
+        TS_ASSERT(sSameImage(image, loaded));
+
+        // volume with mipmaps
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 4, 2, 8), 1, 0));
+        VectorFile f3;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f3);
+        TS_ASSERT_EQUALS(8u, loaded.depth());
+        TS_ASSERT(sSameImage(image, loaded));
+
+        // rows of odd sized block compressed mipmaps are not packed in memory.
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::DXT1_UNORM, 5, 3), 1, 0));
+        VectorFile f4;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f4);
+        TS_ASSERT(sSameImage(image, loaded));
+    }
+
+    void testSaveDDSBgra() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // BGRA8 is loaded as RGBA8
+        auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::BGRA_8_8_8_8_UNORM, 4, 4)));
+        VectorFile f;
+        auto loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f);
+        TS_ASSERT(ColorFormat::RGBA8 == loaded.format());
+        for (size_t i = 0; i < 16 && !loaded.empty(); ++i) {
+            const uint8_t * s = image.data() + i * 4;
+            const uint8_t * d = loaded.data() + i * 4;
+            TS_ASSERT(s[0] == d[2] && s[1] == d[1] && s[2] == d[0] && s[3] == d[3]);
+        }
+    }
+
+    void testSaveDDSDX10() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // Arrays need DX10 header. So does sRGB format.
+        auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::R_8_UNORM, 5, 3), 3, 0));
+        VectorFile f1;
+        auto loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f1);
+        TS_ASSERT_EQUALS(3u, loaded.desc().layers);
+        TS_ASSERT(sSameImage(image, loaded));
+        TS_ASSERT_EQUALS(0, memcmp(f1.map(84, 4, false), "DX10", 4));
+
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 3, 3), 1, 0));
+        VectorFile f2;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f2);
+        TS_ASSERT(sSameImage(image, loaded));
+
+        // array of cube maps
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::BC7_UNORM, 9, 9), 12, 0));
+        VectorFile f3;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS, f3);
+        TS_ASSERT_EQUALS(12u, loaded.desc().layers);
+        TS_ASSERT(sSameImage(image, loaded));
+
+        // forced DX10 header
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 6, 6), 6, 1));
+        VectorFile f4;
+        loaded = sSaveAndLoad(image, ImageFileFormat::DDS_DX10, f4);
+        TS_ASSERT_EQUALS(0, memcmp(f4.map(84, 4, false), "DX10", 4));
+        TS_ASSERT(sSameImage(image, loaded));
+    }
+
+    void testSavePNG() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 33, 17)));
+        VectorFile f1;
+        auto loaded = sSaveAndLoad(image, ImageFileFormat::PNG, f1);
+        TS_ASSERT(sSameImage(image, loaded));
+
+        // sRGB bytes are stored as is.
+        image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 300, 200)));
+        for (size_t y = 0; y < 200; ++y) // smooth rows, to use filters other than Sub.
+        for (size_t x = 0; x < 300 * 4; ++x) {
+            image.data()[y * 1200 + x] = (uint8_t)(x / 4 + y + (x & 3) * 50);
+        }
+        VectorFile f2;
+        loaded = sSaveAndLoad(image, ImageFileFormat::PNG, f2);
+        TS_ASSERT(ColorFormat::RGBA8 == loaded.format());
+        TS_ASSERT(!loaded.empty() && 0 == memcmp(image.data(), loaded.data(), image.size()));
+        TS_ASSERT_LESS_THAN(f2.size(), image.size() / 4);
+
+        // gray, gray + alpha, and RGB
+        ColorFormat formats[] = { ColorFormat::L_8_UNORM, ColorFormat::LA_8_8_UNORM, ColorFormat::BGRX_8_8_8_8_UNORM };
+        for (auto format : formats) {
+            image = sMakeImage(ImageDesc(ImagePlaneDesc::make(format, 11, 9)));
+            VectorFile f;
+            loaded = sSaveAndLoad(image, ImageFileFormat::PNG, f, ColorFormat::RGBA8);
+            TS_ASSERT(!loaded.empty());
+            if (loaded.empty()) continue;
+            RawImage expected(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 11, 9)));
+            for (size_t y = 0; y < 9; ++y) {
+                convertPixels(format, image.data() + image.desc().pixel(0, 0, 0, y), ColorFormat::RGBA8, expected.data() + expected.desc().pixel(0, 0, 0, y), 11);
+            }
+            TS_ASSERT(sSameImage(expected, loaded));
+        }
+    }
+
+    void testSaveTGA() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        ColorFormat formats[] = { ColorFormat::RGBA8, ColorFormat::L_8_UNORM, ColorFormat::LA_8_8_UNORM, ColorFormat::RGB_8_8_8_UNORM };
+        for (auto format : formats) {
+            auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(format, 13, 7)));
+            VectorFile f;
+            auto loaded = sSaveAndLoad(image, ImageFileFormat::TGA, f, ColorFormat::RGBA8);
+            TS_ASSERT(!loaded.empty());
+            if (loaded.empty()) continue;
+            RawImage expected(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 13, 7)));
+            for (size_t y = 0; y < 7; ++y) {
+                convertPixels(format, image.data() + image.desc().pixel(0, 0, 0, y), ColorFormat::RGBA8, expected.data() + expected.desc().pixel(0, 0, 0, y), 13);
+            }
+            TS_ASSERT(sSameImage(expected, loaded));
+        }
+    }
+
+    void testLoadPNGVariants() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // palette with transparency
+        png_color palette[3] = { {255, 0, 0}, {0, 255, 0}, {0, 0, 255} };
+        uint8_t trns[2] = { 0, 128 };
+        uint8_t indices[2 * 3] = { 0, 1, 2, 2, 1, 0 };
+        VectorFile f1;
+        sWritePNG(f1, 3, 2, 8, PNG_COLOR_TYPE_PALETTE, false, indices, 3, palette, 3, trns, 2);
+        auto image = RawImage::load(f1.map(0, f1.size(), true), f1.size());
+        TS_ASSERT(ColorFormat::RGBA8 == image.format());
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.pixel(0, 0, 0, 0), "\xFF\x00\x00\x00\x00\xFF\x00\x80\x00\x00\xFF\xFF", 12));
+
+        // 4-bit gray, interlaced
+        uint8_t gray4[2 * 2] = { 0x0F, 0x70, 0xA5, 0x00 };
+        VectorFile f2;
+        sWritePNG(f2, 3, 2, 4, PNG_COLOR_TYPE_GRAY, true, gray4, 2);
+        image = RawImage::load(f2.map(0, f2.size(), true), f2.size());
+        TS_ASSERT(ColorFormat::L_8_UNORM == image.format());
+        TS_ASSERT_EQUALS(3u, image.width());
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.pixel(0, 0, 0, 1), "\xAA\x55\x00", 3));
+
+        // ... or expanded on request
+        image = RawImage::load(f2.map(0, f2.size(), true), f2.size(), ColorFormat::RGBA8);
+        TS_ASSERT(ColorFormat::RGBA8 == image.format());
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.pixel(0, 0, 0, 1), "\xAA\xAA\xAA\xFF\x55\x55\x55\xFF\x00\x00\x00\xFF", 12));
+
+        // 16-bit gray + alpha
+        uint8_t ga16[4] = { 0x12, 0x34, 0x56, 0x78 };
+        VectorFile f3;
+        sWritePNG(f3, 1, 1, 16, PNG_COLOR_TYPE_GRAY_ALPHA, false, ga16, 4);
+        image = RawImage::load(f3.map(0, f3.size(), true), f3.size());
+        TS_ASSERT(ColorFormat::LA_16_16_UNORM == image.format());
+        TS_ASSERT(!image.empty() && 0x1234 == ((const uint16_t*)image.data())[0] && 0x5678 == ((const uint16_t*)image.data())[1]);
+
+        // 16-bit RGB gets alpha
+        uint8_t rgb16[6] = { 0xAB, 0xCD, 0x00, 0x01, 0xFF, 0xFE };
+        VectorFile f4;
+        sWritePNG(f4, 1, 1, 16, PNG_COLOR_TYPE_RGB, false, rgb16, 6);
+        image = RawImage::load(f4.map(0, f4.size(), true), f4.size());
+        TS_ASSERT(ColorFormat::RGBA_16_16_16_16_UNORM == image.format());
+        const uint16_t expected16[4] = { 0xABCD, 0x0001, 0xFFFE, 0xFFFF };
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.data(), expected16, 8));
+
+        // truncated file
+        image = RawImage::load(f3.map(0, f3.size(), true), f3.size() - 20);
+        TS_ASSERT(image.empty());
+
+        // bad CRC of the IHDR chunk, which follows the 8-byte signature
+        std::vector<uint8_t> bad((const uint8_t*)f3.map(0, f3.size(), true), (const uint8_t*)f3.map(0, f3.size(), true) + f3.size());
+        TS_ASSERT(RawImage::verify(bad.data(), bad.size()));
+        bad[8 + 8 + 13] ^= 1;
+        TS_ASSERT(!RawImage::verify(bad.data(), bad.size()));
+        // load() doesn't check CRCs.
+        TS_ASSERT(!RawImage::load(bad.data(), bad.size()).empty());
+    }
+
+    void testLoadJPG() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // smooth RGB gradient survives quality 95 within a few steps.
+        const uint32_t W = 37, H = 21;
+        std::vector<uint8_t> rgb(W * H * 3), gray(W * H);
+        for (uint32_t y = 0; y < H; ++y)
+        for (uint32_t x = 0; x < W; ++x) {
+            uint8_t * p = &rgb[(y * W + x) * 3];
+            p[0] = (uint8_t)(x * 6);
+            p[1] = (uint8_t)(y * 10);
+            p[2] = (uint8_t)(128 + x - y);
+            gray[y * W + x] = (uint8_t)(x * 3 + y * 5);
+        }
+
+        auto jpg = sWriteJPG(W, H, 3, rgb.data());
+        auto image = RawImage::load(jpg.data(), jpg.size());
+        TS_ASSERT(ColorFormat::RGB_8_8_8_UNORM == image.format());
+        TS_ASSERT_EQUALS(W, image.width());
+        TS_ASSERT_EQUALS(H, image.height());
+        int maxError = 0;
+        for (uint32_t y = 0; y < H && !image.empty(); ++y)
+        for (uint32_t x = 0; x < W; ++x) {
+            const uint8_t * p = image.pixel(0, 0, x, y);
+            for (int c = 0; c < 3; ++c) maxError = std::max(maxError, abs(p[c] - rgb[(y * W + x) * 3 + c]));
+        }
+        TS_ASSERT_LESS_EQUALS(maxError, 8);
+
+        jpg = sWriteJPG(W, H, 1, gray.data());
+        image = RawImage::load(jpg.data(), jpg.size());
+        TS_ASSERT(ColorFormat::L_8_UNORM == image.format());
+        maxError = 0;
+        for (uint32_t y = 0; y < H && !image.empty(); ++y)
+        for (uint32_t x = 0; x < W; ++x) {
+            maxError = std::max(maxError, abs(image.pixel(0, 0, x, y)[0] - gray[y * W + x]));
+        }
+        TS_ASSERT(!image.empty());
+        TS_ASSERT_LESS_EQUALS(maxError, 4);
+
+        // corrupted file
+        jpg.resize(jpg.size() / 2);
+        memset(jpg.data() + jpg.size() / 2, 0xFF, jpg.size() / 2);
+        image = RawImage::load(jpg.data(), jpg.size());
+        TS_ASSERT(image.empty());
+    }
+
+    void testLoadHDR() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // Radiance RGBE pixels above 1 are not clamped.
+        const char header[] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 1 +X 2\n";
+        std::vector<uint8_t> hdr(header, header + sizeof(header) - 1);
+        for (uint8_t b : { 128, 64, 32, 129, 128, 64, 32, 131 }) hdr.push_back(b);
+        auto image = RawImage::load(hdr.data(), hdr.size());
+        TS_ASSERT(ColorFormat::RGB_32_32_32_FLOAT == image.format());
+        const float expected[6] = { 1.0f, 0.5f, 0.25f, 4.0f, 2.0f, 1.0f };
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.data(), expected, sizeof(expected)));
+
+        // converted to half on request
+        image = RawImage::load(hdr.data(), hdr.size(), ColorFormat::RGBA_16_16_16_16_FLOAT);
+        const uint16_t halfs[8] = { 0x3C00, 0x3800, 0x3400, 0x3C00, 0x4400, 0x4000, 0x3C00, 0x3C00 };
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.data(), halfs, sizeof(halfs)));
+    }
+
+    void testLoadEXR() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // 3x2 HALF RGB, channels sorted by name, and one channel that is not read.
+        std::vector<ExrChannel> channels = { { "B", 1 }, { "G", 1 }, { "R", 1 }, { "Z", 2 } };
+        std::vector<uint8_t> lines;
+        for (uint16_t y = 0; y < 2; ++y) {
+            for (uint16_t c = 0; c < 3; ++c)
+            for (uint16_t x = 0; x < 3; ++x) sPut(lines, (uint16_t)(0x3C00 + y * 0x100 + c * 0x10 + x));
+            for (uint16_t x = 0; x < 3; ++x) sPut(lines, 100.0f);
+        }
+        for (uint8_t compression : { 0, 2, 3 }) {
+            auto exr = sWriteEXR(3, 2, channels, compression, lines);
+            auto image = RawImage::load(exr.data(), exr.size());
+            TS_ASSERT(ColorFormat::RGBA_16_16_16_16_FLOAT == image.format());
+            TS_ASSERT_EQUALS(3u, image.width());
+            TS_ASSERT_EQUALS(2u, image.height());
+            for (uint32_t y = 0; y < 2 && !image.empty(); ++y)
+            for (uint32_t x = 0; x < 3; ++x) {
+                const uint16_t * p = (const uint16_t*)image.pixel(0, 0, x, y);
+                TS_ASSERT_EQUALS(0x3C00 + y * 0x100 + 0x20 + x, p[0]);
+                TS_ASSERT_EQUALS(0x3C00 + y * 0x100 + 0x10 + x, p[1]);
+                TS_ASSERT_EQUALS(0x3C00 + y * 0x100 + x, p[2]);
+                TS_ASSERT_EQUALS(0x3C00, p[3]);
+            }
+        }
+
+        // FLOAT channels, with a HALF alpha.
+        channels = { { "A", 1 }, { "B", 2 }, { "G", 2 }, { "R", 2 } };
+        lines.clear();
+        for (float v : { 1.0f, 2.0f }) {
+            sPut(lines, (uint16_t)0x3800);
+            for (float c : { 3.0f, 2.0f, 1.0f }) sPut(lines, v * c);
+        }
+        auto exr = sWriteEXR(1, 2, channels, 3, lines);
+        auto image = RawImage::load(exr.data(), exr.size());
+        TS_ASSERT(ColorFormat::RGBA_32_32_32_32_FLOAT == image.format());
+        const float expected[8] = { 1.0f, 2.0f, 3.0f, 0.5f, 2.0f, 4.0f, 6.0f, 0.5f };
+        TS_ASSERT(!image.empty() && 0 == memcmp(image.data(), expected, sizeof(expected)));
+
+        // truncated
+        image = RawImage::load(exr.data(), exr.size() - 4);
+        TS_ASSERT(image.empty());
+    }
+
+    void testLoadMappedFile() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        auto image = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 19, 11)));
+        TempFile tmp;
+        TS_ASSERT(tmp.open("image", "wb", TempFile::MANUAL_DELETE));
+        TS_ASSERT(image.save(tmp, ImageFileFormat::PNG));
+        StrA name = tmp.name();
+        tmp.close();
+
+        DiskFile f;
+        TS_ASSERT(f.open(name, "rb"));
+        TS_ASSERT(f.caps().map);
+        const uint8_t * mapped = (const uint8_t*)f.map(1, 3, true);
+        TS_ASSERT(mapped && 0 == memcmp(mapped, "PNG", 3));
+        TS_ASSERT(nullptr == f.map(0, 4, true)); // one mapping at a time
+        f.unmap();
+        TS_ASSERT(nullptr == f.map(0, f.size() + 1, true));
+
+        auto loaded = RawImage::load(f);
+        TS_ASSERT(sSameImage(image, loaded));
+        f.close();
+        ::remove(name.rawptr());
+    }
+
+    void testLoadParallel() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        const size_t N = 6;
+        StrA names[N];
+        RawImage sources[N];
+        for (size_t i = 0; i < N - 1; ++i) {
+            sources[i] = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::RGBA8, 8 + (uint32_t)i, 5)));
+            TempFile tmp;
+            TS_ASSERT(tmp.open("image", "wb", TempFile::MANUAL_DELETE));
+            TS_ASSERT(sources[i].save(tmp, 0 == i % 2 ? ImageFileFormat::PNG : ImageFileFormat::DDS));
+            names[i] = tmp.name();
+            tmp.close();
+        }
+        names[N - 1] = names[0] + ".does.not.exist";
+
+        RawImage images[N];
+        JobSystem js(3);
+        RawImage::load(js, names, N, images);
+        for (size_t i = 0; i < N - 1; ++i) {
+            TS_ASSERT(sSameImage(sources[i], images[i]));
+            ::remove(names[i].rawptr());
+        }
+        TS_ASSERT(images[N - 1].empty());
+    }
+
+    void testLoadAsync() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        auto source = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::L_8_UNORM, 7, 3)));
+        TempFile tmp;
+        TS_ASSERT(tmp.open("image", "wb", TempFile::MANUAL_DELETE));
+        TS_ASSERT(source.save(tmp, ImageFileFormat::PNG));
+        StrA name = tmp.name();
+        tmp.close();
+
+        JobSystem js(2);
+        AsyncLoader loader(js);
+
+        // priority right after the file name, as before the format argument was added.
+        AsyncResult<RawImage> native = RawImage::loadAsync(name, AsyncPriority::HIGH, loader);
+        AsyncResult<RawImage> rgba = RawImage::loadAsync(name, ColorFormat::RGBA8, AsyncPriority::LOW, loader);
+        AsyncResult<RawImage> missing = RawImage::loadAsync(name + ".does.not.exist", AsyncPriority::NORMAL, loader);
+        TS_ASSERT_EQUALS(native.operation()->getPriority(), AsyncPriority::HIGH);
+        TS_ASSERT_EQUALS(rgba.operation()->getPriority(), AsyncPriority::LOW);
+
+        TS_ASSERT(sSameImage(source, native.get()));
+        const RawImage & converted = rgba.get();
+        TS_ASSERT(ColorFormat::RGBA8 == converted.format());
+        TS_ASSERT(!converted.empty() && source.pixel(0, 0, 0, 0)[0] == converted.pixel(0, 0, 0, 0)[0] && 0xFF == converted.pixel(0, 0, 0, 0)[3]);
+        missing.wait();
+        TS_ASSERT_EQUALS(missing.getStatus(), AsyncStatus::FAILED);
+        TS_ASSERT(missing.value().empty());
+
+        ::remove(name.rawptr());
+    }
+
+    void testSaveUnsupported() {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        VectorFile f;
+        TS_ASSERT(!RawImage().save(f, ImageFileFormat::DDS));
+
+        // block compressed image is not convertible to PNG or TGA.
+        auto bc = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::DXT1_UNORM, 4, 4)));
+        TS_ASSERT(!bc.save(f, ImageFileFormat::PNG));
+        TS_ASSERT(!bc.save(f, ImageFileFormat::TGA));
+
+        // L8 has legacy DDS format, but no DXGI format for arrays.
+        auto l8 = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::L_8_UNORM, 4, 4), 2, 1));
+        TS_ASSERT(l8.save(f, ImageFileFormat::PNG));
+        TS_ASSERT(!l8.save(f, ImageFileFormat::DDS));
+
+        // too wide for TGA
+        auto wide = sMakeImage(ImageDesc(ImagePlaneDesc::make(ColorFormat::R_8_UNORM, 0x10000, 1)));
+        TS_ASSERT(!wide.save(f, ImageFileFormat::TGA));
+    }
 };
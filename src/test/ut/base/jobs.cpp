@@ -0,0 +1,113 @@
+#include "../testCommon.h"
+#include <thread>
+
+class JobSystemTest : public CxxTest::TestSuite
+{
+public:
+
+    void testDependencies()
+    {
+        using namespace GN;
+
+        JobSystem js( 4 );
+        TS_ASSERT_EQUALS( js.getWorkerCount(), 4u );
+
+        // diamond: a -> (b, c) -> d
+        std::atomic<int> order( 0 );
+        int a = -1, b = -1, c = -1, d = -1;
+        JobHandle ja = js.create( "ut.jobs.a", [&]{ a = order++; } );
+        JobHandle jb = js.run( "ut.jobs.b", [&]{ b = order++; }, &ja, 1 );
+        JobHandle jc = js.run( "ut.jobs.c", [&]{ c = order++; }, &ja, 1 );
+        JobHandle deps[] = { jb, jc };
+        JobHandle jd = js.run( "ut.jobs.d", [&]{ d = order++; }, deps, 2 );
+
+        // nothing runs before a is submitted.
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        TS_ASSERT( !jd->isDone() );
+        TS_ASSERT_EQUALS( order.load(), 0 );
+
+        js.submit( ja );
+        js.wait( jd );
+        TS_ASSERT( ja->isDone() && jb->isDone() && jc->isDone() && jd->isDone() );
+        TS_ASSERT_EQUALS( a, 0 );
+        TS_ASSERT_LESS_THAN( a, b );
+        TS_ASSERT_LESS_THAN( a, c );
+        TS_ASSERT_EQUALS( d, 3 );
+
+        // depending on a finished job does not block.
+        JobHandle je = js.continueWith( jd, "ut.jobs.e", [&]{ order++; } );
+        js.wait( je );
+        TS_ASSERT_EQUALS( order.load(), 5 );
+    }
+
+    void testManyJobs()
+    {
+        using namespace GN;
+
+        JobSystem js( 3 );
+        const int N = 10000;
+        std::atomic<int> count( 0 );
+
+        // jobs spawning jobs: exercise worker deques and stealing.
+        for( int i = 0; i < N / 10; ++i )
+        {
+            js.run( NULL, [&]{
+                for( int k = 0; k < 9; ++k ) js.run( NULL, [&]{ count++; } );
+                count++;
+            } );
+        }
+        js.waitAll();
+        TS_ASSERT_EQUALS( count.load(), N );
+    }
+
+    void testMainThreadJobs()
+    {
+        using namespace GN;
+
+        JobSystem js( 2 );
+        std::thread::id mainId = std::this_thread::get_id();
+        std::thread::id runId;
+
+        JobHandle worker = js.run( "ut.jobs.worker", []{} );
+        JobHandle main = js.runOnMainThread( "ut.jobs.main", [&]{ runId = std::this_thread::get_id(); }, &worker, 1 );
+        js.wait( worker );
+        while( 0 == js.processMainThreadJobs() ) std::this_thread::yield();
+        TS_ASSERT( main->isDone() );
+        TS_ASSERT( runId == mainId );
+
+        // wait() on main thread runs main thread jobs too.
+        main = js.runOnMainThread( "ut.jobs.main", [&]{ runId = std::this_thread::get_id(); } );
+        js.wait( main );
+        TS_ASSERT( main->isDone() );
+    }
+
+    void testParallelFor()
+    {
+        using namespace GN;
+
+        JobSystem js( 4 );
+        const size_t N = 100000;
+        DynaArray<uint8> visited;
+        visited.resize( N );
+        memset( visited.rawptr(), 0, N );
+        std::atomic<size_t> calls( 0 );
+
+        js.parallelFor( 0, N, [&]( size_t b, size_t e ){
+            for( size_t i = b; i < e; ++i ) visited[i]++;
+            calls++;
+        }, 0, "ut.jobs.parallelFor" );
+
+        size_t wrong = 0;
+        for( size_t i = 0; i < N; ++i ) if( 1 != visited[i] ) ++wrong;
+        TS_ASSERT_EQUALS( wrong, 0u );
+        TS_ASSERT_LESS_THAN( 1u, calls.load() );
+
+        // explicit grain size
+        calls = 0;
+        js.parallelFor( 10, 110, [&]( size_t b, size_t e ){ TS_ASSERT_LESS_EQUALS( e - b, 10u ); calls++; }, 10 );
+        TS_ASSERT_LESS_EQUALS( 10u, calls.load() );
+
+        // empty range
+        js.parallelFor( 5, 5, [&]( size_t, size_t ){ TS_FAIL( "should not be called" ); } );
+    }
+};
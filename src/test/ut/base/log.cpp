@@ -2,6 +2,34 @@
 
 class LogTest : public CxxTest::TestSuite
 {
+    struct CountingReceiver : public GN::Logger::Receiver
+    {
+        std::atomic<int> count;
+        std::atomic<int> outOfOrder;
+        int              last[4];
+
+        CountingReceiver() : count(0), outOfOrder(0)
+        {
+            for( int i = 0; i < 4; ++i ) last[i] = -1;
+        }
+
+        virtual void onLog( GN::Logger &, const GN::Logger::LogDesc &, const char * msg )
+        {
+            int thread, index;
+            if( 2 == sscanf( msg, "%d:%d", &thread, &index ) && 0 <= thread && thread < 4 )
+            {
+                if( index != last[thread] + 1 ) ++outOfOrder;
+                last[thread] = index;
+            }
+            ++count;
+        }
+
+        virtual void onLog( GN::Logger &, const GN::Logger::LogDesc &, const wchar_t * )
+        {
+            ++count;
+        }
+    };
+
 public:
     void testLogMacro()
     {
@@ -14,4 +42,37 @@ public:
         GN_ERROR(sLogger)((const char*)NULL);
         GN_ERROR(sLogger)((const wchar_t*)NULL);
     }
+
+    void testAsyncLog()
+    {
+        GN::Logger * logger = GN::getLogger( "GN.test.UT.AsyncLog" );
+        CountingReceiver r;
+        logger->addReceiver( &r );
+
+        bool wasAsync = GN::isLogAsync();
+        GN::setLogAsync( true );
+        TS_ASSERT( GN::isLogAsync() );
+
+        const int N = 2000;
+        std::thread threads[4];
+        for( int t = 0; t < 4; ++t )
+        {
+            threads[t] = std::thread( [=]{
+                for( int i = 0; i < N; ++i )
+                {
+                    if( i % 100 ) GN_INFO(logger)( "%d:%d", t, i );
+                    else GN_INFO(logger)( "%d:%d long message %0512d", t, i, 0 );
+                }
+            } );
+        }
+        for( auto & t : threads ) t.join();
+        GN_INFO(logger)( L"unicode" );
+
+        GN::flushLog();
+        TS_ASSERT_EQUALS( 4 * N + 1, r.count.load() );
+        TS_ASSERT_EQUALS( 0, r.outOfOrder.load() );
+
+        GN::setLogAsync( wasAsync );
+        logger->removeReceiver( &r );
+    }
 };
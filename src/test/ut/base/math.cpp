@@ -45,6 +45,50 @@ void vector_tests( T a , T b )
     TS_ASSERT( equal(c,b) );
 }
 
+static float randf()
+{
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static GN::Matrix44f randomMatrix()
+{
+    GN::Matrix44f m;
+    for( int i = 0; i < 16; ++i ) m.data()[i] = randf();
+    return m;
+}
+
+template<class T1, class T2>
+void copyMatrix( GN::Matrix44<T1> & dst, const GN::Matrix44<T2> & src )
+{
+    for( int i = 0; i < 16; ++i ) dst.data()[i] = (T1)src.data()[i];
+}
+
+template<class T1, class T2>
+bool matrixNear( const GN::Matrix44<T1> & a, const GN::Matrix44<T2> & b, double epsilon )
+{
+    for( int i = 0; i < 16; ++i )
+    {
+        if( fabs( (double)a.data()[i] - (double)b.data()[i] ) > epsilon ) return false;
+    }
+    return true;
+}
+
+template<class T>
+static GN::Transform<T> randomTRS( bool uniformScale, bool unitScale )
+{
+    GN::Quaternion<T> q( randf(), randf(), randf(), randf() );
+    q.normalize();
+    GN::Vector3<T> t( randf() * 100, randf() * 100, randf() * 100 );
+    GN::Vector3<T> s( 0.5f + randf() * 0.4f, 1.5f + randf(), 2.0f + randf() );
+    if( uniformScale ) s.z = s.y = s.x;
+    if( unitScale ) s.set( 1, 1, 1 );
+    return GN::Transform<T>::sTRS( t, q, s );
+}
+
+//
+// Float math classes might be specialized with SIMD code. They are checked
+// against the generic double precision implementation.
+//
 class MathTest : public CxxTest::TestSuite
 {
 public:
@@ -58,4 +102,314 @@ public:
         vector_tests(a3,b3);
         vector_tests(a4,b4);
     }
+
+    void testVector4f()
+    {
+        using namespace GN;
+
+        Vector4f a( 1, 2, 3, 4 ), b( 5, -6, 7, -8 );
+        TS_ASSERT_EQUALS( a + b, Vector4f( 6, -4, 10, -4 ) );
+        TS_ASSERT_EQUALS( a - b, Vector4f( -4, 8, -4, 12 ) );
+        TS_ASSERT_EQUALS( a * b, Vector4f( 5, -12, 21, -32 ) );
+        TS_ASSERT_EQUALS( a * 2.0f, Vector4f( 2, 4, 6, 8 ) );
+        TS_ASSERT_EQUALS( Vector4f::sDot( a, b ), -18.0f );
+
+        Vector4f n = Vector4f::sNormalize( Vector4f( 3, 0, 4, 0 ) );
+        TS_ASSERT_DELTA( n.x, 0.6f, 1e-6f );
+        TS_ASSERT_DELTA( n.z, 0.8f, 1e-6f );
+        TS_ASSERT_EQUALS( Vector4f::sNormalize( Vector4f( 0, 0, 0, 0 ) ), Vector4f( 0, 0, 0, 0 ) );
+    }
+
+    void testMatrix44fMultiply()
+    {
+        using namespace GN;
+
+        for( int i = 0; i < 100; ++i )
+        {
+            Matrix44f a = randomMatrix(), b = randomMatrix();
+            Matrix44d ad, bd;
+            copyMatrix( ad, a );
+            copyMatrix( bd, b );
+
+            TS_ASSERT( matrixNear( a * b, ad * bd, 1e-5 ) );
+
+            // multiply by itself
+            Matrix44f c = a;
+            c *= c;
+            TS_ASSERT( matrixNear( c, ad * ad, 1e-5 ) );
+
+            Vector4f v( randf(), randf(), randf(), randf() );
+            Vector4f r = a * v;
+            Vector4d rd = ad * Vector4d( v.x, v.y, v.z, v.w );
+            TS_ASSERT_DELTA( r.x, rd.x, 1e-5 );
+            TS_ASSERT_DELTA( r.y, rd.y, 1e-5 );
+            TS_ASSERT_DELTA( r.z, rd.z, 1e-5 );
+            TS_ASSERT_DELTA( r.w, rd.w, 1e-5 );
+
+            Matrix44f t = Matrix44f::sTranspose( a );
+            for( int k = 0; k < 4; ++k ) for( int j = 0; j < 4; ++j ) TS_ASSERT_EQUALS( t[k][j], a[j][k] );
+        }
+    }
+
+    void testMatrix44fInverse()
+    {
+        using namespace GN;
+
+        for( int i = 0; i < 100; ++i )
+        {
+            Matrix44f a = randomMatrix();
+            Matrix44d ad;
+            copyMatrix( ad, a );
+            Matrix44d invd = Matrix44d::sInverse( ad );
+
+            // skip ill-conditioned ones
+            double maxElement = 0;
+            for( int k = 0; k < 16; ++k ) maxElement = std::max( maxElement, fabs( invd.data()[k] ) );
+            if( maxElement > 100.0 ) continue;
+
+            Matrix44f inv = Matrix44f::sInverse( a );
+            TS_ASSERT( matrixNear( inv, invd, 1e-3 ) );
+            TS_ASSERT( matrixNear( a * inv, Matrix44f::sIdentity(), 1e-4 ) );
+        }
+
+        // typical transformations
+        Matrix44f r, t, p;
+        r.rotate( Vector3f( 1, 2, 3 ), 0.7f );
+        t.translate( 10, -20, 30 );
+        p.perspectiveD3D( 1.0f, 1.5f, 0.1f, 100.0f );
+        Matrix44f m = p * t * r;
+        TS_ASSERT( matrixNear( m * Matrix44f::sInverse( m ), Matrix44f::sIdentity(), 1e-4 ) );
+
+        // singular matrix is inverted to identity
+        Matrix44f s( 1, 2, 3, 4,  2, 4, 6, 8,  0, 1, 0, 1,  1, 0, 1, 0 );
+        TS_ASSERT_EQUALS( Matrix44f::sInverse( s ), Matrix44f::sIdentity() );
+    }
+
+    void testQuaternionf()
+    {
+        using namespace GN;
+
+        for( int i = 0; i < 100; ++i )
+        {
+            Quaternionf a( randf(), randf(), randf(), randf() ), b( randf(), randf(), randf(), randf() );
+            Quaterniond ad( a.v.x, a.v.y, a.v.z, a.w ), bd( b.v.x, b.v.y, b.v.z, b.w );
+            Quaternionf c = a * b;
+            Quaterniond cd = ad * bd;
+            TS_ASSERT_DELTA( c.v.x, cd.v.x, 1e-5 );
+            TS_ASSERT_DELTA( c.v.y, cd.v.y, 1e-5 );
+            TS_ASSERT_DELTA( c.v.z, cd.v.z, 1e-5 );
+            TS_ASSERT_DELTA( c.w, cd.w, 1e-5 );
+
+            // rotation by concatenated quaternions equals concatenated matrices
+            a.normalize();
+            b.normalize();
+            TS_ASSERT_DELTA( a.getNormal(), 1.0f, 1e-5f );
+            Matrix33f ma, mb, mab;
+            a.toMatrix33( ma );
+            b.toMatrix33( mb );
+            ( a * b ).toMatrix33( mab );
+            Matrix33f expected = ma * mb;
+            for( int k = 0; k < 3; ++k ) for( int j = 0; j < 3; ++j ) TS_ASSERT_DELTA( mab[k][j], expected[k][j], 1e-5f );
+        }
+    }
+
+    void testBatchTransform()
+    {
+        using namespace GN;
+
+        // 19 is not a multiple of 4, to cover the remainders of SIMD loops.
+        const size_t N = 19;
+        Vector3f src[N], dst[N];
+        float xyz[3][N];
+        for( size_t i = 0; i < N; ++i )
+        {
+            src[i].set( randf() * 10.0f, randf() * 10.0f, randf() * 10.0f );
+            xyz[0][i] = src[i].x;
+            xyz[1][i] = src[i].y;
+            xyz[2][i] = src[i].z;
+        }
+
+        Matrix44f r, t, p;
+        r.rotate( Vector3f( 1, 2, 3 ), 0.7f );
+        t.translate( 10, -20, 30 );
+        p.perspectiveD3D( 1.0f, 1.5f, 0.1f, 100.0f );
+        Matrix44f affine = t * r;
+        Matrix44f projective = p * affine;
+
+        for( const Matrix44f & m : { affine, projective } )
+        {
+            transformPoints( dst, m, src, N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( dst[i] - m.transformPoint( src[i] ) ).length() < 1e-4f );
+
+            transformVectors( dst, m, src, N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( dst[i] - m.transformVector( src[i] ) ).length() < 1e-4f );
+
+            // strided, in place
+            struct Vertex { Vector3f pos; uint32 color; } vertices[N];
+            for( size_t i = 0; i < N; ++i ) { vertices[i].pos = src[i]; vertices[i].color = (uint32)i; }
+            transformPoints( &vertices[0].pos, sizeof(Vertex), m, &vertices[0].pos, sizeof(Vertex), N );
+            for( size_t i = 0; i < N; ++i )
+            {
+                TS_ASSERT( ( vertices[i].pos - m.transformPoint( src[i] ) ).length() < 1e-4f );
+                TS_ASSERT_EQUALS( vertices[i].color, (uint32)i );
+            }
+
+            // homogeneous
+            Vector4f h[N];
+            transformPoints( h, sizeof(Vector4f), m, src, sizeof(Vector3f), N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( h[i] - m * Vector4f( src[i], 1.0f ) ).length() < 1e-4f );
+            transformPoints( h, sizeof(Vector4f), m, &vertices[0].pos, sizeof(Vertex), N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( h[i] - m * Vector4f( vertices[i].pos, 1.0f ) ).length() < 1e-3f );
+
+            Vector4f h2[N];
+            transformVector4s( h2, m, h, N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( h2[i] - m * h[i] ).length() < 1e-2f );
+
+            // SoA
+            float out[3][N];
+            transformPointsSoA( out[0], out[1], out[2], m, xyz[0], xyz[1], xyz[2], N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( Vector3f( out[0][i], out[1][i], out[2][i] ) - m.transformPoint( src[i] ) ).length() < 1e-4f );
+            transformVectorsSoA( out[0], out[1], out[2], m, xyz[0], xyz[1], xyz[2], N );
+            for( size_t i = 0; i < N; ++i ) TS_ASSERT( ( Vector3f( out[0][i], out[1][i], out[2][i] ) - m.transformVector( src[i] ) ).length() < 1e-4f );
+        }
+    }
+
+    void testTransformBoxes()
+    {
+        using namespace GN;
+
+        Matrix44f r, t, s, p;
+        r.rotate( Vector3f( 1, 2, 3 ), 0.7f );
+        t.translate( 10, -20, 30 );
+        s.identity();
+        s[0][0] = -2.0f;
+        p.perspectiveD3D( 1.0f, 1.5f, 0.1f, 100.0f );
+
+        // the second box has negative extents.
+        Boxf src[] = { Boxf( 1, 2, 3, 4, 5, 6 ), Boxf( 1, 1, 1, -2, -3, -4 ), Boxf( 5, 5, 5, 0, 0, 0 ) };
+        const size_t N = GN_ARRAY_COUNT( src );
+
+        for( const Matrix44f & m : { Matrix44f( t * r * s ), Matrix44f( p * t ) } )
+        {
+            Boxf dst[N];
+            transformBoxes( dst, m, src, N );
+            for( size_t i = 0; i < N; ++i )
+            {
+                // same as the bounding box of 8 transformed corners
+                Vector3f corners[8];
+                for( int c = 0; c < 8; ++c ) corners[c] = m.transformPoint( src[i].corner( c ) );
+                Boxf expected;
+                calculateBoundingBox( expected, corners, sizeof(Vector3f), 8 );
+                TS_ASSERT_DELTA( dst[i].x, expected.x, 1e-4f );
+                TS_ASSERT_DELTA( dst[i].y, expected.y, 1e-4f );
+                TS_ASSERT_DELTA( dst[i].z, expected.z, 1e-4f );
+                TS_ASSERT_DELTA( dst[i].w, expected.w, 1e-4f );
+                TS_ASSERT_DELTA( dst[i].h, expected.h, 1e-4f );
+                TS_ASSERT_DELTA( dst[i].d, expected.d, 1e-4f );
+            }
+        }
+    }
+
+    void testMultiplyMatrices()
+    {
+        using namespace GN;
+
+        const size_t N = 5;
+        Matrix44f a[N], b[N], dst[N];
+        for( size_t i = 0; i < N; ++i ) { a[i] = randomMatrix(); b[i] = randomMatrix(); }
+
+        multiplyMatrices( dst, a, b, N );
+        for( size_t i = 0; i < N; ++i ) TS_ASSERT( matrixNear( dst[i], a[i] * b[i], 1e-5 ) );
+
+        multiplyMatrices( dst, a[0], b, N );
+        for( size_t i = 0; i < N; ++i ) TS_ASSERT( matrixNear( dst[i], a[0] * b[i], 1e-5 ) );
+
+        multiplyMatrices( dst, a, b[0], N );
+        for( size_t i = 0; i < N; ++i ) TS_ASSERT( matrixNear( dst[i], a[i] * b[0], 1e-5 ) );
+
+        // in place
+        Matrix44f c[N];
+        for( size_t i = 0; i < N; ++i ) c[i] = b[i];
+        multiplyMatrices( c, a[1], c, N );
+        for( size_t i = 0; i < N; ++i ) TS_ASSERT( matrixNear( c[i], a[1] * b[i], 1e-5 ) );
+    }
+
+    template<class T>
+    void fastInverseTests( double epsilon )
+    {
+        using namespace GN;
+
+        for( int i = 0; i < 100; ++i )
+        {
+            Matrix44<T> rigid = randomTRS<T>( true, true ).matrix();
+            Matrix44<T> trs = randomTRS<T>( false, false ).matrix();
+            TS_ASSERT( matrixNear( Matrix44<T>::sInvertRigid( rigid ), Matrix44<T>::sInverse( rigid ), epsilon ) );
+            TS_ASSERT( matrixNear( Matrix44<T>::sInvertTRS( rigid ), Matrix44<T>::sInverse( rigid ), epsilon ) );
+            TS_ASSERT( matrixNear( Matrix44<T>::sInvertTRS( trs ), Matrix44<T>::sInverse( trs ), epsilon ) );
+            TS_ASSERT( matrixNear( Matrix44<T>::sInvertAffine( trs ), Matrix44<T>::sInverse( trs ), epsilon ) );
+            TS_ASSERT( matrixNear( trs * Matrix44<T>::sInvertTRS( trs ), Matrix44<T>::sIdentity(), epsilon ) );
+
+            // sheared
+            Matrix44<T> affine;
+            copyMatrix( affine, randomMatrix() );
+            affine[3].set( 0, 0, 0, 1 );
+            Matrix44<T> general = Matrix44<T>::sInverse( affine );
+            double maxElement = 0;
+            for( int k = 0; k < 16; ++k ) maxElement = std::max( maxElement, fabs( (double)general.data()[k] ) );
+            if( maxElement > 100.0 ) continue;
+            TS_ASSERT( matrixNear( Matrix44<T>::sInvertAffine( affine ), general, epsilon * 10 ) );
+        }
+
+        // singular matrices are inverted to identity
+        Matrix44<T> s = Matrix44<T>::sIdentity();
+        s[1][1] = 0;
+        TS_ASSERT_EQUALS( Matrix44<T>::sInvertAffine( s ), Matrix44<T>::sIdentity() );
+        TS_ASSERT_EQUALS( Matrix44<T>::sInvertTRS( s ), Matrix44<T>::sIdentity() );
+    }
+
+    void testFastInverse()
+    {
+        // double precision is the scalar code, float could be SIMD.
+        fastInverseTests<double>( 1e-9 );
+        fastInverseTests<float>( 1e-4 );
+    }
+
+    void testTransform()
+    {
+        using namespace GN;
+
+        TS_ASSERT_EQUALS( Transformf().kind(), Transformf::IDENTITY );
+        TS_ASSERT_EQUALS( randomTRS<float>( true, true ).kind(), Transformf::RIGID );
+        TS_ASSERT_EQUALS( randomTRS<float>( true, false ).kind(), Transformf::SIMILAR );
+        TS_ASSERT_EQUALS( randomTRS<float>( false, false ).kind(), Transformf::TRS );
+
+        // sTRS() is the same as T * R * S
+        Quaternionf q( 0.1f, 0.2f, 0.3f, 0.9f );
+        q.normalize();
+        Matrix44f t, r, s;
+        t.translate( 1, 2, 3 );
+        q.toMatrix44( r );
+        s.identity();
+        s[0][0] = 2; s[1][1] = 3; s[2][2] = 4;
+        TS_ASSERT( matrixNear( Transformf::sTRS( Vector3f( 1, 2, 3 ), q, Vector3f( 2, 3, 4 ) ).matrix(), t * r * s, 1e-5 ) );
+
+        for( int i = 0; i < 100; ++i )
+        {
+            Transformf a = randomTRS<float>( i % 3 == 0, i % 3 == 1 );
+            Transformf b = randomTRS<float>( i % 2 == 0, false );
+            Transformf ab = a * b;
+            TS_ASSERT( matrixNear( ab.matrix(), a.matrix() * b.matrix(), 1e-3 ) );
+
+            // the combined kind must be inverted correctly by its own method.
+            Matrix44f expected = Matrix44f::sInverse( ab.matrix() );
+            TS_ASSERT( matrixNear( Transformf::sInverse( ab ).matrix(), expected, 1e-3 ) );
+            TS_ASSERT( matrixNear( Transformf::sInverse( ab * Transformf::sInverse( b ) ).matrix(), Matrix44f::sInverse( a.matrix() ), 1e-2 ) );
+        }
+
+        TS_ASSERT_EQUALS( Transformf::sCombine( Transformf::RIGID, Transformf::SIMILAR ), Transformf::SIMILAR );
+        TS_ASSERT_EQUALS( Transformf::sCombine( Transformf::SIMILAR, Transformf::TRS ), Transformf::TRS );
+        TS_ASSERT_EQUALS( Transformf::sCombine( Transformf::TRS, Transformf::RIGID ), Transformf::AFFINE );
+        TS_ASSERT_EQUALS( Transformf::sCombine( Transformf::IDENTITY, Transformf::GENERAL ), Transformf::GENERAL );
+        TS_ASSERT_EQUALS( Transformf::sInverse( randomTRS<float>( false, false ) ).kind(), Transformf::AFFINE );
+    }
 };
@@ -49,7 +49,7 @@ public:
         void * p2 = a.alloc();
         void * p3 = a.alloc();
 
-#if GN_X64
+#if GN_X64 || GN_ARM64
         TS_ASSERT_EQUALS( 40, (uint8*)p0 - (uint8*)p1 );
         TS_ASSERT_EQUALS( 40, (uint8*)p2 - (uint8*)p3 );
 #else
@@ -80,6 +80,28 @@ public:
             a.alloc();
         }
     }
+
+    void testHeapStatistics()
+    {
+        using namespace GN;
+
+        HeapMemory::resetStatistics();
+        HeapMemory::enableStatistics( true );
+        void * p = HeapMemory::alloc( 100 );
+        p = HeapMemory::realloc( p, 200 );
+        HeapMemory::dealloc( p );
+        HeapMemory::dealloc( NULL );
+        HeapMemory::enableStatistics( false );
+        HeapMemory::dealloc( HeapMemory::alloc( 10 ) );
+
+        // counters are process wide. Other threads (jobs, logging) may allocate meanwhile.
+        HeapMemory::Statistics s;
+        HeapMemory::getStatistics( s );
+        TS_ASSERT_LESS_EQUALS( (uint64)1, s.allocCount );
+        TS_ASSERT_LESS_EQUALS( (uint64)1, s.reallocCount );
+        TS_ASSERT_LESS_EQUALS( (uint64)1, s.freeCount );
+        TS_ASSERT_LESS_EQUALS( (uint64)300, s.allocBytes );
+    }
 };
 
 inline void * MemPoolTest::Test::operator new( size_t ) { return MemPoolTest::sPool.allocUnconstructed(); }
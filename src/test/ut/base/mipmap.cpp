@@ -0,0 +1,259 @@
+#include "../testCommon.h"
+#include "garnet/GNgfx.h"
+#include <vector>
+#include <math.h>
+
+class MipmapTest : public CxxTest::TestSuite
+{
+    typedef GN::gfx::MipmapFilter Filter;
+    typedef GN::gfx::MipmapColorSpace ColorSpace;
+
+    // image of one level, with pixels of 4 bytes
+    static GN::gfx::RawImage sImage( GN::gfx::ColorFormat format, uint32 w, uint32 h, const uint8 * pixels, uint32 layers = 1, uint32 d = 1 )
+    {
+        using namespace GN::gfx;
+        RawImage image( ImageDesc( ImagePlaneDesc::make( format, w, h, d ), layers, 1 ) );
+        for( uint32 layer = 0; layer < layers; ++layer )
+        for( uint32 z = 0; z < d; ++z )
+        for( uint32 y = 0; y < h; ++y )
+            memcpy( image.pixel( layer, 0, 0, y, z ), pixels + ( ( ( layer * d + z ) * h + y ) * w ) * 4, w * 4 );
+        return image;
+    }
+
+    static std::vector<uint8> sNoise( size_t count, uint64 seed )
+    {
+        std::vector<uint8> p( count );
+        for( auto & b : p ) b = (uint8)( nextRandom64( seed ) >> 56 );
+        return p;
+    }
+
+public:
+
+    void testLevels()
+    {
+        using namespace GN::gfx;
+
+        std::vector<uint8> p = sNoise( 37 * 19 * 4, 1 );
+        RawImage image = sImage( ColorFormat::RGBA8, 37, 19, p.data() );
+        TS_ASSERT( image.generateMipmaps() );
+        TS_ASSERT_EQUALS( 6u, image.desc().levels );
+        const uint32 W[] = { 37, 18, 9, 4, 2, 1 }, H[] = { 19, 9, 4, 2, 1, 1 };
+        for( uint32 i = 0; i < 6; ++i )
+        {
+            TS_ASSERT_EQUALS( W[i], image.width( 0, i ) );
+            TS_ASSERT_EQUALS( H[i], image.height( 0, i ) );
+        }
+
+        // base level is untouched
+        for( uint32 y = 0; y < 19; ++y )
+            TS_ASSERT_SAME_DATA( image.pixel( 0, 0, 0, y ), &p[y * 37 * 4], 37 * 4 );
+
+        // generate again, from the base level
+        RawImage copy( ImageDesc( image.desc() ), image.data() );
+        TS_ASSERT( image.generateMipmaps() );
+        TS_ASSERT_EQUALS( copy.size(), image.size() );
+        TS_ASSERT_SAME_DATA( copy.data(), image.data(), copy.size() );
+    }
+
+    void testBoxAverage()
+    {
+        using namespace GN::gfx;
+
+        // 4x2 pixels: each 2x2 block averages to a known color
+        const uint8 p[] = {
+            0,   0,   0,   0,    40,  80,  120, 160,   10, 20, 30, 40,   10, 20, 30, 40,
+            80,  160, 240, 200,  120, 240, 0,   0,     10, 20, 30, 40,   10, 20, 30, 40,
+        };
+        RawImage image = sImage( ColorFormat::RGBA8, 4, 2, p );
+        TS_ASSERT( image.generateMipmaps( Filter::BOX, ColorSpace::LINEAR, false ) );
+        TS_ASSERT_EQUALS( 3u, image.desc().levels );
+
+        const uint8 * a = image.pixel( 0, 1, 0, 0 );
+        TS_ASSERT_EQUALS( 60, a[0] );
+        TS_ASSERT_EQUALS( 120, a[1] );
+        TS_ASSERT_EQUALS( 90, a[2] );
+        TS_ASSERT_EQUALS( 90, a[3] );
+        const uint8 * b = image.pixel( 0, 1, 1, 0 );
+        TS_ASSERT_SAME_DATA( b, &p[8], 4 );
+        const uint8 * c = image.pixel( 0, 2, 0, 0 );
+        TS_ASSERT_EQUALS( 35, c[0] );
+        TS_ASSERT_EQUALS( 70, c[1] );
+        TS_ASSERT_EQUALS( 60, c[2] );
+        TS_ASSERT_EQUALS( 65, c[3] );
+
+        // 3 pixels to 1 are covered equally
+        const uint8 q[] = { 0, 0, 0, 255,   30, 60, 90, 255,   60, 120, 180, 255 };
+        RawImage odd = sImage( ColorFormat::RGBA8, 3, 1, q );
+        TS_ASSERT( odd.generateMipmaps( Filter::BOX, ColorSpace::LINEAR ) );
+        TS_ASSERT_EQUALS( 2u, odd.desc().levels );
+        TS_ASSERT_SAME_DATA( odd.pixel( 0, 1 ), &q[4], 4 );
+    }
+
+    void testSrgb()
+    {
+        using namespace GN::gfx;
+
+        // black and white average to linear 0.5, which is 188 in sRGB, 128 in linear.
+        const uint8 p[] = { 0, 0, 0, 255,   255, 255, 255, 255,   255, 255, 255, 255,   0, 0, 0, 255 };
+
+        RawImage srgb = sImage( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 2, 2, p );
+        TS_ASSERT( srgb.generateMipmaps() );
+        TS_ASSERT_EQUALS( 188, srgb.pixel( 0, 1 )[0] );
+        TS_ASSERT_EQUALS( 255, srgb.pixel( 0, 1 )[3] );
+
+        RawImage forced = sImage( ColorFormat::RGBA8, 2, 2, p );
+        TS_ASSERT( forced.generateMipmaps( Filter::BOX, ColorSpace::SRGB ) );
+        TS_ASSERT_EQUALS( 188, forced.pixel( 0, 1 )[1] );
+
+        RawImage linear = sImage( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 2, 2, p );
+        TS_ASSERT( linear.generateMipmaps( Filter::BOX, ColorSpace::LINEAR ) );
+        TS_ASSERT_EQUALS( 128, linear.pixel( 0, 1 )[2] );
+    }
+
+    void testAlphaWeighted()
+    {
+        using namespace GN::gfx;
+
+        // one opaque red pixel, and 3 transparent green ones
+        const uint8 p[] = { 255, 0, 0, 255,   0, 255, 0, 0,   0, 255, 0, 0,   0, 255, 0, 0 };
+
+        RawImage weighted = sImage( ColorFormat::RGBA8, 2, 2, p );
+        TS_ASSERT( weighted.generateMipmaps( Filter::BOX, ColorSpace::LINEAR, true ) );
+        const uint8 * a = weighted.pixel( 0, 1 );
+        TS_ASSERT_EQUALS( 255, a[0] );
+        TS_ASSERT_EQUALS( 0, a[1] );
+        TS_ASSERT_EQUALS( 64, a[3] );
+
+        RawImage plain = sImage( ColorFormat::RGBA8, 2, 2, p );
+        TS_ASSERT( plain.generateMipmaps( Filter::BOX, ColorSpace::LINEAR, false ) );
+        const uint8 * b = plain.pixel( 0, 1 );
+        TS_ASSERT_EQUALS( 64, b[0] );
+        TS_ASSERT_EQUALS( 191, b[1] );
+        TS_ASSERT_EQUALS( 64, b[3] );
+    }
+
+    void testNormalMap()
+    {
+        using namespace GN::gfx;
+
+        // unit normals tilted +x, -x, +y and -y by 45 degrees, in [0, 1]
+        const uint8 t = (uint8)( 127.5f + 127.5f * 0.7071f ), u = (uint8)( 127.5f - 127.5f * 0.7071f );
+        const uint8 p[] = { t, 128, t, 255,   u, 128, t, 255,   128, t, t, 255,   128, u, t, 255 };
+
+        RawImage image = sImage( ColorFormat::RGBA8, 2, 2, p );
+        TS_ASSERT( image.generateMipmaps( Filter::BOX, ColorSpace::NORMAL_MAP ) );
+        const uint8 * n = image.pixel( 0, 1 );
+        TS_ASSERT_LESS_EQUALS( abs( n[0] - 128 ), 1 );
+        TS_ASSERT_LESS_EQUALS( abs( n[1] - 128 ), 1 );
+        TS_ASSERT_EQUALS( 255, n[2] );
+
+        // plain average is shorter than 1
+        RawImage plain = sImage( ColorFormat::RGBA8, 2, 2, p );
+        TS_ASSERT( plain.generateMipmaps( Filter::BOX, ColorSpace::LINEAR ) );
+        TS_ASSERT_LESS_THAN( plain.pixel( 0, 1 )[2], 225 );
+
+        // 2 channel normals compute Z from X and Y, and are renormalized too
+        std::vector<uint8> q = sNoise( 16 * 16 * 4, 3 );
+        RawImage rg( ImageDesc( ImagePlaneDesc::make( ColorFormat::RG_8_8_SNORM, 16, 16 ) ) );
+        for( uint32 i = 0; i < 16 * 16; ++i )
+        {
+            // random XY, inside unit circle
+            float a = q[i * 4] / 255.0f * 6.2832f, r = q[i * 4 + 1] / 255.0f * 0.9f;
+            sint8 * d = (sint8*)rg.data() + rg.desc().plane().pixel( i % 16, i / 16 );
+            d[0] = (sint8)( cosf( a ) * r * 127.0f );
+            d[1] = (sint8)( sinf( a ) * r * 127.0f );
+        }
+        TS_ASSERT( rg.generateMipmaps( Filter::KAISER, ColorSpace::NORMAL_MAP ) );
+        for( uint32 level = 1; level < rg.desc().levels; ++level )
+        {
+            const sint8 * d = (const sint8*)rg.pixel( 0, level );
+            float x = d[0] / 127.0f, y = d[1] / 127.0f;
+            TS_ASSERT_LESS_EQUALS( x * x + y * y, 1.0f + 0.02f );
+        }
+    }
+
+    void testLayersAndDepth()
+    {
+        using namespace GN::gfx;
+
+        // 6 faces of solid colors stay solid, and don't bleed into each other.
+        std::vector<uint8> faces( 6 * 8 * 8 * 4 );
+        for( size_t i = 0; i < faces.size(); ++i ) faces[i] = (uint8)( ( i / ( 8 * 8 * 4 ) ) * 40 + ( i % 4 ) );
+        RawImage cube = sImage( ColorFormat::RGBA8, 8, 8, faces.data(), 6 );
+        TS_ASSERT( cube.generateMipmaps( Filter::LANCZOS ) );
+        TS_ASSERT_EQUALS( 6u, cube.desc().layers );
+        TS_ASSERT_EQUALS( 4u, cube.desc().levels );
+        for( uint32 face = 0; face < 6; ++face )
+        for( uint32 level = 1; level < 4; ++level )
+        {
+            const uint8 * c = cube.pixel( face, level, cube.width( face, level ) - 1 );
+            TS_ASSERT_SAME_DATA( c, &faces[face * 8 * 8 * 4], 4 );
+        }
+
+        // volume: 4x4x2 of two slices, average of both
+        std::vector<uint8> slices( 4 * 4 * 2 * 4, 20 );
+        memset( &slices[4 * 4 * 4], 60, 4 * 4 * 4 );
+        RawImage volume = sImage( ColorFormat::RGBA8, 4, 4, slices.data(), 1, 2 );
+        TS_ASSERT( volume.generateMipmaps( Filter::BOX, ColorSpace::LINEAR, false ) );
+        TS_ASSERT_EQUALS( 3u, volume.desc().levels );
+        TS_ASSERT_EQUALS( 1u, volume.depth( 0, 1 ) );
+        TS_ASSERT_EQUALS( 40, volume.pixel( 0, 1, 1, 1 )[0] );
+        TS_ASSERT_EQUALS( 40, volume.pixel( 0, 2 )[3] );
+    }
+
+    void testFilters()
+    {
+        using namespace GN::gfx;
+
+        // a linear ramp stays a ramp: sharp filters do not shift or overshoot it
+        std::vector<uint8> ramp( 64 * 4 * 4 );
+        for( uint32 y = 0; y < 4; ++y )
+        for( uint32 x = 0; x < 64; ++x )
+            for( uint32 k = 0; k < 4; ++k ) ramp[( y * 64 + x ) * 4 + k] = (uint8)( k < 3 ? x * 4 : 255 );
+
+        const Filter filters[] = { Filter::BOX, Filter::KAISER, Filter::LANCZOS };
+        for( Filter f : filters )
+        {
+            RawImage image = sImage( ColorFormat::RGBA8, 64, 4, ramp.data() );
+            TS_ASSERT( image.generateMipmaps( f, ColorSpace::LINEAR ) );
+            for( uint32 x = 3; x < 29; ++x )
+            {
+                const uint8 * c = image.pixel( 0, 1, x, 1 );
+                TS_ASSERT_LESS_EQUALS( abs( c[0] - (int)( x * 8 + 2 ) ), 1 );
+                TS_ASSERT_EQUALS( 255, c[3] );
+            }
+        }
+
+        // worker threads filter the same pixels
+        std::vector<uint8> p = sNoise( 93 * 71 * 4 * 2, 5 );
+        GN::JobSystem js( 3 );
+        for( Filter f : filters )
+        {
+            RawImage serial = sImage( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 93, 71, p.data(), 2 );
+            RawImage parallel = sImage( ColorFormat::RGBA_8_8_8_8_UNORM_SRGB, 93, 71, p.data(), 2 );
+            TS_ASSERT( serial.generateMipmaps( f ) );
+            TS_ASSERT( parallel.generateMipmaps( js, f ) );
+            TS_ASSERT_EQUALS( serial.size(), parallel.size() );
+            TS_ASSERT_SAME_DATA( serial.data(), parallel.data(), serial.size() );
+        }
+    }
+
+    void testUnsupported()
+    {
+        using namespace GN::gfx;
+
+        RawImage empty;
+        TS_ASSERT( !empty.generateMipmaps() );
+
+        RawImage dxt( ImageDesc( ImagePlaneDesc::make( ColorFormat::DXT1_UNORM, 8, 8 ) ) );
+        TS_ASSERT( !dxt.generateMipmaps() );
+        TS_ASSERT_EQUALS( 1u, dxt.desc().levels );
+
+        RawImage hdr( ImageDesc( ImagePlaneDesc::make( ColorFormat::FLOAT4, 8, 8 ) ) );
+        memset( hdr.data(), 0, hdr.size() );
+        TS_ASSERT( !hdr.generateMipmaps( Filter::BOX, ColorSpace::SRGB ) );
+        TS_ASSERT_EQUALS( 1u, hdr.desc().levels );
+        TS_ASSERT( hdr.generateMipmaps( Filter::KAISER ) );
+        TS_ASSERT_EQUALS( 4u, hdr.desc().levels );
+    }
+};
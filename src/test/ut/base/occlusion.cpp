@@ -0,0 +1,163 @@
+#include "../testCommon.h"
+#include <vector>
+
+class OcclusionBufferTest : public CxxTest::TestSuite
+{
+    // quad in clip space (w = 1), 2 triangles
+    static void sAddQuad( GN::OcclusionBuffer & ob, float x0, float y0, float x1, float y1, float z )
+    {
+        using namespace GN;
+        Vector3f v[] = { Vector3f( x0, y0, z ), Vector3f( x1, y0, z ), Vector3f( x1, y1, z ), Vector3f( x0, y1, z ) };
+        uint16 indices[] = { 0, 1, 2, 0, 2, 3 };
+        ob.addOccluder( Matrix44f::sIdentity(), v, sizeof(Vector3f), 4, indices, 6 );
+    }
+
+    // random boxes of a few blocks in front of the camera, looking at -z.
+    static void sCityScene( GN::OcclusionBuffer & ob, GN::Matrix44f & viewProj, std::vector<GN::Boxf> & occludees )
+    {
+        using namespace GN;
+        Matrix44f proj, view;
+        proj.perspectiveD3DRh( 1.0f, 1.5f, 1.0f, 200.0f );
+        view.lookAtRh( Vector3f( 0, 2, 0 ), Vector3f( 0, 2, -10 ), Vector3f( 0, 1, 0 ) );
+        viewProj = proj * view;
+
+        // unit cube
+        Vector3f v[8];
+        for( int i = 0; i < 8; ++i ) v[i].set( (float)( i & 1 ), (float)( ( i >> 1 ) & 1 ), (float)( ( i >> 2 ) & 1 ) );
+        uint32 indices[] = {
+            0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,  0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,  0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3 };
+
+        uint64 seed = 3;
+        for( int i = 0; i < 200; ++i )
+        {
+            Matrix44f world;
+            Vector3f pos( nextRandomFloat( seed ) * 50, 0, nextRandomFloat( seed ) * 50 - 55 );
+            Vector3f size( nextRandomFloat( seed ) * 3 + 4, nextRandomFloat( seed ) * 10 + 12, nextRandomFloat( seed ) * 3 + 4 );
+            world.identity();
+            world.rows[0].set( size.x, 0, 0, pos.x );
+            world.rows[1].set( 0, size.y, 0, pos.y );
+            world.rows[2].set( 0, 0, size.z, pos.z );
+            ob.addOccluder( viewProj * world, v, sizeof(Vector3f), 8, indices, 36 );
+        }
+
+        for( int i = 0; i < 1000; ++i )
+        {
+            occludees.push_back( Boxf( nextRandomFloat( seed ) * 60, nextRandomFloat( seed ) * 2 + 2, nextRandomFloat( seed ) * 60 - 60, 1, 1, 1 ) );
+        }
+    }
+
+public:
+
+    void testClearAndInit()
+    {
+        using namespace GN;
+
+        OcclusionBuffer ob;
+        TS_ASSERT( !ob.init( 0, 10 ) );
+        TS_ASSERT( ob.init( 100, 50 ) );
+        TS_ASSERT_EQUALS( ob.getWidth(), 104u );
+        TS_ASSERT_EQUALS( ob.getHeight(), 56u );
+        for( size_t i = 0; i < ob.getWidth() * ob.getHeight(); ++i ) TS_ASSERT_EQUALS( ob.getDepth()[i], 1.0f );
+
+        // nothing is occluded by an empty buffer
+        TS_ASSERT( ob.testBox( Matrix44f::sIdentity(), Boxf( -0.5f, -0.5f, 0.5f, 0.1f, 0.1f, 0.1f ) ) );
+    }
+
+    void testFullScreenOccluder()
+    {
+        using namespace GN;
+
+        OcclusionBuffer ob;
+        ob.init( 128, 96 );
+        sAddQuad( ob, -1, -1, 1, 1, 0.5f );
+        TS_ASSERT_EQUALS( ob.getTriangleCount(), 2u );
+        ob.render();
+
+        for( size_t i = 0; i < ob.getWidth() * ob.getHeight(); ++i ) TS_ASSERT_EQUALS( ob.getDepth()[i], 0.5f );
+
+        const Matrix44f & m = Matrix44f::sIdentity();
+        TS_ASSERT( !ob.testBox( m, Boxf( -0.5f, -0.5f, 0.6f, 0.5f, 0.5f, 0.1f ) ) );   // behind
+        TS_ASSERT( ob.testBox( m, Boxf( -0.5f, -0.5f, 0.3f, 0.5f, 0.5f, 0.1f ) ) );    // in front
+        TS_ASSERT( ob.testBox( m, Boxf( -0.5f, -0.5f, 0.4f, 0.5f, 0.5f, 0.3f ) ) );    // intersects
+        TS_ASSERT( !ob.testBox( m, Boxf( 1.5f, -0.5f, 0.3f, 0.5f, 0.5f, 0.1f ) ) );    // off screen
+        TS_ASSERT( ob.testBox( m, Boxf( -0.5f, -0.5f, -0.1f, 0.5f, 0.5f, 0.3f ) ) );   // crosses near plane
+        TS_ASSERT( !ob.testBox( m, Boxf( -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.3f ) ) );  // before near plane
+    }
+
+    void testPartialOccluder()
+    {
+        using namespace GN;
+
+        // left half of the screen
+        OcclusionBuffer ob;
+        ob.init( 64, 64 );
+        sAddQuad( ob, -1, -1, 0, 1, 0.5f );
+        ob.render();
+
+        const float * depth = ob.getDepth();
+        TS_ASSERT_EQUALS( depth[0], 0.5f );
+        TS_ASSERT_EQUALS( depth[31], 0.5f );
+        TS_ASSERT_EQUALS( depth[32], 1.0f );
+        TS_ASSERT_EQUALS( depth[63 * 64 + 31], 0.5f );
+        TS_ASSERT_EQUALS( depth[63 * 64 + 63], 1.0f );
+
+        const Matrix44f & m = Matrix44f::sIdentity();
+        TS_ASSERT( !ob.testBox( m, Boxf( -0.9f, -0.5f, 0.6f, 0.5f, 0.5f, 0.1f ) ) );
+        TS_ASSERT( ob.testBox( m, Boxf( -0.5f, -0.5f, 0.6f, 0.7f, 0.5f, 0.1f ) ) );
+        TS_ASSERT( ob.testBox( m, Boxf( 0.2f, -0.5f, 0.6f, 0.5f, 0.5f, 0.1f ) ) );
+
+        // triangle crossing the near plane is clipped, not dropped.
+        Matrix44f proj;
+        proj.perspectiveD3DRh( 1.0f, 1.0f, 1.0f, 100.0f );
+        Vector3f tri[] = { Vector3f( -10, -10, 5 ), Vector3f( 10, -10, -10 ), Vector3f( 0, 10, -10 ) };
+        ob.clear();
+        ob.addOccluder( proj, tri, sizeof(Vector3f), 3, (const uint32*)NULL, 0 );
+        TS_ASSERT_EQUALS( ob.getTriangleCount(), 2u );
+        ob.render();
+        size_t covered = 0;
+        for( size_t i = 0; i < 64 * 64; ++i ) if( depth[i] < 1.0f ) ++covered;
+        TS_ASSERT( covered > 64 * 16 );
+    }
+
+    void testDeterministic()
+    {
+        using namespace GN;
+
+        Matrix44f viewProj;
+        std::vector<Boxf> boxes;
+
+        OcclusionBuffer serial, parallel;
+        serial.init( 320, 180 );
+        parallel.init( 320, 180 );
+        sCityScene( serial, viewProj, boxes );
+        boxes.clear();
+        sCityScene( parallel, viewProj, boxes );
+
+        serial.render();
+        JobSystem js( 3 );
+        parallel.render( js );
+
+        size_t pixels = serial.getWidth() * serial.getHeight();
+        size_t blocks = pixels / ( OcclusionBuffer::BLOCK_SIZE * OcclusionBuffer::BLOCK_SIZE );
+        TS_ASSERT_SAME_DATA( serial.getDepth(), parallel.getDepth(), (unsigned int)( pixels * sizeof(float) ) );
+        TS_ASSERT_SAME_DATA( serial.getBlockDepth(), parallel.getBlockDepth(), (unsigned int)( blocks * sizeof(float) ) );
+
+        // hierarchical depth is the farthest depth of each block.
+        for( size_t b = 0; b < blocks; ++b )
+        {
+            size_t bx = b % ( serial.getWidth() / 8 ), by = b / ( serial.getWidth() / 8 );
+            float m = 0;
+            for( size_t y = 0; y < 8; ++y )
+                for( size_t x = 0; x < 8; ++x )
+                    m = math::getmax( m, serial.getDepth()[( by * 8 + y ) * serial.getWidth() + bx * 8 + x] );
+            TS_ASSERT_EQUALS( m, serial.getBlockDepth()[b] );
+        }
+
+        // some boxes are hidden, but not all.
+        std::vector<uint32> visible( boxes.size() );
+        size_t n = serial.testBoxes( visible.data(), viewProj, boxes.data(), boxes.size() );
+        TS_ASSERT( n > 0 && n < boxes.size() );
+        for( size_t i = 0; i < n; ++i ) TS_ASSERT( serial.testBox( viewProj, boxes[visible[i]] ) );
+    }
+};
@@ -0,0 +1,218 @@
+#include "../testCommon.h"
+#include <thread>
+
+class ProfilerTest : public CxxTest::TestSuite
+{
+    static void sBusyWait( double seconds )
+    {
+        GN::Clock c;
+        while( c.getTimeD() < seconds ) {}
+    }
+
+    static const GN::ProfileCallNode * sFindNode( const GN::DynaArray<GN::ProfileCallNode> & tree, const char * name, size_t depth )
+    {
+        for( size_t i = 0; i < tree.size(); ++i )
+        {
+            if( tree[i].depth == depth && 0 == GN::str::compare( tree[i].name, name ) ) return &tree[i];
+        }
+        return NULL;
+    }
+
+    static int sCount( const GN::StrA & text, const char * pattern )
+    {
+        int n = 0;
+        for( const char * p = strstr( text.rawptr(), pattern ); p; p = strstr( p + 1, pattern ) ) ++n;
+        return n;
+    }
+
+public:
+
+    void testNestedScopes()
+    {
+        using namespace GN;
+
+        ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+        ProfilerManager::sSetMode( PM_FULL );
+        pm.reset();
+
+        const int THREADS = 4;
+        const int LOOPS = 10;
+        std::thread threads[THREADS];
+        for( int t = 0; t < THREADS; ++t )
+        {
+            threads[t] = std::thread( []{
+                ProfileTimer & outer = ProfilerManager::sGetGlobalInstance().getTimer( "ut.profiler.outer" );
+                ProfileTimer & inner = ProfilerManager::sGetGlobalInstance().getTimer( "ut.profiler.inner" );
+                for( int i = 0; i < LOOPS; ++i )
+                {
+                    ScopeTimer s1( &outer );
+                    sBusyWait( 0.0005 );
+                    ScopeTimer s2( &inner );
+                    sBusyWait( 0.0005 );
+                }
+            } );
+        }
+        for( int t = 0; t < THREADS; ++t ) threads[t].join();
+
+        pm.aggregate();
+
+        ProfileTimer & outer = pm.getTimer( "ut.profiler.outer" );
+        ProfileTimer & inner = pm.getTimer( "ut.profiler.inner" );
+        TS_ASSERT_EQUALS( outer.getCount(), (uint64)(THREADS * LOOPS) );
+        TS_ASSERT_EQUALS( inner.getCount(), (uint64)(THREADS * LOOPS) );
+        TS_ASSERT_LESS_THAN( inner.getSum(), outer.getSum() );
+        TS_ASSERT_LESS_EQUALS( 0.0005, inner.getMin() );
+
+        // Note: exited threads are removed from call tree. So check call tree on the main thread.
+        {
+            ScopeTimer s1( &outer );
+            sBusyWait( 0.0005 );
+            ScopeTimer s2( &inner );
+            sBusyWait( 0.0005 );
+        }
+        DynaArray<ProfileCallNode> tree;
+        pm.getCallTree( tree );
+        const ProfileCallNode * o = sFindNode( tree, "ut.profiler.outer", 1 );
+        const ProfileCallNode * n = sFindNode( tree, "ut.profiler.inner", 2 );
+        TS_ASSERT( o && n );
+        if( o && n )
+        {
+            TS_ASSERT_EQUALS( o->count, (uint64)1 );
+            TS_ASSERT_EQUALS( n->count, (uint64)1 );
+            TS_ASSERT_DELTA( o->exclusive, o->inclusive - n->inclusive, 1e-9 );
+            TS_ASSERT_LESS_EQUALS( 0.0005, o->exclusive );
+            TS_ASSERT_DELTA( n->exclusive, n->inclusive, 1e-9 );
+        }
+        TS_ASSERT_EQUALS( outer.getCount(), (uint64)(THREADS * LOOPS + 1) );
+    }
+
+    void testTraceExport()
+    {
+        using namespace GN;
+
+        ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+        ProfilerManager::sSetMode( PM_FULL );
+        ProfileTimer & t = pm.getTimer( "ut.profiler.\"trace\"" );
+
+        // end event without begin should be skipped
+        t.start();
+        pm.startTrace( TM_RECORD );
+        t.stop();
+        for( int i = 0; i < 3; ++i ) { ScopeTimer s( &t ); }
+        pm.stopTrace();
+        for( int i = 0; i < 3; ++i ) { ScopeTimer s( &t ); }
+        TS_ASSERT_EQUALS( pm.getTraceMode(), TM_OFF );
+
+        VectorFile json;
+        TS_ASSERT( pm.saveTrace( json, TF_CHROME_JSON ) );
+        StrA text( (const char*)json.map( 0, json.size(), false ), json.size() );
+        TS_ASSERT_EQUALS( 0, strncmp( text.rawptr(), "{\"displayTimeUnit\"", 18 ) );
+        TS_ASSERT_EQUALS( 3, sCount( text, "\"ph\":\"B\"" ) );
+        TS_ASSERT_EQUALS( 3, sCount( text, "\"ph\":\"E\"" ) );
+        TS_ASSERT_EQUALS( 6, sCount( text, "\"name\":\"ut.profiler.\\\"trace\\\"\"" ) );
+
+        VectorFile perfetto;
+        TS_ASSERT( pm.saveTrace( perfetto, TF_PERFETTO ) );
+        TS_ASSERT_LESS_THAN( 0u, perfetto.size() );
+        // first byte is the tag of Trace.packet field.
+        TS_ASSERT_EQUALS( 0x0A, *(const uint8*)perfetto.map( 0, 1, false ) );
+    }
+
+    void testHistogram()
+    {
+        using namespace GN;
+
+        // bucket layout: exact below SUB_BUCKET_COUNT, ~3% precision above.
+        TS_ASSERT_EQUALS( ProfileHistogram::sGetBucketIndex( 0 ), 0u );
+        TS_ASSERT_EQUALS( ProfileHistogram::sGetBucketIndex( 31 ), 31u );
+        TS_ASSERT_EQUALS( ProfileHistogram::sGetBucketIndex( 32 ), 32u );
+        TS_ASSERT_EQUALS( ProfileHistogram::sGetBucketIndex( 64 ), 64u );
+        TS_ASSERT_EQUALS( ProfileHistogram::sGetBucketIndex( (uint64)-1 ), (size_t)ProfileHistogram::BUCKET_COUNT - 1 );
+        for( uint64 v = 1; v < ( (uint64)1 << 40 ); v = v * 3 + 1 )
+        {
+            size_t i = ProfileHistogram::sGetBucketIndex( v );
+            TS_ASSERT_LESS_EQUALS( ProfileHistogram::sGetBucketLowerBound( i ), v );
+            TS_ASSERT_LESS_THAN( v, ProfileHistogram::sGetBucketLowerBound( i ) + ProfileHistogram::sGetBucketWidth( i ) );
+        }
+
+        // 990 samples of 1ms, 10 samples of 100ms
+        ProfileHistogram a, b;
+        for( int i = 0; i < 990; ++i ) a.record( 1000000 );
+        for( int i = 0; i < 10; ++i ) b.record( 100000000 );
+        a.merge( b );
+        TS_ASSERT_EQUALS( a.getCount(), (uint64)1000 );
+        TS_ASSERT_DELTA( a.getPercentile( 50 ), 0.001, 0.00005 );
+        TS_ASSERT_DELTA( a.getPercentile( 99 ), 0.001, 0.00005 );
+        TS_ASSERT_DELTA( a.getPercentile( 99.9 ), 0.1, 0.005 );
+
+        // timer histogram
+        ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+        ProfilerManager::sSetMode( PM_FULL );
+        pm.reset();
+        ProfileTimer & t = pm.getTimer( "ut.profiler.histogram" );
+        for( int i = 0; i < 10; ++i ) { ScopeTimer s( &t ); sBusyWait( 0.0002 ); }
+        pm.aggregate();
+        ProfileHistogram h;
+        TS_ASSERT( t.getHistogram( h ) );
+        TS_ASSERT_EQUALS( h.getCount(), (uint64)10 );
+        TS_ASSERT_LESS_EQUALS( 0.0002 * 0.97, h.getPercentile( 50 ) );
+    }
+
+    void testHardwareCounters()
+    {
+        using namespace GN;
+
+        ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+        ProfilerManager::sSetMode( PM_FULL );
+        pm.reset();
+
+        // counters may not be available (e.g. in VM or container). Timers should work either way.
+        bool available = ProfilerManager::sEnableHardwareCounters( true );
+        TS_ASSERT_EQUALS( available, ProfilerManager::sIsHardwareCountersEnabled() );
+
+        ProfileTimer & t = pm.getTimer( "ut.profiler.counters" );
+        for( int i = 0; i < 10; ++i )
+        {
+            ScopeTimer s( &t );
+            sBusyWait( 0.0001 );
+            t.addElements( 100 );
+        }
+        pm.aggregate();
+
+        TS_ASSERT_EQUALS( t.getCount(), (uint64)10 );
+        TS_ASSERT_EQUALS( t.getElements(), (uint64)1000 );
+        if( available )
+        {
+            TS_ASSERT_LESS_THAN( (uint64)0, t.getCounter( PC_INSTRUCTIONS ) );
+            TS_ASSERT_LESS_THAN( 0.0, t.getIpc() );
+        }
+        else
+        {
+            TS_ASSERT_EQUALS( t.getCounter( PC_CYCLES ), (uint64)0 );
+        }
+
+        ProfilerManager::sEnableHardwareCounters( false );
+        TS_ASSERT( !ProfilerManager::sIsHardwareCountersEnabled() );
+    }
+
+    void testLowOverheadMode()
+    {
+        using namespace GN;
+
+        ProfilerManager & pm = ProfilerManager::sGetGlobalInstance();
+        ProfilerManager::sSetMode( PM_LOW_OVERHEAD );
+        pm.reset();
+
+        ProfileTimer & t = pm.getTimer( "ut.profiler.flat" );
+        for( int i = 0; i < 100; ++i ) { ScopeTimer s( &t ); }
+        pm.aggregate();
+        TS_ASSERT_EQUALS( t.getCount(), (uint64)100 );
+
+        ProfilerManager::sSetMode( PM_OFF );
+        for( int i = 0; i < 100; ++i ) { ScopeTimer s( &t ); }
+        pm.aggregate();
+        TS_ASSERT_EQUALS( t.getCount(), (uint64)100 );
+
+        ProfilerManager::sSetMode( PM_FULL );
+    }
+};
@@ -0,0 +1,179 @@
+#include "../testCommon.h"
+#include <thread>
+#include <vector>
+
+class SyncTest : public CxxTest::TestSuite
+{
+    template<typename LOCK>
+    static int sCountWithLock( LOCK & lock, int numThreads, int numLoops )
+    {
+        int counter = 0;
+        std::vector<std::thread> threads;
+        for( int t = 0; t < numThreads; ++t )
+        {
+            threads.emplace_back( [&]{
+                for( int i = 0; i < numLoops; ++i )
+                {
+                    std::lock_guard<LOCK> guard( lock );
+                    ++counter;
+                }
+            } );
+        }
+        for( auto & t : threads ) t.join();
+        return counter;
+    }
+
+public:
+
+    void testSpinLoop()
+    {
+        using namespace GN;
+
+        SpinLoop s;
+        TS_ASSERT( s.tryLock() );
+        TS_ASSERT( !s.tryLock() );
+        s.unlock();
+        TS_ASSERT_EQUALS( sCountWithLock( s, 4, 10000 ), 40000 );
+    }
+
+    void testMutex()
+    {
+        using namespace GN;
+
+        Mutex m;
+        TS_ASSERT( m.tryLock() );
+        TS_ASSERT( !m.tryLock() );
+        m.unlock();
+        TS_ASSERT_EQUALS( sCountWithLock( m, 4, 10000 ), 40000 );
+    }
+
+    void testRWLock()
+    {
+        using namespace GN;
+
+        RWLock rw;
+        TS_ASSERT( rw.tryLockShared() );
+        TS_ASSERT( rw.tryLockShared() );
+        TS_ASSERT( !rw.tryLock() );
+        rw.unlockShared();
+        rw.unlockShared();
+        TS_ASSERT( rw.tryLock() );
+        TS_ASSERT( !rw.tryLockShared() );
+        rw.unlock();
+
+        // writers keep the two values equal; readers must never see them differ.
+        int a = 0, b = 0;
+        std::atomic<int> mismatches( 0 );
+        std::vector<std::thread> threads;
+        for( int t = 0; t < 4; ++t )
+        {
+            bool writer = ( t % 2 ) == 0;
+            threads.emplace_back( [&, writer]{
+                for( int i = 0; i < 5000; ++i )
+                {
+                    if( writer )
+                    {
+                        rw.lock();
+                        ++a; ++b;
+                        rw.unlock();
+                    }
+                    else
+                    {
+                        rw.lockShared();
+                        if( a != b ) ++mismatches;
+                        rw.unlockShared();
+                    }
+                }
+            } );
+        }
+        for( auto & t : threads ) t.join();
+        TS_ASSERT_EQUALS( a, 10000 );
+        TS_ASSERT_EQUALS( mismatches.load(), 0 );
+    }
+
+    void testSemaphore()
+    {
+        using namespace GN;
+
+        Semaphore s( 2 );
+        TS_ASSERT( s.tryAcquire() );
+        TS_ASSERT( WaitResult::COMPLETED == s.acquire() );
+        TS_ASSERT( !s.tryAcquire() );
+        TS_ASSERT( WaitResult::TIMEDOUT == s.acquire( 1000000 ) );
+
+        // producer/consumer
+        const int N = 10000;
+        std::atomic<int> consumed( 0 );
+        std::thread consumer( [&]{
+            for( int i = 0; i < N; ++i ) { s.acquire(); ++consumed; }
+        } );
+        for( int i = 0; i < N; ++i ) s.release();
+        consumer.join();
+        TS_ASSERT_EQUALS( consumed.load(), N );
+        TS_ASSERT( !s.tryAcquire() );
+    }
+
+    void testSyncEvent()
+    {
+        using namespace GN;
+
+        SyncEvent e;
+        TS_ASSERT( WaitResult::KILLED == e.wait( 0 ) );
+
+        // auto reset
+        TS_ASSERT( e.create( SyncEvent::SIGNALED, SyncEvent::AUTO_RESET ) );
+        TS_ASSERT( WaitResult::COMPLETED == e.wait() );
+        TS_ASSERT( !e.isSignaled() );
+        TS_ASSERT( WaitResult::TIMEDOUT == e.wait( 1000000 ) );
+
+        // manual reset
+        TS_ASSERT( e.create( SyncEvent::UNSIGNALED, SyncEvent::MANUAL_RESET ) );
+        std::atomic<int> released( 0 );
+        std::vector<std::thread> threads;
+        for( int t = 0; t < 3; ++t )
+        {
+            threads.emplace_back( [&]{ if( WaitResult::COMPLETED == e.wait() ) ++released; } );
+        }
+        e.signal();
+        for( auto & t : threads ) t.join();
+        TS_ASSERT_EQUALS( released.load(), 3 );
+        TS_ASSERT( e.isSignaled() );
+        e.unsignal();
+        TS_ASSERT( !e.isSignaled() );
+
+        // destroy releases waiters
+        std::thread waiter( [&]{ TS_ASSERT( WaitResult::KILLED == e.wait() ); } );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        e.destroy();
+        waiter.join();
+    }
+
+    void testBarrier()
+    {
+        using namespace GN;
+
+        const int THREADS = 4;
+        const int PHASES = 100;
+        Barrier barrier( THREADS );
+        std::atomic<int> arrived( 0 );
+        std::atomic<int> leaders( 0 );
+        std::atomic<int> errors( 0 );
+        std::vector<std::thread> threads;
+        for( int t = 0; t < THREADS; ++t )
+        {
+            threads.emplace_back( [&]{
+                for( int p = 0; p < PHASES; ++p )
+                {
+                    ++arrived;
+                    if( barrier.arriveAndWait() ) ++leaders;
+                    // every thread of this phase has arrived.
+                    if( arrived.load() < ( p + 1 ) * THREADS ) ++errors;
+                    barrier.arriveAndWait();
+                }
+            } );
+        }
+        for( auto & t : threads ) t.join();
+        TS_ASSERT_EQUALS( errors.load(), 0 );
+        TS_ASSERT_EQUALS( leaders.load(), PHASES );
+    }
+};
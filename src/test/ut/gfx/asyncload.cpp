@@ -0,0 +1,285 @@
+#include "../testCommon.h"
+#include "garnet/GNgfx.h"
+#include "garnet/gfx/fatModel.h"
+#include <stdio.h>
+#include <thread>
+
+//
+// Load models concurrently into a resource database that lives on the fake GPU.
+//
+class AsyncResourceLoadingTest : public CxxTest::TestSuite
+{
+    static GN::StrA sMeshName( int i ) { return GN::str::format( "ut_async_mesh_%d.bin", i ); }
+    static GN::StrA sModelName( int i ) { return GN::str::format( "ut_async_model_%d.xml", i ); }
+
+    static bool sWriteModel( int i )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        float vertices[3][8] = {};
+        for( int v = 0; v < 3; ++v ) vertices[v][0] = (float)( i + v );
+        uint16 indices[] = { 0, 1, 2 };
+
+        MeshResourceDesc mesh;
+        mesh.prim = PrimitiveType::TRIANGLE_LIST;
+        mesh.numvtx = 3;
+        mesh.numidx = 3;
+        mesh.vtxfmt = MeshVertexFormat::XYZ_NORM_UV();
+        mesh.vertices[0] = vertices;
+        mesh.indices = indices;
+        if( !mesh.saveToFile( sMeshName( i ) ) ) return false;
+
+        FILE * fp = ::fopen( sModelName( i ), "wt" );
+        if( !fp ) return false;
+        ::fprintf( fp,
+            "<?xml version=\"1.0\" standalone=\"yes\"?>\n"
+            "<model>\n"
+            "    <effect ref=\"@UT_ASYNC\"/>\n"
+            "    <mesh ref=\"%s\"/>\n"
+            "</model>\n",
+            sMeshName( i ).rawptr() );
+        ::fclose( fp );
+        return true;
+    }
+
+    static bool sWriteTexture( const char * filename )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        RawImage image( ImageDesc( ImagePlaneDesc::make( ColorFormat::RGBA8, 4, 2 ) ) );
+        memset( image.data(), 0x80, image.size() );
+        return image.save( filename, ImageFileFormat::PNG );
+    }
+
+    static bool sWriteObj( const char * filename )
+    {
+        FILE * fp = ::fopen( filename, "wt" );
+        if( !fp ) return false;
+        ::fprintf( fp, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n" );
+        ::fclose( fp );
+        return true;
+    }
+
+public:
+
+    void testTextureMeshAndFatModel()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        GpuOptions o;
+        o.api = GpuAPI::FAKE;
+        Gpu * gpu = createGpu( o, 0 );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        const char * texname = "ut_async_texture.png";
+        const char * objname = "ut_async_fat.obj";
+        TS_ASSERT( sWriteTexture( texname ) );
+        TS_ASSERT( sWriteModel( 0 ) );
+        TS_ASSERT( sWriteObj( objname ) );
+
+        {
+            GpuResourceDatabase db( *gpu );
+            JobSystem js( 2 );
+            AsyncLoader loader( js );
+
+            AsyncResult< AutoRef<TextureResource> > tex = TextureResource::loadFromFileAsync( db, texname, AsyncPriority::HIGH, loader );
+            AsyncResult< AutoRef<TextureResource> > notex = TextureResource::loadFromFileAsync( db, "ut_async_no_such_texture.png", AsyncPriority::NORMAL, loader );
+            AsyncResult< AutoRef<MeshResource> > mesh = MeshResource::loadFromFileAsync( db, sMeshName( 0 ), AsyncPriority::NORMAL, loader );
+            AsyncResult<FatModel> fat = FatModel::loadFromFileAsync( objname, AsyncPriority::LOW, loader );
+
+            AutoRef<TextureResource> t = tex.get();
+            TS_ASSERT( t && t->texture() );
+            if( t && t->texture() )
+            {
+                TS_ASSERT_EQUALS( t->texture()->getDesc().width, 4u );
+                TS_ASSERT_EQUALS( t->texture()->getDesc().height, 2u );
+            }
+            TS_ASSERT_EQUALS( db.findResource<TextureResource>( fs::resolvePath( fs::getCurrentDir(), texname ) ), t );
+
+            notex.wait();
+            TS_ASSERT_EQUALS( notex.getStatus(), AsyncStatus::FAILED );
+
+            AutoRef<MeshResource> m = mesh.get();
+            TS_ASSERT( m );
+            if( m ) TS_ASSERT_EQUALS( m->getDesc().numvtx, 3u );
+
+            // loaded resources are reused.
+            TS_ASSERT_EQUALS( TextureResource::loadFromFileAsync( db, texname, AsyncPriority::NORMAL, loader ).get(), t );
+            TS_ASSERT_EQUALS( MeshResource::loadFromFileAsync( db, sMeshName( 0 ), AsyncPriority::NORMAL, loader ).get(), m );
+
+            const FatModel & fm = fat.get();
+            TS_ASSERT( fat.succeeded() );
+            TS_ASSERT_EQUALS( fm.meshes.size(), 1u );
+            if( 1 == fm.meshes.size() ) TS_ASSERT_EQUALS( fm.meshes[0].vertices.getVertexCount(), 3u );
+
+            tex = AsyncResult< AutoRef<TextureResource> >();
+            mesh = AsyncResult< AutoRef<MeshResource> >();
+        }
+
+        ::remove( texname );
+        ::remove( objname );
+        ::remove( sMeshName( 0 ) );
+        ::remove( sModelName( 0 ) );
+
+        deleteGpu( gpu );
+    }
+
+    void testCancelAndPriority()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        GpuOptions o;
+        o.api = GpuAPI::FAKE;
+        Gpu * gpu = createGpu( o, 0 );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        const char * texname = "ut_async_texture.png";
+        TS_ASSERT( sWriteTexture( texname ) );
+        for( int i = 0; i < 3; ++i ) TS_ASSERT( sWriteModel( i ) );
+
+        {
+            GpuResourceDatabase db( *gpu );
+            EffectResourceDesc ed;
+            ed.techniques.resize( 1 );
+            ed.techniques[0].name = "empty";
+            AutoRef<EffectResource> effect = db.createResource<EffectResource>( "@UT_ASYNC" );
+            TS_ASSERT( effect && effect->reset( &ed ) );
+            JobSystem js( 1 );
+            AsyncLoader loader( js, 1 );
+
+            // occupy the only slot, so everything below stays queued.
+            std::atomic<bool> open( false );
+            AsyncResult<int> gate = loader.run<int>( "ut.async.gate", AsyncPriority::HIGH,
+                [&]( int & ) { while( !open ) std::this_thread::yield(); return true; } );
+
+            DynaArray<int> order;
+            AsyncResult< AutoRef<TextureResource> > low = TextureResource::loadFromFileAsync( db, texname, AsyncPriority::LOW, loader );
+            AsyncResult< AutoRef<MeshResource> > normal = MeshResource::loadFromFileAsync( db, sMeshName( 2 ), AsyncPriority::NORMAL, loader );
+            AsyncResult< AutoRef<MeshResource> > cancelled = MeshResource::loadFromFileAsync( db, sMeshName( 1 ), AsyncPriority::NORMAL, loader );
+            AsyncResult< AutoRef<ModelResource> > high = ModelResource::loadFromFileAsync( db, sModelName( 0 ), AsyncPriority::HIGH, loader );
+            low.then( [&]( AsyncResult< AutoRef<TextureResource> > & ) { order.append( 1 ); } );
+            normal.then( [&]( AsyncResult< AutoRef<MeshResource> > & ) { order.append( 2 ); } );
+            high.then( [&]( AsyncResult< AutoRef<ModelResource> > & ) { order.append( 3 ); } );
+
+            cancelled.cancel();
+            TS_ASSERT_EQUALS( cancelled.getStatus(), AsyncStatus::CANCELLED );
+
+            open = true;
+            loader.waitAll();
+            while( order.size() < 3 ) loader.update();
+
+            // high first, then normal and low. All of them finish on main thread, in the order
+            // their work is done.
+            TS_ASSERT( low.succeeded() && normal.succeeded() && high.succeeded() );
+            TS_ASSERT_EQUALS( order[0], 3 );
+            TS_ASSERT_EQUALS( order[1], 2 );
+            TS_ASSERT_EQUALS( order[2], 1 );
+
+            // cancelled mesh is never loaded.
+            TS_ASSERT( !cancelled.value() );
+            TS_ASSERT( !db.findResource<MeshResource>( fs::resolvePath( fs::getCurrentDir(), sMeshName( 1 ) ) ) );
+
+            low = AsyncResult< AutoRef<TextureResource> >();
+            normal = AsyncResult< AutoRef<MeshResource> >();
+            high = AsyncResult< AutoRef<ModelResource> >();
+        }
+
+        ::remove( texname );
+        for( int i = 0; i < 3; ++i )
+        {
+            ::remove( sMeshName( i ) );
+            ::remove( sModelName( i ) );
+        }
+
+        deleteGpu( gpu );
+    }
+
+    void testConcurrentModels()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        const int N = 8;
+
+        GpuOptions o;
+        o.api = GpuAPI::FAKE;
+        Gpu * gpu = createGpu( o, 0 );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        {
+            GpuResourceDatabase db( *gpu );
+
+            // fake GPU has no shader model. Use an effect without any pass.
+            EffectResourceDesc ed;
+            ed.techniques.resize( 1 );
+            ed.techniques[0].name = "empty";
+            AutoRef<EffectResource> effect = db.createResource<EffectResource>( "@UT_ASYNC" );
+            TS_ASSERT( effect && effect->reset( &ed ) );
+            JobSystem js( 3 );
+            AsyncLoader loader( js );
+
+            bool written = true;
+            for( int i = 0; i < N; ++i ) written = sWriteModel( i ) && written;
+            TS_ASSERT( written );
+
+            // all models are in flight at the same time.
+            AsyncResult< AutoRef<ModelResource> > models[N];
+            for( int i = 0; i < N; ++i )
+            {
+                models[i] = ModelResource::loadFromFileAsync( db, sModelName( i ), AsyncPriority::NORMAL, loader );
+            }
+            AsyncResult< AutoRef<ModelResource> > missing =
+                ModelResource::loadFromFileAsync( db, "ut_async_no_such_model.xml", AsyncPriority::NORMAL, loader );
+
+            int completed = 0;
+            for( int i = 0; i < N; ++i ) models[i].then( [&]( AsyncResult< AutoRef<ModelResource> > & ) { ++completed; } );
+
+            loader.waitAll();
+            while( completed < N ) loader.update();
+
+            for( int i = 0; i < N; ++i )
+            {
+                TS_ASSERT( models[i].succeeded() );
+                AutoRef<ModelResource> m = models[i].value();
+                TS_ASSERT( m );
+                if( !m ) continue;
+
+                StrA abspath = fs::resolvePath( fs::getCurrentDir(), sModelName( i ) );
+                TS_ASSERT_EQUALS( db.findResource<ModelResource>( abspath ), m );
+
+                AutoRef<MeshResource> mesh = m->meshResource();
+                TS_ASSERT( mesh );
+                if( mesh ) TS_ASSERT_EQUALS( mesh->getDesc().numvtx, 3u );
+                TS_ASSERT_EQUALS( m->effectResource(), effect );
+            }
+            TS_ASSERT_EQUALS( missing.getStatus(), AsyncStatus::FAILED );
+            TS_ASSERT( !missing.value() );
+
+            // loaded model is reused without touching the file.
+            AsyncResult< AutoRef<ModelResource> > again =
+                ModelResource::loadFromFileAsync( db, sModelName( 0 ), AsyncPriority::HIGH, loader );
+            TS_ASSERT_EQUALS( again.get(), models[0].value() );
+
+            // the synchronous loader sees the same resources.
+            TS_ASSERT_EQUALS( MeshResource::loadFromFile( db, sMeshName( 1 ) ), models[1].value()->meshResource() );
+
+            for( int i = 0; i < N; ++i ) models[i] = AsyncResult< AutoRef<ModelResource> >();
+            again = AsyncResult< AutoRef<ModelResource> >();
+        }
+
+        for( int i = 0; i < N; ++i )
+        {
+            ::remove( sMeshName( i ) );
+            ::remove( sModelName( i ) );
+        }
+
+        deleteGpu( gpu );
+    }
+};
@@ -1,5 +1,6 @@
 #include "../testCommon.h"
 #include "garnet/GNgfx.h"
+#include <stdio.h>
 
 namespace GN { namespace gfx
 {
@@ -99,4 +100,49 @@ public:
         TS_ASSERT( b.isBindByIndex() );
         TS_ASSERT_EQUALS( 2, b.getBindingIndex() );
     }
+
+    void testMeshBoundsSaveLoad()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        float vertices[3][8] = {};
+        vertices[0][0] = -1.0f;
+        vertices[1][0] =  1.0f;
+        vertices[2][1] =  2.0f;
+
+        MeshResourceDesc mesh;
+        mesh.prim = PrimitiveType::TRIANGLE_LIST;
+        mesh.numvtx = 3;
+        mesh.vtxfmt = MeshVertexFormat::XYZ_NORM_UV();
+        mesh.vertices[0] = vertices;
+        TS_ASSERT( !mesh.hasBounds );
+        TS_ASSERT( mesh.calculateBounds() );
+        TS_ASSERT( mesh.hasBounds );
+        TS_ASSERT_EQUALS( -1.0f, mesh.bounds.box.x );
+        TS_ASSERT_EQUALS(  2.0f, mesh.bounds.box.w );
+        TS_ASSERT_EQUALS(  2.0f, mesh.bounds.box.h );
+
+        const char * filename = "ut_mesh_bounds.mesh.bin";
+        TS_ASSERT( mesh.saveToFile( filename ) );
+
+        MeshResourceDesc loaded;
+        AutoRef<Blob> blob = loaded.loadFromFile( filename );
+        TS_ASSERT( blob );
+        TS_ASSERT( loaded.hasBounds );
+        TS_ASSERT_EQUALS( mesh.bounds.box.x, loaded.bounds.box.x );
+        TS_ASSERT_EQUALS( mesh.bounds.box.h, loaded.bounds.box.h );
+        TS_ASSERT_EQUALS( mesh.bounds.sphere.radius, loaded.bounds.sphere.radius );
+
+        // bounds don't follow vertex changes, until they are invalidated.
+        vertices[1][0] = 3.0f;
+        Box<float> box;
+        mesh.calculateBoundingBox( box );
+        TS_ASSERT_EQUALS( 2.0f, box.w );
+        mesh.hasBounds = false;
+        mesh.calculateBoundingBox( box );
+        TS_ASSERT_EQUALS( 4.0f, box.w );
+
+        ::remove( filename );
+    }
 };
@@ -0,0 +1,230 @@
+#include "../testCommon.h"
+#include "garnet/GNgfx.h"
+
+//
+// Runs the same checks against the fake GPU, with and without the multi
+// thread wrapper. The multi thread GPU must behave exactly like the single
+// thread one it wraps.
+//
+class MultiThreadGpuTest : public CxxTest::TestSuite
+{
+    static GN::gfx::Gpu * createFake( bool multithread, uint32 framesInFlight = 1 )
+    {
+        using namespace GN::gfx;
+        GpuOptions o;
+        o.api = GpuAPI::FAKE;
+        o.displayMode.width = 64;
+        o.displayMode.height = 32;
+        o.maxFramesInFlight = framesInFlight;
+        return createGpu( o, multithread ? GPU_CREATION_MULTIPLE_THREADS : 0 );
+    }
+
+    void buffers( bool multithread )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        Gpu * gpu = createFake( multithread );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        VtxBufDesc vbd = { 256, false };
+        AutoRef<VtxBuf> vb = attachTo( gpu->createVtxBuf( vbd ) );
+        TS_ASSERT( vb );
+        TS_ASSERT_EQUALS( vb->getref(), 1 ); // created resources are owned by caller
+        uint8 vtx[64];
+        for( int i = 0; i < 64; ++i ) vtx[i] = (uint8)i;
+        vb->update( 16, 64, vtx );
+
+        DynaArray<uint8> data;
+        vb->readback( data );
+        TS_ASSERT_EQUALS( data.size(), 256u );
+        TS_ASSERT_EQUALS( data[15], 0 );
+        TS_ASSERT_SAME_DATA( &data[16], vtx, 64 );
+        TS_ASSERT_EQUALS( data[80], 0 );
+
+        IdxBufDesc ibd = { 32, false, false };
+        AutoRef<IdxBuf> ib = attachTo( gpu->createIdxBuf( ibd ) );
+        TS_ASSERT( ib );
+        uint16 idx[] = { 1, 2, 3, 4 };
+        ib->update( 4, 4, idx );
+        ib->readback( data );
+        TS_ASSERT_EQUALS( data.size(), 64u );
+        TS_ASSERT_SAME_DATA( &data[8], idx, sizeof(idx) );
+
+        AutoRef<Uniform> u = attachTo( gpu->createUniform( 16 ) );
+        TS_ASSERT( u );
+        float f[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        u->update( 0, sizeof(f), f );
+        TS_ASSERT_EQUALS( u->size(), 16u );
+        TS_ASSERT_SAME_DATA( u->getval(), f, sizeof(f) );
+
+        vb.clear();
+        ib.clear();
+        u.clear();
+        deleteGpu( gpu );
+    }
+
+    void texture( bool multithread )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        Gpu * gpu = createFake( multithread );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        TextureDesc td = { ColorFormat::RGBA8, 8, 8, 1, 1, 0, TextureUsage::DEFAULT };
+        AutoRef<Texture> tex = attachTo( gpu->createTexture( td ) );
+        TS_ASSERT( tex );
+        if( !tex ) { deleteGpu( gpu ); return; }
+        TS_ASSERT_EQUALS( tex->getDesc().levels, 4u );
+        TS_ASSERT_EQUALS( tex->getMipSize( 1 ), Vector3<uint32>( 4, 4, 1 ) );
+
+        // update 2x2 area in the middle of level 1
+        uint32 texels[] = { 0x11111111, 0x22222222, 0x33333333, 0x44444444 };
+        Box<uint32> area( 1, 1, 0, 2, 2, 1 );
+        tex->updateMipmap( 0, 1, &area, 8, 16, texels );
+
+        MipmapData md;
+        tex->readMipmap( 0, 1, md );
+        TS_ASSERT_EQUALS( md.rowPitch, 16u );
+        TS_ASSERT_EQUALS( md.data.size(), 64u );
+        const uint32 * p = (const uint32*)md.data.rawptr();
+        TS_ASSERT_EQUALS( p[0], 0u );
+        TS_ASSERT_EQUALS( p[5], 0x11111111u );
+        TS_ASSERT_EQUALS( p[6], 0x22222222u );
+        TS_ASSERT_EQUALS( p[9], 0x33333333u );
+        TS_ASSERT_EQUALS( p[10], 0x44444444u );
+        TS_ASSERT_EQUALS( p[11], 0u );
+
+        // block compressed: 8x8 DXT1 is 2x2 blocks of 8 bytes.
+        TextureDesc cd = { ColorFormat::DXT1_UNORM, 8, 8, 1, 1, 1, TextureUsage::DEFAULT };
+        AutoRef<Texture> ctex = attachTo( gpu->createTexture( cd ) );
+        TS_ASSERT( ctex );
+        uint8 blocks[32];
+        for( int i = 0; i < 32; ++i ) blocks[i] = (uint8)( i + 1 );
+        ctex->updateMipmap( 0, 0, NULL, 16, 32, blocks );
+        ctex->readMipmap( 0, 0, md );
+        TS_ASSERT_EQUALS( md.rowPitch, 16u );
+        TS_ASSERT_EQUALS( md.data.size(), 32u );
+        TS_ASSERT_SAME_DATA( md.data.rawptr(), blocks, 32 );
+
+        tex.clear();
+        ctex.clear();
+        deleteGpu( gpu );
+    }
+
+    void backbuffer( bool multithread )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        Gpu * gpu = createFake( multithread );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        TS_ASSERT_EQUALS( gpu->getDispDesc().width, 64u );
+        TS_ASSERT_EQUALS( gpu->getDispDesc().height, 32u );
+        TS_ASSERT_EQUALS( gpu->getRenderWindow().getClientSize().x, 64u );
+        TS_ASSERT_EQUALS( gpu->getOptions().api, GpuAPI::FAKE );
+
+        gpu->clearScreen( Vector4f( 1, 1, 0, 1 ) );
+        gpu->draw( PrimitiveType::TRIANGLE_LIST, 3, 0 );
+        gpu->present();
+
+        Gpu::BackBufferContent bbc;
+        gpu->getBackBufferContent( bbc );
+        TS_ASSERT_EQUALS( bbc.width, 64u );
+        TS_ASSERT_EQUALS( bbc.height, 32u );
+        TS_ASSERT_EQUALS( bbc.data.size(), 64u * 32u * 4u );
+        TS_ASSERT_EQUALS( *(const uint32*)&bbc.data[bbc.pitch * 5 + 4 * 7], 0xFF00FFFFu );
+
+        deleteGpu( gpu );
+    }
+
+    void userData( bool multithread )
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        static const Guid ID = { 0x3a1e6c52, 0x7d0b, 0x4f8e, { 0x9c, 0x21, 0x5b, 0x47, 0xe0, 0x1d, 0x63, 0xaa } };
+
+        Gpu * gpu = createFake( multithread );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        TS_ASSERT( !gpu->hasUserData( ID ) );
+        int value = 12345;
+        gpu->setUserData( ID, &value, sizeof(value) );
+        TS_ASSERT( gpu->hasUserData( ID ) );
+        uint32 length;
+        const int * p = (const int*)gpu->getUserData( ID, &length );
+        TS_ASSERT_EQUALS( length, sizeof(value) );
+        TS_ASSERT( p && 12345 == *p );
+        gpu->setUserData( ID, NULL, 0 );
+        TS_ASSERT( !gpu->hasUserData( ID ) );
+
+        deleteGpu( gpu );
+    }
+
+public:
+
+    void testBuffers()     { buffers( false ); buffers( true ); }
+    void testTexture()     { texture( false ); texture( true ); }
+    void testBackBuffer()  { backbuffer( false ); backbuffer( true ); }
+    void testUserData()    { userData( false ); userData( true ); }
+
+    void testFramesInFlight()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        // 0 means no throttling at all.
+        for( uint32 frames = 0; frames <= 3; ++frames )
+        {
+            Gpu * gpu = createFake( true, frames );
+            TS_ASSERT( gpu );
+            if( !gpu ) continue;
+            for( int i = 0; i < 100; ++i )
+            {
+                gpu->clearScreen( Vector4f( 0, 0, (float)i / 100.0f, 1 ) );
+                gpu->draw( PrimitiveType::TRIANGLE_LIST, 3, 0 );
+                gpu->present();
+            }
+            deleteGpu( gpu );
+        }
+    }
+
+    void testCommandBufferWrapAround()
+    {
+        using namespace GN;
+        using namespace GN::gfx;
+
+        Gpu * gpu = createFake( true );
+        TS_ASSERT( gpu );
+        if( !gpu ) return;
+
+        // Post enough small updates to wrap the 4MB command ring several
+        // times. Commands must be executed in the order they are posted.
+        VtxBufDesc vbd = { 1024, false };
+        AutoRef<VtxBuf> vb = attachTo( gpu->createVtxBuf( vbd ) );
+        const uint32 COUNT = 300000;
+        for( uint32 i = 0; i < COUNT; ++i )
+        {
+            vb->update( ( i % 256 ) * 4, 4, &i );
+        }
+
+        DynaArray<uint8> data;
+        vb->readback( data );
+        const uint32 * p = (const uint32*)data.rawptr();
+        for( uint32 i = 0; i < 256; ++i )
+        {
+            uint32 expected = COUNT - 256 + ( ( i - COUNT ) % 256 );
+            TS_ASSERT_EQUALS( p[i], expected );
+        }
+
+        vb.clear();
+        deleteGpu( gpu );
+    }
+};
@@ -20,6 +20,21 @@
 
 static GN::Logger * sLogger = GN::getLogger("GN.gfx.test.UT");
 
+///
+/// Deterministic pseudo random numbers (64-bit LCG), so tests see the same data on every run.
+///
+static inline uint64 nextRandom64( uint64 & seed )
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed;
+}
+
+/// 32 random bits
+static inline uint32 nextRandom32( uint64 & seed ) { return (uint32)( nextRandom64( seed ) >> 32 ); }
+
+/// uniformly distributed in [-1, 1)
+static inline float nextRandomFloat( uint64 & seed ) { return (float)( nextRandom64( seed ) >> 40 ) / (float)( 1 << 23 ) - 1.0f; }
+
 ///
 /// namespace of CxxTest framework
 ///